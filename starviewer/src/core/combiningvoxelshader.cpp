@@ -39,6 +39,12 @@ void CombiningVoxelShader<VS1, VS2>::setVoxelShaders(VS1 *voxelShader1, VS2 *vox
     m_voxelShader2 = voxelShader2;
 }
 
+template <class VS1, class VS2>
+bool CombiningVoxelShader<VS1, VS2>::usesRemainingOpacity() const
+{
+    return (m_voxelShader1 && m_voxelShader1->usesRemainingOpacity()) || (m_voxelShader2 && m_voxelShader2->usesRemainingOpacity());
+}
+
 template <class VS1, class VS2>
 QString CombiningVoxelShader<VS1, VS2>::toString() const
 {
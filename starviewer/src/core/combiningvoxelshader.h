@@ -48,6 +48,10 @@ public:
     /// Retorna el color corresponent al vòxel a la posició position, fent servir valors interpolats.
     HdrColor nvShade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator, float remainingOpacity,
                       const HdrColor &baseColor = HdrColor());
+    /// Calcula el color de count vòxels seguits cridant nvShade per cada un, sense una crida virtual per vòxel.
+    virtual void shadeSamples(int count, const Vector3 *positions, const int *offsets, const Vector3 &direction, float remainingOpacity, HdrColor *colors);
+    /// Retorna cert si algun dels dos voxel shaders depèn de l'opacitat restant.
+    virtual bool usesRemainingOpacity() const;
     /// Retorna un string representatiu del voxel shader.
     virtual QString toString() const;
 
@@ -71,6 +75,13 @@ inline HdrColor CombiningVoxelShader<VS1, VS2>::shade(const Vector3 &position, c
     return nvShade(position, direction, interpolator, remainingOpacity, baseColor);
 }
 
+template <class VS1, class VS2>
+inline void CombiningVoxelShader<VS1, VS2>::shadeSamples(int count, const Vector3 *positions, const int *offsets, const Vector3 &direction,
+                                                          float remainingOpacity, HdrColor *colors)
+{
+    nvShadeSamples(this, count, positions, offsets, direction, remainingOpacity, colors);
+}
+
 template <class VS1, class VS2>
 inline HdrColor CombiningVoxelShader<VS1, VS2>::nvShade(const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity,
                                                          const HdrColor &baseColor)
@@ -0,0 +1,38 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef COMPUTESTATISTICSPOSTPROCESSOR_H
+#define COMPUTESTATISTICSPOSTPROCESSOR_H
+
+#include "postprocessor.h"
+
+namespace udg {
+
+/**
+    Postprocessor that computes the statistics of the pixel data of the volume just after reading it, so that the automatic window level,
+    the VOI LUT presets and the histograms don't have to scan the volume in the GUI thread.
+ */
+class ComputeStatisticsPostprocessor : public Postprocessor {
+
+public:
+
+    /// Computes the statistics of the pixel data of the given volume.
+    virtual void postprocess(Volume *volume);
+
+};
+
+} // namespace udg
+
+#endif // COMPUTESTATISTICSPOSTPROCESSOR_H
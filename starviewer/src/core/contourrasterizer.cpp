@@ -0,0 +1,79 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "contourrasterizer.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cmath>
+
+namespace udg {
+
+QVector<ContourRasterizer::Span> ContourRasterizer::getSpans(const QVector<QPointF> &contour, const double origin[2], const double spacing[2],
+                                                             const int extent[4])
+{
+    QVector<Span> spans;
+    if (contour.size() < 3)
+    {
+        return spans;
+    }
+
+    double minimumY = contour.first().y();
+    double maximumY = contour.first().y();
+    foreach (const QPointF &point, contour)
+    {
+        minimumY = qMin(minimumY, point.y());
+        maximumY = qMax(maximumY, point.y());
+    }
+
+    int firstRow = qMax(extent[2], static_cast<int>(std::ceil((minimumY - origin[1]) / spacing[1])));
+    int lastRow = qMin(extent[3], static_cast<int>(std::floor((maximumY - origin[1]) / spacing[1])));
+
+    QVarLengthArray<double, 64> crossings;
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        double y = origin[1] + row * spacing[1];
+
+        crossings.clear();
+        for (int i = 0; i < contour.size(); i++)
+        {
+            const QPointF &first = contour.at(i);
+            const QPointF &second = contour.at((i + 1) % contour.size());
+            if ((first.y() <= y && y < second.y()) || (second.y() <= y && y < first.y()))
+            {
+                crossings.append(first.x() + (y - first.y()) * (second.x() - first.x()) / (second.y() - first.y()));
+            }
+        }
+
+        std::sort(crossings.begin(), crossings.end());
+
+        for (int i = 0; i + 1 < crossings.size(); i += 2)
+        {
+            Span span;
+            span.row = row;
+            span.firstColumn = qMax(extent[0], static_cast<int>(std::ceil((crossings[i] - origin[0]) / spacing[0])));
+            span.lastColumn = qMin(extent[1], static_cast<int>(std::floor((crossings[i + 1] - origin[0]) / spacing[0])));
+            if (span.firstColumn <= span.lastColumn)
+            {
+                spans.append(span);
+            }
+        }
+    }
+
+    return spans;
+}
+
+} // End namespace udg
@@ -0,0 +1,54 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGCONTOURRASTERIZER_H
+#define UDGCONTOURRASTERIZER_H
+
+#include <QPointF>
+#include <QVector>
+
+namespace udg {
+
+/**
+    Rasterizes a closed contour drawn on a plane of an image into the row spans of the voxels that it contains.
+
+    A voxel is inside the contour when its center is inside it. Each row is intersected with the edges of the contour, where each edge
+    contains its lower end but not its upper one, so a vertex shared by two edges is crossed once unless it's a vertical extreme, where it's
+    crossed twice or not at all. The crossings are sorted and each pair delimits a span, whose voxels are the ones with their center between
+    both crossings, both included. This is the rule used by all the ROI and VOI measurements, so they give the same voxels for the same contour.
+  */
+class ContourRasterizer {
+public:
+    /// Columns from firstColumn to lastColumn of a row
+    struct Span {
+        int row;
+        int firstColumn;
+        int lastColumn;
+
+        bool operator==(const Span &span) const
+        {
+            return row == span.row && firstColumn == span.firstColumn && lastColumn == span.lastColumn;
+        }
+    };
+
+    /// Returns the spans of the voxels of the plane whose center is inside the contour, sorted by row and then by column. The x and y
+    /// coordinates of the contour are the ones along the columns and the rows of the plane, and origin, spacing and extent are the ones of
+    /// the image along those two axes, with the extent given as { first column, last column, first row, last row }.
+    static QVector<Span> getSpans(const QVector<QPointF> &contour, const double origin[2], const double spacing[2], const int extent[4]);
+};
+
+} // End namespace udg
+
+#endif
@@ -14,15 +14,12 @@
 
 #include "contourvoxelshader.h"
 
-#include <vtkEncodedGradientEstimator.h>
-
 namespace udg {
 
 ContourVoxelShader::ContourVoxelShader()
  : VoxelShader()
 {
-    m_encodedNormals = 0;
-    m_directionEncoder = 0;
+    m_gradientVolume = 0;
     m_threshold = 0.0;
 }
 
@@ -30,10 +27,9 @@ ContourVoxelShader::~ContourVoxelShader()
 {
 }
 
-void ContourVoxelShader::setGradientEstimator(vtkEncodedGradientEstimator *gradientEstimator)
+void ContourVoxelShader::setGradientVolume(const GradientVolume *gradientVolume)
 {
-    m_encodedNormals = gradientEstimator->GetEncodedNormals();
-    m_directionEncoder = gradientEstimator->GetDirectionEncoder();
+    m_gradientVolume = gradientVolume;
 }
 
 void ContourVoxelShader::setThreshold(double threshold)
@@ -17,12 +17,9 @@
 
 #include "voxelshader.h"
 
-#include <vtkDirectionEncoder.h>
-
+#include "gradientvolume.h"
 #include "trilinearinterpolator.h"
 
-class vtkEncodedGradientEstimator;
-
 namespace udg {
 
 /**
@@ -34,8 +31,8 @@ public:
     ContourVoxelShader();
     virtual ~ContourVoxelShader();
 
-    /// Assigna l'estimador del gradient.
-    void setGradientEstimator(vtkEncodedGradientEstimator *gradientEstimator);
+    /// Assigna el gradient del volum.
+    void setGradientVolume(const GradientVolume *gradientVolume);
     /// Assigna el llindar a partir del qual s'aplica el contorn.
     void setThreshold(double threshold);
 
@@ -53,8 +50,7 @@ public:
     virtual QString toString() const;
 
 protected:
-    unsigned short *m_encodedNormals;
-    vtkDirectionEncoder *m_directionEncoder;
+    const GradientVolume *m_gradientVolume;
     double m_threshold;
 
 };
@@ -75,16 +71,14 @@ inline HdrColor ContourVoxelShader::nvShade(const Vector3 &position, int offset,
     Q_UNUSED(position);
     Q_UNUSED(remainingOpacity);
 
-    Q_ASSERT(m_encodedNormals);
-    Q_ASSERT(m_directionEncoder);
+    Q_ASSERT(m_gradientVolume);
 
     if (baseColor.isTransparent() || baseColor.isBlack())
     {
         return baseColor;
     }
 
-    float *gradient = m_directionEncoder->GetDecodedGradient(m_encodedNormals[offset]);
-    Vector3 normal(gradient[0], gradient[1], gradient[2]);
+    Vector3 normal = m_gradientVolume->getNormal(offset);
     double dotProduct = direction * normal;
     if (dotProduct < 0.0)
     {
@@ -101,8 +95,7 @@ inline HdrColor ContourVoxelShader::nvShade(const Vector3 &position, const Vecto
     Q_UNUSED(remainingOpacity);
 
     Q_ASSERT(interpolator);
-    Q_ASSERT(m_encodedNormals);
-    Q_ASSERT(m_directionEncoder);
+    Q_ASSERT(m_gradientVolume);
 
     if (baseColor.isTransparent() || baseColor.isBlack())
     {
@@ -117,9 +110,7 @@ inline HdrColor ContourVoxelShader::nvShade(const Vector3 &position, const Vecto
 
     for (int i = 0; i < 8; i++)
     {
-        float *gradient = m_directionEncoder->GetDecodedGradient(m_encodedNormals[offsets[i]]);
-        Vector3 localNormal(gradient[0], gradient[1], gradient[2]);
-        normal += weights[i] * localNormal;
+        normal += weights[i] * m_gradientVolume->getNormal(offsets[i]);
     }
 
     double dotProduct = direction * normal;
@@ -332,6 +332,7 @@ HEADERS += extensionfactory.h \
     itkDCMTKImageIOFactory.h \
     volumepixeldatareaderitkdcmtk.h \
     postprocessor.h \
+    computestatisticspostprocessor.h \
     computezspacingpostprocessor.h \
     pixelspacingamenderpostprocessor.h \
     volumepixeldatareaderfactory.h \
@@ -427,7 +428,23 @@ HEADERS += extensionfactory.h \
     sliceorientedvolumepixeldata.h \
     voxelindex.h \
     systemrequirements.h \
-    systemrequirementstest.h
+    systemrequirementstest.h \
+    curvedplanarreformation.h \
+    isosurfaceextractor.h \
+    renderingprofiler.h \
+    voistatisticscalculator.h \
+    regiongrowing.h \
+    timeactivitycurvecalculator.h \
+    drawerspatialindex.h \
+    drawerlinebatcher.h \
+    sliceindex.h \
+    standardizeduptakevaluefactorcache.h \
+    volumepixeldatastatistics.h \
+    segmentationprimitives.h \
+    maskstatistics.h \
+    gradientvolume.h \
+    voitool.h \
+    contourrasterizer.h
 
 SOURCES += extensionmediator.cpp \
     displayableid.cpp \
@@ -712,6 +729,7 @@ SOURCES += extensionmediator.cpp \
     itkDCMTKImageIOFactory.cxx \
     volumepixeldatareaderitkdcmtk.cpp \
     postprocessor.cpp \
+    computestatisticspostprocessor.cpp \
     computezspacingpostprocessor.cpp \
     pixelspacingamenderpostprocessor.cpp \
     volumepixeldatareaderfactory.cpp \
@@ -804,7 +822,23 @@ SOURCES += extensionmediator.cpp \
     sliceorientedvolumepixeldata.cpp \
     voxelindex.cpp \
     systemrequirements.cpp \
-    systemrequirementstest.cpp
+    systemrequirementstest.cpp \
+    curvedplanarreformation.cpp \
+    isosurfaceextractor.cpp \
+    renderingprofiler.cpp \
+    voistatisticscalculator.cpp \
+    regiongrowing.cpp \
+    timeactivitycurvecalculator.cpp \
+    drawerspatialindex.cpp \
+    drawerlinebatcher.cpp \
+    sliceindex.cpp \
+    standardizeduptakevaluefactorcache.cpp \
+    volumepixeldatastatistics.cpp \
+    segmentationprimitives.cpp \
+    maskstatistics.cpp \
+    gradientvolume.cpp \
+    voitool.cpp \
+    contourrasterizer.cpp
 
 win32 {
     HEADERS += windowsfirewallaccess.h \
@@ -0,0 +1,402 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "curvedplanarreformation.h"
+
+#include <QtConcurrentMap>
+
+#include <vtkImageData.h>
+
+#include <algorithm>
+
+namespace udg {
+
+namespace {
+
+// Returns the trilinear interpolation at the given continuous index, or the background value if the index is outside the image
+template <class T>
+inline double sampleImage(const T *data, const int dimensions[3], const vtkIdType increments[3], const Vector3 &index, double backgroundValue)
+{
+    const double position[3] = { index.x, index.y, index.z };
+    int baseIndex[3];
+    double fraction[3];
+    vtkIdType nextIncrement[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (position[i] < 0.0 || position[i] > dimensions[i] - 1)
+        {
+            return backgroundValue;
+        }
+
+        if (dimensions[i] > 1)
+        {
+            baseIndex[i] = qMin(static_cast<int>(position[i]), dimensions[i] - 2);
+            fraction[i] = position[i] - baseIndex[i];
+            nextIncrement[i] = increments[i];
+        }
+        else
+        {
+            baseIndex[i] = 0;
+            fraction[i] = 0.0;
+            nextIncrement[i] = 0;
+        }
+    }
+
+    const T *voxel = data + baseIndex[0] * increments[0] + baseIndex[1] * increments[1] + baseIndex[2] * increments[2];
+    const vtkIdType x = nextIncrement[0], y = nextIncrement[1], z = nextIncrement[2];
+
+    double c00 = voxel[0] + fraction[0] * (voxel[x] - voxel[0]);
+    double c10 = voxel[y] + fraction[0] * (voxel[x + y] - voxel[y]);
+    double c01 = voxel[z] + fraction[0] * (voxel[x + z] - voxel[z]);
+    double c11 = voxel[y + z] + fraction[0] * (voxel[x + y + z] - voxel[y + z]);
+    double c0 = c00 + fraction[1] * (c10 - c00);
+    double c1 = c01 + fraction[1] * (c11 - c01);
+
+    return c0 + fraction[2] * (c1 - c0);
+}
+
+// Fills each output row sampling from rowOrigins[row] in steps of rowSteps[row], both given in continuous index coordinates
+template <class T>
+void resampleRows(const T *data, const int dimensions[3], const vtkIdType increments[3], const QVector<Vector3> &rowOrigins,
+                  const QVector<Vector3> &rowSteps, int columns, double backgroundValue, float *output)
+{
+    QVector<int> rows(rowOrigins.size());
+    for (int i = 0; i < rows.size(); i++)
+    {
+        rows[i] = i;
+    }
+
+    QtConcurrent::blockingMap(rows, [&](int row) {
+        Vector3 index = rowOrigins.at(row);
+        const Vector3 &step = rowSteps.at(row);
+        float *outputRow = output + static_cast<vtkIdType>(row) * columns;
+
+        for (int column = 0; column < columns; column++)
+        {
+            outputRow[column] = static_cast<float>(sampleImage(data, dimensions, increments, index, backgroundValue));
+            index += step;
+        }
+    });
+}
+
+}
+
+CurvedPlanarReformation::CurvedPlanarReformation()
+ : m_input(0), m_vectorOfInterest(0.0, 0.0, 1.0), m_sampleSpacing(1.0), m_width(100.0), m_backgroundValue(0.0)
+{
+}
+
+CurvedPlanarReformation::~CurvedPlanarReformation()
+{
+}
+
+void CurvedPlanarReformation::setInput(vtkImageData *input)
+{
+    m_input = input;
+}
+
+void CurvedPlanarReformation::setPath(const QList<Vector3> &path)
+{
+    m_path.clear();
+    foreach (const Vector3 &point, path)
+    {
+        if (m_path.isEmpty() || m_path.last() != point)
+        {
+            m_path << point;
+        }
+    }
+}
+
+QList<Vector3> CurvedPlanarReformation::getPath() const
+{
+    return m_path;
+}
+
+void CurvedPlanarReformation::setVectorOfInterest(const Vector3 &vectorOfInterest)
+{
+    if (vectorOfInterest.length() > 0.0)
+    {
+        m_vectorOfInterest = vectorOfInterest;
+        m_vectorOfInterest.normalize();
+    }
+}
+
+Vector3 CurvedPlanarReformation::getVectorOfInterest() const
+{
+    return m_vectorOfInterest;
+}
+
+void CurvedPlanarReformation::setSampleSpacing(double spacing)
+{
+    if (spacing > 0.0)
+    {
+        m_sampleSpacing = spacing;
+    }
+}
+
+double CurvedPlanarReformation::getSampleSpacing() const
+{
+    return m_sampleSpacing;
+}
+
+void CurvedPlanarReformation::setWidth(double width)
+{
+    if (width > 0.0)
+    {
+        m_width = width;
+    }
+}
+
+void CurvedPlanarReformation::setBackgroundValue(double value)
+{
+    m_backgroundValue = value;
+}
+
+double CurvedPlanarReformation::getPathLength() const
+{
+    return computeCumulativeLengths().last();
+}
+
+Vector3 CurvedPlanarReformation::getPathPoint(double distance) const
+{
+    if (m_path.isEmpty())
+    {
+        return Vector3();
+    }
+
+    QVector<double> cumulativeLengths = computeCumulativeLengths();
+    distance = qBound(0.0, distance, cumulativeLengths.last());
+
+    return getPathSample(cumulativeLengths, distance).point;
+}
+
+vtkSmartPointer<vtkImageData> CurvedPlanarReformation::computeReformation(ReformationType type) const
+{
+    if (!m_input || m_path.size() < 2)
+    {
+        return vtkSmartPointer<vtkImageData>();
+    }
+
+    QVector<double> cumulativeLengths;
+    if (type == Stretched)
+    {
+        cumulativeLengths = computeCumulativeLengths(&m_vectorOfInterest);
+    }
+    else
+    {
+        cumulativeLengths = computeCumulativeLengths();
+    }
+
+    if (cumulativeLengths.last() <= 0.0)
+    {
+        return vtkSmartPointer<vtkImageData>();
+    }
+
+    QVector<PathSample> samples = samplePath(cumulativeLengths);
+    if (type == Straightened)
+    {
+        computeRotationMinimizingFrames(samples);
+    }
+
+    int columns = 2 * qRound(m_width / m_sampleSpacing / 2.0) + 1;
+    double halfWidth = (columns - 1) / 2 * m_sampleSpacing;
+
+    QVector<Vector3> rowOrigins(samples.size());
+    QVector<Vector3> rowSteps(samples.size());
+    for (int i = 0; i < samples.size(); i++)
+    {
+        const Vector3 &direction = type == Stretched ? m_vectorOfInterest : samples.at(i).normal;
+        rowOrigins[i] = samples.at(i).point - direction * halfWidth;
+        rowSteps[i] = direction * m_sampleSpacing;
+    }
+
+    return resample(rowOrigins, rowSteps, columns, m_sampleSpacing);
+}
+
+vtkSmartPointer<vtkImageData> CurvedPlanarReformation::computeCrossSection(double distance) const
+{
+    if (!m_input || m_path.size() < 2)
+    {
+        return vtkSmartPointer<vtkImageData>();
+    }
+
+    QVector<double> cumulativeLengths = computeCumulativeLengths();
+    if (cumulativeLengths.last() <= 0.0)
+    {
+        return vtkSmartPointer<vtkImageData>();
+    }
+
+    // Frames are computed from the beginning of the path so that the cross-section is oriented as the straightened reformation
+    QVector<PathSample> samples = samplePath(cumulativeLengths);
+    computeRotationMinimizingFrames(samples);
+    int sampleIndex = qBound(0, qRound(distance / m_sampleSpacing), samples.size() - 1);
+    PathSample sample = samples.at(sampleIndex);
+    sample.point = getPathSample(cumulativeLengths, qBound(0.0, distance, cumulativeLengths.last())).point;
+
+    Vector3 binormal = Vector3::cross(sample.tangent, sample.normal);
+    int columns = 2 * qRound(m_width / m_sampleSpacing / 2.0) + 1;
+    double halfWidth = (columns - 1) / 2 * m_sampleSpacing;
+
+    QVector<Vector3> rowOrigins(columns);
+    QVector<Vector3> rowSteps(columns, sample.normal * m_sampleSpacing);
+    for (int row = 0; row < columns; row++)
+    {
+        rowOrigins[row] = sample.point - sample.normal * halfWidth + binormal * (row * m_sampleSpacing - halfWidth);
+    }
+
+    return resample(rowOrigins, rowSteps, columns, m_sampleSpacing);
+}
+
+CurvedPlanarReformation::PathSample CurvedPlanarReformation::getPathSample(const QVector<double> &cumulativeLengths, double distance) const
+{
+    // First segment whose end is not before the given distance
+    int segment = std::lower_bound(cumulativeLengths.constBegin() + 1, cumulativeLengths.constEnd(), distance) - cumulativeLengths.constBegin() - 1;
+    segment = qBound(0, segment, m_path.size() - 2);
+
+    const Vector3 &start = m_path.at(segment);
+    Vector3 direction = m_path.at(segment + 1) - start;
+    double segmentLength = cumulativeLengths.at(segment + 1) - cumulativeLengths.at(segment);
+    double t = segmentLength > 0.0 ? (distance - cumulativeLengths.at(segment)) / segmentLength : 0.0;
+
+    PathSample sample;
+    sample.point = start + direction * t;
+    sample.tangent = direction;
+    sample.tangent.normalize();
+
+    return sample;
+}
+
+QVector<CurvedPlanarReformation::PathSample> CurvedPlanarReformation::samplePath(const QVector<double> &cumulativeLengths) const
+{
+    int numberOfSamples = static_cast<int>(cumulativeLengths.last() / m_sampleSpacing) + 1;
+
+    QVector<PathSample> samples(numberOfSamples);
+    for (int i = 0; i < numberOfSamples; i++)
+    {
+        samples[i] = getPathSample(cumulativeLengths, i * m_sampleSpacing);
+    }
+
+    return samples;
+}
+
+QVector<double> CurvedPlanarReformation::computeCumulativeLengths(const Vector3 *perpendicularTo) const
+{
+    QVector<double> cumulativeLengths;
+    cumulativeLengths << 0.0;
+
+    for (int i = 1; i < m_path.size(); i++)
+    {
+        Vector3 segment = m_path.at(i) - m_path.at(i - 1);
+        if (perpendicularTo)
+        {
+            segment -= (segment * *perpendicularTo) * *perpendicularTo;
+        }
+        cumulativeLengths << cumulativeLengths.last() + segment.length();
+    }
+
+    return cumulativeLengths;
+}
+
+void CurvedPlanarReformation::computeRotationMinimizingFrames(QVector<PathSample> &samples) const
+{
+    if (samples.isEmpty())
+    {
+        return;
+    }
+
+    // Double reflection method (Wang et al., "Computation of rotation minimizing frames", 2008)
+    samples[0].normal = getPerpendicularVector(samples.at(0).tangent);
+    for (int i = 0; i < samples.size() - 1; i++)
+    {
+        const PathSample &current = samples.at(i);
+        PathSample &next = samples[i + 1];
+
+        Vector3 v1 = next.point - current.point;
+        double c1 = v1 * v1;
+        if (c1 <= 0.0)
+        {
+            next.normal = current.normal;
+            continue;
+        }
+
+        Vector3 reflectedNormal = current.normal - (2.0 / c1) * (v1 * current.normal) * v1;
+        Vector3 reflectedTangent = current.tangent - (2.0 / c1) * (v1 * current.tangent) * v1;
+        Vector3 v2 = next.tangent - reflectedTangent;
+        double c2 = v2 * v2;
+
+        next.normal = c2 > 0.0 ? reflectedNormal - (2.0 / c2) * (v2 * reflectedNormal) * v2 : reflectedNormal;
+        // Remove the accumulated numerical error
+        next.normal -= (next.normal * next.tangent) * next.tangent;
+        next.normal.normalize();
+    }
+}
+
+Vector3 CurvedPlanarReformation::getPerpendicularVector(const Vector3 &direction) const
+{
+    Vector3 perpendicular = m_vectorOfInterest - (m_vectorOfInterest * direction) * direction;
+    if (perpendicular.length() < 1e-6)
+    {
+        // The vector of interest is parallel to the direction, take the world axis less aligned with it
+        Vector3 axis = qAbs(direction.x) < 0.9 ? Vector3(1.0, 0.0, 0.0) : Vector3(0.0, 1.0, 0.0);
+        perpendicular = Vector3::cross(direction, axis);
+    }
+
+    return perpendicular.normalize();
+}
+
+vtkSmartPointer<vtkImageData> CurvedPlanarReformation::resample(const QVector<Vector3> &rowOrigins, const QVector<Vector3> &rowSteps, int columns,
+                                                               double rowSpacing) const
+{
+    vtkSmartPointer<vtkImageData> output = vtkSmartPointer<vtkImageData>::New();
+    output->SetExtent(0, columns - 1, 0, rowOrigins.size() - 1, 0, 0);
+    output->SetSpacing(m_sampleSpacing, rowSpacing, 1.0);
+    output->SetOrigin(0.0, 0.0, 0.0);
+    output->AllocateScalars(VTK_FLOAT, 1);
+
+    // Convert the rows from world coordinates to continuous indices relative to the first voxel of the input
+    double origin[3];
+    double spacing[3];
+    int extent[6];
+    m_input->GetOrigin(origin);
+    m_input->GetSpacing(spacing);
+    m_input->GetExtent(extent);
+
+    Vector3 indexOrigin(origin[0] + extent[0] * spacing[0], origin[1] + extent[2] * spacing[1], origin[2] + extent[4] * spacing[2]);
+    QVector<Vector3> indexRowOrigins(rowOrigins.size());
+    QVector<Vector3> indexRowSteps(rowSteps.size());
+    for (int i = 0; i < rowOrigins.size(); i++)
+    {
+        Vector3 rowOrigin = rowOrigins.at(i) - indexOrigin;
+        const Vector3 &rowStep = rowSteps.at(i);
+        indexRowOrigins[i] = Vector3(rowOrigin.x / spacing[0], rowOrigin.y / spacing[1], rowOrigin.z / spacing[2]);
+        indexRowSteps[i] = Vector3(rowStep.x / spacing[0], rowStep.y / spacing[1], rowStep.z / spacing[2]);
+    }
+
+    int dimensions[3];
+    vtkIdType increments[3];
+    m_input->GetDimensions(dimensions);
+    m_input->GetIncrements(increments);
+    float *outputPointer = static_cast<float*>(output->GetScalarPointer());
+
+    switch (m_input->GetScalarType())
+    {
+        vtkTemplateMacro(resampleRows(static_cast<const VTK_TT*>(m_input->GetScalarPointer()), dimensions, increments, indexRowOrigins, indexRowSteps,
+                                      columns, m_backgroundValue, outputPointer));
+    }
+
+    return output;
+}
+
+} // End namespace udg
@@ -0,0 +1,120 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGCURVEDPLANARREFORMATION_H
+#define UDGCURVEDPLANARREFORMATION_H
+
+#include "vector3.h"
+
+#include <QList>
+#include <QVector>
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+namespace udg {
+
+/**
+    Computes curved planar reformations (CPR) of a vtkImageData along a polyline path given in the world coordinates of the image.
+
+    Two reformations are supported:
+    - Straightened: the path is resampled at uniform 3D arc length and each output row samples the image along the normal of a
+      rotation minimizing frame that follows the path. The path becomes a straight vertical line in the middle of the output.
+    - Stretched: each output row samples the image along the fixed vector of interest and rows are spaced by the arc length of the path
+      projected onto the plane perpendicular to that vector, so distances along the path are kept.
+
+    Cross-sections perpendicular to the path can also be computed at any distance along it.
+    Output rows are independent from each other and are computed in parallel. Only the first scalar component of the input is used
+    and the output is always a single component float image with the origin at (0, 0, 0).
+  */
+class CurvedPlanarReformation {
+public:
+    enum ReformationType { Straightened, Stretched };
+
+    CurvedPlanarReformation();
+    ~CurvedPlanarReformation();
+
+    /// Sets the image to reformat
+    void setInput(vtkImageData *input);
+
+    /// Sets the path to follow in world coordinates. Consecutive duplicated points are ignored.
+    void setPath(const QList<Vector3> &path);
+    QList<Vector3> getPath() const;
+
+    /// Sets the vector of interest. It defines the sampling direction of the stretched reformation and the initial normal of the straightened one.
+    void setVectorOfInterest(const Vector3 &vectorOfInterest);
+    Vector3 getVectorOfInterest() const;
+
+    /// Sets the distance in mm between consecutive samples, both along the path and along each row. Default is 1 mm.
+    void setSampleSpacing(double spacing);
+    double getSampleSpacing() const;
+
+    /// Sets the width in mm of each output row and of the side of the cross-sections. Default is 100 mm.
+    void setWidth(double width);
+
+    /// Sets the value given to samples outside the input image. Default is 0.
+    void setBackgroundValue(double value);
+
+    /// Returns the 3D length of the path
+    double getPathLength() const;
+
+    /// Returns the point of the path at the given 3D distance from its first point, clamped to the path ends
+    Vector3 getPathPoint(double distance) const;
+
+    /// Computes and returns the reformation of the given type. Returns a null pointer if there is no input or the path is degenerated.
+    vtkSmartPointer<vtkImageData> computeReformation(ReformationType type) const;
+
+    /// Computes and returns the cross-section perpendicular to the path at the given 3D distance from its first point.
+    /// Returns a null pointer if there is no input or the path is degenerated.
+    vtkSmartPointer<vtkImageData> computeCrossSection(double distance) const;
+
+private:
+    /// Point of the path and frame used to sample one output row
+    struct PathSample {
+        Vector3 point;
+        Vector3 tangent;
+        Vector3 normal;
+    };
+
+    /// Returns the point and tangent of the path at the given distance measured with the given cumulative lengths
+    PathSample getPathSample(const QVector<double> &cumulativeLengths, double distance) const;
+
+    /// Returns the samples of the path taken at uniform intervals of the given cumulative lengths
+    QVector<PathSample> samplePath(const QVector<double> &cumulativeLengths) const;
+
+    /// Returns the cumulative lengths of the path points. If the vector of interest is given, the lengths are measured on the plane perpendicular to it.
+    QVector<double> computeCumulativeLengths(const Vector3 *perpendicularTo = 0) const;
+
+    /// Assigns the normals of the samples with a rotation minimizing frame starting from the vector of interest
+    void computeRotationMinimizingFrames(QVector<PathSample> &samples) const;
+
+    /// Returns a unit vector perpendicular to the given direction, as close as possible to the vector of interest
+    Vector3 getPerpendicularVector(const Vector3 &direction) const;
+
+    /// Fills an image of the given size where each row is sampled from rowOrigins[i] in steps of rowSteps[i]
+    vtkSmartPointer<vtkImageData> resample(const QVector<Vector3> &rowOrigins, const QVector<Vector3> &rowSteps, int columns, double rowSpacing) const;
+
+private:
+    vtkImageData *m_input;
+    QList<Vector3> m_path;
+    Vector3 m_vectorOfInterest;
+    double m_sampleSpacing;
+    double m_width;
+    double m_backgroundValue;
+};
+
+} // End namespace udg
+
+#endif
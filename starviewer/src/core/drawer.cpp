@@ -13,9 +13,10 @@
  *************************************************************************************/
 
 #include "drawer.h"
+#include "drawerlinebatcher.h"
 #include "drawerprimitive.h"
+#include "drawerspatialindex.h"
 #include "logging.h"
-#include "mathtools.h"
 // Vtk
 #include <vtkRenderer.h>
 #include <QColor>
@@ -26,12 +27,15 @@ Drawer::Drawer(Q2DViewer *viewer, QObject *parent)
  : QObject(parent), m_currentPlane(OrthogonalPlane::YZPlane), m_currentSlice(0)
 {
     m_2DViewer = viewer;
+    m_lineBatcher = new DrawerLineBatcher(m_2DViewer->getRenderer());
     connect(m_2DViewer, SIGNAL(sliceChanged(int)), SLOT(refresh()));
     connect(m_2DViewer, SIGNAL(viewChanged(int)), SLOT(refresh()));
 }
 
 Drawer::~Drawer()
 {
+    qDeleteAll(m_spatialIndexes);
+    delete m_lineBatcher;
 }
 
 void Drawer::draw(DrawerPrimitive *primitive, const OrthogonalPlane &plane, int slice)
@@ -56,6 +60,16 @@ void Drawer::draw(DrawerPrimitive *primitive, const OrthogonalPlane &plane, int
             break;
     }
 
+    QPair<int, int> location(plane, slice);
+    DrawerSpatialIndex *&spatialIndex = m_spatialIndexes[location];
+    if (!spatialIndex)
+    {
+        spatialIndex = new DrawerSpatialIndex(plane);
+    }
+    spatialIndex->insert(primitive);
+    m_primitiveLocations.insert(primitive, location);
+    connect(primitive, SIGNAL(changed()), SLOT(invalidateSpatialIndex()), Qt::UniqueConnection);
+
     // Segons quin sigui el pla actual caldrà comprovar
     // la visibilitat de la primitiva segons la llesca
     if (m_2DViewer->getView() == plane)
@@ -163,7 +177,7 @@ void Drawer::removeAllPrimitives()
         // Només esborrarem si ningú és propietari, però no comprovarem si són "erasable" o no
         if (!primitive->hasOwners())
         {
-            m_2DViewer->getRenderer()->RemoveViewProp(primitive->getAsVtkProp());
+            removeFromRenderer(primitive);
             delete primitive;
         }
     }
@@ -194,22 +208,19 @@ void Drawer::erasePrimitive(DrawerPrimitive *primitive)
         }
     }
 
-    // Busquem en el pla axial
-    if (erasePrimitiveFromContainer(primitive, m_XYPlanePrimitives))
-    {
-        // En principi una mateixa primitiva només estarà en una de les llistes
-        return;
-    }
-
-    // Busquem en el pla sagital
-    if (erasePrimitiveFromContainer(primitive, m_YZPlanePrimitives))
+    // Busquem en els plans i llesques on s'ha dibuixat
+    QList<QPair<int, int> > locations = m_primitiveLocations.values(primitive);
+    if (!locations.isEmpty())
     {
-        return;
-    }
+        foreach (const QPair<int, int> &location, locations)
+        {
+            getPrimitivesContainer(OrthogonalPlane(static_cast<OrthogonalPlane::Plane>(location.first)))->remove(location.second, primitive);
+            m_spatialIndexes.value(location)->remove(primitive);
+        }
 
-    // Busquem en el pla coronal
-    if (erasePrimitiveFromContainer(primitive, m_XZPlanePrimitives))
-    {
+        m_primitiveLocations.remove(primitive);
+        disconnect(primitive, SIGNAL(changed()), this, SLOT(invalidateSpatialIndex()));
+        removeFromRenderer(primitive);
         return;
     }
 
@@ -217,7 +228,7 @@ void Drawer::erasePrimitive(DrawerPrimitive *primitive)
     if (m_top2DPlanePrimitives.contains(primitive))
     {
         m_top2DPlanePrimitives.removeAt(m_top2DPlanePrimitives.indexOf(primitive));
-        m_2DViewer->getRenderer()->RemoveViewProp(primitive->getAsVtkProp());
+        removeFromRenderer(primitive);
         m_2DViewer->render();
     }
 }
@@ -351,123 +362,70 @@ void Drawer::enableGroup(const QString &groupName)
 
 DrawerPrimitive* Drawer::getNearestErasablePrimitiveToPoint(double point[3], const OrthogonalPlane &view, int slice, double closestPoint[3])
 {
-    double distance;
-    double minimumDistance = MathTools::DoubleMaximumValue;
-    QList<DrawerPrimitive*> primitivesList;
-
-    DrawerPrimitive *nearestPrimitive = 0;
-
-    switch (view)
+    DrawerSpatialIndex *spatialIndex = m_spatialIndexes.value(qMakePair(static_cast<int>(view), slice));
+    if (!spatialIndex)
     {
-        case OrthogonalPlane::XYPlane:
-            primitivesList = m_XYPlanePrimitives.values(slice);
-            break;
-
-        case OrthogonalPlane::YZPlane:
-            primitivesList = m_YZPlanePrimitives.values(slice);
-            break;
+        return 0;
+    }
 
-        case OrthogonalPlane::XZPlane:
-            primitivesList = m_XZPlanePrimitives.values(slice);
-            break;
+    double distance;
+    return spatialIndex->getNearestErasablePrimitive(point, closestPoint, distance);
+}
 
-        default:
-            break;
+void Drawer::erasePrimitivesInsideBounds(double bounds[6], const OrthogonalPlane &view, int slice)
+{
+    DrawerSpatialIndex *spatialIndex = m_spatialIndexes.value(qMakePair(static_cast<int>(view), slice));
+    if (!spatialIndex)
+    {
+        return;
     }
 
-    double localClosestPoint[3];
-    foreach (DrawerPrimitive *primitive, primitivesList)
+    foreach (DrawerPrimitive *primitive, spatialIndex->getErasablePrimitivesInside(bounds))
     {
-        if (primitive->isErasable())
-        {
-            distance = primitive->getDistanceToPoint(point, localClosestPoint);
-            if (distance <= minimumDistance)
-            {
-                minimumDistance = distance;
-                nearestPrimitive = primitive;
-                closestPoint[0] = localClosestPoint[0];
-                closestPoint[1] = localClosestPoint[1];
-                closestPoint[2] = localClosestPoint[2];
-            }
-        }
+        erasePrimitive(primitive);
     }
-    return nearestPrimitive;
 }
 
-void Drawer::erasePrimitivesInsideBounds(double bounds[6], const OrthogonalPlane &view, int slice)
+QMultiMap<int, DrawerPrimitive*>* Drawer::getPrimitivesContainer(const OrthogonalPlane &plane)
 {
-    QList<DrawerPrimitive*> primitivesList;
-
-    switch (view)
+    switch (plane)
     {
         case OrthogonalPlane::XYPlane:
-            primitivesList = m_XYPlanePrimitives.values(slice);
-            break;
+            return &m_XYPlanePrimitives;
 
         case OrthogonalPlane::YZPlane:
-            primitivesList = m_YZPlanePrimitives.values(slice);
-            break;
+            return &m_YZPlanePrimitives;
 
         case OrthogonalPlane::XZPlane:
-            primitivesList = m_XZPlanePrimitives.values(slice);
-            break;
+            return &m_XZPlanePrimitives;
 
         default:
-            break;
-    }
-
-    foreach (DrawerPrimitive *primitive, primitivesList)
-    {
-        if (primitive->isErasable())
-        {
-            if (isPrimitiveInside(primitive, view, bounds))
-            {
-                erasePrimitive(primitive);
-            }
-        }
+            return 0;
     }
 }
 
-bool Drawer::isPrimitiveInside(DrawerPrimitive *primitive, const OrthogonalPlane &view, double bounds[6])
+void Drawer::invalidateSpatialIndex()
 {
-    // Comprovem que els bounds de la primitiva estiguin continguts
-    // dins dels que ens han passat per paràmetre
-    double primitiveBounds[6];
-    primitive->getBounds(primitiveBounds);
-
-    int xIndex = view.getXIndex();
-    int yIndex = view.getYIndex();
-
-    bool inside = false;
-    if (bounds[xIndex * 2] <= primitiveBounds[xIndex * 2] && bounds[xIndex * 2 + 1] >= primitiveBounds[xIndex * 2 + 1] &&
-        bounds[yIndex * 2] <= primitiveBounds[yIndex * 2] && bounds[yIndex * 2 + 1] >= primitiveBounds[yIndex * 2 + 1])
+    DrawerPrimitive *primitive = qobject_cast<DrawerPrimitive*>(sender());
+    foreach (const QPair<int, int> &location, m_primitiveLocations.values(primitive))
     {
-        inside = true;
+        m_spatialIndexes.value(location)->invalidate();
     }
-
-    return inside;
 }
 
-bool Drawer::erasePrimitiveFromContainer(DrawerPrimitive *primitive, QMultiMap<int, DrawerPrimitive*> &primitiveContainer)
+void Drawer::renderPrimitive(DrawerPrimitive *primitive)
 {
-    bool found = false;
-    QMutableMapIterator<int, DrawerPrimitive*> containerIterator(primitiveContainer);
-    while (containerIterator.hasNext() && !found)
+    if (DrawerLineBatcher::canBatch(primitive))
     {
-        containerIterator.next();
-        if (primitive == containerIterator.value())
+        connect(primitive, SIGNAL(dying(DrawerPrimitive*)), SLOT(erasePrimitive(DrawerPrimitive*)), Qt::UniqueConnection);
+        m_lineBatcher->add(primitive);
+        if (primitive->isVisible())
         {
-            found = true;
-            containerIterator.remove();
-            m_2DViewer->getRenderer()->RemoveViewProp(primitive->getAsVtkProp());
+            m_2DViewer->render();
         }
+        return;
     }
 
-    return found;
-}
-
-void Drawer::renderPrimitive(DrawerPrimitive *primitive)
-{
     vtkProp *prop = primitive->getAsVtkProp();
     if (prop)
     {
@@ -480,4 +438,16 @@ void Drawer::renderPrimitive(DrawerPrimitive *primitive)
     }
 }
 
+void Drawer::removeFromRenderer(DrawerPrimitive *primitive)
+{
+    if (DrawerLineBatcher::canBatch(primitive))
+    {
+        m_lineBatcher->remove(primitive);
+    }
+    else
+    {
+        m_2DViewer->getRenderer()->RemoveViewProp(primitive->getAsVtkProp());
+    }
+}
+
 }
@@ -16,14 +16,18 @@
 #define UDGDRAWER_H
 
 #include <QObject>
+#include <QHash>
 #include <QMultiMap>
+#include <QPair>
 #include <QSet>
 
 #include "q2dviewer.h"
 
 namespace udg {
 
+class DrawerLineBatcher;
 class DrawerPrimitive;
+class DrawerSpatialIndex;
 
 /**
     Classe encarregada de pintar els objectes de primitiva gràfica en el viewer assignat
@@ -88,20 +92,22 @@ private:
     void hide(const OrthogonalPlane &plane, int slice);
     void show(const OrthogonalPlane &plane, int slice);
 
-    /// Ens diu si la primitiva donada, que es troba a la vista view, està dins dels bounds indicats
-    bool isPrimitiveInside(DrawerPrimitive *primitive, const OrthogonalPlane &view, double bounds[6]);
-
-    /// Esborra la primitiva donada del contenidor de primitives especificat.
-    /// Si la troba l'esborra. Retorna cert si la troba, fals altrament.
-    bool erasePrimitiveFromContainer(DrawerPrimitive *primitive, QMultiMap<int, DrawerPrimitive*> &primitiveContainer);
+    /// Retorna el contenidor de primitives del pla donat, o nul si el pla no és vàlid
+    QMultiMap<int, DrawerPrimitive*>* getPrimitivesContainer(const OrthogonalPlane &plane);
 
     /// Fa que la primitiva es pugui visualitzar al visor associat
     void renderPrimitive(DrawerPrimitive *primitive);
 
+    /// Treu la primitiva de l'escena, ja sigui el seu vtkProp o el DrawerLineBatcher que la pinta
+    void removeFromRenderer(DrawerPrimitive *primitive);
+
 private slots:
     /// Refresca les primitives que s'han de veure pel viewer segons el seu estat
     void refresh();
 
+    /// Marca com a desactualitzats els índexs espacials de la primitiva que ha emès el senyal, perquè els seus límits poden haver canviat
+    void invalidateSpatialIndex();
+
 private:
     /// Viewer sobre el qual pintarem les primitives
     Q2DViewer *m_2DViewer;
@@ -112,6 +118,15 @@ private:
     QMultiMap<int, DrawerPrimitive*> m_XZPlanePrimitives;
     QList<DrawerPrimitive*> m_top2DPlanePrimitives;
 
+    /// Índexs espacials de les primitives de cada pla i llesca, per trobar ràpidament les primitives properes a un punt o dins d'uns límits
+    QHash<QPair<int, int>, DrawerSpatialIndex*> m_spatialIndexes;
+
+    /// Pla i llesca on s'ha dibuixat cada primitiva
+    QMultiHash<DrawerPrimitive*, QPair<int, int> > m_primitiveLocations;
+
+    /// Pinta les línies i polilínies agrupades en uns pocs actors compartits
+    DrawerLineBatcher *m_lineBatcher;
+
     /// Pla i llesca en el que es troba en aquell moment el 2D Viewer. Serveix per controlar
     /// els canvis de llesca i de pla, per saber quines primitives hem de netejar
     OrthogonalPlane m_currentPlane;
@@ -13,6 +13,7 @@
  *************************************************************************************/
 
 #include "drawerline.h"
+#include "drawerlinebatcher.h"
 #include "logging.h"
 #include "mathtools.h"
 // Vtk
@@ -126,7 +127,15 @@ void DrawerLine::update()
     switch (m_internalRepresentation)
     {
         case VTKRepresentation:
-            updateVtkProp();
+            if (m_lineBatcher)
+            {
+                m_lineBatcher->update(this);
+                this->setModified(false);
+            }
+            else
+            {
+                updateVtkProp();
+            }
             break;
 
         case OpenGLRepresentation:
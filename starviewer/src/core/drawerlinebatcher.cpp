@@ -0,0 +1,423 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "drawerlinebatcher.h"
+
+#include "drawerline.h"
+#include "drawerpolyline.h"
+
+#include <vtkActor2D.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCellArray.h>
+#include <vtkCoordinate.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataMapper2D.h>
+#include <vtkPropAssembly.h>
+#include <vtkProperty2D.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+
+namespace udg {
+
+/// Shared geometry and actors of the primitives with the same style
+struct DrawerLineBatcher::Batch {
+    QString styleKey;
+
+    vtkSmartPointer<vtkPoints> points;
+    vtkSmartPointer<vtkCellArray> cells;
+    vtkSmartPointer<vtkPolyData> polyData;
+    vtkSmartPointer<vtkPropAssembly> propAssembly;
+
+    /// Primitives in the order of their ranges, which are consecutive, so the cell of the primitive at position i begins at
+    /// firstPoints[i] + i in the cell array. Removed primitives that couldn't be swapped with the last one are left as null holes
+    /// until the batch is compacted. The last primitive is never a hole.
+    QVector<DrawerPrimitive*> primitives;
+    QVector<int> firstPoints;
+    QVector<int> numbersOfPoints;
+    QHash<DrawerPrimitive*, int> positions;
+    int numberOfHoles;
+};
+
+DrawerLineBatcher::DrawerLineBatcher(vtkRenderer *renderer)
+ : m_renderer(renderer)
+{
+    m_callbackCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+    m_callbackCommand->SetCallback(&DrawerLineBatcher::processEvent);
+    m_callbackCommand->SetClientData(this);
+
+    if (m_renderer)
+    {
+        m_renderer->AddObserver(vtkCommand::StartEvent, m_callbackCommand);
+    }
+}
+
+DrawerLineBatcher::~DrawerLineBatcher()
+{
+    if (m_renderer)
+    {
+        m_renderer->RemoveObserver(m_callbackCommand);
+    }
+
+    foreach (DrawerPrimitive *primitive, m_primitives.keys())
+    {
+        primitive->setLineBatcher(0);
+    }
+
+    foreach (Batch *batch, m_batches)
+    {
+        m_renderer->RemoveViewProp(batch->propAssembly);
+    }
+    qDeleteAll(m_batches);
+}
+
+bool DrawerLineBatcher::canBatch(DrawerPrimitive *primitive)
+{
+    return primitive->getCoordinateSystem() == DrawerPrimitive::WorldCoordinateSystem
+        && (qobject_cast<DrawerLine*>(primitive) || qobject_cast<DrawerPolyline*>(primitive));
+}
+
+void DrawerLineBatcher::add(DrawerPrimitive *primitive)
+{
+    if (m_primitives.contains(primitive))
+    {
+        return;
+    }
+
+    m_primitives.insert(primitive, 0);
+    primitive->setLineBatcher(this);
+    update(primitive);
+}
+
+bool DrawerLineBatcher::remove(DrawerPrimitive *primitive)
+{
+    QHash<DrawerPrimitive*, Batch*>::iterator iterator = m_primitives.find(primitive);
+    if (iterator == m_primitives.end())
+    {
+        return false;
+    }
+
+    if (iterator.value())
+    {
+        removeFromBatch(iterator.value(), primitive);
+    }
+
+    m_primitives.remove(primitive);
+    primitive->setLineBatcher(0);
+    return true;
+}
+
+bool DrawerLineBatcher::contains(DrawerPrimitive *primitive) const
+{
+    return m_primitives.contains(primitive);
+}
+
+void DrawerLineBatcher::update(DrawerPrimitive *primitive)
+{
+    QHash<DrawerPrimitive*, Batch*>::iterator iterator = m_primitives.find(primitive);
+    if (iterator == m_primitives.end())
+    {
+        return;
+    }
+
+    Batch *batch = iterator.value();
+
+    QVector<double> points;
+    if (primitive->isVisible())
+    {
+        getPoints(primitive, points);
+    }
+
+    if (points.isEmpty())
+    {
+        if (batch)
+        {
+            removeFromBatch(batch, primitive);
+        }
+        return;
+    }
+
+    QString styleKey = getStyleKey(primitive);
+
+    if (batch && batch->styleKey == styleKey)
+    {
+        int position = batch->positions.value(primitive);
+        int numberOfPoints = points.size() / 3;
+        if (batch->numbersOfPoints.at(position) == numberOfPoints)
+        {
+            // Same shape, its range is overwritten in place
+            int firstPoint = batch->firstPoints.at(position);
+            for (int i = 0; i < numberOfPoints; i++)
+            {
+                batch->points->SetPoint(firstPoint + i, points.constData() + i * 3);
+            }
+            batch->points->Modified();
+            return;
+        }
+    }
+
+    if (batch)
+    {
+        removeFromBatch(batch, primitive);
+    }
+    appendToBatch(getBatch(styleKey, primitive), primitive, points);
+}
+
+int DrawerLineBatcher::getNumberOfBatches() const
+{
+    return m_batches.size();
+}
+
+void DrawerLineBatcher::compact()
+{
+    foreach (Batch *batch, m_batches)
+    {
+        compact(batch);
+    }
+}
+
+QString DrawerLineBatcher::getStyleKey(DrawerPrimitive *primitive)
+{
+    return QString("%1;%2;%3;%4").arg(primitive->getColor().rgba()).arg(primitive->getLineWidth()).arg(primitive->getLinePattern())
+        .arg(primitive->getOpacity());
+}
+
+void DrawerLineBatcher::getPoints(DrawerPrimitive *primitive, QVector<double> &points)
+{
+    points.clear();
+
+    if (DrawerLine *line = qobject_cast<DrawerLine*>(primitive))
+    {
+        double *firstPoint = line->getFirstPoint();
+        double *secondPoint = line->getSecondPoint();
+        points << firstPoint[0] << firstPoint[1] << firstPoint[2] << secondPoint[0] << secondPoint[1] << secondPoint[2];
+    }
+    else if (DrawerPolyline *polyline = qobject_cast<DrawerPolyline*>(primitive))
+    {
+        int numberOfPoints = polyline->getNumberOfPoints();
+        points.reserve(numberOfPoints * 3);
+        for (int i = 0; i < numberOfPoints; i++)
+        {
+            double *point = polyline->getPoint(i);
+            points << point[0] << point[1] << point[2];
+        }
+    }
+}
+
+DrawerLineBatcher::Batch* DrawerLineBatcher::getBatch(const QString &styleKey, DrawerPrimitive *primitive)
+{
+    Batch *&batch = m_batches[styleKey];
+    if (batch)
+    {
+        return batch;
+    }
+
+    batch = new Batch();
+    batch->styleKey = styleKey;
+    batch->numberOfHoles = 0;
+    batch->points = vtkSmartPointer<vtkPoints>::New();
+    batch->cells = vtkSmartPointer<vtkCellArray>::New();
+    batch->polyData = vtkSmartPointer<vtkPolyData>::New();
+    batch->polyData->SetPoints(batch->points);
+    batch->polyData->SetLines(batch->cells);
+
+    vtkSmartPointer<vtkCoordinate> coordinate = vtkSmartPointer<vtkCoordinate>::New();
+    coordinate->SetCoordinateSystemToWorld();
+
+    vtkSmartPointer<vtkPolyDataMapper2D> mapper = vtkSmartPointer<vtkPolyDataMapper2D>::New();
+    mapper->SetInputData(batch->polyData);
+    mapper->SetTransformCoordinate(coordinate);
+
+    // Same look as DrawerLine and DrawerPolyline: a black outline behind the line
+    vtkSmartPointer<vtkActor2D> actor = vtkSmartPointer<vtkActor2D>::New();
+    vtkSmartPointer<vtkActor2D> backgroundActor = vtkSmartPointer<vtkActor2D>::New();
+    actor->SetMapper(mapper);
+    backgroundActor->SetMapper(mapper);
+
+    vtkProperty2D *properties = actor->GetProperty();
+    vtkProperty2D *backgroundProperties = backgroundActor->GetProperty();
+    properties->SetLineStipplePattern(primitive->getLinePattern());
+    backgroundProperties->SetLineStipplePattern(primitive->getLinePattern());
+    properties->SetLineWidth(primitive->getLineWidth());
+    backgroundProperties->SetLineWidth(primitive->getLineWidth() + 2);
+    properties->SetOpacity(primitive->getOpacity());
+    backgroundProperties->SetOpacity(primitive->getOpacity());
+    QColor color = primitive->getColor();
+    properties->SetColor(color.redF(), color.greenF(), color.blueF());
+    backgroundProperties->SetColor(0.0, 0.0, 0.0);
+
+    batch->propAssembly = vtkSmartPointer<vtkPropAssembly>::New();
+    batch->propAssembly->AddPart(backgroundActor);
+    batch->propAssembly->AddPart(actor);
+    m_renderer->AddViewProp(batch->propAssembly);
+
+    return batch;
+}
+
+void DrawerLineBatcher::appendToBatch(Batch *batch, DrawerPrimitive *primitive, const QVector<double> &points)
+{
+    int numberOfPoints = points.size() / 3;
+    int firstPoint = batch->points->GetNumberOfPoints();
+
+    batch->cells->InsertNextCell(numberOfPoints);
+    for (int i = 0; i < numberOfPoints; i++)
+    {
+        batch->points->InsertNextPoint(points.constData() + i * 3);
+        batch->cells->InsertCellPoint(firstPoint + i);
+    }
+
+    batch->positions.insert(primitive, batch->primitives.size());
+    batch->primitives.append(primitive);
+    batch->firstPoints.append(firstPoint);
+    batch->numbersOfPoints.append(numberOfPoints);
+    batch->points->Modified();
+    batch->polyData->Modified();
+
+    m_primitives[primitive] = batch;
+}
+
+void DrawerLineBatcher::removeFromBatch(Batch *batch, DrawerPrimitive *primitive)
+{
+    int position = batch->positions.take(primitive);
+    int lastPosition = batch->primitives.size() - 1;
+    m_primitives[primitive] = 0;
+
+    if (batch->positions.isEmpty())
+    {
+        m_renderer->RemoveViewProp(batch->propAssembly);
+        m_batches.remove(batch->styleKey);
+        delete batch;
+        return;
+    }
+
+    if (position != lastPosition && batch->numbersOfPoints.at(position) == batch->numbersOfPoints.at(lastPosition))
+    {
+        // The last primitive is moved to the freed range, so its cell is still valid and only the last range has to be dropped
+        int firstPoint = batch->firstPoints.at(position);
+        int lastFirstPoint = batch->firstPoints.at(lastPosition);
+        for (int i = 0; i < batch->numbersOfPoints.at(position); i++)
+        {
+            batch->points->SetPoint(firstPoint + i, batch->points->GetPoint(lastFirstPoint + i));
+        }
+
+        DrawerPrimitive *lastPrimitive = batch->primitives.at(lastPosition);
+        batch->primitives[position] = lastPrimitive;
+        batch->positions[lastPrimitive] = position;
+        position = lastPosition;
+    }
+
+    // Ranges of different sizes can't be swapped, so the range is left as a hole until the batch is compacted
+    batch->primitives[position] = 0;
+    batch->numberOfHoles++;
+
+    if (position == lastPosition)
+    {
+        dropTrailingHoles(batch);
+    }
+
+    batch->points->Modified();
+    batch->polyData->Modified();
+}
+
+void DrawerLineBatcher::dropTrailingHoles(Batch *batch)
+{
+    int numberOfPrimitives = batch->primitives.size();
+    while (numberOfPrimitives > 0 && !batch->primitives.at(numberOfPrimitives - 1))
+    {
+        numberOfPrimitives--;
+    }
+
+    int numberOfPoints = 0;
+    if (numberOfPrimitives > 0)
+    {
+        numberOfPoints = batch->firstPoints.at(numberOfPrimitives - 1) + batch->numbersOfPoints.at(numberOfPrimitives - 1);
+    }
+
+    batch->points->SetNumberOfPoints(numberOfPoints);
+    vtkIdTypeArray *cellData = batch->cells->GetData();
+    cellData->SetNumberOfValues(numberOfPoints + numberOfPrimitives);
+    batch->cells->SetCells(numberOfPrimitives, cellData);
+
+    batch->numberOfHoles -= batch->primitives.size() - numberOfPrimitives;
+    batch->primitives.resize(numberOfPrimitives);
+    batch->firstPoints.resize(numberOfPrimitives);
+    batch->numbersOfPoints.resize(numberOfPrimitives);
+}
+
+void DrawerLineBatcher::compact(Batch *batch)
+{
+    if (batch->numberOfHoles == 0)
+    {
+        return;
+    }
+
+    // The ranges of the primitives are moved back over the holes in a single pass
+    vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+    int numberOfPrimitives = 0;
+    int numberOfPoints = 0;
+    for (int i = 0; i < batch->primitives.size(); i++)
+    {
+        DrawerPrimitive *primitive = batch->primitives.at(i);
+        if (!primitive)
+        {
+            continue;
+        }
+
+        int firstPoint = batch->firstPoints.at(i);
+        int primitiveNumberOfPoints = batch->numbersOfPoints.at(i);
+        if (firstPoint != numberOfPoints)
+        {
+            for (int j = 0; j < primitiveNumberOfPoints; j++)
+            {
+                batch->points->SetPoint(numberOfPoints + j, batch->points->GetPoint(firstPoint + j));
+            }
+        }
+
+        cells->InsertNextCell(primitiveNumberOfPoints);
+        for (int j = 0; j < primitiveNumberOfPoints; j++)
+        {
+            cells->InsertCellPoint(numberOfPoints + j);
+        }
+
+        batch->primitives[numberOfPrimitives] = primitive;
+        batch->firstPoints[numberOfPrimitives] = numberOfPoints;
+        batch->numbersOfPoints[numberOfPrimitives] = primitiveNumberOfPoints;
+        batch->positions[primitive] = numberOfPrimitives;
+        numberOfPrimitives++;
+        numberOfPoints += primitiveNumberOfPoints;
+    }
+
+    batch->points->SetNumberOfPoints(numberOfPoints);
+    batch->primitives.resize(numberOfPrimitives);
+    batch->firstPoints.resize(numberOfPrimitives);
+    batch->numbersOfPoints.resize(numberOfPrimitives);
+    batch->numberOfHoles = 0;
+
+    batch->cells = cells;
+    batch->polyData->SetLines(cells);
+    batch->points->Modified();
+    batch->polyData->Modified();
+}
+
+void DrawerLineBatcher::processEvent(vtkObject *caller, unsigned long eventId, void *clientData, void *callData)
+{
+    Q_UNUSED(caller);
+    Q_UNUSED(eventId);
+    Q_UNUSED(callData);
+
+    static_cast<DrawerLineBatcher*>(clientData)->compact();
+}
+
+} // End namespace udg
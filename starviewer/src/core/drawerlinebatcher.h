@@ -0,0 +1,112 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGDRAWERLINEBATCHER_H
+#define UDGDRAWERLINEBATCHER_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include <vtkSmartPointer.h>
+
+class vtkCallbackCommand;
+class vtkObject;
+class vtkRenderer;
+
+namespace udg {
+
+class DrawerPrimitive;
+
+/**
+    Draws the lines and polylines of a Drawer with a few shared actors instead of a pair of actors for each primitive.
+
+    The primitives with the same style (color, width, pattern and opacity) share a batch: a polydata with the points of all of them, drawn
+    with a foreground and a background actor like the ones of DrawerLine. Each primitive owns a range of consecutive points and a cell of
+    the polydata. Updating a primitive without changing its number of points overwrites its range in place, and removing it moves the last
+    primitive of the batch to its range when both have the same number of points, so batches of lines are never rebuilt. Otherwise the range
+    is left as a hole and the batch is compacted when the renderer starts the next render, so removing many polylines rebuilds it only once.
+
+    Only the visible primitives are in a batch, so hiding the primitives of a slice takes them out of the polydata instead of leaving hidden
+    actors in the renderer. Only primitives in world coordinates are batched, the ones in display coordinates keep their own actors.
+  */
+class DrawerLineBatcher {
+public:
+    DrawerLineBatcher(vtkRenderer *renderer);
+    ~DrawerLineBatcher();
+
+    /// Returns true if the primitive can be drawn by a batcher. Its coordinate system must not change after it's added.
+    static bool canBatch(DrawerPrimitive *primitive);
+
+    /// Starts drawing the given primitive
+    void add(DrawerPrimitive *primitive);
+
+    /// Stops drawing the primitive. Returns false if it wasn't drawn by the batcher.
+    bool remove(DrawerPrimitive *primitive);
+
+    /// Returns true if the primitive is drawn by the batcher
+    bool contains(DrawerPrimitive *primitive) const;
+
+    /// Brings the geometry, style and visibility of the primitive up to date in the batches
+    void update(DrawerPrimitive *primitive);
+
+    /// Returns the number of batches, that is, the number of pairs of actors added to the renderer
+    int getNumberOfBatches() const;
+
+    /// Rebuilds the batches that have holes left by removed primitives. It's called when the renderer starts rendering.
+    void compact();
+
+private:
+    struct Batch;
+
+    /// Returns the key of the style of the primitive. Primitives with the same key share a batch.
+    static QString getStyleKey(DrawerPrimitive *primitive);
+
+    /// Fills points with the coordinates of the points of the primitive
+    static void getPoints(DrawerPrimitive *primitive, QVector<double> &points);
+
+    /// Returns the batch with the given style, creating it if needed
+    Batch* getBatch(const QString &styleKey, DrawerPrimitive *primitive);
+
+    /// Adds the primitive with the given points at the end of the batch
+    void appendToBatch(Batch *batch, DrawerPrimitive *primitive, const QVector<double> &points);
+
+    /// Takes the primitive out of its batch and deletes the batch if it becomes empty
+    void removeFromBatch(Batch *batch, DrawerPrimitive *primitive);
+
+    /// Drops the ranges of the removed primitives at the end of the batch
+    static void dropTrailingHoles(Batch *batch);
+
+    /// Moves the ranges of the batch back over its holes and rebuilds its cells
+    static void compact(Batch *batch);
+
+    /// Compacts the batches when the renderer starts rendering
+    static void processEvent(vtkObject *caller, unsigned long eventId, void *clientData, void *callData);
+
+private:
+    vtkRenderer *m_renderer;
+
+    /// Observes the start of the renders of m_renderer
+    vtkSmartPointer<vtkCallbackCommand> m_callbackCommand;
+
+    /// Batches by style key
+    QHash<QString, Batch*> m_batches;
+
+    /// All the primitives drawn by the batcher with the batch they are in, null for the ones that aren't visible
+    QHash<DrawerPrimitive*, Batch*> m_primitives;
+};
+
+} // End namespace udg
+
+#endif
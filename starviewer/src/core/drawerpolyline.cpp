@@ -13,6 +13,7 @@
  *************************************************************************************/
 
 #include "drawerpolyline.h"
+#include "drawerlinebatcher.h"
 #include "logging.h"
 #include "mathtools.h"
 // Vtk
@@ -150,7 +151,15 @@ void DrawerPolyline::update()
     switch (m_internalRepresentation)
     {
         case VTKRepresentation:
-            updateVtkProp();
+            if (m_lineBatcher)
+            {
+                m_lineBatcher->update(this);
+                this->setModified(false);
+            }
+            else
+            {
+                updateVtkProp();
+            }
             break;
 
         case OpenGLRepresentation:
@@ -237,13 +246,25 @@ double DrawerPolyline::getDistanceToPoint(double *point3D, double closestPoint[3
 
 void DrawerPolyline::getBounds(double bounds[6])
 {
-    if (m_vtkPolydata)
+    // Es calculen a partir dels punts perquè la polilínia pot no tenir vtkPolyData si la pinta un DrawerLineBatcher
+    if (m_pointsList.isEmpty())
     {
-        m_vtkPolydata->GetBounds(bounds);
+        memset(bounds, 0.0, sizeof(double) * 6);
+        return;
     }
-    else
+
+    for (int i = 0; i < 3; i++)
     {
-        memset(bounds, 0.0, sizeof(double) * 6);
+        bounds[i * 2] = bounds[i * 2 + 1] = m_pointsList.first().at(i);
+    }
+
+    foreach (const QVector<double> &point, m_pointsList)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            bounds[i * 2] = qMin(bounds[i * 2], point.at(i));
+            bounds[i * 2 + 1] = qMax(bounds[i * 2 + 1], point.at(i));
+        }
     }
 }
 
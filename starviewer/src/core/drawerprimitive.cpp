@@ -13,6 +13,7 @@
  *************************************************************************************/
 
 #include "drawerprimitive.h"
+#include "drawerlinebatcher.h"
 // Vtk
 #include <vtkCoordinate.h>
 
@@ -20,7 +21,8 @@ namespace udg {
 
 DrawerPrimitive::DrawerPrimitive(QObject *parent)
 : QObject(parent), m_internalRepresentation(VTKRepresentation), m_isVisible(true), m_coordinateSystem(WorldCoordinateSystem), m_color(QColor(255, 165, 0)),
-  m_isFilled(false), m_linePattern(ContinuousLinePattern), m_lineWidth(2.0), m_opacity(1.0), m_modified(false), m_referenceCount(0), m_coordinate(0)
+  m_isFilled(false), m_linePattern(ContinuousLinePattern), m_lineWidth(2.0), m_opacity(1.0), m_modified(false),
+  m_lineBatcher(0), m_referenceCount(0), m_coordinate(0)
 {
     m_isErasable = true;
     connect(this, SIGNAL(changed()), SLOT(setModified()));
@@ -28,6 +30,11 @@ DrawerPrimitive::DrawerPrimitive(QObject *parent)
 
 DrawerPrimitive::~DrawerPrimitive()
 {
+    if (m_lineBatcher)
+    {
+        m_lineBatcher->remove(this);
+    }
+
     if (m_coordinate)
     {
         m_coordinate->Delete();
@@ -136,6 +143,11 @@ vtkProp* DrawerPrimitive::getAsVtkProp()
     return 0;
 }
 
+bool DrawerPrimitive::hasViewDependentBounds() const
+{
+    return m_coordinateSystem == DisplayCoordinateSystem;
+}
+
 bool DrawerPrimitive::isModified() const
 {
     return m_modified;
@@ -172,6 +184,16 @@ void DrawerPrimitive::setModified(bool modified)
     m_modified = modified;
 }
 
+void DrawerPrimitive::setLineBatcher(DrawerLineBatcher *batcher)
+{
+    m_lineBatcher = batcher;
+}
+
+DrawerLineBatcher* DrawerPrimitive::getLineBatcher() const
+{
+    return m_lineBatcher;
+}
+
 vtkCoordinate* DrawerPrimitive::getVtkCoordinateObject()
 {
     if (m_coordinate)
@@ -23,6 +23,8 @@ class vtkCoordinate;
 
 namespace udg {
 
+class DrawerLineBatcher;
+
 /**
     Classe base de les primitives que pintarà la classe Drawer
 
@@ -96,6 +98,14 @@ public:
     /// en aquest ordre: minX, maxX, minY, maxY, minZ, maxZ
     virtual void getBounds(double bounds[6]) = 0;
 
+    /// Ens diu si els límits de la primitiva depenen de la càmera, com els de les primitives en coordenades de display.
+    /// Aquestes primitives no es poden indexar pels seus límits.
+    virtual bool hasViewDependentBounds() const;
+
+    /// Assigna/Obté el DrawerLineBatcher que dibuixa la primitiva. Si és nul, la primitiva es dibuixa amb el seu propi vtkProp
+    void setLineBatcher(DrawerLineBatcher *batcher);
+    DrawerLineBatcher* getLineBatcher() const;
+
     /// HACK això és una solució temporal, minimitzar el seu ús a casos molt concrets!
     /// Mètodes per emular els smart pointers.
     /// En molts casos necessitem que una primitiva creada per una classe
@@ -185,6 +195,9 @@ protected:
     /// Indica si alguna de les propietats s'han modificat
     bool m_modified;
 
+    /// DrawerLineBatcher que dibuixa la primitiva, si n'hi ha
+    DrawerLineBatcher *m_lineBatcher;
+
 private:
     /// Propietat d'esborrabilitat de la primitiva
     bool m_isErasable;
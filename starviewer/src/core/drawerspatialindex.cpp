@@ -0,0 +1,334 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "drawerspatialindex.h"
+
+#include "drawerprimitive.h"
+#include "mathtools.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cmath>
+
+namespace udg {
+
+namespace {
+
+// Maximum number of entries of a leaf
+const int MaximumEntriesPerLeaf = 4;
+
+}
+
+DrawerSpatialIndex::DrawerSpatialIndex(const OrthogonalPlane &plane)
+ : m_isOutdated(false)
+{
+    m_xIndex = plane.getXIndex();
+    m_yIndex = plane.getYIndex();
+}
+
+DrawerSpatialIndex::~DrawerSpatialIndex()
+{
+}
+
+void DrawerSpatialIndex::insert(DrawerPrimitive *primitive)
+{
+    if (!primitive || m_positions.contains(primitive))
+    {
+        return;
+    }
+
+    m_positions.insert(primitive, m_primitives.size());
+    m_primitives.append(primitive);
+    m_isOutdated = true;
+}
+
+bool DrawerSpatialIndex::remove(DrawerPrimitive *primitive)
+{
+    QHash<DrawerPrimitive*, int>::iterator iterator = m_positions.find(primitive);
+    if (iterator == m_positions.end())
+    {
+        return false;
+    }
+
+    // The last primitive takes the place of the removed one
+    int position = iterator.value();
+    m_positions.erase(iterator);
+    DrawerPrimitive *lastPrimitive = m_primitives.last();
+    m_primitives.removeLast();
+    if (lastPrimitive != primitive)
+    {
+        m_primitives[position] = lastPrimitive;
+        m_positions[lastPrimitive] = position;
+    }
+
+    m_isOutdated = true;
+    return true;
+}
+
+void DrawerSpatialIndex::invalidate()
+{
+    m_isOutdated = true;
+}
+
+int DrawerSpatialIndex::getNumberOfPrimitives() const
+{
+    return m_primitives.size();
+}
+
+DrawerPrimitive* DrawerSpatialIndex::getNearestErasablePrimitive(double point[3], double closestPoint[3], double &distance)
+{
+    update();
+
+    DrawerPrimitive *nearestPrimitive = 0;
+    distance = MathTools::DoubleMaximumValue;
+
+    foreach (DrawerPrimitive *primitive, m_viewDependentPrimitives)
+    {
+        testNearest(primitive, point, nearestPrimitive, closestPoint, distance);
+    }
+
+    if (m_nodes.isEmpty())
+    {
+        return nearestPrimitive;
+    }
+
+    // The distance to the bounds of a node is a lower bound of the distance to its primitives, so the nodes farther than the nearest
+    // primitive found are skipped and the nearest child is visited first
+    QVarLengthArray<int, 64> pendingNodes;
+    pendingNodes.append(0);
+    while (!pendingNodes.isEmpty())
+    {
+        const Node &node = m_nodes.at(pendingNodes.last());
+        pendingNodes.removeLast();
+
+        if (getDistance(point, node.bounds) > distance)
+        {
+            continue;
+        }
+
+        if (node.numberOfEntries > 0)
+        {
+            for (int i = node.firstEntry; i < node.firstEntry + node.numberOfEntries; i++)
+            {
+                const Entry &entry = m_entries.at(i);
+                if (getDistance(point, entry.bounds) <= distance)
+                {
+                    testNearest(entry.primitive, point, nearestPrimitive, closestPoint, distance);
+                }
+            }
+        }
+        else
+        {
+            double firstDistance = getDistance(point, m_nodes.at(node.firstChild).bounds);
+            double secondDistance = getDistance(point, m_nodes.at(node.secondChild).bounds);
+            if (firstDistance < secondDistance)
+            {
+                pendingNodes.append(node.secondChild);
+                pendingNodes.append(node.firstChild);
+            }
+            else
+            {
+                pendingNodes.append(node.firstChild);
+                pendingNodes.append(node.secondChild);
+            }
+        }
+    }
+
+    return nearestPrimitive;
+}
+
+QList<DrawerPrimitive*> DrawerSpatialIndex::getErasablePrimitivesInside(double bounds[6])
+{
+    update();
+
+    QList<DrawerPrimitive*> primitives;
+
+    foreach (DrawerPrimitive *primitive, m_viewDependentPrimitives)
+    {
+        if (primitive->isErasable())
+        {
+            double primitiveBounds[6];
+            primitive->getBounds(primitiveBounds);
+            double planeBounds[4] = { primitiveBounds[m_xIndex * 2], primitiveBounds[m_xIndex * 2 + 1], primitiveBounds[m_yIndex * 2],
+                                      primitiveBounds[m_yIndex * 2 + 1] };
+            if (isInside(planeBounds, bounds))
+            {
+                primitives << primitive;
+            }
+        }
+    }
+
+    if (m_nodes.isEmpty())
+    {
+        return primitives;
+    }
+
+    QVarLengthArray<int, 64> pendingNodes;
+    pendingNodes.append(0);
+    while (!pendingNodes.isEmpty())
+    {
+        const Node &node = m_nodes.at(pendingNodes.last());
+        pendingNodes.removeLast();
+
+        // Skip the nodes that don't overlap the bounds
+        if (node.bounds[1] < bounds[m_xIndex * 2] || node.bounds[0] > bounds[m_xIndex * 2 + 1] || node.bounds[3] < bounds[m_yIndex * 2]
+            || node.bounds[2] > bounds[m_yIndex * 2 + 1])
+        {
+            continue;
+        }
+
+        if (node.numberOfEntries > 0)
+        {
+            for (int i = node.firstEntry; i < node.firstEntry + node.numberOfEntries; i++)
+            {
+                const Entry &entry = m_entries.at(i);
+                if (entry.primitive->isErasable() && isInside(entry.bounds, bounds))
+                {
+                    primitives << entry.primitive;
+                }
+            }
+        }
+        else
+        {
+            pendingNodes.append(node.firstChild);
+            pendingNodes.append(node.secondChild);
+        }
+    }
+
+    return primitives;
+}
+
+void DrawerSpatialIndex::update()
+{
+    if (!m_isOutdated)
+    {
+        return;
+    }
+
+    m_entries.clear();
+    m_nodes.clear();
+    m_viewDependentPrimitives.clear();
+
+    foreach (DrawerPrimitive *primitive, m_primitives)
+    {
+        if (primitive->hasViewDependentBounds())
+        {
+            m_viewDependentPrimitives.append(primitive);
+        }
+        else
+        {
+            double bounds[6];
+            primitive->getBounds(bounds);
+
+            Entry entry;
+            entry.primitive = primitive;
+            entry.bounds[0] = bounds[m_xIndex * 2];
+            entry.bounds[1] = bounds[m_xIndex * 2 + 1];
+            entry.bounds[2] = bounds[m_yIndex * 2];
+            entry.bounds[3] = bounds[m_yIndex * 2 + 1];
+            m_entries.append(entry);
+        }
+    }
+
+    if (!m_entries.isEmpty())
+    {
+        m_nodes.reserve(2 * m_entries.size() / MaximumEntriesPerLeaf + 1);
+        buildNode(0, m_entries.size());
+    }
+
+    m_isOutdated = false;
+}
+
+int DrawerSpatialIndex::buildNode(int firstEntry, int numberOfEntries)
+{
+    int nodeIndex = m_nodes.size();
+    m_nodes.append(Node());
+
+    Node node;
+    node.bounds[0] = node.bounds[2] = MathTools::DoubleMaximumValue;
+    node.bounds[1] = node.bounds[3] = -MathTools::DoubleMaximumValue;
+    for (int i = firstEntry; i < firstEntry + numberOfEntries; i++)
+    {
+        const Entry &entry = m_entries.at(i);
+        node.bounds[0] = qMin(node.bounds[0], entry.bounds[0]);
+        node.bounds[1] = qMax(node.bounds[1], entry.bounds[1]);
+        node.bounds[2] = qMin(node.bounds[2], entry.bounds[2]);
+        node.bounds[3] = qMax(node.bounds[3], entry.bounds[3]);
+    }
+
+    if (numberOfEntries <= MaximumEntriesPerLeaf)
+    {
+        node.firstEntry = firstEntry;
+        node.numberOfEntries = numberOfEntries;
+        node.firstChild = node.secondChild = -1;
+    }
+    else
+    {
+        // Split by the median of the centers along the longest side of the node
+        int axis = (node.bounds[1] - node.bounds[0] >= node.bounds[3] - node.bounds[2]) ? 0 : 2;
+        int middleEntry = firstEntry + numberOfEntries / 2;
+        Entry *entries = m_entries.data();
+        std::nth_element(entries + firstEntry, entries + middleEntry, entries + firstEntry + numberOfEntries,
+                         [axis](const Entry &first, const Entry &second)
+                         {
+                             return first.bounds[axis] + first.bounds[axis + 1] < second.bounds[axis] + second.bounds[axis + 1];
+                         });
+
+        node.firstEntry = 0;
+        node.numberOfEntries = 0;
+        node.firstChild = buildNode(firstEntry, middleEntry - firstEntry);
+        node.secondChild = buildNode(middleEntry, firstEntry + numberOfEntries - middleEntry);
+    }
+
+    m_nodes[nodeIndex] = node;
+    return nodeIndex;
+}
+
+double DrawerSpatialIndex::getDistance(const double point[3], const double bounds[4]) const
+{
+    double x = point[m_xIndex];
+    double y = point[m_yIndex];
+    double dx = qMax(0.0, qMax(bounds[0] - x, x - bounds[1]));
+    double dy = qMax(0.0, qMax(bounds[2] - y, y - bounds[3]));
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+void DrawerSpatialIndex::testNearest(DrawerPrimitive *primitive, double point[3], DrawerPrimitive *&nearestPrimitive, double closestPoint[3],
+                                     double &minimumDistance) const
+{
+    if (!primitive->isErasable())
+    {
+        return;
+    }
+
+    double localClosestPoint[3];
+    double distance = primitive->getDistanceToPoint(point, localClosestPoint);
+    if (distance <= minimumDistance)
+    {
+        minimumDistance = distance;
+        nearestPrimitive = primitive;
+        closestPoint[0] = localClosestPoint[0];
+        closestPoint[1] = localClosestPoint[1];
+        closestPoint[2] = localClosestPoint[2];
+    }
+}
+
+bool DrawerSpatialIndex::isInside(const double primitiveBounds[4], const double bounds[6]) const
+{
+    return bounds[m_xIndex * 2] <= primitiveBounds[0] && bounds[m_xIndex * 2 + 1] >= primitiveBounds[1] && bounds[m_yIndex * 2] <= primitiveBounds[2]
+        && bounds[m_yIndex * 2 + 1] >= primitiveBounds[3];
+}
+
+} // End namespace udg
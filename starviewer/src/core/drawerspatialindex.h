@@ -0,0 +1,109 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGDRAWERSPATIALINDEX_H
+#define UDGDRAWERSPATIALINDEX_H
+
+#include "orthogonalplane.h"
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+namespace udg {
+
+class DrawerPrimitive;
+
+/**
+    Spatial index of the primitives drawn on a slice of an orthogonal plane, used by Drawer to find primitives near a point or inside some bounds
+    without testing all of them.
+
+    The index is a bounding volume hierarchy of the bounds of the primitives projected on the plane. It is built lazily: inserting, removing
+    or invalidating primitives only marks it as outdated and it is rebuilt on the next query. Primitives whose bounds depend on the camera,
+    such as texts, are not put in the hierarchy and are always tested.
+  */
+class DrawerSpatialIndex {
+public:
+    DrawerSpatialIndex(const OrthogonalPlane &plane);
+    ~DrawerSpatialIndex();
+
+    /// Adds the primitive to the index
+    void insert(DrawerPrimitive *primitive);
+
+    /// Removes the primitive from the index. Returns false if it wasn't in the index.
+    bool remove(DrawerPrimitive *primitive);
+
+    /// Marks the index as outdated because the bounds of some primitive have changed
+    void invalidate();
+
+    /// Returns the number of primitives in the index
+    int getNumberOfPrimitives() const;
+
+    /// Returns the erasable primitive nearest to the given point, or null if there isn't any, with its closest point and its distance
+    DrawerPrimitive* getNearestErasablePrimitive(double point[3], double closestPoint[3], double &distance);
+
+    /// Returns the erasable primitives whose bounds are inside the given ones in the plane
+    QList<DrawerPrimitive*> getErasablePrimitivesInside(double bounds[6]);
+
+private:
+    /// A primitive with its bounds projected on the plane: minimum x, maximum x, minimum y and maximum y
+    struct Entry {
+        DrawerPrimitive *primitive;
+        double bounds[4];
+    };
+
+    /// Node of the hierarchy. Leaves have the entries from firstEntry to firstEntry + numberOfEntries - 1 and inner nodes have two children.
+    struct Node {
+        double bounds[4];
+        int firstEntry;
+        int numberOfEntries;
+        int firstChild;
+        int secondChild;
+    };
+
+    /// Builds the hierarchy if it is outdated
+    void update();
+
+    /// Builds the node of the given entries and returns its index
+    int buildNode(int firstEntry, int numberOfEntries);
+
+    /// Returns the distance in the plane from the point to the given bounds, 0 if it's inside them
+    double getDistance(const double point[3], const double bounds[4]) const;
+
+    /// Tests the given primitive as a candidate of the nearest primitive to the point
+    void testNearest(DrawerPrimitive *primitive, double point[3], DrawerPrimitive *&nearestPrimitive, double closestPoint[3],
+                     double &minimumDistance) const;
+
+    /// Returns true if the given primitive bounds in the plane are inside the given bounds
+    bool isInside(const double primitiveBounds[4], const double bounds[6]) const;
+
+private:
+    /// Indices of the plane axes
+    int m_xIndex;
+    int m_yIndex;
+
+    /// Primitives of the index and their position in the list
+    QVector<DrawerPrimitive*> m_primitives;
+    QHash<DrawerPrimitive*, int> m_positions;
+
+    /// The hierarchy and the primitives left out of it
+    QVector<Entry> m_entries;
+    QVector<Node> m_nodes;
+    QVector<DrawerPrimitive*> m_viewDependentPrimitives;
+    bool m_isOutdated;
+};
+
+} // End namespace udg
+
+#endif
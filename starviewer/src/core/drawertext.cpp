@@ -449,6 +449,11 @@ bool DrawerText::isInside(const double *point3D)
     }
 }
 
+bool DrawerText::hasViewDependentBounds() const
+{
+    return true;
+}
+
 void DrawerText::getBounds(double bounds[6])
 {
     if (m_vtkActor && m_vtkActor->GetNumberOfConsumers() > 0)
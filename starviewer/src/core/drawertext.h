@@ -123,6 +123,9 @@ public:
     /// en aquest ordre: minX, maxX, minY, maxY, minZ, maxZ
     virtual void getBounds(double bounds[6]);
 
+    /// Els límits del text depenen de la càmera perquè la seva mida és fixa en pantalla
+    virtual bool hasViewDependentBounds() const;
+
     /// Assigna/Obté el color del fons de l'objecte
     void setBackgroundColor(QColor color);
     QColor getBackgroundColor() const;
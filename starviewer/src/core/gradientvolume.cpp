@@ -0,0 +1,409 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "gradientvolume.h"
+
+#include "logging.h"
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <vtkDirectionEncoder.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace udg {
+
+namespace {
+
+/// Alignment of the arrays, in bytes (a cache line)
+const int ArrayAlignment = 64;
+
+template <class T>
+void computeCentralDifferencesSlice(const T *data, const int dimensions[3], const double spacing[3], int z, float *gradientX, float *gradientY,
+                                    float *gradientZ)
+{
+    const int xSize = dimensions[0], ySize = dimensions[1], zSize = dimensions[2];
+    const vtkIdType sliceSize = static_cast<vtkIdType>(xSize) * ySize;
+
+    // At the borders the differences are one-sided, and along an axis of a single voxel the component is 0
+    const int zPrevious = qMax(z - 1, 0), zNext = qMin(z + 1, zSize - 1);
+    const float zFactor = zNext > zPrevious ? 1.0f / static_cast<float>((zNext - zPrevious) * spacing[2]) : 0.0f;
+    const float xFactor = 1.0f / static_cast<float>(2.0 * spacing[0]);
+    const float xBorderFactor = 1.0f / static_cast<float>(spacing[0]);
+
+    for (int y = 0; y < ySize; y++)
+    {
+        const int yPrevious = qMax(y - 1, 0), yNext = qMin(y + 1, ySize - 1);
+        const float yFactor = yNext > yPrevious ? 1.0f / static_cast<float>((yNext - yPrevious) * spacing[1]) : 0.0f;
+
+        const T *row = data + z * sliceSize + static_cast<vtkIdType>(y) * xSize;
+        const T *previousRow = data + z * sliceSize + static_cast<vtkIdType>(yPrevious) * xSize;
+        const T *nextRow = data + z * sliceSize + static_cast<vtkIdType>(yNext) * xSize;
+        const T *previousSliceRow = data + zPrevious * sliceSize + static_cast<vtkIdType>(y) * xSize;
+        const T *nextSliceRow = data + zNext * sliceSize + static_cast<vtkIdType>(y) * xSize;
+        float *rowGradientX = gradientX + y * xSize;
+        float *rowGradientY = gradientY + y * xSize;
+        float *rowGradientZ = gradientZ + y * xSize;
+
+        for (int x = 0; x < xSize; x++)
+        {
+            rowGradientY[x] = (static_cast<float>(nextRow[x]) - static_cast<float>(previousRow[x])) * yFactor;
+            rowGradientZ[x] = (static_cast<float>(nextSliceRow[x]) - static_cast<float>(previousSliceRow[x])) * zFactor;
+        }
+
+        if (xSize > 1)
+        {
+            for (int x = 1; x < xSize - 1; x++)
+            {
+                rowGradientX[x] = (static_cast<float>(row[x + 1]) - static_cast<float>(row[x - 1])) * xFactor;
+            }
+            rowGradientX[0] = (static_cast<float>(row[1]) - static_cast<float>(row[0])) * xBorderFactor;
+            rowGradientX[xSize - 1] = (static_cast<float>(row[xSize - 1]) - static_cast<float>(row[xSize - 2])) * xBorderFactor;
+        }
+        else
+        {
+            rowGradientX[0] = 0.0f;
+        }
+    }
+}
+
+template <class T>
+void computeLinearRegressionSlice(const T *data, const int dimensions[3], const double spacing[3], int radius, int z, float *gradientX,
+                                  float *gradientY, float *gradientZ)
+{
+    const int xSize = dimensions[0], ySize = dimensions[1], zSize = dimensions[2];
+    const vtkIdType sliceSize = static_cast<vtkIdType>(xSize) * ySize;
+    const int diameter = 2 * radius + 1;
+
+    // Each neighbour is weighted by the inverse of its distance, and the result is divided by twice the spacing
+    QVector<float> weights(diameter * diameter * diameter);
+    for (int iz = -radius, i = 0; iz <= radius; iz++)
+    {
+        for (int iy = -radius; iy <= radius; iy++)
+        {
+            for (int ix = -radius; ix <= radius; ix++, i++)
+            {
+                int squaredDistance = ix * ix + iy * iy + iz * iz;
+                weights[i] = squaredDistance > 0 ? 1.0f / std::sqrt(static_cast<float>(squaredDistance)) : 0.0f;
+            }
+        }
+    }
+    const float xFactor = 1.0f / static_cast<float>(2.0 * spacing[0]);
+    const float yFactor = 1.0f / static_cast<float>(2.0 * spacing[1]);
+    const float zFactor = 1.0f / static_cast<float>(2.0 * spacing[2]);
+
+    std::fill(gradientX, gradientX + sliceSize, 0.0f);
+    std::fill(gradientY, gradientY + sliceSize, 0.0f);
+    std::fill(gradientZ, gradientZ + sliceSize, 0.0f);
+
+    // The neighbourhood is accumulated one shifted row at a time, so that the innermost loop runs over contiguous values without branches.
+    // Neighbours outside the volume count as 0, so they are simply skipped.
+    for (int iz = -radius; iz <= radius; iz++)
+    {
+        const int neighbourZ = z + iz;
+        if (neighbourZ < 0 || neighbourZ >= zSize)
+        {
+            continue;
+        }
+
+        for (int y = 0; y < ySize; y++)
+        {
+            float *rowGradientX = gradientX + y * xSize;
+            float *rowGradientY = gradientY + y * xSize;
+            float *rowGradientZ = gradientZ + y * xSize;
+
+            for (int iy = -radius; iy <= radius; iy++)
+            {
+                const int neighbourY = y + iy;
+                if (neighbourY < 0 || neighbourY >= ySize)
+                {
+                    continue;
+                }
+
+                const T *neighbourRow = data + neighbourZ * sliceSize + static_cast<vtkIdType>(neighbourY) * xSize;
+                const float *neighbourWeights = weights.constData() + ((iz + radius) * diameter + iy + radius) * diameter + radius;
+
+                for (int ix = -radius; ix <= radius; ix++)
+                {
+                    const float weight = neighbourWeights[ix];
+                    if (weight == 0.0f)
+                    {
+                        continue;
+                    }
+
+                    const float weightX = weight * ix * xFactor;
+                    const float weightY = weight * iy * yFactor;
+                    const float weightZ = weight * iz * zFactor;
+                    const int xBegin = qMax(0, -ix), xEnd = qMin(xSize, xSize - ix);
+                    const T *shiftedRow = neighbourRow + ix;
+
+                    for (int x = xBegin; x < xEnd; x++)
+                    {
+                        const float value = static_cast<float>(shiftedRow[x]);
+                        rowGradientX[x] += weightX * value;
+                        rowGradientY[x] += weightY * value;
+                        rowGradientZ[x] += weightZ * value;
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <class T>
+void computeSliceGradient(const T *data, const int dimensions[3], const double spacing[3], GradientVolume::Method method, int radius, int z,
+                          float *gradientX, float *gradientY, float *gradientZ)
+{
+    switch (method)
+    {
+        case GradientVolume::CentralDifferences:
+            computeCentralDifferencesSlice(data, dimensions, spacing, z, gradientX, gradientY, gradientZ);
+            break;
+        case GradientVolume::LinearRegression4D:
+            computeLinearRegressionSlice(data, dimensions, spacing, qMax(1, radius), z, gradientX, gradientY, gradientZ);
+            break;
+    }
+}
+
+/// Computes the magnitudes of count gradients and returns the highest one
+float computeMagnitudes(const float *gradientX, const float *gradientY, const float *gradientZ, int count, float *magnitudes)
+{
+    for (int i = 0; i < count; i++)
+    {
+        magnitudes[i] = std::sqrt(gradientX[i] * gradientX[i] + gradientY[i] * gradientY[i] + gradientZ[i] * gradientZ[i]);
+    }
+
+    float maximum = 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+        maximum = qMax(maximum, magnitudes[i]);
+    }
+
+    return maximum;
+}
+
+}
+
+GradientVolume::GradientVolume()
+ : m_numberOfVoxels(0), m_buffer(0), m_gradientX(0), m_gradientY(0), m_gradientZ(0), m_magnitudes(0), m_maximumMagnitude(0.0f)
+{
+    m_dimensions[0] = m_dimensions[1] = m_dimensions[2] = 0;
+}
+
+GradientVolume::~GradientVolume()
+{
+    clear();
+}
+
+void GradientVolume::compute(vtkImageData *imageData, Method method, int radius)
+{
+    clear();
+
+    if (!imageData || !imageData->GetPointData()->GetScalars() || imageData->GetNumberOfPoints() == 0)
+    {
+        return;
+    }
+
+    if (imageData->GetNumberOfScalarComponents() != 1)
+    {
+        DEBUG_LOG(QString("Can't compute the gradient of an image with %1 components").arg(imageData->GetNumberOfScalarComponents()));
+        WARN_LOG(QString("Can't compute the gradient of an image with %1 components").arg(imageData->GetNumberOfScalarComponents()));
+        return;
+    }
+
+    int dimensions[3];
+    imageData->GetDimensions(dimensions);
+    compute(imageData->GetScalarPointer(), imageData->GetScalarType(), dimensions, imageData->GetSpacing(), method, radius);
+}
+
+void GradientVolume::compute(const float *data, const int dimensions[3], const double spacing[3], Method method, int radius)
+{
+    clear();
+
+    if (!data)
+    {
+        return;
+    }
+
+    compute(data, VTK_FLOAT, dimensions, spacing, method, radius);
+}
+
+bool GradientVolume::isEmpty() const
+{
+    return m_numberOfVoxels == 0;
+}
+
+void GradientVolume::getDimensions(int dimensions[3]) const
+{
+    dimensions[0] = m_dimensions[0];
+    dimensions[1] = m_dimensions[1];
+    dimensions[2] = m_dimensions[2];
+}
+
+int GradientVolume::getNumberOfVoxels() const
+{
+    return m_numberOfVoxels;
+}
+
+const float* GradientVolume::getGradientX() const
+{
+    return m_gradientX;
+}
+
+const float* GradientVolume::getGradientY() const
+{
+    return m_gradientY;
+}
+
+const float* GradientVolume::getGradientZ() const
+{
+    return m_gradientZ;
+}
+
+const float* GradientVolume::getMagnitudes() const
+{
+    return m_magnitudes;
+}
+
+Vector3 GradientVolume::getGradient(int offset) const
+{
+    return Vector3(m_gradientX[offset], m_gradientY[offset], m_gradientZ[offset]);
+}
+
+float GradientVolume::getMagnitude(int offset) const
+{
+    return m_magnitudes[offset];
+}
+
+float GradientVolume::getMaximumMagnitude() const
+{
+    return m_maximumMagnitude;
+}
+
+void GradientVolume::computeSlice(const void *data, int scalarType, const int dimensions[3], const double spacing[3], Method method, int radius, int z,
+                                  float *gradientX, float *gradientY, float *gradientZ)
+{
+    switch (scalarType)
+    {
+        vtkTemplateMacro(computeSliceGradient(static_cast<const VTK_TT*>(data), dimensions, spacing, method, radius, z, gradientX, gradientY, gradientZ));
+        default:
+            DEBUG_LOG(QString("Can't compute the gradient of scalars of type %1").arg(scalarType));
+            WARN_LOG(QString("Can't compute the gradient of scalars of type %1").arg(scalarType));
+    }
+}
+
+void GradientVolume::encode(const float *gradientX, const float *gradientY, const float *gradientZ, int count, vtkDirectionEncoder *directionEncoder,
+                            float zeroNormalThreshold, unsigned short *encodedNormals, float scale, float bias, unsigned char *gradientMagnitudes)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float normal[3] = { gradientX[i], gradientY[i], gradientZ[i] };
+        float magnitude = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+        if (gradientMagnitudes)
+        {
+            float value = (magnitude + bias) * scale;
+            gradientMagnitudes[i] = value < 0.0f ? 0 : value > 255.0f ? 255 : static_cast<unsigned char>(value);
+        }
+
+        if (magnitude > zeroNormalThreshold)
+        {
+            normal[0] /= magnitude;
+            normal[1] /= magnitude;
+            normal[2] /= magnitude;
+        }
+        else
+        {
+            normal[0] = normal[1] = normal[2] = 0.0f;
+        }
+
+        encodedNormals[i] = directionEncoder->GetEncodedDirection(normal);
+    }
+}
+
+void GradientVolume::compute(const void *data, int scalarType, const int dimensions[3], const double spacing[3], Method method, int radius)
+{
+    if (dimensions[0] <= 0 || dimensions[1] <= 0 || dimensions[2] <= 0)
+    {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int sliceSize = dimensions[0] * dimensions[1];
+    const int numberOfVoxels = sliceSize * dimensions[2];
+
+    // Each array is padded to a whole number of cache lines so that all of them start aligned
+    const size_t floatsPerLine = ArrayAlignment / sizeof(float);
+    const size_t paddedSize = (numberOfVoxels + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+    m_buffer = static_cast<float*>(qMallocAligned(4 * paddedSize * sizeof(float), ArrayAlignment));
+    if (!m_buffer)
+    {
+        DEBUG_LOG(QString("Not enough memory for the gradient of %1 voxels").arg(numberOfVoxels));
+        ERROR_LOG(QString("Not enough memory for the gradient of %1 voxels").arg(numberOfVoxels));
+        return;
+    }
+
+    m_gradientX = m_buffer;
+    m_gradientY = m_gradientX + paddedSize;
+    m_gradientZ = m_gradientY + paddedSize;
+    m_magnitudes = m_gradientZ + paddedSize;
+    m_dimensions[0] = dimensions[0];
+    m_dimensions[1] = dimensions[1];
+    m_dimensions[2] = dimensions[2];
+    m_numberOfVoxels = numberOfVoxels;
+
+    QVector<int> slices(dimensions[2]);
+    QVector<float> sliceMaximumMagnitudes(dimensions[2]);
+    for (int z = 0; z < slices.size(); z++)
+    {
+        slices[z] = z;
+    }
+
+    QtConcurrent::blockingMap(slices, [&](int z)
+    {
+        int sliceOffset = z * sliceSize;
+        computeSlice(data, scalarType, dimensions, spacing, method, radius, z, m_gradientX + sliceOffset, m_gradientY + sliceOffset,
+                     m_gradientZ + sliceOffset);
+        sliceMaximumMagnitudes[z] = computeMagnitudes(m_gradientX + sliceOffset, m_gradientY + sliceOffset, m_gradientZ + sliceOffset, sliceSize,
+                                                      m_magnitudes + sliceOffset);
+    });
+
+    m_maximumMagnitude = 0.0f;
+    foreach (float maximum, sliceMaximumMagnitudes)
+    {
+        m_maximumMagnitude = qMax(m_maximumMagnitude, maximum);
+    }
+
+    DEBUG_LOG(QString("Gradient of %1 slices computed in %2 ms").arg(dimensions[2]).arg(timer.elapsed()));
+}
+
+void GradientVolume::clear()
+{
+    qFreeAligned(m_buffer);
+    m_buffer = 0;
+    m_gradientX = m_gradientY = m_gradientZ = m_magnitudes = 0;
+    m_dimensions[0] = m_dimensions[1] = m_dimensions[2] = 0;
+    m_numberOfVoxels = 0;
+    m_maximumMagnitude = 0.0f;
+}
+
+} // End namespace udg
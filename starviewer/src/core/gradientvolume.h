@@ -0,0 +1,119 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGGRADIENTVOLUME_H
+#define UDGGRADIENTVOLUME_H
+
+#include "vector3.h"
+
+class vtkDirectionEncoder;
+class vtkImageData;
+
+namespace udg {
+
+/**
+    Gradient of a volume, precomputed for every voxel and kept as separate, cache-aligned float arrays for the x, y and z components and the magnitude.
+
+    The gradient can be estimated with central differences or with 4D linear regression over a cubic neighbourhood of the given radius, where the voxels
+    outside the volume count as 0. Slices are computed in parallel, and the loops over each row have no branches so that the compiler vectorizes them.
+
+    The slice computation and the encoding into the normals and 8-bit magnitudes used by the VTK ray casting are also available on their own, so that
+    gradient estimators can stream them slice by slice without keeping the whole float volume.
+  */
+class GradientVolume {
+public:
+    /// Gradient estimation methods
+    enum Method { CentralDifferences, LinearRegression4D };
+
+    GradientVolume();
+    ~GradientVolume();
+
+    /// Computes the gradient of the scalars of the given image data, which must have a single component, replacing the previous one
+    void compute(vtkImageData *imageData, Method method = CentralDifferences, int radius = 1);
+    /// Computes the gradient of the given values, stored with x varying fastest, replacing the previous one
+    void compute(const float *data, const int dimensions[3], const double spacing[3], Method method = CentralDifferences, int radius = 1);
+
+    /// Returns true if no gradient has been computed
+    bool isEmpty() const;
+
+    /// Returns the dimensions of the volume and its number of voxels
+    void getDimensions(int dimensions[3]) const;
+    int getNumberOfVoxels() const;
+
+    /// Returns the components and the magnitude of the gradient of all the voxels
+    const float* getGradientX() const;
+    const float* getGradientY() const;
+    const float* getGradientZ() const;
+    const float* getMagnitudes() const;
+
+    /// Returns the gradient and its magnitude at the given voxel
+    Vector3 getGradient(int offset) const;
+    float getMagnitude(int offset) const;
+    /// Returns the unit vector opposite to the gradient at the given voxel, which points towards lower values like the normals of the VTK gradient
+    /// estimators, or the zero vector where the gradient is zero
+    Vector3 getNormal(int offset) const;
+
+    /// Returns the highest gradient magnitude of the volume
+    float getMaximumMagnitude() const;
+
+    /// Computes the gradient of slice z of the given scalars (one component, x varying fastest) into the given arrays, which must have room for a slice
+    static void computeSlice(const void *data, int scalarType, const int dimensions[3], const double spacing[3], Method method, int radius, int z,
+                             float *gradientX, float *gradientY, float *gradientZ);
+
+    /// Encodes count gradients into normal indices of the direction encoder, zero when the magnitude is at or below zeroNormalThreshold, and, if
+    /// gradientMagnitudes is not null, into 8-bit magnitudes as (magnitude + bias) * scale clamped to [0, 255]
+    static void encode(const float *gradientX, const float *gradientY, const float *gradientZ, int count, vtkDirectionEncoder *directionEncoder,
+                       float zeroNormalThreshold, unsigned short *encodedNormals, float scale, float bias, unsigned char *gradientMagnitudes);
+
+private:
+    /// Computes the gradient of the given scalars in parallel
+    void compute(const void *data, int scalarType, const int dimensions[3], const double spacing[3], Method method, int radius);
+
+    /// Frees the arrays
+    void clear();
+
+    // Not implemented
+    GradientVolume(const GradientVolume &);
+    // Not implemented
+    void operator =(const GradientVolume &);
+
+private:
+    int m_dimensions[3];
+    int m_numberOfVoxels;
+
+    /// Single cache-aligned allocation holding the four arrays, each one starting on its own cache line
+    float *m_buffer;
+    float *m_gradientX;
+    float *m_gradientY;
+    float *m_gradientZ;
+    float *m_magnitudes;
+
+    float m_maximumMagnitude;
+};
+
+inline Vector3 GradientVolume::getNormal(int offset) const
+{
+    float magnitude = m_magnitudes[offset];
+    if (magnitude == 0.0f)
+    {
+        return Vector3();
+    }
+
+    return Vector3(-m_gradientX[offset] / magnitude, -m_gradientY[offset] / magnitude, -m_gradientZ[offset] / magnitude);
+}
+
+} // End namespace udg
+
+#endif
@@ -15,10 +15,12 @@
 #include "imagepipeline.h"
 
 #include "phasefilter.h"
+#include "renderingprofiler.h"
 #include "voilut.h"
 #include "vtkRunThroughFilter.h"
 #include "windowlevelfilter.h"
 
+#include <vtkAlgorithmOutput.h>
 #include <vtkImageData.h>
 
 namespace udg {
@@ -100,6 +102,12 @@ void ImagePipeline::clearTransferFunction()
     m_hasTransferFunction = false;
 }
 
+void ImagePipeline::addToRenderingProfiler(RenderingProfiler *profiler)
+{
+    profiler->addStageObject(RenderingProfiler::PhaseExtraction, m_phaseFilter->getOutput().getVtkAlgorithmOutput()->GetProducer());
+    profiler->addStageObject(RenderingProfiler::WindowLevel, m_windowLevelLUTFilter->getOutput().getVtkAlgorithmOutput()->GetProducer());
+}
+
 vtkAlgorithm* ImagePipeline::getVtkAlgorithm() const
 {
     return m_outputFilter;
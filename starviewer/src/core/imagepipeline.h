@@ -23,6 +23,7 @@ class vtkRunThroughFilter;
 namespace udg {
 
 class PhaseFilter;
+class RenderingProfiler;
 class TransferFunction;
 class VoiLut;
 class WindowLevelFilter;
@@ -57,6 +58,9 @@ public:
     /// Clears the transfer function.
     void clearTransferFunction();
 
+    /// Adds the phase and window level filters to the corresponding stages of the given profiler.
+    void addToRenderingProfiler(RenderingProfiler *profiler);
+
 private:
     /// Returns the vtkAlgorithm used to implement the filter.
     virtual vtkAlgorithm* getVtkAlgorithm() const;
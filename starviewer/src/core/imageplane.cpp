@@ -211,7 +211,11 @@ QString ImagePlane::toString(bool verbose) const
 
 bool ImagePlane::getIntersections(const ImagePlane *plane, Vector3 &intersectionPoint1, Vector3 &intersectionPoint2, CornersLocation cornersLocation) const
 {
-    Corners corners = this->getCorners(cornersLocation);
+    return getIntersections(this->getCorners(cornersLocation), plane, intersectionPoint1, intersectionPoint2);
+}
+
+bool ImagePlane::getIntersections(const Corners &corners, const ImagePlane *plane, Vector3 &intersectionPoint1, Vector3 &intersectionPoint2)
+{
     std::array<double, 3> topLeft = corners.topLeft, topRight = corners.topRight, bottomRight = corners.bottomRight, bottomLeft = corners.bottomLeft;
     std::array<double, 3> otherNormal = Vector3(plane->getImageOrientation().getNormalVector());
     std::array<double, 3> otherOrigin = plane->getOrigin();
@@ -109,6 +109,10 @@ public:
     /// \return True if there are intersections, and false otherwise.
     bool getIntersections(const ImagePlane *plane, Vector3 &intersectionPoint1, Vector3 &intersectionPoint2, CornersLocation cornersLocation = Upper) const;
 
+    /// Computes the intersection between the plane defined by the given corners and \a plane, like the method above.
+    /// Useful to intersect the same corners with several planes without computing them each time.
+    static bool getIntersections(const Corners &corners, const ImagePlane *plane, Vector3 &intersectionPoint1, Vector3 &intersectionPoint2);
+
     /// Returns the distance from the given point to this ImagePlane.
     double getDistanceToPoint(const Vector3 &point) const;
     
@@ -0,0 +1,461 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "isosurfaceextractor.h"
+
+#include "logging.h"
+
+#include <QFutureWatcher>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+#include <vtkAppendPolyData.h>
+#include <vtkCleanPolyData.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkImageMarchingCubes.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkQuadricDecimation.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace udg {
+
+const int IsosurfaceExtractor::BlockSize = 32;
+const int IsosurfaceExtractor::MaximumCachedIsosurfaces = 8;
+const int IsosurfaceExtractor::DecimationThreshold = 1000000;
+
+namespace {
+
+/// Number of points processed by each task when computing normals
+const int NormalsChunkSize = 65536;
+
+/// Computes the minimum and maximum values of the first component of the image inside the given extent
+template <class T>
+void computeRange(const T *scalars, const int imageExtent[6], const vtkIdType increments[3], const int extent[6], double &minimum, double &maximum)
+{
+    const T *first = scalars + (extent[0] - imageExtent[0]) * increments[0] + (extent[2] - imageExtent[2]) * increments[1]
+                             + (extent[4] - imageExtent[4]) * increments[2];
+    T minimumValue = *first;
+    T maximumValue = *first;
+
+    for (int z = extent[4]; z <= extent[5]; z++)
+    {
+        for (int y = extent[2]; y <= extent[3]; y++)
+        {
+            const T *voxel = first + (y - extent[2]) * increments[1] + (z - extent[4]) * increments[2];
+
+            for (int x = extent[0]; x <= extent[1]; x++, voxel += increments[0])
+            {
+                minimumValue = std::min(minimumValue, *voxel);
+                maximumValue = std::max(maximumValue, *voxel);
+            }
+        }
+    }
+
+    minimum = minimumValue;
+    maximum = maximumValue;
+}
+
+/// Computes the normals of the given points as the opposite of the gradient of the first component of the image, trilinearly interpolated
+template <class T>
+void computeGradientNormals(const T *scalars, vtkImageData *image, vtkPoints *points, float *normals)
+{
+    int extent[6];
+    image->GetExtent(extent);
+    double origin[3];
+    image->GetOrigin(origin);
+    double spacing[3];
+    image->GetSpacing(spacing);
+    vtkIdType increments[3];
+    image->GetIncrements(increments);
+    int dimensions[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+
+    auto voxelGradient = [&](const int index[3], double gradient[3])
+    {
+        const T *voxel = scalars + index[0] * increments[0] + index[1] * increments[1] + index[2] * increments[2];
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            int lower = std::max(index[axis] - 1, 0);
+            int upper = std::min(index[axis] + 1, dimensions[axis] - 1);
+
+            if (lower == upper)
+            {
+                gradient[axis] = 0.0;
+            }
+            else
+            {
+                double lowerValue = voxel[(lower - index[axis]) * increments[axis]];
+                double upperValue = voxel[(upper - index[axis]) * increments[axis]];
+                gradient[axis] = (upperValue - lowerValue) / ((upper - lower) * spacing[axis]);
+            }
+        }
+    };
+
+    vtkIdType numberOfPoints = points->GetNumberOfPoints();
+    QVector<vtkIdType> chunkStarts;
+
+    for (vtkIdType start = 0; start < numberOfPoints; start += NormalsChunkSize)
+    {
+        chunkStarts.append(start);
+    }
+
+    QtConcurrent::blockingMap(chunkStarts, [&](vtkIdType start)
+    {
+        vtkIdType end = std::min(start + NormalsChunkSize, numberOfPoints);
+
+        for (vtkIdType pointId = start; pointId < end; pointId++)
+        {
+            double point[3];
+            points->GetPoint(pointId, point);
+
+            int baseIndex[3];
+            double weights[3];
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                double continuousIndex = (point[axis] - origin[axis]) / spacing[axis] - extent[2 * axis];
+                int maximumBaseIndex = std::max(dimensions[axis] - 2, 0);
+                baseIndex[axis] = std::min(std::max(static_cast<int>(std::floor(continuousIndex)), 0), maximumBaseIndex);
+                weights[axis] = std::min(std::max(continuousIndex - baseIndex[axis], 0.0), 1.0);
+            }
+
+            double gradient[3] = { 0.0, 0.0, 0.0 };
+
+            for (int corner = 0; corner < 8; corner++)
+            {
+                int index[3];
+                double weight = 1.0;
+
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    int offset = (corner >> axis) & 1;
+                    index[axis] = std::min(baseIndex[axis] + offset, dimensions[axis] - 1);
+                    weight *= offset ? weights[axis] : 1.0 - weights[axis];
+                }
+
+                if (weight > 0.0)
+                {
+                    double cornerGradient[3];
+                    voxelGradient(index, cornerGradient);
+
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        gradient[axis] += weight * cornerGradient[axis];
+                    }
+                }
+            }
+
+            double length = std::sqrt(gradient[0] * gradient[0] + gradient[1] * gradient[1] + gradient[2] * gradient[2]);
+            float *normal = normals + 3 * pointId;
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                normal[axis] = length > 0.0 ? -gradient[axis] / length : 0.0f;
+            }
+        }
+    });
+}
+
+/// Assigns normals computed from the gradient of the image to the points of the given isosurface
+void computeNormals(vtkPolyData *isosurface, vtkImageData *image)
+{
+    vtkSmartPointer<vtkFloatArray> normals = vtkSmartPointer<vtkFloatArray>::New();
+    normals->SetName("Normals");
+    normals->SetNumberOfComponents(3);
+    normals->SetNumberOfTuples(isosurface->GetNumberOfPoints());
+
+    if (isosurface->GetNumberOfPoints() > 0)
+    {
+        switch (image->GetScalarType())
+        {
+            vtkTemplateMacro(computeGradientNormals(static_cast<const VTK_TT*>(image->GetScalarPointer()), image, isosurface->GetPoints(),
+                                                    normals->GetPointer(0)));
+        }
+    }
+
+    isosurface->GetPointData()->SetNormals(normals);
+}
+
+/// Runs marching cubes on a copy of the given extent of the image
+vtkSmartPointer<vtkPolyData> extractBlock(vtkImageData *image, const int extent[6], double isoValue)
+{
+    vtkSmartPointer<vtkImageData> blockImage = vtkSmartPointer<vtkImageData>::New();
+    blockImage->SetExtent(const_cast<int*>(extent));
+    blockImage->SetOrigin(image->GetOrigin());
+    blockImage->SetSpacing(image->GetSpacing());
+    blockImage->AllocateScalars(image->GetScalarType(), image->GetNumberOfScalarComponents());
+
+    // Each thread works on its own copy so that the pipeline of the input image is not touched from several threads
+    size_t rowSize = (extent[1] - extent[0] + 1) * image->GetNumberOfScalarComponents() * image->GetScalarSize();
+
+    for (int z = extent[4]; z <= extent[5]; z++)
+    {
+        for (int y = extent[2]; y <= extent[3]; y++)
+        {
+            memcpy(blockImage->GetScalarPointer(extent[0], y, z), image->GetScalarPointer(extent[0], y, z), rowSize);
+        }
+    }
+
+    vtkNew<vtkImageMarchingCubes> marchingCubes;
+    marchingCubes->SetInputData(blockImage);
+    marchingCubes->SetValue(0, isoValue);
+    marchingCubes->ComputeScalarsOff();
+    marchingCubes->ComputeGradientsOff();
+    marchingCubes->ComputeNormalsOff();
+    marchingCubes->Update();
+
+    vtkSmartPointer<vtkPolyData> output = marchingCubes->GetOutput();
+    return output;
+}
+
+/// Returns a decimated version of the given isosurface with at most IsosurfaceExtractor::DecimationThreshold triangles
+vtkSmartPointer<vtkPolyData> decimate(vtkSmartPointer<vtkPolyData> isosurface, vtkSmartPointer<vtkImageData> image)
+{
+    // Blocks are extracted independently, so points on the faces between blocks must be merged before decimating
+    vtkNew<vtkCleanPolyData> clean;
+    clean->SetInputData(isosurface);
+    clean->PointMergingOn();
+    clean->SetTolerance(0.0);
+
+    vtkNew<vtkQuadricDecimation> decimation;
+    decimation->SetInputConnection(clean->GetOutputPort());
+    decimation->SetTargetReduction(1.0 - static_cast<double>(IsosurfaceExtractor::DecimationThreshold) / isosurface->GetNumberOfPolys());
+    decimation->Update();
+
+    vtkSmartPointer<vtkPolyData> output = decimation->GetOutput();
+    computeNormals(output, image);
+    return output;
+}
+
+} // End namespace
+
+IsosurfaceExtractor::IsosurfaceExtractor(QObject *parent)
+ : QObject(parent), m_hasBlockIndex(false)
+{
+}
+
+IsosurfaceExtractor::~IsosurfaceExtractor()
+{
+}
+
+void IsosurfaceExtractor::setInput(vtkImageData *input)
+{
+    m_input = input;
+    m_cache.clear();
+    m_cacheUsage.clear();
+    m_blocks.clear();
+    m_hasBlockIndex = false;
+}
+
+vtkPolyData* IsosurfaceExtractor::getIsosurface(double isoValue)
+{
+    if (!m_input)
+    {
+        return nullptr;
+    }
+
+    if (m_cache.contains(isoValue))
+    {
+        m_cacheUsage.removeOne(isoValue);
+        m_cacheUsage.append(isoValue);
+        return m_cache.value(isoValue);
+    }
+
+    buildBlockIndex();
+    vtkSmartPointer<vtkPolyData> isosurface = extractIsosurface(isoValue);
+    insertInCache(isoValue, isosurface);
+
+    if (isosurface->GetNumberOfPolys() > DecimationThreshold)
+    {
+        decimateInBackground(isoValue, isosurface);
+    }
+
+    return isosurface;
+}
+
+int IsosurfaceExtractor::getNumberOfActiveBlocks(double isoValue)
+{
+    buildBlockIndex();
+    return getActiveBlocks(isoValue).size();
+}
+
+void IsosurfaceExtractor::buildBlockIndex()
+{
+    if (m_hasBlockIndex)
+    {
+        return;
+    }
+
+    m_hasBlockIndex = true;
+    m_blocks.clear();
+
+    if (!m_input)
+    {
+        return;
+    }
+
+    int extent[6];
+    m_input->GetExtent(extent);
+
+    // Marching cubes needs at least one cell in each dimension
+    if (extent[1] <= extent[0] || extent[3] <= extent[2] || extent[5] <= extent[4])
+    {
+        return;
+    }
+
+    // Consecutive blocks share the voxels of their common face, so that each cell belongs to exactly one block
+    for (int z = extent[4]; z < extent[5]; z += BlockSize)
+    {
+        for (int y = extent[2]; y < extent[3]; y += BlockSize)
+        {
+            for (int x = extent[0]; x < extent[1]; x += BlockSize)
+            {
+                Block block;
+                block.extent[0] = x;
+                block.extent[1] = std::min(x + BlockSize, extent[1]);
+                block.extent[2] = y;
+                block.extent[3] = std::min(y + BlockSize, extent[3]);
+                block.extent[4] = z;
+                block.extent[5] = std::min(z + BlockSize, extent[5]);
+                m_blocks.append(block);
+            }
+        }
+    }
+
+    void *scalars = m_input->GetScalarPointer();
+    int scalarType = m_input->GetScalarType();
+    vtkIdType increments[3];
+    m_input->GetIncrements(increments);
+
+    QtConcurrent::blockingMap(m_blocks, [&](Block &block)
+    {
+        switch (scalarType)
+        {
+            vtkTemplateMacro(computeRange(static_cast<const VTK_TT*>(scalars), extent, increments, block.extent, block.minimum, block.maximum));
+        }
+    });
+
+    std::sort(m_blocks.begin(), m_blocks.end(), [](const Block &block1, const Block &block2)
+    {
+        return block1.minimum < block2.minimum;
+    });
+}
+
+QVector<IsosurfaceExtractor::Block> IsosurfaceExtractor::getActiveBlocks(double isoValue) const
+{
+    // Blocks after the first one whose minimum is greater than the iso value can't contain the isosurface
+    auto end = std::upper_bound(m_blocks.constBegin(), m_blocks.constEnd(), isoValue, [](double value, const Block &block)
+    {
+        return value < block.minimum;
+    });
+
+    QVector<Block> activeBlocks;
+
+    for (auto it = m_blocks.constBegin(); it != end; ++it)
+    {
+        if (it->maximum >= isoValue && it->maximum > it->minimum)
+        {
+            activeBlocks.append(*it);
+        }
+    }
+
+    return activeBlocks;
+}
+
+vtkSmartPointer<vtkPolyData> IsosurfaceExtractor::extractIsosurface(double isoValue) const
+{
+    vtkImageData *input = m_input;
+    QVector<Block> activeBlocks = getActiveBlocks(isoValue);
+    std::function<vtkSmartPointer<vtkPolyData>(const Block&)> extractActiveBlock = [input, isoValue](const Block &block)
+    {
+        return extractBlock(input, block.extent, isoValue);
+    };
+    QList<vtkSmartPointer<vtkPolyData> > blockIsosurfaces =
+        QtConcurrent::blockingMapped<QList<vtkSmartPointer<vtkPolyData> > >(activeBlocks, extractActiveBlock);
+
+    vtkNew<vtkAppendPolyData> append;
+    int numberOfInputs = 0;
+
+    foreach (const vtkSmartPointer<vtkPolyData> &blockIsosurface, blockIsosurfaces)
+    {
+        if (blockIsosurface->GetNumberOfPolys() > 0)
+        {
+            append->AddInputData(blockIsosurface);
+            numberOfInputs++;
+        }
+    }
+
+    vtkSmartPointer<vtkPolyData> isosurface;
+
+    if (numberOfInputs > 0)
+    {
+        append->Update();
+        isosurface = append->GetOutput();
+    }
+    else
+    {
+        isosurface = vtkSmartPointer<vtkPolyData>::New();
+    }
+
+    computeNormals(isosurface, m_input);
+
+    DEBUG_LOG(QString("Isosurface %1 extracted from %2 of %3 blocks: %4 triangles").arg(isoValue).arg(blockIsosurfaces.size()).arg(m_blocks.size())
+              .arg(isosurface->GetNumberOfPolys()));
+
+    return isosurface;
+}
+
+void IsosurfaceExtractor::insertInCache(double isoValue, vtkSmartPointer<vtkPolyData> isosurface)
+{
+    while (m_cacheUsage.size() >= MaximumCachedIsosurfaces)
+    {
+        m_cache.remove(m_cacheUsage.takeFirst());
+    }
+
+    m_cache.insert(isoValue, isosurface);
+    m_cacheUsage.append(isoValue);
+}
+
+void IsosurfaceExtractor::decimateInBackground(double isoValue, vtkSmartPointer<vtkPolyData> isosurface)
+{
+    // The background thread works on a shallow copy so that the pipeline information of the isosurface being rendered isn't modified
+    vtkSmartPointer<vtkPolyData> isosurfaceCopy = vtkSmartPointer<vtkPolyData>::New();
+    isosurfaceCopy->ShallowCopy(isosurface);
+    vtkSmartPointer<vtkImageData> input = m_input;
+
+    QFutureWatcher<vtkSmartPointer<vtkPolyData> > *watcher = new QFutureWatcher<vtkSmartPointer<vtkPolyData> >(this);
+
+    connect(watcher, &QFutureWatcher<vtkSmartPointer<vtkPolyData> >::finished, [this, watcher, isoValue, isosurface]()
+    {
+        // The original isosurface may have been removed from the cache or the input may have changed during the decimation
+        if (m_cache.value(isoValue) == isosurface)
+        {
+            m_cache.insert(isoValue, watcher->result());
+            emit isosurfaceDecimated(isoValue);
+        }
+
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(QtConcurrent::run(decimate, isosurfaceCopy, input));
+}
+
+} // End namespace udg
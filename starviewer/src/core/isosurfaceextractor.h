@@ -0,0 +1,110 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGISOSURFACEEXTRACTOR_H
+#define UDGISOSURFACEEXTRACTOR_H
+
+#include <QObject>
+
+#include <QList>
+#include <QMap>
+#include <QVector>
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+class vtkPolyData;
+
+namespace udg {
+
+/**
+    Extracts isosurfaces of a vtkImageData with marching cubes, visiting only the parts of the image that can contain the surface.
+
+    The first time an isosurface is needed, the image is divided in blocks of BlockSize cells and the minimum and maximum values of each block
+    are computed, so that setting an input that is never used for isosurfaces costs nothing.
+    Blocks are kept sorted by their minimum value, so the active blocks for an iso value are found with a binary search followed by a check
+    of their maximum value. Active blocks are extracted in parallel and merged. Normals are computed from the gradient of the whole image,
+    so there are no visible seams between blocks.
+
+    Extracted isosurfaces are cached by iso value. Isosurfaces with more than DecimationThreshold triangles are decimated in the background
+    down to that number of triangles; when the decimated isosurface is ready it replaces the original one in the cache and
+    isosurfaceDecimated() is emitted. Only the first scalar component of the input is used.
+  */
+class IsosurfaceExtractor : public QObject {
+Q_OBJECT
+public:
+    /// Number of cells in each dimension of the blocks of the min/max index
+    static const int BlockSize;
+    /// Maximum number of isosurfaces kept in the cache
+    static const int MaximumCachedIsosurfaces;
+    /// Isosurfaces with more triangles than this are decimated in the background
+    static const int DecimationThreshold;
+
+    explicit IsosurfaceExtractor(QObject *parent = nullptr);
+    ~IsosurfaceExtractor();
+
+    /// Sets the image from which isosurfaces are extracted and clears the cache. The min/max index is built on the first extraction.
+    void setInput(vtkImageData *input);
+
+    /// Returns the isosurface for the given iso value, from the cache if possible. Returns null if there is no input.
+    /// The returned isosurface is owned by the extractor and remains valid at least until the next call to this method or to setInput().
+    vtkPolyData* getIsosurface(double isoValue);
+
+    /// Returns the number of blocks that have to be visited to extract the isosurface for the given iso value
+    int getNumberOfActiveBlocks(double isoValue);
+
+signals:
+    /// Emitted when the decimated isosurface for the given iso value has replaced the original one in the cache
+    void isosurfaceDecimated(double isoValue);
+
+private:
+    /// Extent of a block of the image and range of the values inside it
+    struct Block {
+        int extent[6];
+        double minimum;
+        double maximum;
+    };
+
+    /// Divides the input in blocks and computes their value ranges, if it hasn't been done yet for the current input
+    void buildBlockIndex();
+
+    /// Returns the blocks whose value range contains the given iso value
+    QVector<Block> getActiveBlocks(double isoValue) const;
+
+    /// Extracts the full resolution isosurface for the given iso value from the active blocks
+    vtkSmartPointer<vtkPolyData> extractIsosurface(double isoValue) const;
+
+    /// Adds the isosurface to the cache, removing the least recently used one if the cache is full
+    void insertInCache(double isoValue, vtkSmartPointer<vtkPolyData> isosurface);
+
+    /// Starts the decimation of the given isosurface in a background thread
+    void decimateInBackground(double isoValue, vtkSmartPointer<vtkPolyData> isosurface);
+
+private:
+    /// The input image
+    vtkSmartPointer<vtkImageData> m_input;
+    /// Blocks of the input sorted by their minimum value
+    QVector<Block> m_blocks;
+    /// True when m_blocks corresponds to the current input
+    bool m_hasBlockIndex;
+
+    /// Cached isosurfaces by iso value
+    QMap<double, vtkSmartPointer<vtkPolyData> > m_cache;
+    /// Cached iso values ordered from the least to the most recently used
+    QList<double> m_cacheUsage;
+};
+
+} // End namespace udg
+
+#endif
@@ -21,14 +21,18 @@
 #include "drawertext.h"
 #include "mathtools.h"
 #include "sliceorientedvolumepixeldata.h"
+#include "volumepixeldata.h"
 #include "voxel.h"
 #include "voxelindex.h"
 
 #include <QApplication> // to check pressed mouse buttons
+#include <QElapsedTimer>
 #include <qmath.h>
 
 // Vtk
 #include <vtkCommand.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
 #include <vtkRenderWindowInteractor.h>
 
 namespace udg {
@@ -46,6 +50,11 @@ MagicROITool::MagicROITool(QViewer *viewer, QObject *parent)
     m_maxY = 0;
     m_lowerLevel = 0.0;
     m_upperLevel = 0.0;
+    m_xIndex = 0;
+    m_yIndex = 1;
+    m_zIndex = 2;
+    m_regionSlice = 0;
+    m_isVolumetric = false;
     m_inputIndex = getROIInputIndex();
     m_toolName = "MagicROITool";
 
@@ -191,16 +200,7 @@ void MagicROITool::startRegion()
     {
         if (m_2DViewer->getCurrentCursorImageCoordinateOnInput(m_pickedPosition, m_inputIndex))
         {
-            // Discard a border of 1 pixel around the image (workaround for #1949)
-            // TODO Implement a better solution, probably reimplementing the whole algorithm
-            VoxelIndex index = getPickedPositionVoxelIndex();   // slice oriented index
-            computeMaskBounds();
-
-            if (index.x() == m_minX || index.x() == m_maxX || index.y() == m_minY || index.y() == m_maxY)
-            {
-                return;
-            }
-
+            m_isVolumetric = m_2DViewer->getInteractor()->GetShiftKey();
             m_pickedPositionInDisplayCoordinates = m_2DViewer->getEventPosition();
             m_magicFactor = InitialMagicFactor;
             m_roiPolygon = new DrawerPolygon;
@@ -351,148 +351,53 @@ void MagicROITool::computeRegionMask()
 {
     this->computeLevelRange();
 
-    // Creem la màscara
-    if (m_minX == 0 && m_minY == 0)
-    {
-        m_mask = QVector<bool>((m_maxX + 1) * (m_maxY + 1), false);
-    }
-    else
-    {
-        DEBUG_LOG("ERROR: extension no comença a 0");
-    }
-    
-    VoxelIndex index = getPickedPositionVoxelIndex();   // slice oriented index
-    double value = this->getVoxelValue(index);
-    int x = index.x(), y = index.y(), z = index.z();
+    SliceOrientedVolumePixelData pixelData = getPixelData();
+    vtkImageData *image = pixelData.getVolumePixelData()->getVtkData();
 
-    if ((value >= m_lowerLevel) && (value <= m_upperLevel))
-    {
-        int maskIndex = getMaskVectorIndex(x, y);
-        m_mask[maskIndex] = true;
-    }
-    else
-    {
-        DEBUG_LOG("Ha petat i sortim");
-        return;
-    }
+    pixelData.getOrthogonalPlane().getXYZIndexes(m_xIndex, m_yIndex, m_zIndex);
 
-    // Comencem el Region Growing
-    QVector<int> movements;
-    // First movement \TODO Codi duplicat amb main loop
-    int i = 0;
-    bool found = false;
-    int maskIndex = 0;
-    while (i < 4 && !found)
-    {
-        this->doMovement(x, y, i);
-        value = this->getVoxelValue(VoxelIndex(x, y, z));
+    VoxelIndex index = pixelData.getVoxelIndex(m_pickedPosition);   // slice oriented index
+    m_regionSlice = index.z();
+    int seed[3];
+    getDataIndex(index.x(), index.y(), seed);
 
-        if ((value >= m_lowerLevel) && (value <= m_upperLevel))
-        {
-            maskIndex = getMaskVectorIndex(x, y);
-            m_mask[maskIndex] = true;
-            found = true;
-            movements.push_back(i);
-        }
-        if (!found)
-        {
-            this->undoMovement(x, y, i);
-        }
-        ++i;
-    }
+    // The region is confined to the picked slice. Voxels at the border of the image are included because the polygon is traced
+    // with getMaskValue() and getWorldCoordinate(), which also work outside the image.
+    int regionExtent[6];
+    image->GetExtent(regionExtent);
+    regionExtent[m_zIndex * 2] = seed[m_zIndex];
+    regionExtent[m_zIndex * 2 + 1] = seed[m_zIndex];
 
-    // Main loop
-    i = 0;
-    while (movements.size() > 0)
-    {
-        found = false;
-        while (i < 4 && !found)
-        {
-            this->doMovement(x, y, i);
-            if ((x > m_minX) && (x < m_maxX) && (y > m_minY) && (y < m_maxY))
-            {
-                value = this->getVoxelValue(VoxelIndex(x, y, z));
-                maskIndex = getMaskVectorIndex(x, y);
-                if ((value >= m_lowerLevel) && (value <= m_upperLevel) && (!m_mask[maskIndex]))
-                {
-                    m_mask[maskIndex] = true;
-                    found = true;
-                    movements.push_back(i);
-                    i = 0;
-                }
-            }
-            if (!found)
-            {
-                this->undoMovement(x, y, i);
-                ++i;
-            }
-        }
-        if (!found)
-        {
-            this->undoMovement(x, y, movements.back());
-            i = movements.back();
-            ++i;
-            movements.pop_back();
-        }
-    }
-}
+    QElapsedTimer timer;
+    timer.start();
 
-void MagicROITool::doMovement(int &x, int &y, int movement)
-{
-    switch (movement)
-    {
-        case MoveRight:
-            x++;
-            break;
-        case MoveLeft:
-            x--;
-            break;
-        case MoveUp:
-            y++;
-            break;
-        case MoveDown:
-            y--;
-            break;
-        default:
-            DEBUG_LOG("Invalid movement");
-    }
-}
+    m_regionGrowing.setInput(image);
+    m_regionGrowing.setRegionExtent(regionExtent);
+    m_regionGrowing.setSeed(seed);
+    int numberOfVoxels = m_regionGrowing.grow(m_lowerLevel, m_upperLevel);
 
-void MagicROITool::undoMovement(int &x, int &y, int movement)
-{
-    switch (movement)
-    {
-        case MoveRight:
-            x--;
-            break;
-        case MoveLeft:
-            x++;
-            break;
-        case MoveUp:
-            y--;
-            break;
-        case MoveDown:
-            y++;
-            break;
-        default:
-            DEBUG_LOG("Invalid movement");
-    }
+    DEBUG_LOG(QString("Magic ROI region of %1 voxels grown in %2 ms").arg(numberOfVoxels).arg(timer.nsecsElapsed() / 1000000.0));
 }
 
 void MagicROITool::computePolygon()
 {
-    int i = m_minX;
+    // Busquem el primer punt dins els bounds de la regió
+    int regionBounds[6];
+    m_regionGrowing.getRegionBounds(regionBounds);
+    int minX = regionBounds[m_xIndex * 2];
+    int maxX = regionBounds[m_xIndex * 2 + 1];
+    int minY = regionBounds[m_yIndex * 2];
+    int maxY = regionBounds[m_yIndex * 2 + 1];
+
+    int i = minX;
     int j;
-    int maskIndex = 0;
-    // Busquem el primer punt
     bool found = false;
-    while ((i <= m_maxX) && !found)
+    while ((i <= maxX) && !found)
     {
-        j = m_minY;
-        while ((j <= m_maxY) && !found)
+        j = minY;
+        while ((j <= maxY) && !found)
         {
-            maskIndex = getMaskVectorIndex(i, j);
-            if (m_mask[maskIndex])
+            if (getMaskValue(i, j))
             {
                 found = true;
             }
@@ -542,6 +447,60 @@ void MagicROITool::computePolygon()
     m_filledRoiPolygon->update();
 }
 
+QString MagicROITool::getAnnotation()
+{
+    QString annotation = ROITool::getAnnotation();
+    if (m_isVolumetric)
+    {
+        annotation += "\n" + getVolumetricRegionAnnotation();
+    }
+
+    return annotation;
+}
+
+QString MagicROITool::getVolumetricRegionAnnotation()
+{
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    vtkImageData *image = getPixelData().getVolumePixelData()->getVtkData();
+    VoxelIndex index = getPickedPositionVoxelIndex();   // slice oriented index
+    int seed[3];
+    getDataIndex(index.x(), index.y(), seed);
+
+    m_volumeRegionGrowing.setInput(image);
+    m_volumeRegionGrowing.setRegionExtent(image->GetExtent());
+    m_volumeRegionGrowing.setSeed(seed);
+    int numberOfVoxels = m_volumeRegionGrowing.grow(m_lowerLevel, m_upperLevel);
+
+    double sum = 0.0;
+    int bounds[6];
+    m_volumeRegionGrowing.getRegionBounds(bounds);
+    for (int z = bounds[4]; numberOfVoxels > 0 && z <= bounds[5]; z++)
+    {
+        for (int y = bounds[2]; y <= bounds[3]; y++)
+        {
+            for (int x = bounds[0]; x <= bounds[1]; x++)
+            {
+                if (m_volumeRegionGrowing.isInRegion(x, y, z))
+                {
+                    sum += image->GetScalarComponentAsDouble(x, y, z, 0);
+                }
+            }
+        }
+    }
+
+    QApplication::restoreOverrideCursor();
+
+    double *spacing = image->GetSpacing();
+    double volume = numberOfVoxels * spacing[0] * spacing[1] * spacing[2];
+    double mean = numberOfVoxels > 0 ? sum / numberOfVoxels : 0.0;
+
+    QString annotation = tr("Volume: %1 cm³").arg(volume / 1000.0, 0, 'f', 2);
+    annotation += "\n" + tr("Volume mean: %1").arg(mean, 0, 'f', 2);
+
+    return annotation;
+}
+
 void MagicROITool::getNextIndex(int direction, int x, int y, int &nextX, int &nextY)
 {
     switch (direction)
@@ -596,30 +555,27 @@ int MagicROITool::getInverseDirection(int direction)
 
 void MagicROITool::addPoint(int direction, int x, int y)
 {
-    int z = getPickedPositionVoxelIndex().z();
-    Vector3 p1 = getPixelData().getWorldCoordinate(VoxelIndex(x, y, z));
-    Vector3 p2;
+    // El punt és al mig de l'aresta entre el vòxel i el veí en la direcció donada, que pot quedar fora de la imatge
+    Vector3 point;
 
     switch (direction)
     {
         case Down:
-            p2 = getPixelData().getWorldCoordinate(VoxelIndex(x, y-1, z));
+            point = getWorldCoordinate(x, y - 0.5);
             break;
         case Right:
-            p2 = getPixelData().getWorldCoordinate(VoxelIndex(x+1, y, z));
+            point = getWorldCoordinate(x + 0.5, y);
             break;
         case Up:
-            p2 = getPixelData().getWorldCoordinate(VoxelIndex(x, y+1, z));
+            point = getWorldCoordinate(x, y + 0.5);
             break;
         case Left:
-            p2 = getPixelData().getWorldCoordinate(VoxelIndex(x-1, y, z));
+            point = getWorldCoordinate(x - 0.5, y);
             break;
         default:
             DEBUG_LOG("ERROR: This direction doesn't exist");
     }
 
-    Vector3 point = (p1 + p2) * 0.5;
-
     m_roiPolygon->addVertix(point.x, point.y, point.z);
     m_filledRoiPolygon->addVertix(point.x, point.y, point.z);
 }
@@ -672,17 +628,45 @@ double MagicROITool::getStandardDeviation()
     return deviation;
 }
 
-int MagicROITool::getMaskVectorIndex(int x, int y) const
+void MagicROITool::getDataIndex(int x, int y, int dataIndex[3]) const
+{
+    dataIndex[m_xIndex] = x;
+    dataIndex[m_yIndex] = y;
+    dataIndex[m_zIndex] = m_regionSlice;
+}
+
+Vector3 MagicROITool::getWorldCoordinate(double x, double y)
 {
-    return y * (m_maxX + 1) + x;
+    SliceOrientedVolumePixelData pixelData = getPixelData();
+    vtkImageData *image = pixelData.getVolumePixelData()->getVtkData();
+    double *origin = image->GetOrigin();
+    double *spacing = image->GetSpacing();
+
+    double index[3];
+    index[m_xIndex] = x;
+    index[m_yIndex] = y;
+    index[m_zIndex] = m_regionSlice;
+
+    double dataCoordinate[4];
+    for (int i = 0; i < 3; i++)
+    {
+        dataCoordinate[i] = origin[i] + index[i] * spacing[i];
+    }
+    dataCoordinate[3] = 1.0;
+
+    double worldCoordinate[4];
+    pixelData.getDataToWorldMatrix()->MultiplyPoint(dataCoordinate, worldCoordinate);
+
+    return Vector3(worldCoordinate[0], worldCoordinate[1], worldCoordinate[2]);
 }
 
 bool MagicROITool::getMaskValue(int x, int y) const
 {
     if (MathTools::isInsideRange(x, m_minX, m_maxX) && MathTools::isInsideRange(y, m_minY, m_maxY))
     {
-        int maskIndex = getMaskVectorIndex(x, y);
-        return m_mask[maskIndex];
+        int dataIndex[3];
+        getDataIndex(x, y, dataIndex);
+        return m_regionGrowing.isInRegion(dataIndex[0], dataIndex[1], dataIndex[2]);
     }
     else
     {
@@ -16,6 +16,8 @@
 #define UDGMAGICROITOOL_H
 
 #include "roitool.h"
+#include "regiongrowing.h"
+#include "vector3.h"
 
 #include <QVector>
 
@@ -29,7 +31,8 @@ class VolumePixelData;
 class VoxelIndex;
 
 /**
-    Tool que serveix per editar el volum sobreposat en un visor 2D
+    Tool que serveix per editar el volum sobreposat en un visor 2D.
+    Si es prem Shift en començar la regió, a més de la regió de la llesca es fa créixer la regió volumètrica i se'n mostra el volum.
 */
 class MagicROITool : public ROITool {
 Q_OBJECT
@@ -37,8 +40,6 @@ public:
     
     // Creixement
     enum { LeftDown, Down, RightDown, Right, RightUp, Up, LeftUp, Left };
-    // Moviments
-    enum { MoveRight, MoveLeft, MoveUp, MoveDown };
 
     MagicROITool(QViewer *viewer, QObject *parent = 0);
     ~MagicROITool();
@@ -48,6 +49,9 @@ public:
 protected:
     virtual void setTextPosition(DrawerText *text);
 
+    /// Afegeix a l'anotació de la ROI el volum de la regió volumètrica si s'ha demanat
+    virtual QString getAnnotation();
+
 private:
     /// Returns the current pixel data from the selected input.
     SliceOrientedVolumePixelData getPixelData();
@@ -64,22 +68,15 @@ private:
     /// Calcula el rang de valors d'intensitat vàlid a partir de \sa #m_magicSize i \see #m_magicFactor
     void computeLevelRange();
 
-    /// Versió iterativa del region Growing
+    /// Grows the region from the picked voxel in the current slice. When the level range widens the previous region is reused.
     void computeRegionMask();
 
-    /// Fer un moviment des d'un índex cap a una direcció
-    /// @param a, @param b índex del volum de la màscara que estem mirant en cada crida
-    /// @param movement direcció en el moviment
-    void doMovement(int &a, int &b, int movement);
-
-    /// Desfer un moviment dses d'un índex cap a una direcció
-    /// @param a, @param b índex del volum de la màscara que estem mirant en cada crida
-    /// @param movement direcció en el moviment
-    void undoMovement(int &a, int &b, int movement);
-
     /// Genera el polígon a partir de la màscara
     void computePolygon();
 
+    /// Grows the region from the picked voxel in the whole volume and returns the annotation with its volume and mean
+    QString getVolumetricRegionAnnotation();
+
     /// Mètodes auxiliar per la generació del polígon
     void getNextIndex(int direction, int x, int y, int &nextX, int &nextY);
     int getNextDirection(int direction);
@@ -108,8 +105,12 @@ private:
     /// Elimina la representacio temporal de la tool
     void deleteTemporalRepresentation();
 
-    /// Returns the mask index corresponding to the given x and y image indices.
-    int getMaskVectorIndex(int x, int y) const;
+    /// Converts the given slice oriented x and y indices in the slice of the region to indices of the pixel data
+    void getDataIndex(int x, int y, int dataIndex[3]) const;
+
+    /// Returns the world coordinate of the given slice oriented continuous x and y indices in the slice of the region.
+    /// Unlike SliceOrientedVolumePixelData::getWorldCoordinate() it also works outside the image, at the border of the region.
+    Vector3 getWorldCoordinate(double x, double y);
 
     /// Returns the mask value at the given x and y image indices. If the indices are out of bounds, returns false.
     bool getMaskValue(int x, int y) const;
@@ -131,8 +132,18 @@ private:
 
     double m_magicFactor;
 
-    /// Màscara de la regió que formarà el polígon
-    QVector<bool> m_mask;
+    /// Region growing that computes the mask of the region that will form the polygon
+    RegionGrowing m_regionGrowing;
+
+    /// Region growing in the whole volume, used when m_isVolumetric is true
+    RegionGrowing m_volumeRegionGrowing;
+
+    /// Cert si s'ha de calcular també la regió volumètrica
+    bool m_isVolumetric;
+
+    /// Pixel data axes of the slice oriented x, y and z axes and slice oriented z index of the region
+    int m_xIndex, m_yIndex, m_zIndex;
+    int m_regionSlice;
 
     /// Bounds de la màscara
     int m_minX, m_maxX, m_minY, m_maxY;
@@ -0,0 +1,464 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "maskstatistics.h"
+
+#include "volume.h"
+#include "volumepixeldatastatistics.h"
+
+#include <QSharedPointer>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace udg {
+
+namespace {
+
+template <class T>
+qint64 countInsideVoxels(const T *scalars, vtkIdType numberOfPixels, int numberOfComponents, double insideValue)
+{
+    qint64 count = 0;
+    for (vtkIdType i = 0; i < numberOfPixels; i++)
+    {
+        if (scalars[i * numberOfComponents] == insideValue)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+template <class T>
+qint64 countSliceVoxelsInRange(const T *scalars, vtkIdType numberOfPixels, int numberOfComponents, double lower, double upper)
+{
+    qint64 count = 0;
+    for (vtkIdType i = 0; i < numberOfPixels; i++)
+    {
+        double value = scalars[i * numberOfComponents];
+        if (value >= lower && value <= upper)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+bool hasScalars(vtkImageData *imageData)
+{
+    return imageData && imageData->GetPointData()->GetScalars() && imageData->GetNumberOfPoints() > 0;
+}
+
+// Returns a new image that shares the scalars of the given one, so that they stay alive for a background task even if the data of the given image
+// are released
+vtkSmartPointer<vtkImageData> shareData(vtkImageData *imageData)
+{
+    vtkSmartPointer<vtkImageData> copy = vtkSmartPointer<vtkImageData>::New();
+    copy->ShallowCopy(imageData);
+    return copy;
+}
+
+}
+
+// Enough to give a bin to each value of 16 bit images
+const int MaskStatistics::MaximumNumberOfBins = 65536;
+
+MaskStatistics::MaskStatistics(QObject *parent)
+ : QObject(parent), m_volumeGeneration(0), m_histogramMinimum(0.0), m_histogramMaximum(0.0), m_binWidth(1.0), m_exactBins(false),
+   m_isHistogramReady(false), m_hasPendingThreshold(false), m_pendingLower(0.0), m_pendingUpper(0.0), m_insideValue(0.0), m_maskGeneration(0),
+   m_maskVoxels(0), m_thresholdLower(0.0), m_thresholdUpper(0.0), m_isCountingMask(false), m_maskCountWatcher(0)
+{
+}
+
+MaskStatistics::~MaskStatistics()
+{
+}
+
+void MaskStatistics::setVolume(Volume *volume)
+{
+    setVolume(volume ? volume->getVtkData() : 0);
+}
+
+void MaskStatistics::setVolume(vtkImageData *imageData)
+{
+    m_volumeGeneration++;
+    m_volume = imageData;
+    m_cumulativeHistogram.clear();
+    m_isHistogramReady = false;
+    m_hasPendingThreshold = false;
+
+    // A threshold mask refers to the previous volume for the slices that haven't been counted, so it has to be counted from scratch
+    if (m_sliceCounts.contains(-1))
+    {
+        setMask(m_mask, m_insideValue);
+    }
+
+    if (!hasScalars(imageData))
+    {
+        return;
+    }
+
+    QSharedPointer<VolumePixelDataStatistics> statistics(new VolumePixelDataStatistics());
+    vtkSmartPointer<vtkImageData> volume = shareData(m_volume);
+    int generation = m_volumeGeneration;
+
+    QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
+
+    connect(watcher, &QFutureWatcher<void>::finished, [this, watcher, statistics, generation]()
+    {
+        watcher->deleteLater();
+
+        // The volume may have changed while the histogram was computed
+        if (generation != m_volumeGeneration || statistics->isEmpty())
+        {
+            return;
+        }
+
+        double range[2];
+        statistics->getRange(range);
+        m_histogramMinimum = range[0];
+        m_histogramMaximum = range[1];
+        m_binWidth = statistics->getBinWidth();
+        m_exactBins = statistics->hasExactBins();
+
+        const QVector<qint64> &histogram = statistics->getHistogram();
+        m_cumulativeHistogram.fill(0, histogram.size() + 1);
+        for (int i = 0; i < histogram.size(); i++)
+        {
+            m_cumulativeHistogram[i + 1] = m_cumulativeHistogram.at(i) + histogram.at(i);
+        }
+        m_isHistogramReady = true;
+
+        if (m_hasPendingThreshold)
+        {
+            m_hasPendingThreshold = false;
+            requestThresholdVolume(m_pendingLower, m_pendingUpper);
+        }
+    });
+
+    watcher->setFuture(QtConcurrent::run([statistics, volume]()
+    {
+        statistics->compute(volume, MaximumNumberOfBins);
+    }));
+}
+
+bool MaskStatistics::isHistogramReady() const
+{
+    return m_isHistogramReady;
+}
+
+qint64 MaskStatistics::countVoxelsInRange(double lower, double upper) const
+{
+    if (!m_isHistogramReady)
+    {
+        return -1;
+    }
+
+    if (upper < lower || upper < m_histogramMinimum || lower > m_histogramMaximum)
+    {
+        return 0;
+    }
+
+    int numberOfBins = m_cumulativeHistogram.size() - 1;
+
+    if (m_exactBins)
+    {
+        // Each bin holds the integer value m_histogramMinimum + bin, so the range covers the bins of the integers inside it
+        int firstBin = static_cast<int>(qMax(0.0, std::ceil(lower - m_histogramMinimum)));
+        int lastBin = static_cast<int>(qMin(numberOfBins - 1.0, std::floor(upper - m_histogramMinimum)));
+        if (firstBin > lastBin)
+        {
+            return 0;
+        }
+
+        return m_cumulativeHistogram.at(lastBin + 1) - m_cumulativeHistogram.at(firstBin);
+    }
+
+    // The maximum falls in the last bin, so ranges that reach it have to include the whole bin
+    double countBelowUpper = upper >= m_histogramMaximum ? m_cumulativeHistogram.last() : countValuesBelow((upper - m_histogramMinimum) / m_binWidth);
+    double countBelowLower = lower <= m_histogramMinimum ? 0.0 : countValuesBelow((lower - m_histogramMinimum) / m_binWidth);
+
+    return qRound64(countBelowUpper - countBelowLower);
+}
+
+void MaskStatistics::requestThresholdVolume(double lower, double upper)
+{
+    if (!m_isHistogramReady)
+    {
+        m_hasPendingThreshold = true;
+        m_pendingLower = lower;
+        m_pendingUpper = upper;
+        return;
+    }
+
+    qint64 voxels = countVoxelsInRange(lower, upper);
+    emit thresholdVolumeComputed(lower, upper, voxels, computeVolume(m_volume, voxels));
+}
+
+void MaskStatistics::setMask(Volume *mask, double insideValue)
+{
+    setMask(mask ? mask->getVtkData() : 0, insideValue);
+}
+
+void MaskStatistics::setMask(vtkImageData *mask, double insideValue)
+{
+    resetMask(mask, insideValue);
+
+    if (m_mask)
+    {
+        int extent[6];
+        m_mask->GetExtent(extent);
+        m_sliceCounts.fill(0, extent[5] - extent[4] + 1);
+        updateMask();
+    }
+}
+
+void MaskStatistics::setThresholdMask(Volume *mask, double insideValue, double lower, double upper)
+{
+    setThresholdMask(mask ? mask->getVtkData() : 0, insideValue, lower, upper);
+}
+
+void MaskStatistics::setThresholdMask(vtkImageData *mask, double insideValue, double lower, double upper)
+{
+    int maskExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    int volumeExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    if (hasScalars(mask))
+    {
+        mask->GetExtent(maskExtent);
+    }
+    if (m_volume)
+    {
+        m_volume->GetExtent(volumeExtent);
+    }
+
+    if (!m_isHistogramReady || !hasScalars(mask) || !std::equal(maskExtent, maskExtent + 6, volumeExtent))
+    {
+        setMask(mask, insideValue);
+        return;
+    }
+
+    resetMask(mask, insideValue);
+    m_thresholdLower = lower;
+    m_thresholdUpper = upper;
+    m_sliceCounts.fill(-1, maskExtent[5] - maskExtent[4] + 1);
+    m_maskVoxels = countVoxelsInRange(lower, upper);
+
+    emit maskVolumeComputed(m_maskVoxels, getMaskVolume());
+}
+
+void MaskStatistics::updateMask(int firstSlice, int lastSlice)
+{
+    if (!m_mask)
+    {
+        return;
+    }
+
+    int extent[6];
+    m_mask->GetExtent(extent);
+    for (int z = qMax(firstSlice, extent[4]); z <= qMin(lastSlice, extent[5]); z++)
+    {
+        m_pendingSlices.insert(z);
+    }
+
+    if (!m_isCountingMask)
+    {
+        startMaskCount();
+    }
+}
+
+void MaskStatistics::updateMask()
+{
+    if (m_mask)
+    {
+        int extent[6];
+        m_mask->GetExtent(extent);
+        updateMask(extent[4], extent[5]);
+    }
+}
+
+bool MaskStatistics::isMaskUpToDate() const
+{
+    return !m_isCountingMask && m_pendingSlices.isEmpty();
+}
+
+qint64 MaskStatistics::getMaskVoxels() const
+{
+    return m_maskVoxels;
+}
+
+double MaskStatistics::getMaskVolume() const
+{
+    return computeVolume(m_mask, m_maskVoxels);
+}
+
+void MaskStatistics::resetMask(vtkImageData *mask, double insideValue)
+{
+    m_maskGeneration++;
+    if (m_maskCountWatcher)
+    {
+        m_maskCountWatcher->cancel();
+        m_maskCountWatcher = 0;
+    }
+
+    m_mask = hasScalars(mask) ? mask : 0;
+    m_insideValue = insideValue;
+    m_pendingSlices.clear();
+    m_isCountingMask = false;
+    m_maskVoxels = 0;
+    m_sliceCounts.clear();
+}
+
+void MaskStatistics::startMaskCount()
+{
+    if (m_pendingSlices.isEmpty())
+    {
+        return;
+    }
+
+    int extent[6];
+    m_mask->GetExtent(extent);
+    vtkIdType numberOfPixels = static_cast<vtkIdType>(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1);
+    int numberOfComponents = m_mask->GetNumberOfScalarComponents();
+    int scalarType = m_mask->GetScalarType();
+    int sliceSize = numberOfPixels * numberOfComponents * m_mask->GetScalarSize();
+
+    // The slices are copied so that the mask can be modified or replaced while they're counted
+    QSharedPointer<QVector<SliceCount> > slices(new QVector<SliceCount>());
+    QSharedPointer<QByteArray> sliceData(new QByteArray(sliceSize * m_pendingSlices.size(), Qt::Uninitialized));
+    bool needsThresholdCounts = false;
+    slices->reserve(m_pendingSlices.size());
+    foreach (int z, m_pendingSlices)
+    {
+        memcpy(sliceData->data() + slices->size() * sliceSize, m_mask->GetScalarPointer(extent[0], extent[2], z), sliceSize);
+        bool isCounted = m_sliceCounts.at(z - extent[4]) >= 0;
+        SliceCount slice = { z, 0, isCounted ? -1 : 0 };
+        slices->append(slice);
+        needsThresholdCounts = needsThresholdCounts || !isCounted;
+    }
+    m_pendingSlices.clear();
+    m_isCountingMask = true;
+
+    vtkSmartPointer<vtkImageData> volume;
+    if (needsThresholdCounts)
+    {
+        volume = shareData(m_volume);
+    }
+    double insideValue = m_insideValue;
+    double lower = m_thresholdLower;
+    double upper = m_thresholdUpper;
+    int generation = m_maskGeneration;
+
+    QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
+    m_maskCountWatcher = watcher;
+
+    connect(watcher, &QFutureWatcher<void>::finished, [this, watcher, slices, generation]()
+    {
+        watcher->deleteLater();
+
+        // The mask may have changed while it was counted
+        if (generation != m_maskGeneration)
+        {
+            return;
+        }
+        m_maskCountWatcher = 0;
+
+        // The slices of a threshold mask that hadn't been counted had the voxels of the volume in the threshold range before being edited
+        int firstSlice = m_mask->GetExtent()[4];
+        foreach (const SliceCount &slice, *slices)
+        {
+            qint64 previousCount = m_sliceCounts.at(slice.z - firstSlice);
+            if (previousCount < 0)
+            {
+                previousCount = slice.thresholdCount;
+            }
+            m_maskVoxels += slice.count - previousCount;
+            m_sliceCounts[slice.z - firstSlice] = slice.count;
+        }
+        m_isCountingMask = false;
+
+        // Slices edited during the count are counted before publishing the result
+        if (!m_pendingSlices.isEmpty())
+        {
+            startMaskCount();
+            return;
+        }
+
+        emit maskVolumeComputed(m_maskVoxels, getMaskVolume());
+    });
+
+    // The functor keeps the slices, their data and the volume alive even if this object is destroyed before the count finishes
+    watcher->setFuture(QtConcurrent::map(*slices, [slices, sliceData, sliceSize, numberOfPixels, numberOfComponents, scalarType, insideValue, volume,
+                                                   lower, upper](SliceCount &slice)
+    {
+        // The slices were copied in the same order as they are in the vector
+        const char *scalars = sliceData->constData() + (&slice - slices->constData()) * sliceSize;
+        switch (scalarType)
+        {
+            vtkTemplateMacro(slice.count = countInsideVoxels(reinterpret_cast<const VTK_TT*>(scalars), numberOfPixels, numberOfComponents,
+                                                             insideValue));
+        }
+
+        if (slice.thresholdCount >= 0)
+        {
+            int extent[6];
+            volume->GetExtent(extent);
+            void *volumeScalars = volume->GetScalarPointer(extent[0], extent[2], slice.z);
+            switch (volume->GetScalarType())
+            {
+                vtkTemplateMacro(slice.thresholdCount = countSliceVoxelsInRange(static_cast<const VTK_TT*>(volumeScalars), numberOfPixels,
+                                                                                volume->GetNumberOfScalarComponents(), lower, upper));
+            }
+        }
+    }));
+}
+
+double MaskStatistics::countValuesBelow(double binPosition) const
+{
+    int numberOfBins = m_cumulativeHistogram.size() - 1;
+    if (binPosition <= 0.0)
+    {
+        return 0.0;
+    }
+    if (binPosition >= numberOfBins)
+    {
+        return m_cumulativeHistogram.last();
+    }
+
+    // The values are assumed to be evenly spread inside each bin
+    int bin = static_cast<int>(binPosition);
+    qint64 binCount = m_cumulativeHistogram.at(bin + 1) - m_cumulativeHistogram.at(bin);
+    return m_cumulativeHistogram.at(bin) + (binPosition - bin) * binCount;
+}
+
+double MaskStatistics::computeVolume(vtkImageData *imageData, qint64 voxels)
+{
+    if (!imageData)
+    {
+        return 0.0;
+    }
+
+    double spacing[3];
+    imageData->GetSpacing(spacing);
+    return spacing[0] * spacing[1] * spacing[2] * voxels;
+}
+
+} // End namespace udg
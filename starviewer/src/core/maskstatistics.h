@@ -0,0 +1,169 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGMASKSTATISTICS_H
+#define UDGMASKSTATISTICS_H
+
+#include <QObject>
+
+#include <QFutureWatcher>
+#include <QSet>
+#include <QVector>
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+namespace udg {
+
+class Volume;
+
+/**
+    Voxel counts and volumes of segmentation masks, computed in the background so that the GUI thread never walks the voxels.
+
+    There are two kinds of masks. Threshold masks, which contain the voxels of a volume whose values are in a [lower, upper] range, are measured
+    with a histogram of the volume that is computed once when the volume is set, so any range is answered from its cumulative counts without
+    touching the voxels. The counts are exact for integer volumes with up to MaximumNumberOfBins different values and interpolated inside the
+    bins otherwise.
+
+    Edited masks, such as the result of a seeded segmentation modified with the editor tool, are counted slice by slice. After an edit only the
+    slices that have been modified have to be recounted; edits received while a count is running are queued and counted when it finishes.
+    A mask obtained thresholding the volume can be set with setThresholdMask(), which takes its count from the histogram; the slices of such
+    a mask are only counted when they are edited, together with the voxels of the same slice of the volume in the threshold range, which gives
+    the count of the slice before the edit.
+
+    The slices to count are copied in the GUI thread when their count starts, so the background count never reads the mask while the GUI thread
+    modifies or replaces it. The volume isn't expected to be modified in place; its data are kept alive while they're read.
+
+    Results are published with thresholdVolumeComputed() and maskVolumeComputed(). Only the first scalar component is taken into account.
+  */
+class MaskStatistics : public QObject {
+Q_OBJECT
+public:
+    /// Maximum number of bins of the histogram of the volume
+    static const int MaximumNumberOfBins;
+
+    explicit MaskStatistics(QObject *parent = nullptr);
+    ~MaskStatistics();
+
+    /// Sets the volume used for the threshold queries and starts computing its histogram in the background
+    void setVolume(Volume *volume);
+    void setVolume(vtkImageData *imageData);
+
+    /// Returns true if the histogram of the volume is ready
+    bool isHistogramReady() const;
+
+    /// Returns the number of voxels of the volume with a value in [lower, upper], or -1 if the histogram isn't ready yet
+    qint64 countVoxelsInRange(double lower, double upper) const;
+
+    /// Requests the number of voxels and the volume in mm3 of the voxels with a value in [lower, upper]. thresholdVolumeComputed() is emitted
+    /// at once if the histogram is ready, or when it's ready otherwise; in that case only the last requested range is answered.
+    void requestThresholdVolume(double lower, double upper);
+
+    /// Sets the mask whose voxels equal to insideValue are counted and starts counting all of them in the background. The count of the
+    /// previous mask is cancelled.
+    void setMask(Volume *mask, double insideValue);
+    void setMask(vtkImageData *mask, double insideValue);
+
+    /// Sets a mask obtained thresholding the volume in [lower, upper], whose voxels equal to insideValue are the voxels of the volume in that
+    /// range. If the histogram is ready the count is taken from it and maskVolumeComputed() is emitted at once without counting the mask;
+    /// otherwise, or if the mask doesn't have the extent of the volume, it's counted as with setMask().
+    void setThresholdMask(Volume *mask, double insideValue, double lower, double upper);
+    void setThresholdMask(vtkImageData *mask, double insideValue, double lower, double upper);
+
+    /// Recounts the slices of the mask from firstSlice to lastSlice, in image index coordinates, after they have been modified
+    void updateMask(int firstSlice, int lastSlice);
+    /// Recounts all the slices of the mask
+    void updateMask();
+
+    /// Returns true if there are no counts of the mask running or pending
+    bool isMaskUpToDate() const;
+
+    /// Returns the last computed number of voxels and volume in mm3 of the mask
+    qint64 getMaskVoxels() const;
+    double getMaskVolume() const;
+
+signals:
+    /// Emitted when the voxels of the volume in the requested range have been counted
+    void thresholdVolumeComputed(double lower, double upper, qint64 voxels, double volume);
+
+    /// Emitted when all the modifications of the mask have been counted
+    void maskVolumeComputed(qint64 voxels, double volume);
+
+private:
+    /// Number of voxels inside the mask in the slice z and, for the slices of a threshold mask that haven't been counted yet, number of voxels of
+    /// the volume in the threshold range in that slice
+    struct SliceCount {
+        int z;
+        qint64 count;
+        qint64 thresholdCount;
+    };
+
+    /// Replaces the mask and cancels the count of the previous one
+    void resetMask(vtkImageData *mask, double insideValue);
+
+    /// Counts the pending slices of the mask in the background
+    void startMaskCount();
+
+    /// Returns the number of values of the histogram below the given position, measured in bins
+    double countValuesBelow(double binPosition) const;
+
+    /// Returns the volume in mm3 of the given number of voxels of the image
+    static double computeVolume(vtkImageData *imageData, qint64 voxels);
+
+private:
+    /// Volume used for the threshold queries
+    vtkSmartPointer<vtkImageData> m_volume;
+    /// Incremented each time the volume changes, to discard the histograms of previous volumes
+    int m_volumeGeneration;
+
+    /// Range of the values of the volume and width of the bins of its histogram
+    double m_histogramMinimum;
+    double m_histogramMaximum;
+    double m_binWidth;
+    /// True if each bin holds a single integer value
+    bool m_exactBins;
+    /// Number of values of the volume in the bins before each bin. Has one more entry than bins, with the total count.
+    QVector<qint64> m_cumulativeHistogram;
+    bool m_isHistogramReady;
+
+    /// Threshold range requested before the histogram was ready
+    bool m_hasPendingThreshold;
+    double m_pendingLower;
+    double m_pendingUpper;
+
+    /// Mask whose inside voxels are counted and value of those voxels
+    vtkSmartPointer<vtkImageData> m_mask;
+    double m_insideValue;
+    /// Incremented each time the mask changes, to discard the counts of previous masks
+    int m_maskGeneration;
+
+    /// Number of inside voxels in each slice of the mask and their sum. The slices of a threshold mask that haven't been counted have -1.
+    QVector<qint64> m_sliceCounts;
+    qint64 m_maskVoxels;
+
+    /// Threshold range of the mask, if it has been set with setThresholdMask()
+    double m_thresholdLower;
+    double m_thresholdUpper;
+
+    /// Slices modified since the running count started
+    QSet<int> m_pendingSlices;
+    bool m_isCountingMask;
+    /// Watcher of the running count, cancelled when the mask changes
+    QFutureWatcher<void> *m_maskCountWatcher;
+};
+
+} // End namespace udg
+
+#endif
@@ -18,10 +18,13 @@
 #include "logging.h"
 #include "drawerpolygon.h"
 #include "drawer.h"
-#include "mathtools.h"
-// Vtk
-#include <vtkPoints.h>
-#include <vtkLine.h>
+#include "volume.h"
+
+#include <QElapsedTimer>
+
+#include <vtkCommand.h>
+
+#include <algorithm>
 
 namespace udg {
 
@@ -33,8 +36,6 @@ PolylineTemporalROITool::PolylineTemporalROITool(QViewer *viewer, QObject *paren
     m_hasPersistentData = true;
 
     m_myData = new PolylineTemporalROIToolData;
-
-    connect(this, SIGNAL(finished()), this, SLOT(start()));
 }
 
 PolylineTemporalROITool::~PolylineTemporalROITool()
@@ -57,267 +58,91 @@ void PolylineTemporalROITool::setToolData(ToolData *data)
     }
 }
 
-void PolylineTemporalROITool::start()
+void PolylineTemporalROITool::handleEvent(long unsigned eventID)
 {
-    DEBUG_LOG("Start PolylineTemporalROI");
-    double bounds[6];
-    m_roiPolygon->getBounds(bounds);
-    this->computeTemporalMean();
+    PolylineROITool::handleEvent(eventID);
+
+    // Mentre es dibuixa la ROI actualitzem les corbes amb el punt actual com a últim vèrtex. Només es tornen a mesurar
+    // les files de la ROI que canvien, de manera que la gràfica pot seguir el ratolí.
+    if (eventID == vtkCommand::MouseMoveEvent && m_roiPolygon && m_roiPolygon->getNumberOfPoints() >= 2)
+    {
+        double pickedPoint[3];
+        m_2DViewer->getEventWorldCoordinate(pickedPoint);
+        m_2DViewer->putCoordinateInCurrentImageBounds(pickedPoint);
+
+        int xIndex, yIndex, zIndex;
+        m_2DViewer->getView().getXYZIndexes(xIndex, yIndex, zIndex);
+
+        QVector<QPointF> contour = getContour();
+        contour.append(QPointF(pickedPoint[xIndex], pickedPoint[yIndex]));
+        computeTimeActivityCurves(contour);
+    }
 }
 
-double PolylineTemporalROITool::computeTemporalMean()
+QString PolylineTemporalROITool::getAnnotation()
 {
-    if (!m_myData->temporalImageHasBeenDefined())
+    QString annotation = PolylineROITool::getAnnotation();
+
+    if (!this->computeTimeActivityCurves(getContour()))
     {
-        return 0.0;
+        return annotation;
     }
 
-    TemporalImageType::RegionType region = m_myData->getTemporalImage()->GetLargestPossibleRegion();
-    // std::cout<<"Region="<<region<<std::endl;
-    TemporalImageType::SizeType size = region.GetSize();
-    // std::cout<<"Size="<<size<<std::endl;
-    int temporalSize = size[0];
-    QVector<double> mean (temporalSize);
-    QVector<double> aux (temporalSize);
-    int i, j;
-    for (i = 0; i < temporalSize; i++)
+    // Resum de la corba de la mitjana: el pic i la fase on s'assoleix
+    const TimeActivityCurveCalculator::Curves &curves = m_myData->getCurves();
+    if (curves.numberOfVoxels > 0 && !curves.mean.isEmpty())
     {
-        mean[i] = 0.0;
+        int peakPhase = std::max_element(curves.mean.constBegin(), curves.mean.constEnd()) - curves.mean.constBegin();
+        annotation += "\n" + tr("Phases: %1").arg(curves.mean.size());
+        annotation += "\n" + tr("Peak mean: %1 (phase %2)").arg(curves.mean.at(peakPhase), 0, 'f', 2).arg(peakPhase + 1);
     }
 
-    int subId;
-    int initialPosition;
-    int endPosition;
-    double intersectPoint[3];
-    double *firstIntersection;
-    double *secondIntersection;
-    double pcoords[3];
-    double t;
-    double p0[3];
-    double p1[3];
-    int numberOfVoxels = 0;
-    QList<double*> intersectionList;
-    QList<int> indexList;
-    vtkPoints *auxPoints;
-    double rayP1[3];
-    double rayP2[3];
-    double verticalLimit;
-    int currentView = m_2DViewer->getView();
-
-    // El nombre de segments és el mateix que el nombre de punts del polígon
-    int numberOfSegments = m_roiPolygon->getNumberOfPoints() - 1;
+    return annotation;
+}
 
-    // Taula de punters a vtkLine per a representar cadascun dels segments del polígon
-    QVector<vtkLine*> segments;
+QVector<QPointF> PolylineTemporalROITool::getContour() const
+{
+    int xIndex, yIndex, zIndex;
+    m_2DViewer->getView().getXYZIndexes(xIndex, yIndex, zIndex);
 
-    // Creem els diferents segments
-    for (i = 0; i < numberOfSegments; i++)
+    QVector<QPointF> contour;
+    for (int i = 0; i < m_roiPolygon->getNumberOfPoints(); i++)
     {
-        vtkLine *line = vtkLine::New();
-        line->GetPointIds()->SetNumberOfIds(2);
-        line->GetPoints()->SetNumberOfPoints(2);
-
-        const double *p1 = m_roiPolygon->getVertix(i);
-        const double *p2 = m_roiPolygon->getVertix(i + 1);
-
-        line->GetPoints()->InsertPoint(0, p1);
-        line->GetPoints()->InsertPoint(1, p2);
-
-        segments << line;
+        const double *vertex = m_roiPolygon->getVertix(i);
+        contour.append(QPointF(vertex[xIndex], vertex[yIndex]));
     }
 
-    double bounds[6];
-    m_roiPolygon->getBounds(bounds);
-    double *spacing = m_2DViewer->getMainInput()->getSpacing();
+    return contour;
+}
 
-    int rayPointIndex;
-    int intersectionIndex;
-    switch (currentView)
+bool PolylineTemporalROITool::computeTimeActivityCurves(const QVector<QPointF> &contour)
+{
+    Volume *input = m_2DViewer->getMainInput();
+    if (m_myData->temporalImageHasBeenDefined())
     {
-        case OrthogonalPlane::XYPlane:
-            // xmin
-            rayP1[0] = bounds[0];
-            // y
-            rayP1[1] = bounds[2];
-            // z
-            rayP1[2] = bounds[4];
-            // xmax
-            rayP2[0] = bounds[1];
-            // y
-            rayP2[1] = bounds[2];
-            // z
-            rayP2[2] = bounds[4];
-
-            rayPointIndex = 1;
-            intersectionIndex = 0;
-            verticalLimit = bounds[3];
-            break;
-
-        case OrthogonalPlane::YZPlane:
-            // xmin
-            rayP1[0] = bounds[0];
-            // ymin
-            rayP1[1] = bounds[2];
-            // zmin
-            rayP1[2] = bounds[4];
-            // xmin
-            rayP2[0] = bounds[0];
-            // ymin
-            rayP2[1] = bounds[2];
-            // zmax
-            rayP2[2] = bounds[5];
-
-            rayPointIndex = 1;
-            intersectionIndex = 2;
-            verticalLimit = bounds[3];
-            break;
-
-        case OrthogonalPlane::XZPlane:
-            // xmin
-            rayP1[0] = bounds[0];
-            // ymin
-            rayP1[1] = bounds[2];
-            // zmin
-            rayP1[2] = bounds[4];
-            // xmax
-            rayP2[0] = bounds[1];
-            // ymin
-            rayP2[1] = bounds[2];
-            // zmin
-            rayP2[2] = bounds[4];
-
-            rayPointIndex = 2;
-            intersectionIndex = 0;
-            verticalLimit = bounds[5];
-            break;
+        m_timeActivityCurveCalculator.setTemporalImage(m_myData->getTemporalImage(), input->getOrigin(), input->getSpacing());
     }
-
-    while (rayP1[rayPointIndex] <= verticalLimit)
+    else if (input->getNumberOfPhases() > 1)
     {
-        intersectionList.clear();
-        indexList.clear();
-        for (i = 0; i < numberOfSegments; i++)
-        {
-            auxPoints = segments[i]->GetPoints();
-            auxPoints->GetPoint(0, p0);
-            auxPoints->GetPoint(1, p1);
-            if ((rayP1[rayPointIndex] <= p0[rayPointIndex] && rayP1[rayPointIndex] >= p1[rayPointIndex])
-                || (rayP1[rayPointIndex] >= p0[rayPointIndex] && rayP1[rayPointIndex] <= p1[rayPointIndex]))
-            {
-                indexList << i;
-            }
-        }
-        // Obtenim les interseccions entre tots els segments de la ROI i el raig actual
-        foreach (int segment, indexList)
-        {
-            if (segments[segment]->IntersectWithLine(rayP1, rayP2, 0.0001, t, intersectPoint, pcoords, subId) > 0)
-            {
-                double *findedPoint = new double[3];
-                findedPoint[0] = intersectPoint[0];
-                findedPoint[1] = intersectPoint[1];
-                findedPoint[2] = intersectPoint[2];
-                intersectionList.append (findedPoint);
-            }
-        }
-
-        if (MathTools::isEven(intersectionList.count()))
-        {
-            int limit = intersectionList.count() / 2;
-            for (i = 0; i < limit; i++)
-            {
-                initialPosition = i * 2;
-                endPosition = initialPosition + 1;
-
-                firstIntersection = intersectionList.at(initialPosition);
-                secondIntersection = intersectionList.at(endPosition);
-
-                // Tractem els dos sentits de les interseccions
-
-                // D'esquerra cap a dreta
-                if (firstIntersection[intersectionIndex] <= secondIntersection[intersectionIndex])
-                {
-                    while (firstIntersection[intersectionIndex] <= secondIntersection[intersectionIndex])
-                    {
-                        aux = this->getGraySerie(firstIntersection, temporalSize);
-                        for (j = 0; j < temporalSize; j++)
-                        {
-                            mean[j] += aux[j];
-                        }
-                        numberOfVoxels++;
-                        firstIntersection[intersectionIndex] += spacing[0];
-                    }
-                }
-                // De dreta cap a esquerra
-                else
-                {
-                    while (firstIntersection[intersectionIndex] >= secondIntersection[intersectionIndex])
-                    {
-                        aux = this->getGraySerie(firstIntersection, temporalSize);
-                        for (j = 0; j < temporalSize; j++)
-                        {
-                            mean[j] += aux[j];
-                        }
-                        numberOfVoxels++;
-                        firstIntersection[intersectionIndex] -= spacing[0];
-                    }
-                }
-            }
-        }
-        else
-        {
-            DEBUG_LOG("EL NOMBRE D'INTERSECCIONS ENTRE EL RAIG I LA ROI Ã‰S IMPARELL!!");
-        }
-
-        // Fem el següent pas en la coordenada que escombrem
-        rayP1[rayPointIndex] += spacing[1];
-        rayP2[rayPointIndex] += spacing[1];
-
-        while (!intersectionList.isEmpty())
-        {
-            double *intersection = intersectionList.takeFirst();
-            delete[] intersection;
-        }
+        m_timeActivityCurveCalculator.setInput(input->getVtkData(), input->getNumberOfPhases());
     }
-
-    // std::cout<<"Num of voxels:"<<numberOfVoxels<<std::endl;
-
-    for (j = 0; j < temporalSize; j++)
+    else
     {
-        mean[j] /= numberOfVoxels;
-        // std::cout<<"i: "<<j<<": "<<mean[j]<<std::endl;
+        return false;
     }
 
-    this->m_myData->setMeanVector(mean);
+    QElapsedTimer timer;
+    timer.start();
 
-    // Destruim els diferents segments que hem creat per simular la roi
-    for (i = 0; i < numberOfSegments; i++)
-    {
-        segments[i]->Delete();
-    }
-
-    return 0.0;
-}
+    m_timeActivityCurveCalculator.setContour(contour, m_2DViewer->getView(), m_2DViewer->getCurrentSlice());
+    const TimeActivityCurveCalculator::Curves &curves = m_timeActivityCurveCalculator.getCurves();
 
-QVector<double> PolylineTemporalROITool::getGraySerie(double *coords, int size)
-{
-    QVector<double> v (size);
-    double *origin = m_2DViewer->getMainInput()->getOrigin();
-    double *spacing = m_2DViewer->getMainInput()->getSpacing();
-    itk::Index<4> index;
-    int xIndex, yIndex, zIndex;
-    int i;
+    DEBUG_LOG(QString("Time-activity curves of %1 voxels and %2 phases computed in %3 ms").arg(curves.numberOfVoxels)
+              .arg(curves.mean.size()).arg(timer.nsecsElapsed() / 1000000.0));
 
-    m_2DViewer->getView().getXYZIndexes(xIndex, yIndex, zIndex);
-    index[xIndex + 1] = (int)((coords[xIndex] - origin[xIndex])/spacing[xIndex]);
-    index[yIndex + 1] = (int)((coords[yIndex] - origin[yIndex])/spacing[yIndex]);
-    index[zIndex + 1] = m_2DViewer->getCurrentSlice();
+    m_myData->setCurves(curves);
 
-    for (i = 0; i < size; i++)
-    {
-        index[0] = i;
-        v[i] = m_myData->getTemporalImage()->GetPixel(index);
-    }
-    return v;
+    return true;
 }
 
 }
@@ -16,6 +16,7 @@
 #define UDGPOLYLINETEMPORALROITOOL_H
 
 #include "polylineroitool.h"
+#include "timeactivitycurvecalculator.h"
 
 #include <itkImage.h>
 
@@ -42,20 +43,27 @@ public:
     /// Assigna les dades pròpies de l'eina (persistent data)
     void setToolData(ToolData *data);
 
-private slots:
-    /// Metode que es crida quan s'acaba de definir la roi
-    void start();
+    /// Gestiona els events de la polilínia i, mentre es dibuixa, actualitza les corbes amb la ROI que es tancaria al punt actual
+    void handleEvent(long unsigned eventID);
+
+protected:
+    /// Calcula les corbes temporals quan s'acaba de definir la roi i n'afegeix un resum a l'anotació
+    virtual QString getAnnotation();
 
 private:
-    /// Metode per calcular la mitjana temporal de la regio del polyline
-    double computeTemporalMean();
+    /// Retorna els vèrtexs de la ROI amb les coordenades dels eixos de la vista actual
+    QVector<QPointF> getContour() const;
 
-    /// Metode que retorna la serie temporal de mida size en una determinada coordenada
-    QVector<double> getGraySerie(double *coords, int size);
+    /// Calcula les corbes temporals del contorn donat sobre la imatge temporal de les dades, o sobre les fases de l'input principal
+    /// si les dades no tenen imatge temporal, i les guarda a les dades. Retorna fals si no hi ha sèrie temporal.
+    bool computeTimeActivityCurves(const QVector<QPointF> &contour);
 
 private:
     /// Dades específiques de la tool
     PolylineTemporalROIToolData *m_myData;
+
+    /// Calcula les corbes i les manté fins que canvien la regió o la imatge temporal
+    TimeActivityCurveCalculator m_timeActivityCurveCalculator;
 };
 
 }
@@ -22,16 +22,22 @@ PolylineTemporalROIToolData::PolylineTemporalROIToolData(QObject *parent)
 {
     m_temporalImage = 0;
     m_temporalImageHasBeenDefined = false;
+    m_curves.numberOfVoxels = 0;
 }
 
 PolylineTemporalROIToolData::~PolylineTemporalROIToolData()
 {
 }
 
-void PolylineTemporalROIToolData::setMeanVector(QVector<double> m)
+void PolylineTemporalROIToolData::setCurves(const TimeActivityCurveCalculator::Curves &curves)
 {
-    m_mean = m;
+    m_curves = curves;
     emit dataChanged();
 }
 
+bool PolylineTemporalROIToolData::saveCurvesCsv(const QString &fileName) const
+{
+    return TimeActivityCurveCalculator::saveCsv(m_curves, fileName);
+}
+
 }
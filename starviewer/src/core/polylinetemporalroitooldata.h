@@ -16,6 +16,7 @@
 #define UDGPOLYLINETEMPORALROITOOLDATA_H
 
 #include "tooldata.h"
+#include "timeactivitycurvecalculator.h"
 
 #include <itkImage.h>
 
@@ -49,19 +50,28 @@ public:
         return m_temporalImageHasBeenDefined;
     }
 
-    void setMeanVector(QVector<double> m);
+    /// Assigna les corbes temporals de la ROI
+    void setCurves(const TimeActivityCurveCalculator::Curves &curves);
+    const TimeActivityCurveCalculator::Curves& getCurves() const
+    {
+        return m_curves;
+    }
+
     QVector<double> getMeanVector()
     {
-        return m_mean;
+        return m_curves.mean;
     }
 
+    /// Desa les corbes temporals en format CSV. Retorna fals si no es pot escriure el fitxer.
+    bool saveCurvesCsv(const QString &fileName) const;
+
 signals:
     /// S'emet quan s'assigna un nou vector de dades
     void dataChanged();
 
 private:
-    /// Vector on hi desarem la mitjana temporal
-    QVector<double> m_mean;
+    /// Corbes temporals de la ROI: mitjana, mínim, màxim i desviació estàndard per cada fase
+    TimeActivityCurveCalculator::Curves m_curves;
 
     /// Imatge amb les dades temporals
     TemporalImageType::Pointer m_temporalImage;
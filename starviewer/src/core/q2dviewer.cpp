@@ -595,6 +595,7 @@ void Q2DViewer::setNewVolumes(const QList<Volume*> &volumes, bool setViewerStatu
     }
 
     addImageActors();
+    updateRenderingProfilerStages();
 
     setCurrentViewPlane(OrthogonalPlane::XYPlane);
     m_alignPosition = Q2DViewer::AlignCenter;
@@ -1952,6 +1953,14 @@ VolumeDisplayUnit* Q2DViewer::getMainDisplayUnit() const
     return getDisplayUnit(0);
 }
 
+void Q2DViewer::addRenderingProfilerStages(RenderingProfiler *profiler)
+{
+    foreach (VolumeDisplayUnit *unit, getDisplayUnits())
+    {
+        unit->addToRenderingProfiler(profiler);
+    }
+}
+
 QList<VolumeDisplayUnit*> Q2DViewer::getDisplayUnits() const
 {
     if (m_displayUnitsHandler.isNull())
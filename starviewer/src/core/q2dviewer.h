@@ -438,6 +438,9 @@ protected:
     /// Sets the current view plane.
     virtual void setCurrentViewPlane(const OrthogonalPlane &viewPlane);
 
+    /// Adds the filters and mappers of all the display units to the profiler.
+    virtual void addRenderingProfilerStages(RenderingProfiler *profiler);
+
 private:
     /// Updates image orientation according to the preferred presentation depending on its attributes, like modality.
     /// At this moment it is only applying to mammography (MG) images
@@ -16,18 +16,24 @@
 
 #include "abortrendercommand.h"
 #include "imageplane.h"
+#include "isosurfaceextractor.h"
+#include "logging.h"
 #include "q3dorientationmarker.h"
 #include "voilut.h"
 #include "volume.h"
 
+#include <QElapsedTimer>
+#include <QThread>
 #include <QVTKWidget.h>
 #include <vtkActor.h>
-#include <vtkImageMarchingCubes.h>
+#include <vtkCamera.h>
+#include <vtkFixedPointVolumeRayCastMapper.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkPlanes.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
 #include <vtkRenderer.h>
 #include <vtkSmartVolumeMapper.h>
 #include <vtkVolume.h>
@@ -35,6 +41,8 @@
 
 namespace udg {
 
+const double Q3DViewer::CpuRayCastingMaximumImageSampleDistance = 4.0;
+
 Q3DViewer* Q3DViewer::castFromQViewer(QViewer *viewer)
 {
     if (!viewer)
@@ -54,7 +62,7 @@ Q3DViewer* Q3DViewer::castFromQViewer(QViewer *viewer)
 }
 
 Q3DViewer::Q3DViewer(QWidget *parent)
-    : QViewer(parent), m_firstRender(true), m_clippingPlanes(nullptr)
+    : QViewer(parent), m_isoValue(0.0), m_isosurfaceEnabled(false), m_firstRender(true), m_clippingPlanes(nullptr)
 {
     m_vtkWidget->setAutomaticImageCacheEnabled(true);
 
@@ -65,6 +73,14 @@ Q3DViewer::Q3DViewer(QWidget *parent)
 
     m_volumeMapper = vtkSmartVolumeMapper::New();
     m_volumeMapper->InteractiveAdjustSampleDistancesOff();  // Workaround for vtkSmartVolumeMapper bug (https://gitlab.kitware.com/vtk/vtk/issues/17323)
+    // The smart mapper can't adjust sample distances because of the workaround above, so CPU ray casting uses its own mapper. The image sample
+    // distance is adapted to the desired update rate of the render window, which the interactor raises while the user is interacting.
+    m_cpuVolumeMapper = vtkFixedPointVolumeRayCastMapper::New();
+    m_cpuVolumeMapper->SetNumberOfThreads(QThread::idealThreadCount());
+    m_cpuVolumeMapper->LockSampleDistanceToInputSpacingOn();
+    m_cpuVolumeMapper->AutoAdjustSampleDistancesOn();
+    m_cpuVolumeMapper->SetMinimumImageSampleDistance(1.0);
+    m_cpuVolumeMapper->SetMaximumImageSampleDistance(CpuRayCastingMaximumImageSampleDistance);
     m_volumeProperty = vtkVolumeProperty::New();
     m_volumeProperty->SetInterpolationTypeToLinear();
     m_vtkVolume = vtkVolume::New();
@@ -85,11 +101,18 @@ Q3DViewer::Q3DViewer(QWidget *parent)
     m_volumeProperty->SetColor(m_transferFunction.vtkColorTransferFunction());
     m_volumeProperty->SetScalarOpacity(m_transferFunction.vtkOpacityTransferFunction());
 
-    m_isosurfaceFilter = vtkImageMarchingCubes::New();
-    vtkNew<vtkPolyDataMapper> isosurfaceMapper;
-    isosurfaceMapper->SetInputConnection(m_isosurfaceFilter->GetOutputPort());
+    m_isosurfaceExtractor = new IsosurfaceExtractor(this);
+    m_isosurfaceMapper = vtkPolyDataMapper::New();
     m_isosurfaceActor = vtkActor::New();
-    m_isosurfaceActor->SetMapper(isosurfaceMapper);
+    m_isosurfaceActor->SetMapper(m_isosurfaceMapper);
+
+    connect(m_isosurfaceExtractor, &IsosurfaceExtractor::isosurfaceDecimated, [this](double isoValue) {
+        if (m_isosurfaceEnabled && isoValue == m_isoValue)
+        {
+            updateIsosurface();
+            render();
+        }
+    });
 
     m_renderer->AddViewProp(m_vtkVolume);
 }
@@ -97,10 +120,11 @@ Q3DViewer::Q3DViewer(QWidget *parent)
 Q3DViewer::~Q3DViewer()
 {
     m_volumeMapper->Delete();
+    m_cpuVolumeMapper->Delete();
     m_volumeProperty->Delete();
     m_vtkVolume->Delete();
 
-    m_isosurfaceFilter->Delete();
+    m_isosurfaceMapper->Delete();
     m_isosurfaceActor->Delete();
 
     if (m_clippingPlanes)
@@ -131,7 +155,8 @@ void Q3DViewer::setClippingPlanes(vtkPlanes *clippingPlanes)
         m_clippingPlanes = clippingPlanes;
         m_clippingPlanes->Register(nullptr);
         m_volumeMapper->SetClippingPlanes(m_clippingPlanes);
-        m_isosurfaceActor->GetMapper()->SetClippingPlanes(m_clippingPlanes);
+        m_cpuVolumeMapper->SetClippingPlanes(m_clippingPlanes);
+        m_isosurfaceMapper->SetClippingPlanes(m_clippingPlanes);
     }
     else
     {
@@ -158,7 +183,8 @@ void Q3DViewer::setInput(Volume *volume)
     if (m_clippingPlanes)
     {
         m_volumeMapper->RemoveAllClippingPlanes();
-        m_isosurfaceActor->GetMapper()->RemoveAllClippingPlanes();
+        m_cpuVolumeMapper->RemoveAllClippingPlanes();
+        m_isosurfaceMapper->RemoveAllClippingPlanes();
         m_clippingPlanes->Delete();
         m_clippingPlanes = nullptr;
     }
@@ -167,7 +193,13 @@ void Q3DViewer::setInput(Volume *volume)
     m_mainVolume->getVtkData()->Modified(); // Workaround for vtkSmartVolumeMapper bug (https://gitlab.kitware.com/vtk/vtk/issues/17328)
     m_volumeMapper->SetInputData(m_mainVolume->getVtkData());
     m_volumeMapper->SetSampleDistance(-1.0);    // force the mapper to compute a sample distance based on data spacing
-    m_isosurfaceFilter->SetInputData(m_mainVolume->getVtkData());
+    m_cpuVolumeMapper->SetInputData(m_mainVolume->getVtkData());
+    m_isosurfaceExtractor->setInput(m_mainVolume->getVtkData());
+
+    if (m_isosurfaceEnabled)
+    {
+        updateIsosurface();
+    }
 
     setVolumeTransformation();
 
@@ -188,18 +220,26 @@ void Q3DViewer::setInput(Volume *volume)
 
 void Q3DViewer::setBlendMode(const BlendMode &mode)
 {
+    int vtkBlendMode = m_volumeMapper->GetBlendMode();
+
     switch (mode)
     {
-        case BlendMode::Composite: m_volumeMapper->SetBlendModeToComposite(); break;
-        case BlendMode::MaximumIntensity: m_volumeMapper->SetBlendModeToMaximumIntensity(); break;
-        case BlendMode::MinimumIntensity: m_volumeMapper->SetBlendModeToMinimumIntensity(); break;
-        case BlendMode::AverageIntensity: m_volumeMapper->SetBlendModeToAverageIntensity(); break;
-        case BlendMode::Additive: m_volumeMapper->SetBlendModeToAdditive(); break;
+        case BlendMode::Composite: vtkBlendMode = vtkVolumeMapper::COMPOSITE_BLEND; break;
+        case BlendMode::MaximumIntensity: vtkBlendMode = vtkVolumeMapper::MAXIMUM_INTENSITY_BLEND; break;
+        case BlendMode::MinimumIntensity: vtkBlendMode = vtkVolumeMapper::MINIMUM_INTENSITY_BLEND; break;
+        case BlendMode::AverageIntensity: vtkBlendMode = vtkVolumeMapper::AVERAGE_INTENSITY_BLEND; break;
+        case BlendMode::Additive: vtkBlendMode = vtkVolumeMapper::ADDITIVE_BLEND; break;
         case BlendMode::Isosurface: break;
     }
 
-    if (mode == BlendMode::Isosurface)
+    m_volumeMapper->SetBlendMode(vtkBlendMode);
+    m_cpuVolumeMapper->SetBlendMode(vtkBlendMode);
+
+    m_isosurfaceEnabled = mode == BlendMode::Isosurface;
+
+    if (m_isosurfaceEnabled)
     {
+        updateIsosurface();
         m_renderer->RemoveViewProp(m_vtkVolume);
         m_renderer->AddViewProp(m_isosurfaceActor);
     }
@@ -212,12 +252,19 @@ void Q3DViewer::setBlendMode(const BlendMode &mode)
 
 void Q3DViewer::setRenderMode(const RenderMode &mode)
 {
+    vtkVolumeMapper *mapper = m_volumeMapper;
+
     switch (mode)
     {
         case RenderMode::SmartRayCasting: m_volumeMapper->SetRequestedRenderModeToDefault(); break;
-        case RenderMode::CpuRayCasting: m_volumeMapper->SetRequestedRenderModeToRayCast(); break;
+        case RenderMode::CpuRayCasting: mapper = m_cpuVolumeMapper; break;
         case RenderMode::GpuRayCasting: m_volumeMapper->SetRequestedRenderModeToGPU(); break;
     }
+
+    if (m_vtkVolume->GetMapper() != mapper)
+    {
+        m_vtkVolume->SetMapper(mapper);
+    }
 }
 
 void Q3DViewer::setInterpolationMode(const InterpolationMode &mode)
@@ -295,7 +342,12 @@ void Q3DViewer::setSpecularPower(double specularPower)
 
 void Q3DViewer::setIsoValue(int isoValue)
 {
-    m_isosurfaceFilter->SetValue(0, isoValue);
+    m_isoValue = isoValue;
+
+    if (m_isosurfaceEnabled)
+    {
+        updateIsosurface();
+    }
 }
 
 void Q3DViewer::enableOrientationMarker(bool enable)
@@ -313,6 +365,47 @@ void Q3DViewer::orientationMarkerOff()
     this->enableOrientationMarker(false);
 }
 
+double Q3DViewer::benchmarkInteractiveRendering(int numberOfFrames)
+{
+    if (!hasInput() || numberOfFrames <= 0)
+    {
+        return 0.0;
+    }
+
+    vtkRenderWindow *renderWindow = getRenderWindow();
+    vtkCamera *camera = getActiveCamera();
+    vtkNew<vtkCamera> initialCamera;
+    initialCamera->DeepCopy(camera);
+    double stillUpdateRate = renderWindow->GetDesiredUpdateRate();
+
+    // Renders must not be aborted by pending events, otherwise aborted frames would be counted as fast ones
+    renderWindow->RemoveObservers(vtkCommand::AbortCheckEvent);
+    renderWindow->SetDesiredUpdateRate(getInteractor()->GetDesiredUpdateRate());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < numberOfFrames; i++)
+    {
+        camera->Azimuth(360.0 / numberOfFrames);
+        renderWindow->Render();
+    }
+
+    double meanFrameTime = static_cast<double>(timer.nsecsElapsed()) / numberOfFrames / 1000000.0;
+
+    renderWindow->SetDesiredUpdateRate(stillUpdateRate);
+    vtkNew<AbortRenderCommand> abortRenderCommand;
+    renderWindow->AddObserver(vtkCommand::AbortCheckEvent, abortRenderCommand);
+    camera->DeepCopy(initialCamera);
+    render();
+
+    INFO_LOG(QString("3D rendering benchmark: %1 frames of %2x%3 pixels with %4, mean frame time: %5 ms")
+             .arg(numberOfFrames).arg(getRenderWindowSize().width()).arg(getRenderWindowSize().height())
+             .arg(m_vtkVolume->GetMapper()->GetClassName()).arg(meanFrameTime));
+
+    return meanFrameTime;
+}
+
 void Q3DViewer::getCurrentRenderedItemBounds(double bounds[6])
 {
     m_vtkVolume->GetBounds(bounds);
@@ -379,4 +472,9 @@ void Q3DViewer::setDefaultViewForCurrentInput()
     resetViewToCoronal();
 }
 
+void Q3DViewer::updateIsosurface()
+{
+    m_isosurfaceMapper->SetInputData(m_isosurfaceExtractor->getIsosurface(m_isoValue));
+}
+
 }
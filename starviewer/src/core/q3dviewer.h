@@ -20,15 +20,17 @@
 #include "transferfunction.h"
 
 class vtkActor;
+class vtkFixedPointVolumeRayCastMapper;
 class vtkImageData;
-class vtkImageMarchingCubes;
 class vtkPlanes;
+class vtkPolyDataMapper;
 class vtkSmartVolumeMapper;
 class vtkVolume;
 class vtkVolumeProperty;
 
 namespace udg {
 
+class IsosurfaceExtractor;
 class Q3DOrientationMarker;
 class Volume;
 
@@ -67,6 +69,11 @@ public:
     /// Obté els plans de tall que s'han definit sobre el volum
     vtkPlanes* getClippingPlanes() const;
 
+    /// Renders a full turn of the camera around the volume in the given number of frames at the interactive update rate and returns the mean
+    /// time per frame in milliseconds. The camera and the update rate are restored afterwards, so runs with different render modes on the same
+    /// input and viewer size are comparable. Returns 0 if there is no input.
+    double benchmarkInteractiveRendering(int numberOfFrames = 72);
+
 
 public slots:
     void setInput(Volume* volume) override;
@@ -123,18 +130,33 @@ private:
     /// Coronal, però depenent del tipus de Sèrie podria ser una altra
     void setDefaultViewForCurrentInput();
 
+    /// Gives the isosurface for the current iso value to the isosurface mapper.
+    void updateIsosurface();
+
 private:
+    /// Largest image sample distance allowed to the CPU ray casting mapper when rendering at the interactive update rate.
+    static const double CpuRayCastingMaximumImageSampleDistance;
+
     /// The main mapper for volume rendering.
     vtkSmartVolumeMapper *m_volumeMapper;
+    /// The mapper used in CPU ray casting render mode. It skips transparent space using a min/max volume classified with the current
+    /// transfer function, terminates rays early, renders in parallel and lowers the image resolution during interaction.
+    vtkFixedPointVolumeRayCastMapper *m_cpuVolumeMapper;
     /// Properties of volume rendering.
     vtkVolumeProperty *m_volumeProperty;
     /// The volume actor.
     vtkVolume *m_vtkVolume;
 
-    /// The filter to compute isosurfaces.
-    vtkImageMarchingCubes *m_isosurfaceFilter;
+    /// Extracts and caches the isosurfaces of the current input.
+    IsosurfaceExtractor *m_isosurfaceExtractor;
+    /// The mapper for isosurfaces.
+    vtkPolyDataMapper *m_isosurfaceMapper;
     /// The actor for isosurfaces.
     vtkActor *m_isosurfaceActor;
+    /// Current iso value.
+    double m_isoValue;
+    /// True when the blend mode is isosurface. Isosurfaces are only extracted in that case.
+    bool m_isosurfaceEnabled;
 
     /// Widget per veure la orientació en 3D
     Q3DOrientationMarker *m_orientationMarker;
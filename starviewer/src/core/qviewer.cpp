@@ -26,12 +26,16 @@
 #include "mathtools.h"
 #include "starviewerapplication.h"
 #include "coresettings.h"
+#include "renderingprofiler.h"
+#include "shortcutmanager.h"
 
 // TODO: Ouch! SuperGuarrada (tm). Per poder fer sortir el menú i tenir accés al Patient principal. S'ha d'arreglar en quan es tregui les dependències de
 // interface, pacs, etc.etc.!!
 #include "../interface/qapplicationmainwindow.h"
 
 // Qt
+#include <QAction>
+#include <QDateTime>
 #include <QStackedLayout>
 #include <QContextMenuEvent>
 #include <QMessageBox>
@@ -76,6 +80,13 @@ QViewer::QViewer(QWidget *parent)
     m_toolProxy = new ToolProxy(this);
     connect(this, SIGNAL(eventReceived(unsigned long)), m_toolProxy, SLOT(forwardEvent(unsigned long)));
 
+    m_renderingProfiler = new RenderingProfiler(getRenderWindow(), m_renderer, this);
+    QAction *toggleRenderingProfilerAction = new QAction(this);
+    toggleRenderingProfilerAction->setShortcuts(ShortcutManager::getShortcuts(Shortcuts::ToggleRenderingProfiler));
+    toggleRenderingProfilerAction->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    connect(toggleRenderingProfilerAction, &QAction::triggered, this, &QViewer::toggleRenderingProfiler);
+    addAction(toggleRenderingProfilerAction);
+
     // Inicialitzem el window level data
     setVoiLutData(new VoiLutPresetsToolData(this));
 
@@ -103,6 +114,7 @@ QViewer::~QViewer()
 {
     // Cal que la eliminació del vtkWidget sigui al final ja que els altres
     // objectes que eliminem en poden fer ús durant la seva destrucció
+    delete m_renderingProfiler;
     delete m_toolProxy;
     m_patientBrowserMenu->deleteLater();
     m_windowToImageFilter->Delete();
@@ -571,6 +583,34 @@ bool QViewer::scaleToFit3D(double topCorner[3], double bottomCorner[3], double m
     return adjustCameraScaleFactor(factor);
 }
 
+void QViewer::toggleRenderingProfiler()
+{
+    if (!m_renderingProfiler->isEnabled())
+    {
+        updateRenderingProfilerStages();
+        m_renderingProfiler->setEnabled(true);
+        m_renderingProfiler->setOverlayVisible(true);
+        render();
+        return;
+    }
+
+    m_renderingProfiler->setEnabled(false);
+    m_renderingProfiler->setOverlayVisible(false);
+    render();
+
+    INFO_LOG("Rendering profile:\n" + m_renderingProfiler->getSummary());
+
+    QString fileName = UserLogsPath + "renderingprofile_" + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") + ".csv";
+    if (m_renderingProfiler->saveCsv(fileName))
+    {
+        INFO_LOG("Rendering profile saved to " + fileName);
+    }
+    else
+    {
+        WARN_LOG("Could not save the rendering profile to " + fileName);
+    }
+}
+
 void QViewer::fitRenderingIntoViewport()
 {
     // First we get the bounds of the current rendered item in world coordinates
@@ -938,6 +978,18 @@ void QViewer::handleNotEnoughMemoryForVisualizationError()
     unsetCursor();
     // In case of error during rendering the render window is left unusable, so we must create a new one
     setupRenderWindow();
+    m_renderingProfiler->setRenderWindow(getRenderWindow());
+}
+
+void QViewer::addRenderingProfilerStages(RenderingProfiler *profiler)
+{
+    Q_UNUSED(profiler);
+}
+
+void QViewer::updateRenderingProfilerStages()
+{
+    m_renderingProfiler->clearStageObjects();
+    addRenderingProfilerStages(m_renderingProfiler);
 }
 
 void QViewer::setupRenderWindow()
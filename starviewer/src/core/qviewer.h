@@ -43,6 +43,7 @@ class ToolProxy;
 class VoiLutPresetsToolData;
 class PatientBrowserMenu;
 class QViewerWorkInProgressWidget;
+class RenderingProfiler;
 class VoiLut;
 
 /**
@@ -215,6 +216,10 @@ public slots:
     /// Fits the current rendered item into the viewport size
     void fitRenderingIntoViewport();
 
+    /// Enables the rendering profiler with its overlay if it was disabled. Otherwise disables it, writes its summary to the log and saves
+    /// the recorded frames as CSV in the user logs directory.
+    void toggleRenderingProfiler();
+
 signals:
     /// Informem de l'event rebut. \TODO ara enviem el codi en vtkCommand, però podria (o hauria de) canviar per un mapeig nostre
     void eventReceived(unsigned long eventID);
@@ -289,6 +294,12 @@ protected:
     /// Handles errors produced by lack of memory space for visualization.
     void handleNotEnoughMemoryForVisualizationError();
 
+    /// Adds the objects whose rendering times are measured by the given profiler. The default implementation does nothing.
+    virtual void addRenderingProfilerStages(RenderingProfiler *profiler);
+
+    /// Replaces the stage objects of the rendering profiler. Must be called when the objects added by addRenderingProfilerStages() change.
+    void updateRenderingProfilerStages();
+
 private slots:
     /// Slot que s'utilitza quan s'ha seleccionat una sèrie amb el PatientBrowserMenu
     /// Mètode que especifica un input seguit d'una crida al mètode render()
@@ -348,6 +359,9 @@ protected:
     /// The default margin for fit into viewport. Should be between 0..1.
     double m_defaultFitIntoViewportMarginRate;
 
+    /// Measures the time spent in each rendering stage. Disabled by default.
+    RenderingProfiler *m_renderingProfiler;
+
 private:
     /// Current view plane: plane that is perpendicular to the camera pointing direction.
     OrthogonalPlane m_currentViewPlane;
@@ -35,7 +35,8 @@ const double ReferenceLinesTool::MinimumAngleConstraint = 45.0;
 const double ReferenceLinesTool::MaximumAngleConstraint = 135.0;
 
 ReferenceLinesTool::ReferenceLinesTool(QViewer *viewer, QObject *parent)
- : Tool(viewer, parent), m_projectedReferencePlane(0), m_showPlaneThickness(true), m_planesToProject(SingleImage)
+ : Tool(viewer, parent), m_projectedReferencePlane(0), m_showPlaneThickness(true), m_planesToProject(SingleImage),
+   m_localizerPlane(0), m_localizerSlice(0), m_localizerView(0)
 {
     m_toolName = "ReferenceLinesTool";
     m_hasSharedData = true;
@@ -91,6 +92,8 @@ ReferenceLinesTool::~ReferenceLinesTool()
     {
         m_myData->setFrameOfReferenceUID(QString());
     }
+
+    delete m_localizerPlane;
 }
 
 void ReferenceLinesTool::initialize()
@@ -142,13 +145,12 @@ void ReferenceLinesTool::updateProjectionLines()
             }
             else
             {
+                // Aquí ja ho deixem en mans de la projecció
+                ImagePlane *localizerPlane = getLocalizerPlane();
                 int drawerLineOffset = 0;
-                foreach (ImagePlane *referencePlane, planesToProject)
+                for (int i = 0; i < planesToProject.count(); i++)
                 {
-                    // Aquí ja ho deixem en mans de la projecció
-                    ImagePlane *localizerPlane = m_2DViewer->getCurrentImagePlane();
-                    projectIntersection(referencePlane, localizerPlane, drawerLineOffset);
-                    delete localizerPlane;
+                    projectIntersection(i, planesToProject.at(i), localizerPlane, drawerLineOffset);
                     drawerLineOffset += m_showPlaneThickness ? 2 : 1;
                 }
             }
@@ -165,7 +167,7 @@ void ReferenceLinesTool::updateProjectionLines()
     }
 }
 
-void ReferenceLinesTool::projectIntersection(ImagePlane *referencePlane, ImagePlane *localizerPlane, int drawerLineOffset)
+void ReferenceLinesTool::projectIntersection(int referencePlaneIndex, ImagePlane *referencePlane, ImagePlane *localizerPlane, int drawerLineOffset)
 {
     if (!(referencePlane && localizerPlane))
     {
@@ -198,7 +200,7 @@ void ReferenceLinesTool::projectIntersection(ImagePlane *referencePlane, ImagePl
             cornerLocations << ImagePlane::Central;
         }
 
-        if (computeIntersectionAndUpdateProjectionLines(localizerPlane, referencePlane, cornerLocations, drawerLineOffset))
+        if (computeIntersectionAndUpdateProjectionLines(localizerPlane, referencePlaneIndex, cornerLocations, drawerLineOffset))
         {
             m_2DViewer->getDrawer()->enableGroup(ReferenceLinesDrawerGroup);
         }
@@ -213,7 +215,7 @@ void ReferenceLinesTool::projectIntersection(ImagePlane *referencePlane, ImagePl
     }
 }
 
-bool ReferenceLinesTool::computeIntersectionAndUpdateProjectionLines(ImagePlane *localizerPlane, ImagePlane *referencePlane,
+bool ReferenceLinesTool::computeIntersectionAndUpdateProjectionLines(ImagePlane *localizerPlane, int referencePlaneIndex,
                                                                      const QList<ImagePlane::CornersLocation> &cornerLocations, int lineOffset)
 {
     bool hasEnoughIntersections = true;
@@ -221,7 +223,9 @@ bool ReferenceLinesTool::computeIntersectionAndUpdateProjectionLines(ImagePlane
     for (int i = 0; i < cornerLocations.size(); ++i)
     {
         Vector3 firstIntersectionPoint, secondIntersectionPoint;
-        numberOfIntersections = referencePlane->getIntersections(localizerPlane, firstIntersectionPoint, secondIntersectionPoint, cornerLocations.at(i));
+        // Les cantonades del pla de referència estan precalculades a les dades compartides per tots els viewers
+        numberOfIntersections = ImagePlane::getIntersections(m_myData->getCornersToProject(referencePlaneIndex, cornerLocations.at(i)), localizerPlane,
+                                                             firstIntersectionPoint, secondIntersectionPoint);
         if (numberOfIntersections)
         {
             updateProjectionLinesFromIntersections(firstIntersectionPoint.toArray().data(), secondIntersectionPoint.toArray().data(), lineOffset + i);
@@ -340,6 +344,9 @@ void ReferenceLinesTool::updateReferenceImagePlanesToProject()
 
 void ReferenceLinesTool::updateDataForCurrentInput()
 {
+    // El pla localitzador del volum anterior ja no és vàlid
+    invalidateLocalizerPlane();
+
     // Actualitzem el frame of reference
     updateFrameOfReference();
     
@@ -373,6 +380,27 @@ void ReferenceLinesTool::setAsReferenceViewer()
     updateReferenceImagePlanesToProject();
 }
 
+ImagePlane* ReferenceLinesTool::getLocalizerPlane()
+{
+    int slice = m_2DViewer->getCurrentSlice();
+    int view = m_2DViewer->getView();
+    if (!m_localizerPlane || slice != m_localizerSlice || view != m_localizerView)
+    {
+        delete m_localizerPlane;
+        m_localizerPlane = m_2DViewer->getCurrentImagePlane();
+        m_localizerSlice = slice;
+        m_localizerView = view;
+    }
+
+    return m_localizerPlane;
+}
+
+void ReferenceLinesTool::invalidateLocalizerPlane()
+{
+    delete m_localizerPlane;
+    m_localizerPlane = 0;
+}
+
 DrawerLine* ReferenceLinesTool::createNewLine(bool isBackgroundLine)
 {
     DrawerLine *line = new DrawerLine;
@@ -75,13 +75,14 @@ private:
     void createPrimitives();
 
     /// Projecta la intersecció del pla de referència amb el localitzador, sobre el pla de localitzador
-    /// tambe li indiquem quina es la linia a modificar
-    void projectIntersection(ImagePlane *referencePlane, ImagePlane *localizerPlane, int drawerLineOffset = 0);
+    /// tambe li indiquem quina es la linia a modificar. referencePlaneIndex és l'índex del pla de referència a les dades de la tool
+    void projectIntersection(int referencePlaneIndex, ImagePlane *referencePlane, ImagePlane *localizerPlane, int drawerLineOffset = 0);
     
-    /// Computes intersection between given localizer and reference plane. boundsList shows which reference bound planes should be used to
-    /// compute intersections (upper, lower, central). If there is intersection with a bound plane, updates the correspoding lines
-    /// according to the given offset. If there is intersection with all the given bound planes returns true, false otherwise.
-    bool computeIntersectionAndUpdateProjectionLines(ImagePlane *localizerPlane, ImagePlane *referencePlane,
+    /// Computes intersection between given localizer and reference plane, given by its index in the tool data. boundsList shows which
+    /// reference bound planes should be used to compute intersections (upper, lower, central). If there is intersection with a bound plane,
+    /// updates the correspoding lines according to the given offset. If there is intersection with all the given bound planes returns true,
+    /// false otherwise.
+    bool computeIntersectionAndUpdateProjectionLines(ImagePlane *localizerPlane, int referencePlaneIndex,
                                                      const QList<ImagePlane::CornersLocation> &cornerLocations, int lineOffset);
     
     /// Projects the given intersection points and updates the corresponding lines according to lineOffset
@@ -97,6 +98,13 @@ private:
     /// Aquest mètode es fa servir per "debug"
     void projectPlane(ImagePlane *planeToProject);
 
+    /// Retorna el pla de la imatge que es veu al viewer, que fa de localitzador. Es guarda mentre no canviï la llesca o la vista,
+    /// de manera que no cal tornar-lo a calcular cada cop que canvia el pla de referència
+    ImagePlane* getLocalizerPlane();
+
+    /// Descarta el pla localitzador guardat
+    void invalidateLocalizerPlane();
+
     /// Ens crea una DrawerLine, ja sigui de les principals o de background
     DrawerLine* createNewLine(bool isBackgroundLine = false);
 
@@ -145,6 +153,11 @@ private:
     /// Ens indica quins plans volem projectar. Tindra els valors enumerats definits per....
     /// aquesta podria ser una variable usada en un ToolConfiguration
     int m_planesToProject;
+
+    /// Pla localitzador guardat i la llesca i vista del viewer per les quals s'ha calculat
+    ImagePlane *m_localizerPlane;
+    int m_localizerSlice;
+    int m_localizerView;
 };
 
 }
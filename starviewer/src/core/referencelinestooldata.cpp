@@ -13,7 +13,6 @@
  *************************************************************************************/
 
 #include "referencelinestooldata.h"
-#include "imageplane.h"
 
 namespace udg {
 
@@ -40,6 +39,11 @@ QList<ImagePlane*> ReferenceLinesToolData::getPlanesToProject() const
     return m_planesToProject;
 }
 
+const ImagePlane::Corners& ReferenceLinesToolData::getCornersToProject(int planeIndex, ImagePlane::CornersLocation location) const
+{
+    return m_cornersToProject.at(planeIndex * 3 + location);
+}
+
 void ReferenceLinesToolData::setFrameOfReferenceUID(const QString &frameOfReference)
 {
     m_frameOfReferenceUID = frameOfReference;
@@ -53,6 +57,7 @@ void ReferenceLinesToolData::setPlanesToProject(QList<ImagePlane*> planes)
     }
     m_planesToProject.clear();
     m_planesToProject = planes;
+    updateCornersToProject();
     emit changed();
 }
 
@@ -67,7 +72,18 @@ void ReferenceLinesToolData::setPlanesToProject(ImagePlane *plane)
     {
         m_planesToProject << plane;
     }
+    updateCornersToProject();
     emit changed();
 }
 
+void ReferenceLinesToolData::updateCornersToProject()
+{
+    m_cornersToProject.clear();
+    m_cornersToProject.reserve(m_planesToProject.size() * 3);
+    foreach (ImagePlane *plane, m_planesToProject)
+    {
+        m_cornersToProject << plane->getCorners(ImagePlane::Central) << plane->getCorners(ImagePlane::Upper) << plane->getCorners(ImagePlane::Lower);
+    }
+}
+
 }
@@ -17,9 +17,11 @@
 
 #include "tooldata.h"
 
-namespace udg {
+#include "imageplane.h"
+
+#include <QVector>
 
-class ImagePlane;
+namespace udg {
 
 /**
     Dades corresponents a la Tool de reference lines
@@ -38,6 +40,10 @@ public:
     /// @return
     QList<ImagePlane*> getPlanesToProject() const;
 
+    /// Retorna les cantonades del pla a projectar amb l'índex donat a la posició indicada.
+    /// Es calculen un sol cop quan s'assignen els plans, de manera que tots els visors que projecten el mateix pla les comparteixen
+    const ImagePlane::Corners& getCornersToProject(int planeIndex, ImagePlane::CornersLocation location) const;
+
 public slots:
     /// Li assignem el frameOfReference del pla de referencia
     /// El frame of reference només pot canviar de valor quan es canvia de sèrie.
@@ -50,12 +56,19 @@ public slots:
     void setPlanesToProject(QList<ImagePlane*> planes);
     void setPlanesToProject(ImagePlane *plane);
 
+private:
+    /// Calcula les cantonades de tots els plans a projectar
+    void updateCornersToProject();
+
 private:
     /// El frame of reference UID del pla de referència
     QString m_frameOfReferenceUID;
 
     /// Llista de plans a projectar
     QList<ImagePlane*> m_planesToProject;
+
+    /// Cantonades central, superior i inferior de cada pla a projectar, consecutives per a cada pla en l'ordre de l'enum CornersLocation
+    QVector<ImagePlane::Corners> m_cornersToProject;
 };
 
 }
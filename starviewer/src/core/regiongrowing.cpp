@@ -0,0 +1,358 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "regiongrowing.h"
+
+#include <vtkImageData.h>
+
+#include <algorithm>
+
+namespace udg {
+
+RegionGrowing::RegionGrowing()
+ : m_inputMTime(0), m_lower(0.0), m_upper(0.0), m_hasRegion(false), m_numberOfVoxels(0)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        m_regionExtent[i * 2] = 0;
+        m_regionExtent[i * 2 + 1] = -1;
+        m_seed[i] = 0;
+        m_regionBounds[i * 2] = 0;
+        m_regionBounds[i * 2 + 1] = -1;
+    }
+}
+
+RegionGrowing::~RegionGrowing()
+{
+}
+
+void RegionGrowing::setInput(vtkImageData *image)
+{
+    if (image != m_input)
+    {
+        m_input = image;
+        if (m_input)
+        {
+            m_input->GetExtent(m_regionExtent);
+        }
+        reset();
+    }
+}
+
+void RegionGrowing::setRegionExtent(const int extent[6])
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (m_regionExtent[i] != extent[i])
+        {
+            std::copy(extent, extent + 6, m_regionExtent);
+            reset();
+            return;
+        }
+    }
+}
+
+void RegionGrowing::getRegionExtent(int extent[6]) const
+{
+    std::copy(m_regionExtent, m_regionExtent + 6, extent);
+}
+
+void RegionGrowing::setSeed(const int index[3])
+{
+    if (m_seed[0] != index[0] || m_seed[1] != index[1] || m_seed[2] != index[2])
+    {
+        std::copy(index, index + 3, m_seed);
+        reset();
+    }
+}
+
+int RegionGrowing::grow(double lower, double upper)
+{
+    if (!m_input)
+    {
+        return 0;
+    }
+
+    bool resume = m_hasRegion && m_inputMTime == m_input->GetMTime() && lower <= m_lower && upper >= m_upper;
+    if (!resume)
+    {
+        reset();
+    }
+
+    m_lower = lower;
+    m_upper = upper;
+    m_inputMTime = m_input->GetMTime();
+
+    switch (m_input->GetScalarType())
+    {
+        vtkTemplateMacro(grow(static_cast<const VTK_TT*>(m_input->GetScalarPointer()), resume));
+    }
+
+    return m_numberOfVoxels;
+}
+
+bool RegionGrowing::isInRegion(int x, int y, int z) const
+{
+    if (x < m_regionExtent[0] || x > m_regionExtent[1] || y < m_regionExtent[2] || y > m_regionExtent[3] || z < m_regionExtent[4]
+        || z > m_regionExtent[5] || m_mask.isEmpty())
+    {
+        return false;
+    }
+
+    return m_mask.at(getMaskIndex(x, y, z)) == InRegion;
+}
+
+int RegionGrowing::getNumberOfVoxels() const
+{
+    return m_numberOfVoxels;
+}
+
+void RegionGrowing::getRegionBounds(int bounds[6]) const
+{
+    std::copy(m_regionBounds, m_regionBounds + 6, bounds);
+}
+
+vtkSmartPointer<vtkImageData> RegionGrowing::getMaskImage() const
+{
+    vtkSmartPointer<vtkImageData> maskImage = vtkSmartPointer<vtkImageData>::New();
+    if (!m_input)
+    {
+        return maskImage;
+    }
+
+    maskImage->SetExtent(const_cast<int*>(m_regionExtent));
+    maskImage->SetOrigin(m_input->GetOrigin());
+    maskImage->SetSpacing(m_input->GetSpacing());
+    maskImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+
+    unsigned char *pointer = static_cast<unsigned char*>(maskImage->GetScalarPointer());
+    vtkIdType numberOfPoints = maskImage->GetNumberOfPoints();
+    for (vtkIdType i = 0; i < numberOfPoints; i++)
+    {
+        pointer[i] = (i < m_mask.size() && m_mask.at(i) == InRegion) ? 1 : 0;
+    }
+
+    return maskImage;
+}
+
+void RegionGrowing::reset()
+{
+    m_hasRegion = false;
+    m_mask.clear();
+    m_rejectedVoxels.clear();
+    m_numberOfVoxels = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        m_regionBounds[i * 2] = 0;
+        m_regionBounds[i * 2 + 1] = -1;
+    }
+}
+
+int RegionGrowing::getMaskIndex(int x, int y, int z) const
+{
+    int dimensionX = m_regionExtent[1] - m_regionExtent[0] + 1;
+    int dimensionY = m_regionExtent[3] - m_regionExtent[2] + 1;
+    return (x - m_regionExtent[0]) + ((y - m_regionExtent[2]) + (z - m_regionExtent[4]) * dimensionY) * dimensionX;
+}
+
+template <typename T>
+void RegionGrowing::grow(const T *scalars, bool resume)
+{
+    int *inputExtent = m_input->GetExtent();
+    vtkIdType *increments = m_input->GetIncrements();
+    const int *extent = m_regionExtent;
+    int dimensionX = extent[1] - extent[0] + 1;
+    int dimensionY = extent[3] - extent[2] + 1;
+    int dimensionZ = extent[5] - extent[4] + 1;
+    if (dimensionX <= 0 || dimensionY <= 0 || dimensionZ <= 0)
+    {
+        return;
+    }
+
+    // Offset in the scalars of the first voxel of the region extent
+    const T *regionScalars = scalars + (extent[0] - inputExtent[0]) * increments[0] + (extent[2] - inputExtent[2]) * increments[1]
+                           + (extent[4] - inputExtent[4]) * increments[2];
+    auto getValue = [&](int x, int y, int z)
+    {
+        return static_cast<double>(regionScalars[(x - extent[0]) * increments[0] + (y - extent[2]) * increments[1] + (z - extent[4]) * increments[2]]);
+    };
+    auto isInRange = [&](double value)
+    {
+        return value >= m_lower && value <= m_upper;
+    };
+
+    m_seeds.clear();
+
+    if (resume)
+    {
+        // Rejected voxels that are inside the new range become seeds, the others remain rejected
+        int numberOfRejectedVoxels = 0;
+        for (int i = 0; i < m_rejectedVoxels.size(); i++)
+        {
+            int maskIndex = m_rejectedVoxels.at(i);
+            Seed seed;
+            seed.x = extent[0] + maskIndex % dimensionX;
+            seed.y = extent[2] + (maskIndex / dimensionX) % dimensionY;
+            seed.z = extent[4] + maskIndex / (dimensionX * dimensionY);
+
+            if (isInRange(getValue(seed.x, seed.y, seed.z)))
+            {
+                m_mask[maskIndex] = Unvisited;
+                m_seeds.append(seed);
+            }
+            else
+            {
+                m_rejectedVoxels[numberOfRejectedVoxels++] = maskIndex;
+            }
+        }
+        m_rejectedVoxels.resize(numberOfRejectedVoxels);
+    }
+    else
+    {
+        m_hasRegion = true;
+        m_mask.fill(Unvisited, dimensionX * dimensionY * dimensionZ);
+
+        if (m_seed[0] < extent[0] || m_seed[0] > extent[1] || m_seed[1] < extent[2] || m_seed[1] > extent[3] || m_seed[2] < extent[4]
+            || m_seed[2] > extent[5])
+        {
+            return;
+        }
+
+        int seedMaskIndex = getMaskIndex(m_seed[0], m_seed[1], m_seed[2]);
+        if (!isInRange(getValue(m_seed[0], m_seed[1], m_seed[2])))
+        {
+            m_mask[seedMaskIndex] = Rejected;
+            m_rejectedVoxels.append(seedMaskIndex);
+            return;
+        }
+
+        Seed seed;
+        seed.x = m_seed[0];
+        seed.y = m_seed[1];
+        seed.z = m_seed[2];
+        m_seeds.append(seed);
+    }
+
+    unsigned char *mask = m_mask.data();
+
+    // Tests the voxel at the given mask index, which must be unvisited. Returns true if it's in range, otherwise marks it as rejected.
+    auto testVoxel = [&](int maskIndex, int x, int y, int z)
+    {
+        if (isInRange(getValue(x, y, z)))
+        {
+            return true;
+        }
+
+        mask[maskIndex] = Rejected;
+        m_rejectedVoxels.append(maskIndex);
+        return false;
+    };
+
+    // Pushes a seed at the start of each run of unvisited voxels in range of the given row between first and last
+    auto scanRow = [&](int first, int last, int y, int z)
+    {
+        int maskIndex = getMaskIndex(first, y, z);
+        bool previousIsSeeded = false;
+        for (int x = first; x <= last; x++, maskIndex++)
+        {
+            if (mask[maskIndex] == Unvisited && testVoxel(maskIndex, x, y, z))
+            {
+                if (!previousIsSeeded)
+                {
+                    Seed seed;
+                    seed.x = x;
+                    seed.y = y;
+                    seed.z = z;
+                    m_seeds.append(seed);
+                    previousIsSeeded = true;
+                }
+            }
+            else
+            {
+                previousIsSeeded = false;
+            }
+        }
+    };
+
+    while (!m_seeds.isEmpty())
+    {
+        Seed seed = m_seeds.last();
+        m_seeds.removeLast();
+
+        int seedMaskIndex = getMaskIndex(seed.x, seed.y, seed.z);
+        if (mask[seedMaskIndex] != Unvisited)
+        {
+            continue;
+        }
+
+        // Extend the span to the left and to the right
+        int first = seed.x;
+        int maskIndex = seedMaskIndex - 1;
+        while (first > extent[0] && mask[maskIndex] == Unvisited && testVoxel(maskIndex, first - 1, seed.y, seed.z))
+        {
+            first--;
+            maskIndex--;
+        }
+
+        int last = seed.x;
+        maskIndex = seedMaskIndex + 1;
+        while (last < extent[1] && mask[maskIndex] == Unvisited && testVoxel(maskIndex, last + 1, seed.y, seed.z))
+        {
+            last++;
+            maskIndex++;
+        }
+
+        std::fill(mask + getMaskIndex(first, seed.y, seed.z), mask + getMaskIndex(last, seed.y, seed.z) + 1, static_cast<unsigned char>(InRegion));
+        m_numberOfVoxels += last - first + 1;
+
+        // The bounds are empty until the first span is accepted, which may happen in a resumed grow if the seed was rejected before
+        if (m_regionBounds[0] > m_regionBounds[1])
+        {
+            m_regionBounds[0] = first;
+            m_regionBounds[1] = last;
+            m_regionBounds[2] = m_regionBounds[3] = seed.y;
+            m_regionBounds[4] = m_regionBounds[5] = seed.z;
+        }
+        else
+        {
+            m_regionBounds[0] = qMin(m_regionBounds[0], first);
+            m_regionBounds[1] = qMax(m_regionBounds[1], last);
+            m_regionBounds[2] = qMin(m_regionBounds[2], seed.y);
+            m_regionBounds[3] = qMax(m_regionBounds[3], seed.y);
+            m_regionBounds[4] = qMin(m_regionBounds[4], seed.z);
+            m_regionBounds[5] = qMax(m_regionBounds[5], seed.z);
+        }
+
+        // Look for new spans in the neighbouring rows
+        if (seed.y > extent[2])
+        {
+            scanRow(first, last, seed.y - 1, seed.z);
+        }
+        if (seed.y < extent[3])
+        {
+            scanRow(first, last, seed.y + 1, seed.z);
+        }
+        if (seed.z > extent[4])
+        {
+            scanRow(first, last, seed.y, seed.z - 1);
+        }
+        if (seed.z < extent[5])
+        {
+            scanRow(first, last, seed.y, seed.z + 1);
+        }
+    }
+}
+
+} // End namespace udg
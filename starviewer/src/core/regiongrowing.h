@@ -0,0 +1,116 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGREGIONGROWING_H
+#define UDGREGIONGROWING_H
+
+#include <QVector>
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+namespace udg {
+
+/**
+    Grows a region of a vtkImageData from a seed voxel, adding the 6-connected voxels whose value is inside a range.
+
+    The region is grown with a scanline flood fill that reads the scalars of the image directly. It can be confined to a region extent
+    of the image: a region extent with a single slice gives a 2D region and the whole extent gives a volumetric one.
+
+    Voxels that have been tested and rejected at the boundary of the region are remembered. If grow() is called again with a range that
+    contains the previous one, and the input, region extent and seed are the same, the previous region is reused and growing resumes only
+    from those rejected voxels. Otherwise the region is grown from scratch. Only the first scalar component of the image is used.
+  */
+class RegionGrowing {
+public:
+    RegionGrowing();
+    ~RegionGrowing();
+
+    /// Sets the image where the region is grown. By default the region extent is the whole extent of the image.
+    void setInput(vtkImageData *image);
+
+    /// Confines the region to the given extent, which must be inside the extent of the input
+    void setRegionExtent(const int extent[6]);
+    void getRegionExtent(int extent[6]) const;
+
+    /// Sets the index of the seed voxel
+    void setSeed(const int index[3]);
+
+    /// Grows the region with the voxels connected to the seed whose value is between lower and upper, both included.
+    /// Returns the number of voxels of the region, which is 0 if the seed isn't in the range or outside the region extent.
+    int grow(double lower, double upper);
+
+    /// Returns true if the voxel with the given index belongs to the region
+    bool isInRegion(int x, int y, int z) const;
+
+    /// Returns the number of voxels of the region
+    int getNumberOfVoxels() const;
+
+    /// Returns the bounds of the region as an extent. They are only valid if the region is not empty.
+    void getRegionBounds(int bounds[6]) const;
+
+    /// Returns an image with the geometry of the region extent where voxels of the region have value 1 and the others 0
+    vtkSmartPointer<vtkImageData> getMaskImage() const;
+
+private:
+    /// State of each voxel of the region extent in the mask
+    enum VoxelState { Unvisited = 0, InRegion = 1, Rejected = 2 };
+
+    /// Voxel from which a span of the region has to be filled
+    struct Seed {
+        int x;
+        int y;
+        int z;
+    };
+
+    /// Discards the current region
+    void reset();
+
+    /// Returns the index in the mask of the given voxel
+    int getMaskIndex(int x, int y, int z) const;
+
+    /// Grows the region reading the given scalars. If resume is true, growing continues from the rejected voxels of the previous region.
+    template <typename T>
+    void grow(const T *scalars, bool resume);
+
+private:
+    /// The input image
+    vtkSmartPointer<vtkImageData> m_input;
+    /// Modification time of the input when the current region was grown
+    unsigned long m_inputMTime;
+
+    int m_regionExtent[6];
+    int m_seed[3];
+
+    /// Range of the current region
+    double m_lower;
+    double m_upper;
+    /// True if there is a region that can be resumed
+    bool m_hasRegion;
+
+    /// State of the voxels of the region extent
+    QVector<unsigned char> m_mask;
+    /// Mask indices of the rejected voxels at the boundary of the region
+    QVector<int> m_rejectedVoxels;
+    /// Pending seeds, kept to reuse its memory
+    QVector<Seed> m_seeds;
+
+    int m_numberOfVoxels;
+    int m_regionBounds[6];
+};
+
+} // End namespace udg
+
+#endif
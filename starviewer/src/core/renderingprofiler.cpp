@@ -0,0 +1,472 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "renderingprofiler.h"
+
+#include "logging.h"
+
+#include <QFile>
+#include <QTextStream>
+
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkTextActor.h>
+#include <vtkTextProperty.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace udg {
+
+const int RenderingProfiler::FrameHistorySize = 300;
+const int RenderingProfiler::NumberOfHistogramBins = 10;
+
+namespace {
+
+/// Minimum time between updates of the overlay in nanoseconds
+const qint64 OverlayUpdateInterval = 500000000;
+
+/// Returns the histogram bin for the given time in milliseconds
+int getHistogramBin(double time)
+{
+    if (time < 1.0)
+    {
+        return 0;
+    }
+
+    return std::min(1 + static_cast<int>(std::floor(std::log2(time))), RenderingProfiler::NumberOfHistogramBins - 1);
+}
+
+}
+
+RenderingProfiler::RenderingProfiler(vtkRenderWindow *renderWindow, vtkRenderer *renderer, QObject *parent)
+ : QObject(parent), m_renderWindow(renderWindow), m_renderer(renderer), m_enabled(false), m_frameInProgress(false), m_rendererStartTime(0),
+   m_currentRendererTime(0), m_frameStartTime(0), m_nextFrameIndex(0), m_numberOfRecordedFrames(0), m_overlayVisible(false), m_lastOverlayUpdateTime(0)
+{
+    m_callbackCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+    m_callbackCommand->SetCallback(&RenderingProfiler::processEvent);
+    m_callbackCommand->SetClientData(this);
+
+    for (int stage = 0; stage < NumberOfStages; stage++)
+    {
+        m_currentFrameTimes[stage] = 0;
+        m_frameTimes[stage].fill(0.0, FrameHistorySize);
+        m_histograms[stage].fill(0, NumberOfHistogramBins);
+    }
+
+    m_overlay = vtkSmartPointer<vtkTextActor>::New();
+    m_overlay->GetTextProperty()->SetFontFamilyToCourier();
+    m_overlay->GetTextProperty()->SetFontSize(12);
+    m_overlay->GetTextProperty()->SetColor(1.0, 1.0, 0.0);
+    m_overlay->GetTextProperty()->SetBackgroundColor(0.0, 0.0, 0.0);
+    m_overlay->GetTextProperty()->SetBackgroundOpacity(0.6);
+    m_overlay->GetPositionCoordinate()->SetCoordinateSystemToNormalizedViewport();
+    m_overlay->SetPosition(0.02, 0.3);
+
+    m_clock.start();
+}
+
+RenderingProfiler::~RenderingProfiler()
+{
+    setOverlayVisible(false);
+    removeObservers();
+}
+
+void RenderingProfiler::setEnabled(bool enabled)
+{
+    if (enabled == m_enabled || !m_renderWindow || !m_renderer)
+    {
+        return;
+    }
+
+    m_enabled = enabled;
+
+    if (m_enabled)
+    {
+        m_nextFrameIndex = 0;
+        m_numberOfRecordedFrames = 0;
+
+        for (int stage = 0; stage < NumberOfStages; stage++)
+        {
+            m_histograms[stage].fill(0);
+        }
+
+        m_renderWindow->AddObserver(vtkCommand::StartEvent, m_callbackCommand);
+        m_renderWindow->AddObserver(vtkCommand::EndEvent, m_callbackCommand);
+        m_renderer->AddObserver(vtkCommand::StartEvent, m_callbackCommand);
+        m_renderer->AddObserver(vtkCommand::EndEvent, m_callbackCommand);
+
+        for (auto it = m_stageObjects.begin(); it != m_stageObjects.end(); ++it)
+        {
+            observe(it.value());
+        }
+    }
+    else
+    {
+        removeObservers();
+        m_frameInProgress = false;
+    }
+}
+
+bool RenderingProfiler::isEnabled() const
+{
+    return m_enabled;
+}
+
+void RenderingProfiler::setRenderWindow(vtkRenderWindow *renderWindow)
+{
+    setEnabled(false);
+    m_renderWindow = renderWindow;
+}
+
+void RenderingProfiler::setOverlayVisible(bool visible)
+{
+    if (visible == m_overlayVisible || !m_renderer)
+    {
+        return;
+    }
+
+    m_overlayVisible = visible;
+
+    if (m_overlayVisible)
+    {
+        updateOverlay();
+        m_renderer->AddViewProp(m_overlay);
+    }
+    else
+    {
+        m_renderer->RemoveViewProp(m_overlay);
+    }
+}
+
+bool RenderingProfiler::isOverlayVisible() const
+{
+    return m_overlayVisible;
+}
+
+void RenderingProfiler::addStageObject(Stage stage, vtkObject *object)
+{
+    if (!object || m_stageObjects.contains(object))
+    {
+        return;
+    }
+
+    ObservedObject stageObject;
+    stageObject.object = object;
+    stageObject.stage = stage;
+    stageObject.depth = 0;
+    stageObject.startTime = 0;
+
+    if (m_enabled)
+    {
+        observe(stageObject);
+    }
+
+    m_stageObjects.insert(object, stageObject);
+}
+
+void RenderingProfiler::clearStageObjects()
+{
+    foreach (const ObservedObject &stageObject, m_stageObjects)
+    {
+        if (stageObject.object)
+        {
+            stageObject.object->RemoveObservers(vtkCommand::StartEvent, m_callbackCommand);
+            stageObject.object->RemoveObservers(vtkCommand::EndEvent, m_callbackCommand);
+        }
+    }
+
+    m_stageObjects.clear();
+}
+
+int RenderingProfiler::getNumberOfFrames() const
+{
+    return std::min(m_numberOfRecordedFrames, FrameHistorySize);
+}
+
+RenderingProfiler::StageStatistics RenderingProfiler::getStatistics(Stage stage) const
+{
+    StageStatistics statistics = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    int numberOfFrames = getNumberOfFrames();
+
+    if (numberOfFrames == 0)
+    {
+        return statistics;
+    }
+
+    QVector<double> times = m_frameTimes[stage].mid(0, numberOfFrames);
+    statistics.last = m_frameTimes[stage].at((m_nextFrameIndex + FrameHistorySize - 1) % FrameHistorySize);
+
+    double sum = 0.0;
+    foreach (double time, times)
+    {
+        sum += time;
+    }
+    statistics.mean = sum / numberOfFrames;
+
+    std::sort(times.begin(), times.end());
+    statistics.minimum = times.first();
+    statistics.maximum = times.last();
+    statistics.median = times.at(numberOfFrames / 2);
+    statistics.percentile95 = times.at(std::min(static_cast<int>(std::ceil(0.95 * numberOfFrames)) - 1, numberOfFrames - 1));
+
+    return statistics;
+}
+
+QVector<int> RenderingProfiler::getHistogram(Stage stage) const
+{
+    return m_histograms[stage];
+}
+
+QString RenderingProfiler::getSummary() const
+{
+    QString summary = QString("%1 frames (ms)\n%2 %3 %4 %5 %6\n").arg(getNumberOfFrames()).arg("", -24).arg("last", 7).arg("mean", 7).arg("p95", 7)
+                                                                  .arg("max", 7);
+
+    for (int stage = 0; stage < NumberOfStages; stage++)
+    {
+        StageStatistics statistics = getStatistics(static_cast<Stage>(stage));
+        summary += QString("%1 %2 %3 %4 %5\n").arg(getStageName(static_cast<Stage>(stage)), -24).arg(statistics.last, 7, 'f', 2)
+                                              .arg(statistics.mean, 7, 'f', 2).arg(statistics.percentile95, 7, 'f', 2).arg(statistics.maximum, 7, 'f', 2);
+    }
+
+    return summary;
+}
+
+bool RenderingProfiler::saveCsv(const QString &fileName) const
+{
+    QFile file(fileName);
+
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+    {
+        WARN_LOG(QString("Can't write rendering profile to %1").arg(fileName));
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "Frame";
+
+    for (int stage = 0; stage < NumberOfStages; stage++)
+    {
+        out << ";" << getStageName(static_cast<Stage>(stage));
+    }
+
+    out << "\n";
+
+    int numberOfFrames = getNumberOfFrames();
+    // The oldest frame is the next one to be overwritten if the ring buffer is full
+    int firstFrameIndex = numberOfFrames < FrameHistorySize ? 0 : m_nextFrameIndex;
+
+    for (int i = 0; i < numberOfFrames; i++)
+    {
+        int frameIndex = (firstFrameIndex + i) % FrameHistorySize;
+        out << m_numberOfRecordedFrames - numberOfFrames + i;
+
+        for (int stage = 0; stage < NumberOfStages; stage++)
+        {
+            out << ";" << QString::number(m_frameTimes[stage].at(frameIndex), 'f', 3);
+        }
+
+        out << "\n";
+    }
+
+    return true;
+}
+
+QString RenderingProfiler::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+        case PhaseExtraction: return "Phase extraction";
+        case WindowLevel: return "Window level";
+        case Reslice: return "Reslice";
+        case ImageDrawing: return "Image drawing";
+        case ImageMapper: return "Image mapper (total)";
+        case DrawerPrimitives: return "Drawer primitives";
+        case OtherRenderersAndSwap: return "Other renderers + swap";
+        case Frame: return "Frame";
+        case NumberOfStages: break;
+    }
+
+    return QString();
+}
+
+qint64 RenderingProfiler::getCurrentTime() const
+{
+    return m_clock.nsecsElapsed();
+}
+
+void RenderingProfiler::processEvent(vtkObject *caller, unsigned long eventId, void *clientData, void *callData)
+{
+    Q_UNUSED(callData);
+
+    RenderingProfiler *profiler = static_cast<RenderingProfiler*>(clientData);
+    qint64 now = profiler->getCurrentTime();
+
+    if (caller == profiler->m_renderWindow)
+    {
+        if (eventId == vtkCommand::StartEvent)
+        {
+            profiler->startFrame();
+        }
+        else
+        {
+            profiler->endFrame();
+        }
+
+        return;
+    }
+
+    if (!profiler->m_frameInProgress)
+    {
+        return;
+    }
+
+    if (caller == profiler->m_renderer)
+    {
+        if (eventId == vtkCommand::StartEvent)
+        {
+            profiler->m_rendererStartTime = now;
+        }
+        else
+        {
+            profiler->m_currentRendererTime += now - profiler->m_rendererStartTime;
+        }
+
+        return;
+    }
+
+    auto it = profiler->m_stageObjects.find(caller);
+
+    if (it == profiler->m_stageObjects.end())
+    {
+        return;
+    }
+
+    ObservedObject &stageObject = it.value();
+
+    if (eventId == vtkCommand::StartEvent)
+    {
+        if (stageObject.depth++ == 0)
+        {
+            stageObject.startTime = now;
+        }
+    }
+    else if (stageObject.depth > 0 && --stageObject.depth == 0)
+    {
+        profiler->m_currentFrameTimes[stageObject.stage] += now - stageObject.startTime;
+    }
+}
+
+void RenderingProfiler::observe(ObservedObject &stageObject)
+{
+    if (stageObject.object)
+    {
+        stageObject.object->AddObserver(vtkCommand::StartEvent, m_callbackCommand);
+        stageObject.object->AddObserver(vtkCommand::EndEvent, m_callbackCommand);
+        stageObject.depth = 0;
+    }
+}
+
+void RenderingProfiler::removeObservers()
+{
+    if (m_renderWindow)
+    {
+        m_renderWindow->RemoveObservers(vtkCommand::StartEvent, m_callbackCommand);
+        m_renderWindow->RemoveObservers(vtkCommand::EndEvent, m_callbackCommand);
+    }
+
+    if (m_renderer)
+    {
+        m_renderer->RemoveObservers(vtkCommand::StartEvent, m_callbackCommand);
+        m_renderer->RemoveObservers(vtkCommand::EndEvent, m_callbackCommand);
+    }
+
+    foreach (const ObservedObject &stageObject, m_stageObjects)
+    {
+        if (stageObject.object)
+        {
+            stageObject.object->RemoveObservers(vtkCommand::StartEvent, m_callbackCommand);
+            stageObject.object->RemoveObservers(vtkCommand::EndEvent, m_callbackCommand);
+        }
+    }
+}
+
+void RenderingProfiler::startFrame()
+{
+    m_frameInProgress = true;
+    m_frameStartTime = getCurrentTime();
+    m_currentRendererTime = 0;
+
+    for (int stage = 0; stage < NumberOfStages; stage++)
+    {
+        m_currentFrameTimes[stage] = 0;
+    }
+
+    for (auto it = m_stageObjects.begin(); it != m_stageObjects.end(); ++it)
+    {
+        it->depth = 0;
+    }
+}
+
+void RenderingProfiler::endFrame()
+{
+    if (!m_frameInProgress)
+    {
+        return;
+    }
+
+    m_frameInProgress = false;
+
+    qint64 frameTime = getCurrentTime() - m_frameStartTime;
+    qint64 pipelineTime = m_currentFrameTimes[PhaseExtraction] + m_currentFrameTimes[WindowLevel] + m_currentFrameTimes[Reslice];
+    m_currentFrameTimes[ImageDrawing] = std::max<qint64>(m_currentFrameTimes[ImageMapper] - pipelineTime, 0);
+    m_currentFrameTimes[DrawerPrimitives] = std::max<qint64>(m_currentRendererTime - m_currentFrameTimes[ImageMapper], 0);
+    m_currentFrameTimes[OtherRenderersAndSwap] = std::max<qint64>(frameTime - m_currentRendererTime, 0);
+    m_currentFrameTimes[Frame] = frameTime;
+
+    bool isFull = m_numberOfRecordedFrames >= FrameHistorySize;
+
+    for (int stage = 0; stage < NumberOfStages; stage++)
+    {
+        double &slot = m_frameTimes[stage][m_nextFrameIndex];
+
+        if (isFull)
+        {
+            m_histograms[stage][getHistogramBin(slot)]--;
+        }
+
+        slot = m_currentFrameTimes[stage] / 1000000.0;
+        m_histograms[stage][getHistogramBin(slot)]++;
+    }
+
+    m_nextFrameIndex = (m_nextFrameIndex + 1) % FrameHistorySize;
+    m_numberOfRecordedFrames++;
+
+    // The overlay is updated at a limited rate because changing its text has a cost in the next frame
+    if (m_overlayVisible && getCurrentTime() - m_lastOverlayUpdateTime > OverlayUpdateInterval)
+    {
+        updateOverlay();
+    }
+}
+
+void RenderingProfiler::updateOverlay()
+{
+    m_overlay->SetInput(getSummary().trimmed().toLatin1().constData());
+    m_lastOverlayUpdateTime = getCurrentTime();
+}
+
+} // End namespace udg
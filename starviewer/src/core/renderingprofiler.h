@@ -0,0 +1,181 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGRENDERINGPROFILER_H
+#define UDGRENDERINGPROFILER_H
+
+#include <QObject>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+class vtkCallbackCommand;
+class vtkObject;
+class vtkRenderer;
+class vtkRenderWindow;
+class vtkTextActor;
+
+namespace udg {
+
+/**
+    Measures how long each stage of the rendering of a viewer takes in every frame.
+
+    The profiler observes the start and end events of the render window, of the renderer and of the objects added to each stage with addStageObject().
+    The time of a stage in a frame is the sum of the time spent by its objects while the render window was rendering that frame. Stages that can't be
+    observed directly are derived from the others:
+    - ImageDrawing: time of the image mappers not spent in phase extraction, window level or reslice.
+    - DrawerPrimitives: time of the renderer not spent in the image mappers, i.e. drawer primitives and annotations.
+    - OtherRenderersAndSwap: time of the render window not spent in the renderer.
+
+    The times of the last FrameHistorySize frames are kept to compute statistics and a histogram of each stage. The statistics can be shown in an overlay
+    on the renderer, written to the log or saved as CSV.
+
+    Nothing is observed while the profiler is disabled, so it has no overhead in that state.
+  */
+class RenderingProfiler : public QObject {
+Q_OBJECT
+public:
+    enum Stage { PhaseExtraction, WindowLevel, Reslice, ImageDrawing, ImageMapper, DrawerPrimitives, OtherRenderersAndSwap, Frame, NumberOfStages };
+
+    /// Statistics of a stage in the recorded frames, in milliseconds
+    struct StageStatistics {
+        double last;
+        double mean;
+        double minimum;
+        double maximum;
+        double median;
+        double percentile95;
+    };
+
+    /// Number of frames kept to compute statistics
+    static const int FrameHistorySize;
+    /// Number of bins of the histograms. Bin i counts frame times in [2^(i-1), 2^i) ms, except the first one, which starts at 0, and the last one,
+    /// which has no upper limit.
+    static const int NumberOfHistogramBins;
+
+    RenderingProfiler(vtkRenderWindow *renderWindow, vtkRenderer *renderer, QObject *parent = nullptr);
+    ~RenderingProfiler();
+
+    /// Enables or disables the profiler. Recorded frames are cleared when it is enabled.
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    /// Sets the render window whose frames are measured. The profiler is disabled if it was enabled.
+    void setRenderWindow(vtkRenderWindow *renderWindow);
+
+    /// Enables or disables the overlay with the statistics of the last frames
+    void setOverlayVisible(bool visible);
+    bool isOverlayVisible() const;
+
+    /// Adds an object whose executions are accounted to the given stage. It must invoke start and end events around them.
+    /// ImageMapper objects should include in their executions those of the PhaseExtraction, WindowLevel and Reslice objects.
+    void addStageObject(Stage stage, vtkObject *object);
+    /// Removes all the stage objects
+    void clearStageObjects();
+
+    /// Returns the number of recorded frames
+    int getNumberOfFrames() const;
+
+    /// Returns the statistics of the given stage in the recorded frames
+    StageStatistics getStatistics(Stage stage) const;
+
+    /// Returns the histogram of the given stage in the recorded frames
+    QVector<int> getHistogram(Stage stage) const;
+
+    /// Returns a text with the statistics of all the stages
+    QString getSummary() const;
+
+    /// Saves the times of each stage in every recorded frame in CSV format. Returns false if the file can't be written.
+    bool saveCsv(const QString &fileName) const;
+
+    /// Returns the name of the given stage
+    static QString getStageName(Stage stage);
+
+protected:
+    /// Returns the time elapsed since the profiler was created in nanoseconds
+    virtual qint64 getCurrentTime() const;
+
+private:
+    /// Object of a stage and the state of its current execution
+    struct ObservedObject {
+        vtkWeakPointer<vtkObject> object;
+        Stage stage;
+        /// Nesting level of its start and end events
+        int depth;
+        /// Time of the outermost start event
+        qint64 startTime;
+    };
+
+    /// Observer callback for the start and end events of all the observed objects
+    static void processEvent(vtkObject *caller, unsigned long eventId, void *clientData, void *callData);
+
+    /// Adds observers to the given stage object
+    void observe(ObservedObject &stageObject);
+    /// Removes the observers of all the observed objects
+    void removeObservers();
+
+    /// Called when a frame starts
+    void startFrame();
+    /// Called when a frame ends, records the times of the frame
+    void endFrame();
+
+    /// Updates the text of the overlay
+    void updateOverlay();
+
+private:
+    vtkWeakPointer<vtkRenderWindow> m_renderWindow;
+    vtkWeakPointer<vtkRenderer> m_renderer;
+
+    bool m_enabled;
+
+    /// Observer for the render window, the renderer and the stage objects
+    vtkSmartPointer<vtkCallbackCommand> m_callbackCommand;
+    /// Objects added to the stages, observed only while the profiler is enabled
+    QHash<vtkObject*, ObservedObject> m_stageObjects;
+
+    /// Clock for all the measures
+    QElapsedTimer m_clock;
+    /// True while the render window is rendering a frame
+    bool m_frameInProgress;
+    /// Nanoseconds spent in each measured stage in the current frame
+    qint64 m_currentFrameTimes[NumberOfStages];
+    /// Start time and nanoseconds spent by the renderer in the current frame
+    qint64 m_rendererStartTime;
+    qint64 m_currentRendererTime;
+    /// Start time of the current frame
+    qint64 m_frameStartTime;
+
+    /// Times of the recorded frames in milliseconds for each stage, used as ring buffers
+    QVector<double> m_frameTimes[NumberOfStages];
+    /// Position of the next frame in the ring buffers
+    int m_nextFrameIndex;
+    /// Total number of frames recorded since the profiler was enabled
+    int m_numberOfRecordedFrames;
+    /// Histograms of the recorded frames for each stage
+    QVector<int> m_histograms[NumberOfStages];
+
+    /// Overlay that shows the statistics
+    vtkSmartPointer<vtkTextActor> m_overlay;
+    bool m_overlayVisible;
+    /// Time of the last update of the overlay
+    qint64 m_lastOverlayUpdateTime;
+};
+
+} // End namespace udg
+
+#endif
@@ -15,11 +15,13 @@
 #include "roidata.h"
 
 #include <QtCore/qmath.h>
-#include <cfloat>
+
+#include <algorithm>
 
 namespace udg {
 
 ROIData::ROIData()
+ : m_percentilesEnabled(false), m_histogramMinimum(0.0), m_histogramBinWidth(1.0)
 {
     clear();
 }
@@ -30,11 +32,15 @@ ROIData::~ROIData()
 
 void ROIData::clear()
 {
-    m_voxels.clear();
-    m_statisticsAreOutdated = false;
-    m_mean = 0.0;
-    m_standardDeviation = 0.0;
+    m_numberOfVoxels = 0;
+    m_sum = 0.0;
+    m_runningMean = 0.0;
+    m_sumOfSquaredDeviations = 0.0;
     m_maximum = 0.0;
+    m_minimum = 0.0;
+    m_values.clear();
+    m_valuesAreSorted = true;
+    m_histogram.fill(0);
     m_units = "";
     m_modality = "";
 }
@@ -43,121 +49,193 @@ void ROIData::addVoxel(const Voxel &voxel)
 {
     if (!voxel.isEmpty())
     {
-        m_voxels << voxel;
-        m_statisticsAreOutdated = true;
+        addValue(voxel.getComponent(0));
     }
 }
 
-double ROIData::getMean()
+void ROIData::addValue(double value)
 {
-    computeStatistics();
-    return m_mean;
+    if (m_numberOfVoxels == 0)
+    {
+        m_maximum = value;
+        m_minimum = value;
+    }
+    else
+    {
+        m_maximum = qMax(m_maximum, value);
+        m_minimum = qMin(m_minimum, value);
+    }
+
+    m_numberOfVoxels++;
+    m_sum += value;
+
+    double deviation = value - m_runningMean;
+    m_runningMean += deviation / m_numberOfVoxels;
+    m_sumOfSquaredDeviations += deviation * (value - m_runningMean);
+
+    if (m_percentilesEnabled)
+    {
+        m_values.append(value);
+        m_valuesAreSorted = false;
+    }
+
+    if (!m_histogram.isEmpty())
+    {
+        // Clamped as a double so that values far out of the range don't overflow
+        double bin = qBound(0.0, (value - m_histogramMinimum) / m_histogramBinWidth, m_histogram.size() - 1.0);
+        m_histogram[static_cast<int>(bin)]++;
+    }
 }
 
-double ROIData::getStandardDeviation()
+void ROIData::add(const ROIData &roiData)
 {
-    computeStatistics();
-    return m_standardDeviation;
+    if (roiData.m_numberOfVoxels == 0)
+    {
+        return;
+    }
+
+    if (m_numberOfVoxels == 0)
+    {
+        m_maximum = roiData.m_maximum;
+        m_minimum = roiData.m_minimum;
+    }
+    else
+    {
+        m_maximum = qMax(m_maximum, roiData.m_maximum);
+        m_minimum = qMin(m_minimum, roiData.m_minimum);
+    }
+
+    // Combine the sums of squared deviations of both sets (Chan et al.)
+    int numberOfVoxels = m_numberOfVoxels + roiData.m_numberOfVoxels;
+    double deviation = roiData.m_runningMean - m_runningMean;
+    m_sumOfSquaredDeviations += roiData.m_sumOfSquaredDeviations + deviation * deviation * m_numberOfVoxels * roiData.m_numberOfVoxels / numberOfVoxels;
+    m_runningMean += deviation * roiData.m_numberOfVoxels / numberOfVoxels;
+    m_numberOfVoxels = numberOfVoxels;
+    m_sum += roiData.m_sum;
+
+    if (m_percentilesEnabled)
+    {
+        m_values += roiData.m_values;
+        m_valuesAreSorted = false;
+    }
+
+    if (!m_histogram.isEmpty() && m_histogram.size() == roiData.m_histogram.size() && m_histogramMinimum == roiData.m_histogramMinimum
+        && m_histogramBinWidth == roiData.m_histogramBinWidth)
+    {
+        for (int i = 0; i < m_histogram.size(); i++)
+        {
+            m_histogram[i] += roiData.m_histogram.at(i);
+        }
+    }
 }
 
-double ROIData::getMaximum()
+int ROIData::getNumberOfVoxels() const
 {
-    computeStatistics();
-    return m_maximum;
+    return m_numberOfVoxels;
 }
 
-double ROIData::getSum()
+double ROIData::getMean() const
 {
-    computeStatistics();
-    return m_sum;
+    if (m_numberOfVoxels == 0)
+    {
+        return 0.0;
+    }
+
+    return m_sum / m_numberOfVoxels;
 }
 
-void ROIData::setUnits(const QString &units)
+double ROIData::getStandardDeviation() const
 {
-    m_units = units;
+    if (m_numberOfVoxels == 0)
+    {
+        return 0.0;
+    }
+
+    return qSqrt(m_sumOfSquaredDeviations / m_numberOfVoxels);
 }
 
-QString ROIData::getUnits() const
+double ROIData::getMaximum() const
 {
-    return m_units;
+    return m_maximum;
 }
 
-void ROIData::setModality(const QString &modality)
+double ROIData::getMinimum() const
 {
-    m_modality = modality;
+    return m_minimum;
 }
 
-QString ROIData::getModality() const
+double ROIData::getSum() const
 {
-    return m_modality;
+    return m_sum;
 }
 
-void ROIData::computeStatistics()
+void ROIData::setPercentilesEnabled(bool enabled)
 {
-    if (!m_statisticsAreOutdated)
+    m_percentilesEnabled = enabled;
+
+    if (!m_percentilesEnabled)
     {
-        return;
+        m_values.clear();
+        m_valuesAreSorted = true;
     }
-
-    computeMean();
-    computeStandardDeviation();
-    computeMaximum();
-    computeSum();
-
-    m_statisticsAreOutdated = false;
 }
 
-void ROIData::computeMean()
+bool ROIData::arePercentilesEnabled() const
 {
-    m_mean = 0.0;
-    foreach (const Voxel &voxel, m_voxels)
-    {
-        m_mean += voxel.getComponent(0);
-    }
-
-    m_mean = m_mean / m_voxels.size();
+    return m_percentilesEnabled;
 }
 
-void ROIData::computeStandardDeviation()
+double ROIData::getPercentile(double percentile)
 {
-    m_standardDeviation = 0.0;
-    QList<double> deviations;
-    foreach (const Voxel &voxel, m_voxels)
+    if (m_values.isEmpty())
     {
-        double individualDeviation = voxel.getComponent(0) - m_mean;
-        deviations << (individualDeviation * individualDeviation);
+        return 0.0;
     }
 
-    foreach (double deviation, deviations)
+    if (!m_valuesAreSorted)
     {
-        m_standardDeviation += deviation;
+        std::sort(m_values.begin(), m_values.end());
+        m_valuesAreSorted = true;
     }
 
-    m_standardDeviation /= deviations.size();
-    m_standardDeviation = qSqrt(m_standardDeviation);
+    double rank = qBound(0.0, percentile, 100.0) / 100.0 * (m_values.size() - 1);
+    int lowerRank = static_cast<int>(rank);
+    int upperRank = qMin(lowerRank + 1, m_values.size() - 1);
+    double fraction = rank - lowerRank;
+
+    return m_values.at(lowerRank) + fraction * (m_values.at(upperRank) - m_values.at(lowerRank));
 }
 
-void ROIData::computeMaximum()
+void ROIData::setHistogramBins(int numberOfBins, double minimum, double maximum)
 {
-    m_maximum = -DBL_MAX;
+    m_histogram.fill(0, qMax(numberOfBins, 0));
+    m_histogramMinimum = minimum;
+    m_histogramBinWidth = numberOfBins > 0 && maximum > minimum ? (maximum - minimum) / numberOfBins : 1.0;
+}
 
-    foreach (const Voxel &voxel, m_voxels)
-    {
-        double value = voxel.getComponent(0);
-        if (value > m_maximum)
-        {
-            m_maximum = value;
-        }
-    }
+QVector<int> ROIData::getHistogram() const
+{
+    return m_histogram;
 }
 
-void ROIData::computeSum()
+void ROIData::setUnits(const QString &units)
 {
-    m_sum = 0.0;
-    foreach (const Voxel &voxel, m_voxels)
-    {
-        m_sum += voxel.getComponent(0);
-    }
+    m_units = units;
+}
+
+QString ROIData::getUnits() const
+{
+    return m_units;
+}
+
+void ROIData::setModality(const QString &modality)
+{
+    m_modality = modality;
+}
+
+QString ROIData::getModality() const
+{
+    return m_modality;
 }
 
 } // End namespace udg
@@ -18,11 +18,16 @@
 #include "voxel.h"
 
 #include <QString>
+#include <QVector>
 
 namespace udg {
 
 /**
-    Class to save voxel data contained in a ROI and compute statistics from it.
+    Class to compute statistics from the voxel data contained in a ROI.
+    Voxel values are not stored: mean, variance, maximum, minimum and sum are accumulated as values are added
+    (the variance with Welford's algorithm), so the cost of adding a value is constant and doesn't allocate memory.
+    Values are only kept if percentiles are enabled. A histogram of the values can be accumulated too if its bins are set before adding them.
+    Without voxels all the statistics are 0.
     Currently it only takes into account the first component of the voxel,
     i.e. if the voxel is an RGB color voxel, it only will take into account the red channel
  */
@@ -37,11 +42,37 @@ public:
     /// Adds a voxel unless Voxel::isEmpty() is true
     void addVoxel(const Voxel &voxel);
 
-    /// Gets the mean/standard deviation/maximum corresponding to the current voxels
-    double getMean();
-    double getStandardDeviation();
-    double getMaximum();
-    double getSum();
+    /// Adds the value of a voxel
+    void addValue(double value);
+
+    /// Adds all the voxels of the given ROI data, as if they had been added one by one. Units and modality are not modified.
+    /// Histograms are only merged if both have the same bins.
+    void add(const ROIData &roiData);
+
+    /// Returns the number of voxels added
+    int getNumberOfVoxels() const;
+
+    /// Gets the mean/standard deviation/maximum/minimum/sum corresponding to the current voxels
+    double getMean() const;
+    double getStandardDeviation() const;
+    double getMaximum() const;
+    double getMinimum() const;
+    double getSum() const;
+
+    /// Enables or disables keeping the added values to compute percentiles. It must be enabled before adding the values. Disabled by default.
+    void setPercentilesEnabled(bool enabled);
+    bool arePercentilesEnabled() const;
+
+    /// Returns the given percentile (between 0 and 100) of the current voxels, linearly interpolated between the closest ranks.
+    /// Returns 0 if percentiles are not enabled or there are no voxels.
+    double getPercentile(double percentile);
+
+    /// Sets the histogram to numberOfBins bins of the same width in [minimum, maximum]. Values out of the range are counted in the first or last bin.
+    /// It must be set before adding the values. With 0 bins, which is the default, no histogram is accumulated.
+    void setHistogramBins(int numberOfBins, double minimum, double maximum);
+
+    /// Returns the histogram of the current voxels, empty if its bins haven't been set
+    QVector<int> getHistogram() const;
 
     /// Sets/gets the units of the voxels of this ROI
     void setUnits(const QString &units);
@@ -52,33 +83,27 @@ public:
     QString getModality() const;
 
 private:
-    /// Computes all statistics data if needed
-    void computeStatistics();
-
-    /// Computes voxels mean
-    void computeMean();
+    /// Number of voxels added
+    int m_numberOfVoxels;
 
-    /// Computes voxels standard deviation. Requires mean to be computed before, as it uses the m_mean value
-    void computeStandardDeviation();
-
-    /// Computes voxels maximum value
-    void computeMaximum();
-
-    /// Computes the sum of the voxel values.
-    void computeSum();
-
-private:
-    /// The container of the ROI voxels
-    QVector<Voxel> m_voxels;
-    
-    /// Statistic data members
-    double m_mean;
-    double m_standardDeviation;
-    double m_maximum;
+    /// Running statistics. Mean is computed from the sum to get the same result as a two-pass computation,
+    /// the running mean is only used to update the sum of squared deviations
     double m_sum;
-
-    /// Used to control whether the statistics data has to be computed or not when requested
-    bool m_statisticsAreOutdated;
+    double m_runningMean;
+    double m_sumOfSquaredDeviations;
+    double m_maximum;
+    double m_minimum;
+
+    /// Added values, only kept when percentiles are enabled
+    bool m_percentilesEnabled;
+    QVector<double> m_values;
+    /// True when m_values is sorted
+    bool m_valuesAreSorted;
+
+    /// Histogram of the added values, only accumulated when it has bins
+    QVector<int> m_histogram;
+    double m_histogramMinimum;
+    double m_histogramBinWidth;
     
     /// Additional optional information of the ROI regarding the units of the voxels and their modality
     QString m_units;
@@ -14,14 +14,12 @@
 
 #include "roitool.h"
 #include "q2dviewer.h"
-#include "logging.h"
+#include "contourrasterizer.h"
 #include "drawer.h"
 #include "drawerpolygon.h"
 #include "drawertext.h"
 #include "image.h"
-#include "mathtools.h"
 #include "areameasurecomputer.h"
-#include "voxel.h"
 #include "roidata.h"
 #include "roidataprinter.h"
 #include "petctfusionroidataprinter.h"
@@ -29,14 +27,31 @@
 #include "nmroidataprinter.h"
 #include "nmctfusionroidataprinter.h"
 #include "sliceorientedvolumepixeldata.h"
+#include "volumepixeldata.h"
 
 #include <QApplication>
 
+#include <vtkImageData.h>
+#include <vtkPoints.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
 
 namespace udg {
 
+namespace {
+
+/// Adds to roiData the values of the given number of voxels of a span, starting at pointer and separated by increment scalars
+template <typename T>
+void addSpanValues(const T *pointer, vtkIdType increment, int numberOfVoxels, ROIData &roiData)
+{
+    for (int i = 0; i < numberOfVoxels; i++, pointer += increment)
+    {
+        roiData.addValue(*pointer);
+    }
+}
+
+}
+
 ROITool::ROITool(QViewer *viewer, QObject *parent)
  : MeasurementTool(viewer, parent), m_roiPolygon(0)
 {
@@ -68,46 +83,7 @@ QMap<int, ROIData> ROITool::computeROIData()
     auto *pixelDataOrientedRoiPolyData = transformFilter->GetOutput();
     // Pixel data oriented because it's not really slice oriented: still needs to permute axes
 
-    // To compute the voxels inside the polygon we'll use the sweep line algorithm approach
-    // tracing a set of lines within the bounds of the drawn polygon. Upon the resulting intersections between polygon segments and sweep lines
-    // we will be able to compute which points of the line are inside of the polygon and get the corresponding voxel values.
-    // The sweep lines will be horizontal and swept down in vertical direction
-    double bounds[6];
-    pixelDataOrientedRoiPolyData->GetBounds(bounds);
-
-    int xIndex, yIndex, zIndex;
-    pixelData.getOrthogonalPlane().getXYZIndexes(xIndex, yIndex, zIndex);
-
-    // Building up the initial sweep line
-    // We'll have to add some extra space to the x/y bounds just to help the sweep line algorithm work better
-    // when the vertices and segments are just on the bound lines
-    Vector3 spacing = pixelData.getSpacing();   // This is really slice oriented
-    double xMargin = spacing.x * 1.1;
-    double yMargin = spacing.y * 1.1;
-    
-    // First point of the sweep line, will be at the minimum x, y, z bounds of the polygon
-    Point3D sweepLineBeginPoint;
-    sweepLineBeginPoint[xIndex] = bounds[xIndex * 2] - xMargin;
-    sweepLineBeginPoint[yIndex] = bounds[yIndex * 2] - yMargin;
-    sweepLineBeginPoint[zIndex] = bounds[zIndex * 2];
-    
-    // Second point of the sweep line, will be the same as the first but with the maximum x bounds of the polygon so it will trace an horizontal line
-    Point3D sweepLineEndPoint;
-    sweepLineEndPoint[xIndex] = bounds[xIndex * 2 + 1] + xMargin;
-    sweepLineEndPoint[yIndex] = bounds[yIndex * 2] - yMargin;
-    sweepLineEndPoint[zIndex] = bounds[zIndex * 2];
-
-    // The ending height of the sweep line will be at the maximum y bounds of the polygon
-    double verticalLimit = bounds[yIndex * 2 + 1] + yMargin;
-
-    // Build segments
-    QList<Line3D> segments;
-    auto *points = pixelDataOrientedRoiPolyData->GetPoints();
-    for (int i = 0; i < points->GetNumberOfPoints() - 1; i++)
-    {
-        segments.append(Line3D(points->GetPoint(i), points->GetPoint(i+1)));
-    }
-    segments.append(Line3D(points->GetPoint(points->GetNumberOfPoints() - 1), points->GetPoint(0)));
+    vtkPoints *points = pixelDataOrientedRoiPolyData->GetPoints();
 
     // Compute the ROI data corresponding for each input
     QMap<int, ROIData> roiDataMap;
@@ -116,7 +92,15 @@ QMap<int, ROIData> ROITool::computeROIData()
         // Compute the voxel values inside of the polygon if the input is visible and the images are monochrome
         if (m_2DViewer->isInputVisible(i) && !m_2DViewer->getInput(i)->getImage(0)->getPhotometricInterpretation().isColor())
         {
-            ROIData roiData = computeVoxelValues(segments, sweepLineBeginPoint, sweepLineEndPoint, verticalLimit, i);
+            ROIData roiData;
+            // We get the pixel data to obtain voxels values from
+            auto inputPixelData = m_2DViewer->getCurrentPixelDataFromInput(i);
+            if (inputPixelData.getVolumePixelData() && inputPixelData.getVolumePixelData()->getVtkData())
+            {
+                int inputXIndex, inputYIndex, inputZIndex;
+                inputPixelData.getOrthogonalPlane().getXYZIndexes(inputXIndex, inputYIndex, inputZIndex);
+                roiData = computeVoxelValues(points, inputPixelData.getVolumePixelData()->getVtkData(), inputXIndex, inputYIndex, inputZIndex);
+            }
             
             // Set additional information of the ROI data
             roiData.setUnits(m_2DViewer->getInput(i)->getPixelUnits());
@@ -129,140 +113,54 @@ QMap<int, ROIData> ROITool::computeROIData()
     return roiDataMap;
 }
 
-ROIData ROITool::computeVoxelValues(const QList<Line3D> &polygonSegments, Point3D sweepLineBeginPoint, Point3D sweepLineEndPoint, double sweepLineEnd, int inputNumber)
+ROIData ROITool::computeVoxelValues(vtkPoints *points, vtkImageData *image, int xIndex, int yIndex, int zIndex)
 {
-    // We get the pixel data to obtain voxels values from
-    auto pixelData = m_2DViewer->getCurrentPixelDataFromInput(inputNumber);
-    
-    OrthogonalPlane currentView = pixelData.getOrthogonalPlane();
-    int yIndex = currentView.getYIndex();
-
-    double verticalSpacingIncrement = pixelData.getSpacing().y; // slice oriented
-
-    // ROI voxel data to be obtained from the sweep line
     ROIData roiData;
-    while (sweepLineBeginPoint.at(yIndex) <= sweepLineEnd)
+
+    int numberOfPoints = points->GetNumberOfPoints();
+    if (numberOfPoints < 3)
     {
-        // We get the intersections bewteen ROI segments and current sweep line
-        QList<double*> intersectionList = getIntersectionPoints(polygonSegments, Line3D(sweepLineBeginPoint, sweepLineEndPoint), currentView);
-
-        // Adding the voxels from the current intersections of the current sweep line to the voxel values list
-        addVoxelsFromIntersections(intersectionList, currentView, pixelData, roiData);
-        
-        // Shift the sweep line the corresponding space in vertical direction
-        sweepLineBeginPoint[yIndex] += verticalSpacingIncrement;
-        sweepLineEndPoint[yIndex] += verticalSpacingIncrement;
+        return roiData;
     }
 
-    return roiData;
-}
-
-QList<int> ROITool::getIndexOfSegmentsCrossingAtHeight(const QList<Line3D> &segments, double height, int heightIndex)
-{
-    QList<int> intersectedSegmentsIndexList;
+    double *origin = image->GetOrigin();
+    double *spacing = image->GetSpacing();
+    int *extent = image->GetExtent();
+    vtkIdType *increments = image->GetIncrements();
 
-    for (int i = 0; i < segments.count(); ++i)
+    int slice = qRound((points->GetPoint(0)[zIndex] - origin[zIndex]) / spacing[zIndex]);
+    if (slice < extent[zIndex * 2] || slice > extent[zIndex * 2 + 1])
     {
-        if ((height <= segments.at(i).getFirstPoint().at(heightIndex) && height >= segments.at(i).getSecondPoint().at(heightIndex))
-        || (height >= segments.at(i).getFirstPoint().at(heightIndex) && height <= segments.at(i).getSecondPoint().at(heightIndex)))
-        {
-            intersectedSegmentsIndexList << i;
-        }
+        return roiData;
     }
 
-    return intersectedSegmentsIndexList;
-}
-
-QList<double*> ROITool::getIntersectionPoints(const QList<Line3D> &polygonSegments, const Line3D &sweepLine, const OrthogonalPlane &view)
-{
-    QList<double*> intersectionPoints;
-    int sortIndex = view.getXIndex();
-    int heightIndex = view.getYIndex();
-    
-    QList<int> indexListOfSegmentsToIntersect = getIndexOfSegmentsCrossingAtHeight(polygonSegments, sweepLine.getFirstPoint().at(heightIndex), heightIndex);
-    foreach (int segmentIndex, indexListOfSegmentsToIntersect)
+    QVector<QPointF> contour(numberOfPoints);
+    for (int i = 0; i < numberOfPoints; i++)
     {
-        int intersectionState;
-        double *foundPoint = MathTools::infiniteLinesIntersection(polygonSegments.at(segmentIndex).getFirstPoint().getAsDoubleArray(),
-                                                                    polygonSegments.at(segmentIndex).getSecondPoint().getAsDoubleArray(),
-                                                                    sweepLine.getFirstPoint().getAsDoubleArray(), sweepLine.getSecondPoint().getAsDoubleArray(),
-                                                                    intersectionState);
-        if (intersectionState == MathTools::LinesIntersect)
-        {
-            // Must sort intersections horizontally in order to be able to get voxels inside polygon correctly
-            bool found = false;
-            int i = 0;
-            while (!found && i < intersectionPoints.count())
-            {
-                if (foundPoint[sortIndex] > intersectionPoints.at(i)[sortIndex])
-                {
-                    intersectionPoints.insert(i, foundPoint);
-                    found = true;
-                }
-                else
-                {
-                    ++i;
-                }
-            }
-            // If not found, it means it is the greatest point and must be placed at the end
-            if (!found)
-            {
-                intersectionPoints << foundPoint;
-            }
-        }
+        double *point = points->GetPoint(i);
+        contour[i] = QPointF(point[xIndex], point[yIndex]);
     }
 
-    return intersectionPoints;
-}
+    double planeOrigin[2] = { origin[xIndex], origin[yIndex] };
+    double planeSpacing[2] = { spacing[xIndex], spacing[yIndex] };
+    int planeExtent[4] = { extent[xIndex * 2], extent[xIndex * 2 + 1], extent[yIndex * 2], extent[yIndex * 2 + 1] };
 
-void ROITool::addVoxelsFromIntersections(const QList<double*> &intersectionPoints, const OrthogonalPlane &view, SliceOrientedVolumePixelData &pixelData, ROIData &roiData)
-{
-    if (MathTools::isEven(intersectionPoints.count()))
+    foreach (const ContourRasterizer::Span &span, ContourRasterizer::getSpans(contour, planeOrigin, planeSpacing, planeExtent))
     {
-        int scanDirectionIndex = view.getXIndex();
-        double scanDirectionIncrement = pixelData.getSpacing().x;   // slice oriented
+        int spanStart[3];
+        spanStart[xIndex] = span.firstColumn;
+        spanStart[yIndex] = span.row;
+        spanStart[zIndex] = slice;
+        void *spanPointer = image->GetScalarPointer(spanStart);
 
-        int limit = intersectionPoints.count() / 2;
-        for (int i = 0; i < limit; ++i)
+        switch (image->GetScalarType())
         {
-            double *firstIntersection = intersectionPoints.at(i * 2);
-            double *secondIntersection = intersectionPoints.at(i * 2 + 1);
-            // First we check which will be the direction of the scan line
-            Point3D currentScanLinePoint;
-            double scanLineEnd;
-            if (firstIntersection[scanDirectionIndex] <= secondIntersection[scanDirectionIndex])
-            {
-                for (int i = 0; i < 3; ++i)
-                {
-                    currentScanLinePoint[i] = firstIntersection[i];
-                }
-                scanLineEnd = secondIntersection[scanDirectionIndex];
-            }
-            else
-            {
-                for (int i = 0; i < 3; ++i)
-                {
-                    currentScanLinePoint[i] = secondIntersection[i];
-                }
-                scanLineEnd = firstIntersection[scanDirectionIndex];
-            }
-            // Then we scan and get the voxels along the line
-            while (currentScanLinePoint.at(scanDirectionIndex) <= scanLineEnd)
-            {
-                // currentScanLinePoint is pixel data oriented
-                double pixelDataOrientedPoint[4] = { currentScanLinePoint[0], currentScanLinePoint[1], currentScanLinePoint[2], 1.0 };
-                double worldPoint[4];
-                pixelData.getDataToWorldMatrix()->MultiplyPoint(pixelDataOrientedPoint, worldPoint);
-                Vector3 voxelCoordinate(worldPoint);
-                roiData.addVoxel(pixelData.getVoxelValue(voxelCoordinate));
-                currentScanLinePoint[scanDirectionIndex] += scanDirectionIncrement;
-            }
+            vtkTemplateMacro(addSpanValues(static_cast<const VTK_TT*>(spanPointer), increments[xIndex], span.lastColumn - span.firstColumn + 1,
+                                           roiData));
         }
     }
-    else
-    {
-        DEBUG_LOG(QString("EL NOMBRE D'INTERSECCIONS ENTRE EL RAIG I LA ROI ÉS IMPARELL!!: %1").arg(intersectionPoints.count()));
-    }
+
+    return roiData;
 }
 
 void ROITool::printData()
@@ -17,8 +17,11 @@
 
 #include "measurementtool.h"
 #include "volume.h"
-#include "line3d.h"
 #include <QPointer>
+#include <QVector>
+
+class vtkImageData;
+class vtkPoints;
 
 namespace udg {
 
@@ -26,7 +29,6 @@ class DrawerPolygon;
 class DrawerText;
 class ROIData;
 class AbstractROIDataPrinter;
-class SliceOrientedVolumePixelData;
 
 /**
     Tool pare per totes aquelles tools destinades a crear ROIs.
@@ -50,10 +52,17 @@ protected:
     void printData();
 
     /// Mètode que genera el text a mostrar
-    QString getAnnotation();
+    virtual QString getAnnotation();
     /// Mètode per assignar propietats de posició al text
     virtual void setTextPosition(DrawerText *text);
 
+protected:
+    /// Computes the statistics of the voxel values of the image contained inside the polygon with the given points in pixel data space.
+    /// xIndex, yIndex and zIndex give the slice oriented axes and the slice is the one of the first point. The polygon is rasterized into
+    /// row spans with ContourRasterizer, so a voxel is inside when its center is, and the values of the spans are read directly from the image
+    /// and accumulated in the returned ROIData.
+    static ROIData computeVoxelValues(vtkPoints *points, vtkImageData *image, int xIndex, int yIndex, int zIndex);
+
 protected:
     /// Polígon que defineix la ROI
     QPointer<DrawerPolygon> m_roiPolygon;
@@ -62,20 +71,6 @@ private:
     /// Returns a map of ROIData for each input corresponding to the current ROI polygon
     /// The key is the index of the input on the viewer corresponding to the mapped ROIData
     QMap<int, ROIData> computeROIData();
-    
-    /// Computes the voxel values contained inside polygonSegments corresponding to inputNumber volume. It will use the sweepLine algorithm, 
-    /// begining with the line defined with the given points and will end at sweepLineEnd height and returns them in a ROIData object
-    ROIData computeVoxelValues(const QList<Line3D> &polygonSegments, Point3D sweepLineBeginPoint, Point3D sweepLineEndPoint, double sweepLineEnd, int inputNumber);
-    
-    /// Returns a list with the indices of the corresponding segments of the given list which crosses the given height, that is, those segments
-    /// which its initial and end point are between the specified heigh on the heightIndex
-    QList<int> getIndexOfSegmentsCrossingAtHeight(const QList<Line3D> &segments, double height, int heightIndex);
-
-    /// Gets the points that intersect with polygonSegments and the given sweepLine and orders them by the xIndex of view
-    QList<double*> getIntersectionPoints(const QList<Line3D> &polygonSegments, const Line3D &sweepLine, const OrthogonalPlane &view);
-
-    /// Adds the voxels that are in the path of the intersection points to the given ROIData
-    void addVoxelsFromIntersections(const QList<double*> &intersectionPoints, const OrthogonalPlane &view, SliceOrientedVolumePixelData &pixelData, ROIData &roiData);
 
     /// Returns the appropiate ROIDataPrinter for the given roi data
     AbstractROIDataPrinter* getROIDataPrinter(const QMap<int, ROIData> &roiDataMap);
@@ -0,0 +1,90 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "segmentationprimitives.h"
+
+#include <cmath>
+
+namespace udg {
+
+QVector<SegmentationPrimitives::StructuringElementRow> SegmentationPrimitives::getBallRows(const int radius[3])
+{
+    // Same ellipsoid as itk::BinaryBallStructuringElement: the offsets o with sum((o_i / (radius_i + 0.5))^2) <= 1
+    double axes[3];
+    for (int i = 0; i < 3; i++)
+    {
+        axes[i] = qMax(0, radius[i]) + 0.5;
+    }
+
+    QVector<StructuringElementRow> rows;
+    for (int dz = -radius[2]; dz <= radius[2]; dz++)
+    {
+        for (int dy = -radius[1]; dy <= radius[1]; dy++)
+        {
+            double remaining = 1.0 - (dy / axes[1]) * (dy / axes[1]) - (dz / axes[2]) * (dz / axes[2]);
+            if (remaining < 0.0)
+            {
+                continue;
+            }
+
+            StructuringElementRow row;
+            row.dy = dy;
+            row.dz = dz;
+            row.halfWidth = qMin(qMax(0, radius[0]), static_cast<int>(std::floor(axes[0] * std::sqrt(remaining))));
+            rows.append(row);
+        }
+    }
+
+    return rows;
+}
+
+QVector<int> SegmentationPrimitives::getSlices(const int dimensions[3])
+{
+    QVector<int> slices(dimensions[2]);
+    for (int z = 0; z < slices.size(); z++)
+    {
+        slices[z] = z;
+    }
+
+    return slices;
+}
+
+int SegmentationPrimitives::findRoot(int *parents, int index)
+{
+    while (parents[index] != index)
+    {
+        // Path halving
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+
+    return index;
+}
+
+void SegmentationPrimitives::join(int *parents, int a, int b)
+{
+    int rootA = findRoot(parents, a);
+    int rootB = findRoot(parents, b);
+    if (rootA < rootB)
+    {
+        parents[rootB] = rootA;
+    }
+    else if (rootB < rootA)
+    {
+        parents[rootA] = rootB;
+    }
+}
+
+} // End namespace udg
@@ -0,0 +1,392 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGSEGMENTATIONPRIMITIVES_H
+#define UDGSEGMENTATIONPRIMITIVES_H
+
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+
+namespace udg {
+
+/**
+    Segmentation building blocks that work directly on raw buffers of voxels, stored with x varying fastest, then y and then z.
+
+    - floodFill() fills the 6-connected region of a seed with a scanline fill and an explicit stack, so the size of the region isn't limited by
+      the call stack.
+    - labelConnectedComponents() labels the 6-connected components of a value with a union-find. The slices are labelled in parallel and then
+      joined along z.
+    - erode() and dilate() apply binary morphology with the same ellipsoidal structuring element as itk::BinaryBallStructuringElement. The ellipsoid
+      is decomposed in rows along x, and the foreground voxels of every row of the image are counted with prefix sums, so testing a voxel costs one
+      subtraction per row of the ellipsoid. The slices are processed in parallel.
+
+    Images with a single slice can be passed with a z dimension of 1 and a z radius of 0 to work in 2D.
+  */
+class SegmentationPrimitives {
+public:
+    /// Sets fillValue in mask for the voxels 6-connected to seed inside extent whose value in image is between lower and upper, both included,
+    /// and whose value in mask isn't fillValue yet. image and mask may be the same buffer. Returns the number of filled voxels.
+    template <class T, class M>
+    static qint64 floodFill(const T *image, M *mask, const int dimensions[3], const int extent[6], const int seed[3], double lower, double upper,
+                            M fillValue);
+    /// Flood fill in the whole image
+    template <class T, class M>
+    static qint64 floodFill(const T *image, M *mask, const int dimensions[3], const int seed[3], double lower, double upper, M fillValue);
+
+    /// Labels the 6-connected components of the voxels with the given value. labels gets one label per voxel, 0 for the other voxels and
+    /// consecutive labels from 1 in raster order of the first voxel of each component. Returns the number of components.
+    template <class T>
+    static int labelConnectedComponents(const T *image, const int dimensions[3], T value, QVector<int> &labels);
+
+    /// Binary erosion of the voxels with foreground value: output is a copy of input where foreground voxels whose neighbourhood isn't all
+    /// foreground are set to background. Voxels outside the image count as foreground. input and output can't be the same buffer.
+    template <class T>
+    static void erode(const T *input, T *output, const int dimensions[3], const int radius[3], T foreground, T background);
+
+    /// Binary dilation of the voxels with foreground value: output is a copy of input where voxels that have a foreground voxel in their
+    /// neighbourhood are set to foreground. input and output can't be the same buffer.
+    template <class T>
+    static void dilate(const T *input, T *output, const int dimensions[3], const int radius[3], T foreground);
+
+    /// Returns the number of voxels with the given value
+    template <class T>
+    static qint64 count(const T *image, qint64 numberOfVoxels, T value);
+
+private:
+    /// Row along x of a structuring element: the offsets from -halfWidth to halfWidth of row (dy, dz)
+    struct StructuringElementRow {
+        int dy;
+        int dz;
+        int halfWidth;
+    };
+
+    /// Returns the rows of the ellipsoid with the given radius
+    static QVector<StructuringElementRow> getBallRows(const int radius[3]);
+
+    /// Returns the indices of the slices of an image with the given dimensions, to be mapped in parallel
+    static QVector<int> getSlices(const int dimensions[3]);
+
+    /// Returns the root of the set of index, compressing the path
+    static int findRoot(int *parents, int index);
+    /// Joins the sets of a and b, keeping the lowest index as root
+    static void join(int *parents, int a, int b);
+
+    /// Fills counts with the number of voxels with the given value in [0, x) of every row, with dimensions[0] + 1 counts per row
+    template <class T>
+    static void countRowValues(const T *image, const int dimensions[3], T value, QVector<int> &counts);
+
+    /// Common implementation of erode() (erode true) and dilate() (erode false)
+    template <class T>
+    static void applyMorphology(const T *input, T *output, const int dimensions[3], const int radius[3], T foreground, T background, bool erode);
+};
+
+template <class T, class M>
+qint64 SegmentationPrimitives::floodFill(const T *image, M *mask, const int dimensions[3], const int extent[6], const int seed[3], double lower,
+                                         double upper, M fillValue)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        if (seed[i] < extent[2 * i] || seed[i] > extent[2 * i + 1] || extent[2 * i] < 0 || extent[2 * i + 1] >= dimensions[i])
+        {
+            return 0;
+        }
+    }
+
+    const qint64 rowSize = dimensions[0];
+    const qint64 sliceSize = rowSize * dimensions[1];
+
+    // Reads the image before the mask in case they are the same buffer
+    auto isFillable = [&](qint64 index)
+    {
+        double value = image[index];
+        return value >= lower && value <= upper && mask[index] != fillValue;
+    };
+
+    struct Seed {
+        int x;
+        int y;
+        int z;
+    };
+    QVector<Seed> seeds;
+
+    // Pushes a seed at the start of each run of fillable voxels of the given row between first and last
+    auto scanRow = [&](int first, int last, int y, int z)
+    {
+        qint64 index = first + y * rowSize + z * sliceSize;
+        bool previousIsSeeded = false;
+        for (int x = first; x <= last; x++, index++)
+        {
+            if (isFillable(index))
+            {
+                if (!previousIsSeeded)
+                {
+                    Seed newSeed = { x, y, z };
+                    seeds.append(newSeed);
+                    previousIsSeeded = true;
+                }
+            }
+            else
+            {
+                previousIsSeeded = false;
+            }
+        }
+    };
+
+    qint64 numberOfFilledVoxels = 0;
+    Seed firstSeed = { seed[0], seed[1], seed[2] };
+    seeds.append(firstSeed);
+
+    while (!seeds.isEmpty())
+    {
+        Seed current = seeds.last();
+        seeds.removeLast();
+
+        qint64 rowStart = current.y * rowSize + current.z * sliceSize;
+        if (!isFillable(rowStart + current.x))
+        {
+            continue;
+        }
+
+        // Extend the span to the left and to the right
+        int first = current.x;
+        while (first > extent[0] && isFillable(rowStart + first - 1))
+        {
+            first--;
+        }
+        int last = current.x;
+        while (last < extent[1] && isFillable(rowStart + last + 1))
+        {
+            last++;
+        }
+
+        std::fill(mask + rowStart + first, mask + rowStart + last + 1, fillValue);
+        numberOfFilledVoxels += last - first + 1;
+
+        // Look for new spans in the neighbouring rows
+        if (current.y > extent[2])
+        {
+            scanRow(first, last, current.y - 1, current.z);
+        }
+        if (current.y < extent[3])
+        {
+            scanRow(first, last, current.y + 1, current.z);
+        }
+        if (current.z > extent[4])
+        {
+            scanRow(first, last, current.y, current.z - 1);
+        }
+        if (current.z < extent[5])
+        {
+            scanRow(first, last, current.y, current.z + 1);
+        }
+    }
+
+    return numberOfFilledVoxels;
+}
+
+template <class T, class M>
+qint64 SegmentationPrimitives::floodFill(const T *image, M *mask, const int dimensions[3], const int seed[3], double lower, double upper, M fillValue)
+{
+    int extent[6] = { 0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1 };
+    return floodFill(image, mask, dimensions, extent, seed, lower, upper, fillValue);
+}
+
+template <class T>
+int SegmentationPrimitives::labelConnectedComponents(const T *image, const int dimensions[3], T value, QVector<int> &labels)
+{
+    const int rowSize = dimensions[0];
+    const int sliceSize = rowSize * dimensions[1];
+    const int numberOfVoxels = sliceSize * dimensions[2];
+
+    // While labelling, labels holds the parent of each voxel of the value in the union-find, and -1 for the other voxels
+    labels.resize(numberOfVoxels);
+    int *parents = labels.data();
+
+    // Each slice only joins voxels of the same slice, so they can be labelled in parallel
+    QtConcurrent::blockingMap(getSlices(dimensions), [&](int z)
+    {
+        int sliceStart = z * sliceSize;
+        for (int y = 0; y < dimensions[1]; y++)
+        {
+            int index = sliceStart + y * rowSize;
+            for (int x = 0; x < rowSize; x++, index++)
+            {
+                if (image[index] != value)
+                {
+                    parents[index] = -1;
+                    continue;
+                }
+
+                parents[index] = index;
+                if (x > 0 && parents[index - 1] >= 0)
+                {
+                    join(parents, index - 1, index);
+                }
+                if (y > 0 && parents[index - rowSize] >= 0)
+                {
+                    join(parents, index - rowSize, index);
+                }
+            }
+        }
+    });
+
+    for (int index = sliceSize; index < numberOfVoxels; index++)
+    {
+        if (parents[index] >= 0 && parents[index - sliceSize] >= 0)
+        {
+            join(parents, index - sliceSize, index);
+        }
+    }
+
+    // Roots have the lowest index of their component and parents always have a lower index than their children, so in raster order the parent of
+    // each voxel already points to its root
+    for (int index = 0; index < numberOfVoxels; index++)
+    {
+        if (parents[index] >= 0)
+        {
+            parents[index] = parents[parents[index]];
+        }
+    }
+
+    // Labels are first stored as -(label + 1) so that roots, already labelled, can be told apart from the indices of roots still to be read.
+    // The background keeps -1, which becomes 0.
+    int numberOfComponents = 0;
+    for (int index = 0; index < numberOfVoxels; index++)
+    {
+        if (parents[index] == index)
+        {
+            labels[index] = -(++numberOfComponents) - 1;
+        }
+        else if (parents[index] >= 0)
+        {
+            labels[index] = labels[parents[index]];
+        }
+    }
+
+    for (int index = 0; index < numberOfVoxels; index++)
+    {
+        labels[index] = -labels[index] - 1;
+    }
+
+    return numberOfComponents;
+}
+
+template <class T>
+void SegmentationPrimitives::erode(const T *input, T *output, const int dimensions[3], const int radius[3], T foreground, T background)
+{
+    applyMorphology(input, output, dimensions, radius, foreground, background, true);
+}
+
+template <class T>
+void SegmentationPrimitives::dilate(const T *input, T *output, const int dimensions[3], const int radius[3], T foreground)
+{
+    applyMorphology(input, output, dimensions, radius, foreground, foreground, false);
+}
+
+template <class T>
+qint64 SegmentationPrimitives::count(const T *image, qint64 numberOfVoxels, T value)
+{
+    qint64 numberOfValues = 0;
+    for (qint64 i = 0; i < numberOfVoxels; i++)
+    {
+        numberOfValues += image[i] == value;
+    }
+
+    return numberOfValues;
+}
+
+template <class T>
+void SegmentationPrimitives::countRowValues(const T *image, const int dimensions[3], T value, QVector<int> &counts)
+{
+    const int numberOfRows = dimensions[1] * dimensions[2];
+    counts.resize((dimensions[0] + 1) * numberOfRows);
+    int *rowCounts = counts.data();
+
+    QtConcurrent::blockingMap(getSlices(dimensions), [&](int z)
+    {
+        for (int row = z * dimensions[1]; row < (z + 1) * dimensions[1]; row++)
+        {
+            const T *rowValues = image + static_cast<qint64>(row) * dimensions[0];
+            int *countsOfRow = rowCounts + row * (dimensions[0] + 1);
+            countsOfRow[0] = 0;
+            for (int x = 0; x < dimensions[0]; x++)
+            {
+                countsOfRow[x + 1] = countsOfRow[x] + (rowValues[x] == value);
+            }
+        }
+    });
+}
+
+template <class T>
+void SegmentationPrimitives::applyMorphology(const T *input, T *output, const int dimensions[3], const int radius[3], T foreground, T background,
+                                             bool erode)
+{
+    QVector<int> counts;
+    countRowValues(input, dimensions, foreground, counts);
+    const QVector<StructuringElementRow> rows = getBallRows(radius);
+    const int countsRowSize = dimensions[0] + 1;
+
+    QtConcurrent::blockingMap(getSlices(dimensions), [&](int z)
+    {
+        for (int y = 0; y < dimensions[1]; y++)
+        {
+            qint64 rowStart = (static_cast<qint64>(z) * dimensions[1] + y) * dimensions[0];
+            for (int x = 0; x < dimensions[0]; x++)
+            {
+                T value = input[rowStart + x];
+                output[rowStart + x] = value;
+
+                // Only foreground voxels can be eroded and only the rest can be dilated
+                if ((value == foreground) != erode)
+                {
+                    continue;
+                }
+
+                foreach (const StructuringElementRow &row, rows)
+                {
+                    int neighbourY = y + row.dy;
+                    int neighbourZ = z + row.dz;
+                    if (neighbourY < 0 || neighbourY >= dimensions[1] || neighbourZ < 0 || neighbourZ >= dimensions[2])
+                    {
+                        // Outside the image: foreground for erosion and background for dilation
+                        continue;
+                    }
+
+                    int first = qMax(0, x - row.halfWidth);
+                    int last = qMin(dimensions[0] - 1, x + row.halfWidth);
+                    const int *countsOfRow = counts.constData() + (neighbourZ * dimensions[1] + neighbourY) * countsRowSize;
+                    int numberOfForegroundVoxels = countsOfRow[last + 1] - countsOfRow[first];
+
+                    if (erode && numberOfForegroundVoxels < last - first + 1)
+                    {
+                        output[rowStart + x] = background;
+                        break;
+                    }
+                    if (!erode && numberOfForegroundVoxels > 0)
+                    {
+                        output[rowStart + x] = foreground;
+                        break;
+                    }
+                }
+            }
+        }
+    });
+}
+
+} // End namespace udg
+
+#endif
@@ -60,6 +60,8 @@ const QString Shortcuts::Propagation(ShortcutsBase + "Propagation");
 const QString Shortcuts::NextHangingProtocol(ShortcutsBase + "NextHangingProtocol");
 const QString Shortcuts::PreviousHangingProtocol(ShortcutsBase + "PreviousHangingProtocol");
 const QString Shortcuts::ToggleComparativeStudiesMode(ShortcutsBase + "ToggleComparativeStudiesMode");
+const QString Shortcuts::Benchmark3DRendering(ShortcutsBase + "Benchmark3DRendering");
+const QString Shortcuts::ToggleRenderingProfiler(ShortcutsBase + "ToggleRenderingProfiler");
 
 const QString Shortcuts::SaveSingleScreenShot(ShortcutsBase + "SaveSingleScreenShot");
 const QString Shortcuts::SaveWholeSeriesScreenShot(ShortcutsBase + "SaveWholeSeriesScreenShot");
@@ -360,6 +362,14 @@ void Shortcuts::init()
     shortcutsList.append(QString("F10"));
     settingsRegistry->addSetting(ToggleComparativeStudiesMode, shortcutsList);
 
+    shortcutsList.clear();
+    shortcutsList.append(QString("Ctrl+Alt+B"));
+    settingsRegistry->addSetting(Benchmark3DRendering, shortcutsList);
+
+    shortcutsList.clear();
+    shortcutsList.append(QString("Ctrl+Alt+P"));
+    settingsRegistry->addSetting(ToggleRenderingProfiler, shortcutsList);
+
     shortcutsList.clear();
     shortcutsList.append(QString("Shift+F1"));
     settingsRegistry->addSetting(ExternalApplication1, shortcutsList);
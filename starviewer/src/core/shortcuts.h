@@ -66,6 +66,8 @@ public:
     static const QString NextHangingProtocol;
     static const QString PreviousHangingProtocol;
     static const QString ToggleComparativeStudiesMode;
+    static const QString Benchmark3DRendering;
+    static const QString ToggleRenderingProfiler;
 
     static const QString SaveSingleScreenShot;
     static const QString SaveWholeSeriesScreenShot;
@@ -0,0 +1,170 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "sliceindex.h"
+
+#include "imageplane.h"
+#include "mathtools.h"
+
+#include <QPair>
+#include <QVector3D>
+
+#include <algorithm>
+#include <cmath>
+
+namespace udg {
+
+namespace {
+
+// Slices whose normals have a dot product with the first normal below this value are considered not parallel
+const double ParallelNormalsTolerance = 1.0 - 1e-6;
+
+}
+
+SliceIndex::SliceIndex(const QList<ImagePlane*> &slicePlanes)
+ : m_areSlicesParallel(true)
+{
+    m_normal[0] = m_normal[1] = m_normal[2] = 0.0;
+
+    for (int i = 0; i < slicePlanes.size(); i++)
+    {
+        ImagePlane *plane = slicePlanes.at(i);
+        if (!plane)
+        {
+            continue;
+        }
+
+        QVector3D normal = plane->getImageOrientation().getNormalVector();
+        const Vector3 &origin = plane->getOrigin();
+        m_sliceNumbers << i;
+        m_normals << normal.x() << normal.y() << normal.z();
+        m_origins << origin.x << origin.y << origin.z;
+    }
+
+    int numberOfSlices = m_sliceNumbers.size();
+    if (numberOfSlices == 0)
+    {
+        return;
+    }
+
+    std::copy(m_normals.constBegin(), m_normals.constBegin() + 3, m_normal);
+    for (int i = 1; i < numberOfSlices && m_areSlicesParallel; i++)
+    {
+        const double *normal = m_normals.constData() + i * 3;
+        m_areSlicesParallel = normal[0] * m_normal[0] + normal[1] * m_normal[1] + normal[2] * m_normal[2] >= ParallelNormalsTolerance;
+    }
+
+    if (!m_areSlicesParallel)
+    {
+        return;
+    }
+
+    QVector<QPair<double, int> > positions(numberOfSlices);
+    for (int i = 0; i < numberOfSlices; i++)
+    {
+        const double *origin = m_origins.constData() + i * 3;
+        positions[i] = qMakePair(origin[0] * m_normal[0] + origin[1] * m_normal[1] + origin[2] * m_normal[2], m_sliceNumbers.at(i));
+    }
+    std::sort(positions.begin(), positions.end());
+
+    m_sortedPositions.resize(numberOfSlices);
+    m_sortedSliceNumbers.resize(numberOfSlices);
+    for (int i = 0; i < numberOfSlices; i++)
+    {
+        m_sortedPositions[i] = positions.at(i).first;
+        m_sortedSliceNumbers[i] = positions.at(i).second;
+    }
+}
+
+SliceIndex::~SliceIndex()
+{
+}
+
+int SliceIndex::getNumberOfSlices() const
+{
+    return m_sliceNumbers.size();
+}
+
+bool SliceIndex::areSlicesParallel() const
+{
+    return m_areSlicesParallel;
+}
+
+int SliceIndex::getNearestSlice(const double point[3], double &distance) const
+{
+    distance = MathTools::DoubleMaximumValue;
+
+    if (m_sliceNumbers.isEmpty())
+    {
+        return -1;
+    }
+
+    if (!m_areSlicesParallel)
+    {
+        return getNearestSliceLinear(point, distance);
+    }
+
+    double position = point[0] * m_normal[0] + point[1] * m_normal[1] + point[2] * m_normal[2];
+    const double *begin = m_sortedPositions.constBegin();
+    const double *end = m_sortedPositions.constEnd();
+    int next = std::lower_bound(begin, end, position) - begin;
+
+    if (next > 0)
+    {
+        distance = position - m_sortedPositions.at(next - 1);
+    }
+    if (next < m_sortedPositions.size())
+    {
+        distance = qMin(distance, m_sortedPositions.at(next) - position);
+    }
+
+    // Slices at the same position or at the same distance on both sides are tied, the lowest slice number wins
+    int nearestSlice = -1;
+    for (int i = next - 1; i >= 0 && position - m_sortedPositions.at(i) <= distance; i--)
+    {
+        if (nearestSlice < 0 || m_sortedSliceNumbers.at(i) < nearestSlice)
+        {
+            nearestSlice = m_sortedSliceNumbers.at(i);
+        }
+    }
+    for (int i = next; i < m_sortedPositions.size() && m_sortedPositions.at(i) - position <= distance; i++)
+    {
+        if (nearestSlice < 0 || m_sortedSliceNumbers.at(i) < nearestSlice)
+        {
+            nearestSlice = m_sortedSliceNumbers.at(i);
+        }
+    }
+
+    return nearestSlice;
+}
+
+int SliceIndex::getNearestSliceLinear(const double point[3], double &distance) const
+{
+    int nearestSlice = -1;
+    for (int i = 0; i < m_sliceNumbers.size(); i++)
+    {
+        const double *normal = m_normals.constData() + i * 3;
+        const double *origin = m_origins.constData() + i * 3;
+        double sliceDistance = std::abs(normal[0] * (point[0] - origin[0]) + normal[1] * (point[1] - origin[1]) + normal[2] * (point[2] - origin[2]));
+        if (sliceDistance < distance)
+        {
+            distance = sliceDistance;
+            nearestSlice = m_sliceNumbers.at(i);
+        }
+    }
+
+    return nearestSlice;
+}
+
+} // End namespace udg
@@ -0,0 +1,70 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGSLICEINDEX_H
+#define UDGSLICEINDEX_H
+
+#include <QList>
+#include <QVector>
+
+namespace udg {
+
+class ImagePlane;
+
+/**
+    Index of the slices of a volume in an orthogonal plane to find the slice nearest to a point without building all the image planes.
+
+    When all the slices are parallel, their positions along the common normal are kept sorted and the nearest slice is found with a binary
+    search, which also works for irregular spacing and for several stacks with the same orientation. When they aren't parallel, e.g. a series
+    with per-slice gantry tilt or several stacks with different orientations, the distance to each slice plane is computed from the stored
+    normals and origins.
+
+    Volume keeps an index for each plane, so it's built once and shared by SliceLocator and all the synchronization tools that use it.
+  */
+class SliceIndex {
+public:
+    /// Builds the index from the planes of the slices, where the position in the list is the slice number. Null planes are skipped.
+    SliceIndex(const QList<ImagePlane*> &slicePlanes);
+    ~SliceIndex();
+
+    /// Returns the number of indexed slices
+    int getNumberOfSlices() const;
+
+    /// Returns true if all the slices are parallel and the binary search is used
+    bool areSlicesParallel() const;
+
+    /// Returns the slice whose plane is nearest to the given point and the distance to it, or -1 if there are no slices.
+    /// If several slices are at the same distance, the lowest slice number is returned.
+    int getNearestSlice(const double point[3], double &distance) const;
+
+private:
+    /// Returns the nearest slice computing the distance to each plane
+    int getNearestSliceLinear(const double point[3], double &distance) const;
+
+private:
+    /// Slice number, normal and origin of each indexed slice
+    QVector<int> m_sliceNumbers;
+    QVector<double> m_normals;
+    QVector<double> m_origins;
+
+    /// Common normal of the slices and their positions along it, sorted, with the slice number of each one. Only used if all are parallel.
+    bool m_areSlicesParallel;
+    double m_normal[3];
+    QVector<double> m_sortedPositions;
+    QVector<int> m_sortedSliceNumbers;
+};
+
+} // End namespace udg
+
+#endif
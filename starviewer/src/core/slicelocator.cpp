@@ -15,7 +15,7 @@
 #include "slicelocator.h"
 
 #include "imageplane.h"
-#include "mathtools.h"
+#include "sliceindex.h"
 #include "volume.h"
 
 namespace udg {
@@ -50,26 +50,10 @@ int SliceLocator::getNearestSlice(double point[3])
         return -1;
     }
     
-    double nearestSliceDistance = MathTools::DoubleMaximumValue;
-    int nearestSlice = -1;
-    
-    for (int i = 0; i <= m_volume->getMaximumSlice(m_volumePlane); ++i)
-    {
-        ImagePlane *currentPlane = m_volume->getImagePlane(i, m_volumePlane);
-        if (currentPlane)
-        {
-            double currentDistance = currentPlane->getDistanceToPoint(point);
-            if (currentDistance < nearestSliceDistance)
-            {
-                nearestSliceDistance = currentDistance;
-                nearestSlice = i;
-            }
-
-            delete currentPlane;
-        }
-    }
+    double nearestSliceDistance;
+    int nearestSlice = m_volume->getSliceIndex(m_volumePlane)->getNearestSlice(point, nearestSliceDistance);
 
-    if (isWithinProximityBounds(nearestSliceDistance))
+    if (nearestSlice >= 0 && isWithinProximityBounds(nearestSliceDistance))
     {
         return nearestSlice;
     }
@@ -69,6 +69,11 @@ SliceOrientedVolumePixelData& SliceOrientedVolumePixelData::setDataToWorldMatrix
     return *this;
 }
 
+VolumePixelData* SliceOrientedVolumePixelData::getVolumePixelData() const
+{
+    return m_volumePixelData;
+}
+
 const OrthogonalPlane& SliceOrientedVolumePixelData::getOrthogonalPlane() const
 {
     return m_orthogonalPlane;
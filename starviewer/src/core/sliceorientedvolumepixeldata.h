@@ -44,6 +44,9 @@ public:
     /// Sets the given data-to-world matrix and its inverse as world-to-data to this object and returns the object.
     SliceOrientedVolumePixelData& setDataToWorldMatrix(vtkMatrix4x4 *dataToWorldMatrix);
 
+    /// Returns the underlying volume pixel data.
+    VolumePixelData* getVolumePixelData() const;
+
     /// Returns the orthogonal plane that defines the slice orientation with respect to the volume pixel data.
     const OrthogonalPlane& getOrthogonalPlane() const;
     /// Returns the data-to-world matrix that allows to transform from pixel data space to world space.
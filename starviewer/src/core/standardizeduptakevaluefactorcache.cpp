@@ -0,0 +1,102 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "standardizeduptakevaluefactorcache.h"
+
+#include "image.h"
+#include "volume.h"
+
+namespace udg {
+
+StandardizedUptakeValueFactorCache::StandardizedUptakeValueFactorCache(Volume *volume)
+ : m_volume(volume)
+{
+    StandardUptakeValueMeasureHandler suvHandler;
+    m_formula = suvHandler.getPreferredFormula();
+    m_formulaLabel = suvHandler.getFormulaLabel(m_formula);
+    m_formulaUnits = suvHandler.getFormulaUnits(m_formula);
+}
+
+StandardizedUptakeValueFactorCache::~StandardizedUptakeValueFactorCache()
+{
+}
+
+void StandardizedUptakeValueFactorCache::setFormula(StandardUptakeValueMeasureHandler::FormulaType formula)
+{
+    if (formula != m_formula)
+    {
+        StandardUptakeValueMeasureHandler suvHandler;
+        m_formula = formula;
+        m_formulaLabel = suvHandler.getFormulaLabel(m_formula);
+        m_formulaUnits = suvHandler.getFormulaUnits(m_formula);
+        m_factors.clear();
+    }
+}
+
+StandardUptakeValueMeasureHandler::FormulaType StandardizedUptakeValueFactorCache::getFormula() const
+{
+    return m_formula;
+}
+
+QString StandardizedUptakeValueFactorCache::getFormulaLabel() const
+{
+    return m_formulaLabel;
+}
+
+QString StandardizedUptakeValueFactorCache::getFormulaUnits() const
+{
+    return m_formulaUnits;
+}
+
+double StandardizedUptakeValueFactorCache::getFactor(Image *image)
+{
+    if (!image)
+    {
+        return 0.0;
+    }
+
+    QHash<Image*, double>::const_iterator iterator = m_factors.constFind(image);
+    if (iterator != m_factors.constEnd())
+    {
+        return iterator.value();
+    }
+
+    double factor = 0.0;
+    StandardUptakeValueMeasureHandler suvHandler;
+    suvHandler.setImage(image);
+    if (suvHandler.canComputeFormula(m_formula))
+    {
+        factor = suvHandler.compute(1.0, m_formula);
+    }
+    m_factors.insert(image, factor);
+
+    return factor;
+}
+
+double StandardizedUptakeValueFactorCache::getFactor(int slice, int phase)
+{
+    return getFactor(m_volume->getImage(slice, phase));
+}
+
+bool StandardizedUptakeValueFactorCache::canCompute(Image *image)
+{
+    return getFactor(image) != 0.0;
+}
+
+double StandardizedUptakeValueFactorCache::computeValue(double pixelValue, Image *image)
+{
+    return pixelValue * getFactor(image);
+}
+
+} // End namespace udg
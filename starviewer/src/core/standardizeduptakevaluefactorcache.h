@@ -0,0 +1,75 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGSTANDARDIZEDUPTAKEVALUEFACTORCACHE_H
+#define UDGSTANDARDIZEDUPTAKEVALUEFACTORCACHE_H
+
+#include "standarduptakevaluemeasurehandler.h"
+
+#include <QHash>
+
+namespace udg {
+
+class Image;
+class Volume;
+
+/**
+    Cache of the factors that convert the pixel values of the images of a PET volume to SUV.
+
+    All the SUV formulas are linear on the activity concentration, so the SUV of a pixel is its value multiplied by a factor that only depends
+    on the DICOM attributes of its image. The factor of each image is computed once with StandardUptakeValueMeasureHandler, which has to read
+    the header of the file, and kept until the formula changes.
+
+    Pixel values are converted with the factor without touching the DICOM header again, which makes it cheap enough to be used on every mouse
+    move. The displayed pixel data is not converted.
+  */
+class StandardizedUptakeValueFactorCache {
+public:
+    explicit StandardizedUptakeValueFactorCache(Volume *volume);
+    ~StandardizedUptakeValueFactorCache();
+
+    /// Sets the formula used to compute SUV. Changing it discards the computed factors. By default it's the preferred formula.
+    void setFormula(StandardUptakeValueMeasureHandler::FormulaType formula);
+    StandardUptakeValueMeasureHandler::FormulaType getFormula() const;
+
+    /// Returns the label and the units of the formula
+    QString getFormulaLabel() const;
+    QString getFormulaUnits() const;
+
+    /// Returns the factor that converts the pixel values of the given image to SUV, or 0 if SUV can't be computed for it
+    double getFactor(Image *image);
+    /// Returns the factor of the image of the given slice and phase, or 0 if SUV can't be computed for it
+    double getFactor(int slice, int phase = 0);
+
+    /// Returns true if SUV can be computed for the given image
+    bool canCompute(Image *image);
+
+    /// Returns the SUV corresponding to the given pixel value of the image. It's undefined if canCompute() returns false for the image.
+    double computeValue(double pixelValue, Image *image);
+
+private:
+    Volume *m_volume;
+
+    /// Formula used to compute the factors, with its label and units
+    StandardUptakeValueMeasureHandler::FormulaType m_formula;
+    QString m_formulaLabel;
+    QString m_formulaUnits;
+
+    /// Factor of each image for which it has already been computed
+    QHash<Image*, double> m_factors;
+};
+
+} // End namespace udg
+
+#endif
@@ -15,7 +15,6 @@
 #include "strokesegmentationmethod.h"
 
 #include "itkErfcLevelSetImageFilter.h"
-#include "itkVolumeCalculatorImageFilter.h"
 
 // Per la utilització de clock()
 #include <ctime>
@@ -27,7 +26,6 @@
 #include <itkConfidenceConnectedImageFilter.h>
 #include <itkCurvatureFlowImageFilter.h>
 #include <itkCastImageFilter.h>
-#include <itkConnectedThresholdImageFilter.h>
 #include <itkMedianImageFilter.h>
 #include <itkCurvatureAnisotropicDiffusionImageFilter.h>
 #include <itkGradientMagnitudeRecursiveGaussianImageFilter.h>
@@ -37,9 +35,6 @@
 #include <itkThresholdSegmentationLevelSetImageFilter.h>
 #include <itkZeroCrossingImageFilter.h>
 #include <itkGeodesicActiveContourLevelSetImageFilter.h>
-#include <itkBinaryErodeImageFilter.h>
-#include <itkBinaryDilateImageFilter.h>
-#include <itkBinaryBallStructuringElement.h>
 
 #include <itkVector.h>
 #include <itkListSample.h>
@@ -57,9 +52,60 @@
 #include <vtkImageData.h>
 
 #include "logging.h"
+#include "segmentationprimitives.h"
 
 namespace udg {
 
+namespace {
+
+/// Returns the dimensions of the buffered region of the image
+void getDimensions(Volume::ItkImageType *image, int dimensions[3])
+{
+    Volume::ItkImageType::SizeType size = image->GetBufferedRegion().GetSize();
+    for (int i = 0; i < 3; i++)
+    {
+        dimensions[i] = size[i];
+    }
+}
+
+/// Returns a new image with the same region, spacing, origin and direction as the reference, filled with the given value
+Volume::ItkImageType::Pointer createImage(Volume::ItkImageType *reference, Volume::ItkPixelType value)
+{
+    Volume::ItkImageType::Pointer image = Volume::ItkImageType::New();
+    image->SetRegions(reference->GetBufferedRegion());
+    image->SetSpacing(reference->GetSpacing());
+    image->SetOrigin(reference->GetOrigin());
+    image->SetDirection(reference->GetDirection());
+    image->Allocate();
+    image->FillBuffer(value);
+    return image;
+}
+
+/// Returns the binary dilation of the foreground of the image with a ball of the given radius
+Volume::ItkImageType::Pointer dilate(Volume::ItkImageType *image, int radiusX, int radiusY, int radiusZ, Volume::ItkPixelType foreground)
+{
+    int dimensions[3];
+    getDimensions(image, dimensions);
+    int radius[3] = { radiusX, radiusY, radiusZ };
+    Volume::ItkImageType::Pointer output = createImage(image, 0);
+    SegmentationPrimitives::dilate(image->GetBufferPointer(), output->GetBufferPointer(), dimensions, radius, foreground);
+    return output;
+}
+
+/// Returns the binary erosion of the foreground of the image with a ball of the given radius
+Volume::ItkImageType::Pointer erode(Volume::ItkImageType *image, int radiusX, int radiusY, int radiusZ, Volume::ItkPixelType foreground,
+                                    Volume::ItkPixelType background)
+{
+    int dimensions[3];
+    getDimensions(image, dimensions);
+    int radius[3] = { radiusX, radiusY, radiusZ };
+    Volume::ItkImageType::Pointer output = createImage(image, 0);
+    SegmentationPrimitives::erode(image->GetBufferPointer(), output->GetBufferPointer(), dimensions, radius, foreground, background);
+    return output;
+}
+
+}
+
 StrokeSegmentationMethod::StrokeSegmentationMethod()
 {
     m_Volume = 0;
@@ -101,74 +147,9 @@ void StrokeSegmentationMethod::setHistogramUpperLevel(int x)
 
 double StrokeSegmentationMethod::applyMethod()
 {
-    typedef float InternalPixelType;
-    typedef itk::Image<InternalPixelType, 3> InternalImageType;
-
-    typedef itk::CastImageFilter<Volume::ItkImageType, InternalImageType> InputCastingFilterType;
-    typedef itk::CastImageFilter<InternalImageType, Volume::ItkImageType> OutputCastingFilterType;
-
-    typedef itk::CurvatureFlowImageFilter<InternalImageType, InternalImageType> CurvatureFlowImageFilterType;
-    typedef itk::ConnectedThresholdImageFilter<InternalImageType, InternalImageType> ConnectedFilterType;
-
-    InputCastingFilterType::Pointer incaster = InputCastingFilterType::New();
-    OutputCastingFilterType::Pointer outcaster = OutputCastingFilterType::New();
-    CurvatureFlowImageFilterType::Pointer smoothing = CurvatureFlowImageFilterType::New();
-    ConnectedFilterType::Pointer connectedThreshold = ConnectedFilterType::New();
-
-    incaster->SetInput(m_Volume->getItkData());
-    //smoothing->SetInput(incaster->GetOutput());
-    //connectedThreshold->SetInput(smoothing->GetOutput());
-    // Comentem aquesta línia per fer el filtratge
-    connectedThreshold->SetInput(incaster->GetOutput());
-    outcaster->SetInput(connectedThreshold->GetOutput());
-
-    smoothing->SetNumberOfIterations(3);
-    smoothing->SetTimeStep(0.0625);
-    //smoothing->SetNumberOfIterations(numiterations);
-    //smoothing->SetTimeStep(timeStep);
-
-    connectedThreshold->SetLower(m_lowerThreshold);
-    connectedThreshold->SetUpper(m_upperThreshold);
-    connectedThreshold->SetReplaceValue(m_insideMaskValue);
-
-    InternalImageType::IndexType seedIndex;
-    InternalImageType::PointType seedPoint;
-    seedPoint[0] = m_px;
-    seedPoint[1] = m_py;
-    seedPoint[2] = m_pz;
-    m_Volume->getItkData()->TransformPhysicalPointToIndex(seedPoint, seedIndex);
-    connectedThreshold->SetSeed(seedIndex);
-
-    DEBUG_LOG("Init filter");
-    DEBUG_LOG(QString("Parameters: %1").arg(*seedIndex.GetIndex()));
-    std::cerr << "Parameters: " << seedIndex << std::endl;
     DEBUG_LOG(QString("Histogram parameters: %1,%2").arg(m_lowerThreshold).arg(m_upperThreshold));
 
-    typedef itk::VolumeCalculatorImageFilter<Volume::ItkImageType> VolumeCalcFilterType;
-    VolumeCalcFilterType::Pointer volumeCalc = VolumeCalcFilterType::New();
-    volumeCalc->SetInput(outcaster->GetOutput());
-    volumeCalc->SetInsideValue(m_insideMaskValue);
-
-    try
-    {
-        //outcaster->Update();
-        volumeCalc->Update();
-    }
-    catch(itk::ExceptionObject &excep)
-    {
-        DEBUG_LOG("Exception caught !");
-        DEBUG_LOG(excep.what());
-    }
-
-    m_volume = volumeCalc->GetVolume();
-    m_cont = volumeCalc->GetVolumeCount();
-    DEBUG_LOG(QString("MCONT>%1").arg(m_cont));
-
-    //m_Mask->setData(outcaster->GetOutput());
-    m_Mask->setData(volumeCalc->GetOutput());
-    // m_Mask  = outcaster->GetOutput();
-
-    return m_volume;
+    return fillConnectedRegion(m_Volume->getItkData(), m_lowerThreshold, m_upperThreshold);
 }
 
 double StrokeSegmentationMethod::applyMethodVTK()
@@ -193,7 +174,20 @@ double StrokeSegmentationMethod::applyMethodVTK()
     index[2] = (int)(((double)m_pz - origin[2]) / spacing[2]);
     DEBUG_LOG(QString("Tractant llesca %1").arg(index[2]));
 
-    applyMethodVTKRecursive(imMask, index[0], index[1], index[2], 0);
+    int extent[6];
+    int dimensions[3];
+    imMask->GetExtent(extent);
+    imMask->GetDimensions(dimensions);
+    int seed[3] = { index[0] - extent[0], index[1] - extent[2], index[2] - extent[4] };
+
+    // The thresholded voxels connected to the seed go from m_insideMaskValue - 100 to m_insideMaskValue, in place
+    void *scalars = imMask->GetScalarPointer();
+    double thresholdedValue = m_insideMaskValue - 100;
+    switch (imMask->GetScalarType())
+    {
+        vtkTemplateMacro(m_cont = SegmentationPrimitives::floodFill(static_cast<VTK_TT*>(scalars), static_cast<VTK_TT*>(scalars), dimensions, seed,
+                                                                    thresholdedValue, thresholdedValue, static_cast<VTK_TT>(m_insideMaskValue)));
+    }
 
     DEBUG_LOG(QString("Tractant llesca %1").arg(index[2]));
 
@@ -203,33 +197,9 @@ double StrokeSegmentationMethod::applyMethodVTK()
     return m_cont * spacing[0] * spacing[1] * spacing[2];
 }
 
-void StrokeSegmentationMethod::applyMethodVTKRecursive(vtkImageData* imMask, int a, int b, int c, int prof)
-{
-    if ((a >= m_Volume->getExtent()[0]) && (a <= m_Volume->getExtent()[1]) && (b >= m_Volume->getExtent()[2]) && (b <=
-        m_Volume->getExtent()[3]) && (c >= m_Volume->getExtent()[4]) && (c <= m_Volume->getExtent()[5]))
-    {
-        double maskValue = imMask->GetScalarComponentAsDouble(a, b, c, 0);
-        if (maskValue == m_insideMaskValue - 100)
-        {
-            imMask->SetScalarComponentFromDouble(a, b, c, 0, m_insideMaskValue);
-            m_cont++;
-            applyMethodVTKRecursive(imMask, a, b, c + 1, prof + 1);
-            applyMethodVTKRecursive(imMask, a, b, c - 1, prof + 1);
-            applyMethodVTKRecursive(imMask, a + 1, b, c, prof + 1);
-            applyMethodVTKRecursive(imMask, a - 1, b, c, prof + 1);
-            applyMethodVTKRecursive(imMask, a, b + 1, c, prof + 1);
-            applyMethodVTKRecursive(imMask, a, b - 1, c, prof + 1);
-        }
-    }
-}
-
 double StrokeSegmentationMethod::applyCleanSkullMethod()
 {
     DEBUG_LOG("Clean Skull!!");
-    typedef itk::BinaryBallStructuringElement<Volume::ItkPixelType, Volume::VDimension> StructuringElementType;
-    typedef itk::BinaryErodeImageFilter<Volume::ItkImageType, Volume::ItkImageType, StructuringElementType> ErodeFilterType;
-    typedef itk::BinaryDilateImageFilter<Volume::ItkImageType, Volume::ItkImageType, StructuringElementType> DilateFilterType;
-
     typedef itk::ResampleImageFilter<Volume::ItkImageType, Volume::ItkImageType> ResampleFilterType;
     typedef itk::AffineTransform<double, 3> TransformType;
     typedef itk::NearestNeighborInterpolateImageFunction<Volume::ItkImageType, double> InterpolatorType;
@@ -286,61 +256,11 @@ double StrokeSegmentationMethod::applyCleanSkullMethod()
         .arg(newspacing[0]).arg(newspacing[1]).arg(newspacing[2])
         .arg(*newsize.GetSize()));
 
-    ErodeFilterType::Pointer binaryErode = ErodeFilterType::New();
-    DilateFilterType::Pointer binaryDilate = DilateFilterType::New();
-    DilateFilterType::Pointer binaryDilatePre = DilateFilterType::New();
-
-    binaryErode->SetErodeValue(m_insideMaskValue);
-    binaryDilate->SetDilateValue(m_insideMaskValue);
-    binaryDilatePre->SetDilateValue(m_insideMaskValue);
-    binaryErode->SetBackgroundValue(m_outsideMaskValue);
-    binaryDilate->SetBackgroundValue(m_outsideMaskValue);
-    binaryDilatePre->SetBackgroundValue(m_outsideMaskValue);
-
-    StructuringElementType::SizeType radiusDilatePre;
-    radiusDilatePre[0] = 1;
-    radiusDilatePre[1] = 1;
-    radiusDilatePre[2] = 1;
-    StructuringElementType structuringElementDilatePre;
-    // 3x3 structuring element
-    structuringElementDilatePre.SetRadius(radiusDilatePre);
-    structuringElementDilatePre.CreateStructuringElement();
-
-    binaryDilatePre->SetKernel(structuringElementDilatePre);
-
-    //binaryDilatePre->SetInput(m_Mask->getItkData());
-    binaryDilatePre->SetInput(resampleFilter->GetOutput());
-
-    StructuringElementType::SizeType radiusErode;
-    radiusErode[0] = 6;
-    radiusErode[1] = 6;
-    radiusErode[2] = 1;
-
-    StructuringElementType structuringElementErode;
-    // 3x3 structuring element
-    structuringElementErode.SetRadius(radiusErode);
-    structuringElementErode.CreateStructuringElement();
-
-    binaryErode->SetKernel(structuringElementErode);
-
-    //binaryErode->SetInput(m_Mask->getItkData());
-    binaryErode->SetInput(binaryDilatePre->GetOutput());
-
-    StructuringElementType::SizeType radiusDilate;
-    radiusDilate[0] = 8;
-    radiusDilate[1] = 8;
-    radiusDilate[2] = 2;
-    StructuringElementType structuringElementDilate;
-    // 3x3 structuring element
-    structuringElementDilate.SetRadius(radiusDilate);
-    structuringElementDilate.CreateStructuringElement();
-
-    binaryDilate->SetKernel(structuringElementDilate);
-
-    binaryDilate->SetInput(binaryErode->GetOutput());
+    // Opening of the resampled mask after a small dilation that closes its gaps
     t1 = clock();
-    //medianFilter->Update();
-    binaryDilate->Update();
+    Volume::ItkImageType::Pointer dilatedPre = dilate(resampleFilter->GetOutput(), 1, 1, 1, m_insideMaskValue);
+    Volume::ItkImageType::Pointer eroded = erode(dilatedPre, 6, 6, 1, m_insideMaskValue, m_outsideMaskValue);
+    Volume::ItkImageType::Pointer dilated = dilate(eroded, 8, 8, 2, m_insideMaskValue);
     t2 = clock();
 
     // Resamplagem la imatge per tal de que tingui menys vòxels i trigui menys a calcular
@@ -358,7 +278,7 @@ double StrokeSegmentationMethod::applyCleanSkullMethod()
 
     size = m_Mask->getItkData()->GetBufferedRegion().GetSize();
     resample2Filter->SetSize(size);
-    resample2Filter->SetInput(binaryDilate->GetOutput());
+    resample2Filter->SetInput(dilated);
     t5 = clock();
     resample2Filter->Update();
     t6 = clock();
@@ -371,64 +291,23 @@ double StrokeSegmentationMethod::applyCleanSkullMethod()
         .arg(newspacing[0]).arg(newspacing[1]).arg(newspacing[2])
         .arg(*newsize.GetSize()));
 
-    Volume::ItkImageType::Pointer maskAux = Volume::ItkImageType::New();
-    maskAux->SetSpacing(m_Mask->getItkData()->GetSpacing());
-    maskAux->SetOrigin(m_Mask->getItkData()->GetOrigin());
-    maskAux = resample2Filter->GetOutput();
-    //maskAux = binaryDilate->GetOutput();
-    //maskAux = medianFilter->GetOutput();
-
-    itk::ImageRegionIterator<Volume::ItkImageType> maskIt(m_Mask->getItkData(), m_Mask->getItkData()->GetBufferedRegion());
-    itk::ImageRegionIterator<Volume::ItkImageType> auxIt(maskAux, maskAux->GetBufferedRegion());
-    auxIt.GoToBegin();
-    maskIt.GoToBegin();
+    Volume::ItkImageType::Pointer maskAux = resample2Filter->GetOutput();
+    const Volume::ItkPixelType *maskValues = m_Mask->getItkData()->GetBufferPointer();
+    Volume::ItkPixelType *auxValues = maskAux->GetBufferPointer();
+    qint64 numberOfVoxels = maskAux->GetBufferedRegion().GetNumberOfPixels();
 
     // Fem la intersecció de les dues màscares
-    while (!auxIt.IsAtEnd())
+    for (qint64 i = 0; i < numberOfVoxels; i++)
     {
-        if (maskIt.Value()!= m_insideMaskValue && auxIt.Value() == m_insideMaskValue)
+        if (maskValues[i] != m_insideMaskValue && auxValues[i] == m_insideMaskValue)
         {
             // L'únic cas que canvia
-            auxIt.Set(m_outsideMaskValue);
+            auxValues[i] = m_outsideMaskValue;
         }
-        ++auxIt;
-        ++maskIt;
     }
     t3 = clock();
 
-    typedef itk::ConnectedThresholdImageFilter<Volume::ItkImageType, Volume::ItkImageType> ConnectedFilterType;
-
-    ConnectedFilterType::Pointer connectedThreshold = ConnectedFilterType::New();
-
-    connectedThreshold->SetInput(maskAux);
-
-    connectedThreshold->SetLower(m_insideMaskValue - 1);
-    connectedThreshold->SetUpper(m_insideMaskValue + 1);
-    connectedThreshold->SetReplaceValue(m_insideMaskValue);
-
-    Volume::ItkImageType::IndexType seedIndex;
-    Volume::ItkImageType::PointType seedPoint;
-    seedPoint[0] = m_px;
-    seedPoint[1] = m_py;
-    seedPoint[2] = m_pz;
-    m_Volume->getItkData()->TransformPhysicalPointToIndex(seedPoint, seedIndex);
-    connectedThreshold->SetSeed(seedIndex);
-
-    typedef itk::VolumeCalculatorImageFilter<Volume::ItkImageType> VolumeCalcFilterType;
-    VolumeCalcFilterType::Pointer volumeCalc = VolumeCalcFilterType::New();
-    volumeCalc->SetInput(connectedThreshold->GetOutput());
-    //volumeCalc->SetInput(resample2Filter->GetOutput());
-    volumeCalc->SetInsideValue(m_insideMaskValue);
-
-    try
-    {
-        volumeCalc->Update();
-    }
-    catch(itk::ExceptionObject &excep)
-    {
-        DEBUG_LOG("Exception caught !");
-        DEBUG_LOG(excep.what());
-    }
+    fillConnectedRegion(maskAux, m_insideMaskValue - 1, m_insideMaskValue + 1);
     t4 = clock();
     DEBUG_LOG("Estudi temps:");
     DEBUG_LOG(QString("Resample1    : %1").arg((double)(t8 - t7) / 1000000.0));
@@ -438,11 +317,6 @@ double StrokeSegmentationMethod::applyCleanSkullMethod()
     DEBUG_LOG(QString("ConnectedThrd: %1").arg((double)(t4 - t3) / 1000000.0));
     DEBUG_LOG(QString("TOTAL        : %1").arg((double)(t4 - t7) / 1000000.0));
 
-    m_volume = volumeCalc->GetVolume();
-    m_cont = volumeCalc->GetVolumeCount();
-
-    m_Mask->setData(volumeCalc->GetOutput());
-
     return m_volume;
 }
 
@@ -538,8 +412,6 @@ double StrokeSegmentationMethod::applyMethodEdema(Volume *lesionMask)
     typedef itk::BinaryThresholdImageFilter<InternalImageType, Volume::ItkImageType> ThresholdingFilterType;
     typedef itk::FastMarchingImageFilter<InternalImageType, InternalImageType> FastMarchingFilterType;
 
-    typedef itk::BinaryBallStructuringElement<Volume::ItkPixelType, Volume::VDimension> StructuringElementType;
-    typedef itk::BinaryDilateImageFilter<Volume::ItkImageType, Volume::ItkImageType, StructuringElementType> DilateFilterType;
 
     typedef itk::ResampleImageFilter<Volume::ItkImageType, Volume::ItkImageType> ResampleFilterType;
     typedef itk::AffineTransform<double, 3> TransformType;
@@ -551,24 +423,8 @@ double StrokeSegmentationMethod::applyMethodEdema(Volume *lesionMask)
    unsigned long t1, t2, t3, t4, t5, t6, t7, t8;
 
    // Ampliem la màscara per evitar el partial volume effect
-   DilateFilterType::Pointer binaryDilate = DilateFilterType::New();
-
-    StructuringElementType::SizeType radiusDilate;
-    radiusDilate[0] = 2;
-    radiusDilate[1] = 2;
-    radiusDilate[2] = 1;
-    StructuringElementType structuringElementDilate;
-    // 3x3 structuring element
-    structuringElementDilate.SetRadius(radiusDilate);
-    structuringElementDilate.CreateStructuringElement();
-
-    binaryDilate->SetDilateValue(m_insideMaskValue);
-    binaryDilate->SetKernel(structuringElementDilate);
-    binaryDilate->SetInput(m_Mask->getItkData());
-    //binaryDilate->SetInput(resampleMaskFilter->GetOutput());
-
     t1 = clock();
-    binaryDilate->Update();
+    Volume::ItkImageType::Pointer dilatedMask = dilate(m_Mask->getItkData(), 2, 2, 1, m_insideMaskValue);
 
     // Resamplagem la imatge per tal de que tingui un vòxel isomètric (el mètode ho requereix)
     ResampleFilterType::Pointer resampleFilter = ResampleFilterType::New();
@@ -661,7 +517,7 @@ double StrokeSegmentationMethod::applyMethodEdema(Volume *lesionMask)
 
     resampleMaskFilter->SetSize(newsize);
     //resampleMaskFilter->SetInput(m_Mask->getItkData());
-    resampleMaskFilter->SetInput(binaryDilate->GetOutput());
+    resampleMaskFilter->SetInput(dilatedMask);
     resampleMaskFilter->Update();
     t3 = clock();
 
@@ -676,7 +532,7 @@ double StrokeSegmentationMethod::applyMethodEdema(Volume *lesionMask)
     // Fi resample
 
     itk::ImageRegionIterator<Volume::ItkImageType> mainIt(resampleFilter->GetOutput(), resampleFilter->GetOutput()->GetBufferedRegion());
-    itk::ImageRegionIterator<Volume::ItkImageType> maskIt(binaryDilate->GetOutput(), binaryDilate->GetOutput()->GetBufferedRegion());
+    itk::ImageRegionIterator<Volume::ItkImageType> maskIt(dilatedMask, dilatedMask->GetBufferedRegion());
 
     // Compute image statistics
     const unsigned int MeasurementVectorLength = 1;
@@ -1004,28 +860,11 @@ double StrokeSegmentationMethod::applyMethodEdema2(Volume *lesionMask)
     typedef itk::BinaryThresholdImageFilter<InternalImageType, Volume::ItkImageType> ThresholdingFilterType;
     typedef itk::FastMarchingImageFilter<InternalImageType, InternalImageType> FastMarchingFilterType;
 
-    typedef itk::BinaryBallStructuringElement<Volume::ItkPixelType, Volume::VDimension> StructuringElementType;
-    typedef itk::BinaryDilateImageFilter<Volume::ItkImageType, Volume::ItkImageType, StructuringElementType> DilateFilterType;
-
-    DilateFilterType::Pointer binaryDilate = DilateFilterType::New();
-
-    StructuringElementType::SizeType radiusDilate;
-    radiusDilate[0] = 2;
-    radiusDilate[1] = 2;
-    radiusDilate[2] = 1;
-    StructuringElementType structuringElementDilate;
-    // 3x3 structuring element
-    structuringElementDilate.SetRadius(radiusDilate);
-    structuringElementDilate.CreateStructuringElement();
-
-    binaryDilate->SetDilateValue(m_insideMaskValue);
-    binaryDilate->SetKernel(structuringElementDilate);
-    binaryDilate->SetInput(m_Mask->getItkData());
 
-    binaryDilate->Update();
+    Volume::ItkImageType::Pointer dilatedMask = dilate(m_Mask->getItkData(), 2, 2, 1, m_insideMaskValue);
 
     itk::ImageRegionIterator<Volume::ItkImageType> mainIt(m_Volume->getItkData(), m_Volume->getItkData()->GetBufferedRegion());
-    itk::ImageRegionIterator<Volume::ItkImageType> maskIt(binaryDilate->GetOutput(), binaryDilate->GetOutput()->GetBufferedRegion());
+    itk::ImageRegionIterator<Volume::ItkImageType> maskIt(dilatedMask, dilatedMask->GetBufferedRegion());
 
     // COmpute image statistics
     const unsigned int MeasurementVectorLength = 1;
@@ -1278,57 +1117,38 @@ double StrokeSegmentationMethod::erfc(double x)
 
 double StrokeSegmentationMethod::applyVentriclesMethod()
 {
-    typedef float InternalPixelType;
-    typedef itk::Image<InternalPixelType, 3> InternalImageType;
-
-    typedef itk::CastImageFilter<Volume::ItkImageType, InternalImageType> InputCastingFilterType;
-    typedef itk::CastImageFilter<InternalImageType, Volume::ItkImageType> OutputCastingFilterType;
-    typedef itk::ConnectedThresholdImageFilter<InternalImageType, InternalImageType> ConnectedFilterType;
-    typedef itk::VolumeCalculatorImageFilter<Volume::ItkImageType> VolumeCalcFilterType;
-
-    InputCastingFilterType::Pointer incaster = InputCastingFilterType::New();
-    OutputCastingFilterType::Pointer outcaster = OutputCastingFilterType::New();
-    ConnectedFilterType::Pointer connectedThreshold = ConnectedFilterType::New();
-    VolumeCalcFilterType::Pointer volumeCalc = VolumeCalcFilterType::New();
-
-    incaster->SetInput(m_Volume->getItkData());
-    // Comentem aquesta línia per fer el filtratge
-    connectedThreshold->SetInput(incaster->GetOutput());
-    outcaster->SetInput(connectedThreshold->GetOutput());
-    volumeCalc->SetInput(outcaster->GetOutput());
+    DEBUG_LOG(QString("Histogram parameters: %1,%2").arg(m_lowerThreshold).arg(m_upperThreshold));
 
-    connectedThreshold->SetLower(m_lowerThreshold);
-    connectedThreshold->SetUpper(m_upperThreshold);
-    connectedThreshold->SetReplaceValue(m_insideMaskValue);
+    return fillConnectedRegion(m_Volume->getItkData(), m_lowerThreshold, m_upperThreshold);
+}
 
-    InternalImageType::IndexType seedIndex;
-    InternalImageType::PointType seedPoint;
+double StrokeSegmentationMethod::fillConnectedRegion(Volume::ItkImageType *image, double lower, double upper)
+{
+    Volume::ItkImageType::IndexType seedIndex;
+    Volume::ItkImageType::PointType seedPoint;
     seedPoint[0] = m_px;
     seedPoint[1] = m_py;
     seedPoint[2] = m_pz;
     m_Volume->getItkData()->TransformPhysicalPointToIndex(seedPoint, seedIndex);
-    connectedThreshold->SetSeed(seedIndex);
-
-    volumeCalc->SetInsideValue(m_insideMaskValue);
-
-    std::cout << "Init filter" << std::endl;
-    std::cout << "Parameters: " << seedIndex << std::endl;
-    std::cout << "Histogram parameters: " << m_lowerThreshold << " " << m_upperThreshold << std::endl;
 
-    try
-    {
-        volumeCalc->Update();
-    }
-    catch(itk::ExceptionObject &excep)
+    Volume::ItkImageType::IndexType startIndex = image->GetBufferedRegion().GetIndex();
+    int seed[3];
+    for (int i = 0; i < 3; i++)
     {
-        DEBUG_LOG("Exception caught !");
-        DEBUG_LOG(excep.what());
+        seed[i] = seedIndex[i] - startIndex[i];
     }
+    int dimensions[3];
+    getDimensions(image, dimensions);
 
-    m_volume = volumeCalc->GetVolume();
-    m_cont = volumeCalc->GetVolumeCount();
+    Volume::ItkImageType::Pointer mask = createImage(image, 0);
+    m_cont = SegmentationPrimitives::floodFill(image->GetBufferPointer(), mask->GetBufferPointer(), dimensions, seed, lower, upper,
+                                               static_cast<Volume::ItkPixelType>(m_insideMaskValue));
 
-    m_Mask->setData(volumeCalc->GetOutput());
+    const Volume::ItkImageType::SpacingType &spacing = image->GetSpacing();
+    m_volume = m_cont * spacing[0] * spacing[1] * spacing[2];
+    DEBUG_LOG(QString("MCONT>%1").arg(m_cont));
+
+    m_Mask->setData(mask);
 
     return m_volume;
 }
@@ -1448,19 +1268,9 @@ void StrokeSegmentationMethod::applyMethod2()
 
 int StrokeSegmentationMethod::computeSizeMask()
 {
-    typedef itk::ImageRegionIterator<Volume::ItkImageType> IteratorType;
-    IteratorType imIt(m_Mask->getItkData(), m_Mask->getItkData()->GetBufferedRegion());
-    int cont = 0;
-
-    imIt.GoToBegin();
-    while (!imIt.IsAtEnd())
-    {
-        if (imIt.Value() == m_insideMaskValue)
-        {
-            cont++;
-        }
-        ++imIt;
-    }
+    Volume::ItkImageType *mask = m_Mask->getItkData();
+    int cont = SegmentationPrimitives::count(mask->GetBufferPointer(), mask->GetBufferedRegion().GetNumberOfPixels(),
+                                             static_cast<Volume::ItkPixelType>(m_insideMaskValue));
     DEBUG_LOG(QString("VolumePelo = %1").arg(cont));
 
     return cont;
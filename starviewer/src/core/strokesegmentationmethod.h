@@ -28,7 +28,6 @@ public:
 
     double applyMethod();
     double applyMethodVTK();
-    void applyMethodVTKRecursive(vtkImageData *imMask, int a, int b, int c, int prof);
 
     /// Neteja els casos propers al crani
     double applyCleanSkullMethod();
@@ -175,6 +174,10 @@ private:
     /// Retorna quants voxels != de 0 hi ha a la màscara
     int computeSizeMask();
 
+    /// Fills a new mask with the region of image connected to the seed whose values are between lower and upper, both included, and sets it as
+    /// m_Mask. Updates m_cont and m_volume and returns the volume of the region.
+    double fillConnectedRegion(Volume::ItkImageType *image, double lower, double upper);
+
 };
 
 }
@@ -0,0 +1,309 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "timeactivitycurvecalculator.h"
+
+#include "logging.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QtConcurrentMap>
+
+#include <vtkImageData.h>
+
+#include <algorithm>
+
+namespace udg {
+
+TimeActivityCurveCalculator::TimeActivityCurveCalculator()
+ : m_scalars(0), m_scalarType(VTK_DOUBLE), m_phaseIncrement(0), m_numberOfPhases(0), m_slice(0), m_curvesAreValid(false)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        m_extent[i * 2] = 0;
+        m_extent[i * 2 + 1] = -1;
+        m_origin[i] = 0.0;
+        m_spacing[i] = 1.0;
+        m_increments[i] = 0;
+    }
+
+    m_curves.numberOfVoxels = 0;
+}
+
+TimeActivityCurveCalculator::~TimeActivityCurveCalculator()
+{
+}
+
+void TimeActivityCurveCalculator::setInput(vtkImageData *image, int numberOfPhases)
+{
+    if (image && image == m_input && numberOfPhases == m_numberOfPhases)
+    {
+        return;
+    }
+
+    m_input = image;
+    m_temporalImage = 0;
+    m_scalars = 0;
+    m_numberOfPhases = 0;
+
+    if (image && numberOfPhases > 0)
+    {
+        int *extent = image->GetExtent();
+        vtkIdType *increments = image->GetIncrements();
+
+        m_scalars = image->GetScalarPointer();
+        m_scalarType = image->GetScalarType();
+        m_numberOfPhases = numberOfPhases;
+
+        // The spatial z index is the slice and consecutive slices of the same phase are numberOfPhases z indices apart
+        m_extent[0] = extent[0];
+        m_extent[1] = extent[1];
+        m_extent[2] = extent[2];
+        m_extent[3] = extent[3];
+        m_extent[4] = extent[4] / numberOfPhases;
+        m_extent[5] = m_extent[4] + (extent[5] - extent[4] + 1) / numberOfPhases - 1;
+        std::copy(image->GetOrigin(), image->GetOrigin() + 3, m_origin);
+        std::copy(image->GetSpacing(), image->GetSpacing() + 3, m_spacing);
+        m_increments[0] = increments[0];
+        m_increments[1] = increments[1];
+        m_increments[2] = increments[2] * numberOfPhases;
+        m_phaseIncrement = increments[2];
+    }
+
+    invalidate();
+}
+
+void TimeActivityCurveCalculator::setTemporalImage(TemporalImageType *image, const double origin[3], const double spacing[3])
+{
+    if (image && image == m_temporalImage && std::equal(origin, origin + 3, m_origin) && std::equal(spacing, spacing + 3, m_spacing))
+    {
+        return;
+    }
+
+    m_input = 0;
+    m_temporalImage = image;
+    m_scalars = 0;
+    m_numberOfPhases = 0;
+
+    if (image)
+    {
+        TemporalImageType::RegionType region = image->GetBufferedRegion();
+        TemporalImageType::SizeType size = region.GetSize();
+        TemporalImageType::IndexType index = region.GetIndex();
+
+        m_scalars = image->GetBufferPointer();
+        m_scalarType = VTK_DOUBLE;
+        m_numberOfPhases = size[0];
+
+        // The phase is the fastest varying index, so the whole series of a voxel is contiguous
+        m_phaseIncrement = 1;
+        qint64 increment = size[0];
+        for (int i = 0; i < 3; i++)
+        {
+            m_extent[i * 2] = index[i + 1];
+            m_extent[i * 2 + 1] = index[i + 1] + size[i + 1] - 1;
+            m_origin[i] = origin[i];
+            m_spacing[i] = spacing[i];
+            m_increments[i] = increment;
+            increment *= size[i + 1];
+        }
+    }
+
+    invalidate();
+}
+
+int TimeActivityCurveCalculator::getNumberOfPhases() const
+{
+    return m_numberOfPhases;
+}
+
+void TimeActivityCurveCalculator::setContour(const QVector<QPointF> &contour, const OrthogonalPlane &plane, int slice)
+{
+    if (contour == m_contour && plane == m_plane && slice == m_slice)
+    {
+        return;
+    }
+
+    if (plane == m_plane && slice == m_slice)
+    {
+        // The cached rows are still valid, only the ones whose spans change will be measured again
+        m_curvesAreValid = false;
+    }
+    else
+    {
+        invalidate();
+    }
+
+    m_contour = contour;
+    m_plane = plane;
+    m_slice = slice;
+}
+
+const TimeActivityCurveCalculator::Curves& TimeActivityCurveCalculator::getCurves()
+{
+    if (m_curvesAreValid)
+    {
+        return m_curves;
+    }
+
+    QMap<int, QVector<ContourRasterizer::Span> > rowSpans = getRowSpans();
+
+    // Discard the rows that are no longer in the ROI or whose spans have changed and add the new ones
+    QMap<int, Row>::iterator it = m_rows.begin();
+    while (it != m_rows.end())
+    {
+        if (rowSpans.value(it.key()) != it->spans)
+        {
+            it = m_rows.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    QList<int> newRows;
+    for (QMap<int, QVector<ContourRasterizer::Span> >::const_iterator spans = rowSpans.constBegin(); spans != rowSpans.constEnd(); ++spans)
+    {
+        if (!m_rows.contains(spans.key()))
+        {
+            m_rows[spans.key()].spans = spans.value();
+            newRows.append(spans.key());
+        }
+    }
+
+    // Get the pointers here to avoid calling non-const methods of the map from several threads
+    QVector<Row*> outdatedRows;
+    foreach (int row, newRows)
+    {
+        outdatedRows.append(&m_rows[row]);
+    }
+
+    QtConcurrent::blockingMap(outdatedRows, [this](Row *row)
+    {
+        switch (m_scalarType)
+        {
+            vtkTemplateMacro(measureRow(static_cast<const VTK_TT*>(m_scalars), *row));
+        }
+    });
+
+    QVector<ROIData> phaseData(m_numberOfPhases);
+    foreach (const Row &row, m_rows)
+    {
+        for (int phase = 0; phase < m_numberOfPhases; phase++)
+        {
+            phaseData[phase].add(row.phaseData.at(phase));
+        }
+    }
+
+    m_curves.numberOfVoxels = 0;
+    m_curves.mean.resize(m_numberOfPhases);
+    m_curves.minimum.resize(m_numberOfPhases);
+    m_curves.maximum.resize(m_numberOfPhases);
+    m_curves.standardDeviation.resize(m_numberOfPhases);
+
+    for (int phase = 0; phase < m_numberOfPhases; phase++)
+    {
+        const ROIData &data = phaseData.at(phase);
+        bool isEmpty = data.getNumberOfVoxels() == 0;
+        m_curves.numberOfVoxels = data.getNumberOfVoxels();
+        m_curves.mean[phase] = data.getMean();
+        m_curves.minimum[phase] = isEmpty ? 0.0 : data.getMinimum();
+        m_curves.maximum[phase] = isEmpty ? 0.0 : data.getMaximum();
+        m_curves.standardDeviation[phase] = isEmpty ? 0.0 : data.getStandardDeviation();
+    }
+
+    m_curvesAreValid = true;
+    return m_curves;
+}
+
+bool TimeActivityCurveCalculator::saveCsv(const Curves &curves, const QString &fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+    {
+        WARN_LOG(QString("Can't write time-activity curves to %1").arg(fileName));
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "Phase;Mean;Minimum;Maximum;Standard deviation\n";
+
+    for (int phase = 0; phase < curves.mean.size(); phase++)
+    {
+        out << phase << ";" << QString::number(curves.mean.at(phase), 'g', 10) << ";" << QString::number(curves.minimum.at(phase), 'g', 10) << ";"
+            << QString::number(curves.maximum.at(phase), 'g', 10) << ";" << QString::number(curves.standardDeviation.at(phase), 'g', 10) << "\n";
+    }
+
+    return true;
+}
+
+void TimeActivityCurveCalculator::invalidate()
+{
+    m_rows.clear();
+    m_curvesAreValid = false;
+}
+
+QMap<int, QVector<ContourRasterizer::Span> > TimeActivityCurveCalculator::getRowSpans() const
+{
+    QMap<int, QVector<ContourRasterizer::Span> > rowSpans;
+
+    int xIndex, yIndex, zIndex;
+    m_plane.getXYZIndexes(xIndex, yIndex, zIndex);
+
+    if (!m_scalars || m_slice < m_extent[zIndex * 2] || m_slice > m_extent[zIndex * 2 + 1])
+    {
+        return rowSpans;
+    }
+
+    double origin[2] = { m_origin[xIndex], m_origin[yIndex] };
+    double spacing[2] = { m_spacing[xIndex], m_spacing[yIndex] };
+    int extent[4] = { m_extent[xIndex * 2], m_extent[xIndex * 2 + 1], m_extent[yIndex * 2], m_extent[yIndex * 2 + 1] };
+
+    foreach (const ContourRasterizer::Span &span, ContourRasterizer::getSpans(m_contour, origin, spacing, extent))
+    {
+        rowSpans[span.row].append(span);
+    }
+
+    return rowSpans;
+}
+
+template <typename T>
+void TimeActivityCurveCalculator::measureRow(const T *scalars, Row &row) const
+{
+    int xIndex, yIndex, zIndex;
+    m_plane.getXYZIndexes(xIndex, yIndex, zIndex);
+
+    qint64 rowOffset = (row.spans.first().row - m_extent[yIndex * 2]) * m_increments[yIndex]
+                     + (m_slice - m_extent[zIndex * 2]) * m_increments[zIndex];
+    row.phaseData.fill(ROIData(), m_numberOfPhases);
+
+    for (int phase = 0; phase < m_numberOfPhases; phase++)
+    {
+        const T *rowScalars = scalars + phase * m_phaseIncrement + rowOffset;
+        ROIData &data = row.phaseData[phase];
+
+        foreach (const ContourRasterizer::Span &span, row.spans)
+        {
+            const T *pointer = rowScalars + (span.firstColumn - m_extent[xIndex * 2]) * m_increments[xIndex];
+            for (int x = span.firstColumn; x <= span.lastColumn; x++, pointer += m_increments[xIndex])
+            {
+                data.addValue(static_cast<double>(*pointer));
+            }
+        }
+    }
+}
+
+} // End namespace udg
@@ -0,0 +1,128 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGTIMEACTIVITYCURVECALCULATOR_H
+#define UDGTIMEACTIVITYCURVECALCULATOR_H
+
+#include "contourrasterizer.h"
+#include "orthogonalplane.h"
+#include "roidata.h"
+
+#include <QMap>
+#include <QPointF>
+#include <QVector>
+
+#include <itkImage.h>
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+namespace udg {
+
+/**
+    Computes the time-activity curves of a 2D ROI over all the phases of a temporal series.
+
+    The series can be a vtkImageData with the phases interleaved along z as in VolumePixelData, so the voxels of slice s of phase p are at
+    z index s * numberOfPhases + p, or a 4D ITK image whose first index is the phase, as the ones computed in the perfusion extension.
+
+    The ROI is a contour in an orthogonal plane of a slice, given with the coordinates of the plane axes in pixel data space. A voxel belongs
+    to the ROI when its center is inside the contour, as computed by ContourRasterizer. The statistics of each row of the ROI are cached for
+    all the phases, so when the contour is edited in the same plane and slice, as while it's being drawn, only the rows whose spans have
+    changed are measured again, in parallel. The curves are cached until the input or the contour change, so setting the same contour again
+    is free.
+  */
+class TimeActivityCurveCalculator {
+public:
+    /// Temporal image with the phase as first index and x, y and z as the following ones
+    typedef itk::Image<double, 4> TemporalImageType;
+
+    /// Statistics of the ROI voxels in each phase
+    struct Curves {
+        QVector<double> mean;
+        QVector<double> minimum;
+        QVector<double> maximum;
+        QVector<double> standardDeviation;
+        /// Number of voxels of the ROI, the same in all phases
+        int numberOfVoxels;
+    };
+
+    TimeActivityCurveCalculator();
+    ~TimeActivityCurveCalculator();
+
+    /// Sets a series with the given number of phases interleaved along z. Only the first scalar component is used.
+    void setInput(vtkImageData *image, int numberOfPhases);
+
+    /// Sets a temporal image. Its origin and spacing are taken from the given ones, because the temporal images of the perfusion extension
+    /// don't keep the geometry of the series they come from.
+    void setTemporalImage(TemporalImageType *image, const double origin[3], const double spacing[3]);
+
+    /// Returns the number of phases of the input
+    int getNumberOfPhases() const;
+
+    /// Sets the ROI as a contour in the given plane and slice. The coordinates of the points are the ones of the plane axes.
+    void setContour(const QVector<QPointF> &contour, const OrthogonalPlane &plane, int slice);
+
+    /// Returns the curves of the ROI, computing them if needed
+    const Curves& getCurves();
+
+    /// Saves the given curves in CSV format, with a row for each phase. Returns false if the file can't be written.
+    static bool saveCsv(const Curves &curves, const QString &fileName);
+
+private:
+    /// Spans of a row of the ROI and the statistics of their voxels in each phase
+    struct Row {
+        QVector<ContourRasterizer::Span> spans;
+        QVector<ROIData> phaseData;
+    };
+
+    /// Discards the cached rows and the curves
+    void invalidate();
+
+    /// Returns the spans of the contour grouped by row
+    QMap<int, QVector<ContourRasterizer::Span> > getRowSpans() const;
+
+    /// Measures the voxels of the spans of the given row in each phase
+    template <typename T>
+    void measureRow(const T *scalars, Row &row) const;
+
+private:
+    /// The inputs, only one of them is set
+    vtkSmartPointer<vtkImageData> m_input;
+    TemporalImageType::Pointer m_temporalImage;
+
+    /// Layout of the scalars of the input in the spatial axes and along the phases
+    const void *m_scalars;
+    int m_scalarType;
+    int m_extent[6];
+    double m_origin[3];
+    double m_spacing[3];
+    qint64 m_increments[3];
+    qint64 m_phaseIncrement;
+    int m_numberOfPhases;
+
+    /// The ROI
+    QVector<QPointF> m_contour;
+    OrthogonalPlane m_plane;
+    int m_slice;
+
+    /// Cached rows of the ROI by row index
+    QMap<int, Row> m_rows;
+
+    Curves m_curves;
+    bool m_curvesAreValid;
+};
+
+} // End namespace udg
+
+#endif
@@ -47,6 +47,7 @@
 #include "automaticsynchronizationtool.h"
 #include "magnifyingglasstool.h"
 #include "circletool.h"
+#include "voitool.h"
 #include "perpendiculardistancetool.h"
 
 #include "shortcutmanager.h"
@@ -188,6 +189,10 @@ Tool* ToolRegistry::getTool(const QString &toolName, QViewer *viewer)
     {
         tool = new CircleTool(viewer);
     }
+    else if (toolName == "VOITool")
+    {
+        tool = new VOITool(viewer);
+    }
     else if (toolName == "PerpendicularDistanceTool")
     {
         tool = new PerpendicularDistanceTool(viewer);
@@ -273,7 +278,7 @@ QAction* ToolRegistry::getToolAction(const QString &toolName)
         toolAction->setText(tr("Magical ROI"));
         toolAction->setIcon(QIcon(":/images/icons/tools-wizard.svg"));
         toolAction->setShortcuts(ShortcutManager::getShortcuts(Shortcuts::MagicROITool));
-        statusTip = tr("Enable/Disable Magic tool");
+        statusTip = tr("Enable/Disable Magic tool. Hold Shift when clicking to also measure the volume of the region");
         toolTip = toolAction->text();
     }
     else if (toolName == "ScreenShotTool")
@@ -440,6 +445,13 @@ QAction* ToolRegistry::getToolAction(const QString &toolName)
         statusTip = tr("Enable/Disable Circle tool");
         toolTip = toolAction->text();
     }
+    else if (toolName == "VOITool")
+    {
+        toolAction->setText(tr("Spherical VOI"));
+        toolAction->setIcon(QIcon(":/images/icons/draw-circle.svg"));
+        statusTip = tr("Enable/Disable spherical VOI tool");
+        toolTip = toolAction->text();
+    }
     else if (toolName == "PerpendicularDistanceTool")
     {
         toolAction->setText(tr("TA-GT"));
@@ -20,6 +20,8 @@
 #include "volume.h"
 #include "volumepixeldataiterator.h"
 
+#include <QtConcurrentMap>
+
 #include <vtkCommand.h>
 #include <vtkRenderWindowInteractor.h>
 
@@ -200,11 +202,7 @@ void TransDifferenceTool::initializeDifferenceImage()
         m_myData->setDifferenceVolume(differenceVolume);
     }
 
-    int k;
-    for (k = ext[4]; k <= ext[5]; k++)
-    {
-        this->computeSingleDifferenceImage(0, 0, k);
-    }
+    this->computeDifferenceImages(false);
 
     double range[2];
     differenceVolume->getScalarRange(range);
@@ -238,6 +236,42 @@ void TransDifferenceTool::setSingleDifferenceImage(int dx, int dy)
     m_myData->setSliceTranslationY(m_2DViewer->getCurrentSlice(), dy);
 }
 
+void TransDifferenceTool::updateDifferenceImages()
+{
+    if (m_myData->getInputVolume() == 0 || m_myData->getDifferenceVolume() == 0)
+    {
+        return;
+    }
+
+    this->computeDifferenceImages(true);
+    m_myData->getDifferenceVolume()->getVtkData()->Modified();
+    m_viewer->render();
+}
+
+void TransDifferenceTool::computeDifferenceImages(bool applyTranslations)
+{
+    int extent[6];
+    m_myData->getInputVolume()->getExtent(extent);
+
+    // The translations are read here so that the tasks don't touch the tool data
+    QVector<QPair<int, QPoint> > slices;
+    for (int slice = extent[4]; slice <= extent[5]; slice++)
+    {
+        QPoint translation;
+        if (applyTranslations)
+        {
+            translation = QPoint(m_myData->getSliceTranslationX(slice), m_myData->getSliceTranslationY(slice));
+        }
+        slices.append(qMakePair(slice, translation));
+    }
+
+    // Each slice only writes its own slice of the difference volume
+    QtConcurrent::blockingMap(slices, [this](const QPair<int, QPoint> &slice)
+    {
+        this->computeSingleDifferenceImage(slice.second.x(), slice.second.y(), slice.first);
+    });
+}
+
 void TransDifferenceTool::computeSingleDifferenceImage(int dx, int dy, int slice)
 {
     // \TODO: Fer-ho amb un filtre
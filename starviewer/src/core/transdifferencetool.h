@@ -47,6 +47,9 @@ public:
     /// Assigna una determinada translació a una llesca
     void setSingleDifferenceImage(int dx, int dy);
 
+    /// Recomputes the difference image of every slice with the translations of the tool data, in parallel, and renders it
+    void updateDifferenceImages();
+
 private slots:
     /// Comença la translació
     void startTransDifference();
@@ -63,6 +66,11 @@ private slots:
     /// Incrementa els valors dels paràmeters a la tranformació actual
     void increaseSingleDifferenceImage(int dx, int dy);
 
+private:
+    /// Computes the difference image of every slice in parallel, with the translations of the tool data if applyTranslations is true and
+    /// without translation otherwise
+    void computeDifferenceImages(bool applyTranslations);
+
 private:
     /// Dades específiques de la tool
     TransDifferenceToolData *m_myData;
@@ -0,0 +1,439 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "voistatisticscalculator.h"
+
+#include "standarduptakevaluemeasurehandler.h"
+
+#include <QtConcurrentMap>
+
+#include <vtkImageData.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace udg {
+
+// Radius of a sphere of 1000 mm³: cbrt(3 * 1000 / (4 * pi))
+const double VOIStatisticsCalculator::PeakSphereRadius = 6.2035049089940;
+
+namespace {
+
+/// Returns a pointer to the voxel at the given index
+template <typename T>
+const T* getVoxelPointer(const T *scalars, const vtkIdType increments[3], const int extent[6], int x, int y, int z)
+{
+    return scalars + (x - extent[0]) * increments[0] + (y - extent[2]) * increments[1] + (z - extent[4]) * increments[2];
+}
+
+/// Adds to data the values of the voxels of the given spans of slice z and updates maximumIndex with the index of the first maximum found
+template <typename T, typename SpanVector>
+void accumulateSpans(const T *scalars, const vtkIdType increments[3], const int extent[6], int z, const SpanVector &spans, ROIData &data,
+                     int maximumIndex[3])
+{
+    for (const auto &span : spans)
+    {
+        const T *pointer = getVoxelPointer(scalars, increments, extent, span.firstColumn, span.row, z);
+        for (int x = span.firstColumn; x <= span.lastColumn; x++, pointer += increments[0])
+        {
+            double value = *pointer;
+            if (data.getNumberOfVoxels() == 0 || value > data.getMaximum())
+            {
+                maximumIndex[0] = x;
+                maximumIndex[1] = span.row;
+                maximumIndex[2] = z;
+            }
+            data.addValue(value);
+        }
+    }
+}
+
+/// Returns the number of voxels of the given spans of slice z whose value is at least the given threshold
+template <typename T, typename SpanVector>
+int countSpanVoxelsAbove(const T *scalars, const vtkIdType increments[3], const int extent[6], int z, const SpanVector &spans, double threshold)
+{
+    int count = 0;
+    for (const auto &span : spans)
+    {
+        const T *pointer = getVoxelPointer(scalars, increments, extent, span.firstColumn, span.row, z);
+        for (int x = span.firstColumn; x <= span.lastColumn; x++, pointer += increments[0])
+        {
+            if (*pointer >= threshold)
+            {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+}
+
+VOIStatisticsCalculator::VOIStatisticsCalculator()
+ : m_numberOfPhases(1), m_shape(NoShape), m_sphereRadius(0.0), m_metabolicVolumeThresholdType(FractionOfMaximumThreshold),
+   m_metabolicVolumeThreshold(0.41), m_standardizedUptakeValueFactor(0.0)
+{
+    m_sphereCenter[0] = m_sphereCenter[1] = m_sphereCenter[2] = 0.0;
+}
+
+VOIStatisticsCalculator::~VOIStatisticsCalculator()
+{
+}
+
+void VOIStatisticsCalculator::setInput(vtkImageData *image, int numberOfPhases)
+{
+    m_input = image;
+    m_numberOfPhases = qMax(1, numberOfPhases);
+
+    m_sliceStatistics.fill(QVector<SliceStatistics>(getNumberOfSlicesPerPhase()), m_numberOfPhases);
+    invalidateAllSlices();
+}
+
+int VOIStatisticsCalculator::getNumberOfSlicesPerPhase() const
+{
+    if (!m_input)
+    {
+        return 0;
+    }
+
+    int *extent = m_input->GetExtent();
+    return (extent[5] - extent[4] + 1) / m_numberOfPhases;
+}
+
+void VOIStatisticsCalculator::setSphere(const double center[3], double radius)
+{
+    m_shape = SphereShape;
+    m_sphereCenter[0] = center[0];
+    m_sphereCenter[1] = center[1];
+    m_sphereCenter[2] = center[2];
+    m_sphereRadius = radius;
+    m_contours.clear();
+
+    invalidateAllSlices();
+}
+
+void VOIStatisticsCalculator::setContour(int slice, const QVector<QPointF> &contour)
+{
+    if (m_shape != ContoursShape)
+    {
+        m_shape = ContoursShape;
+        invalidateAllSlices();
+    }
+
+    m_contours.insert(slice, contour);
+    invalidateSlice(slice);
+}
+
+void VOIStatisticsCalculator::removeContour(int slice)
+{
+    if (m_contours.remove(slice) > 0)
+    {
+        invalidateSlice(slice);
+    }
+}
+
+void VOIStatisticsCalculator::clearVOI()
+{
+    m_shape = NoShape;
+    m_contours.clear();
+
+    invalidateAllSlices();
+}
+
+void VOIStatisticsCalculator::setMetabolicVolumeThreshold(MetabolicVolumeThresholdType type, double threshold)
+{
+    m_metabolicVolumeThresholdType = type;
+    m_metabolicVolumeThreshold = threshold;
+}
+
+void VOIStatisticsCalculator::setStandardizedUptakeValueImage(Image *image)
+{
+    m_standardizedUptakeValueFactor = 0.0;
+
+    if (image)
+    {
+        StandardUptakeValueMeasureHandler suvHandler;
+        suvHandler.setImage(image);
+        if (suvHandler.canComputePreferredFormula())
+        {
+            // All the formulas are proportional to the activity concentration
+            m_standardizedUptakeValueFactor = suvHandler.computePreferredFormula(1.0);
+        }
+    }
+}
+
+VOIStatisticsCalculator::Statistics VOIStatisticsCalculator::getStatistics(int phase)
+{
+    Statistics statistics;
+    statistics.peak = 0.0;
+    statistics.metabolicVolume = 0.0;
+    statistics.maximumIndex[0] = statistics.maximumIndex[1] = statistics.maximumIndex[2] = 0;
+    statistics.hasStandardizedUptakeValues = false;
+    statistics.standardizedUptakeValueMaximum = 0.0;
+    statistics.standardizedUptakeValuePeak = 0.0;
+    statistics.standardizedUptakeValueMean = 0.0;
+
+    if (!m_input || phase < 0 || phase >= m_numberOfPhases)
+    {
+        return statistics;
+    }
+
+    updateSliceStatistics(phase);
+
+    foreach (const SliceStatistics &sliceStatistics, m_sliceStatistics.at(phase))
+    {
+        if (sliceStatistics.data.getNumberOfVoxels() > 0
+            && (statistics.data.getNumberOfVoxels() == 0 || sliceStatistics.data.getMaximum() > statistics.data.getMaximum()))
+        {
+            std::copy(sliceStatistics.maximumIndex, sliceStatistics.maximumIndex + 3, statistics.maximumIndex);
+        }
+        statistics.data.add(sliceStatistics.data);
+    }
+
+    if (statistics.data.getNumberOfVoxels() == 0)
+    {
+        return statistics;
+    }
+
+    double *origin = m_input->GetOrigin();
+    double *spacing = m_input->GetSpacing();
+    int *extent = m_input->GetExtent();
+    vtkIdType *increments = m_input->GetIncrements();
+    void *scalars = m_input->GetScalarPointer();
+
+    // Peak: mean of the sphere centered at the maximum
+    int maximumSlice = (statistics.maximumIndex[2] - extent[4]) / m_numberOfPhases;
+    double peakCenter[3] = { origin[0] + statistics.maximumIndex[0] * spacing[0], origin[1] + statistics.maximumIndex[1] * spacing[1],
+                             origin[2] + (extent[4] / m_numberOfPhases + maximumSlice) * spacing[2] };
+    int sliceRadius = static_cast<int>(std::ceil(PeakSphereRadius / spacing[2]));
+    ROIData peakData;
+    int peakMaximumIndex[3];
+    for (int slice = qMax(0, maximumSlice - sliceRadius); slice <= qMin(getNumberOfSlicesPerPhase() - 1, maximumSlice + sliceRadius); slice++)
+    {
+        QVector<Span> spans = getSphereSpans(peakCenter, PeakSphereRadius, slice);
+        switch (m_input->GetScalarType())
+        {
+            vtkTemplateMacro(accumulateSpans(static_cast<const VTK_TT*>(scalars), increments, extent, getZIndex(slice, phase), spans, peakData,
+                                             peakMaximumIndex));
+        }
+    }
+    statistics.peak = peakData.getMean();
+
+    // Metabolic volume
+    double threshold = m_metabolicVolumeThreshold;
+    if (m_metabolicVolumeThresholdType == FractionOfMaximumThreshold)
+    {
+        threshold *= statistics.data.getMaximum();
+    }
+    else if (m_standardizedUptakeValueFactor > 0.0)
+    {
+        threshold /= m_standardizedUptakeValueFactor;
+    }
+    statistics.metabolicVolume = countVoxelsAbove(phase, threshold) * spacing[0] * spacing[1] * spacing[2];
+
+    if (m_standardizedUptakeValueFactor > 0.0)
+    {
+        statistics.hasStandardizedUptakeValues = true;
+        statistics.standardizedUptakeValueMaximum = statistics.data.getMaximum() * m_standardizedUptakeValueFactor;
+        statistics.standardizedUptakeValuePeak = statistics.peak * m_standardizedUptakeValueFactor;
+        statistics.standardizedUptakeValueMean = statistics.data.getMean() * m_standardizedUptakeValueFactor;
+    }
+
+    return statistics;
+}
+
+QVector<VOIStatisticsCalculator::Statistics> VOIStatisticsCalculator::getStatisticsOfAllPhases()
+{
+    QVector<Statistics> statistics;
+    for (int phase = 0; phase < m_numberOfPhases; phase++)
+    {
+        statistics.append(getStatistics(phase));
+    }
+
+    return statistics;
+}
+
+void VOIStatisticsCalculator::invalidateAllSlices()
+{
+    for (int phase = 0; phase < m_sliceStatistics.size(); phase++)
+    {
+        for (int slice = 0; slice < m_sliceStatistics[phase].size(); slice++)
+        {
+            m_sliceStatistics[phase][slice].isValid = false;
+        }
+    }
+}
+
+void VOIStatisticsCalculator::invalidateSlice(int slice)
+{
+    for (int phase = 0; phase < m_sliceStatistics.size(); phase++)
+    {
+        if (slice >= 0 && slice < m_sliceStatistics[phase].size())
+        {
+            m_sliceStatistics[phase][slice].isValid = false;
+        }
+    }
+}
+
+QVector<VOIStatisticsCalculator::Span> VOIStatisticsCalculator::getVOISpans(int slice) const
+{
+    switch (m_shape)
+    {
+        case SphereShape:
+            return getSphereSpans(m_sphereCenter, m_sphereRadius, slice);
+
+        case ContoursShape:
+            if (m_contours.contains(slice))
+            {
+                return getContourSpans(m_contours.value(slice));
+            }
+            break;
+
+        case NoShape:
+            break;
+    }
+
+    return QVector<Span>();
+}
+
+QVector<VOIStatisticsCalculator::Span> VOIStatisticsCalculator::getSphereSpans(const double center[3], double radius, int slice) const
+{
+    QVector<Span> spans;
+
+    double *origin = m_input->GetOrigin();
+    double *spacing = m_input->GetSpacing();
+    int *extent = m_input->GetExtent();
+
+    double z = origin[2] + (extent[4] / m_numberOfPhases + slice) * spacing[2];
+    double sliceRadiusSquared = radius * radius - (z - center[2]) * (z - center[2]);
+    if (sliceRadiusSquared < 0.0)
+    {
+        return spans;
+    }
+
+    double sliceRadius = std::sqrt(sliceRadiusSquared);
+    int firstRow = qMax(extent[2], static_cast<int>(std::ceil((center[1] - sliceRadius - origin[1]) / spacing[1])));
+    int lastRow = qMin(extent[3], static_cast<int>(std::floor((center[1] + sliceRadius - origin[1]) / spacing[1])));
+
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        double y = origin[1] + row * spacing[1];
+        double halfWidthSquared = sliceRadiusSquared - (y - center[1]) * (y - center[1]);
+        if (halfWidthSquared < 0.0)
+        {
+            continue;
+        }
+
+        double halfWidth = std::sqrt(halfWidthSquared);
+        Span span;
+        span.row = row;
+        span.firstColumn = qMax(extent[0], static_cast<int>(std::ceil((center[0] - halfWidth - origin[0]) / spacing[0])));
+        span.lastColumn = qMin(extent[1], static_cast<int>(std::floor((center[0] + halfWidth - origin[0]) / spacing[0])));
+        if (span.firstColumn <= span.lastColumn)
+        {
+            spans.append(span);
+        }
+    }
+
+    return spans;
+}
+
+QVector<VOIStatisticsCalculator::Span> VOIStatisticsCalculator::getContourSpans(const QVector<QPointF> &contour) const
+{
+    int *extent = m_input->GetExtent();
+    int planeExtent[4] = { extent[0], extent[1], extent[2], extent[3] };
+
+    return ContourRasterizer::getSpans(contour, m_input->GetOrigin(), m_input->GetSpacing(), planeExtent);
+}
+
+int VOIStatisticsCalculator::getZIndex(int slice, int phase) const
+{
+    return m_input->GetExtent()[4] + slice * m_numberOfPhases + phase;
+}
+
+void VOIStatisticsCalculator::updateSliceStatistics(int phase)
+{
+    QVector<int> outdatedSlices;
+    for (int slice = 0; slice < m_sliceStatistics.at(phase).size(); slice++)
+    {
+        if (!m_sliceStatistics.at(phase).at(slice).isValid)
+        {
+            outdatedSlices.append(slice);
+        }
+    }
+
+    if (outdatedSlices.isEmpty())
+    {
+        return;
+    }
+
+    // Get the pointer here to avoid calling non-const methods of the vector from several threads
+    SliceStatistics *sliceStatistics = m_sliceStatistics[phase].data();
+    int *extent = m_input->GetExtent();
+    vtkIdType *increments = m_input->GetIncrements();
+    void *scalars = m_input->GetScalarPointer();
+
+    QtConcurrent::blockingMap(outdatedSlices, [&](int slice)
+    {
+        SliceStatistics &statistics = sliceStatistics[slice];
+        statistics.data.clear();
+        statistics.maximumIndex[0] = statistics.maximumIndex[1] = statistics.maximumIndex[2] = 0;
+
+        QVector<Span> spans = getVOISpans(slice);
+        switch (m_input->GetScalarType())
+        {
+            vtkTemplateMacro(accumulateSpans(static_cast<const VTK_TT*>(scalars), increments, extent, getZIndex(slice, phase), spans, statistics.data,
+                                             statistics.maximumIndex));
+        }
+
+        statistics.isValid = true;
+    });
+}
+
+int VOIStatisticsCalculator::countVoxelsAbove(int phase, double threshold) const
+{
+    int numberOfSlices = getNumberOfSlicesPerPhase();
+    QVector<int> slices(numberOfSlices);
+    QVector<int> counts(numberOfSlices, 0);
+    for (int slice = 0; slice < numberOfSlices; slice++)
+    {
+        slices[slice] = slice;
+    }
+
+    int *sliceCounts = counts.data();
+    int *extent = m_input->GetExtent();
+    vtkIdType *increments = m_input->GetIncrements();
+    void *scalars = m_input->GetScalarPointer();
+
+    QtConcurrent::blockingMap(slices, [&](int slice)
+    {
+        QVector<Span> spans = getVOISpans(slice);
+        switch (m_input->GetScalarType())
+        {
+            vtkTemplateMacro(sliceCounts[slice] = countSpanVoxelsAbove(static_cast<const VTK_TT*>(scalars), increments, extent, getZIndex(slice, phase),
+                                                                       spans, threshold));
+        }
+    });
+
+    int count = 0;
+    foreach (int sliceCount, counts)
+    {
+        count += sliceCount;
+    }
+
+    return count;
+}
+
+} // End namespace udg
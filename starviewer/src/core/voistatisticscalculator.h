@@ -0,0 +1,165 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGVOISTATISTICSCALCULATOR_H
+#define UDGVOISTATISTICSCALCULATOR_H
+
+#include "contourrasterizer.h"
+#include "roidata.h"
+
+#include <QMap>
+#include <QPointF>
+#include <QVector>
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+namespace udg {
+
+class Image;
+
+/**
+    Computes statistics of a volume of interest (VOI) over the slices of every phase of an image.
+
+    The VOI can be a sphere or a stack of axial contours, one for each slice that has to be included. All coordinates are in pixel data space,
+    i.e. the space of the origin and spacing of the image. Phases are interleaved along z as in VolumePixelData, so the voxels of slice s of phase p
+    are at z index s * numberOfPhases + p. A voxel belongs to the VOI when its center is inside the sphere or the contour of its slice.
+
+    Slices are measured in parallel and the statistics of each slice are cached, so when the contour of a single slice is edited only that slice
+    is measured again. For each phase the following are computed:
+    - the statistics of the VOI voxels (mean, standard deviation, maximum, ...) in image units,
+    - the peak: the mean of the voxels inside a sphere of 1 cm³ centered at the maximum voxel of the VOI,
+    - the metabolic volume: the volume in mm³ of the VOI voxels whose value is at least the metabolic volume threshold.
+
+    If an image with the needed PET attributes is given with setStandardizedUptakeValueImage(), the maximum, peak and mean are also given as SUV
+    with the preferred formula of StandardUptakeValueMeasureHandler, and absolute metabolic volume thresholds are SUV values.
+    Only the first scalar component of the image is used.
+  */
+class VOIStatisticsCalculator {
+public:
+    /// Ways to interpret the metabolic volume threshold
+    enum MetabolicVolumeThresholdType { AbsoluteThreshold, FractionOfMaximumThreshold };
+
+    /// Statistics of the VOI in a phase
+    struct Statistics {
+        /// Statistics of the VOI voxels in image units
+        ROIData data;
+        /// Mean of the sphere of PeakSphereRadius centered at the maximum voxel of the VOI, in image units
+        double peak;
+        /// Volume of the VOI voxels above the threshold in mm³
+        double metabolicVolume;
+        /// Index of the maximum voxel of the VOI
+        int maximumIndex[3];
+        /// True if the SUV values are valid
+        bool hasStandardizedUptakeValues;
+        double standardizedUptakeValueMaximum;
+        double standardizedUptakeValuePeak;
+        double standardizedUptakeValueMean;
+    };
+
+    /// Radius in mm of the sphere used to compute the peak, which has a volume of 1 cm³
+    static const double PeakSphereRadius;
+
+    VOIStatisticsCalculator();
+    ~VOIStatisticsCalculator();
+
+    /// Sets the image to measure and its number of phases
+    void setInput(vtkImageData *image, int numberOfPhases = 1);
+
+    /// Returns the number of slices of each phase of the input
+    int getNumberOfSlicesPerPhase() const;
+
+    /// Sets the VOI as the sphere with the given center and radius in mm. Removes the contours.
+    void setSphere(const double center[3], double radius);
+
+    /// Sets the contour of the given slice, with points in pixel data space, and removes the sphere.
+    /// Only the statistics of this slice have to be measured again.
+    void setContour(int slice, const QVector<QPointF> &contour);
+    /// Removes the contour of the given slice
+    void removeContour(int slice);
+    /// Removes the sphere and all the contours
+    void clearVOI();
+
+    /// Sets how the threshold of the metabolic volume has to be interpreted and its value. By default it is 41% of the maximum.
+    void setMetabolicVolumeThreshold(MetabolicVolumeThresholdType type, double threshold);
+
+    /// Sets the image from which the SUV conversion is computed. It can be null to disable SUV values.
+    void setStandardizedUptakeValueImage(Image *image);
+
+    /// Returns the statistics of the VOI in the given phase
+    Statistics getStatistics(int phase = 0);
+
+    /// Returns the statistics of the VOI in all phases
+    QVector<Statistics> getStatisticsOfAllPhases();
+
+private:
+    /// Columns from firstColumn to lastColumn of a row of a slice
+    typedef ContourRasterizer::Span Span;
+
+    /// Cached statistics of the VOI voxels of a slice
+    struct SliceStatistics {
+        bool isValid;
+        ROIData data;
+        int maximumIndex[3];
+    };
+
+    /// Ways to define the VOI
+    enum Shape { NoShape, SphereShape, ContoursShape };
+
+    /// Marks as invalid the cached statistics of all the slices
+    void invalidateAllSlices();
+    /// Marks as invalid the cached statistics of the given slice in all phases
+    void invalidateSlice(int slice);
+
+    /// Returns the spans of the VOI in the given slice
+    QVector<Span> getVOISpans(int slice) const;
+    /// Returns the spans of the given sphere in the given slice
+    QVector<Span> getSphereSpans(const double center[3], double radius, int slice) const;
+    /// Returns the spans of the given contour in its slice
+    QVector<Span> getContourSpans(const QVector<QPointF> &contour) const;
+
+    /// Returns the z index of the given slice in the given phase
+    int getZIndex(int slice, int phase) const;
+
+    /// Measures the slices of the given phase whose statistics are not valid
+    void updateSliceStatistics(int phase);
+
+    /// Returns the number of VOI voxels of the given phase whose value is at least the given one
+    int countVoxelsAbove(int phase, double threshold) const;
+
+private:
+    /// Image to measure
+    vtkSmartPointer<vtkImageData> m_input;
+    int m_numberOfPhases;
+
+    /// The VOI
+    Shape m_shape;
+    double m_sphereCenter[3];
+    double m_sphereRadius;
+    QMap<int, QVector<QPointF> > m_contours;
+
+    MetabolicVolumeThresholdType m_metabolicVolumeThresholdType;
+    double m_metabolicVolumeThreshold;
+
+    /// Factor to convert image values to SUV, 0 if they can't be converted
+    double m_standardizedUptakeValueFactor;
+
+    /// Cached statistics for each phase and slice
+    QVector<QVector<SliceStatistics> > m_sliceStatistics;
+};
+
+} // End namespace udg
+
+#endif
@@ -0,0 +1,331 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "voitool.h"
+
+#include "drawer.h"
+#include "drawerpolygon.h"
+#include "drawertext.h"
+#include "mathtools.h"
+#include "q2dviewer.h"
+#include "standarduptakevaluemeasurehandler.h"
+#include "volume.h"
+
+#include <QApplication>
+
+#include <cmath>
+
+#include <vtkCommand.h>
+#include <vtkRenderWindowInteractor.h>
+
+namespace udg {
+
+namespace {
+
+// Threshold of the metabolic volume as a fraction of the maximum
+const double MetabolicVolumeThreshold = 0.41;
+
+}
+
+VOITool::VOITool(QViewer *viewer, QObject *parent)
+ : Tool(viewer, parent), m_isDrawing(false), m_radius(0.0), m_measuredInputIndex(-1)
+{
+    m_toolName = "VOITool";
+    m_2DViewer = Q2DViewer::castFromQViewer(viewer);
+
+    m_calculator.setMetabolicVolumeThreshold(VOIStatisticsCalculator::FractionOfMaximumThreshold, MetabolicVolumeThreshold);
+
+    connect(m_2DViewer, SIGNAL(volumeChanged(Volume*)), SLOT(initialize()));
+    connect(m_2DViewer, SIGNAL(phaseChanged(int)), SLOT(updateAnnotation()));
+
+    initialize();
+}
+
+VOITool::~VOITool()
+{
+    initialize();
+}
+
+void VOITool::handleEvent(unsigned long eventId)
+{
+    if (!m_2DViewer || !m_2DViewer->hasInput())
+    {
+        return;
+    }
+
+    switch (eventId)
+    {
+        case vtkCommand::LeftButtonPressEvent:
+            if (!m_isDrawing)
+            {
+                startDrawing();
+            }
+            break;
+        case vtkCommand::MouseMoveEvent:
+            if (m_isDrawing)
+            {
+                updateCircle();
+            }
+            break;
+        case vtkCommand::LeftButtonReleaseEvent:
+            if (m_isDrawing)
+            {
+                endDrawing();
+            }
+            break;
+        case vtkCommand::KeyPressEvent:
+            int keyCode = m_2DViewer->getInteractor()->GetKeyCode();
+            if (keyCode == 27 && m_isDrawing)  // Esc
+            {
+                abortDrawing();
+            }
+            break;
+    }
+}
+
+void VOITool::startDrawing()
+{
+    Q_ASSERT(!m_isDrawing);
+
+    m_isDrawing = true;
+
+    double center[3];
+    m_2DViewer->getEventWorldCoordinate(center);
+    m_center = Vector3(center[0], center[1], center[2]);
+    m_radius = 0.0;
+
+    // The annotation of the previous VOI is left as it was
+    m_text = 0;
+    setupCalculator();
+}
+
+void VOITool::endDrawing()
+{
+    Q_ASSERT(m_isDrawing);
+
+    m_isDrawing = false;
+
+    // The circle doesn't exist if the mouse hasn't been moved, e.g. after a double click
+    if (!m_circle || m_radius <= 0.0)
+    {
+        initialize();
+        return;
+    }
+
+    // Release the circle and its annotation so that they can be erased and draw them on the current slice
+    m_circle->decreaseReferenceCount();
+    m_2DViewer->getDrawer()->erasePrimitive(m_circle);
+    m_2DViewer->getDrawer()->draw(m_circle, m_2DViewer->getView(), m_2DViewer->getCurrentSlice());
+    m_circle = 0;
+
+    m_text->decreaseReferenceCount();
+    m_2DViewer->getDrawer()->erasePrimitive(m_text);
+    m_2DViewer->getDrawer()->draw(m_text, m_2DViewer->getView(), m_2DViewer->getCurrentSlice());
+}
+
+void VOITool::abortDrawing()
+{
+    Q_ASSERT(m_isDrawing);
+
+    deleteCircle();
+    m_isDrawing = false;
+}
+
+void VOITool::updateCircle()
+{
+    Q_ASSERT(m_isDrawing);
+
+    double point[3];
+    m_2DViewer->getEventWorldCoordinate(point);
+    int zIndex = m_2DViewer->getView().getZIndex();
+    double center[3] = { m_center.x, m_center.y, m_center.z };
+    point[zIndex] = center[zIndex];
+    m_radius = (Vector3(point[0], point[1], point[2]) - m_center).length();
+
+    if (!m_circle)
+    {
+        m_circle = new DrawerPolygon();
+        // Prevent the circle from being erased by external events while it's being drawn
+        m_circle->increaseReferenceCount();
+        m_2DViewer->getDrawer()->draw(m_circle);
+
+        m_text = new DrawerText();
+        m_text->setHorizontalJustification("Left");
+        m_text->increaseReferenceCount();
+        m_2DViewer->getDrawer()->draw(m_text);
+    }
+
+    updatePolygonPoints();
+
+    // The statistics follow the circle while it's being drawn. The calculator iterates the volume itself, whose pixel data space is the world
+    // space of the viewer; only the thick slab output is resliced. The radius is the same in both spaces.
+    double dataCenter[3] = { m_center.x, m_center.y, m_center.z };
+    m_calculator.setSphere(dataCenter, m_radius);
+    updateText();
+
+    m_2DViewer->render();
+}
+
+void VOITool::updatePolygonPoints()
+{
+    int xIndex, yIndex, zIndex;
+    m_2DViewer->getView().getXYZIndexes(xIndex, yIndex, zIndex);
+
+    double center[3] = { m_center.x, m_center.y, m_center.z };
+
+    m_circle->removeVertices();
+
+    const int NumberOfPoints = 360;
+
+    for (int i = 0; i < NumberOfPoints; i++)
+    {
+        double angle = static_cast<double>(i) / NumberOfPoints * 2.0 * MathTools::PiNumber;
+        double point[3];
+        point[xIndex] = center[xIndex] + m_radius * cos(angle);
+        point[yIndex] = center[yIndex] + m_radius * sin(angle);
+        point[zIndex] = center[zIndex];
+        m_circle->addVertix(point);
+    }
+
+    m_circle->update();
+}
+
+int VOITool::getMeasuredInputIndex() const
+{
+    // In PET-CT fusions the PET is measured
+    for (int i = 0; i < m_2DViewer->getNumberOfInputs(); i++)
+    {
+        if (m_2DViewer->getInput(i)->getModality() == "PT")
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+void VOITool::updateText()
+{
+    int xIndex = m_2DViewer->getView().getXIndex();
+    double attachmentPoint[3] = { m_center.x, m_center.y, m_center.z };
+    attachmentPoint[xIndex] += m_radius;
+
+    m_text->setText(getAnnotation());
+    m_text->setAttachmentPoint(attachmentPoint);
+    m_text->update();
+}
+
+void VOITool::deleteCircle()
+{
+    // The annotation is only owned by the tool while its circle is being drawn
+    if (m_circle)
+    {
+        m_circle->decreaseReferenceCount();
+        delete m_circle;
+        if (m_text)
+        {
+            m_text->decreaseReferenceCount();
+            delete m_text;
+        }
+        m_text = 0;
+        m_2DViewer->render();
+    }
+
+    m_circle = 0;
+}
+
+void VOITool::setupCalculator()
+{
+    m_measuredInputIndex = getMeasuredInputIndex();
+    Volume *input = m_2DViewer->getInput(m_measuredInputIndex);
+    m_calculator.setInput(input->getVtkData(), input->getNumberOfPhases());
+
+    m_standardizedUptakeValueLabel.clear();
+    m_standardizedUptakeValueUnits.clear();
+    Image *petImage = input->getModality() == "PT" ? input->getImage(0) : 0;
+    if (petImage)
+    {
+        StandardUptakeValueMeasureHandler suvHandler;
+        suvHandler.setImage(petImage);
+        if (suvHandler.canComputePreferredFormula())
+        {
+            suvHandler.computePreferredFormula(1.0);
+            m_standardizedUptakeValueLabel = suvHandler.getComputedFormulaLabel();
+            m_standardizedUptakeValueUnits = suvHandler.getComputedFormulaUnits();
+        }
+    }
+    m_calculator.setStandardizedUptakeValueImage(petImage);
+    m_calculator.clearVOI();
+}
+
+QString VOITool::getAnnotation()
+{
+    VOIStatisticsCalculator::Statistics statistics = m_calculator.getStatistics(m_2DViewer->getCurrentPhaseOnInput(m_measuredInputIndex));
+
+    if (statistics.data.getNumberOfVoxels() == 0)
+    {
+        return tr("No voxels");
+    }
+
+    QString annotation;
+
+    if (statistics.hasStandardizedUptakeValues)
+    {
+        QString units = m_standardizedUptakeValueUnits.isEmpty() ? QString() : " " + m_standardizedUptakeValueUnits;
+        annotation = tr("SUV (%1)").arg(m_standardizedUptakeValueLabel);
+        annotation += "\n" + tr("Max: %1").arg(statistics.standardizedUptakeValueMaximum, 0, 'f', 2) + units;
+        annotation += "\n" + tr("Peak: %1").arg(statistics.standardizedUptakeValuePeak, 0, 'f', 2) + units;
+        annotation += "\n" + tr("Mean: %1").arg(statistics.standardizedUptakeValueMean, 0, 'f', 2) + units;
+    }
+    else
+    {
+        QString pixelUnits = m_2DViewer->getInput(m_measuredInputIndex)->getPixelUnits();
+        QString units = pixelUnits.isEmpty() ? QString() : " " + pixelUnits;
+        annotation = tr("Max: %1").arg(statistics.data.getMaximum(), 0, 'f', 2) + units;
+        annotation += "\n" + tr("Peak: %1").arg(statistics.peak, 0, 'f', 2) + units;
+        annotation += "\n" + tr("Mean: %1").arg(statistics.data.getMean(), 0, 'f', 2) + units;
+    }
+
+    annotation += "\n" + tr("MTV (%1%): %2 cm³").arg(qRound(MetabolicVolumeThreshold * 100.0)).arg(statistics.metabolicVolume / 1000.0, 0, 'f', 2);
+
+    return annotation;
+}
+
+void VOITool::initialize()
+{
+    deleteCircle();
+    m_isDrawing = false;
+
+    // The annotation of the last VOI stays drawn but is no longer updated
+    m_text = 0;
+    m_measuredInputIndex = -1;
+    m_calculator.setInput(0);
+}
+
+void VOITool::updateAnnotation()
+{
+    if (!m_text || m_measuredInputIndex < 0 || m_measuredInputIndex >= m_2DViewer->getNumberOfInputs())
+    {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    m_text->setText(getAnnotation());
+    QApplication::restoreOverrideCursor();
+    m_text->update();
+    m_2DViewer->render();
+}
+
+}
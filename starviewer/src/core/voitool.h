@@ -0,0 +1,101 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGVOITOOL_H
+#define UDGVOITOOL_H
+
+#include "tool.h"
+
+#include "vector3.h"
+#include "voistatisticscalculator.h"
+
+#include <QPointer>
+
+namespace udg {
+
+class DrawerPolygon;
+class DrawerText;
+class Q2DViewer;
+
+/**
+    Tool to measure a spherical volume of interest (VOI).
+
+    The sphere is drawn as a circle on the current slice, from its center to its border. While the circle is drawn the statistics of the whole
+    sphere are computed with VOIStatisticsCalculator over the PET input of the viewer, or the main input if there is none, and are shown next
+    to the circle: maximum, peak and mean (as SUV when possible) and the metabolic volume above 41% of the maximum.
+    The annotation of the last VOI is updated when the phase of the viewer changes.
+ */
+class VOITool : public Tool {
+Q_OBJECT
+public:
+    VOITool(QViewer *viewer, QObject *parent = 0);
+    ~VOITool();
+
+    void handleEvent(unsigned long eventId);
+
+private:
+    /// Starts drawing the circle at the event position
+    void startDrawing();
+    /// Finishes drawing the circle and measures its sphere
+    void endDrawing();
+    /// Cancels the drawing of the circle
+    void abortDrawing();
+    /// Updates the radius of the circle to the event position
+    void updateCircle();
+    /// Updates the points of the circle polygon from its center and radius
+    void updatePolygonPoints();
+    /// Updates the annotation of the circle being drawn with the statistics of its sphere
+    void updateText();
+    /// Deletes the circle being drawn and its annotation, if any
+    void deleteCircle();
+
+    /// Returns the index of the input that has to be measured
+    int getMeasuredInputIndex() const;
+    /// Sets the input of the calculator and its SUV conversion, without VOI
+    void setupCalculator();
+    /// Returns the annotation with the statistics of the VOI in the current phase of the measured input
+    QString getAnnotation();
+
+private slots:
+    /// Discards the circle being drawn and the last VOI
+    void initialize();
+    /// Updates the annotation of the last VOI with the statistics of the current phase
+    void updateAnnotation();
+
+private:
+    /// 2D viewer where the tool works
+    Q2DViewer *m_2DViewer;
+    /// The circle being drawn
+    QPointer<DrawerPolygon> m_circle;
+    /// Annotation of the last VOI
+    QPointer<DrawerText> m_text;
+    /// True while a circle is being drawn
+    bool m_isDrawing;
+    /// Center and radius in mm of the circle in world coordinates
+    Vector3 m_center;
+    double m_radius;
+
+    /// Calculator with the last VOI
+    VOIStatisticsCalculator m_calculator;
+    /// Index of the input measured by the calculator
+    int m_measuredInputIndex;
+    /// Label and units of the SUV formula of the measured input, empty if SUV can't be computed
+    QString m_standardizedUptakeValueLabel;
+    QString m_standardizedUptakeValueUnits;
+};
+
+}
+
+#endif
@@ -22,13 +22,15 @@
 #include "mathtools.h"
 #include "volumepixeldataiterator.h"
 #include "imageplane.h"
+#include "sliceindex.h"
+#include "standardizeduptakevaluefactorcache.h"
 #include "dicomtagreader.h"
 #include "volumehelper.h"
 
 namespace udg {
 
 Volume::Volume(QObject *parent)
-: QObject(parent), m_checkedImagesAnatomicalPlane(false)
+: QObject(parent), m_checkedImagesAnatomicalPlane(false), m_standardizedUptakeValueFactorCache(0)
 {
     m_numberOfPhases = 1;
     m_numberOfSlicesPerPhase = 1;
@@ -39,6 +41,7 @@ Volume::Volume(QObject *parent)
 Volume::~Volume()
 {
     DEBUG_LOG(QString("Destructor ~Volume %1, name: %2").arg(m_identifier.getValue()).arg(this->objectName()));
+    clearDerivedData();
     delete m_volumePixelData;
 }
 
@@ -55,11 +58,13 @@ vtkImageData* Volume::getVtkData()
 void Volume::setData(ItkImageTypePointer itkImage)
 {
     m_volumePixelData->setData(itkImage);
+    clearDerivedData();
 }
 
 void Volume::setData(vtkImageData *vtkImage)
 {
     m_volumePixelData->setData(vtkImage);
+    clearDerivedData();
 }
 
 void Volume::setPixelData(VolumePixelData *pixelData)
@@ -68,6 +73,7 @@ void Volume::setPixelData(VolumePixelData *pixelData)
     m_volumePixelData = pixelData;
     // Set the number of phases to the new pixel data
     m_volumePixelData->setNumberOfPhases(m_numberOfPhases);
+    clearDerivedData();
 }
 
 VolumePixelData* Volume::getPixelData()
@@ -133,7 +139,16 @@ void Volume::getDimensions(int dims[3])
 
 void Volume::getScalarRange(double range[2])
 {
-    getVtkData()->GetScalarRange(range);
+    // The statistics computed after reading avoid scanning the whole volume in the GUI thread
+    const VolumePixelDataStatistics *statistics = getPixelData()->getStatistics();
+    if (statistics)
+    {
+        statistics->getRange(range);
+    }
+    else
+    {
+        getVtkData()->GetScalarRange(range);
+    }
 }
 
 void Volume::setIdentifier(const Identifier &id)
@@ -161,6 +176,7 @@ void Volume::setNumberOfPhases(int phases)
     if (phases >= 1)
     {
         m_numberOfPhases = phases;
+        clearDerivedData();
 
         // Set the number of phases to the pixel data only if it's already loaded, because we don't want to load it now
         if (isPixelDataLoaded())
@@ -252,6 +268,7 @@ void Volume::setImages(const QList<Image*> &imageList)
 {
     m_imageSet.clear();
     m_imageSet = imageList;
+    clearDerivedData();
     // Si tenim dades carregades passen a ser invàlides
     if (isPixelDataLoaded())
     {
@@ -373,6 +390,35 @@ Image* Volume::getImage(int sliceNumber, int phaseNumber) const
     return image;
 }
 
+const SliceIndex* Volume::getSliceIndex(const OrthogonalPlane &plane)
+{
+    SliceIndex *&sliceIndex = m_sliceIndexes[plane];
+    if (!sliceIndex)
+    {
+        QList<ImagePlane*> slicePlanes;
+        int maximumSlice = getMaximumSlice(plane);
+        for (int i = 0; i <= maximumSlice; i++)
+        {
+            slicePlanes << getImagePlane(i, plane);
+        }
+
+        sliceIndex = new SliceIndex(slicePlanes);
+        qDeleteAll(slicePlanes);
+    }
+
+    return sliceIndex;
+}
+
+StandardizedUptakeValueFactorCache* Volume::getStandardizedUptakeValueFactorCache()
+{
+    if (!m_standardizedUptakeValueFactorCache)
+    {
+        m_standardizedUptakeValueFactorCache = new StandardizedUptakeValueFactorCache(this);
+    }
+
+    return m_standardizedUptakeValueFactorCache;
+}
+
 QString Volume::getPixelUnits()
 {
     QString units;
@@ -677,6 +723,7 @@ double Volume::getScalarValue(int x, int y, int z)
 void Volume::convertToNeutralVolume()
 {
     m_volumePixelData->convertToNeutralPixelData();
+    clearDerivedData();
 
     // Quan creem el volum neutre indiquem que només tenim 1 sola fase
     // TODO Potser s'haurien de crear tantes fases com les que indiqui la sèrie?
@@ -832,4 +879,13 @@ bool Volume::areAllImagesInTheSameAnatomicalPlane() const
     return m_allImagesAreInTheSameAnatomicalPlane;
 }
 
+void Volume::clearDerivedData()
+{
+    qDeleteAll(m_sliceIndexes);
+    m_sliceIndexes.clear();
+
+    delete m_standardizedUptakeValueFactorCache;
+    m_standardizedUptakeValueFactorCache = 0;
+}
+
 };
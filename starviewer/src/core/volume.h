@@ -22,6 +22,7 @@
 #include "anatomicalplane.h"
 #include "orthogonalplane.h"
 // Qt
+#include <QHash>
 #include <QPixmap>
 #include <QVector>
 // FWD declarations
@@ -35,6 +36,8 @@ class Study;
 class Patient;
 class VolumeReader;
 class ImagePlane;
+class SliceIndex;
+class StandardizedUptakeValueFactorCache;
 
 /**
     Aquesta classe respresenta un volum de dades. Aquesta serà la classe on es guardaran les dades que voldrem tractar.
@@ -147,6 +150,14 @@ public:
     /// @return The corresponding image plane
     ImagePlane* getImagePlane(int sliceNumber, const OrthogonalPlane &plane, bool vtkReconstructionHack = false);
     
+    /// Returns the index of the slices of the given plane to locate the slice nearest to a point.
+    /// It's built the first time it's requested and kept until the images or the pixel data change.
+    const SliceIndex* getSliceIndex(const OrthogonalPlane &plane);
+
+    /// Returns the cache of the SUV factors of the images of this volume, which only makes sense for PT volumes.
+    /// It's created the first time it's requested and discarded when the images or the pixel data change.
+    StandardizedUptakeValueFactorCache* getStandardizedUptakeValueFactorCache();
+
     /// Returns the pixel units for this volume. If the units cannot be specified, an empty string will be returned
     QString getPixelUnits();
     
@@ -229,6 +240,9 @@ private:
     /// Lazy loading of the units of the pixels of PT series
     QString getPTPixelUnits(const Image *image);
 
+    /// Deletes the slice indexes and the SUV pixel data, which have to be rebuilt after a change in the images or the pixel data of the volume
+    void clearDerivedData();
+
 private:
 
     /// Conjunt d'imatges que composen el volum
@@ -253,6 +267,12 @@ private:
 
     /// Stores the units of the pixel values of PT series. getPTPixelUnits should always be used to get this value
     QString m_PTPixelUnits;
+
+    /// Slice indexes by orthogonal plane, built on demand
+    QHash<int, SliceIndex*> m_sliceIndexes;
+
+    /// Cache of the SUV factors, created on demand
+    StandardizedUptakeValueFactorCache *m_standardizedUptakeValueFactorCache;
 };
 
 }  // End namespace udg
@@ -15,6 +15,7 @@
 #include "volumedisplayunit.h"
 
 #include "imagepipeline.h"
+#include "renderingprofiler.h"
 #include "slicehandler.h"
 #include "sliceorientedvolumepixeldata.h"
 #include "volume.h"
@@ -105,6 +106,13 @@ ImagePipeline* VolumeDisplayUnit::getImagePipeline() const
     return m_imagePipeline;
 }
 
+void VolumeDisplayUnit::addToRenderingProfiler(RenderingProfiler *profiler) const
+{
+    m_imagePipeline->addToRenderingProfiler(profiler);
+    profiler->addStageObject(RenderingProfiler::Reslice, m_mapper->getResliceAlgorithm());
+    profiler->addStageObject(RenderingProfiler::ImageMapper, m_mapper);
+}
+
 vtkImageSlice* VolumeDisplayUnit::getImageSlice() const
 {
     return m_imageSlice;
@@ -32,6 +32,7 @@ namespace udg {
 class Image;
 class ImagePipeline;
 class OrthogonalPlane;
+class RenderingProfiler;
 class SliceHandler;
 class SliceOrientedVolumePixelData;
 class Volume;
@@ -69,6 +70,9 @@ public:
     /// Returns the image pipeline.
     ImagePipeline* getImagePipeline() const;
 
+    /// Adds the filters of the image pipeline, the reslice and the image mapper to the corresponding stages of the given profiler.
+    void addToRenderingProfiler(RenderingProfiler *profiler) const;
+
     /// Returns the main vtkImageSlice.
     vtkImageSlice* getImageSlice() const;
 
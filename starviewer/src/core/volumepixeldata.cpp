@@ -314,4 +314,20 @@ int VolumePixelData::getNumberOfPoints()
 {
     return m_imageDataVTK->GetNumberOfPoints();
 } 
+
+void VolumePixelData::computeStatistics()
+{
+    m_statistics.compute(m_imageDataVTK);
+}
+
+const VolumePixelDataStatistics* VolumePixelData::getStatistics() const
+{
+    if (!m_statistics.isUpToDate(m_imageDataVTK))
+    {
+        return 0;
+    }
+
+    return &m_statistics;
+}
+
 } // End namespace udg
@@ -18,6 +18,8 @@
 #include <QObject>
 #include <QVector>
 
+#include "volumepixeldatastatistics.h"
+
 #include <itkImage.h>
 #include <vtkSmartPointer.h>
 // Els filtres per passar itk<=>vtk: InsightApplications/auxiliary/vtk --> ho tenim a /tools
@@ -128,6 +130,13 @@ public:
 
     //  Obté el nombre de punts
     int getNumberOfPoints();
+
+    /// Computes the range, histograms and percentiles of the whole pixel data and of each slice, scanning the slices in parallel.
+    /// It's meant to be called once after reading, out of the GUI thread.
+    void computeStatistics();
+
+    /// Returns the statistics of the current pixel data, or null if they haven't been computed or the data has changed since then
+    const VolumePixelDataStatistics* getStatistics() const;
    
 private:
     /// Filtres per importar/exportar
@@ -143,6 +152,9 @@ private:
     /// Number of phases of the pixel data. Its minimum value must be 1
     int m_numberOfPhases;
     
+    /// Statistics of the pixel data, computed on demand
+    VolumePixelDataStatistics m_statistics;
+
     /// Filtres per passar de vtk a itk
     ItkToVtkFilterType::Pointer m_itkToVtkFilter;
     VtkToItkFilterType::Pointer m_vtkToItkFilter;
@@ -14,6 +14,7 @@
 
 #include "volumepixeldatareaderfactory.h"
 
+#include "computestatisticspostprocessor.h"
 #include "computezspacingpostprocessor.h"
 #include "pixelspacingamenderpostprocessor.h"
 #include "coresettings.h"
@@ -84,6 +85,9 @@ QQueue< QSharedPointer<Postprocessor> > VolumePixelDataReaderFactory::getPostpro
             break;
     }
 
+    // Last, so that the statistics are computed from the final pixel data
+    postprocessors.enqueue(QSharedPointer<Postprocessor>(new ComputeStatisticsPostprocessor()));
+
     return postprocessors;
 }
 
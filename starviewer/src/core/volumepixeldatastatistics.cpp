@@ -0,0 +1,276 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "volumepixeldatastatistics.h"
+
+#include "logging.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrentMap>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+
+namespace udg {
+
+namespace {
+
+template <class T>
+void computeSliceRange(const T *scalars, vtkIdType numberOfPixels, int numberOfComponents, double &minimum, double &maximum)
+{
+    T sliceMinimum = scalars[0];
+    T sliceMaximum = scalars[0];
+
+    for (vtkIdType i = 0; i < numberOfPixels; i++)
+    {
+        T value = scalars[i * numberOfComponents];
+        if (value < sliceMinimum)
+        {
+            sliceMinimum = value;
+        }
+        if (value > sliceMaximum)
+        {
+            sliceMaximum = value;
+        }
+    }
+
+    minimum = sliceMinimum;
+    maximum = sliceMaximum;
+}
+
+template <class T>
+void computeSliceHistogram(const T *scalars, vtkIdType numberOfPixels, int numberOfComponents, double minimum, double binWidth,
+                           QVector<qint64> &histogram)
+{
+    int lastBin = histogram.size() - 1;
+    qint64 *bins = histogram.data();
+
+    for (vtkIdType i = 0; i < numberOfPixels; i++)
+    {
+        int bin = static_cast<int>((scalars[i * numberOfComponents] - minimum) / binWidth);
+        bins[qBound(0, bin, lastBin)]++;
+    }
+}
+
+}
+
+const int VolumePixelDataStatistics::DefaultNumberOfBins = 256;
+
+VolumePixelDataStatistics::VolumePixelDataStatistics()
+ : m_minimum(0.0), m_maximum(0.0), m_binWidth(1.0), m_exactBins(false), m_imageData(0), m_scalarsModificationTime(0)
+{
+}
+
+void VolumePixelDataStatistics::compute(vtkImageData *imageData, int maximumNumberOfBins)
+{
+    m_slices.clear();
+    m_histogram.clear();
+    m_minimum = 0.0;
+    m_maximum = 0.0;
+    m_binWidth = 1.0;
+    m_exactBins = false;
+    m_imageData = imageData;
+    m_scalarsModificationTime = 0;
+
+    if (!imageData || !imageData->GetPointData()->GetScalars() || imageData->GetNumberOfPoints() == 0)
+    {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    m_scalarsModificationTime = imageData->GetPointData()->GetScalars()->GetMTime();
+
+    int extent[6];
+    imageData->GetExtent(extent);
+    vtkIdType numberOfPixels = static_cast<vtkIdType>(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1);
+    int numberOfComponents = imageData->GetNumberOfScalarComponents();
+    int scalarType = imageData->GetScalarType();
+
+    m_slices.resize(extent[5] - extent[4] + 1);
+    for (int i = 0; i < m_slices.size(); i++)
+    {
+        m_slices[i].z = extent[4] + i;
+    }
+
+    QtConcurrent::blockingMap(m_slices, [&](Slice &slice)
+    {
+        void *scalars = imageData->GetScalarPointer(extent[0], extent[2], slice.z);
+        switch (scalarType)
+        {
+            vtkTemplateMacro(computeSliceRange(static_cast<const VTK_TT*>(scalars), numberOfPixels, numberOfComponents, slice.minimum, slice.maximum));
+        }
+    });
+
+    m_minimum = m_slices.first().minimum;
+    m_maximum = m_slices.first().maximum;
+    foreach (const Slice &slice, m_slices)
+    {
+        m_minimum = qMin(m_minimum, slice.minimum);
+        m_maximum = qMax(m_maximum, slice.maximum);
+    }
+
+    // Integer values get a bin each when they fit, so that their percentiles are exact
+    bool isInteger = scalarType != VTK_FLOAT && scalarType != VTK_DOUBLE;
+    int numberOfBins = qMax(1, maximumNumberOfBins);
+    if (isInteger && m_maximum - m_minimum + 1.0 <= numberOfBins)
+    {
+        numberOfBins = static_cast<int>(m_maximum - m_minimum + 1.0);
+        m_binWidth = 1.0;
+        m_exactBins = true;
+    }
+    else if (m_maximum > m_minimum)
+    {
+        m_binWidth = (m_maximum - m_minimum) / numberOfBins;
+    }
+    else
+    {
+        numberOfBins = 1;
+    }
+
+    double minimum = m_minimum;
+    double binWidth = m_binWidth;
+    QtConcurrent::blockingMap(m_slices, [&](Slice &slice)
+    {
+        slice.histogram.fill(0, numberOfBins);
+        void *scalars = imageData->GetScalarPointer(extent[0], extent[2], slice.z);
+        switch (scalarType)
+        {
+            vtkTemplateMacro(computeSliceHistogram(static_cast<const VTK_TT*>(scalars), numberOfPixels, numberOfComponents, minimum, binWidth,
+                                                   slice.histogram));
+        }
+    });
+
+    m_histogram.fill(0, numberOfBins);
+    foreach (const Slice &slice, m_slices)
+    {
+        for (int i = 0; i < numberOfBins; i++)
+        {
+            m_histogram[i] += slice.histogram.at(i);
+        }
+    }
+
+    DEBUG_LOG(QString("Statistics of %1 slices computed in %2 ms").arg(m_slices.size()).arg(timer.elapsed()));
+}
+
+bool VolumePixelDataStatistics::isEmpty() const
+{
+    return m_slices.isEmpty();
+}
+
+bool VolumePixelDataStatistics::isUpToDate(vtkImageData *imageData) const
+{
+    if (isEmpty() || !imageData || imageData != m_imageData || !imageData->GetPointData()->GetScalars())
+    {
+        return false;
+    }
+
+    return imageData->GetPointData()->GetScalars()->GetMTime() == m_scalarsModificationTime;
+}
+
+int VolumePixelDataStatistics::getNumberOfSlices() const
+{
+    return m_slices.size();
+}
+
+int VolumePixelDataStatistics::getNumberOfBins() const
+{
+    return m_histogram.size();
+}
+
+void VolumePixelDataStatistics::getRange(double range[2]) const
+{
+    range[0] = m_minimum;
+    range[1] = m_maximum;
+}
+
+void VolumePixelDataStatistics::getSliceRange(int slice, double range[2]) const
+{
+    range[0] = m_slices.at(slice).minimum;
+    range[1] = m_slices.at(slice).maximum;
+}
+
+double VolumePixelDataStatistics::getBinMinimum(int bin) const
+{
+    return m_minimum + bin * m_binWidth;
+}
+
+double VolumePixelDataStatistics::getBinWidth() const
+{
+    return m_binWidth;
+}
+
+bool VolumePixelDataStatistics::hasExactBins() const
+{
+    return m_exactBins;
+}
+
+const QVector<qint64>& VolumePixelDataStatistics::getHistogram() const
+{
+    return m_histogram;
+}
+
+const QVector<qint64>& VolumePixelDataStatistics::getSliceHistogram(int slice) const
+{
+    return m_slices.at(slice).histogram;
+}
+
+double VolumePixelDataStatistics::getPercentile(double percentage) const
+{
+    return computePercentile(m_histogram, m_minimum, m_maximum, percentage);
+}
+
+double VolumePixelDataStatistics::getSlicePercentile(int slice, double percentage) const
+{
+    const Slice &sliceStatistics = m_slices.at(slice);
+    return computePercentile(sliceStatistics.histogram, sliceStatistics.minimum, sliceStatistics.maximum, percentage);
+}
+
+double VolumePixelDataStatistics::computePercentile(const QVector<qint64> &histogram, double minimum, double maximum, double percentage) const
+{
+    qint64 count = 0;
+    foreach (qint64 binCount, histogram)
+    {
+        count += binCount;
+    }
+
+    if (count == 0)
+    {
+        return minimum;
+    }
+
+    double target = qBound(0.0, percentage, 100.0) / 100.0 * count;
+    qint64 accumulatedCount = 0;
+    int bin = 0;
+    for (; bin < histogram.size() - 1; bin++)
+    {
+        if (histogram.at(bin) > 0 && accumulatedCount + histogram.at(bin) >= target)
+        {
+            break;
+        }
+        accumulatedCount += histogram.at(bin);
+    }
+
+    double value = getBinMinimum(bin);
+    if (!m_exactBins && histogram.at(bin) > 0)
+    {
+        value += (target - accumulatedCount) / histogram.at(bin) * m_binWidth;
+    }
+
+    return qBound(minimum, value, maximum);
+}
+
+} // End namespace udg
@@ -0,0 +1,105 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGVOLUMEPIXELDATASTATISTICS_H
+#define UDGVOLUMEPIXELDATASTATISTICS_H
+
+#include <QVector>
+
+#include <vtkType.h>
+
+class vtkImageData;
+
+namespace udg {
+
+/**
+    Range, histogram and percentiles of the values of a vtkImageData, for each slice (each z plane) and for the whole volume.
+
+    The slices are scanned in parallel, in two passes: the first one gets the range of each slice and the second one fills the histograms, whose
+    bins evenly cover the range of the volume. When the values are integers and there are fewer different values than bins, each bin holds a single
+    value and the percentiles are exact; otherwise they are interpolated inside the bin.
+
+    Only the first component of the scalars is taken into account.
+  */
+class VolumePixelDataStatistics {
+public:
+    /// Default number of bins of the histograms
+    static const int DefaultNumberOfBins;
+
+    VolumePixelDataStatistics();
+
+    /// Computes the statistics of the given image data, replacing the previous ones
+    void compute(vtkImageData *imageData, int maximumNumberOfBins = DefaultNumberOfBins);
+
+    /// Returns true if no statistics have been computed or the image data was empty
+    bool isEmpty() const;
+
+    /// Returns true if the statistics were computed from the given image data and its scalars haven't been modified since then
+    bool isUpToDate(vtkImageData *imageData) const;
+
+    /// Returns the number of slices and the number of bins of the histograms
+    int getNumberOfSlices() const;
+    int getNumberOfBins() const;
+
+    /// Returns the minimum and maximum values of the volume
+    void getRange(double range[2]) const;
+    /// Returns the minimum and maximum values of the given slice
+    void getSliceRange(int slice, double range[2]) const;
+
+    /// Returns the lowest value that falls in the given bin. The values of the bin are in [getBinMinimum(bin), getBinMinimum(bin) + getBinWidth()).
+    double getBinMinimum(int bin) const;
+    double getBinWidth() const;
+
+    /// Returns true if each bin holds a single integer value
+    bool hasExactBins() const;
+
+    /// Returns the histogram of the volume and of the given slice
+    const QVector<qint64>& getHistogram() const;
+    const QVector<qint64>& getSliceHistogram(int slice) const;
+
+    /// Returns the value below which the given percentage of the values of the volume or of the given slice falls
+    double getPercentile(double percentage) const;
+    double getSlicePercentile(int slice, double percentage) const;
+
+private:
+    /// Statistics of one slice
+    struct Slice {
+        int z;
+        double minimum;
+        double maximum;
+        QVector<qint64> histogram;
+    };
+
+    /// Returns the value below which the given percentage of the values counted in the histogram falls, clamped to [minimum, maximum]
+    double computePercentile(const QVector<qint64> &histogram, double minimum, double maximum, double percentage) const;
+
+private:
+    QVector<Slice> m_slices;
+
+    double m_minimum;
+    double m_maximum;
+    double m_binWidth;
+    QVector<qint64> m_histogram;
+
+    /// True if each bin holds a single integer value
+    bool m_exactBins;
+
+    /// Image data from which the statistics were computed and modification time of its scalars at that moment
+    vtkImageData *m_imageData;
+    vtkMTimeType m_scalarsModificationTime;
+};
+
+} // End namespace udg
+
+#endif
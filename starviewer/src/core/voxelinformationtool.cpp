@@ -19,7 +19,7 @@
 #include "drawer.h"
 #include "voxel.h"
 #include "logging.h"
-#include "standarduptakevaluemeasurehandler.h"
+#include "standardizeduptakevaluefactorcache.h"
 #include "sliceorientedvolumepixeldata.h"
 // Vtk
 #include <vtkCommand.h>
@@ -32,6 +32,7 @@ VoxelInformationTool::VoxelInformationTool(QViewer *viewer, QObject *parent)
     m_toolName = "VoxelInformationTool";
 
     m_2DViewer = Q2DViewer::castFromQViewer(viewer);
+    m_standardizedUptakeValueFormula = StandardUptakeValueMeasureHandler().getPreferredFormula();
     createCaption();
     connect(m_2DViewer, SIGNAL(sliceChanged(int)), SLOT(updateCaption()));
     connect(m_2DViewer, SIGNAL(phaseChanged(int)), SLOT(updateCaption()));
@@ -58,6 +59,8 @@ void VoxelInformationTool::handleEvent(unsigned long eventID)
             break;
 
         case vtkCommand::EnterEvent:
+            // La configuració només pot haver canviat mentre el ratolí era fora del visor
+            m_standardizedUptakeValueFormula = StandardUptakeValueMeasureHandler().getPreferredFormula();
             break;
 
         case vtkCommand::LeaveEvent:
@@ -147,12 +150,14 @@ QString VoxelInformationTool::computeVoxelValueOnInput(double worldCoordinate[3]
             petImage = m_2DViewer->getInput(i)->getImage(0);
         }
 
-        StandardUptakeValueMeasureHandler suvHandler;
-        suvHandler.setImage(petImage);
-        if (suvHandler.canComputePreferredFormula())
+        // The factor of each image is computed only once, so hovering doesn't read the DICOM header of the image each time
+        StandardizedUptakeValueFactorCache *suvFactorCache = m_2DViewer->getInput(i)->getStandardizedUptakeValueFactorCache();
+        suvFactorCache->setFormula(m_standardizedUptakeValueFormula);
+        if (suvFactorCache->canCompute(petImage))
         {
-            double value = suvHandler.computePreferredFormula(voxel.getComponent(0));
-            return QString::number(value, 'f', 2) + " " + suvHandler.getComputedFormulaUnits() + " " + tr("SUV (%1)").arg(suvHandler.getComputedFormulaLabel());
+            double value = suvFactorCache->computeValue(voxel.getComponent(0), petImage);
+            return QString::number(value, 'f', 2) + " " + suvFactorCache->getFormulaUnits() + " "
+                   + tr("SUV (%1)").arg(suvFactorCache->getFormulaLabel());
         }
     }
 
@@ -16,6 +16,7 @@
 #define UDGVOXELINFORMATIONTOOL_H
 
 #include "tool.h"
+#include "standarduptakevaluemeasurehandler.h"
 #include <QPointer>
 
 namespace udg {
@@ -58,6 +59,9 @@ private:
 
     /// El texte per mostrar les annotacions de voxel
     QPointer<DrawerText> m_caption;
+
+    /// Fórmula SUV preferida. Es llegeix de la configuració quan el ratolí entra al visor i no a cada moviment.
+    StandardUptakeValueMeasureHandler::FormulaType m_standardizedUptakeValueFormula;
 };
 
 }
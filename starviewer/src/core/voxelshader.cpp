@@ -24,6 +24,19 @@ VoxelShader::~VoxelShader()
 {
 }
 
+void VoxelShader::shadeSamples(int count, const Vector3 *positions, const int *offsets, const Vector3 &direction, float remainingOpacity, HdrColor *colors)
+{
+    for (int i = 0; i < count; i++)
+    {
+        colors[i] = shade(positions[i], offsets[i], direction, remainingOpacity, colors[i]);
+    }
+}
+
+bool VoxelShader::usesRemainingOpacity() const
+{
+    return false;
+}
+
 QString VoxelShader::toString() const
 {
     return "VoxelShader";
@@ -24,6 +24,10 @@ class TrilinearInterpolator;
 
 /**
     Aquesta classe implementa els mètodes per retornar el color d'un vòxel. El mètode shade ha de ser implementat per les classes filles.
+
+    La part del color que només depèn del valor del vòxel i de la funció de transferència s'ha de precalcular en una taula indexada pel valor
+    quan s'assigna la funció de transferència, com fa AmbientVoxelShader, de manera que shade només hi faci una consulta. La resta de la cadena
+    es calcula per cada mostra, perquè depèn de les normals, de les obscurances o de la direcció de visió.
   */
 class VoxelShader {
 
@@ -36,11 +40,35 @@ public:
     /// Retorna el color corresponent al vòxel a la posició position, fent servir valors interpolats.
     virtual HdrColor shade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator, float remainingOpacity,
                             const HdrColor &baseColor = HdrColor()) = 0;
+    /// Calcula el color de count vòxels seguits d'un raig, a les posicions positions i offsets offsets. A l'entrada colors conté els colors base i a la
+    /// sortida els colors resultants. La implementació per defecte crida shade per cada vòxel; les classes filles poden sobreescriure-la per evitar una
+    /// crida virtual per vòxel.
+    virtual void shadeSamples(int count, const Vector3 *positions, const int *offsets, const Vector3 &direction, float remainingOpacity, HdrColor *colors);
+    /// Retorna cert si el resultat o l'estat del voxel shader depèn de l'opacitat restant. En aquest cas no es poden agrupar mostres de passos diferents
+    /// del raig, perquè totes compartirien la mateixa opacitat restant.
+    virtual bool usesRemainingOpacity() const;
     /// Retorna un string representatiu del voxel shader.
     virtual QString toString() const;
 
+protected:
+    /// Implementació de shadeSamples per les classes filles que tenen nvShade: crida Shader::nvShade per cada vòxel, de manera que la crida no és
+    /// virtual i el compilador la pot inlinar.
+    template <class Shader>
+    static void nvShadeSamples(Shader *shader, int count, const Vector3 *positions, const int *offsets, const Vector3 &direction, float remainingOpacity,
+                               HdrColor *colors);
+
 };
 
+template <class Shader>
+inline void VoxelShader::nvShadeSamples(Shader *shader, int count, const Vector3 *positions, const int *offsets, const Vector3 &direction,
+                                        float remainingOpacity, HdrColor *colors)
+{
+    for (int i = 0; i < count; i++)
+    {
+        colors[i] = shader->Shader::nvShade(positions[i], offsets[i], direction, remainingOpacity, colors[i]);
+    }
+}
+
 }
 
 #endif
@@ -14,6 +14,7 @@
 
 #include "vtkimagereslicemapper2.h"
 
+#include <vtkCommand.h>
 #include <vtkImageProperty.h>
 #include <vtkImageSlice.h>
 #include <vtkImageResliceToColors.h>
@@ -35,8 +36,15 @@ vtkMatrix4x4* VtkImageResliceMapper2::getSliceToWorldMatrix() const
     return this->SliceToWorldMatrix;
 }
 
+vtkAlgorithm* VtkImageResliceMapper2::getResliceAlgorithm() const
+{
+    return this->ImageReslice;
+}
+
 void VtkImageResliceMapper2::Render(vtkRenderer *renderer, vtkImageSlice *prop)
 {
+    this->InvokeEvent(vtkCommand::StartEvent);
+
     // Set background level at negative infinity by default, but set it at positive infinity if we detect inverse window level
     double level = -std::numeric_limits<double>::infinity();
     vtkScalarsToColors *lut = prop->GetProperty()->GetLookupTable();
@@ -65,6 +73,8 @@ void VtkImageResliceMapper2::Render(vtkRenderer *renderer, vtkImageSlice *prop)
     }
 
     vtkImageResliceMapper::Render(renderer, prop);
+
+    this->InvokeEvent(vtkCommand::EndEvent);
 }
 
 VtkImageResliceMapper2::VtkImageResliceMapper2()
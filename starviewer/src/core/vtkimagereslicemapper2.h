@@ -35,7 +35,10 @@ public:
     /// Returns the slice to world matrix.
     vtkMatrix4x4* getSliceToWorldMatrix() const;
 
-    /// Overriden to set a proper background level before the reslice.
+    /// Returns the algorithm that performs the reslice.
+    vtkAlgorithm* getResliceAlgorithm() const;
+
+    /// Overriden to set a proper background level before the reslice. Start and end events are invoked around the whole rendering so that it can be profiled.
     void Render(vtkRenderer *renderer, vtkImageSlice *prop) override;
 
     using Superclass::Update;
@@ -14,8 +14,10 @@
 
 #include "qmprextension.h"
 
+#include "curvedplanarreformation.h"
 #include "drawer.h"
 #include "drawerpoint.h"
+#include "drawerpolyline.h"
 #include "logging.h"
 // Per càlculs d'interseccions
 #include "mathtools.h"
@@ -31,6 +33,8 @@
 // Qt
 #include <QMessageBox>
 #include <QMenu>
+#include <QSplitter>
+#include <QTimer>
 #include <QVector3D>
 // VTK
 #include <vtkAxisActor2D.h>
@@ -38,7 +42,9 @@
 #include <vtkCommand.h>
 // Per portar a l'origen
 #include <vtkImageChangeInformation.h>
+#include <vtkImageData.h>
 #include <vtkImageReslice.h>
+#include <vtkMatrix4x4.h>
 #include <vtkPlaneSource.h>
 #include <vtkProperty2D.h>
 #include <vtkRenderWindowInteractor.h>
@@ -48,6 +54,7 @@
 namespace udg {
 
 const double QMPRExtension::PickingDistanceThreshold = 7.0;
+const int QMPRExtension::InteractiveResliceSubsamplingFactor = 2;
 
 QMPRExtension::QMPRExtension(QWidget *parent)
  : QWidget(parent), m_axialZeroSliceCoordinate(.0)
@@ -128,6 +135,8 @@ QMPRExtension::~QMPRExtension()
     {
         delete m_mipViewer;
     }
+    clearCPRPath();
+    delete m_curvedPlanarReformation;
     delete m_coronal2DView;
 }
 
@@ -174,6 +183,21 @@ void QMPRExtension::init()
     m_pickedActorReslice = 0;
     m_mipViewer = 0;
 
+    m_curvedPlanarReformation = new CurvedPlanarReformation();
+    m_cprSplitter = 0;
+    m_straightenedCPRViewer = 0;
+    m_stretchedCPRViewer = 0;
+    m_cprCrossSectionViewer = 0;
+    m_straightenedCPRVolume = 0;
+    m_stretchedCPRVolume = 0;
+    m_cprCrossSectionVolume = 0;
+    m_cprPathPolyline = 0;
+    m_cprPathViewer = 0;
+
+    m_interactiveResliceTimer = new QTimer(this);
+    m_interactiveResliceTimer->setSingleShot(true);
+    m_interactiveResliceTimer->setInterval(0);
+
     m_extensionToolsList << "ZoomTool" << "SlicingMouseTool" << "TranslateTool" << "VoxelInformationTool" << "WindowLevelTool" << "ScreenShotTool"
                          << "DistanceTool" << "PolylineROITool" << "EllipticalROITool" << "EraserTool";
 }
@@ -193,6 +217,14 @@ void QMPRExtension::createActions()
     m_mipAction->setIcon(QIcon(":/images/icons/thick-slab.svg"));
     m_mipAction->setCheckable(true);
     m_mipToolButton->setDefaultAction(m_mipAction);
+
+    m_cprAction = new QAction(0);
+    m_cprAction->setText(tr("&Curved MPR"));
+    m_cprAction->setStatusTip(tr("Curved planar reformation along a path drawn on any of the MPR views"));
+    m_cprAction->setToolTip(tr("Curved MPR: click on any view to add points to the path, press Escape to start a new path"));
+    m_cprAction->setIcon(QIcon(":/images/icons/draw-polyline.svg"));
+    m_cprAction->setCheckable(true);
+    m_cprToolButton->setDefaultAction(m_cprAction);
 }
 
 void QMPRExtension::initializeZoomTools()
@@ -312,6 +344,8 @@ void QMPRExtension::createConnections()
     // Gestionen els events de les finestres per poder manipular els plans
     connect(m_axial2DView, SIGNAL(eventReceived(unsigned long)), SLOT(handleAxialViewEvents(unsigned long)));
     connect(m_sagital2DView, SIGNAL(eventReceived(unsigned long)), SLOT(handleSagitalViewEvents(unsigned long)));
+    connect(m_coronal2DView, SIGNAL(eventReceived(unsigned long)), SLOT(handleCoronalViewEvents(unsigned long)));
+    connect(m_interactiveResliceTimer, SIGNAL(timeout()), SLOT(updateInteractiveReslice()));
 
     connect(m_thickSlabSpinBox, SIGNAL(valueChanged(double)), SLOT(updateThickSlab(double)));
     connect(m_thickSlabSlider, SIGNAL(valueChanged(int)), SLOT(updateThickSlab(int)));
@@ -319,6 +353,7 @@ void QMPRExtension::createConnections()
     // Layouts
     connect(m_horizontalLayoutAction, SIGNAL(triggered()), SLOT(switchHorizontalLayout()));
     connect(m_mipAction, SIGNAL(triggered(bool)), SLOT(switchToMIPLayout(bool)));
+    connect(m_cprAction, SIGNAL(triggered(bool)), SLOT(switchToCPRMode(bool)));
 
     // Fem que no s'assigni automàticament l'input que s'ha seleccionat amb el menú de pacient, ja que fem tractaments adicionals
     // sobre el volum seleccionat i l'input final del visor pot diferir de l'inicial i és l'extensió qui decideix finalment quin input
@@ -521,6 +556,12 @@ void QMPRExtension::switchToMIPLayout(bool isMIPChecked)
 
 void QMPRExtension::handleAxialViewEvents(unsigned long eventID)
 {
+    if (m_cprAction->isChecked())
+    {
+        handleCPRPathEvents(m_axial2DView, eventID);
+        return;
+    }
+
     switch (eventID)
     {
         case vtkCommand::LeftButtonPressEvent:
@@ -573,6 +614,12 @@ void QMPRExtension::handleAxialViewEvents(unsigned long eventID)
 
 void QMPRExtension::handleSagitalViewEvents(unsigned long eventID)
 {
+    if (m_cprAction->isChecked())
+    {
+        handleCPRPathEvents(m_sagital2DView, eventID);
+        return;
+    }
+
     switch (eventID)
     {
         case vtkCommand::LeftButtonPressEvent:
@@ -620,6 +667,30 @@ void QMPRExtension::handleSagitalViewEvents(unsigned long eventID)
     }
 }
 
+void QMPRExtension::handleCoronalViewEvents(unsigned long eventID)
+{
+    if (m_cprAction->isChecked())
+    {
+        handleCPRPathEvents(m_coronal2DView, eventID);
+    }
+}
+
+void QMPRExtension::handleStraightenedCPRViewerEvents(unsigned long eventID)
+{
+    if (eventID != vtkCommand::MouseMoveEvent || !m_straightenedCPRViewer->getMainInput())
+    {
+        return;
+    }
+
+    // Cada fila de la reformatació rectificada correspon a una distància al llarg del camí
+    double clickedWorldPoint[3];
+    m_straightenedCPRViewer->getEventWorldCoordinate(clickedWorldPoint);
+    if (clickedWorldPoint[1] >= 0.0 && clickedWorldPoint[1] <= m_curvedPlanarReformation->getPathLength())
+    {
+        updateCPRCrossSection(clickedWorldPoint[1]);
+    }
+}
+
 bool QMPRExtension::detectAxialViewAxisActor()
 {
     bool picked = false;
@@ -720,7 +791,7 @@ void QMPRExtension::releaseAxialViewAxisActor()
 {
     if (m_pickedActorReslice)
     {
-        m_pickedActorReslice->SetInterpolationModeToCubic();
+        finishInteractiveReslice();
         // TODO No seria millor un restoreOverrideCursor?
         m_axial2DView->unsetCursor();
         if (m_pickedActorPlaneSource == m_sagitalPlaneSource)
@@ -732,7 +803,6 @@ void QMPRExtension::releaseAxialViewAxisActor()
             m_coronal2DView->render();
         }
         m_state = None;
-        m_pickedActorReslice = 0;
         m_pickedActorPlaneSource = 0;
         // Reactivem les tools
         m_toolManager->undoDisableAllToolsTemporarily();
@@ -839,10 +909,10 @@ void QMPRExtension::releaseSagitalViewAxisActor()
     if (m_pickedActorReslice)
     {
         m_sagital2DView->unsetCursor();
-        m_pickedActorReslice->SetInterpolationModeToCubic();
+        finishInteractiveReslice();
+        m_sagital2DView->render();
         m_coronal2DView->render();
         m_state = None;
-        m_pickedActorReslice = 0;
         m_pickedActorPlaneSource = 0;
         // Reactivem les tools
         m_toolManager->undoDisableAllToolsTemporarily();
@@ -1017,6 +1087,9 @@ void QMPRExtension::setInput(Volume *input)
 
     m_volume->getSpacing(m_axialSpacing);
 
+    // El camí del CPR està definit sobre el volum anterior
+    clearCPRPath();
+
     if (m_sagitalReslice)
     {
         m_sagitalReslice->Delete();
@@ -1572,13 +1645,75 @@ void QMPRExtension::updatePlane(vtkPlaneSource *planeSource, vtkImageReslice *re
 
     resliceAxes->Delete();
 
-    reslice->SetOutputSpacing(planeSizeX / extentLength[0], planeSizeY / extentLength[1], 1.0);
+    // Mentre l'usuari manipula el pla fem una previsualització a resolució reduïda que cobreix la mateixa regió de l'espai.
+    // vtkImageReslice ja reparteix l'extent de sortida entre tots els threads disponibles i interpola per files amb vectors de pas precalculats
+    // Només es redueix la resolució del pla que es manipula; quan es mou el pla axial des de la sagital el reslice seleccionat és el de la
+    // sagital, però el seu pla no canvia i es calcula a resolució completa
+    bool isInteractive = reslice == m_pickedActorReslice && isPickedResliceManipulated();
+    int outputExtentLength[2] = { extentLength[0], extentLength[1] };
+    if (isInteractive)
+    {
+        outputExtentLength[0] = qMax(1, extentLength[0] / InteractiveResliceSubsamplingFactor);
+        outputExtentLength[1] = qMax(1, extentLength[1] / InteractiveResliceSubsamplingFactor);
+    }
+
+    reslice->SetOutputSpacing(planeSizeX / outputExtentLength[0], planeSizeY / outputExtentLength[1], 1.0);
     reslice->SetOutputOrigin(0.0, 0.0, 0.0);
     // TODO Li passem thickSlab que és double però això només accepta int's! Buscar si aquesta és la manera adequada. Potsre si volem fer servir doubles
     // ho hauríem de combinar amb l'outputSpacing
     // Obtenim una única llesca
-    reslice->SetOutputExtent(0, extentLength[0] - 1, 0, extentLength[1] - 1, 0, static_cast<int>(m_thickSlab));
-    reslice->Update();
+    reslice->SetOutputExtent(0, outputExtentLength[0] - 1, 0, outputExtentLength[1] - 1, 0, static_cast<int>(m_thickSlab));
+
+    if (isInteractive)
+    {
+        // Es calcularà quan es torni al bucle d'events, de manera que si arriben nous moviments abans només es calcularà l'últim
+        m_interactiveResliceTimer->start();
+    }
+    else
+    {
+        reslice->Update();
+    }
+}
+
+void QMPRExtension::updateInteractiveReslice()
+{
+    if (!m_pickedActorReslice)
+    {
+        return;
+    }
+
+    m_pickedActorReslice->Update();
+    m_sagital2DView->render();
+    m_coronal2DView->render();
+}
+
+void QMPRExtension::finishInteractiveReslice()
+{
+    vtkImageReslice *reslice = m_pickedActorReslice;
+    m_pickedActorReslice = 0;
+    m_interactiveResliceTimer->stop();
+
+    if (!reslice)
+    {
+        return;
+    }
+
+    reslice->SetInterpolationModeToCubic();
+    // Només es recupera la geometria completa del pla que s'ha manipulat, els altres no s'han calculat a resolució reduïda
+    if (reslice == m_sagitalReslice && m_pickedActorPlaneSource == m_sagitalPlaneSource)
+    {
+        updatePlane(m_sagitalPlaneSource, m_sagitalReslice, m_sagitalExtentLength);
+    }
+    else if (reslice == m_coronalReslice && m_pickedActorPlaneSource == m_coronalPlaneSource)
+    {
+        updatePlane(m_coronalPlaneSource, m_coronalReslice, m_coronalExtentLength);
+    }
+}
+
+bool QMPRExtension::isPickedResliceManipulated() const
+{
+    return (m_pickedActorReslice == m_sagitalReslice && m_pickedActorPlaneSource == m_sagitalPlaneSource)
+        || (m_pickedActorReslice == m_coronalReslice && m_pickedActorPlaneSource == m_coronalPlaneSource);
 }
 
 void QMPRExtension::getSagitalXVector(double x[3])
@@ -1718,6 +1853,191 @@ void QMPRExtension::updateThickSlab(int value)
     updateControls();
 }
 
+void QMPRExtension::switchToCPRMode(bool isCPRChecked)
+{
+    if (isCPRChecked)
+    {
+        if (!m_cprSplitter)
+        {
+            createCPRViewers();
+        }
+        m_cprSplitter->show();
+        // Desactivem les tools perquè els clics a les vistes serveixin per dibuixar el camí
+        m_toolManager->disableAllToolsTemporarily();
+    }
+    else
+    {
+        clearCPRPath();
+        m_cprSplitter->hide();
+        m_toolManager->undoDisableAllToolsTemporarily();
+    }
+}
+
+void QMPRExtension::createCPRViewers()
+{
+    m_cprSplitter = new QSplitter(Qt::Vertical);
+
+    m_straightenedCPRViewer = new Q2DViewer(m_cprSplitter);
+    m_stretchedCPRViewer = new Q2DViewer(m_cprSplitter);
+    m_cprCrossSectionViewer = new Q2DViewer(m_cprSplitter);
+    foreach (Q2DViewer *viewer, QList<Q2DViewer*>() << m_straightenedCPRViewer << m_stretchedCPRViewer << m_cprCrossSectionViewer)
+    {
+        viewer->removeAnnotation(PatientOrientationAnnotation | MainInformationAnnotation | SliceAnnotation);
+        viewer->disableContextMenu();
+        viewer->setVoiLutData(m_axial2DView->getVoiLutData());
+        m_cprSplitter->addWidget(viewer);
+    }
+
+    m_straightenedCPRVolume = new Volume(this);
+    m_stretchedCPRVolume = new Volume(this);
+    m_cprCrossSectionVolume = new Volume(this);
+
+    connect(m_straightenedCPRViewer, SIGNAL(eventReceived(unsigned long)), SLOT(handleStraightenedCPRViewerEvents(unsigned long)));
+
+    m_horizontalSplitter->addWidget(m_cprSplitter);
+}
+
+void QMPRExtension::handleCPRPathEvents(Q2DViewer *viewer, unsigned long eventID)
+{
+    switch (eventID)
+    {
+        case vtkCommand::LeftButtonPressEvent:
+            addCPRPathPoint(viewer);
+            updateCPR();
+            break;
+
+        case vtkCommand::KeyPressEvent:
+            if (QString(viewer->getInteractor()->GetKeySym()) == "Escape")
+            {
+                clearCPRPath();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void QMPRExtension::addCPRPathPoint(Q2DViewer *viewer)
+{
+    // El camí es dibuixa en una única vista; si es clica en una altra vista se'n comença un de nou
+    if (viewer != m_cprPathViewer)
+    {
+        clearCPRPath();
+        m_cprPathViewer = viewer;
+        m_cprPathPolyline = new DrawerPolyline();
+        m_cprPathPolyline->increaseReferenceCount();
+        m_cprPathPolyline->setColor(QColor(255, 255, 0));
+        m_cprPathViewer->getDrawer()->draw(m_cprPathPolyline);
+    }
+
+    double clickedWorldPoint[3];
+    viewer->getEventWorldCoordinate(clickedWorldPoint);
+    double viewPoint[3] = { clickedWorldPoint[0], clickedWorldPoint[1], 0.0 };
+    m_cprPathPolyline->addPoint(viewPoint);
+    m_cprPathPolyline->update();
+
+    // Passem el punt a coordenades del volum. A les vistes sagital i coronal la matriu del reslice ens porta de coordenades de la vista a les del volum.
+    Vector3 volumePoint;
+    vtkPlaneSource *viewPlaneSource;
+    if (viewer == m_axial2DView)
+    {
+        volumePoint = Vector3(clickedWorldPoint[0], clickedWorldPoint[1], m_axialPlaneSource->GetCenter()[2]);
+        viewPlaneSource = m_axialPlaneSource;
+    }
+    else
+    {
+        vtkImageReslice *reslice = viewer == m_sagital2DView ? m_sagitalReslice : m_coronalReslice;
+        viewPlaneSource = viewer == m_sagital2DView ? m_sagitalPlaneSource : m_coronalPlaneSource;
+
+        double resliceOutputPoint[4] = { clickedWorldPoint[0], clickedWorldPoint[1], 0.0, 1.0 };
+        double volumeCoordinate[4];
+        reslice->GetResliceAxes()->MultiplyPoint(resliceOutputPoint, volumeCoordinate);
+        volumePoint = Vector3(volumeCoordinate[0], volumeCoordinate[1], volumeCoordinate[2]);
+    }
+
+    // Les files de les reformatacions es mostregen en la direcció perpendicular a la vista on s'ha dibuixat el camí
+    m_curvedPlanarReformation->setPath(m_curvedPlanarReformation->getPath() << volumePoint);
+    m_curvedPlanarReformation->setVectorOfInterest(Vector3(viewPlaneSource->GetNormal()));
+}
+
+void QMPRExtension::clearCPRPath()
+{
+    m_curvedPlanarReformation->setPath(QList<Vector3>());
+
+    if (m_cprPathPolyline)
+    {
+        m_cprPathPolyline->decreaseReferenceCount();
+        delete m_cprPathPolyline;
+        m_cprPathPolyline = 0;
+        m_cprPathViewer->render();
+    }
+    m_cprPathViewer = 0;
+}
+
+void QMPRExtension::updateCPR()
+{
+    if (!m_cprSplitter || m_curvedPlanarReformation->getPath().size() < 2)
+    {
+        return;
+    }
+
+    double spacing[3];
+    m_volume->getSpacing(spacing);
+    int extent[6];
+    m_volume->getExtent(extent);
+
+    // Les files han de ser prou amples per cobrir tot el volum en la direcció del vector d'interès
+    Vector3 vectorOfInterest = m_curvedPlanarReformation->getVectorOfInterest();
+    double width = qAbs(vectorOfInterest.x) * spacing[0] * (extent[1] - extent[0]) + qAbs(vectorOfInterest.y) * spacing[1] * (extent[3] - extent[2]) +
+                   qAbs(vectorOfInterest.z) * spacing[2] * (extent[5] - extent[4]);
+
+    m_curvedPlanarReformation->setInput(m_volume->getVtkData());
+    m_curvedPlanarReformation->setSampleSpacing(qMin(spacing[0], qMin(spacing[1], spacing[2])));
+    m_curvedPlanarReformation->setWidth(width);
+
+    setCPRViewerInput(m_straightenedCPRViewer, m_straightenedCPRVolume, m_curvedPlanarReformation->computeReformation(CurvedPlanarReformation::Straightened));
+    setCPRViewerInput(m_stretchedCPRViewer, m_stretchedCPRVolume, m_curvedPlanarReformation->computeReformation(CurvedPlanarReformation::Stretched));
+    updateCPRCrossSection(m_curvedPlanarReformation->getPathLength() / 2.0);
+}
+
+void QMPRExtension::updateCPRCrossSection(double distance)
+{
+    setCPRViewerInput(m_cprCrossSectionViewer, m_cprCrossSectionVolume, m_curvedPlanarReformation->computeCrossSection(distance));
+}
+
+void QMPRExtension::setCPRViewerInput(Q2DViewer *viewer, Volume *volume, vtkImageData *image)
+{
+    if (!image)
+    {
+        return;
+    }
+
+    // Si el visor ja mostra una imatge de la mateixa mida, n'actualitzem el contingut per no perdre el zoom ni la posició de la càmera
+    if (viewer->getMainInput() == volume && volume->isPixelDataLoaded())
+    {
+        int currentDimensions[3];
+        int newDimensions[3];
+        volume->getVtkData()->GetDimensions(currentDimensions);
+        image->GetDimensions(newDimensions);
+        if (currentDimensions[0] == newDimensions[0] && currentDimensions[1] == newDimensions[1])
+        {
+            volume->getVtkData()->DeepCopy(image);
+            volume->getVtkData()->Modified();
+            viewer->render();
+            return;
+        }
+    }
+
+    // TODO Això es necessari perquè tingui la informació de la sèrie, estudis, pacient...
+    volume->setImages(m_volume->getImages());
+    volume->setData(image);
+    volume->setNumberOfPhases(1);
+    volume->setNumberOfSlicesPerPhase(1);
+    viewer->setInput(volume);
+    viewer->render();
+}
+
 void QMPRExtension::readSettings()
 {
     Settings settings;
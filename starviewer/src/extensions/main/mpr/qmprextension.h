@@ -19,8 +19,11 @@
 
 // FWD declarations
 class QAction;
+class QSplitter;
 class QStringList;
+class QTimer;
 class vtkAxisActor2D;
+class vtkImageData;
 class vtkImageReslice;
 class vtkPlaneSource;
 class vtkTransform;
@@ -28,8 +31,11 @@ class vtkTransform;
 namespace udg {
 
 // FWD declarations
+class CurvedPlanarReformation;
 class DrawerPoint;
+class DrawerPolyline;
 class ToolManager;
+class Q2DViewer;
 class Q3DViewer;
 class Volume;
 
@@ -60,6 +66,10 @@ public slots:
     /// Activa o desactiva la distribució de finestres al mode MIP
     void switchToMIPLayout(bool isMIPChecked);
 
+    /// Activa o desactiva el mode de reformatació curvilínia (CPR). Mentre està actiu, cada clic en una de les vistes de l'MPR
+    /// afegeix un punt al camí que es fa servir per calcular les reformatacions
+    void switchToCPRMode(bool isCPRChecked);
+
 signals:
     /// Notificació del canvi de direcció de cadascun dels eixos que podem manipular. Aquests senyals haurien de ser enviats quan canviem la direcció a
     /// través dels controls (línies blaves i vermella)
@@ -92,9 +102,17 @@ private:
     /// TODO: separar en dos mètodes diferenciats segons quin pla????
     void updatePlanes();
 
-    /// Actualitza els valors del pla donat amb el reslice associat
+    /// Actualitza els valors del pla donat amb el reslice associat.
+    /// Si el pla és el que s'està manipulant, es calcula a resolució reduïda i de manera diferida (veure updateInteractiveReslice())
     void updatePlane(vtkPlaneSource *planeSource, vtkImageReslice *reslice, int extentLength[2]);
 
+    /// Finalitza la manipulació del reslice seleccionat i, si el seu pla és el que s'ha manipulat, el torna a calcular a resolució completa
+    /// i amb interpolació cúbica
+    void finishInteractiveReslice();
+
+    /// Retorna cert si el pla del reslice seleccionat és el que s'està manipulant. No ho és quan es mou el pla axial des de la vista sagital
+    bool isPickedResliceManipulated() const;
+
     /// Inicialitza les orientacions dels plans de tall correctament perquè tinguin un espaiat, dimensions i límits correctes
     void initOrientation();
 
@@ -133,6 +151,27 @@ private:
     /// Retorna la tranformació necessària per passar de coordenades de món a coordenades de la vista sagital.
     vtkTransform* getWorldToSagitalTransform() const;
 
+    /// Crea els visors on es mostren les reformatacions curvilínies
+    void createCPRViewers();
+
+    /// Tracta els events d'una vista de l'MPR quan el mode CPR està actiu
+    void handleCPRPathEvents(Q2DViewer *viewer, unsigned long eventID);
+
+    /// Afegeix al camí del CPR el punt on s'ha fet clic al visor donat
+    void addCPRPathPoint(Q2DViewer *viewer);
+
+    /// Esborra el camí del CPR i el seu dibuix
+    void clearCPRPath();
+
+    /// Torna a calcular les reformatacions curvilínies amb el camí actual
+    void updateCPR();
+
+    /// Calcula i mostra la secció transversal al camí a la distància donada des del seu inici
+    void updateCPRCrossSection(double distance);
+
+    /// Mostra la imatge donada al visor i volum donats
+    void setCPRViewerInput(Q2DViewer *viewer, Volume *volume, vtkImageData *image);
+
 private slots:
     /// Col·loca i ordena les icones i el menú de les eines de ROI segons l'última tool de ROI seleccionada
     void rearrangeROIToolsMenu();
@@ -158,6 +197,10 @@ private slots:
     /// Gestiona els events de cada finestra per controlar els eixos de manipulació
     void handleAxialViewEvents(unsigned long eventID);
     void handleSagitalViewEvents(unsigned long eventID);
+    void handleCoronalViewEvents(unsigned long eventID);
+
+    /// Gestiona els events del visor de la reformatació rectificada per actualitzar la secció transversal
+    void handleStraightenedCPRViewerEvents(unsigned long eventID);
 
     /// Detecten si algun dels plans s'han seleccionat per l'usuari
     bool detectAxialViewAxisActor();
@@ -178,6 +221,10 @@ private slots:
     /// Fa les accions pertinents quan una llesca s'ha actualitzat
     void axialSliceUpdated(int slice);
 
+    /// Calcula el reslice que s'està manipulant amb l'última posició del pla demanada i repinta les vistes.
+    /// Les posicions intermèdies que han arribat mentre no es tornava al bucle d'events es descarten.
+    void updateInteractiveReslice();
+
     /// Actualitza el valor del thickSlab i tot el que hi estigui relacionat amb ell
     void updateThickSlab(double value);
     void updateThickSlab(int value);
@@ -193,6 +240,9 @@ private:
     /// considerar-se prou proper per fer una operació de picking
     static const double PickingDistanceThreshold;
 
+    /// Factor de reducció de resolució del reslice mentre l'usuari manipula un pla
+    static const int InteractiveResliceSubsamplingFactor;
+
     /// El reslice de cada vista
     vtkImageReslice *m_sagitalReslice, *m_coronalReslice;
 
@@ -238,6 +288,9 @@ private:
     vtkPlaneSource *m_pickedActorPlaneSource;
     vtkImageReslice *m_pickedActorReslice;
 
+    /// Timer per agrupar les actualitzacions del reslice manipulat i calcular només la darrera
+    QTimer *m_interactiveResliceTimer;
+
     /// Gruix del thickSlab que servirà per al MIP
     double m_thickSlab;
 
@@ -249,6 +302,21 @@ private:
     /// Visor de MIP
     Q3DViewer *m_mipViewer;
 
+    /// Acció per activar el mode CPR
+    QAction *m_cprAction;
+
+    /// Calcula les reformatacions curvilínies a partir del camí dibuixat per l'usuari
+    CurvedPlanarReformation *m_curvedPlanarReformation;
+
+    /// Visors i volums de les reformatacions rectificada, estirada i de la secció transversal al camí
+    QSplitter *m_cprSplitter;
+    Q2DViewer *m_straightenedCPRViewer, *m_stretchedCPRViewer, *m_cprCrossSectionViewer;
+    Volume *m_straightenedCPRVolume, *m_stretchedCPRVolume, *m_cprCrossSectionVolume;
+
+    /// Dibuix del camí del CPR i visor on s'està dibuixant
+    DrawerPolyline *m_cprPathPolyline;
+    Q2DViewer *m_cprPathViewer;
+
     /// Estat en el que es troba la manipulació de plans
     enum { None, Rotating, Pushing };
     int m_state;
@@ -433,6 +433,7 @@ void Q2DViewerExtension::initializeTools()
     m_drawingToolButton->addAction(m_toolManager->registerTool("MagicROITool"));
     m_drawingToolButton->addAction(m_toolManager->registerTool("PolylineROITool"));
     m_drawingToolButton->addAction(m_toolManager->registerTool("CircleTool"));
+    m_drawingToolButton->addAction(m_toolManager->registerTool("VOITool"));
 
     m_cursor3DToolButton->setDefaultAction(m_toolManager->registerTool("Cursor3DTool"));
 
@@ -482,7 +483,7 @@ void Q2DViewerExtension::initializeTools()
 #else
     leftButtonExclusiveTools << "ZoomTool" << "SlicingMouseTool" << "TranslateLeftTool" << "WindowLevelLeftTool" << "PolylineROITool" << "DistanceTool"
                              << "PerpendicularDistanceTool" << "EraserTool" << "AngleTool" << "NonClosedAngleTool" << "Cursor3DTool" << "EllipticalROITool"
-                             << "MagicROITool" << "CircleTool" << "MagnifyingGlassTool";
+                             << "MagicROITool" << "CircleTool" << "VOITool" << "MagnifyingGlassTool";
 #endif
 
     m_toolManager->addExclusiveToolsGroup("LeftButtonGroup", leftButtonExclusiveTools);
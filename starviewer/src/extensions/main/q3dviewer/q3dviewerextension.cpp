@@ -22,6 +22,7 @@
 #include "screenshottool.h"
 #include "toolproxy.h"
 #include "qexportertool.h"
+#include "shortcutmanager.h"
 // Qt
 #include <QAction>
 #include <QFileDialog>
@@ -59,6 +60,13 @@ Q3DViewerExtension::Q3DViewerExtension(QWidget *parent)
     hideClutEditor();
     m_screenshotsExporterToolButton->setToolTip(tr("Export viewer image to DICOM and send it to a PACS server"));
     m_customStyleToolButton->setToolTip(tr("Show/Hide advanced colour options"));
+
+    // Hidden action to measure the interactive rendering speed of the current rendering method
+    QAction *benchmarkAction = new QAction(this);
+    benchmarkAction->setShortcuts(ShortcutManager::getShortcuts(Shortcuts::Benchmark3DRendering));
+    benchmarkAction->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    connect(benchmarkAction, &QAction::triggered, this, &Q3DViewerExtension::benchmarkRendering);
+    addAction(benchmarkAction);
 }
 
 Q3DViewerExtension::~Q3DViewerExtension()
@@ -521,6 +529,16 @@ void Q3DViewerExtension::applyRenderingStyle(const QModelIndex &index)
     enableAutoUpdate();
 }
 
+void Q3DViewerExtension::benchmarkRendering()
+{
+    // Make sure that there isn't a pending high quality render that would be counted in the benchmark
+    m_timer->stop();
+
+    this->setCursor(QCursor(Qt::WaitCursor));
+    m_3DView->benchmarkInteractiveRendering();
+    this->unsetCursor();
+}
+
 void Q3DViewerExtension::showScreenshotsExporterDialog()
 {
     QExporterTool exporter(m_3DView);
@@ -89,6 +89,8 @@ private slots:
     void changeViewerTransferFunction();
     void applyRenderingStyle(const QModelIndex &index);
     void showScreenshotsExporterDialog();
+    /// Mesura el temps mitjà per frame del mètode de rendering actual fent una volta completa al volum. El resultat queda registrat al log.
+    void benchmarkRendering();
 
 private:
     /// El volum d'input
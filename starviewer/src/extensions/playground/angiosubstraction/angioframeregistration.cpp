@@ -0,0 +1,348 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "angioframeregistration.h"
+
+#include "logging.h"
+
+#include <QtConcurrentMap>
+
+#include <itkCommand.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkMattesMutualInformationImageToImageMetric.h>
+#include <itkMultiResolutionImageRegistrationMethod.h>
+#include <itkRecursiveMultiResolutionPyramidImageFilter.h>
+#include <itkRegularStepGradientDescentOptimizer.h>
+#include <itkTranslationTransform.h>
+
+namespace udg {
+
+namespace {
+
+typedef itk::Image<float, 2> FrameImageType;
+typedef itk::TranslationTransform<double, 2> TransformType;
+typedef itk::RegularStepGradientDescentOptimizer OptimizerType;
+typedef itk::LinearInterpolateImageFunction<FrameImageType, double> InterpolatorType;
+typedef itk::MattesMutualInformationImageToImageMetric<FrameImageType, FrameImageType> MetricType;
+typedef itk::MultiResolutionImageRegistrationMethod<FrameImageType, FrameImageType> RegistrationType;
+typedef itk::RecursiveMultiResolutionPyramidImageFilter<FrameImageType, FrameImageType> PyramidType;
+
+/// Maximum step of the optimizer in the coarsest level, in mm. It's divided by 2 at each finer level.
+const double MaximumStepLength = 8.0;
+const double MinimumStepLength = 0.05;
+const int MaximumNumberOfIterations = 100;
+const unsigned int NumberOfHistogramBins = 32;
+/// Fraction of the pixels of the fixed image sampled by the metric, with a minimum number of samples for small images
+const double SamplingFraction = 0.1;
+const itk::SizeValueType MinimumNumberOfSamples = 1000;
+
+/// Shortens the steps of the optimizer at the start of each level and stops the registration when it's cancelled
+class RegistrationObserver : public itk::Command {
+public:
+    typedef RegistrationObserver Self;
+    typedef itk::Command Superclass;
+    typedef itk::SmartPointer<Self> Pointer;
+    itkNewMacro(Self);
+
+    void setRegistration(RegistrationType *registration, OptimizerType *optimizer, const QAtomicInt *cancelled)
+    {
+        m_registration = registration;
+        m_optimizer = optimizer;
+        m_cancelled = cancelled;
+    }
+
+    void Execute(itk::Object *caller, const itk::EventObject &event)
+    {
+        Execute(static_cast<const itk::Object*>(caller), event);
+    }
+
+    void Execute(const itk::Object *caller, const itk::EventObject &event)
+    {
+        if (!itk::IterationEvent().CheckEvent(&event))
+        {
+            return;
+        }
+
+        if (m_cancelled->load())
+        {
+            m_registration->StopRegistration();
+            m_optimizer->StopOptimization();
+        }
+        else if (caller == m_registration && m_registration->GetCurrentLevel() > 0)
+        {
+            m_optimizer->SetMaximumStepLength(m_optimizer->GetMaximumStepLength() / 2.0);
+        }
+    }
+
+protected:
+    RegistrationObserver()
+     : m_registration(0), m_optimizer(0), m_cancelled(0)
+    {
+    }
+
+private:
+    RegistrationType *m_registration;
+    OptimizerType *m_optimizer;
+    const QAtomicInt *m_cancelled;
+};
+
+}
+
+const int AngioFrameRegistration::DefaultNumberOfLevels = 3;
+
+AngioFrameRegistration::AngioFrameRegistration(QObject *parent)
+ : QObject(parent), m_volume(0), m_numberOfLevels(DefaultNumberOfLevels), m_voxels(0), m_referenceFrame(0), m_cancelled(0)
+{
+    m_dimensions[0] = m_dimensions[1] = m_dimensions[2] = 0;
+    m_spacing[0] = m_spacing[1] = 1.0;
+
+    connect(&m_watcher, SIGNAL(progressValueChanged(int)), SLOT(emitProgress(int)));
+    connect(&m_watcher, SIGNAL(finished()), SLOT(finishRun()));
+}
+
+AngioFrameRegistration::~AngioFrameRegistration()
+{
+    cancel();
+    m_watcher.waitForFinished();
+}
+
+void AngioFrameRegistration::setInput(Volume *volume)
+{
+    cancel();
+    m_watcher.waitForFinished();
+
+    m_volume = volume;
+    m_voxels = 0;
+    m_tasks.clear();
+    m_translations.clear();
+}
+
+void AngioFrameRegistration::setNumberOfLevels(int numberOfLevels)
+{
+    m_numberOfLevels = qMax(1, numberOfLevels);
+}
+
+int AngioFrameRegistration::getNumberOfLevels() const
+{
+    return m_numberOfLevels;
+}
+
+void AngioFrameRegistration::start(int referenceFrame, const QVector<int> &frames)
+{
+    if (!m_volume || isRunning())
+    {
+        return;
+    }
+
+    // The ITK image is obtained here because the volume may have to build it
+    Volume::ItkImageType *image = m_volume->getItkData();
+    Volume::ItkImageType::SizeType size = image->GetBufferedRegion().GetSize();
+    for (int i = 0; i < 3; i++)
+    {
+        m_dimensions[i] = size[i];
+    }
+    m_spacing[0] = image->GetSpacing()[0];
+    m_spacing[1] = image->GetSpacing()[1];
+    m_voxels = image->GetBufferPointer();
+
+    m_referenceFrame = referenceFrame;
+    m_referenceImage = createFrameImage(referenceFrame);
+    m_translations.insert(qMakePair(referenceFrame, referenceFrame), QPointF(0.0, 0.0));
+    m_tasks.clear();
+    foreach (int frame, frames)
+    {
+        if (frame >= 0 && frame < m_dimensions[2] && !m_translations.contains(qMakePair(referenceFrame, frame)))
+        {
+            Task task;
+            task.frame = frame;
+            task.done = false;
+            m_tasks.append(task);
+        }
+    }
+
+    DEBUG_LOG(QString("Registering %1 frames to frame %2, %3 of %4 were already registered").arg(m_tasks.size()).arg(referenceFrame)
+        .arg(frames.size() - m_tasks.size()).arg(frames.size()));
+
+    m_cancelled.store(0);
+    m_timer.start();
+    m_watcher.setFuture(QtConcurrent::map(m_tasks, [this](Task &task)
+    {
+        registerFrame(task);
+    }));
+}
+
+void AngioFrameRegistration::cancel()
+{
+    if (isRunning())
+    {
+        m_cancelled.store(1);
+        m_watcher.cancel();
+    }
+}
+
+bool AngioFrameRegistration::isRunning() const
+{
+    return m_watcher.isRunning();
+}
+
+bool AngioFrameRegistration::getTranslation(int referenceFrame, int frame, QPointF &translation) const
+{
+    QHash<QPair<int, int>, QPointF>::const_iterator iterator = m_translations.constFind(qMakePair(referenceFrame, frame));
+    if (iterator == m_translations.constEnd())
+    {
+        return false;
+    }
+
+    translation = iterator.value();
+    return true;
+}
+
+void AngioFrameRegistration::emitProgress(int registeredFrames)
+{
+    emit progress(registeredFrames, m_tasks.size());
+}
+
+void AngioFrameRegistration::finishRun()
+{
+    int numberOfRegisteredFrames = 0;
+    foreach (const Task &task, m_tasks)
+    {
+        if (task.done)
+        {
+            m_translations.insert(qMakePair(m_referenceFrame, task.frame), task.translation);
+            numberOfRegisteredFrames++;
+        }
+    }
+
+    DEBUG_LOG(QString("%1 of %2 frames registered in %3 ms").arg(numberOfRegisteredFrames).arg(m_tasks.size()).arg(m_timer.elapsed()));
+
+    m_tasks.clear();
+    m_referenceImage = 0;
+    emit finished();
+}
+
+void AngioFrameRegistration::registerFrame(Task &task) const
+{
+    if (m_cancelled.load())
+    {
+        return;
+    }
+
+    // The pipeline of the registration updates its fixed image, so each task has its own image object sharing the pixels of the reference image
+    FrameImageType::Pointer fixedImage = FrameImageType::New();
+    fixedImage->SetRegions(m_referenceImage->GetLargestPossibleRegion());
+    fixedImage->SetSpacing(m_referenceImage->GetSpacing());
+    fixedImage->SetOrigin(m_referenceImage->GetOrigin());
+    fixedImage->SetDirection(m_referenceImage->GetDirection());
+    fixedImage->SetPixelContainer(m_referenceImage->GetPixelContainer());
+    FrameImageType::Pointer movingImage = createFrameImage(task.frame);
+
+    TransformType::Pointer transform = TransformType::New();
+    OptimizerType::Pointer optimizer = OptimizerType::New();
+    InterpolatorType::Pointer interpolator = InterpolatorType::New();
+    MetricType::Pointer metric = MetricType::New();
+    PyramidType::Pointer fixedPyramid = PyramidType::New();
+    PyramidType::Pointer movingPyramid = PyramidType::New();
+    RegistrationType::Pointer registration = RegistrationType::New();
+
+    // The frames are already registered in parallel, so each registration uses a single thread
+    metric->SetNumberOfThreads(1);
+    fixedPyramid->SetNumberOfThreads(1);
+    movingPyramid->SetNumberOfThreads(1);
+    registration->SetNumberOfThreads(1);
+
+    FrameImageType::RegionType fixedRegion = fixedImage->GetBufferedRegion();
+    metric->SetNumberOfHistogramBins(NumberOfHistogramBins);
+    itk::SizeValueType numberOfSamples = static_cast<itk::SizeValueType>(fixedRegion.GetNumberOfPixels() * SamplingFraction);
+    metric->SetNumberOfSpatialSamples(qMin(fixedRegion.GetNumberOfPixels(), qMax(MinimumNumberOfSamples, numberOfSamples)));
+    // Same samples in every run
+    metric->ReinitializeSeed(76926294);
+
+    optimizer->SetMaximumStepLength(MaximumStepLength);
+    optimizer->SetMinimumStepLength(MinimumStepLength);
+    optimizer->SetNumberOfIterations(MaximumNumberOfIterations);
+
+    registration->SetOptimizer(optimizer);
+    registration->SetTransform(transform);
+    registration->SetInterpolator(interpolator);
+    registration->SetMetric(metric);
+    registration->SetFixedImagePyramid(fixedPyramid);
+    registration->SetMovingImagePyramid(movingPyramid);
+    registration->SetFixedImage(fixedImage);
+    registration->SetMovingImage(movingImage);
+    registration->SetFixedImageRegion(fixedRegion);
+    registration->SetNumberOfLevels(m_numberOfLevels);
+
+    RegistrationType::ParametersType initialParameters(transform->GetNumberOfParameters());
+    initialParameters.Fill(0.0);
+    registration->SetInitialTransformParameters(initialParameters);
+
+    RegistrationObserver::Pointer observer = RegistrationObserver::New();
+    observer->setRegistration(registration, optimizer, &m_cancelled);
+    registration->AddObserver(itk::IterationEvent(), observer);
+    optimizer->AddObserver(itk::IterationEvent(), observer);
+
+    try
+    {
+        registration->Update();
+    }
+    catch (itk::ExceptionObject &exception)
+    {
+        DEBUG_LOG(QString("Registration of frame %1 failed: %2").arg(task.frame).arg(exception.GetDescription()));
+        return;
+    }
+
+    if (m_cancelled.load())
+    {
+        return;
+    }
+
+    RegistrationType::ParametersType parameters = registration->GetLastTransformParameters();
+    task.translation = QPointF(parameters[0] / m_spacing[0], parameters[1] / m_spacing[1]);
+    task.done = true;
+}
+
+AngioFrameRegistration::FrameImageType::Pointer AngioFrameRegistration::createFrameImage(int frame) const
+{
+    // The central half of the frame in each direction, like in the manual registration, so that the borders don't drive the registration
+    FrameImageType::SizeType size;
+    size[0] = qMax(1, m_dimensions[0] / 2);
+    size[1] = qMax(1, m_dimensions[1] / 2);
+    int startX = m_dimensions[0] / 4;
+    int startY = m_dimensions[1] / 4;
+
+    FrameImageType::IndexType start;
+    start.Fill(0);
+    FrameImageType::RegionType region(start, size);
+
+    FrameImageType::Pointer image = FrameImageType::New();
+    image->SetRegions(region);
+    image->SetSpacing(m_spacing);
+    image->Allocate();
+
+    float *pixels = image->GetBufferPointer();
+    for (unsigned int y = 0; y < size[1]; y++)
+    {
+        const Volume::ItkPixelType *row = m_voxels + (static_cast<qint64>(frame) * m_dimensions[1] + startY + y) * m_dimensions[0] + startX;
+        for (unsigned int x = 0; x < size[0]; x++)
+        {
+            *pixels++ = row[x];
+        }
+    }
+
+    return image;
+}
+
+} // End namespace udg
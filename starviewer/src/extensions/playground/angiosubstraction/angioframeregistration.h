@@ -0,0 +1,130 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGANGIOFRAMEREGISTRATION_H
+#define UDGANGIOFRAMEREGISTRATION_H
+
+#include <QObject>
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QPair>
+#include <QPointF>
+#include <QVector>
+
+#include "volume.h"
+
+namespace udg {
+
+/**
+    Finds the translations that align the frames of an angiography run to a reference (mask) frame.
+
+    Each frame is registered independently with a translation transform, a Mattes mutual information metric evaluated on a random sample of the
+    pixels and a regular step gradient descent optimizer, going from coarse to fine through image pyramids. Only the central part of the frames
+    is used so that the background doesn't drive the registration. The frames are registered in parallel in the global thread pool, each one
+    with a single ITK thread, and the run can be followed with progress() and cancelled.
+
+    The translations are cached by pair of frames until the input changes, so registering again to the same reference is immediate.
+  */
+class AngioFrameRegistration : public QObject {
+Q_OBJECT
+public:
+    /// Default number of levels of the image pyramids
+    static const int DefaultNumberOfLevels;
+
+    explicit AngioFrameRegistration(QObject *parent = 0);
+    ~AngioFrameRegistration();
+
+    /// Sets the volume whose slices are the frames to register. Cancels the running registration and discards the cached translations.
+    void setInput(Volume *volume);
+
+    /// Sets the number of levels of the image pyramids
+    void setNumberOfLevels(int numberOfLevels);
+    int getNumberOfLevels() const;
+
+    /// Starts registering the given frames to the reference frame and returns immediately. Frames already registered to the same reference
+    /// are taken from the cache. Does nothing if a registration is running.
+    void start(int referenceFrame, const QVector<int> &frames);
+
+    /// Cancels the running registration. The frames registered so far are kept in the cache.
+    void cancel();
+
+    /// Returns true while a registration is running
+    bool isRunning() const;
+
+    /// Returns true and the translation in pixels that aligns the frame to the reference frame if it has been computed. The pixel (x, y) of the
+    /// reference frame corresponds to the pixel (x + translation.x(), y + translation.y()) of the frame.
+    bool getTranslation(int referenceFrame, int frame, QPointF &translation) const;
+
+signals:
+    /// Emitted each time a frame has been registered, with the number of frames registered so far and the total of the run
+    void progress(int registeredFrames, int numberOfFrames);
+
+    /// Emitted when the run ends, both if it has been completed and if it has been cancelled
+    void finished();
+
+private:
+    typedef itk::Image<float, 2> FrameImageType;
+
+    /// Registration of one frame
+    struct Task {
+        int frame;
+        bool done;
+        QPointF translation;
+    };
+
+    /// Registers the frame of the task to the reference frame
+    void registerFrame(Task &task) const;
+
+    /// Returns a copy of the central part of the frame as a float image
+    FrameImageType::Pointer createFrameImage(int frame) const;
+
+private slots:
+    /// Emits progress() with the number of finished tasks
+    void emitProgress(int registeredFrames);
+
+    /// Caches the translations of the finished tasks and emits finished()
+    void finishRun();
+
+private:
+    Volume *m_volume;
+    int m_numberOfLevels;
+
+    /// Pixels of the input and their layout, read in the tasks
+    const Volume::ItkPixelType *m_voxels;
+    int m_dimensions[3];
+    double m_spacing[2];
+
+    /// Reference frame of the current run, its image, whose pixels are shared read-only by all the tasks, and the tasks
+    int m_referenceFrame;
+    FrameImageType::Pointer m_referenceImage;
+    QVector<Task> m_tasks;
+    QFutureWatcher<void> m_watcher;
+
+    /// Set to stop the optimizers of the running tasks
+    QAtomicInt m_cancelled;
+
+    /// Measures the duration of the run
+    QElapsedTimer m_timer;
+
+    /// Translations found by pair of reference frame and frame
+    QHash<QPair<int, int>, QPointF> m_translations;
+};
+
+} // End namespace udg
+
+#endif
@@ -5,13 +5,17 @@
 
 FORMS += qangiosubstractionextensionbase.ui 
 HEADERS += angiosubstractionsettings.h \
+           angioframeregistration.h \
            qangiosubstractionextension.h \
            angiosubstractionextensionmediator.h 
 SOURCES += angiosubstractionsettings.cpp \
+           angioframeregistration.cpp \
            qangiosubstractionextension.cpp \
            angiosubstractionextensionmediator.cpp 
 
 RESOURCES += angiosubstraction.qrc
 
+QT += concurrent
+
 EXTENSION_DIR = $$PWD
 include(../../basicconfextensions.pri)
@@ -14,16 +14,8 @@
 #include "toolconfiguration.h"
 #include "patientbrowsermenu.h"
 #include "angiosubstractionsettings.h"
+#include "angioframeregistration.h"
 #include "volume.h"
-// ITK
-#include <itkImageRegistrationMethod.h>
-#include <itkTranslationTransform.h>
-#include <itkLinearInterpolateImageFunction.h>
-#include <itkExtractImageFilter.h>
-#include <itkMutualInformationImageToImageMetric.h>
-#include <itkGradientDescentOptimizer.h>
-#include <itkNormalizeImageFilter.h>
-#include <itkDiscreteGaussianImageFilter.h>
 
 namespace udg {
 
@@ -33,8 +25,8 @@ QAngioSubstractionExtension::QAngioSubstractionExtension(QWidget *parent)
     setupUi(this);
     AngioSubstractionSettings().init();
 
-    //De moment amaguem el botó d'autoregistration perquè no acaba de funcionar
-    m_autoRegistrationToolButton->setVisible(false);
+    m_frameRegistration = new AngioFrameRegistration(this);
+    m_autoRegistrationProgressBar->setVisible(false);
 
     initializeTools();
     createConnections();
@@ -104,12 +96,16 @@ void QAngioSubstractionExtension::createConnections()
     m_2DView_2->getViewer()->setAutomaticallyLoadPatientBrowserMenuSelectedInput(false);
     connect(m_2DView_1->getViewer()->getPatientBrowserMenu(), SIGNAL(selectedVolume(Volume*)), SLOT(setInput(Volume*)));
     connect(m_imageSelectorSpinBox, SIGNAL(valueChanged(int)), SLOT(computeDifferenceImage(int)));
-    //connect(m_autoRegistrationToolButton, SIGNAL(clicked()), SLOT(computeAutomateSingleImage()));
+    connect(m_autoRegistrationToolButton, SIGNAL(clicked()), SLOT(toggleAutomaticRegistration()));
+    connect(m_frameRegistration, SIGNAL(progress(int, int)), SLOT(updateRegistrationProgress(int, int)));
+    connect(m_frameRegistration, SIGNAL(finished()), SLOT(applyAutomaticRegistration()));
 }
 
 void QAngioSubstractionExtension::setInput(Volume *input)
 {
     m_mainVolume = input;
+    m_frameRegistration->setInput(m_mainVolume);
+    m_autoRegistrationToolButton->setEnabled(m_mainVolume != 0);
 
     //Desactivem la sincronització perquè si no quan es canvia l'input no funciona correctament
     m_2DView_1->enableSynchronization(false);
@@ -154,13 +150,7 @@ void QAngioSubstractionExtension::computeDifferenceImage(int imageid)
     
     //Actualitzem les dades de la transdifference tool
     m_toolManager->triggerTool("TransDifferenceTool");
-    TransDifferenceTool* tdTool = static_cast<TransDifferenceTool*> (m_2DView_2->getViewer()->getToolProxy()->getTool("TransDifferenceTool"));
-    if(m_tdToolData == 0){
-        m_tdToolData = static_cast<TransDifferenceToolData*> (tdTool->getToolData());
-    }
-    if(m_tdToolData->getInputVolume() != m_mainVolume){
-        m_tdToolData->setInputVolume(m_mainVolume);
-    }
+    TransDifferenceTool* tdTool = getTransDifferenceTool();
     m_tdToolData->setReferenceSlice(imageid);
     tdTool->initializeDifferenceImage();
     m_toolManager->triggerTool("SlicingMouseTool");
@@ -168,160 +158,78 @@ void QAngioSubstractionExtension::computeDifferenceImage(int imageid)
     QApplication::restoreOverrideCursor();
 }
 
-void QAngioSubstractionExtension::computeAutomateSingleImage()
+void QAngioSubstractionExtension::toggleAutomaticRegistration()
 {
-    QApplication::setOverrideCursor(Qt::WaitCursor);
-    const    unsigned int          Dimension = 2;
-    typedef  Volume::ItkPixelType  PixelType;
-
-    typedef itk::Image< PixelType, Dimension >  FixedImageType;
-    typedef itk::Image< PixelType, Dimension >  MovingImageType;
-    typedef   float     InternalPixelType;
-    typedef itk::Image< InternalPixelType, Dimension > InternalImageType;
-
-    typedef itk::TranslationTransform< double, Dimension > TransformType;
-    typedef itk::GradientDescentOptimizer                  OptimizerType;
-    typedef itk::LinearInterpolateImageFunction< 
-                                    InternalImageType,
-                                    double             > InterpolatorType;
-    typedef itk::ImageRegistrationMethod< 
-                                    InternalImageType, 
-                                    InternalImageType >  RegistrationType;
-    typedef itk::MutualInformationImageToImageMetric< 
-                                          InternalImageType, 
-                                          InternalImageType >    MetricType;
-
-    TransformType::Pointer      transform     = TransformType::New();
-    OptimizerType::Pointer      optimizer     = OptimizerType::New();
-    InterpolatorType::Pointer   interpolator  = InterpolatorType::New();
-    RegistrationType::Pointer   registration  = RegistrationType::New();
-
-    registration->SetOptimizer(optimizer);
-    registration->SetTransform(transform);
-    registration->SetInterpolator(interpolator);
-
-    MetricType::Pointer         metric        = MetricType::New();
-    registration->SetMetric(metric);
-    metric->SetFixedImageStandardDeviation(0.4);
-    metric->SetMovingImageStandardDeviation(0.4);
-    metric->SetNumberOfSpatialSamples(50);
-
-    typedef itk::ExtractImageFilter< Volume::ItkImageType, FixedImageType > FilterType;
-    
-    FilterType::Pointer extractFixedImageFilter = FilterType::New();
-    Volume::ItkImageType::RegionType inputRegion = m_mainVolume->getItkData()->GetLargestPossibleRegion();
-    Volume::ItkImageType::SizeType size = inputRegion.GetSize();
-    //Dividim la mida per dos per tal de quedar-nos només amb la part central
-    // ja que si no ens registre el background
-    size[0] = size[0] / 2;
-    size[1] = size[1] / 2;
-    size[2] = 0;
-    Volume::ItkImageType::IndexType start = inputRegion.GetIndex();
-    const unsigned int sliceReference = m_imageSelectorSpinBox->value();
-    //comencem a un quart de la imatge
-    start[0] = size[0] / 2;
-    start[1] = size[1] / 2;
-    start[2] = sliceReference;
-    Volume::ItkImageType::RegionType desiredRegion;
-    desiredRegion.SetSize(size);
-    desiredRegion.SetIndex(start);
-    extractFixedImageFilter->SetExtractionRegion(desiredRegion);
-    extractFixedImageFilter->SetInput(m_mainVolume->getItkData());
-    extractFixedImageFilter->Update();
-
-    FilterType::Pointer extractMovingImageFilter = FilterType::New();
-    Volume::ItkImageType::IndexType startMoving = inputRegion.GetIndex();
-    const unsigned int sliceNumber = m_2DView_1->getViewer()->getCurrentSlice();
-    startMoving[0] = size[0] / 2;
-    startMoving[1] = size[1] / 2;
-    startMoving[2] = sliceNumber;
-    Volume::ItkImageType::RegionType desiredMovingRegion;
-    desiredMovingRegion.SetSize(size);
-    desiredMovingRegion.SetIndex(startMoving);
-    extractMovingImageFilter->SetExtractionRegion(desiredMovingRegion);
-    extractMovingImageFilter->SetInput(m_mainVolume->getItkData());
-    extractMovingImageFilter->Update();
-
-    typedef itk::NormalizeImageFilter< 
-                                FixedImageType, 
-                                InternalImageType 
-                                        > FixedNormalizeFilterType;
-
-    typedef itk::NormalizeImageFilter< 
-                                MovingImageType, 
-                                InternalImageType 
-                                              > MovingNormalizeFilterType;
-
-    FixedNormalizeFilterType::Pointer fixedNormalizer = 
-                                            FixedNormalizeFilterType::New();
-
-    MovingNormalizeFilterType::Pointer movingNormalizer =
-                                            MovingNormalizeFilterType::New();
-    typedef itk::DiscreteGaussianImageFilter<
-                                      InternalImageType, 
-                                      InternalImageType
-                                                    > GaussianFilterType;
-
-    GaussianFilterType::Pointer fixedSmoother  = GaussianFilterType::New();
-    GaussianFilterType::Pointer movingSmoother = GaussianFilterType::New();
-
-    fixedSmoother->SetVariance(2.0);
-    movingSmoother->SetVariance(2.0);
-    fixedNormalizer->SetInput(extractFixedImageFilter->GetOutput());
-    movingNormalizer->SetInput(extractMovingImageFilter->GetOutput());
-
-    fixedSmoother->SetInput(fixedNormalizer->GetOutput());
-    movingSmoother->SetInput(movingNormalizer->GetOutput());
-
-    registration->SetFixedImage(fixedSmoother->GetOutput());
-    registration->SetMovingImage(movingSmoother->GetOutput());
-
-    fixedNormalizer->Update();
-    registration->SetFixedImageRegion(
-       fixedNormalizer->GetOutput()->GetBufferedRegion());
-
-    typedef RegistrationType::ParametersType ParametersType;
-    ParametersType initialParameters(transform->GetNumberOfParameters());
-
-    initialParameters[0] = 0.0;  // Initial offset in mm along X
-    initialParameters[1] = 0.0;  // Initial offset in mm along Y
-
-    registration->SetInitialTransformParameters(initialParameters);
-
-    optimizer->SetLearningRate(20.0);
-    optimizer->SetNumberOfIterations(200);
-    optimizer->MaximizeOn();
-
-    try 
-    { 
-        registration->Update();
-    } 
-    catch(itk::ExceptionObject & err) 
-    { 
-        std::cout << "ExceptionObject caught !" << std::endl; 
-        std::cout << err << std::endl; 
+    if (m_frameRegistration->isRunning())
+    {
+        m_frameRegistration->cancel();
+        return;
+    }
+
+    if (m_mainVolume == 0)
+    {
         return;
-    } 
+    }
+
+    QVector<int> frames(m_mainVolume->getDimensions()[2]);
+    for (int i = 0; i < frames.size(); i++)
+    {
+        frames[i] = i;
+    }
 
-    ParametersType finalParameters = registration->GetLastTransformParameters();
+    m_autoRegistrationToolButton->setText(tr("Cancel Registration"));
+    m_autoRegistrationProgressBar->setRange(0, frames.size());
+    m_autoRegistrationProgressBar->setValue(0);
+    m_autoRegistrationProgressBar->setVisible(true);
+    m_imageSelectorSpinBox->setEnabled(false);
 
-    double TranslationAlongX = finalParameters[0];
-    double TranslationAlongY = finalParameters[1];
+    // The reference image of the spin box starts at 1
+    m_frameRegistration->start(m_imageSelectorSpinBox->value() - 1, frames);
+}
+
+void QAngioSubstractionExtension::updateRegistrationProgress(int registeredFrames, int numberOfFrames)
+{
+    m_autoRegistrationProgressBar->setRange(0, numberOfFrames);
+    m_autoRegistrationProgressBar->setValue(registeredFrames);
+}
 
-    // Print out results
-    //
-    DEBUG_LOG(QString("Result = "));
-    DEBUG_LOG(QString(" Translation X = %1").arg(TranslationAlongX));
-    DEBUG_LOG(QString(" Translation Y = %1").arg(TranslationAlongY));
-    DEBUG_LOG(QString(" Iterations    = %1").arg(optimizer->GetCurrentIteration()));
-    DEBUG_LOG(QString(" Metric value  = %1").arg(optimizer->GetValue()));
-    double spacing[3];
-    m_mainVolume->getSpacing(spacing);
-    DEBUG_LOG(QString(" Translation X (in px) = %1").arg(TranslationAlongX / spacing[0]));
-    DEBUG_LOG(QString(" Translation Y (in px) = %1").arg(TranslationAlongY / spacing[1]));
+void QAngioSubstractionExtension::applyAutomaticRegistration()
+{
+    m_autoRegistrationToolButton->setText(tr("Auto Registration"));
+    m_autoRegistrationProgressBar->setVisible(false);
+    m_imageSelectorSpinBox->setEnabled(true);
+
+    if (m_mainVolume == 0)
+    {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
 
-    //Actualitzem les dades de la transdifference tool
     m_toolManager->triggerTool("TransDifferenceTool");
+    TransDifferenceTool *tdTool = getTransDifferenceTool();
+
+    // The frames that haven't been registered because the registration has been cancelled keep their translation.
+    // The tool subtracts the pixel (x - tx, y - ty) of each frame from the pixel (x, y) of the reference, hence the change of sign.
+    int referenceFrame = m_tdToolData->getReferenceSlice() - 1;
+    for (int frame = 0; frame < m_mainVolume->getDimensions()[2]; frame++)
+    {
+        QPointF translation;
+        if (m_frameRegistration->getTranslation(referenceFrame, frame, translation))
+        {
+            m_tdToolData->setSliceTranslationX(frame, -qRound(translation.x()));
+            m_tdToolData->setSliceTranslationY(frame, -qRound(translation.y()));
+        }
+    }
+    tdTool->updateDifferenceImages();
+
+    m_toolManager->triggerTool("SlicingMouseTool");
+
+    QApplication::restoreOverrideCursor();
+}
+
+TransDifferenceTool* QAngioSubstractionExtension::getTransDifferenceTool()
+{
     TransDifferenceTool* tdTool = static_cast<TransDifferenceTool*> (m_2DView_2->getViewer()->getToolProxy()->getTool("TransDifferenceTool"));
     if(m_tdToolData == 0){
         m_tdToolData = static_cast<TransDifferenceToolData*> (tdTool->getToolData());
@@ -329,154 +237,8 @@ void QAngioSubstractionExtension::computeAutomateSingleImage()
     if(m_tdToolData->getInputVolume() != m_mainVolume){
         m_tdToolData->setInputVolume(m_mainVolume);
     }
-    tdTool->setSingleDifferenceImage(TranslationAlongX / spacing[0],TranslationAlongY / spacing[1]);
-    m_toolManager->triggerTool("SlicingMouseTool");
-    
-
-/*    typedef itk::Image< PixelType, Dimension >  FixedImageType;
-    typedef itk::Image< PixelType, Dimension >  MovingImageType;
-    typedef itk::TranslationTransform< double, Dimension > TransformType;
-    typedef itk::RegularStepGradientDescentOptimizer       OptimizerType;
-    typedef itk::MattesMutualInformationImageToImageMetric< 
-                                          FixedImageType, 
-                                          MovingImageType >    MetricType;
-    typedef itk:: LinearInterpolateImageFunction< 
-                                    MovingImageType,
-                                    double          >    InterpolatorType;
-    typedef itk::ImageRegistrationMethod< 
-                                    FixedImageType, 
-                                    MovingImageType >    RegistrationType;
-
-    MetricType::Pointer         metric        = MetricType::New();
-    TransformType::Pointer      transform     = TransformType::New();
-    OptimizerType::Pointer      optimizer     = OptimizerType::New();
-    InterpolatorType::Pointer   interpolator  = InterpolatorType::New();
-    RegistrationType::Pointer   registration  = RegistrationType::New();
-
-    registration->SetMetric(metric);
-    registration->SetOptimizer(optimizer);
-    registration->SetTransform(transform);
-    registration->SetInterpolator(interpolator);
-
-    metric->SetNumberOfHistogramBins(50);
-    metric->SetNumberOfSpatialSamples(10000);
-
-    typedef itk::ExtractImageFilter< Volume::ItkImageType, FixedImageType > FilterType;
-    
-    FilterType::Pointer extractFixedImageFilter = FilterType::New();
-    Volume::ItkImageType::RegionType inputRegion = m_mainVolume->getItkData()->GetLargestPossibleRegion();
-    Volume::ItkImageType::SizeType size = inputRegion.GetSize();
-    //Dividim la mida per dos per tal de quedar-nos només amb la part central
-    // ja que si no ens registre el background
-    size[0] = size[0] / 2;
-    size[1] = size[1] / 2;
-    size[2] = 0;
-    Volume::ItkImageType::IndexType start = inputRegion.GetIndex();
-    const unsigned int sliceReference = m_imageSelectorSpinBox->value();
-    //comencem a un quart de la imatge
-    start[0] = size[0] / 2;
-    start[1] = size[1] / 2;
-    start[2] = sliceReference;
-    Volume::ItkImageType::RegionType desiredRegion;
-    desiredRegion.SetSize(size);
-    desiredRegion.SetIndex(start);
-    extractFixedImageFilter->SetExtractionRegion(desiredRegion);
-    extractFixedImageFilter->SetInput(m_mainVolume->getItkData());
-    extractFixedImageFilter->Update();
-
-    FilterType::Pointer extractMovingImageFilter = FilterType::New();
-    Volume::ItkImageType::IndexType startMoving = inputRegion.GetIndex();
-    const unsigned int sliceNumber = m_2DView_1->getViewer()->getCurrentSlice();
-    startMoving[0] = size[0] / 2;
-    startMoving[1] = size[1] / 2;
-    startMoving[2] = sliceNumber;
-    Volume::ItkImageType::RegionType desiredMovingRegion;
-    desiredMovingRegion.SetSize(size);
-    desiredMovingRegion.SetIndex(startMoving);
-    extractMovingImageFilter->SetExtractionRegion(desiredMovingRegion);
-    extractMovingImageFilter->SetInput(m_mainVolume->getItkData());
-    extractMovingImageFilter->Update();
-
-    registration->SetFixedImage(extractFixedImageFilter->GetOutput());
-    registration->SetMovingImage(extractMovingImageFilter->GetOutput());
-
-    typedef RegistrationType::ParametersType ParametersType;
-    ParametersType initialParameters(transform->GetNumberOfParameters());
-
-    //Potser seria millor posar la transformada que té actualment
-    initialParameters[0] = 0.0;  // Initial offset in mm along X
-    initialParameters[1] = 0.0;  // Initial offset in mm along Y
-
-    registration->SetInitialTransformParameters(initialParameters);
-
-    optimizer->SetMaximumStepLength(4.00);  
-    optimizer->SetMinimumStepLength(0.005);
-
-    optimizer->SetNumberOfIterations(200);
-
-    try 
-    { 
-        registration->StartRegistration(); 
-    } 
-    catch(itk::ExceptionObject & err) 
-    { 
-        DEBUG_LOG(QString("ExceptionObject caught !"));
-        std::cout<<err<<std::endl;
-        return;
-    } 
-    ParametersType finalParameters = registration->GetLastTransformParameters();
-
-    const double TranslationAlongX = finalParameters[0];
-    const double TranslationAlongY = finalParameters[1];
-
-    const unsigned int numberOfIterations = optimizer->GetCurrentIteration();
-
-    const double bestValue = optimizer->GetValue();
-
-    DEBUG_LOG(QString("Result = "));
-    DEBUG_LOG(QString(" Translation X = %1").arg(TranslationAlongX));
-    DEBUG_LOG(QString(" Translation Y = %1").arg(TranslationAlongY));
-    DEBUG_LOG(QString(" Iterations    = %1").arg(numberOfIterations));
-    DEBUG_LOG(QString(" Metric value  = %1").arg(bestValue));
-
-    typedef  unsigned char  OutputPixelType;
-    typedef itk::Image< OutputPixelType, Dimension > OutputImageType;
-    typedef itk::RescaleIntensityImageFilter< FixedImageType, FixedImageType > RescaleFilterType;
-    typedef itk::ResampleImageFilter< 
-                            FixedImageType, 
-                            FixedImageType >    ResampleFilterType;
-    typedef itk::CastImageFilter< 
-                        FixedImageType,
-                        OutputImageType > CastFilterType;
-    typedef itk::ImageFileWriter< OutputImageType >  WriterType;
-
-    WriterType::Pointer      writer =  WriterType::New();
-    CastFilterType::Pointer  caster =  CastFilterType::New();
-    ResampleFilterType::Pointer resample = ResampleFilterType::New();
-    RescaleFilterType::Pointer rescaler = RescaleFilterType::New();
-
-    rescaler->SetOutputMinimum(0);
-    rescaler->SetOutputMaximum(255);
-
-    TransformType::Pointer finalTransform = TransformType::New();
-    finalTransform->SetParameters(finalParameters);
-    resample->SetTransform(finalTransform);
-    resample->SetSize(extractMovingImageFilter->GetOutput()->GetLargestPossibleRegion().GetSize());
-    resample->SetOutputOrigin(extractMovingImageFilter->GetOutput()->GetOrigin());
-    resample->SetOutputSpacing(extractMovingImageFilter->GetOutput()->GetSpacing());
-    resample->SetDefaultPixelValue(100);
-
-    writer->SetFileName("prova.jpg");
-
-    rescaler->SetInput(extractMovingImageFilter->GetOutput());
-    resample->SetInput(rescaler->GetOutput());
-    caster->SetInput(resample->GetOutput());
-    writer->SetInput(caster->GetOutput());
-    writer->Update();
-*/
-
-    QApplication::restoreOverrideCursor();
 
+    return tdTool;
 }
 
 void QAngioSubstractionExtension::readSettings()
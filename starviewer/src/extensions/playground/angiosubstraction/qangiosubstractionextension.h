@@ -21,7 +21,9 @@ namespace udg {
 // FWD declarations
 class Volume;
 class ToolManager;
+class TransDifferenceTool;
 class TransDifferenceToolData;
+class AngioFrameRegistration;
 
 /**
     @author Grup de Gràfics de Girona  (GGG) <vismed@ima.udg.es>
@@ -51,8 +53,18 @@ private slots:
     /// Calcula la imatge diferència respecte la imatge imageid
     void computeDifferenceImage(int imageid);
 
-    /// Calcula automàticament (registre) la imatge diferència respecte la imatge imageid
-    void computeAutomateSingleImage();
+    /// Starts registering all the frames to the reference image, or cancels the registration if it's running
+    void toggleAutomaticRegistration();
+
+    /// Shows the progress of the automatic registration
+    void updateRegistrationProgress(int registeredFrames, int numberOfFrames);
+
+    /// Applies the translations found by the automatic registration to the difference images
+    void applyAutomaticRegistration();
+
+private:
+    /// Returns the TransDifferenceTool of the difference viewer, making sure that its data refer to the main volume
+    TransDifferenceTool* getTransDifferenceTool();
 
 private:
     /// El volum principal
@@ -63,6 +75,9 @@ private:
     ToolManager *m_toolManager;
     TransDifferenceToolData *m_tdToolData;
 
+    /// Automatic registration of the frames to the reference image
+    AngioFrameRegistration *m_frameRegistration;
+
     /// Dades de les transformacions aplicades a cada llesca
     QVector< QPair<int,int> > m_sliceTranslations;
 
@@ -9,15 +9,13 @@ HEADERS += qdifuperfuextension.h \
            itkRegistre3DAffine.h \
            udgPerfusionEstimator.h \
            udgBinaryMaker.h \
-           diffusionperfusionsegmentationextensionmediator.h \
-           volumecalculator.h
+           diffusionperfusionsegmentationextensionmediator.h
 SOURCES += qdifuperfuextension.cpp \
            diffusionperfusionsegmentationsettings.cpp \
            itkRegistre3DAffine.cpp \
            udgPerfusionEstimator.cpp \
            udgBinaryMaker.cpp \
-           diffusionperfusionsegmentationextensionmediator.cpp \
-           volumecalculator.cpp
+           diffusionperfusionsegmentationextensionmediator.cpp
 
 RESOURCES += diffusionperfusionsegmentation.qrc
 
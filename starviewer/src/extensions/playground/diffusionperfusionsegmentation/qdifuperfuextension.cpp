@@ -6,13 +6,10 @@
  ***************************************************************************/
 #include "qdifuperfuextension.h"
 #include "strokesegmentationmethod.h"
-#include "volumecalculator.h"
+#include "maskstatistics.h"
 #include "series.h"
 #include "logging.h"
 #include "toolmanager.h"
-#include "toolproxy.h"
-#include "editortool.h"
-#include "editortooldata.h"
 #include "diffusionperfusionsegmentationsettings.h"
 #include "patientbrowsermenu.h"
 #include "transferfunction.h"
@@ -53,6 +50,9 @@ QDifuPerfuSegmentationExtension::QDifuPerfuSegmentationExtension(QWidget * paren
 
     m_perfusionHueLut = vtkLookupTable::New();
 
+    m_strokeMaskStatistics = new MaskStatistics(this);
+    m_penombraMaskStatistics = new MaskStatistics(this);
+
     createActions();
     createConnections();
     readSettings();
@@ -236,6 +236,9 @@ void QDifuPerfuSegmentationExtension::createConnections()
     connect(m_diffusion2DView, SIGNAL(overlayModified()), SLOT(updateStrokeVolume()));
     connect(m_perfusion2DView, SIGNAL(overlayModified()), SLOT(updatePenombraVolume()));
 
+    connect(m_strokeMaskStatistics, SIGNAL(maskVolumeComputed(qint64, double)), SLOT(showStrokeVolume(qint64, double)));
+    connect(m_penombraMaskStatistics, SIGNAL(maskVolumeComputed(qint64, double)), SLOT(showPenombraVolume(qint64, double)));
+
 }
 
 void QDifuPerfuSegmentationExtension::readSettings()
@@ -291,6 +294,7 @@ void QDifuPerfuSegmentationExtension::setMaxDiffusionImage(int max)
 void QDifuPerfuSegmentationExtension::setDiffusionImage(int index)
 {
     m_diffusionMainVolume = m_diffusionInputVolume->getPhaseVolume(index);
+    m_strokeMaskStatistics->setVolume(m_diffusionMainVolume);
 
     double range[2];
     m_diffusionMainVolume->getScalarRange(range);
@@ -448,6 +452,11 @@ void QDifuPerfuSegmentationExtension::viewThresholds()
     m_strokeMaskVolume->setImages(m_diffusionInputVolume->getImages());
     m_strokeMaskVolume->setData(imageThreshold->GetOutput());
 
+    // El volum de la màscara s'obté de l'histograma de la difusió sense recórrer-la;
+    // només es compten les llesques que s'editin després
+    m_strokeMaskStatistics->setThresholdMask(m_strokeMaskVolume, m_diffusionMaxValue, m_strokeLowerValueSlider->value(),
+                                             m_strokeUpperValueSlider->value());
+
     m_diffusion2DView->setOverlapMethod(Q2DViewer::Blend);
     m_diffusion2DView->setOverlayOpacity(m_diffusionOpacitySlider->value() / 100.0);
     m_diffusion2DView->setOverlayInput(m_strokeMaskVolume);
@@ -473,6 +482,8 @@ void QDifuPerfuSegmentationExtension::viewThresholds2()
     m_penombraMaskVolume->setImages(m_diffusionMainVolume->getImages());
     m_penombraMaskVolume->setData(imageThreshold->GetOutput());
 
+    m_penombraMaskStatistics->setThresholdMask(m_penombraMaskVolume, m_penombraMaskMaxValue, m_penombraLowerValueSlider->value(), 1000000);
+
     vtkImageCast * imageCast = vtkImageCast::New();
     imageCast->SetInputData(m_penombraMaskVolume->getVtkData());
     imageCast->SetOutputScalarTypeToUnsignedChar();
@@ -515,6 +526,8 @@ void QDifuPerfuSegmentationExtension::applyStrokeSegmentation()
 
     m_strokeVolume = m_strokeSegmentationMethod->applyMethod();
     m_strokeCont = (int)(m_strokeVolume / (m_diffusionMainVolume->getSpacing()[0]*m_diffusionMainVolume->getSpacing()[1]*m_diffusionMainVolume->getSpacing()[2]));
+    // Les edicions posteriors de la màscara només recompten les llesques modificades
+    m_strokeMaskStatistics->setMask(m_strokeMaskVolume, m_diffusionMaxValue);
 
     m_diffusion2DView->setOverlapMethod(Q2DViewer::Blend);
     m_diffusion2DView->setOverlayOpacity(m_diffusionOpacitySlider->value() / 100.0);
@@ -767,6 +780,7 @@ void QDifuPerfuSegmentationExtension::computeBlackpointEstimation()
     m_blackpointEstimatedVolume->setImages(m_diffusionInputVolume->getPhaseImages(m_selectedDiffusionImageSpinBox->value()));
 
     m_blackpointEstimatedVolume->setData(perfuEstimatorImageResult);
+    m_penombraMaskStatistics->setVolume(m_blackpointEstimatedVolume);
 
     connect(m_penombraLowerValueSlider, SIGNAL(valueChanged(int)), SLOT(viewThresholds2()));
 
@@ -839,18 +853,12 @@ void QDifuPerfuSegmentationExtension::applyPenombraSegmentation()
     m_synchroCheckBox->setChecked(true);
     m_lesionViewToolButton->click();
 
-    VolumeCalculator volumeCalculator;
-    volumeCalculator.setInput(m_penombraMaskVolume);
-    volumeCalculator.setInsideValue(m_penombraMaskMaxValue);
     m_penombraVolumeLabel->setEnabled(true);
     m_penombraLineEdit->setEnabled(true);
     m_penombraLabel->setEnabled(true);
     m_penombraVolumeLineEdit->setEnabled(true);
-    m_penombraVolume = volumeCalculator.getVolume();
-    m_penombraVolumeLineEdit->setText(QString::number(m_penombraVolume, 'f', 2));
-    m_penombraCont = volumeCalculator.getVoxels();
-    //std::cout<<"penombra cont= "<<m_penombraCont<<" // voxel size= "<<m_penombraMaskVolume->getItkData()->GetSpacing()<<std::endl;
-    //std::cout<<"penombra vol= "<<m_penombraVolume<<std::endl;
+    // El volum es mostra quan s'ha acabat de comptar la màscara en segon pla
+    m_penombraMaskStatistics->setMask(m_penombraMaskVolume, m_penombraMaskMaxValue);
 
     QApplication::restoreOverrideCursor();
 }
@@ -868,6 +876,7 @@ void QDifuPerfuSegmentationExtension::applyFilterDiffusionImage()
 
     delete m_diffusionMainVolume;
     m_diffusionMainVolume = filteredVolume;
+    m_strokeMaskStatistics->setVolume(m_diffusionMainVolume);
 
     m_diffusion2DView->setInput(m_diffusionMainVolume);
     m_diffusion2DView->render();
@@ -1150,75 +1159,13 @@ void QDifuPerfuSegmentationExtension::saveTransform()
     }
 }
 
-double QDifuPerfuSegmentationExtension::calculateDiffusionMaskVolume()
-{
-    if (!m_strokeMaskVolume) 
-        return 0.0;
-
-    double spacing[3];
-    m_strokeMaskVolume->getSpacing(spacing);
-    double volume = 1.0;
-
-    for(unsigned int i=0;i<Volume::VDimension;i++)
-    {
-        volume *= spacing[i];
-    }
-
-    int cont;
-    EditorToolData* edToolData = static_cast<EditorToolData*> (m_diffusion2DView->getToolProxy()->getTool("EditorTool")->getToolData());
-    if(edToolData!=0)
-    {
-        cont = edToolData->getVolumeVoxels();
-    }
-    else
-    {
-        DEBUG_LOG("No existeix la editor tool");
-        cont = 0;
-    }
-
-    m_strokeVolume = volume*(double)cont;
-
-    return m_strokeVolume;
-}
-
-double QDifuPerfuSegmentationExtension::calculatePerfusionMaskVolume()
-{
-    if (!m_penombraMaskVolume) 
-        return 0.0;
-
-    double spacing[3];
-    m_penombraMaskVolume->getSpacing(spacing);
-    double volume = 1.0;
-
-    for(unsigned int i=0;i<Volume::VDimension;i++)
-    {
-        volume *= spacing[i];
-    }
-
-    int cont;
-    EditorToolData* edToolData = static_cast<EditorToolData*> (m_perfusion2DView->getToolProxy()->getTool("EditorTool")->getToolData());
-    if(edToolData!=0)
-    {
-        cont = edToolData->getVolumeVoxels();
-    }
-    else
-    {
-        DEBUG_LOG("No existeix la editor tool");
-        cont = 0;
-    }
-
-    m_penombraVolume = volume*(double)cont;
-
-    return m_penombraVolume;
-}
-
 void QDifuPerfuSegmentationExtension::updateStrokeVolume()
 {
     if(m_strokeVolumeLineEdit->isEnabled() && m_activedMaskVolume == m_strokeMaskVolume)
     {
-        m_strokeVolume = this->calculateDiffusionMaskVolume();
-        m_strokeVolumeLineEdit->clear();
-        m_strokeVolumeLineEdit->insert(QString("%1").arg(m_strokeVolume, 0, 'f', 2));
+        // L'editor només modifica la llesca actual, que és l'única que cal recomptar
+        int slice = m_diffusion2DView->getCurrentSlice();
+        m_strokeMaskStatistics->updateMask(slice, slice);
     }
 }
 
@@ -1227,11 +1174,8 @@ void QDifuPerfuSegmentationExtension::updatePenombraVolume()
     if(m_penombraVolumeLineEdit->isEnabled())
     {
         //this->viewThresholds2();
-        m_penombraVolume = this->calculatePerfusionMaskVolume();
-        m_penombraVolumeLineEdit->clear();
-        m_penombraVolumeLineEdit->insert(QString("%1").arg(m_penombraVolume, 0, 'f', 2));
-        m_penombraLineEdit->clear();
-        m_penombraLineEdit->insert(QString("%1").arg(m_penombraVolume - m_strokeVolume, 0, 'f', 2));
+        int slice = m_perfusion2DView->getCurrentSlice();
+        m_penombraMaskStatistics->updateMask(slice, slice);
 
         vtkImageCast * imageCast = vtkImageCast::New();
         imageCast->SetInputData(m_penombraMaskVolume->getVtkData());
@@ -1247,6 +1191,21 @@ void QDifuPerfuSegmentationExtension::updatePenombraVolume()
     }
 }
 
+void QDifuPerfuSegmentationExtension::showStrokeVolume(qint64 voxels, double volume)
+{
+    m_strokeCont = static_cast<int>(voxels);
+    m_strokeVolume = volume;
+    m_strokeVolumeLineEdit->setText(QString::number(m_strokeVolume, 'f', 2));
+}
+
+void QDifuPerfuSegmentationExtension::showPenombraVolume(qint64 voxels, double volume)
+{
+    m_penombraCont = static_cast<int>(voxels);
+    m_penombraVolume = volume;
+    // En canviar el text es recalcula la diferència amb el volum de l'stroke
+    m_penombraVolumeLineEdit->setText(QString::number(m_penombraVolume, 'f', 2));
+}
+
 }
 
 
@@ -21,6 +21,7 @@ class vtkLookupTable;
 namespace udg {
 
 // Forward declarations
+class MaskStatistics;
 class StrokeSegmentationMethod;
 class ToolManager;
 
@@ -126,6 +127,11 @@ private slots:
     void updateStrokeVolume();
     void updatePenombraVolume();
 
+private slots:
+    /// Mostren el volum de les màscares de l'stroke i la penombra, obtingudes amb els llindars donats o editades
+    void showStrokeVolume(qint64 voxels, double volume);
+    void showPenombraVolume(qint64 voxels, double volume);
+
 private:
     /// inicialitza les tools
     void initializeTools();
@@ -146,10 +152,6 @@ private:
     /// Calcula el volum de la màscara d'stroke
     double calculateStrokeVolume();
 
-    ///Calcula els volums de les màscares de la perfusió i la difusió
-    double calculateDiffusionMaskVolume();
-    double calculatePerfusionMaskVolume();
-
 private:
     typedef Volume::ItkImageType ItkImageType;
     typedef itkRegistre3DAffine< ItkImageType, ItkImageType >::TransformType TransformType;
@@ -208,6 +210,10 @@ private:
     int m_penombraCont;
     double m_penombraVolume;
 
+    /// Calculen en segon pla els volums de les màscares de l'stroke i la penombra
+    MaskStatistics *m_strokeMaskStatistics;
+    MaskStatistics *m_penombraMaskStatistics;
+
     double m_seedPosition[3];
 
     /// Accions
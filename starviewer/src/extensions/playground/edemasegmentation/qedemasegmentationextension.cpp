@@ -11,10 +11,8 @@
 #include "logging.h"
 #include "q2dviewer.h"
 #include "toolmanager.h"
-#include "toolproxy.h"
-#include "editortool.h"
-#include "editortooldata.h"
 #include "edemasegmentationsettings.h"
+#include "maskstatistics.h"
 #include "patientbrowsermenu.h"
 //Qt
 #include <QString>
@@ -40,6 +38,7 @@ QEdemaSegmentationExtension::QEdemaSegmentationExtension(QWidget *parent)
     m_seedPosition[2] = 0.0;
 
     m_segMethod = new StrokeSegmentationMethod();
+    m_maskStatistics = new MaskStatistics(this);
    
     createActions();
     initializeTools();
@@ -174,6 +173,7 @@ void QEdemaSegmentationExtension::createConnections()
     
     // cada cop que es modifiqui l'overlay mostrarem un volum diferent (per la edició)
     connect(m_2DView, SIGNAL(overlayModified()), SLOT(updateVolume()));
+    connect(m_maskStatistics, SIGNAL(maskVolumeComputed(qint64, double)), SLOT(showLesionVolume(qint64, double)));
 }
 
 void QEdemaSegmentationExtension::setInput(Volume *input)
@@ -211,6 +211,9 @@ void QEdemaSegmentationExtension::setInput(Volume *input)
 
     // \TODO ara ho fem "a saco" per?s'hauria de millorar
     m_2DView->setInput(m_mainVolume);
+    // Els llindars s'apliquen sobre el volum principal i la màscara de la lesió ja no existeix
+    m_maskStatistics->setVolume(m_mainVolume);
+    m_maskStatistics->setMask(m_lesionMaskVolume, 0.0);
     //això ho fem per indicar que no hi ha cap overlay
     m_2DView->setOverlapMethod(Q2DViewer::None);
     //m_2DView->setOverlayInput(m_lesionMaskVolume);
@@ -283,6 +286,7 @@ void QEdemaSegmentationExtension::applyCleanSkullMethod()
     m_volume = m_segMethod->applyCleanSkullMethod();
     //std::cout<<"Hem sortit de l'abisme!!!"<<std::endl;
     m_cont = m_segMethod->getNumberOfVoxels();
+    m_maskStatistics->setMask(m_lesionMaskVolume, m_insideValue);
 
     m_resultsLineEdit->clear();
     m_resultsLineEdit->insert(QString("%1").arg(m_volume, 0, 'f', 2));
@@ -321,6 +325,8 @@ void QEdemaSegmentationExtension::applyMethod()
     m_volume = m_segMethod->applyMethod();
     //m_volume = m_segMethod->applyMethodVTK();//No funciona!!
     m_cont = m_segMethod->getNumberOfVoxels();
+    // Les edicions posteriors de la màscara només recompten les llesques modificades
+    m_maskStatistics->setMask(m_lesionMaskVolume, m_insideValue);
 
     DEBUG_LOG("FI apply filter!!");
 
@@ -476,7 +482,18 @@ void QEdemaSegmentationExtension::setUpperValue(int x)
 
 void QEdemaSegmentationExtension::updateVolume()
 {
-    m_volume = this->calculateMaskVolume();
+    // L'editor només modifica la llesca actual, que és l'única que cal recomptar
+    if (m_lesionMaskVolume && m_activedMaskVolume == m_lesionMaskVolume)
+    {
+        int slice = m_2DView->getCurrentSlice();
+        m_maskStatistics->updateMask(slice, slice);
+    }
+}
+
+void QEdemaSegmentationExtension::showLesionVolume(qint64 voxels, double volume)
+{
+    m_cont = static_cast<int>(voxels);
+    m_volume = volume;
     m_resultsLineEdit->clear();
     m_resultsLineEdit->insert(QString("%1").arg(m_volume, 0, 'f', 2));
 }
@@ -504,6 +521,10 @@ void QEdemaSegmentationExtension::viewThresholds()
     m_lesionMaskVolume->setData(imageThreshold->GetOutput());
     DEBUG_LOG(QString("min: %1, mout %2").arg(m_insideValue).arg(m_outsideValue));
 
+    // El volum de la màscara s'obté de l'histograma del volum principal sense recórrer-la;
+    // només es compten les llesques que s'editin després
+    m_maskStatistics->setThresholdMask(m_lesionMaskVolume, m_insideValue, m_lowerValueSlider->value(), m_upperValueSlider->value());
+
     this->viewLesionOverlay();
     DEBUG_LOG(QString("min: %1, mout %2").arg(m_insideValue).arg(m_outsideValue));
     imageThreshold->Delete();
@@ -555,39 +576,6 @@ void QEdemaSegmentationExtension::viewVentriclesOverlay()
     }
 }
 
-double QEdemaSegmentationExtension::calculateMaskVolume()
-{
-    if(!m_lesionMaskVolume)
-        return 0.0;
-
-    double spacing[3];
-    m_lesionMaskVolume->getSpacing(spacing);
-    double volume = 1.0;
-
-    for(unsigned int i=0;i<Volume::VDimension;i++)
-    {
-        volume *= spacing[i];
-    }
-
-    int cont = 0;
-    EditorTool *editorTool = static_cast<EditorTool*>(m_2DView->getToolProxy()->getTool("EditorTool"));
-    if (editorTool) 
-    {
-        EditorToolData *editorToolData = static_cast<EditorToolData*>(editorTool->getToolData());
-        if(editorToolData!=0)
-        {
-            cont = editorToolData->getVolumeVoxels();
-        }
-        else
-        {
-            DEBUG_LOG("No existeix la editor tool");
-        }
-    }
-    volume = volume*(double)cont;
-
-    return volume;
-}
-
 void QEdemaSegmentationExtension::saveActivedMaskVolume()
 {
     QString fileName = QFileDialog::getSaveFileName(this, tr("Save Volume file"), m_savingMaskDirectory, tr("MetaImage Files (*.mhd)"));
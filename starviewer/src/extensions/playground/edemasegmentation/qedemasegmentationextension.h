@@ -19,6 +19,7 @@ namespace udg {
 
 // FWD declarations
 class Volume;
+class MaskStatistics;
 class StrokeSegmentationMethod;
 class ToolManager;
 
@@ -71,12 +72,12 @@ private slots:
     /// Canvia la opacitat de la màscara
     void setOpacity(int op);
 
-    /// Calcula el volum de la màscara
-    double calculateMaskVolume();
-
-    /// Refresca el resultat del volum
+    /// Recompta la llesca de la màscara de la lesió que s'ha editat
     void updateVolume();
 
+    /// Mostra el volum de la màscara de la lesió
+    void showLesionVolume(qint64 voxels, double volume);
+
     /// Visualitza la màscara donats uns thresholds
     void viewThresholds();
 
@@ -105,6 +106,9 @@ private:
     /// Mètode de la segmentació
     StrokeSegmentationMethod *m_segMethod;
 
+    /// Calcula en segon pla el volum de la màscara de la lesió
+    MaskStatistics *m_maskStatistics;
+
     /// Membres de classe
     bool m_isSeed;
     bool m_isMask;
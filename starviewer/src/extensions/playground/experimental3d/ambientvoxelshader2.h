@@ -41,6 +41,8 @@ public:
     /// Retorna el color corresponent al vòxel a la posició position, fent servir valors interpolats.
     HdrColor nvShade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator, float remainingOpacity,
                      const HdrColor &baseColor = HdrColor());
+    /// Calcula el color de count vòxels seguits cridant nvShade per cada un, sense una crida virtual per vòxel.
+    virtual void shadeSamples(int count, const Vector3 *positions, const int *offsets, const Vector3 &direction, float remainingOpacity, HdrColor *colors);
     /// Retorna un string representatiu del voxel shader.
     virtual QString toString() const;
 
@@ -72,6 +74,12 @@ inline HdrColor AmbientVoxelShader2::shade(const Vector3 &position, const Vector
     return nvShade(position, direction, interpolator, remainingOpacity, baseColor);
 }
 
+inline void AmbientVoxelShader2::shadeSamples(int count, const Vector3 *positions, const int *offsets, const Vector3 &direction, float remainingOpacity,
+                                              HdrColor *colors)
+{
+    nvShadeSamples(this, count, positions, offsets, direction, remainingOpacity, colors);
+}
+
 inline HdrColor AmbientVoxelShader2::nvShade(const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity, const HdrColor &baseColor)
 {
     Q_UNUSED(position);
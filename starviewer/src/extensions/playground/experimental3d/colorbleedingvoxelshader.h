@@ -34,6 +34,8 @@ public:
     /// Retorna el color corresponent al vòxel a la posició position, fent servir valors interpolats.
     HdrColor nvShade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator, float remainingOpacity,
                      const HdrColor &baseColor = HdrColor());
+    /// Calcula el color de count vòxels seguits cridant nvShade per cada un, sense una crida virtual per vòxel.
+    virtual void shadeSamples(int count, const Vector3 *positions, const int *offsets, const Vector3 &direction, float remainingOpacity, HdrColor *colors);
     /// Retorna un string representatiu del voxel shader.
     virtual QString toString() const;
 
@@ -56,6 +58,12 @@ inline HdrColor ColorBleedingVoxelShader::shade(const Vector3 &position, const V
     return nvShade(position, direction, interpolator, remainingOpacity, baseColor);
 }
 
+inline void ColorBleedingVoxelShader::shadeSamples(int count, const Vector3 *positions, const int *offsets, const Vector3 &direction, float remainingOpacity,
+                                                   HdrColor *colors)
+{
+    nvShadeSamples(this, count, positions, offsets, direction, remainingOpacity, colors);
+}
+
 inline HdrColor ColorBleedingVoxelShader::nvShade(const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity,
                                                   const HdrColor &baseColor)
 {
@@ -1,12 +1,10 @@
 #include "coolwarmvoxelshader.h"
 
-#include <vtkEncodedGradientEstimator.h>
-
 namespace udg {
 
 CoolWarmVoxelShader::CoolWarmVoxelShader()
     : VoxelShader(), m_data(0), m_maxValue(0), m_ambientColors(0), m_b(1.0f), m_y(1.0f), m_alpha(1.0f), m_beta(1.0f),
-      m_encodedNormals(0), m_directionEncoder(0), m_combine(false)
+      m_gradientVolume(0), m_combine(false)
 {
 }
 
@@ -37,10 +35,9 @@ void CoolWarmVoxelShader::setBYAlphaBeta(float b, float y, float alpha, float be
     m_beta = beta;
 }
 
-void CoolWarmVoxelShader::setGradientEstimator(vtkEncodedGradientEstimator *gradientEstimator)
+void CoolWarmVoxelShader::setGradientVolume(const GradientVolume *gradientVolume)
 {
-    m_encodedNormals = gradientEstimator->GetEncodedNormals();
-    m_directionEncoder = gradientEstimator->GetDirectionEncoder();
+    m_gradientVolume = gradientVolume;
 }
 
 void CoolWarmVoxelShader::setCombine(bool on)
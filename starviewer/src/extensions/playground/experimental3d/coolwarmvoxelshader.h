@@ -3,13 +3,10 @@
 
 #include "voxelshader.h"
 
+#include "gradientvolume.h"
 #include "transferfunction.h"
 #include "trilinearinterpolator.h"
 
-#include <vtkDirectionEncoder.h>
-
-class vtkEncodedGradientEstimator;
-
 namespace udg {
 
 /**
@@ -27,8 +24,8 @@ public:
     /// Assigna la funció de transferència.
     void setTransferFunction(const TransferFunction &transferFunction);
     void setBYAlphaBeta(float b, float y, float alpha, float beta);
-    /// Assigna l'estimador del gradient.
-    void setGradientEstimator(vtkEncodedGradientEstimator *gradientEstimator);
+    /// Assigna el gradient del volum.
+    void setGradientVolume(const GradientVolume *gradientVolume);
     void setCombine(bool on);
 
     /// Retorna el color corresponent al vòxel a la posició offset.
@@ -56,8 +53,7 @@ protected:
     TransferFunction m_transferFunction;
     HdrColor *m_ambientColors;
     float m_b, m_y, m_alpha, m_beta;
-    unsigned short *m_encodedNormals;
-    vtkDirectionEncoder *m_directionEncoder;
+    const GradientVolume *m_gradientVolume;
     bool m_combine;
 
 };
@@ -81,14 +77,12 @@ inline HdrColor CoolWarmVoxelShader::nvShade(const Vector3 &position, int offset
     Q_UNUSED(baseColor);
 
     Q_ASSERT(m_data);
-    Q_ASSERT(m_encodedNormals);
-    Q_ASSERT(m_directionEncoder);
+    Q_ASSERT(m_gradientVolume);
 
     HdrColor color = m_ambientColors[m_data[offset]];
     if (!color.isTransparent())
     {
-        float *gradient = m_directionEncoder->GetDecodedGradient(m_encodedNormals[offset]);
-        Vector3 normal(gradient[0], gradient[1], gradient[2]);
+        Vector3 normal = m_gradientVolume->getNormal(offset);
         const double SQRT3_INV = 1.0 / sqrt(3.0);
         Vector3 light(SQRT3_INV, SQRT3_INV, SQRT3_INV);
         double dotProduct = light * normal;
@@ -109,6 +103,7 @@ inline HdrColor CoolWarmVoxelShader::nvShade(const Vector3 &position, const Vect
 
     Q_ASSERT(interpolator);
     Q_ASSERT(m_data);
+    Q_ASSERT(m_gradientVolume);
 
     int offsets[8];
     double weights[8];
@@ -121,9 +116,7 @@ inline HdrColor CoolWarmVoxelShader::nvShade(const Vector3 &position, const Vect
         Vector3 normal;
         for (int i = 0; i < 8; i++)
         {
-            float *gradient = m_directionEncoder->GetDecodedGradient(m_encodedNormals[offsets[i]]);
-            Vector3 localNormal(gradient[0], gradient[1], gradient[2]);
-            normal += weights[i] * localNormal;
+            normal += weights[i] * m_gradientVolume->getNormal(offsets[i]);
         }
         const double SQRT3_INV = 1.0 / sqrt(3.0);
         Vector3 light(SQRT3_INV, SQRT3_INV, SQRT3_INV);
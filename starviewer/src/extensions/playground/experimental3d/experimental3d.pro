@@ -26,6 +26,8 @@ HEADERS += experimental3dextensionmediator.h \
     vomicoolwarmvoxelshader.h \
     coolwarmvoxelshader.h \
     viewpointinformationchannel.h \
+    viewpointvisibilityraycaster.h \
+    voxelprobabilitiesinviewstore.h \
     filteringambientocclusionvoxelshader.h \
     filteringambientocclusionmapvoxelshader.h \
     vomigammavoxelshader.h \
@@ -41,6 +43,7 @@ HEADERS += experimental3dextensionmediator.h \
     quaternion.h \
     obscurance.h \
     obscurancemainthread.h \
+    obscurancetaskqueue.h \
     obscurancethread.h \
     obscurancevoxelshader.h \
     vtkVolumeRayCastVoxelShaderCompositeFunction.h \
@@ -69,6 +72,8 @@ SOURCES += experimental3dextensionmediator.cpp \
     vomicoolwarmvoxelshader.cpp \
     coolwarmvoxelshader.cpp \
     viewpointinformationchannel.cpp \
+    viewpointvisibilityraycaster.cpp \
+    voxelprobabilitiesinviewstore.cpp \
     filteringambientocclusionvoxelshader.cpp \
     filteringambientocclusionmapvoxelshader.cpp \
     vomigammavoxelshader.cpp \
@@ -84,6 +89,7 @@ SOURCES += experimental3dextensionmediator.cpp \
     quaternion.cpp \
     obscurance.cpp \
     obscurancemainthread.cpp \
+    obscurancetaskqueue.cpp \
     obscurancethread.cpp \
     obscurancevoxelshader.cpp \
     vtkVolumeRayCastVoxelShaderCompositeFunction.cxx \
@@ -10,6 +10,7 @@
 #include "filteringambientocclusionmapvoxelshader.h"
 #include "filteringambientocclusionstipplingvoxelshader.h"
 #include "filteringambientocclusionvoxelshader.h"
+#include "gradientvolume.h"
 #include "imivoxelshader.h"
 #include "obscurance.h"
 #include "obscurancevoxelshader.h"
@@ -27,7 +28,6 @@
 
 #include <vtkEncodedGradientShader.h>
 #include <vtkFiniteDifferenceGradientEstimator.h>
-#include <vtkFloatArray.h>
 #include <vtkImageData.h>
 #include <vtkImageShiftScale.h>
 #include <vtkOpenGLGPUVolumeRayCastMapper.h>
@@ -39,8 +39,20 @@
 
 namespace udg {
 
+namespace {
+
+/// Retorna el mètode i el radi del GradientVolume equivalents a l'estimador de gradient donat.
+void getGradientMethod(Experimental3DVolume::GradientEstimator gradientEstimator, GradientVolume::Method &method, int &radius)
+{
+    method = gradientEstimator == Experimental3DVolume::FiniteDifference ? GradientVolume::CentralDifferences : GradientVolume::LinearRegression4D;
+    radius = gradientEstimator == Experimental3DVolume::FourDLInearRegression2 ? 2 : 1;
+}
+
+}
+
 Experimental3DVolume::Experimental3DVolume(Volume *volume)
-    : m_alternativeImage(0), m_finiteDifferenceGradientEstimator(0), m_4DLinearRegressionGradientEstimator(0)
+    : m_alternativeImage(0), m_gradientEstimator(FiniteDifference), m_finiteDifferenceGradientEstimator(0), m_4DLinearRegressionGradientEstimator(0),
+      m_gradientVolume(0)
 {
     createImage(volume->getVtkData());
     createVolumeRayCastFunctions();
@@ -51,7 +63,8 @@ Experimental3DVolume::Experimental3DVolume(Volume *volume)
 }
 
 Experimental3DVolume::Experimental3DVolume(vtkImageData *image)
-    : m_alternativeImage(0), m_finiteDifferenceGradientEstimator(0), m_4DLinearRegressionGradientEstimator(0)
+    : m_alternativeImage(0), m_gradientEstimator(FiniteDifference), m_finiteDifferenceGradientEstimator(0), m_4DLinearRegressionGradientEstimator(0),
+      m_gradientVolume(0)
 {
     createImage(image);
     createVolumeRayCastFunctions();
@@ -96,11 +109,13 @@ Experimental3DVolume::~Experimental3DVolume()
     {
         m_4DLinearRegressionGradientEstimator->Delete();
     }
+    delete m_gradientVolume;
 }
 
 void Experimental3DVolume::setAlternativeImage(vtkImageData *alternativeImage)
 {
     m_alternativeImage = alternativeImage;
+    deleteGradientVolume();
     m_ambientVoxelShader->setAlternativeData(reinterpret_cast<unsigned short*>(m_alternativeImage->GetScalarPointer()));
     m_directIlluminationVoxelShader->setAlternativeData(reinterpret_cast<unsigned short*>(m_alternativeImage->GetScalarPointer()));
 }
@@ -166,6 +181,11 @@ void Experimental3DVolume::setInterpolation(Interpolation interpolation)
 
 void Experimental3DVolume::setGradientEstimator(GradientEstimator gradientEstimator)
 {
+    // QExperimental3DExtension l'assigna a cada render, i el gradient només s'ha de recalcular si canvia l'estimador
+    if (gradientEstimator != m_gradientEstimator)
+    {
+        deleteGradientVolume();
+    }
     m_gradientEstimator = gradientEstimator;
 
     switch (gradientEstimator)
@@ -256,7 +276,7 @@ void Experimental3DVolume::addCoolWarm(float b, float y, float alpha, float beta
     {
         m_shaderVolumeRayCastFunction->AddVoxelShader(m_coolWarmVoxelShader);
     }
-    m_coolWarmVoxelShader->setGradientEstimator(gradientEstimator());
+    m_coolWarmVoxelShader->setGradientVolume(gradientVolume());
     m_coolWarmVoxelShader->setBYAlphaBeta(b, y, alpha, beta);
     m_coolWarmVoxelShader->setCombine(m_shaderVolumeRayCastFunction->IndexOfVoxelShader(m_coolWarmVoxelShader) != 0);
     m_volume->SetMapper(m_cpuRayCastMapper);
@@ -273,7 +293,7 @@ void Experimental3DVolume::addContour(double threshold)
 {
     m_cpuRayCastMapper->SetVolumeRayCastFunction(m_shaderVolumeRayCastFunction);
     m_shaderVolumeRayCastFunction->AddVoxelShader(m_contourVoxelShader);
-    m_contourVoxelShader->setGradientEstimator(gradientEstimator());
+    m_contourVoxelShader->setGradientVolume(gradientVolume());
     m_contourVoxelShader->setThreshold(threshold);
     m_volume->SetMapper(m_cpuRayCastMapper);
 }
@@ -460,36 +480,30 @@ void Experimental3DVolume::addOpacity(const QVector<float> &data, float maximum)
 
 QVector<float> Experimental3DVolume::computeVomiGradient(const QVector<float> &vomi)
 {
-    vtkFloatArray *vomiArray = vtkFloatArray::New();
-    vomiArray->SetArray(const_cast<float*>(vomi.data()), m_dataSize, 1);
-    vtkImageData *vomiData = vtkImageData::New();
-    vomiData->CopyStructure(m_image);
-    vtkPointData *vomiPointData = vomiData->GetPointData();
-    vomiPointData->SetScalars(vomiArray);
+    // Es calcula el gradient en floats directament sobre la VoMI amb el mateix mètode que l'estimador actual,
+    // sense canviar l'entrada de l'estimador (cosa que obligava a recalcular les normals del volum)
+    GradientVolume::Method method;
+    int radius;
+    getGradientMethod(m_gradientEstimator, method, radius);
+    int dimensions[3];
+    m_image->GetDimensions(dimensions);
 
-    vtkEncodedGradientEstimator *gradientEstimator = this->gradientEstimator();
-    gradientEstimator->SetInputData(vomiData);
-    unsigned char *gradientMagnitudes = gradientEstimator->GetGradientMagnitudes();
+    GradientVolume gradientVolume;
+    gradientVolume.compute(vomi.constData(), dimensions, m_image->GetSpacing(), method, radius);
 
     QVector<float> vomiGradient(m_dataSize);
-    float maxVomiGradient = 0.0f;
-    for (unsigned int i = 0; i < m_dataSize; i++)
+    float maxVomiGradient = gradientVolume.getMaximumMagnitude();
+    if (gradientVolume.isEmpty() || maxVomiGradient == 0.0f)
     {
-        if (gradientMagnitudes[i] > maxVomiGradient)
-        {
-            maxVomiGradient = gradientMagnitudes[i];
-        }
+        return vomiGradient;
     }
+
+    const float *magnitudes = gradientVolume.getMagnitudes();
     for (unsigned int i = 0; i < m_dataSize; i++)
     {
-        vomiGradient[i] = gradientMagnitudes[i] / maxVomiGradient;
+        vomiGradient[i] = magnitudes[i] / maxVomiGradient;
     }
 
-    gradientEstimator->SetInputData(m_image);
-
-    vomiArray->Delete();
-    vomiData->Delete();
-
     return vomiGradient;
 }
 
@@ -620,4 +634,28 @@ vtkEncodedGradientEstimator* Experimental3DVolume::gradientEstimator() const
     }
 }
 
+const GradientVolume* Experimental3DVolume::gradientVolume()
+{
+    if (!m_gradientVolume)
+    {
+        GradientVolume::Method method;
+        int radius;
+        getGradientMethod(m_gradientEstimator, method, radius);
+
+        m_gradientVolume = new GradientVolume();
+        m_gradientVolume->compute(m_alternativeImage ? m_alternativeImage : m_image, method, radius);
+    }
+
+    return m_gradientVolume;
+}
+
+void Experimental3DVolume::deleteGradientVolume()
+{
+    delete m_gradientVolume;
+    m_gradientVolume = 0;
+    // Els voxel shaders el tornen a rebre quan es tornen a afegir
+    m_contourVoxelShader->setGradientVolume(0);
+    m_coolWarmVoxelShader->setGradientVolume(0);
+}
+
 } // namespace udg
@@ -26,6 +26,7 @@ class DirectIlluminationVoxelShader2;
 class FilteringAmbientOcclusionMapVoxelShader;
 class FilteringAmbientOcclusionStipplingVoxelShader;
 class FilteringAmbientOcclusionVoxelShader;
+class GradientVolume;
 class ImiVoxelShader;
 class Obscurance;
 class ObscuranceVoxelShader;
@@ -140,6 +141,10 @@ private:
     void createVolume();
     /// Retorna l'estimador de gradient actual.
     vtkEncodedGradientEstimator* gradientEstimator() const;
+    /// Retorna el gradient del volum calculat amb el mètode de l'estimador actual; el calcula si no el té.
+    const GradientVolume* gradientVolume();
+    /// Esborra el gradient del volum i el treu dels voxel shaders que el fan servir.
+    void deleteGradientVolume();
 
 private:
 
@@ -225,6 +230,8 @@ private:
     vtkFiniteDifferenceGradientEstimator *m_finiteDifferenceGradientEstimator;
     /// Estimador de gradient per regressió lineal 4D.
     Vtk4DLinearRegressionGradientEstimator *m_4DLinearRegressionGradientEstimator;
+    /// Gradient del volum en floats, compartit pels voxel shaders que fan servir les normals. És nul fins que algun el necessita.
+    GradientVolume *m_gradientVolume;
 
 };
 
@@ -17,6 +17,9 @@
 #include <QDataStream>
 #include <QFile>
 
+#include <algorithm>
+
+#include "derivedvolumecache.h"
 #include "logging.h"
 #include "vector3.h"
 
@@ -113,6 +116,51 @@ void Obscurance::normalize()
     }
 }
 
+void Obscurance::clear()
+{
+    if (m_floatObscurance)
+    {
+        std::fill(m_floatObscurance, m_floatObscurance + m_size, 0.0f);
+    }
+    if (m_doubleObscurance)
+    {
+        std::fill(m_doubleObscurance, m_doubleObscurance + m_size, 0.0);
+    }
+    if (m_floatColorBleeding)
+    {
+        std::fill(m_floatColorBleeding, m_floatColorBleeding + m_size, Vector3Float());
+    }
+    if (m_doubleColorBleeding)
+    {
+        std::fill(m_doubleColorBleeding, m_doubleColorBleeding + m_size, Vector3Double());
+    }
+}
+
+void Obscurance::add(const Obscurance &obscurance, unsigned int begin, unsigned int end)
+{
+    Q_ASSERT(obscurance.m_size == m_size && obscurance.m_color == m_color && obscurance.m_doublePrecision == m_doublePrecision);
+
+    for (unsigned int i = begin; i < end; i++)
+    {
+        if (m_floatObscurance)
+        {
+            m_floatObscurance[i] += obscurance.m_floatObscurance[i];
+        }
+        if (m_doubleObscurance)
+        {
+            m_doubleObscurance[i] += obscurance.m_doubleObscurance[i];
+        }
+        if (m_floatColorBleeding)
+        {
+            m_floatColorBleeding[i] += obscurance.m_floatColorBleeding[i];
+        }
+        if (m_doubleColorBleeding)
+        {
+            m_doubleColorBleeding[i] += obscurance.m_doubleColorBleeding[i];
+        }
+    }
+}
+
 bool Obscurance::load(const QString &fileName)
 {
     QFile file(fileName);
@@ -257,4 +305,57 @@ bool Obscurance::save(const QString &fileName) const
     return true;
 }
 
+bool Obscurance::load(DerivedVolumeCache &cache, const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key)
+{
+    // Els Vector3 són 3 components consecutius, i així es desa el color bleeding
+    if (!m_color)
+    {
+        if (m_doublePrecision)
+        {
+            return cache.load(studyInstanceUID, seriesInstanceUID, key, m_doubleObscurance, m_size);
+        }
+        else
+        {
+            return cache.load(studyInstanceUID, seriesInstanceUID, key, m_floatObscurance, m_size);
+        }
+    }
+    else
+    {
+        if (m_doublePrecision)
+        {
+            return cache.load(studyInstanceUID, seriesInstanceUID, key, reinterpret_cast<double*>(m_doubleColorBleeding), m_size, 3);
+        }
+        else
+        {
+            return cache.load(studyInstanceUID, seriesInstanceUID, key, reinterpret_cast<float*>(m_floatColorBleeding), m_size, 3);
+        }
+    }
+}
+
+bool Obscurance::save(DerivedVolumeCache &cache, const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key) const
+{
+    if (!m_color)
+    {
+        if (m_doublePrecision)
+        {
+            return cache.store(studyInstanceUID, seriesInstanceUID, key, m_doubleObscurance, m_size);
+        }
+        else
+        {
+            return cache.store(studyInstanceUID, seriesInstanceUID, key, m_floatObscurance, m_size);
+        }
+    }
+    else
+    {
+        if (m_doublePrecision)
+        {
+            return cache.store(studyInstanceUID, seriesInstanceUID, key, reinterpret_cast<const double*>(m_doubleColorBleeding), m_size, 3);
+        }
+        else
+        {
+            return cache.store(studyInstanceUID, seriesInstanceUID, key, reinterpret_cast<const float*>(m_floatColorBleeding), m_size, 3);
+        }
+    }
+}
+
 }
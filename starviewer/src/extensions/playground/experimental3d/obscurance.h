@@ -19,6 +19,8 @@
 
 namespace udg {
 
+class DerivedVolumeCache;
+
 /**
     Classe que encapsula les obscurances.
   */
@@ -38,6 +40,11 @@ public:
     /// Normalitza les obscurances.
     void normalize();
 
+    /// Posa totes les obscurances a 0.
+    void clear();
+    /// Afegeix les obscurances de les posicions [begin, end) de \a obscurance, que ha de tenir la mateixa mida, color i precisió.
+    void add(const Obscurance &obscurance, unsigned int begin, unsigned int end);
+
     /// Retorna l'array d'obscurança amb floats (0 si no existeix).
     float* floatObscurance() const;
     /// Retorna l'array d'obscurança amb doubles (0 si no existeix).
@@ -64,6 +71,11 @@ public:
     bool load(const QString &fileName);
     /// Desa les obscurances a un fitxer. Retorna cert si tot va bé i fals si hi ha error.
     bool save(const QString &fileName) const;
+    /// Carrega les obscurances de la cache de volums derivats, on es guarden quantitzades si són de precisió simple i sense pèrdua si són de precisió
+    /// doble. Retorna cert si hi són i fals altrament.
+    bool load(DerivedVolumeCache &cache, const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key);
+    /// Desa les obscurances a la cache de volums derivats. Retorna cert si tot va bé i fals si hi ha error.
+    bool save(DerivedVolumeCache &cache, const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key) const;
 
 private:
     /// Mida de les obscurances.
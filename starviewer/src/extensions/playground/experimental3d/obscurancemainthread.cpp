@@ -14,31 +14,53 @@
 
 #include "obscurancemainthread.h"
 
+#include <QPair>
+#include <QtConcurrentMap>
+
 #include <vtkDataArray.h>
 #include <vtkEncodedGradientEstimator.h>
 #include <vtkImageData.h>
-#include <vtkMultiThreader.h>
 #include <vtkPointData.h>
 #include <vtkVolume.h>
 #include "vtkVolumeRayCastMapper.h"
 
 #include "logging.h"
+#include "obscurancetaskqueue.h"
 #include "obscurancethread.h"
 #include "vector3.h"
 #include "viewpointgenerator.h"
 
 namespace udg {
 
+namespace {
+
+/// Number of chunks in which the lines of each direction are split for each thread, so that there are enough tasks to balance the load
+const int ChunksPerThread = 8;
+/// Milliseconds between progress updates
+const int ProgressInterval = 100;
+/// Maximum number of directions processed at the same time, each of them with its own full-size obscurance
+const int MaximumNumberOfAccumulators = 3;
+/// Number of voxels of each block when merging the accumulators
+const int MergeBlockSize = 65536;
+
+}
+
 bool ObscuranceMainThread::hasColor(Variant variant)
 {
     return variant >= OpacityColorBleeding;
 }
 
+bool ObscuranceMainThread::usesOpacity(Variant variant)
+{
+    return variant >= Opacity;
+}
+
 ObscuranceMainThread::ObscuranceMainThread(int numberOfDirections, double maximumDistance, Function function, Variant variant,
                                            bool doublePrecision, QObject *parent)
  : QThread(parent),
    m_numberOfDirections(numberOfDirections), m_maximumDistance(maximumDistance), m_function(function), m_variant(variant),
    m_doublePrecision(doublePrecision),
+   m_numberOfThreads(QThread::idealThreadCount()),
    m_volume(0),
    m_obscurance(0)
 {
@@ -76,6 +98,11 @@ void ObscuranceMainThread::setSaliency(const double *saliency, double fxSaliency
     m_fxSaliencyHigh = fxSaliencyHigh;
 }
 
+void ObscuranceMainThread::setNumberOfThreads(int numberOfThreads)
+{
+    m_numberOfThreads = qMax(1, numberOfThreads);
+}
+
 Obscurance* ObscuranceMainThread::getObscurance() const
 {
     return m_obscurance;
@@ -97,9 +124,7 @@ void ObscuranceMainThread::run()
     /// \TODO fent això aquí crec que va més ràpid, però s'hauria de comprovar i provar també amb l'Update()
     gradientEstimator->GetEncodedNormals();
 
-    // Creem els threads
-    /// \todo QThread::idealThreadCount() amb Qt >= 4.3
-    int numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    int numberOfThreads = m_numberOfThreads;
     QVector<ObscuranceThread*> threads(numberOfThreads);
 
     // Variables necessàries
@@ -117,200 +142,90 @@ void ObscuranceMainThread::run()
     increments[2] = vtkIncrements[2];
 
     m_obscurance = new Obscurance(dataSize, hasColor(), m_doublePrecision);
+    m_obscurance->clear();
+
+    const QVector<Vector3> directions = getDirections();
+    int numberOfAccumulators = qBound(1, qMin(numberOfThreads, directions.size()), MaximumNumberOfAccumulators);
+    ObscuranceTaskQueue taskQueue(directions, dimensions, increments, numberOfThreads, ChunksPerThread * numberOfThreads, numberOfAccumulators);
+
+    // Each of the directions being processed at the same time accumulates into its own obscurance, shared by all the threads, so the memory
+    // doesn't grow with the number of threads. The first one is the final obscurance.
+    QVector<Obscurance*> accumulators(numberOfAccumulators);
+    accumulators[0] = m_obscurance;
+    for (int i = 1; i < numberOfAccumulators; i++)
+    {
+        accumulators[i] = new Obscurance(dataSize, hasColor(), m_doublePrecision);
+        accumulators[i]->clear();
+    }
 
     for (int i = 0; i < numberOfThreads; i++)
     {
-        ObscuranceThread * thread = new ObscuranceThread(i, numberOfThreads, m_transferFunction);
+        ObscuranceThread *thread = new ObscuranceThread(i, m_transferFunction);
         thread->setGradientEstimator(gradientEstimator);
         thread->setData(data, dataSize, dimensions, increments);
-        thread->setObscuranceParameters(m_maximumDistance, m_function, m_variant, m_obscurance);
+        thread->setObscuranceParameters(m_maximumDistance, m_function, m_variant, accumulators);
         thread->setSaliency(m_saliency, m_fxSaliencyA, m_fxSaliencyB, m_fxSaliencyLow, m_fxSaliencyHigh);
+        thread->setTaskQueue(&taskQueue);
         threads[i] = thread;
+        thread->start();
     }
 
-    // Estructures de dades reaprofitables
-    QVector<Vector3> lineStarts;
-
-    const QVector<Vector3> directions = getDirections();
+    // Esperem que acabin els threads, informant del progrés i propagant la cancel·lació
     int nDirections = directions.size();
-
-    // Iterem per les direccions
-    for (int i = 0; i < nDirections && !m_stopped; i++)
+    int lastFinishedDirections = 0;
+    for (int i = 0; i < numberOfThreads; i++)
     {
-        const Vector3 &direction = directions.at(i);
-
-        DEBUG_LOG(QString("Direcció %1: %2").arg(i).arg(direction.toString()));
-
-        // Direcció dominant (0 = x, 1 = y, 2 = z)
-        int dominant;
-        Vector3 absDirection(qAbs(direction.x), qAbs(direction.y), qAbs(direction.z));
-        if (absDirection.x >= absDirection.y)
+        while (!threads[i]->wait(ProgressInterval))
         {
-            if (absDirection.x >= absDirection.z)
+            if (m_stopped)
             {
-                dominant = 0;
+                taskQueue.stop();
             }
-            else
-            {
-                dominant = 2;
-            }
-        }
-        else
-        {
-            if (absDirection.y >= absDirection.z)
-            {
-                dominant = 1;
-            }
-            else
+
+            int finishedDirections = taskQueue.getNumberOfFinishedDirections();
+            if (finishedDirections != lastFinishedDirections)
             {
-                dominant = 2;
+                lastFinishedDirections = finishedDirections;
+                emit progress(100 * finishedDirections / nDirections);
             }
         }
-
-        // Vector per avançar
-        Vector3 forward;
-        switch (dominant)
-        {
-            case 0:
-                forward = Vector3(direction.x, direction.y, direction.z);
-                break;
-            case 1:
-                forward = Vector3(direction.y, direction.z, direction.x);
-                break;
-            case 2: 
-                forward = Vector3(direction.z, direction.x, direction.y);
-                break;
-        }
-        // La direcció x passa a ser 1 o -1
-        forward /= qAbs(forward.x);
-        DEBUG_LOG(QString("forward = ") + forward.toString());
-
-        // Dimensions i increments segons la direcció dominant
-        int x = dominant, y = (dominant + 1) % 3, z = (dominant + 2) % 3;
-        int dimX = dimensions[x], dimY = dimensions[y], dimZ = dimensions[z];
-        int incX = increments[x], incY = increments[y], incZ = increments[z];
-        int sX = 1, sY = 1, sZ = 1;
-        qptrdiff startDelta = 0;
-        if (forward.x < 0.0)
-        {
-            startDelta += incX * (dimX - 1);
-//             incX = -incX;
-            forward.x = -forward.x;
-            sX = -1;
-        }
-        if (forward.y < 0.0)
-        {
-            startDelta += incY * (dimY - 1);
-//             incY = -incY;
-            forward.y = -forward.y;
-            sY = -1;
-        }
-        if (forward.z < 0.0)
-        {
-            startDelta += incZ * (dimZ - 1);
-//             incZ = -incZ;
-            forward.z = -forward.z;
-            sZ = -1;
-        }
-        DEBUG_LOG(QString("forward = ") + forward.toString());
-        // Ara els 3 components són positius
-
-        // Llista dels vòxels que són començament de línia
-        getLineStarts(lineStarts, dimX, dimY, dimZ, forward);
-
-//         int incXYZ[3] = { incX, incY, incZ };
-        int xyz[3] = { x, y, z };
-        int sXYZ[3] = { sX, sY, sZ };
-
-        // Iniciem els threads
-        for (int j = 0; j < numberOfThreads; j++)
-        {
-            ObscuranceThread * thread = threads[j];
-            thread->setPerDirectionParameters(direction, forward, xyz, sXYZ, lineStarts, startDelta);
-            thread->start();
-        }
-
-        // Esperem que acabin els threads
-        for (int j = 0; j < numberOfThreads; j++)
-        {
-            threads[j]->wait();
-        }
-
-        emit progress(100 * (i + 1) / nDirections);
     }
 
     // Destruïm els threads
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        delete threads[j];
-    }
+    qDeleteAll(threads);
+
     // Si han cancel·lat el procés ja podem plegar
     if (m_stopped)
     {
+        qDeleteAll(accumulators);
+        m_obscurance = 0;
         emit progress(0);
-        delete m_obscurance; m_obscurance = 0;
         return;
     }
 
-    m_obscurance->normalize();
-
-    emit computed();
-}
-
-void ObscuranceMainThread::getLineStarts(QVector<Vector3> &lineStarts, int dimX, int dimY, int dimZ, const Vector3 &forward)
-{
-    lineStarts.resize(0);
-
-    // Tots els (0,y,z) són començament de línia
-    // (0,0,0)
-    Vector3 lineStart;
-    for (int iy = 0; iy < dimY; ++iy)
+    // Sumem els acumuladors a l'obscurança final per blocs en paral·lel
+    QVector<QPair<unsigned int, unsigned int> > blocks;
+    for (int begin = 0; begin < dataSize; begin += MergeBlockSize)
     {
-        lineStart.y = iy;
-        for (int iz = 0; iz < dimZ; ++iz)
-        {
-            lineStart.z = iz;
-            lineStarts << lineStart;
-//             DEBUG_LOG(QString("line start: (%1,%2,%3)").arg(lineStart.x).arg(lineStart.y).arg(lineStart.z));
-        }
+        blocks << qMakePair(static_cast<unsigned int>(begin), static_cast<unsigned int>(qMin(begin + MergeBlockSize, dataSize)));
     }
-    DEBUG_LOG(QString("line starts: %1").arg(lineStarts.size()));
-
-    // Més començaments de línia
-    // (0,0,0)
-    Vector3 rv;
-    Voxel v = { 0, 0, 0 }, pv = v;
-
-    // Iterar per la línia que comença a (0,0,0)
-    while (v.x < dimX)
+    QtConcurrent::blockingMap(blocks, [&](const QPair<unsigned int, unsigned int> &block)
     {
-        if (v.y != pv.y)
-        {
-            // [y] = 0
-            lineStart.x = rv.x; lineStart.y = rv.y - v.y;
-            for (double iz = rv.z - v.z; iz < dimZ; iz++)
-            {
-                lineStart.z = iz;
-                lineStarts << lineStart;
-            }
-        }
-        if (v.z != pv.z)
+        for (int i = 1; i < numberOfAccumulators; i++)
         {
-            // [z] = 0
-            lineStart.x = rv.x; lineStart.z = rv.z - v.z;
-            for (double iy = rv.y - v.y; iy < dimY; iy++)
-            {
-                lineStart.y = iy;
-                lineStarts << lineStart;
-            }
+            m_obscurance->add(*accumulators.at(i), block.first, block.second);
         }
+    });
 
-        // Avançar el vòxel
-        rv += forward;
-        pv = v;
-        v.x = qRound(rv.x); v.y = qRound(rv.y); v.z = qRound(rv.z);
+    for (int i = 1; i < numberOfAccumulators; i++)
+    {
+        delete accumulators[i];
     }
-    DEBUG_LOG(QString("line starts: %1").arg(lineStarts.size()));
+
+    m_obscurance->normalize();
+
+    emit progress(100);
+    emit computed();
 }
 
 QVector<Vector3> ObscuranceMainThread::getDirections() const
@@ -41,6 +41,8 @@ public:
     enum Variant { Density, DensitySmooth, Opacity, OpacitySmooth, OpacitySaliency, OpacitySmoothSaliency, OpacityColorBleeding, OpacitySmoothColorBleeding };
 
     static bool hasColor(Variant variant);
+    /// Retorna cert si la variant fa servir l'opacitat de la funció de transferència.
+    static bool usesOpacity(Variant variant);
 
     ObscuranceMainThread(int numberOfDirections, double maximumDistance, Function function, Variant variant, bool doublePrecision = true, QObject *parent = 0);
     virtual ~ObscuranceMainThread();
@@ -49,6 +51,8 @@ public:
     void setVolume(vtkVolume *volume);
     void setTransferFunction(const TransferFunction &transferFunction);
     void setSaliency(const double *saliency, double fxSaliencyA, double fxSaliencyB, double fxSaliencyLow, double fxSaliencyHigh);
+    /// Sets the number of threads used to compute the obscurances. By default it's QThread::idealThreadCount().
+    void setNumberOfThreads(int numberOfThreads);
 
     Obscurance* getObscurance() const;
 
@@ -63,7 +67,6 @@ protected:
     virtual void run();
 
 private:
-    static void getLineStarts(QVector<Vector3> &lineStarts, int dimX, int dimY, int dimZ, const Vector3 &forward);
     QVector<Vector3> getDirections() const;
 
 private:
@@ -72,6 +75,7 @@ private:
     Function m_function;
     Variant m_variant;
     bool m_doublePrecision;
+    int m_numberOfThreads;
     vtkVolume *m_volume;
     TransferFunction m_transferFunction;
     Obscurance *m_obscurance;
@@ -0,0 +1,330 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "obscurancetaskqueue.h"
+
+#include "logging.h"
+#include "obscurancemainthread.h"
+
+namespace udg {
+
+/// A direction with the state needed to prepare it once and release its line starts
+struct ObscuranceTaskQueue::DirectionState {
+    Direction direction;
+    QMutex mutex;
+    bool prepared;
+    QAtomicInt remainingChunks;
+};
+
+ObscuranceTaskQueue::ObscuranceTaskQueue(const QVector<Vector3> &directions, const int dimensions[3], const int increments[3], int numberOfWorkers,
+                                         int numberOfChunksPerDirection, int numberOfAccumulators)
+ : m_numberOfChunksPerDirection(qMax(1, numberOfChunksPerDirection)), m_numberOfAccumulators(qMax(1, numberOfAccumulators)),
+   m_numberOfFinishedDirections(0), m_stopped(0)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        m_dimensions[i] = dimensions[i];
+        m_increments[i] = increments[i];
+    }
+
+    m_directions.resize(directions.size());
+    for (int i = 0; i < directions.size(); i++)
+    {
+        DirectionState *state = new DirectionState();
+        state->direction.direction = directions.at(i);
+        state->prepared = false;
+        state->remainingChunks = m_numberOfChunksPerDirection;
+        m_directions[i] = state;
+    }
+
+    m_workerQueues.resize(qMax(1, numberOfWorkers));
+
+    // The chunks of each direction are dealt to the workers in turn, so that all of them start with the first directions
+    for (int i = 0; i < directions.size(); i++)
+    {
+        for (int j = 0; j < m_numberOfChunksPerDirection; j++)
+        {
+            Task task = { i, j, i % m_numberOfAccumulators };
+            m_workerQueues[j % m_workerQueues.size()].append(task);
+        }
+    }
+}
+
+ObscuranceTaskQueue::~ObscuranceTaskQueue()
+{
+    qDeleteAll(m_directions);
+}
+
+int ObscuranceTaskQueue::getNumberOfDirections() const
+{
+    return m_directions.size();
+}
+
+int ObscuranceTaskQueue::getNumberOfChunksPerDirection() const
+{
+    return m_numberOfChunksPerDirection;
+}
+
+int ObscuranceTaskQueue::getNumberOfAccumulators() const
+{
+    return m_numberOfAccumulators;
+}
+
+bool ObscuranceTaskQueue::takeTask(int worker, Task &task)
+{
+    int numberOfWorkers = m_workerQueues.size();
+    QMutexLocker locker(&m_mutex);
+
+    while (true)
+    {
+        if (isStopped())
+        {
+            return false;
+        }
+
+        bool tasksLeft = false;
+
+        for (int i = 0; i < numberOfWorkers; i++)
+        {
+            QList<Task> &queue = m_workerQueues[(worker + i) % numberOfWorkers];
+
+            if (!queue.isEmpty())
+            {
+                tasksLeft = true;
+
+                // The queues are in direction order, so if the first task can't start none of them can
+                if (canStart(queue.first().direction))
+                {
+                    task = queue.takeFirst();
+                    return true;
+                }
+            }
+        }
+
+        if (!tasksLeft)
+        {
+            return false;
+        }
+
+        m_directionFinished.wait(&m_mutex);
+    }
+}
+
+const ObscuranceTaskQueue::Direction& ObscuranceTaskQueue::getDirection(int direction)
+{
+    DirectionState *state = m_directions.at(direction);
+    QMutexLocker locker(&state->mutex);
+
+    if (!state->prepared)
+    {
+        prepareDirection(state->direction);
+        state->prepared = true;
+    }
+
+    return state->direction;
+}
+
+bool ObscuranceTaskQueue::finishTask(const Task &task)
+{
+    DirectionState *state = m_directions.at(task.direction);
+
+    if (state->remainingChunks.deref())
+    {
+        return false;
+    }
+
+    // All the chunks have already copied the line starts, so they can be released
+    {
+        QMutexLocker locker(&state->mutex);
+        state->direction.lineStarts = QVector<Vector3>();
+    }
+    m_numberOfFinishedDirections.ref();
+
+    // Its accumulator is free now, so the next direction that uses it can start
+    QMutexLocker locker(&m_mutex);
+    m_directionFinished.wakeAll();
+
+    return true;
+}
+
+int ObscuranceTaskQueue::getNumberOfFinishedDirections() const
+{
+    return m_numberOfFinishedDirections.load();
+}
+
+void ObscuranceTaskQueue::stop()
+{
+    m_stopped.store(1);
+
+    QMutexLocker locker(&m_mutex);
+    m_directionFinished.wakeAll();
+}
+
+bool ObscuranceTaskQueue::isStopped() const
+{
+    return m_stopped.load() != 0;
+}
+
+bool ObscuranceTaskQueue::canStart(int direction) const
+{
+    return direction < m_numberOfAccumulators || m_directions.at(direction - m_numberOfAccumulators)->remainingChunks.loadAcquire() == 0;
+}
+
+void ObscuranceTaskQueue::prepareDirection(Direction &parameters) const
+{
+    const Vector3 &direction = parameters.direction;
+
+    DEBUG_LOG(QString("Direcció: %1").arg(direction.toString()));
+
+    // Direcció dominant (0 = x, 1 = y, 2 = z)
+    int dominant;
+    Vector3 absDirection(qAbs(direction.x), qAbs(direction.y), qAbs(direction.z));
+    if (absDirection.x >= absDirection.y)
+    {
+        if (absDirection.x >= absDirection.z)
+        {
+            dominant = 0;
+        }
+        else
+        {
+            dominant = 2;
+        }
+    }
+    else
+    {
+        if (absDirection.y >= absDirection.z)
+        {
+            dominant = 1;
+        }
+        else
+        {
+            dominant = 2;
+        }
+    }
+
+    // Vector per avançar
+    Vector3 forward;
+    switch (dominant)
+    {
+        case 0:
+            forward = Vector3(direction.x, direction.y, direction.z);
+            break;
+        case 1:
+            forward = Vector3(direction.y, direction.z, direction.x);
+            break;
+        case 2:
+            forward = Vector3(direction.z, direction.x, direction.y);
+            break;
+    }
+    // La direcció x passa a ser 1 o -1
+    forward /= qAbs(forward.x);
+
+    // Dimensions i increments segons la direcció dominant
+    int x = dominant, y = (dominant + 1) % 3, z = (dominant + 2) % 3;
+    int dimX = m_dimensions[x], dimY = m_dimensions[y], dimZ = m_dimensions[z];
+    int incX = m_increments[x], incY = m_increments[y], incZ = m_increments[z];
+    int sX = 1, sY = 1, sZ = 1;
+    qptrdiff startDelta = 0;
+    if (forward.x < 0.0)
+    {
+        startDelta += incX * (dimX - 1);
+        forward.x = -forward.x;
+        sX = -1;
+    }
+    if (forward.y < 0.0)
+    {
+        startDelta += incY * (dimY - 1);
+        forward.y = -forward.y;
+        sY = -1;
+    }
+    if (forward.z < 0.0)
+    {
+        startDelta += incZ * (dimZ - 1);
+        forward.z = -forward.z;
+        sZ = -1;
+    }
+    DEBUG_LOG(QString("forward = ") + forward.toString());
+    // Ara els 3 components són positius
+
+    parameters.forward = forward;
+    parameters.xyz[0] = x;
+    parameters.xyz[1] = y;
+    parameters.xyz[2] = z;
+    parameters.sXYZ[0] = sX;
+    parameters.sXYZ[1] = sY;
+    parameters.sXYZ[2] = sZ;
+    parameters.startDelta = startDelta;
+
+    // Llista dels vòxels que són començament de línia
+    getLineStarts(parameters.lineStarts, dimX, dimY, dimZ, forward);
+}
+
+void ObscuranceTaskQueue::getLineStarts(QVector<Vector3> &lineStarts, int dimX, int dimY, int dimZ, const Vector3 &forward)
+{
+    lineStarts.resize(0);
+
+    // Tots els (0,y,z) són començament de línia
+    // (0,0,0)
+    Vector3 lineStart;
+    for (int iy = 0; iy < dimY; ++iy)
+    {
+        lineStart.y = iy;
+        for (int iz = 0; iz < dimZ; ++iz)
+        {
+            lineStart.z = iz;
+            lineStarts << lineStart;
+//             DEBUG_LOG(QString("line start: (%1,%2,%3)").arg(lineStart.x).arg(lineStart.y).arg(lineStart.z));
+        }
+    }
+    DEBUG_LOG(QString("line starts: %1").arg(lineStarts.size()));
+
+    // Més començaments de línia
+    // (0,0,0)
+    Vector3 rv;
+    ObscuranceMainThread::Voxel v = { 0, 0, 0 }, pv = v;
+
+    // Iterar per la línia que comença a (0,0,0)
+    while (v.x < dimX)
+    {
+        if (v.y != pv.y)
+        {
+            // [y] = 0
+            lineStart.x = rv.x; lineStart.y = rv.y - v.y;
+            for (double iz = rv.z - v.z; iz < dimZ; iz++)
+            {
+                lineStart.z = iz;
+                lineStarts << lineStart;
+            }
+        }
+        if (v.z != pv.z)
+        {
+            // [z] = 0
+            lineStart.x = rv.x; lineStart.z = rv.z - v.z;
+            for (double iy = rv.y - v.y; iy < dimY; iy++)
+            {
+                lineStart.y = iy;
+                lineStarts << lineStart;
+            }
+        }
+
+        // Avançar el vòxel
+        rv += forward;
+        pv = v;
+        v.x = qRound(rv.x); v.y = qRound(rv.y); v.z = qRound(rv.z);
+    }
+    DEBUG_LOG(QString("line starts: %1").arg(lineStarts.size()));
+}
+
+}
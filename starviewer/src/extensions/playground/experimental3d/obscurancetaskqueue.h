@@ -0,0 +1,124 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGOBSCURANCETASKQUEUE_H
+#define UDGOBSCURANCETASKQUEUE_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "vector3.h"
+
+namespace udg {
+
+/**
+    Tasks of an obscurance computation, scheduled on a fixed set of workers with work stealing.
+
+    The lines of each direction are split in chunks of interleaved lines and each task processes one chunk of one direction. Each worker has its
+    own queue with a chunk of every direction, in direction order, takes tasks from the front of it and, when it's empty, steals them from the
+    queues of the other workers. There isn't any barrier between directions: up to numberOfAccumulators directions are processed at the same
+    time, each one accumulating into a different obscurance. The lines of a direction don't share any voxel, so its chunks can accumulate into
+    the same obscurance, and a direction doesn't start until the one that used its accumulator before has finished. This keeps the memory
+    bounded by the number of accumulators instead of the number of workers.
+
+    The parameters and the line starts of a direction are computed by the first task that needs them and the line starts are released when
+    the last chunk of the direction finishes, so only the directions being processed are kept in memory.
+  */
+class ObscuranceTaskQueue {
+public:
+    /// A chunk of the lines of a direction
+    struct Task {
+        int direction;
+        int chunk;
+        /// Index of the obscurance where the task accumulates
+        int accumulator;
+    };
+
+    /// Parameters to traverse the lines of a direction
+    struct Direction {
+        /// Direction of the lines
+        Vector3 direction;
+        /// Step between consecutive voxels of a line, in the axes given by xyz, with its dominant component equal to 1 and all of them positive
+        Vector3 forward;
+        /// Axes of the volume in the order of forward, starting with the dominant one
+        int xyz[3];
+        /// Signs of the steps along each axis of forward
+        int sXYZ[3];
+        /// Offset of the first voxel of the lines
+        qptrdiff startDelta;
+        /// Starts of the lines, with coordinates in the axes given by xyz
+        QVector<Vector3> lineStarts;
+    };
+
+    ObscuranceTaskQueue(const QVector<Vector3> &directions, const int dimensions[3], const int increments[3], int numberOfWorkers,
+                        int numberOfChunksPerDirection, int numberOfAccumulators);
+    ~ObscuranceTaskQueue();
+
+    int getNumberOfDirections() const;
+    int getNumberOfChunksPerDirection() const;
+    int getNumberOfAccumulators() const;
+
+    /// Takes the next task of the given worker, stealing it from another worker if its queue is empty, and waits if the remaining tasks
+    /// can't start until another direction finishes. Returns false when there are no tasks left or the queue has been stopped.
+    bool takeTask(int worker, Task &task);
+
+    /// Returns the parameters of the given direction, computing them the first time. It can only be called between taking and finishing a task
+    /// of the direction.
+    const Direction& getDirection(int direction);
+
+    /// Marks the task as finished. Returns true if it was the last one of its direction.
+    bool finishTask(const Task &task);
+
+    /// Returns the number of directions whose tasks have all finished
+    int getNumberOfFinishedDirections() const;
+
+    /// Makes takeTask() return false from now on, so that the workers stop after their current task
+    void stop();
+    bool isStopped() const;
+
+    /// Fills lineStarts with the voxels where the lines with the given forward step start, in a volume of the given dimensions
+    static void getLineStarts(QVector<Vector3> &lineStarts, int dimX, int dimY, int dimZ, const Vector3 &forward);
+
+private:
+    struct DirectionState;
+
+    /// Returns true if the tasks of the direction can start, i.e. the previous direction with the same accumulator has finished
+    bool canStart(int direction) const;
+
+    /// Computes the parameters and the line starts of the direction
+    void prepareDirection(Direction &direction) const;
+
+private:
+    QVector<DirectionState*> m_directions;
+    /// Tasks of each worker, in direction order
+    QVector<QList<Task> > m_workerQueues;
+    /// Protects the worker queues
+    QMutex m_mutex;
+    /// Signaled when a direction finishes or the queue is stopped
+    QWaitCondition m_directionFinished;
+    int m_numberOfChunksPerDirection;
+    int m_numberOfAccumulators;
+    int m_dimensions[3];
+    int m_increments[3];
+    QAtomicInt m_numberOfFinishedDirections;
+    QAtomicInt m_stopped;
+};
+
+}
+
+#endif
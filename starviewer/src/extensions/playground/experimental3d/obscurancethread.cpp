@@ -25,11 +25,12 @@
 #include "logging.h"
 #include "mathtools.h"
 #include "obscurance.h"
+#include "obscurancetaskqueue.h"
 
 namespace udg {
 
-ObscuranceThread::ObscuranceThread(int id, int numberOfThreads, const TransferFunction &transferFunction, QObject *parent)
- : QThread(parent), m_id(id), m_numberOfThreads(numberOfThreads), m_transferFunction(transferFunction), m_obscurance(0), m_saliency(0)
+ObscuranceThread::ObscuranceThread(int id, const TransferFunction &transferFunction, QObject *parent)
+ : QThread(parent), m_id(id), m_taskQueue(0), m_chunk(0), m_numberOfChunks(1), m_transferFunction(transferFunction), m_obscurance(0), m_saliency(0)
 {
 }
 
@@ -51,12 +52,13 @@ void ObscuranceThread::setData(const ushort *data, int dataSize, const int dimen
     m_increments = increments;
 }
 
-void ObscuranceThread::setObscuranceParameters(double obscuranceMaximumDistance, Function obscuranceFunction, Variant obscuranceVariant, Obscurance *obscurance)
+void ObscuranceThread::setObscuranceParameters(double obscuranceMaximumDistance, Function obscuranceFunction, Variant obscuranceVariant,
+                                               const QVector<Obscurance*> &accumulators)
 {
     m_obscuranceMaximumDistance = obscuranceMaximumDistance;
     m_obscuranceFunction = obscuranceFunction;
     m_obscuranceVariant = obscuranceVariant;
-    m_obscurance = obscurance;
+    m_accumulators = accumulators;
 }
 
 void ObscuranceThread::setSaliency(const double * saliency, double fxSaliencyA, double fxSaliencyB, double fxSaliencyLow, double fxSaliencyHigh)
@@ -68,6 +70,11 @@ void ObscuranceThread::setSaliency(const double * saliency, double fxSaliencyA,
     m_fxSaliencyHigh = fxSaliencyHigh;
 }
 
+void ObscuranceThread::setTaskQueue(ObscuranceTaskQueue *taskQueue)
+{
+    m_taskQueue = taskQueue;
+}
+
 void ObscuranceThread::setPerDirectionParameters(const Vector3 &direction, const Vector3 &forward, const int xyz[3], const int sXYZ[3],
                                                  const QVector<Vector3> &lineStarts, qptrdiff startDelta)
 {
@@ -83,6 +90,28 @@ void ObscuranceThread::run()
 {
     DEBUG_LOG(QString("%1: run()").arg(m_id));
 
+    Q_ASSERT(m_taskQueue);
+
+    ObscuranceTaskQueue::Task task;
+    while (m_taskQueue->takeTask(m_id, task))
+    {
+        const ObscuranceTaskQueue::Direction &direction = m_taskQueue->getDirection(task.direction);
+        setPerDirectionParameters(direction.direction, direction.forward, direction.xyz, direction.sXYZ, direction.lineStarts, direction.startDelta);
+        m_chunk = task.chunk;
+        m_numberOfChunks = m_taskQueue->getNumberOfChunksPerDirection();
+        m_obscurance = m_accumulators.at(task.accumulator);
+
+        runChunk();
+
+        m_taskQueue->finishTask(task);
+    }
+
+    // Release the line starts of the last direction
+    m_lineStarts = QVector<Vector3>();
+}
+
+void ObscuranceThread::runChunk()
+{
     switch (m_obscuranceVariant)
     {
         case ObscuranceMainThread::Density:
@@ -128,7 +157,7 @@ void ObscuranceThread::runDensity()
     int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_chunk; j < nLineStarts; j += m_numberOfChunks)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -200,7 +229,7 @@ void ObscuranceThread::runDensitySmooth()
     int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_chunk; j < nLineStarts; j += m_numberOfChunks)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -350,7 +379,7 @@ void ObscuranceThread::runOpacity()
     int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_chunk; j < nLineStarts; j += m_numberOfChunks)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -419,7 +448,7 @@ void ObscuranceThread::runOpacitySmooth()
     int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_chunk; j < nLineStarts; j += m_numberOfChunks)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -570,7 +599,7 @@ void ObscuranceThread::runOpacitySaliency()
     int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_chunk; j < nLineStarts; j += m_numberOfChunks)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -640,7 +669,7 @@ void ObscuranceThread::runOpacitySmoothSaliency()
     int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_chunk; j < nLineStarts; j += m_numberOfChunks)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -808,7 +837,7 @@ void ObscuranceThread::runOpacityColorBleeding()
     int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_chunk; j < nLineStarts; j += m_numberOfChunks)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -964,7 +993,7 @@ void ObscuranceThread::runOpacitySmoothColorBleeding()
 
     // u és el tapat, v és el que tapa
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_chunk; j < nLineStarts; j += m_numberOfChunks)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
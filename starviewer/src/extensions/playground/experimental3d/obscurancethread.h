@@ -28,27 +28,32 @@ class vtkEncodedGradientEstimator;
 namespace udg {
 
 class Obscurance;
+class ObscuranceTaskQueue;
 
 /**
     Thread que implementa els mètodes de càlcul d'obscurances.
 
+    Executes tasks of an ObscuranceTaskQueue until there are none left, accumulating the obscurances of each one into the Obscurance assigned
+    to the task.
+
     \author Grup de Gràfics de Girona (GGG) <vismed@ima.udg.edu>
   */
 class ObscuranceThread : public QThread {
 Q_OBJECT
 
 public:
-    ObscuranceThread(int id, int numberOfThreads, const TransferFunction &transferFunction, QObject *parent = 0);
+    ObscuranceThread(int id, const TransferFunction &transferFunction, QObject *parent = 0);
     virtual ~ObscuranceThread();
 
     /// Assigna l'estimador del gradient, d'on es treuran les normals.
     void setGradientEstimator(vtkEncodedGradientEstimator *gradientEstimator);
     void setData(const ushort *data, int dataSize, const int dimensions[3], const int increments[3]);
+    /// Assigna els paràmetres de les obscurances i les Obscurance on s'acumularan, indexades per l'acumulador de cada tasca.
     void setObscuranceParameters(double obscuranceMaximumDistance, ObscuranceMainThread::Function obscuranceFunction,
-                                 ObscuranceMainThread::Variant obscuranceVariant, Obscurance *obscurance);
+                                 ObscuranceMainThread::Variant obscuranceVariant, const QVector<Obscurance*> &accumulators);
     void setSaliency(const double *saliency, double fxSaliencyA, double fxSaliencyB, double fxSaliencyLow, double fxSaliencyHigh);
-    void setPerDirectionParameters(const Vector3 &direction, const Vector3 &forward, const int xyz[3], const int sXYZ[3],
-                                   const QVector<Vector3> &lineStarts, qptrdiff startDelta);
+    /// Sets the queue the tasks are taken from. The id of the thread is its worker index in the queue.
+    void setTaskQueue(ObscuranceTaskQueue *taskQueue);
 
 protected:
     virtual void run();
@@ -58,6 +63,10 @@ private:
     typedef ObscuranceMainThread::Function Function;
     typedef ObscuranceMainThread::Variant Variant;
 
+    void setPerDirectionParameters(const Vector3 &direction, const Vector3 &forward, const int xyz[3], const int sXYZ[3],
+                                   const QVector<Vector3> &lineStarts, qptrdiff startDelta);
+    /// Processes the lines of the current chunk of the current direction
+    void runChunk();
     void runDensity();
     void runDensitySmooth();
     void runOpacity();
@@ -69,7 +78,10 @@ private:
     double obscurance(double distance) const;
     bool smoothBlocking(const Vector3 &blocking, const Vector3 &blocked, double distance, const float *blockedGradient) const;
 
-    int m_id, m_numberOfThreads;
+    int m_id;
+    ObscuranceTaskQueue *m_taskQueue;
+    /// The current chunk has the lines m_chunk + k * m_numberOfChunks
+    int m_chunk, m_numberOfChunks;
     const TransferFunction &m_transferFunction;
     vtkDirectionEncoder *m_directionEncoder;
     const ushort *m_encodedNormals;
@@ -80,6 +92,8 @@ private:
     double m_obscuranceMaximumDistance;
     Function m_obscuranceFunction;
     Variant m_obscuranceVariant;
+    QVector<Obscurance*> m_accumulators;
+    /// Accumulator of the current task
     Obscurance *m_obscurance;
     const double *m_saliency;
     double m_fxSaliencyA, m_fxSaliencyB;
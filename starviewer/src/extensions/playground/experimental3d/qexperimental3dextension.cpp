@@ -1,12 +1,15 @@
 #include "qexperimental3dextension.h"
 
+#include "derivedvolumecache.h"
 #include "experimental3dsettings.h"
 #include "experimental3dvolume.h"
+#include "image.h"
 #include "informationtheory.h"
 #include "logging.h"
 #include "mathtools.h"
 #include "obscurancemainthread.h"
 #include "optimizetransferfunctioncommand.h"
+#include "series.h"
 #include "study.h"
 #include "transferfunctionio.h"
 #include "vector3.h"
@@ -17,6 +20,7 @@
 
 #include <QButtonGroup>
 #include <QColorDialog>
+#include <QDataStream>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QStringListModel>
@@ -24,6 +28,8 @@
 #include <QTime>
 #include <QtCore/qmath.h>
 
+#include <algorithm>
+
 #include <vtkCommand.h>
 #include <vtkImageCast.h>
 #include <vtkImageData.h>
@@ -81,6 +87,9 @@ void QExperimental3DExtension::setInput(Volume *input)
 {
     m_volume = m_normalVolume = new Experimental3DVolume(input);
 
+    m_studyInstanceUID = input->getStudy() ? input->getStudy()->getInstanceUID() : QString();
+    m_seriesInstanceUID = input->getSeries() ? input->getSeries()->getInstanceUID() : QString();
+
     m_viewer->setInput(input);
     m_viewer->setVolume(m_volume);
 
@@ -1283,6 +1292,54 @@ QString QExperimental3DExtension::getFileNameToSave(const QString &settingsDirKe
     return fileName;
 }
 
+QString QExperimental3DExtension::getDerivedVolumeKey(const QString &name, const TransferFunction &transferFunction, const QByteArray &parameters) const
+{
+    Volume *input = m_viewer->getMainInput();
+
+    if (m_seriesInstanceUID.isEmpty() || !input || m_volume != m_normalVolume)
+    {
+        return QString();
+    }
+
+    // Una sèrie pot donar més d'un volum, per això hi afegim la primera imatge i el nombre d'imatges
+    QByteArray keyData;
+    QDataStream keyStream(&keyData, QIODevice::WriteOnly);
+    keyStream << name << input->getImages().size() << m_volume->getSize() << m_volume->getRangeMax() << transferFunction << parameters;
+
+    if (!input->getImages().isEmpty())
+    {
+        keyStream << input->getImages().first()->getKeyIdentifier();
+    }
+
+    return DerivedVolumeCache::computeKey(keyData);
+}
+
+bool QExperimental3DExtension::loadDerivedVolume(const QString &key, QVector<float> &data) const
+{
+    DerivedVolumeCache cache;
+
+    if (!cache.contains(m_studyInstanceUID, m_seriesInstanceUID, key))
+    {
+        return false;
+    }
+
+    data.resize(m_volume->getSize());
+
+    if (!cache.load(m_studyInstanceUID, m_seriesInstanceUID, key, data.data(), data.size()))
+    {
+        data.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void QExperimental3DExtension::saveDerivedVolume(const QString &key, const QVector<float> &data) const
+{
+    DerivedVolumeCache cache;
+    cache.store(m_studyInstanceUID, m_seriesInstanceUID, key, data.constData(), data.size());
+}
+
 void QExperimental3DExtension::loadTransferFunction()
 {
     QString transferFunctionFileName = getFileNameToLoad(Experimental3DSettings::TransferFunctionDir, tr("Load transfer function"),
@@ -2047,8 +2104,6 @@ void QExperimental3DExtension::computeCancelObscurance()
 {
     if (!m_computingObscurance)
     {
-        m_computingObscurance = true;
-
         if (m_obscuranceCheckBox->isChecked())
         {
             m_obscuranceCheckBox->setChecked(false);
@@ -2057,8 +2112,8 @@ void QExperimental3DExtension::computeCancelObscurance()
 
         m_obscuranceCheckBox->setEnabled(false);
 
-        delete m_obscuranceMainThread;          // esborrem el thread d'abans
-        delete m_obscurance; m_obscurance = 0;  // esborrem l'obscurança d'abans
+        delete m_obscuranceMainThread; m_obscuranceMainThread = 0;  // esborrem el thread d'abans
+        delete m_obscurance; m_obscurance = 0;                      // esborrem l'obscurança d'abans
 
         int numberOfDirections;
         if (m_obscuranceViewpointDistributionWidget->isUniform())
@@ -2070,10 +2125,39 @@ void QExperimental3DExtension::computeCancelObscurance()
             numberOfDirections = m_obscuranceViewpointDistributionWidget->recursionLevel();
         }
 
-        m_obscuranceMainThread = new ObscuranceMainThread(numberOfDirections, m_obscuranceMaximumDistanceDoubleSpinBox->value(),
-                                                          static_cast<ObscuranceMainThread::Function>(m_obscuranceFunctionComboBox->currentIndex()),
-                                                          static_cast<ObscuranceMainThread::Variant>(m_obscuranceVariantComboBox->currentIndex()),
-                                                          m_obscuranceDoublePrecisionRadioButton->isChecked(), this);
+        ObscuranceMainThread::Function function = static_cast<ObscuranceMainThread::Function>(m_obscuranceFunctionComboBox->currentIndex());
+        ObscuranceMainThread::Variant variant = static_cast<ObscuranceMainThread::Variant>(m_obscuranceVariantComboBox->currentIndex());
+        bool doublePrecision = m_obscuranceDoublePrecisionRadioButton->isChecked();
+
+        // Si aquestes obscurances ja s'han calculat en una altra sessió les agafem de la cache de volums derivats
+        QByteArray parameters;
+        QDataStream parametersStream(&parameters, QIODevice::WriteOnly);
+        parametersStream << numberOfDirections << m_obscuranceMaximumDistanceDoubleSpinBox->value() << static_cast<int>(function) << static_cast<int>(variant)
+                         << doublePrecision;
+        // Les variants de densitat no depenen de la funció de transferència, i així no es tornen a calcular quan canvia
+        TransferFunction transferFunction = ObscuranceMainThread::usesOpacity(variant) ? m_transferFunctionEditor->transferFunction() : TransferFunction();
+        m_obscuranceKey = getDerivedVolumeKey("obscurance", transferFunction, parameters);
+
+        DerivedVolumeCache cache;
+        if (cache.contains(m_studyInstanceUID, m_seriesInstanceUID, m_obscuranceKey))
+        {
+            m_obscurance = new Obscurance(m_volume->getSize(), ObscuranceMainThread::hasColor(variant), doublePrecision);
+
+            if (m_obscurance->load(cache, m_studyInstanceUID, m_seriesInstanceUID, m_obscuranceKey))
+            {
+                m_obscuranceProgressBar->setValue(m_obscuranceProgressBar->maximum());
+                m_obscuranceSavePushButton->setEnabled(true);
+                m_obscuranceCheckBox->setEnabled(true);
+                return;
+            }
+
+            delete m_obscurance; m_obscurance = 0;
+        }
+
+        m_computingObscurance = true;
+
+        m_obscuranceMainThread = new ObscuranceMainThread(numberOfDirections, m_obscuranceMaximumDistanceDoubleSpinBox->value(), function, variant,
+                                                          doublePrecision, this);
         m_obscuranceMainThread->setVolume(m_volume->getVolume());
         m_obscuranceMainThread->setTransferFunction(m_transferFunctionEditor->transferFunction());
 
@@ -2101,6 +2185,9 @@ void QExperimental3DExtension::endComputeObscurance()
     m_computingObscurance = false;
 
     m_obscurance = m_obscuranceMainThread->getObscurance();
+
+    DerivedVolumeCache cache;
+    m_obscurance->save(cache, m_studyInstanceUID, m_seriesInstanceUID, m_obscuranceKey);
     m_obscurancePushButton->setText(tr("Compute obscurance"));
     m_obscuranceLoadPushButton->setEnabled(true);
     m_obscuranceSavePushButton->setEnabled(true);
@@ -2448,6 +2535,29 @@ void QExperimental3DExtension::computeSelectedVmi()
         viewpointInformationChannel.filterViewpoints(filter);
     }
 
+    // Les VoMI que ja s'han calculat en una altra sessió amb els mateixos punts de vista les agafem de la cache de volums derivats.
+    // Si alguna altra mesura les necessita es tornaran a calcular igualment.
+    QString vomiKey, vomi2Key;
+    bool vomiFromCache = false, vomi2FromCache = false;
+
+    if (!m_vmiOneViewpointCheckBox->isChecked())
+    {
+        QByteArray parameters;
+        QDataStream parametersStream(&parameters, QIODevice::WriteOnly);
+        foreach (const Vector3 &viewpoint, viewpointGenerator.viewpoints())
+        {
+            parametersStream << viewpoint.x << viewpoint.y << viewpoint.z;
+        }
+
+        vomiKey = getDerivedVolumeKey("vomi", m_transferFunctionEditor->transferFunction(), parameters);
+        vomi2Key = getDerivedVolumeKey("vomi2", m_transferFunctionEditor->transferFunction(), parameters);
+
+        vomiFromCache = computeVomi && loadDerivedVolume(vomiKey, m_vomi);
+        vomi2FromCache = computeVomi2 && loadDerivedVolume(vomi2Key, m_vomi2);
+        computeVomi = computeVomi && !vomiFromCache;
+        computeVomi2 = computeVomi2 && !vomi2FromCache;
+    }
+
     connect(&viewpointInformationChannel, SIGNAL(totalProgressMaximum(int)), m_vmiTotalProgressBar, SLOT(setMaximum(int)));
     // no sé per què però cal això perquè s'actualitzi quan toca
     connect(&viewpointInformationChannel, SIGNAL(totalProgressMaximum(int)), m_vmiTotalProgressBar, SLOT(repaint()));
@@ -2530,11 +2640,20 @@ void QExperimental3DExtension::computeSelectedVmi()
         m_saveViewpointUnstabilitiesPushButton->setEnabled(true);
     }
 
-    if (computeVomi)
+    if (computeVomi || vomiFromCache)
     {
-        m_vomi = viewpointInformationChannel.vomi();
-        m_minimumVomi = viewpointInformationChannel.minimumVomi();
-        m_maximumVomi = viewpointInformationChannel.maximumVomi();
+        if (computeVomi)
+        {
+            m_vomi = viewpointInformationChannel.vomi();
+            m_minimumVomi = viewpointInformationChannel.minimumVomi();
+            m_maximumVomi = viewpointInformationChannel.maximumVomi();
+            saveDerivedVolume(vomiKey, m_vomi);
+        }
+        else
+        {
+            m_minimumVomi = *std::min_element(m_vomi.constBegin(), m_vomi.constEnd());
+            m_maximumVomi = *std::max_element(m_vomi.constBegin(), m_vomi.constEnd());
+        }
         DEBUG_LOG(QString("range vomi1 = [%1, %2]").arg(m_minimumVomi).arg(m_maximumVomi));
         m_baseVomiRadioButton->setEnabled(true);
         m_vomiCheckBox->setEnabled(true);
@@ -2545,11 +2664,20 @@ void QExperimental3DExtension::computeSelectedVmi()
         m_vomiGradientPushButton->setEnabled(true);
     }
 
-    if (computeVomi2)
+    if (computeVomi2 || vomi2FromCache)
     {
-        m_vomi2 = viewpointInformationChannel.vomi2();
-        m_minimumVomi2 = viewpointInformationChannel.minimumVomi2();
-        m_maximumVomi2 = viewpointInformationChannel.maximumVomi2();
+        if (computeVomi2)
+        {
+            m_vomi2 = viewpointInformationChannel.vomi2();
+            m_minimumVomi2 = viewpointInformationChannel.minimumVomi2();
+            m_maximumVomi2 = viewpointInformationChannel.maximumVomi2();
+            saveDerivedVolume(vomi2Key, m_vomi2);
+        }
+        else
+        {
+            m_minimumVomi2 = *std::min_element(m_vomi2.constBegin(), m_vomi2.constEnd());
+            m_maximumVomi2 = *std::max_element(m_vomi2.constBegin(), m_vomi2.constEnd());
+        }
         DEBUG_LOG(QString("range vomi2 = [%1, %2]").arg(m_minimumVomi2).arg(m_maximumVomi2));
         m_baseVomiRadioButton->setEnabled(true);
         m_vomiCheckBox->setEnabled(true);
@@ -187,6 +187,14 @@ private:
     /// Llança un diàleg per obtenir un nom de fitxer per escriure.
     QString getFileNameToSave(const QString &settingsDirKey, const QString &caption, const QString &filter, const QString &defaultSuffix);
 
+    /// Retorna la clau amb què es desa a la cache de volums derivats el volum amb el nom donat calculat amb la funció de transferència i els paràmetres
+    /// donats. Retorna una clau buida si el volum actual no es pot desar a la cache (no ve d'una sèrie o està clusteritzat).
+    QString getDerivedVolumeKey(const QString &name, const TransferFunction &transferFunction, const QByteArray &parameters) const;
+    /// Carrega de la cache de volums derivats el volum amb la clau donada. Retorna cert si hi és.
+    bool loadDerivedVolume(const QString &key, QVector<float> &data) const;
+    /// Desa a la cache de volums derivats el volum amb la clau donada.
+    void saveDerivedVolume(const QString &key, const QVector<float> &data) const;
+
     void loadTransferFunction(const QString &fileName);
     void loadColorTransferFunction(const QString &fileName);
     void saveTransferFunction(const QString &fileName);
@@ -365,6 +373,12 @@ private:
     bool m_computingObscurance;
     ObscuranceMainThread *m_obscuranceMainThread;
     Obscurance *m_obscurance;
+    /// Clau de les obscurances a la cache de volums derivats.
+    QString m_obscuranceKey;
+
+    /// Estudi i sèrie del volum d'entrada, que identifiquen els seus volums derivats a la cache.
+    QString m_studyInstanceUID;
+    QString m_seriesInstanceUID;
 
     QVector<float> m_viewedVolume;
     float m_HV;             // H(V)
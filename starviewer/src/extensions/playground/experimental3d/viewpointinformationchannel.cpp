@@ -13,7 +13,8 @@
 
 #ifndef CUDA_AVAILABLE
 #include "mathtools.h"
-#include <QTemporaryFile>
+#include "viewpointvisibilityraycaster.h"
+#include "voxelprobabilitiesinviewstore.h"
 #else // CUDA_AVAILABLE
 #include "camera.h"
 #include "cudaviewpointinformationchannel.h"
@@ -26,6 +27,13 @@ ViewpointInformationChannel::ViewpointInformationChannel(const ViewpointGenerato
                                                          QExperimental3DViewer *viewer, const TransferFunction &transferFunction)
     : QObject(), m_viewpointGenerator(viewpointGenerator), m_volume(volume), m_viewer(viewer), m_transferFunction(transferFunction)
 {
+#ifndef CUDA_AVAILABLE
+    m_voxelProbabilitiesMemoryBudget = VoxelProbabilitiesInViewStore::DefaultMemoryBudget;
+    m_voxelProbabilitiesPerView = 0;
+#else // CUDA_AVAILABLE
+    m_voxelProbabilitiesMemoryBudget = 0;
+#endif
+
     m_backgroundColor = m_viewer->getBackgroundColor();
     m_viewpoints = m_viewpointGenerator.viewpoints();
 }
@@ -270,6 +278,11 @@ void ViewpointInformationChannel::setBestViewsParameters(bool fixedNumber, int n
     m_bestViewsThreshold = threshold;
 }
 
+void ViewpointInformationChannel::setVoxelProbabilitiesMemoryBudget(qint64 memoryBudget)
+{
+    m_voxelProbabilitiesMemoryBudget = memoryBudget;
+}
+
 void ViewpointInformationChannel::setExploratoryTourThreshold(float threshold)
 {
     m_exploratoryTourThreshold = threshold;
@@ -656,11 +669,7 @@ void ViewpointInformationChannel::computeCpu(bool computeViewProbabilities, bool
     int step = 0;
     emit totalProgress(step);
 
-    createVoxelProbabilitiesPerViewFiles();
-    if (m_voxelProbabilitiesPerViewFiles.isEmpty())
-    {
-        return; // caldria llançar alguna excepció o retornar error
-    }
+    createVoxelProbabilitiesPerViewStore();
 
     float totalViewedVolume;
 
@@ -753,60 +762,35 @@ void ViewpointInformationChannel::computeCpu(bool computeViewProbabilities, bool
         QCoreApplication::processEvents();  // necessari perquè el procés vagi fluid
     }
 
-    deleteVoxelProbabilitiesPerViewFiles();
+    deleteVoxelProbabilitiesPerViewStore();
 }
 
-void ViewpointInformationChannel::createVoxelProbabilitiesPerViewFiles()
+void ViewpointInformationChannel::createVoxelProbabilitiesPerViewStore()
 {
     DEBUG_LOG("Creem p(Z|V)");
 
-    int nViewpoints = m_viewpoints.size();
-    m_voxelProbabilitiesPerViewFiles.resize(nViewpoints);
-
-    for (int i = 0; i < nViewpoints; i++)
-    {
-        m_voxelProbabilitiesPerViewFiles[i] = new QTemporaryFile("pZvXXXXXX.tmp");    // els fitxers temporals es creen al directori de treball
-
-        if (!m_voxelProbabilitiesPerViewFiles.at(i)->open())
-        {
-            DEBUG_LOG(QString("No s'ha pogut obrir el fitxer: error %1").arg(m_voxelProbabilitiesPerViewFiles.at(i)->errorString()));
-            for (int j = 0; j < i; j++)
-            {
-                m_voxelProbabilitiesPerViewFiles.at(j)->close();
-            }
-            m_voxelProbabilitiesPerViewFiles.clear();   // el deixarem buit si hi ha hagut problemes
-            break;
-        }
-    }
+    delete m_voxelProbabilitiesPerView;
+    m_voxelProbabilitiesPerView = new VoxelProbabilitiesInViewStore(m_viewpoints.size(), m_volume->getSize(), m_voxelProbabilitiesMemoryBudget);
 }
 
 QVector<float> ViewpointInformationChannel::voxelProbabilitiesInViewCpu(int i)
 {
-    QVector<float> pZv(m_volume->getSize());
-    m_voxelProbabilitiesPerViewFiles.at(i)->reset();  // reset per tornar al principi
-    m_voxelProbabilitiesPerViewFiles.at(i)->read(reinterpret_cast<char*>(pZv.data()), pZv.size() * sizeof(float)); // llegim...
-    // ... i després fem un reset per tornar al principi i buidar el buffer (amb un peek queda el buffer ple, i es gasta molta memòria)
-    m_voxelProbabilitiesPerViewFiles.at(i)->reset();
-    return pZv;
+    return m_voxelProbabilitiesPerView->get(i);
 }
 
-void ViewpointInformationChannel::deleteVoxelProbabilitiesPerViewFiles()
+void ViewpointInformationChannel::deleteVoxelProbabilitiesPerViewStore()
 {
-    DEBUG_LOG("Destruïm p(Z|V)");
+    DEBUG_LOG(QString("Destruïm p(Z|V): %1 vistes disperses, %2 bytes en memòria, %3 bytes en fitxer")
+              .arg(m_voxelProbabilitiesPerView->getNumberOfSparseViews()).arg(m_voxelProbabilitiesPerView->getMemoryUsage())
+              .arg(m_voxelProbabilitiesPerView->getFileUsage()));
 
-    for (int i = 0; i < m_voxelProbabilitiesPerViewFiles.size(); i++)
-    {
-        m_voxelProbabilitiesPerViewFiles.at(i)->close();
-        delete m_voxelProbabilitiesPerViewFiles.at(i);
-    }
-
-    m_voxelProbabilitiesPerViewFiles.clear();
+    delete m_voxelProbabilitiesPerView;
+    m_voxelProbabilitiesPerView = 0;
 }
 
 float ViewpointInformationChannel::rayCastingCpu(bool computeViewProbabilities)
 {
     int nViewpoints = m_viewpoints.size();
-    int nVoxels = m_volume->getSize();
     double totalViewedVolume = 0.0;
 
     if (computeViewProbabilities)
@@ -817,26 +801,34 @@ float ViewpointInformationChannel::rayCastingCpu(bool computeViewProbabilities)
     emit partialProgress(0);
     QCoreApplication::processEvents();  // necessari perquè el procés vagi fluid
 
-    m_volume->startVmiMode();
+    // Els punts de vista es calculen en paral·lel, sense tocar el visor, en lots d'un punt de vista per fil per limitar la memòria
+    ViewpointVisibilityRayCaster rayCaster(m_volume->getImage(), m_transferFunction);
+    int batchSize = QThread::idealThreadCount();
 
-    for (int i = 0; i < nViewpoints; i++)
+    for (int start = 0; start < nViewpoints; start += batchSize)
     {
-        m_volume->startVmiSecondPass();
-        m_viewer->setCamera(m_viewpoints.at(i), Vector3(), m_viewpointGenerator.up(m_viewpoints.at(i)));    // render
+        QVector<ViewpointVisibilityRayCaster::View> views = rayCaster.rayCast(m_viewpoints.mid(start, batchSize));
 
-        // p(Z|V)
-        QVector<float> voxelProbabilitiesInView = m_volume->finishVmiSecondPass();  // p(Z|v)
-        m_voxelProbabilitiesPerViewFiles.at(i)->write(reinterpret_cast<const char*>(voxelProbabilitiesInView.data()), nVoxels * sizeof(float));
-
-        // p(V)
-        if (computeViewProbabilities)
+        for (int j = 0; j < views.size(); j++)
         {
-            float viewedVolume = m_volume->viewedVolumeInVmiSecondPass();
-            m_viewProbabilities[i] = viewedVolume;
-            totalViewedVolume += viewedVolume;
+            int i = start + j;
+
+            // p(Z|V)
+            if (!m_voxelProbabilitiesPerView->set(i, views.at(j).voxelProbabilities))
+            {
+                DEBUG_LOG(QString("No s'ha pogut guardar p(Z|v%1)").arg(i));
+            }
+
+            // p(V)
+            if (computeViewProbabilities)
+            {
+                float viewedVolume = views.at(j).viewedVolume;
+                m_viewProbabilities[i] = viewedVolume;
+                totalViewedVolume += viewedVolume;
+            }
         }
 
-        emit partialProgress(100 * (i + 1) / nViewpoints);
+        emit partialProgress(100 * (start + views.size()) / nViewpoints);
         QCoreApplication::processEvents();  // necessari perquè el procés vagi fluid
     }
 
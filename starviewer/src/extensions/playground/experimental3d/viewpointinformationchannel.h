@@ -9,16 +9,14 @@
 #include <QColor>
 #include <QPair>
 
-#ifndef CUDA_AVAILABLE
-class QTemporaryFile;
-#endif
-
 namespace udg {
 
 class Experimental3DVolume;
 class QExperimental3DViewer;
 
-#ifdef CUDA_AVAILABLE
+#ifndef CUDA_AVAILABLE
+class VoxelProbabilitiesInViewStore;
+#else // CUDA_AVAILABLE
 class Matrix4;
 #endif
 
@@ -39,6 +37,8 @@ public:
     void setEvmiOpacityTransferFunction(const TransferFunction &evmiOpacityTransferFunction);
     void setBestViewsParameters(bool fixedNumber, int n, float threshold);
     void setExploratoryTourThreshold(float threshold);
+    /// Sets the memory in bytes that p(Z|V) can take before the views are moved to a temporary file. Only used in the CPU implementation.
+    void setVoxelProbabilitiesMemoryBudget(qint64 memoryBudget);
 
     /// Filtra el conjunt de punts de vista que es faran servir.
     /// \a filter Vector que conté un booleà per cada punt de vista original. Es faran servir els que estiguin a cert.
@@ -93,9 +93,9 @@ private:
                     bool computeHZV, bool computeVmi, bool computeVmi2, bool computeVmi3, bool computeMi, bool computeViewpointUnstabilities, bool computeVomi,
                     bool computeVomi2, bool computeVomi3, bool computeViewpointVomi, bool computeViewpointVomi2, bool computeColorVomi, bool computeEvmiOpacity,
                     bool computeEvmiVomi, bool computeBestViews, bool computeGuidedTour, bool computeExploratoryTour);
-    void createVoxelProbabilitiesPerViewFiles();
+    void createVoxelProbabilitiesPerViewStore();
     QVector<float> voxelProbabilitiesInViewCpu(int i);
-    void deleteVoxelProbabilitiesPerViewFiles();
+    void deleteVoxelProbabilitiesPerViewStore();
     float rayCastingCpu(bool computeViewProbabilities);
     void computeViewProbabilitiesAndEntropyCpu(float totalViewedVolume, bool computeHV);
     void computeVoxelProbabilitiesAndEntropyCpu(bool computeHZ);
@@ -136,8 +136,9 @@ private:
     QColor m_backgroundColor;
     QVector<Vector3> m_viewpoints;
 
+    qint64 m_voxelProbabilitiesMemoryBudget;
 #ifndef CUDA_AVAILABLE
-    QVector<QTemporaryFile*> m_voxelProbabilitiesPerViewFiles;  // p(Z|V)
+    VoxelProbabilitiesInViewStore *m_voxelProbabilitiesPerView; // p(Z|V)
 #endif
 
     QVector<float> m_viewedVolume;          // volum vist des de cada vista
@@ -0,0 +1,198 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "viewpointvisibilityraycaster.h"
+
+#include "camera.h"
+#include "transferfunction.h"
+#include "viewpointgenerator.h"
+
+#include <QtConcurrentMap>
+
+#include <vtkImageData.h>
+
+#include <algorithm>
+
+namespace udg {
+
+namespace {
+
+/// Maximum number of samples of a ray
+const int MaximumNumberOfSteps = 512;
+/// Accumulated opacity at which a ray stops
+const float OpaqueAlpha = 0.9f;
+/// Distance between samples in world units
+const float RayStep = 1.0f;
+/// Distance from the eye to the image plane, in units of half the image
+const float ImagePlaneDistance = 3.0f;
+
+/// Intersects the ray with the box [boxMin, boxMax] and returns the parametric distances of the intersections
+bool intersectBox(const Vector3Float &origin, const Vector3Float &direction, const Vector3Float &boxMin, const Vector3Float &boxMax, float &tNear,
+                  float &tFar)
+{
+    float tMin[3], tMax[3];
+    const float origins[3] = { origin.x, origin.y, origin.z };
+    const float directions[3] = { direction.x, direction.y, direction.z };
+    const float minima[3] = { boxMin.x, boxMin.y, boxMin.z };
+    const float maxima[3] = { boxMax.x, boxMax.y, boxMax.z };
+
+    for (int i = 0; i < 3; i++)
+    {
+        float inverse = 1.0f / directions[i];
+        float tBottom = inverse * (minima[i] - origins[i]);
+        float tTop = inverse * (maxima[i] - origins[i]);
+        tMin[i] = std::min(tBottom, tTop);
+        tMax[i] = std::max(tBottom, tTop);
+    }
+
+    tNear = std::max(tMin[0], std::max(tMin[1], tMin[2]));
+    tFar = std::min(tMax[0], std::min(tMax[1], tMax[2]));
+
+    return tFar > tNear;
+}
+
+}
+
+const int ViewpointVisibilityRayCaster::DefaultImageSize = 512;
+
+ViewpointVisibilityRayCaster::ViewpointVisibilityRayCaster(vtkImageData *image, const TransferFunction &transferFunction)
+ : m_imageSize(DefaultImageSize)
+{
+    Q_ASSERT(image);
+    Q_ASSERT(image->GetScalarType() == VTK_UNSIGNED_SHORT);
+
+    m_data = static_cast<const unsigned short*>(image->GetScalarPointer());
+    image->GetDimensions(m_dimensions);
+    double *spacing = image->GetSpacing();
+    m_volumeSize = Vector3(m_dimensions[0] * spacing[0], m_dimensions[1] * spacing[1], m_dimensions[2] * spacing[2]);
+
+    int maximumValue = static_cast<int>(image->GetScalarRange()[1]);
+    m_opacities.resize(maximumValue + 1);
+    for (int i = 0; i <= maximumValue; i++)
+    {
+        m_opacities[i] = transferFunction.getOpacity(i);
+    }
+}
+
+void ViewpointVisibilityRayCaster::setImageSize(int imageSize)
+{
+    m_imageSize = qMax(2, imageSize);
+}
+
+int ViewpointVisibilityRayCaster::getImageSize() const
+{
+    return m_imageSize;
+}
+
+ViewpointVisibilityRayCaster::View ViewpointVisibilityRayCaster::rayCast(const Vector3 &viewpoint) const
+{
+    Camera camera;
+    camera.lookAt(viewpoint, Vector3(), ViewpointGenerator::up(viewpoint));
+    const Vector3Float origin(viewpoint);
+    const Vector3Float xAxis(camera.getXAxis()), yAxis(camera.getYAxis()), zAxis(camera.getZAxis());
+
+    const Vector3Float volumeSize(m_volumeSize);
+    const Vector3Float boxMax = volumeSize / 2.0;
+    const Vector3Float boxMin = -boxMax;
+    const int numberOfVoxels = m_dimensions[0] * m_dimensions[1] * m_dimensions[2];
+    const int sliceSize = m_dimensions[0] * m_dimensions[1];
+    const float *opacities = m_opacities.constData();
+    const int maximumValue = m_opacities.size() - 1;
+
+    View view;
+    view.voxelProbabilities.fill(0.0f, numberOfVoxels);
+    float *volumes = view.voxelProbabilities.data();
+    double viewedVolume = 0.0;
+
+    for (int y = 0; y < m_imageSize; y++)
+    {
+        float v = y / static_cast<float>(m_imageSize - 1) * 2.0f - 1.0f;
+
+        for (int x = 0; x < m_imageSize; x++)
+        {
+            float u = x / static_cast<float>(m_imageSize - 1) * 2.0f - 1.0f;
+
+            Vector3Float direction = u * xAxis + v * yAxis - ImagePlaneDistance * zAxis;
+            direction.normalize();
+
+            float tNear, tFar;
+            if (!intersectBox(origin, direction, boxMin, boxMax, tNear, tFar))
+            {
+                continue;
+            }
+
+            float remainingOpacity = 1.0f;
+            float t = qMax(tNear, 0.0f);
+
+            for (int i = 0; i < MaximumNumberOfSteps && t <= tFar; i++, t += RayStep)
+            {
+                // Position in [0,1]
+                Vector3Float position = origin + t * direction;
+                float px = position.x / volumeSize.x + 0.5f;
+                float py = position.y / volumeSize.y + 0.5f;
+                float pz = position.z / volumeSize.z + 0.5f;
+
+                int vx = qBound(0, static_cast<int>(px * m_dimensions[0]), m_dimensions[0] - 1);
+                int vy = qBound(0, static_cast<int>(py * m_dimensions[1]), m_dimensions[1] - 1);
+                int vz = qBound(0, static_cast<int>(pz * m_dimensions[2]), m_dimensions[2] - 1);
+                int offset = vx + vy * m_dimensions[0] + vz * sliceSize;
+
+                float opacity = opacities[qMin(static_cast<int>(m_data[offset]), maximumValue)];
+                float volume = opacity * remainingOpacity;
+
+                if (volume > 0.0f)
+                {
+                    volumes[offset] += volume;
+                    viewedVolume += volume;
+                    remainingOpacity *= 1.0f - opacity;
+
+                    if (1.0f - remainingOpacity >= OpaqueAlpha)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // The volumes are normalized in place to get p(Z|v)
+    view.viewedVolume = viewedVolume;
+    float factor = viewedVolume > 0.0 ? static_cast<float>(1.0 / viewedVolume) : 0.0f;
+    for (int i = 0; i < numberOfVoxels; i++)
+    {
+        volumes[i] *= factor;
+    }
+
+    return view;
+}
+
+QVector<ViewpointVisibilityRayCaster::View> ViewpointVisibilityRayCaster::rayCast(const QVector<Vector3> &viewpoints) const
+{
+    QVector<View> views(viewpoints.size());
+    QVector<int> indices(viewpoints.size());
+    for (int i = 0; i < indices.size(); i++)
+    {
+        indices[i] = i;
+    }
+
+    QtConcurrent::blockingMap(indices, [&](int i)
+    {
+        views[i] = rayCast(viewpoints.at(i));
+    });
+
+    return views;
+}
+
+}
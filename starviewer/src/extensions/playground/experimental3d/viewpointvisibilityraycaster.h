@@ -0,0 +1,76 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGVIEWPOINTVISIBILITYRAYCASTER_H
+#define UDGVIEWPOINTVISIBILITYRAYCASTER_H
+
+#include <QVector>
+
+#include "vector3.h"
+
+class vtkImageData;
+
+namespace udg {
+
+class TransferFunction;
+
+/**
+    Headless CPU ray caster that computes the voxel probabilities p(Z|v) of a set of viewpoints without rendering on the screen.
+
+    It's the CPU counterpart of the CUDA ray casting of the viewpoint information channel, and uses the same model: the volume is centered at the
+    origin, each viewpoint looks at the origin with ViewpointGenerator::up() as up vector, and the rays of a square image are cast with a constant
+    step of one world unit, accumulating for each voxel the volume seen through it (opacity × remaining opacity) until the ray is almost opaque.
+
+    Each viewpoint is cast in a single task and the tasks run in parallel in the global thread pool, so there are no shared accumulators.
+  */
+class ViewpointVisibilityRayCaster {
+public:
+    /// Visibility from a viewpoint
+    struct View {
+        /// p(Z|v)
+        QVector<float> voxelProbabilities;
+        /// Total volume seen from the viewpoint
+        float viewedVolume;
+    };
+
+    /// Default width and height of the image in pixels
+    static const int DefaultImageSize;
+
+    /// Creates the ray caster for the given unsigned short image and transfer function, whose opacities are tabulated once.
+    ViewpointVisibilityRayCaster(vtkImageData *image, const TransferFunction &transferFunction);
+
+    /// Sets the width and height of the image, which is the number of rays per side cast from each viewpoint.
+    void setImageSize(int imageSize);
+    int getImageSize() const;
+
+    /// Casts the rays from the given viewpoint.
+    View rayCast(const Vector3 &viewpoint) const;
+    /// Casts the rays from all the given viewpoints in parallel and returns the results in the same order.
+    /// All the results are kept in memory, so the caller should pass the viewpoints in batches if there are many.
+    QVector<View> rayCast(const QVector<Vector3> &viewpoints) const;
+
+private:
+    const unsigned short *m_data;
+    int m_dimensions[3];
+    /// Size of the volume in world units
+    Vector3 m_volumeSize;
+    /// Opacity of each value of the data
+    QVector<float> m_opacities;
+    int m_imageSize;
+};
+
+}
+
+#endif
@@ -108,6 +108,11 @@ void VmiVoxelShader2::clearViewedVolumes()
     m_objectVolumePerThread.clear();
 }
 
+bool VmiVoxelShader2::usesRemainingOpacity() const
+{
+    return true;
+}
+
 QString VmiVoxelShader2::toString() const
 {
     return "VmiVoxelShader2";
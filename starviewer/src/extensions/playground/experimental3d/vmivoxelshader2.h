@@ -43,6 +43,8 @@ public:
     /// Retorna el color corresponent al vòxel a la posició position, fent servir valors interpolats.
     HdrColor nvShade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator, float remainingOpacity,
                      const HdrColor &baseColor = HdrColor());
+    /// Retorna cert perquè acumula el volum vist amb l'opacitat restant de cada mostra.
+    virtual bool usesRemainingOpacity() const;
     /// Retorna un string representatiu del voxel shader.
     virtual QString toString() const;
 
@@ -0,0 +1,313 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "voxelprobabilitiesinviewstore.h"
+
+#include <QDir>
+
+#include <cstring>
+
+#include "logging.h"
+
+namespace udg {
+
+const qint64 VoxelProbabilitiesInViewStore::DefaultMemoryBudget = Q_INT64_C(512) * 1024 * 1024;
+
+VoxelProbabilitiesInViewStore::VoxelProbabilitiesInViewStore(int numberOfViews, int numberOfVoxels, qint64 memoryBudget)
+ : m_numberOfVoxels(numberOfVoxels), m_memoryBudget(memoryBudget), m_memoryUsage(0), m_fileUsage(0),
+   m_file(QDir::tempPath() + "/pZvXXXXXX.tmp"), m_fileMapping(0), m_fileMappingSize(0)
+{
+    View emptyView = { false, false, false, 0, QByteArray(), 0, 0 };
+    m_views.fill(emptyView, numberOfViews);
+}
+
+VoxelProbabilitiesInViewStore::~VoxelProbabilitiesInViewStore()
+{
+    if (m_fileMapping)
+    {
+        m_file.unmap(m_fileMapping);
+    }
+}
+
+int VoxelProbabilitiesInViewStore::getNumberOfViews() const
+{
+    return m_views.size();
+}
+
+int VoxelProbabilitiesInViewStore::getNumberOfVoxels() const
+{
+    return m_numberOfVoxels;
+}
+
+bool VoxelProbabilitiesInViewStore::set(int view, const QVector<float> &voxelProbabilities)
+{
+    Q_ASSERT(voxelProbabilities.size() == m_numberOfVoxels);
+
+    View &storedView = m_views[view];
+    if (storedView.stored)
+    {
+        if (storedView.inMemory)
+        {
+            m_memoryUsage -= storedView.data.size();
+            storedView.data.clear();
+        }
+        else
+        {
+            m_fileUsage -= storedView.fileSize;
+            freeFileExtent(storedView.fileOffset, storedView.fileSize);
+        }
+    }
+
+    QByteArray data;
+    encode(voxelProbabilities, storedView, data);
+    storedView.stored = true;
+
+    // An empty sparse view could be in the file too, but it's kept in memory so that it doesn't depend on the file
+    storedView.inMemory = m_memoryUsage + data.size() <= m_memoryBudget || data.isEmpty();
+    if (storedView.inMemory)
+    {
+        storedView.data = data;
+        m_memoryUsage += data.size();
+        return true;
+    }
+
+    storedView.fileOffset = writeToFile(data);
+    storedView.fileSize = data.size();
+    if (storedView.fileOffset < 0)
+    {
+        storedView.stored = false;
+        return false;
+    }
+
+    m_fileUsage += data.size();
+    return true;
+}
+
+QVector<float> VoxelProbabilitiesInViewStore::get(int view)
+{
+    QVector<float> voxelProbabilities(m_numberOfVoxels, 0.0f);
+    const View &storedView = m_views.at(view);
+
+    if (!storedView.stored)
+    {
+        return voxelProbabilities;
+    }
+
+    if (storedView.inMemory)
+    {
+        decode(storedView.data.constData(), storedView, voxelProbabilities);
+    }
+    else if (const uchar *fileMapping = getFileMapping())
+    {
+        decode(reinterpret_cast<const char*>(fileMapping + storedView.fileOffset), storedView, voxelProbabilities);
+    }
+    else
+    {
+        // Without mapping the file it's read as usual
+        m_file.seek(storedView.fileOffset);
+        QByteArray data = m_file.read(storedView.fileSize);
+        if (data.size() == storedView.fileSize)
+        {
+            decode(data.constData(), storedView, voxelProbabilities);
+        }
+        else
+        {
+            DEBUG_LOG(QString("No s'ha pogut llegir p(Z|v%1): error %2").arg(view).arg(m_file.errorString()));
+        }
+    }
+
+    return voxelProbabilities;
+}
+
+qint64 VoxelProbabilitiesInViewStore::getMemoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+qint64 VoxelProbabilitiesInViewStore::getFileUsage() const
+{
+    return m_fileUsage;
+}
+
+qint64 VoxelProbabilitiesInViewStore::getFileSize() const
+{
+    return m_file.isOpen() ? m_file.size() : 0;
+}
+
+int VoxelProbabilitiesInViewStore::getNumberOfSparseViews() const
+{
+    int numberOfSparseViews = 0;
+    foreach (const View &view, m_views)
+    {
+        if (view.stored && view.sparse)
+        {
+            numberOfSparseViews++;
+        }
+    }
+
+    return numberOfSparseViews;
+}
+
+void VoxelProbabilitiesInViewStore::encode(const QVector<float> &voxelProbabilities, View &view, QByteArray &data) const
+{
+    int numberOfValues = 0;
+    foreach (float probability, voxelProbabilities)
+    {
+        if (probability != 0.0f)
+        {
+            numberOfValues++;
+        }
+    }
+
+    // A sparse value takes an index and a value
+    view.sparse = static_cast<qint64>(numberOfValues) * (sizeof(quint32) + sizeof(float)) < static_cast<qint64>(m_numberOfVoxels) * sizeof(float);
+    view.numberOfValues = numberOfValues;
+
+    if (!view.sparse)
+    {
+        data = QByteArray(reinterpret_cast<const char*>(voxelProbabilities.constData()), m_numberOfVoxels * sizeof(float));
+        return;
+    }
+
+    // Indices first and then values, to keep each array aligned
+    data.resize(numberOfValues * (sizeof(quint32) + sizeof(float)));
+    quint32 *indices = reinterpret_cast<quint32*>(data.data());
+    float *values = reinterpret_cast<float*>(data.data() + numberOfValues * sizeof(quint32));
+    int j = 0;
+    for (int i = 0; i < m_numberOfVoxels; i++)
+    {
+        float probability = voxelProbabilities.at(i);
+        if (probability != 0.0f)
+        {
+            indices[j] = i;
+            values[j] = probability;
+            j++;
+        }
+    }
+}
+
+void VoxelProbabilitiesInViewStore::decode(const char *data, const View &view, QVector<float> &voxelProbabilities) const
+{
+    if (!view.sparse)
+    {
+        std::memcpy(voxelProbabilities.data(), data, m_numberOfVoxels * sizeof(float));
+        return;
+    }
+
+    const quint32 *indices = reinterpret_cast<const quint32*>(data);
+    const float *values = reinterpret_cast<const float*>(data + view.numberOfValues * sizeof(quint32));
+    float *probabilities = voxelProbabilities.data();
+    for (int j = 0; j < view.numberOfValues; j++)
+    {
+        probabilities[indices[j]] = values[j];
+    }
+}
+
+qint64 VoxelProbabilitiesInViewStore::writeToFile(const QByteArray &data)
+{
+    if (!m_file.isOpen() && !m_file.open())
+    {
+        DEBUG_LOG(QString("No s'ha pogut obrir el fitxer: error %1").arg(m_file.errorString()));
+        return -1;
+    }
+
+    // The file may grow, and the mapping isn't kept in sync with the writes, so it is mapped again when needed
+    if (m_fileMapping)
+    {
+        m_file.unmap(m_fileMapping);
+        m_fileMapping = 0;
+        m_fileMappingSize = 0;
+    }
+
+    qint64 size = data.size();
+    qint64 offset = m_file.size();
+    QMap<qint64, qint64>::iterator it = m_freeFileExtents.begin();
+    while (it != m_freeFileExtents.end() && it.value() < size)
+    {
+        ++it;
+    }
+
+    if (it != m_freeFileExtents.end())
+    {
+        offset = it.key();
+        qint64 remainingSize = it.value() - size;
+        m_freeFileExtents.erase(it);
+        if (remainingSize > 0)
+        {
+            m_freeFileExtents.insert(offset + size, remainingSize);
+        }
+    }
+    else if (!m_freeFileExtents.isEmpty() && (m_freeFileExtents.end() - 1).key() + (m_freeFileExtents.end() - 1).value() == offset)
+    {
+        // The last free extent is too small but it's at the end of the file, so the data starts there and the file grows only by the rest
+        offset = (m_freeFileExtents.end() - 1).key();
+        m_freeFileExtents.erase(m_freeFileExtents.end() - 1);
+    }
+
+    if (!m_file.seek(offset) || m_file.write(data) != size)
+    {
+        DEBUG_LOG(QString("No s'ha pogut escriure al fitxer: error %1").arg(m_file.errorString()));
+        freeFileExtent(offset, size);
+        return -1;
+    }
+
+    return offset;
+}
+
+void VoxelProbabilitiesInViewStore::freeFileExtent(qint64 offset, qint64 size)
+{
+    if (size <= 0)
+    {
+        return;
+    }
+
+    QMap<qint64, qint64>::iterator next = m_freeFileExtents.lowerBound(offset);
+    if (next != m_freeFileExtents.end() && offset + size == next.key())
+    {
+        size += next.value();
+        next = m_freeFileExtents.erase(next);
+    }
+
+    if (next != m_freeFileExtents.begin())
+    {
+        QMap<qint64, qint64>::iterator previous = next - 1;
+        if (previous.key() + previous.value() == offset)
+        {
+            previous.value() += size;
+            return;
+        }
+    }
+
+    m_freeFileExtents.insert(offset, size);
+}
+
+const uchar* VoxelProbabilitiesInViewStore::getFileMapping()
+{
+    if (!m_fileMapping && m_file.isOpen())
+    {
+        m_file.flush();
+        m_fileMappingSize = m_file.size();
+        m_fileMapping = m_file.map(0, m_fileMappingSize);
+        if (!m_fileMapping)
+        {
+            DEBUG_LOG(QString("No s'ha pogut mapejar el fitxer: error %1").arg(m_file.errorString()));
+            m_fileMappingSize = 0;
+        }
+    }
+
+    return m_fileMapping;
+}
+
+}
@@ -0,0 +1,105 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGVOXELPROBABILITIESINVIEWSTORE_H
+#define UDGVOXELPROBABILITIESINVIEWSTORE_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QTemporaryFile>
+#include <QVector>
+
+namespace udg {
+
+/**
+    Keeps the voxel probabilities p(Z|v) of each view of a viewpoint information channel.
+
+    Most voxels aren't seen from a given view, so each view is stored sparse (indices and values of the non-zero probabilities) when that takes
+    less space than the dense array, and dense otherwise. The encoding is lossless, so the measures don't change. The views are kept in memory
+    while they fit in the memory budget; the rest are written to a single temporary file, which is memory-mapped to read them back. The space of
+    the views that are replaced is reused for the next views written to the file.
+  */
+class VoxelProbabilitiesInViewStore {
+public:
+    /// Default memory budget in bytes
+    static const qint64 DefaultMemoryBudget;
+
+    VoxelProbabilitiesInViewStore(int numberOfViews, int numberOfVoxels, qint64 memoryBudget = DefaultMemoryBudget);
+    ~VoxelProbabilitiesInViewStore();
+
+    int getNumberOfViews() const;
+    int getNumberOfVoxels() const;
+
+    /// Stores the probabilities of the given view, which must have one value per voxel. Returns false if they couldn't be written to the file.
+    bool set(int view, const QVector<float> &voxelProbabilities);
+
+    /// Returns the probabilities of the given view, or zeros if they haven't been stored
+    QVector<float> get(int view);
+
+    /// Returns the number of bytes used in memory and in the file by the stored views
+    qint64 getMemoryUsage() const;
+    qint64 getFileUsage() const;
+    /// Returns the size of the file, which also includes the free space left by replaced views
+    qint64 getFileSize() const;
+
+    /// Returns the number of views stored sparse
+    int getNumberOfSparseViews() const;
+
+private:
+    /// Encoded probabilities of a view
+    struct View {
+        bool stored;
+        bool sparse;
+        /// True if the encoded data is in memory and false if it's in the file
+        bool inMemory;
+        /// Number of non-zero values, for sparse views
+        int numberOfValues;
+        /// Encoded data, when the view is in memory
+        QByteArray data;
+        /// Offset and size of the encoded data in the file, when the view isn't in memory
+        qint64 fileOffset;
+        qint64 fileSize;
+    };
+
+    /// Encodes the probabilities in data and fills the sparse and numberOfValues fields of view
+    void encode(const QVector<float> &voxelProbabilities, View &view, QByteArray &data) const;
+    /// Decodes the given encoded data of the view into voxelProbabilities
+    void decode(const char *data, const View &view, QVector<float> &voxelProbabilities) const;
+
+    /// Writes the data to the first free extent of the file where it fits, or at its end, and returns its offset, or -1 if it fails
+    qint64 writeToFile(const QByteArray &data);
+    /// Marks the given extent of the file as free, merging it with the adjacent free extents
+    void freeFileExtent(qint64 offset, qint64 size);
+    /// Maps the whole file in memory if it isn't already. Returns null if it can't be mapped.
+    const uchar* getFileMapping();
+
+private:
+    int m_numberOfVoxels;
+    qint64 m_memoryBudget;
+    QVector<View> m_views;
+
+    qint64 m_memoryUsage;
+    qint64 m_fileUsage;
+    /// Free extents of the file left by replaced views, as sizes indexed by offset
+    QMap<qint64, qint64> m_freeFileExtents;
+
+    QTemporaryFile m_file;
+    uchar *m_fileMapping;
+    qint64 m_fileMappingSize;
+};
+
+}
+
+#endif
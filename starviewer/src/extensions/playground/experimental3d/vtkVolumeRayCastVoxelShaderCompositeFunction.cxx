@@ -44,6 +44,7 @@ namespace udg {
 vtkStandardNewMacro( vtkVolumeRayCastVoxelShaderCompositeFunction );
 
 const float vtkVolumeRayCastVoxelShaderCompositeFunction::MINIMUM_REMAINING_OPACITY = 0.02f;
+const int vtkVolumeRayCastVoxelShaderCompositeFunction::SAMPLE_BATCH_SIZE;
 
 vtkVolumeRayCastVoxelShaderCompositeFunction::vtkVolumeRayCastVoxelShaderCompositeFunction()
 {
@@ -158,68 +159,117 @@ void vtkVolumeRayCastVoxelShaderCompositeFunction::CastRay( vtkVolumeRayCastDyna
 
     int stepsThisRay = 0, nShaders = m_voxelShaderList.size();
 
-    // For each step along the ray
-    for ( int step = 0; step < N_STEPS && remainingOpacity > MINIMUM_REMAINING_OPACITY; step++ )
-    {
-        // We've taken another step
-        stepsThisRay++;
+    // Without interpolation consecutive steps are shaded in batches, with one call per voxel shader for the whole batch, unless some voxel shader
+    // depends on the remaining opacity, which would be the same for all the samples of a batch
+    bool batchSteps = !INTERPOLATION;
+    for ( int i = 0; i < nShaders && batchSteps; i++ ) batchSteps = !m_voxelShaderList.at( i )->usesRemainingOpacity();
 
-        HdrColor color;
+    if ( batchSteps )
+    {
+        Vector3 positions[SAMPLE_BATCH_SIZE];
+        int offsets[SAMPLE_BATCH_SIZE];
+        HdrColor colors[SAMPLE_BATCH_SIZE];
 
-        if ( !INTERPOLATION )
-        {
-            int offset = voxel[0] * X_INC + voxel[1] * Y_INC + voxel[2] * Z_INC;
-            for ( int i = 0; i < nShaders; i++ ) color = m_voxelShaderList.at( i )->shade( rayPosition, offset, direction, remainingOpacity, color );
-        }
-        else if ( CLASSIFY_INTERPOLATE )
+        for ( int step = 0; step < N_STEPS && remainingOpacity > MINIMUM_REMAINING_OPACITY; )
         {
-            Vector3 positions[8];
-            int offsets[8];
-            double weights[8];
+            const int N_SAMPLES = qMin( SAMPLE_BATCH_SIZE, N_STEPS - step );
+
+            for ( int j = 0; j < N_SAMPLES; j++ )
+            {
+                positions[j] = rayPosition;
+                offsets[j] = voxel[0] * X_INC + voxel[1] * Y_INC + voxel[2] * Z_INC;
+                colors[j] = HdrColor();
+
+                // Increment our position and compute our voxel location
+                rayPosition += RAY_INCREMENT;
+                voxel[0] = qRound( rayPosition.x );
+                voxel[1] = qRound( rayPosition.y );
+                voxel[2] = qRound( rayPosition.z );
+            }
 
-            m_interpolator->getPositions( rayPosition, positions );
-            m_interpolator->getOffsetsAndWeights( rayPosition, offsets, weights );
+            for ( int i = 0; i < nShaders; i++ ) m_voxelShaderList.at( i )->shadeSamples( N_SAMPLES, positions, offsets, direction, remainingOpacity, colors );
 
-            for ( int j = 0; j < 8; j++ )
+            // The samples shaded past the end of the ray are discarded
+            for ( int j = 0; j < N_SAMPLES && remainingOpacity > MINIMUM_REMAINING_OPACITY; j++, step++ )
             {
-                HdrColor tempColor;
+                // We've taken another step
+                stepsThisRay++;
 
-                for ( int i = 0; i < nShaders; i++ )
-                    tempColor = m_voxelShaderList.at( i )->shade( positions[j], offsets[j], direction, remainingOpacity, tempColor );
+                const HdrColor &color = colors[j];
+                float f = color.alpha * remainingOpacity;
 
-                tempColor.alpha *= weights[j];
-                color += tempColor.multiplyColorBy( tempColor.alpha );
+                accumulatedRedIntensity += f * color.red;
+                accumulatedGreenIntensity += f * color.green;
+                accumulatedBlueIntensity += f * color.blue;
+                remainingOpacity *= ( 1.0f - color.alpha );
             }
         }
-        else //if ( !CLASSIFY_INTERPOLATE )
+    }
+    else
+    {
+        // For each step along the ray
+        for ( int step = 0; step < N_STEPS && remainingOpacity > MINIMUM_REMAINING_OPACITY; step++ )
         {
-            for ( int i = 0; i < nShaders; i++ ) color = m_voxelShaderList.at( i )->shade( rayPosition, direction, m_interpolator, remainingOpacity, color );
-        }
+            // We've taken another step
+            stepsThisRay++;
+
+            HdrColor color;
+
+            if ( !INTERPOLATION )
+            {
+                int offset = voxel[0] * X_INC + voxel[1] * Y_INC + voxel[2] * Z_INC;
+                for ( int i = 0; i < nShaders; i++ ) color = m_voxelShaderList.at( i )->shade( rayPosition, offset, direction, remainingOpacity, color );
+            }
+            else if ( CLASSIFY_INTERPOLATE )
+            {
+                Vector3 positions[8];
+                int offsets[8];
+                double weights[8];
+                HdrColor cornerColors[8];
+
+                m_interpolator->getPositions( rayPosition, positions );
+                m_interpolator->getOffsetsAndWeights( rayPosition, offsets, weights );
+
+                // The 8 corners are shaded with one call per voxel shader
+                for ( int i = 0; i < nShaders; i++ ) m_voxelShaderList.at( i )->shadeSamples( 8, positions, offsets, direction, remainingOpacity, cornerColors );
+
+                for ( int j = 0; j < 8; j++ )
+                {
+                    HdrColor &tempColor = cornerColors[j];
+                    tempColor.alpha *= weights[j];
+                    color += tempColor.multiplyColorBy( tempColor.alpha );
+                }
+            }
+            else //if ( !CLASSIFY_INTERPOLATE )
+            {
+                for ( int i = 0; i < nShaders; i++ ) color = m_voxelShaderList.at( i )->shade( rayPosition, direction, m_interpolator, remainingOpacity, color );
+            }
 
-        float opacity = color.alpha, f;
+            float opacity = color.alpha, f;
 
-        if ( !INTERPOLATION || !CLASSIFY_INTERPOLATE ) f = opacity * remainingOpacity;
-        else f = remainingOpacity;
+            if ( !INTERPOLATION || !CLASSIFY_INTERPOLATE ) f = opacity * remainingOpacity;
+            else f = remainingOpacity;
 
-        accumulatedRedIntensity += f * color.red;
-        accumulatedGreenIntensity += f * color.green;
-        accumulatedBlueIntensity += f * color.blue;
-        remainingOpacity *= ( 1.0f - opacity );
+            accumulatedRedIntensity += f * color.red;
+            accumulatedGreenIntensity += f * color.green;
+            accumulatedBlueIntensity += f * color.blue;
+            remainingOpacity *= ( 1.0f - opacity );
 
-        // Increment our position and compute our voxel location
-        rayPosition += RAY_INCREMENT;
+            // Increment our position and compute our voxel location
+            rayPosition += RAY_INCREMENT;
 
-        if ( !INTERPOLATION )
-        {
-            voxel[0] = qRound( rayPosition.x );
-            voxel[1] = qRound( rayPosition.y );
-            voxel[2] = qRound( rayPosition.z );
-        }
-        else
-        {
-            voxel[0] = floor( rayPosition.x );
-            voxel[1] = floor( rayPosition.y );
-            voxel[2] = floor( rayPosition.z );
+            if ( !INTERPOLATION )
+            {
+                voxel[0] = qRound( rayPosition.x );
+                voxel[1] = qRound( rayPosition.y );
+                voxel[2] = qRound( rayPosition.z );
+            }
+            else
+            {
+                voxel[0] = floor( rayPosition.x );
+                voxel[1] = floor( rayPosition.y );
+                voxel[2] = floor( rayPosition.z );
+            }
         }
     }
 
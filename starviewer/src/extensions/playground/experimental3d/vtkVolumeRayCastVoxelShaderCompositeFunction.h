@@ -81,6 +81,8 @@ protected:
 private:
     /// Opacitat mínima que ha de restar per continuar el ray casting.
     static const float MINIMUM_REMAINING_OPACITY;
+    /// Nombre de passos del raig que es pinten amb una sola crida a cada voxel shader quan no hi ha interpolació.
+    static const int SAMPLE_BATCH_SIZE = 8;
 
     vtkVolumeRayCastVoxelShaderCompositeFunction(const vtkVolumeRayCastVoxelShaderCompositeFunction&);    // Not implemented.
     void operator=(const vtkVolumeRayCastVoxelShaderCompositeFunction&);                                  // Not implemented.
@@ -0,0 +1,235 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "perfusiondeconvolver.h"
+
+#include "mathtools.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace udg {
+
+namespace {
+
+/// Below this the regularization factor and the transform of the AIF are considered null
+const double Epsilon = 1e-6;
+
+}
+
+PerfusionDeconvolver::Workspace::Workspace(const PerfusionDeconvolver &deconvolver)
+ : m_fft(0)
+{
+    if (deconvolver.m_useFft)
+    {
+        m_fft = new vnl_fft_1d<double>(deconvolver.m_numberOfSamples);
+    }
+    else
+    {
+        m_dftOutput.resize(deconvolver.m_numberOfSamples);
+    }
+    m_signal.resize(deconvolver.m_numberOfSamples);
+}
+
+PerfusionDeconvolver::Workspace::~Workspace()
+{
+    delete m_fft;
+}
+
+PerfusionDeconvolver::PerfusionDeconvolver()
+ : m_numberOfSamples(0), m_useFft(true)
+{
+}
+
+void PerfusionDeconvolver::setArterialInputFunction(const QVector<double> &aif, double regularizationFactor, double regularizationExponent)
+{
+    m_numberOfSamples = aif.size();
+    m_useFft = hasOnlySmallPrimeFactors(m_numberOfSamples);
+
+    m_twiddleFactors.clear();
+    if (!m_useFft)
+    {
+        m_twiddleFactors.resize(m_numberOfSamples);
+        for (int i = 0; i < m_numberOfSamples; i++)
+        {
+            m_twiddleFactors[i] = std::polar(1.0, -2.0 * MathTools::PiNumber * i / m_numberOfSamples);
+        }
+    }
+
+    // Omega axis of the transform for dt = 1
+    m_omega.resize(m_numberOfSamples);
+    int index = static_cast<int>(std::ceil(m_numberOfSamples / 2.0)) + 1;
+    for (int i = 0; i < m_numberOfSamples; i++)
+    {
+        if (i < index)
+        {
+            m_omega[i] = static_cast<double>(i) / (index - 1) * MathTools::PiNumber;
+        }
+        else
+        {
+            m_omega[i] = -static_cast<double>(m_numberOfSamples - i) / (index - 1) * MathTools::PiNumber;
+        }
+    }
+
+    if (m_numberOfSamples == 0)
+    {
+        m_filter.clear();
+        return;
+    }
+
+    Workspace workspace(*this);
+    std::complex<double> *aifTransform = workspace.m_signal.data();
+    for (int i = 0; i < m_numberOfSamples; i++)
+    {
+        aifTransform[i] = aif.at(i);
+    }
+    transform(aifTransform, -1, workspace);
+
+    m_filter.resize(m_numberOfSamples);
+    double regularizationSign = std::pow(-1.0, regularizationExponent);
+    for (int i = 0; i < m_numberOfSamples; i++)
+    {
+        const std::complex<double> &a = aifTransform[i];
+        if (regularizationFactor > Epsilon || std::abs(a.real()) + std::abs(a.imag()) > Epsilon)
+        {
+            double regularization = regularizationFactor * regularizationSign * std::pow(m_omega.at(i), 2.0 * regularizationExponent);
+            m_filter[i] = std::conj(a) / (a * std::conj(a) + regularization);
+        }
+        else
+        {
+            m_filter[i] = 0.0;
+        }
+    }
+}
+
+int PerfusionDeconvolver::getNumberOfSamples() const
+{
+    return m_numberOfSamples;
+}
+
+const QVector<double>& PerfusionDeconvolver::getOmega() const
+{
+    return m_omega;
+}
+
+void PerfusionDeconvolver::deconvolve(const double *tissueCurves, int numberOfCurves, double *residueFunctions, Workspace &workspace) const
+{
+    const std::complex<double> *signal = workspace.m_signal.constData();
+
+    for (int curve = 0; curve < numberOfCurves; curve++)
+    {
+        deconvolveToWorkspace(tissueCurves + curve * m_numberOfSamples, workspace);
+
+        double *residueFunction = residueFunctions + curve * m_numberOfSamples;
+        for (int i = 0; i < m_numberOfSamples; i++)
+        {
+            residueFunction[i] = signal[i].real();
+        }
+    }
+}
+
+double PerfusionDeconvolver::computeMaximumResidue(const double *tissueCurve, Workspace &workspace) const
+{
+    if (m_numberOfSamples == 0)
+    {
+        return 0.0;
+    }
+
+    deconvolveToWorkspace(tissueCurve, workspace);
+
+    const std::complex<double> *signal = workspace.m_signal.constData();
+    double maximum = signal[0].real();
+    for (int i = 1; i < m_numberOfSamples; i++)
+    {
+        maximum = qMax(maximum, signal[i].real());
+    }
+
+    return maximum;
+}
+
+void PerfusionDeconvolver::transform(std::complex<double> *signal, int direction, Workspace &workspace) const
+{
+    if (m_useFft)
+    {
+        workspace.m_fft->transform(signal, direction);
+        return;
+    }
+
+    std::complex<double> *output = workspace.m_dftOutput.data();
+    for (int k = 0; k < m_numberOfSamples; k++)
+    {
+        std::complex<double> sum = 0.0;
+        int twiddleIndex = 0;
+        for (int n = 0; n < m_numberOfSamples; n++)
+        {
+            const std::complex<double> &twiddleFactor = m_twiddleFactors.at(twiddleIndex);
+            sum += signal[n] * (direction < 0 ? twiddleFactor : std::conj(twiddleFactor));
+            twiddleIndex += k;
+            if (twiddleIndex >= m_numberOfSamples)
+            {
+                twiddleIndex -= m_numberOfSamples;
+            }
+        }
+        output[k] = sum;
+    }
+
+    std::copy(output, output + m_numberOfSamples, signal);
+}
+
+void PerfusionDeconvolver::deconvolveToWorkspace(const double *tissueCurve, Workspace &workspace) const
+{
+    std::complex<double> *signal = workspace.m_signal.data();
+    for (int i = 0; i < m_numberOfSamples; i++)
+    {
+        signal[i] = tissueCurve[i];
+    }
+
+    transform(signal, -1, workspace);
+
+    const std::complex<double> *filter = m_filter.constData();
+    for (int i = 0; i < m_numberOfSamples; i++)
+    {
+        signal[i] *= filter[i];
+    }
+
+    transform(signal, 1, workspace);
+
+    double normalization = 1.0 / m_numberOfSamples;
+    for (int i = 0; i < m_numberOfSamples; i++)
+    {
+        signal[i] *= normalization;
+    }
+}
+
+bool PerfusionDeconvolver::hasOnlySmallPrimeFactors(int number)
+{
+    if (number < 1)
+    {
+        return false;
+    }
+
+    const int factors[] = { 2, 3, 5 };
+    for (int i = 0; i < 3; i++)
+    {
+        while (number % factors[i] == 0)
+        {
+            number /= factors[i];
+        }
+    }
+
+    return number == 1;
+}
+
+}
@@ -0,0 +1,92 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGPERFUSIONDECONVOLVER_H
+#define UDGPERFUSIONDECONVOLVER_H
+
+#include <QVector>
+
+#include <complex>
+
+#include <vnl/algo/vnl_fft_1d.h>
+
+namespace udg {
+
+/**
+    Deconvolves tissue concentration curves by the arterial input function (AIF) in the frequency domain, with the same regularization as the
+    original perfusion calculation: R = T · conj(A) / (|A|² + λ·(-1)^e·ω^(2e)), where A and T are the Fourier transforms of the AIF and the tissue curve.
+
+    The AIF is transformed once and the whole filter is precomputed, so deconvolving a curve is a forward FFT, a complex product per frequency and an
+    inverse FFT. The FFTs are done with vnl_fft_1d, the same implementation used by the ITK filters, when the number of samples only has 2, 3 and 5 as
+    prime factors, and with a direct DFT with tabulated twiddle factors otherwise.
+
+    The deconvolver is read-only once the AIF is set and can be shared between threads; each thread needs its own Workspace.
+  */
+class PerfusionDeconvolver {
+public:
+    /// Buffers and FFT plan reused between curves by a thread
+    class Workspace {
+    public:
+        explicit Workspace(const PerfusionDeconvolver &deconvolver);
+        ~Workspace();
+
+    private:
+        friend class PerfusionDeconvolver;
+
+        vnl_fft_1d<double> *m_fft;
+        QVector<std::complex<double> > m_signal;
+        QVector<std::complex<double> > m_dftOutput;
+    };
+
+    PerfusionDeconvolver();
+
+    /// Sets the AIF and the regularization factor (λ) and exponent (e), and precomputes the filter
+    void setArterialInputFunction(const QVector<double> &aif, double regularizationFactor, double regularizationExponent);
+
+    /// Returns the number of samples of the curves
+    int getNumberOfSamples() const;
+
+    /// Returns the angular frequency of each sample of the transforms, for a sampling interval of 1
+    const QVector<double>& getOmega() const;
+
+    /// Deconvolves numberOfCurves tissue curves stored one after the other and writes the residue functions in the same layout
+    void deconvolve(const double *tissueCurves, int numberOfCurves, double *residueFunctions, Workspace &workspace) const;
+
+    /// Deconvolves the tissue curve and returns the maximum of the residue function
+    double computeMaximumResidue(const double *tissueCurve, Workspace &workspace) const;
+
+private:
+    /// Transforms the signal in place. Direction -1 is the forward transform and +1 the inverse one, without normalization.
+    void transform(std::complex<double> *signal, int direction, Workspace &workspace) const;
+
+    /// Deconvolves a curve leaving the residue function in the signal of the workspace
+    void deconvolveToWorkspace(const double *tissueCurve, Workspace &workspace) const;
+
+    /// Returns true if the given number only has 2, 3 and 5 as prime factors
+    static bool hasOnlySmallPrimeFactors(int number);
+
+private:
+    int m_numberOfSamples;
+    bool m_useFft;
+    QVector<double> m_omega;
+    /// conj(A) / (|A|² + λ·(-1)^e·ω^(2e)) for each frequency
+    QVector<std::complex<double> > m_filter;
+    /// exp(-2πik/N) for the direct DFT
+    QVector<std::complex<double> > m_twiddleFactors;
+};
+
+}
+
+#endif
@@ -11,22 +11,17 @@
 #include "logging.h"
 #include "series.h"
 #include "volume.h"
-#include "mathtools.h" // pel PI
 
 // Qt
 #include <QTime>
 #include <QPair>
+#include <QtConcurrentMap>
 // VTK
 #include <vtkMultiThreader.h>
 // ITK
 #include <itkCastImageFilter.h>
-#include <itkVnlForwardFFTImageFilter.h>
-#include <itkVnlInverseFFTImageFilter.h>
 
-//Fourier Transform
-//#include <fftw3.h>
-//#include <complex>
-#include <cmath> // pel ceil
+#include <cmath>
 
 namespace udg {
 
@@ -646,8 +641,7 @@ void PerfusionMapCalculatorMainThread::findAIF()
         m_aif[t] = deltaRImage->GetPixel(indexTemp);
     }
 
-    this->fftAIF();
-    this->getOmega();
+    m_deconvolver.setArterialInputFunction(m_aif, reg_fact, reg_exp);
 }
 
 void PerfusionMapCalculatorMainThread::updateAIF()
@@ -671,9 +665,7 @@ void PerfusionMapCalculatorMainThread::updateAIF()
     double m1aif,m2aif;
     this->computeMomentsVoxel(m_aif, m_m0aif,m1aif,m2aif);
     //std::cout<<"m_m0aif="<<m_m0aif<<", m1aif="<<m1aif<<", m2aif="<<m2aif<<std::endl;
-    this->fftAIF();
-    //std::cout<<"End fftAIF"<<std::endl;
-    this->getOmega();
+    m_deconvolver.setArterialInputFunction(m_aif, reg_fact, reg_exp);
     //std::cout<<"End Update!!"<<std::endl;
 }
 
@@ -716,126 +708,72 @@ void PerfusionMapCalculatorMainThread::computePerfusion()
     map2Image->SetRegions(region);
     map2Image->Allocate();
 
-    //With threads!!!
-/*
-    int numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();  /// \todo QThread::idealThreadCount() amb Qt >= 4.3
-    //numberOfThreads = 1;
-    std::cout<<"Number of threads = "<<numberOfThreads<<std::endl;
-    QVector<PerfusionMapCalculatorThread *> threads(numberOfThreads);
+    // Cada llesca es calcula en paral·lel; les corbes temporals d'una fila de vòxels són contigües a deltaRImage
     int iend = m_DSCVolume->getDimensions()[0];
     int jend = m_DSCVolume->getDimensions()[1];
     int kend = m_DSCVolume->getNumberOfSlicesPerPhase();
     int tend = m_DSCVolume->getNumberOfPhases();
+    Q_ASSERT(tend == m_deconvolver.getNumberOfSamples());
 
-    for (int i = 0; i < numberOfThreads; i++)
+    QVector<int> slices(kend);
+    for (int k = 0; k < kend; k++)
     {
-        PerfusionMapCalculatorThread * thread = new PerfusionMapCalculatorThread(i, numberOfThreads);
-        thread->setVolumeSize(iend, jend, kend, tend);
-        thread->setCheckImage(checkImage);
-        thread->setDeltaRImage(deltaRImage);
-        thread->setm0Aif(m_m0aif);
-        thread->setFFTAif(fftaifreal,fftaifimag);
-        thread->setOmega(omega);
-        thread->setm0Image(m0Image);
-        thread->setCBVImage(cbvImage);
-        thread->setCBFImage(cbfImage);
-        thread->setMTTImage(mttImage);
-        thread->setCBVMapImage(map0Image);
-        thread->setCBFMapImage(map2Image);
-        thread->setMTTMapImage(map1Image);
-        thread->setPerfusionImageMode();
-        threads[i] = thread;
+        slices[k] = k;
     }
 
-    // iniciem els threads
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        PerfusionMapCalculatorThread * thread = threads[j];
-        thread->start();
-        //thread->runPerfusionImage();
-    }
-
-    // esperem que acabin els threads
-    for (int j = 0; j < numberOfThreads; j++)
-    {
-        threads[j]->wait();
-    }
-    for (int j = 0; j < numberOfThreads; j++)
+    QtConcurrent::blockingMap(slices, [&](int k)
     {
-        delete threads[j];
-    }
-
-*/
-  
-    //std::cout<<"Init Bucle"<<std::endl;
-    //Init com estava abans!!!!!!!!!!
-    int i,j,k,t;
-    int iend = m_DSCVolume->getDimensions()[0];
-    int jend = m_DSCVolume->getDimensions()[1];
-    int kend = m_DSCVolume->getNumberOfSlicesPerPhase();
-    int tend = m_DSCVolume->getNumberOfPhases();
-    Volume::ItkImageType::IndexType index;
-    double max;
-    double valueCbv, valueCbf, valueMtt;
-
-    QVector<  double > timeseries(m_aif.size());
-    QVector<  double > residueFunction(m_aif.size());
-
-    typedef itk::ImageRegionIterator<DoubleTemporalImageType> DoubleTempIterator;
-    DoubleTempIterator imIter(deltaRImage, deltaRImage->GetBufferedRegion());
-    imIter.GoToBegin();
+        PerfusionDeconvolver::Workspace workspace(m_deconvolver);
+        Volume::ItkImageType::IndexType index;
+        DoubleTemporalImageType::IndexType indexTemp;
+        index[2] = k;
+        indexTemp[0] = 0;
+        indexTemp[3] = k;
 
-    for (k=0;k<kend;k++)
-    {
-        index[2]=k;
-        for (j=0;j<jend;j++)
+        for (int j = 0; j < jend; j++)
         {
-            index[1]=j;
-            for (i=0;i<iend;i++)
+            index[0] = 0;
+            index[1] = j;
+            indexTemp[1] = 0;
+            indexTemp[2] = j;
+
+            const double *timeseries = deltaRImage->GetBufferPointer() + deltaRImage->ComputeOffset(indexTemp);
+            const bool *check = checkImage->GetBufferPointer() + checkImage->ComputeOffset(index);
+            const double *m0 = m0Image->GetBufferPointer() + m0Image->ComputeOffset(index);
+            double *cbv = cbvImage->GetBufferPointer() + cbvImage->ComputeOffset(index);
+            double *cbf = cbfImage->GetBufferPointer() + cbfImage->ComputeOffset(index);
+            double *mtt = mttImage->GetBufferPointer() + mttImage->ComputeOffset(index);
+            Volume::ItkImageType::PixelType *map0 = map0Image->GetBufferPointer() + map0Image->ComputeOffset(index);
+            Volume::ItkImageType::PixelType *map1 = map1Image->GetBufferPointer() + map1Image->ComputeOffset(index);
+            Volume::ItkImageType::PixelType *map2 = map2Image->GetBufferPointer() + map2Image->ComputeOffset(index);
+
+            for (int i = 0; i < iend; i++, timeseries += tend)
             {
-                index[0]=i;
-                if(checkImage->GetPixel(index))
+                if (check[i])
                 {
-                    for (t=0;t<tend;t++)
-                    {
-                        timeseries[t] = imIter.Get();
-                        ++imIter;
-                    }
-                    this->deconvolve(timeseries, residueFunction);
-                    max=residueFunction[0];
-                    for (t=1;t<tend;t++)
-                    {
-                        if(residueFunction[t] > max)
-                        {
-                            max = residueFunction[t];
-                        }
-                    }
-                    valueCbv = 100*0.7*m0Image->GetPixel(index)/m_m0aif; //in ml/100g --> Peter dixit!!
-                    valueCbf = max*100*60*0.7/TR; //ml/100g*min --> Peter dixit!!
-                    valueMtt = (60*valueCbv)/valueCbf; // TR (in sec.)
-                    cbvImage->SetPixel(index, 10.0*valueCbv);   //JUST FOR A GOOD VISUALIZATION!!!!!!
-                    map0Image->SetPixel(index, (int)(10*valueCbv));
-                    cbfImage->SetPixel(index, valueCbf);
-                    map1Image->SetPixel(index, (int)(valueCbf));
-                    mttImage->SetPixel(index, 10.0*valueMtt);   //JUST FOR A GOOD VISUALIZATION!!!!!!
-                    map2Image->SetPixel(index, (int)(10*valueMtt));
+                    double max = m_deconvolver.computeMaximumResidue(timeseries, workspace);
+                    double valueCbv = 100*0.7*m0[i]/m_m0aif; //in ml/100g --> Peter dixit!!
+                    double valueCbf = max*100*60*0.7/TR; //ml/100g*min --> Peter dixit!!
+                    double valueMtt = (60*valueCbv)/valueCbf; // TR (in sec.)
+                    cbv[i] = 10.0*valueCbv;   //JUST FOR A GOOD VISUALIZATION!!!!!!
+                    map0[i] = (int)(10*valueCbv);
+                    cbf[i] = valueCbf;
+                    map1[i] = (int)(valueCbf);
+                    mtt[i] = 10.0*valueMtt;   //JUST FOR A GOOD VISUALIZATION!!!!!!
+                    map2[i] = (int)(10*valueMtt);
                 }
                 else
                 {
-                    cbvImage->SetPixel(index, 0.0);
-                    cbfImage->SetPixel(index, 0.0);
-                    mttImage->SetPixel(index, 0.0);
-                    map0Image->SetPixel(index, 0);
-                    map1Image->SetPixel(index, 0);
-                    map2Image->SetPixel(index, 0);
-                    for (t=0;t<tend;t++)
-                    {
-                       ++imIter;
-                    }
+                    cbv[i] = 0.0;
+                    cbf[i] = 0.0;
+                    mtt[i] = 0.0;
+                    map0[i] = 0;
+                    map1[i] = 0;
+                    map2[i] = 0;
                 }
             }
         }
-    }
+    });
 
     //std::cout<<"End Bucle"<<std::endl;
 
@@ -869,248 +807,6 @@ void PerfusionMapCalculatorMainThread::computePerfusion()
     DEBUG_LOG(QString("-- TEMPS PINTANT Perfusion : %1ms ").arg(time2));
 }
 
-void PerfusionMapCalculatorMainThread::fftAIF()
-{
-    fftaifreal = QVector<double>(m_aif.size());
-    fftaifimag = QVector<double>(m_aif.size());
-//     //Usant les fftw
-//     std::cout<<"Usant fftw"<<std::endl;
-//     std::cout<<"Size: "<<std::endl;
-//     std::cout<<aif.size()<<std::endl;
-//
-//     fftw_complex* in;
-//     fftw_complex* out;
-//
-//     in = new fftw_complex[aif.size()];
-//     out = new fftw_complex[aif.size()];
-//
-//     fftw_plan pf;
-//
-//     pf = fftw_plan_dft_1d(aif.size(), in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-//
-//     int i;
-//     for(i=0;i<aif.size();i++)
-//     {
-//         in[i][0]=aif[i];
-//         in[i][1]=0.0;
-//     }
-//     fftw_execute(pf);
-//     for(i=0;i<aif.size();i++)
-//     {
-//         fftaifreal[i]=out[i][0];
-//         fftaifimag[i]=out[i][1];
-//     }
-//
-//     fftw_destroy_plan(pf);
-//     free(in);
-//     free(out);
-
-
-    //Usant itk's
-    //std::cout<<"Usant itk's"<<std::endl;
-    typedef itk::Image< double, 1 > VectorImageType;
-    VectorImageType::RegionType region;
-    VectorImageType::IndexType start;
-    start[0]=0;
-    VectorImageType::SizeType size;
-    size[0] = m_aif.size();  //les mostres temporals
-    region.SetSize(size);
-    region.SetIndex(start);
-
-    VectorImageType::Pointer aifImage = VectorImageType::New();
-    aifImage->SetRegions(region);
-    aifImage->Allocate();
-
-    typedef itk::ImageRegionIterator<VectorImageType> VectorIterator;
-    VectorIterator aifIter(aifImage, aifImage->GetBufferedRegion());
-
-    typedef itk::VnlForwardFFTImageFilter< VectorImageType >  FFTFilterType;
-    FFTFilterType::Pointer fftFilter = FFTFilterType::New();
-
-    int i;
-    aifIter.GoToBegin();
-    for(i=0;i<m_aif.size();i++)
-    {
-        aifIter.Set(m_aif[i]);
-        ++aifIter;
-    }
-
-    fftFilter->SetInput(aifImage);
-
-    try
-        {
-        fftFilter->Update();
-        }
-    catch(itk::ExceptionObject & excp)
-        {
-        DEBUG_LOG(QString("Exception caught ! %1").arg(excp.GetDescription()));
-        return;
-        }
-
-    typedef itk::ImageRegionIterator<FFTFilterType::OutputImageType> ComplexIterator;
-    ComplexIterator fftaifIter(fftFilter->GetOutput(), fftFilter->GetOutput()->GetBufferedRegion());
-    fftaifIter.GoToBegin();
-
-    for(i=0;i<m_aif.size();i++)
-    {
-        fftaifreal[i]=fftaifIter.Get().real();
-        fftaifimag[i]=fftaifIter.Get().imag();
-        ++fftaifIter;
-    }
-}
-
-void PerfusionMapCalculatorMainThread::deconvolve(QVector<double> tissue, QVector<double>& residuefunc)
-{
-    typedef std::complex<double> complexd;
-    complexd num1, num2, num3;
-
-//     //Usant fftw
-//     fftw_complex* in;
-//     fftw_complex* out;
-//
-//     in = new fftw_complex[tissue.size()];
-//     out = new fftw_complex[tissue.size()];
-//
-//     fftw_plan pf, pb;
-//
-//     pf = fftw_plan_dft_1d(tissue.size(), in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-//     pb = fftw_plan_dft_1d(tissue.size(), in, out, FFTW_BACKWARD, FFTW_ESTIMATE);
-//
-//     int i;
-//     for(i=0;i<tissue.size();i++)
-//     {
-//         in[i][0]=tissue[i];
-//         in[i][1]=0.0;
-//     }
-//
-//     fftw_execute(pf);
-//
-//     for(i=0;i<tissue.size();i++)
-//     {
-//         num1=complexd(fftaifreal[i],fftaifimag[i]);
-//         num2=complexd(out[i][0],out[i][1]);
-//
-//         if((reg_fact > 1e-6) || ((fabs(num1.real()) + fabs(num1.imag()))> 1e-6))
-//         {
-//             num3 = num2* (conj(num1) / (num1*conj(num1) + reg_fact*pow(-1,reg_exp)*pow(omega[i],2*reg_exp)));
-//             in[i][0] = num3.real();
-//             in[i][1] = num3.imag();
-//         }
-//         else
-//         {
-//             in[i][0] = 0.0;
-//             in[i][1] = 0.0;
-//         }
-//     }
-//     fftw_execute(pb);
-//     for(i=0;i<tissue.size();i++)
-//     {
-//         residuefunc[i]=out[i][0]/tissue.size();
-//     }
-//     fftw_destroy_plan(pf);
-//     fftw_destroy_plan(pb);
-//     free(in);
-//     free(out);
-
-    //Usant itk's
-    //std::cout<<"Usant itk's"<<std::endl;
-    typedef itk::Image< double, 1 > VectorImageType;
-    VectorImageType::RegionType region;
-    VectorImageType::IndexType start;
-    start[0]=0;
-    VectorImageType::SizeType size;
-    size[0] = m_aif.size();  //les mostres temporals
-    region.SetSize(size);
-    region.SetIndex(start);
-
-    VectorImageType::Pointer tissueImage = VectorImageType::New();
-    tissueImage->SetRegions(region);
-    tissueImage->Allocate();
-
-    typedef itk::ImageRegionIterator<VectorImageType> VectorIteratorType;
-    VectorIteratorType tissueIter(tissueImage, tissueImage->GetBufferedRegion());
-
-    typedef itk::VnlForwardFFTImageFilter< VectorImageType >  FFTFilterType;
-    FFTFilterType::Pointer fftFilter = FFTFilterType::New();
-
-    int i;
-    tissueIter.GoToBegin();
-
-    for(i=0;i<tissue.size();i++)
-    {
-        tissueIter.Set(tissue[i]);
-        ++tissueIter;
-    }
-    fftFilter->SetInput(tissueImage);
-
-    try
-        {
-        fftFilter->Update();
-        }
-    catch(itk::ExceptionObject & excp)
-        {
-        DEBUG_LOG(QString("Exception caught ! %1").arg(excp.GetDescription()));
-        return;
-        }
-
-    typedef FFTFilterType::OutputImageType ComplexImageType;
-    ComplexImageType::Pointer residualFFTImage = ComplexImageType::New();
-    residualFFTImage->SetRegions(region);
-    residualFFTImage->Allocate();
-
-    typedef itk::ImageRegionIterator<ComplexImageType> ComplexIteratorType;
-    ComplexIteratorType fftTissueIter(fftFilter->GetOutput(), fftFilter->GetOutput()->GetBufferedRegion());
-    fftTissueIter.GoToBegin();
-
-    ComplexIteratorType fftResidualIter(residualFFTImage, residualFFTImage->GetBufferedRegion());
-    fftResidualIter.GoToBegin();
-
-    for(i=0;i<tissue.size();i++)
-    {
-        num1=complexd(fftaifreal[i],fftaifimag[i]);
-        num2=complexd(fftTissueIter.Get().real(),fftTissueIter.Get().imag());
-
-        if((reg_fact > 1e-6) || ((fabs(num1.real()) + fabs(num1.imag()))> 1e-6))
-        {
-            num3 = num2* (conj(num1) / (num1*conj(num1) + reg_fact*pow(-1,reg_exp)*pow(omega[i],2*reg_exp)));
-            fftResidualIter.Set(num3);
-        }
-        else
-        {
-            num3 = complexd(0.0, 0.0);
-            fftResidualIter.Set(num3);
-        }
-        ++fftTissueIter;
-        ++fftResidualIter;
-    }
-
-    typedef itk::VnlInverseFFTImageFilter< ComplexImageType >  IFFTFilterType;
-    IFFTFilterType::Pointer fftInverseFilter = IFFTFilterType::New();
-    fftInverseFilter->SetInput(residualFFTImage);
-
-    try
-        {
-        fftInverseFilter->Update();
-        }
-    catch(itk::ExceptionObject & excp)
-        {
-        DEBUG_LOG(QString("Exception caught ! %1").arg(excp.GetDescription()));
-        return;
-        }
-
-    VectorIteratorType residualIter(fftInverseFilter->GetOutput(), fftInverseFilter->GetOutput()->GetBufferedRegion());
-    residualIter.GoToBegin();
-
-    for(i=0;i<tissue.size();i++)
-    {
-        //if(residuefunc[i]!=residualIter.Get()) std::cout<<"Resultat residuefunc diferent: "<<residuefunc[i]<<" ," <<residualIter.Get()/tissue.size()<<std::endl;
-
-        residuefunc[i]=residualIter.Get();
-        ++residualIter;
-    }
-
-}
-
 void PerfusionMapCalculatorMainThread::computeMomentsVoxel(QVector<double> v, double &m0, double &m1, double &m2)
 {
     int i;
@@ -1155,29 +851,4 @@ void PerfusionMapCalculatorMainThread::computeMomentsVoxel(QVector<double> v, do
 
 }
 
-void PerfusionMapCalculatorMainThread::getOmega()
-{
-    //! returns omega axis for fft for dt=1
-    omega = QVector<double>(m_aif.size());
-
-    int i, index;
-    double  omega_max;
-
-    omega_max = MathTools::PiNumber; // divide omega by Delta t for scaling according to sampling
-
-    index = static_cast<int>(ceil(m_aif.size()/2.0)) + 1;
-
-    for(i=0; i<index; i++)
-    {
-        omega[i] = (double)i/(double)(index-1)*omega_max;
-    }
-    for(i=index; i<m_aif.size(); i++)
-    {
-        omega[i] = -(double)(m_aif.size()-i)/(double)(index-1)*omega_max;
-    }
-
-    return;
-}
-
-
 }
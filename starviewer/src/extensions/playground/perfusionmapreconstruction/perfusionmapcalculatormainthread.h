@@ -8,6 +8,8 @@
 #ifndef UDGPERFUSIONMAPCALCULATORMAINTHREAD_H
 #define UDGPERFUSIONMAPCALCULATORMAINTHREAD_H
 
+#include "perfusiondeconvolver.h"
+
 #include <itkImage.h>
 
 #include <QThread>
@@ -73,10 +75,7 @@ private:
     void computeMomentsVoxel(QVector<double> v, double &m0, double &m1, double &m2);
     void findAIF();
     void updateAIF();
-    void fftAIF();
-    void getOmega();
     void computePerfusion();
-    void deconvolve(QVector<double> tissue, QVector<double>& residuefunc);
     void changeMap(int value);
 
 
@@ -99,9 +98,8 @@ private:
     QVector<double> m_aif;
     QVector<int> m_aifIndex;
     double m_m0aif;
-    QVector<double> fftaifreal;
-    QVector<double> fftaifimag;
-    QVector<double> omega;
+    /// Deconvolució per la AIF, que es transforma només quan canvia
+    PerfusionDeconvolver m_deconvolver;
 
     QVector<QVector<double> > m_meanseries;
 
@@ -10,15 +10,19 @@ HEADERS += qperfusionmapreconstructionextension.h \
            perfusionmapreconstructionsettings.h \
            perfusionmapcalculatorthread.h \
            perfusionmapcalculatormainthread.h \
+           perfusiondeconvolver.h \
            qgraphicplotwidget.h
 SOURCES += qperfusionmapreconstructionextension.cpp \
            perfusionmapreconstructionextensionmediator.cpp  \
            perfusionmapreconstructionsettings.cpp \
            perfusionmapcalculatorthread.cpp \
            perfusionmapcalculatormainthread.cpp \
+           perfusiondeconvolver.cpp \
            qgraphicplotwidget.cpp
 RESOURCES += perfusionmapreconstruction.qrc
 
+QT += concurrent
+
 EXTENSION_DIR = $$PWD
 include(../../basicconfextensions.pri)
 
@@ -6,6 +6,7 @@ namespace udg {
 const QString KeyPrefix("StarViewer-App-PerfusionMapReconstruction/");
 const QString PerfusionMapReconstructionSettings::HorizontalSplitterGeometry(KeyPrefix + "horizontalSplitter");
 const QString PerfusionMapReconstructionSettings::VerticalSplitterGeometry(KeyPrefix + "verticalSplitter");
+const QString PerfusionMapReconstructionSettings::SavedCurvesPath(KeyPrefix + "savingCurvesDirectory");
 
 PerfusionMapReconstructionSettings::PerfusionMapReconstructionSettings()
 {
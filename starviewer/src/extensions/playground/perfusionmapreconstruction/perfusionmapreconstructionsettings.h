@@ -16,6 +16,7 @@ public:
     /// Declaració de claus
     static const QString HorizontalSplitterGeometry;
     static const QString VerticalSplitterGeometry;
+    static const QString SavedCurvesPath;
 };
 
 } // end namespace udg 
@@ -43,6 +43,8 @@
 #include <QDataStream>
 #include <QDir>
 #include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QMultiMap>
 #include <QTextStream>
 // VTK
@@ -146,6 +148,7 @@ void QPerfusionMapReconstructionExtension::createConnections()
   //connect(m_2DView->getViewer(), SIGNAL(volumeChanged(Volume *)), SLOT(setInput(Volume *)));
   connect(m_chooseDSCPushButton, SIGNAL(clicked()), SLOT(contextMenuDSCRelease()));
   connect(m_computePerfusionPushButton, SIGNAL(clicked()), SLOT(computePerfusionMap()));
+  connect(m_saveROICurvesPushButton, SIGNAL(clicked()), SLOT(saveROICurves()));
   //connect(m_filterPushButton, SIGNAL(clicked()), SLOT(applyFilterMapImage()));
   connect(m_mapViewComboBox, SIGNAL(currentIndexChanged (int)), SLOT(changeMap(int)));
   connect(m_mapCalculator, SIGNAL(computed()), SLOT(paintMap()));
@@ -1127,6 +1130,32 @@ void QPerfusionMapReconstructionExtension::paintROIData()
     }*/
 }
 
+void QPerfusionMapReconstructionExtension::saveROICurves()
+{
+    Tool *roiTool = m_2DView->getViewer()->getToolProxy()->getTool("PolylineTemporalROITool");
+    PolylineTemporalROIToolData *data = roiTool ? static_cast<PolylineTemporalROIToolData*>(roiTool->getToolData()) : 0;
+    if (!data || data->getCurves().numberOfVoxels == 0)
+    {
+        QMessageBox::information(this, tr("Save ROI Curves"), tr("Draw a ROI to compute its time-activity curves before saving them."));
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save ROI Curves"), m_savingCurvesDirectory, tr("CSV Files (*.csv)"));
+    if (!fileName.isEmpty())
+    {
+        if (QFileInfo(fileName).suffix() != "csv")
+        {
+            fileName += ".csv";
+        }
+
+        m_savingCurvesDirectory = QFileInfo(fileName).absolutePath();
+        if (!data->saveCurvesCsv(fileName))
+        {
+            QMessageBox::warning(this, tr("Save ROI Curves"), tr("The curves could not be saved to %1.").arg(fileName));
+        }
+    }
+}
+
 void QPerfusionMapReconstructionExtension::leftButtonEventHandler()
 {
     m_isLeftButtonPressed = true;
@@ -1205,6 +1234,7 @@ void QPerfusionMapReconstructionExtension::readSettings()
 
     settings.restoreGeometry(PerfusionMapReconstructionSettings::HorizontalSplitterGeometry, m_horizontalSplitter);
     settings.restoreGeometry(PerfusionMapReconstructionSettings::VerticalSplitterGeometry, m_verticalSplitter);
+    m_savingCurvesDirectory = settings.getValue(PerfusionMapReconstructionSettings::SavedCurvesPath).toString();
 }
 
 void QPerfusionMapReconstructionExtension::writeSettings()
@@ -1213,6 +1243,7 @@ void QPerfusionMapReconstructionExtension::writeSettings()
 
     settings.saveGeometry(PerfusionMapReconstructionSettings::HorizontalSplitterGeometry, m_horizontalSplitter);
     settings.saveGeometry(PerfusionMapReconstructionSettings::VerticalSplitterGeometry, m_verticalSplitter);
+    settings.setValue(PerfusionMapReconstructionSettings::SavedCurvesPath, m_savingCurvesDirectory);
 }
 
 }
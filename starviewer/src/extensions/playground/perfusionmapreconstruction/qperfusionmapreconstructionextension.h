@@ -93,6 +93,9 @@ private slots:
     /// pinta les dades de la ROI
     void paintROIData();
 
+    /// Desa les corbes temporals de la ROI en un fitxer CSV escollit per l'usuari
+    void saveROICurves();
+
     /// gestiona els events del botó esquerre
     void leftButtonEventHandler();
 
@@ -134,6 +137,9 @@ private:
 
     //DeltaR mitjana per cada llesca
     QVector<QVector<double> > m_meanseries;
+
+    /// Directori on es desen les corbes de la ROI
+    QString m_savingCurvesDirectory;
 };
 
 } // end namespace udg
@@ -46,6 +46,7 @@
 #include <QMessageBox>
 
 #include "logging.h"
+#include "segmentationprimitives.h"
 
 namespace udg {
 
@@ -456,8 +457,6 @@ void rectumSegmentationMethod::applyMethodNextSlice(unsigned int slice, int step
     regionThreshold->SetOrigin(ThresholdFilter->GetOutput()->GetOrigin());
     regionThreshold->Allocate();
 
-    itk::ImageRegionIteratorWithIndex< InternalImageType > itDilate(binaryDilate->GetOutput(), binaryDilate->GetOutput()->GetLargestPossibleRegion());
-    itk::ImageRegionIteratorWithIndex< InternalImageType > itPrevious(extracterPrevious->GetOutput(), extracterPrevious->GetOutput()->GetLargestPossibleRegion());
     itk::ImageRegionIteratorWithIndex< InternalImageType > itRegion(regionThreshold, regionThreshold->GetLargestPossibleRegion());
 
     itRegion.GoToBegin();
@@ -468,23 +467,26 @@ void rectumSegmentationMethod::applyMethodNextSlice(unsigned int slice, int step
         ++itRegion;
     }
 
-    itDilate.GoToBegin();
-    itPrevious.GoToBegin();
-    itRegion.GoToBegin();
-    //std::cout<<"Init Recorregut..."<<std::endl;
-    while(!itDilate.IsAtEnd())
+    // Grow the region inside the ROI from every voxel of the previous slice's mask that is also in the thresholded slice
+    const InternalImageType::PixelType *dilateValues = binaryDilate->GetOutput()->GetBufferPointer();
+    const InternalImageType::PixelType *previousValues = extracterPrevious->GetOutput()->GetBufferPointer();
+    InternalImageType::PixelType *regionValues = regionThreshold->GetBufferPointer();
+    InternalImageType::SizeType regionSize = regionThreshold->GetBufferedRegion().GetSize();
+    int dimensions[3] = { static_cast<int>(regionSize[0]), static_cast<int>(regionSize[1]), 1 };
+    int extent[6] = { qMax(0, m_minROI[0]), qMin(dimensions[0] - 1, m_maxROI[0]), qMax(0, m_minROI[1]), qMin(dimensions[1] - 1, m_maxROI[1]), 0, 0 };
+    InternalImageType::PixelType insideValue = m_insideMaskValue;
+
+    for (int y = 0; y < dimensions[1]; y++)
     {
-        if((itDilate.Get()==m_insideMaskValue)&&(itPrevious.Get()==m_insideMaskValue)&&(itRegion.Get()!=m_insideMaskValue))
+        for (int x = 0; x < dimensions[0]; x++)
         {
-            //std::cout<<"Crida a regionGrowingRecursive a "<<itDilate.GetIndex()[0]<<", "<<itDilate.GetIndex()[1]<<" [ "<<regionThreshold->GetLargestPossibleRegion().GetSize()<<std::endl;
-            //Primer ho desem en atributs de la classe així ja no s'ha de passar per paràmetre
-            m_maskrecursive = regionThreshold;
-            m_imrecursive = binaryDilate->GetOutput();
-            this->regionGrowingRecursive(itDilate.GetIndex()[0], itDilate.GetIndex()[1],0);
+            int index = x + y * dimensions[0];
+            if (dilateValues[index] == insideValue && previousValues[index] == insideValue && regionValues[index] != insideValue)
+            {
+                int seed[3] = { x, y, 0 };
+                SegmentationPrimitives::floodFill(dilateValues, regionValues, dimensions, extent, seed, insideValue, insideValue, insideValue);
+            }
         }
-        ++itDilate;
-        ++itPrevious;
-        ++itRegion;
     }
 
 
@@ -529,37 +531,6 @@ void rectumSegmentationMethod::applyMethodNextSlice(unsigned int slice, int step
     return;
 }
 
-void rectumSegmentationMethod::regionGrowingRecursive(int indexX, int indexY , int prof)
-{
-    itk::ImageRegionIteratorWithIndex< InternalImageType > itIm(m_imrecursive, m_imrecursive->GetLargestPossibleRegion());
-    itk::ImageRegionIteratorWithIndex< InternalImageType > itMask(m_maskrecursive, m_maskrecursive->GetLargestPossibleRegion());
-    InternalImageType::IndexType index;
-    index[0]=indexX;
-    index[1]=indexY;
-
-    itIm.SetIndex(index);
-    itMask.SetIndex(index);
-    //if((itIm.Get()>=m_lowerThreshold)&&(itIm.Get()<=m_upperThreshold)&&(itMask.Get()!=m_insideMaskValue))
-    //if((itIm.Get()==m_insideMaskValue)&&(itMask.Get()!=m_insideMaskValue))
-    if((itIm.Get()==m_insideMaskValue)&&(itMask.Get()!=m_insideMaskValue)&& (indexX>=m_minROI[0])&&(indexX<=m_maxROI[0])&&(indexY>=m_minROI[1])&&(indexY<=m_maxROI[1])&&prof<=2000)
-    {
-        //std::cout<<"->Set "<<std::endl;
-        itMask.Set(m_insideMaskValue);
-        if(indexX+1 < (int)m_maskrecursive->GetLargestPossibleRegion().GetSize()[0])
-            regionGrowingRecursive(indexX + 1, indexY, prof +1);
-        if(indexX > 0)
-            regionGrowingRecursive(indexX - 1, indexY, prof +1);
-        if(indexY+1 < (int)m_maskrecursive->GetLargestPossibleRegion().GetSize()[1])
-            regionGrowingRecursive(indexX, indexY + 1, prof +1);
-        if(indexY > 0)
-            regionGrowingRecursive(indexX, indexY - 1, prof +1);
-    }
-    else
-    {
-      //  std::cout<<"*"<<std::endl;
-    }
-}
-
 void rectumSegmentationMethod::applyFilter(Volume* output)
 {
     typedef   float           InternalPixelType;
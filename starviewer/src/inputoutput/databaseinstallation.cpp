@@ -15,6 +15,7 @@
 #include "databaseinstallation.h"
 
 #include "databaseconnection.h"
+#include "derivedvolumecache.h"
 #include "directoryutilities.h"
 #include "localdatabasemanager.h"
 #include "logging.h"
@@ -383,6 +384,8 @@ bool DatabaseInstallation::deleteLocalImagesAndReinstallDatabase()
     // Return value is ignored
     DirectoryUtilities directoryUtilities;
     directoryUtilities.deleteDirectory(LocalDatabaseManager::getCachePath(), false);
+    // The derived volumes belong to the deleted studies
+    directoryUtilities.deleteDirectory(DerivedVolumeCache().getPath(), false);
 
     progressDialog.close();
 
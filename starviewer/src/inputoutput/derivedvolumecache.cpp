@@ -0,0 +1,434 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#include "derivedvolumecache.h"
+
+#include "directoryutilities.h"
+#include "inputoutputsettings.h"
+#include "logging.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QSaveFile>
+#include <QVector>
+
+#include <algorithm>
+#include <cstring>
+
+namespace udg {
+
+namespace {
+
+const quint32 Magic = 0x56445653;
+const quint32 Version = 2;
+const QString FileSuffix(".vol");
+const int MaximumQuantizedValue = 65535;
+
+/// Header of a cached volume file, followed by the values, each one of valueSize bytes. Quantized value v of component c is stored as
+/// (v - minimum[c]) / step[c].
+struct Header {
+    quint32 magic;
+    quint32 version;
+    qint64 numberOfVoxels;
+    qint32 numberOfComponents;
+    qint32 valueSize;
+    float minimum[DerivedVolumeCache::MaximumNumberOfComponents];
+    float step[DerivedVolumeCache::MaximumNumberOfComponents];
+    char padding[8];
+};
+
+Q_STATIC_ASSERT(sizeof(Header) == 64);
+
+void quantize(const float *values, qint64 numberOfVoxels, int numberOfComponents, Header &header, quint16 *quantizedValues)
+{
+    for (int c = 0; c < numberOfComponents; c++)
+    {
+        float minimum = values[c];
+        float maximum = values[c];
+
+        for (qint64 i = 1; i < numberOfVoxels; i++)
+        {
+            float value = values[i * numberOfComponents + c];
+            minimum = qMin(minimum, value);
+            maximum = qMax(maximum, value);
+        }
+
+        header.minimum[c] = minimum;
+        header.step[c] = (maximum - minimum) / MaximumQuantizedValue;
+    }
+
+    for (int c = 0; c < numberOfComponents; c++)
+    {
+        float minimum = header.minimum[c];
+        float inverseStep = header.step[c] > 0.0f ? 1.0f / header.step[c] : 0.0f;
+
+        for (qint64 i = 0; i < numberOfVoxels; i++)
+        {
+            float quantizedValue = (values[i * numberOfComponents + c] - minimum) * inverseStep + 0.5f;
+            quantizedValues[i * numberOfComponents + c] = static_cast<quint16>(qBound(0.0f, quantizedValue, static_cast<float>(MaximumQuantizedValue)));
+        }
+    }
+}
+
+void dequantize(const quint16 *quantizedValues, qint64 numberOfVoxels, int numberOfComponents, const Header &header, float *values)
+{
+    for (int c = 0; c < numberOfComponents; c++)
+    {
+        float minimum = header.minimum[c];
+        float step = header.step[c];
+
+        for (qint64 i = 0; i < numberOfVoxels; i++)
+        {
+            values[i * numberOfComponents + c] = minimum + quantizedValues[i * numberOfComponents + c] * step;
+        }
+    }
+}
+
+/// Returns the size in bytes of each stored value: floats are quantized to 16 bits and doubles are stored as they are
+int getStoredValueSize(const float*)
+{
+    return sizeof(quint16);
+}
+
+int getStoredValueSize(const double*)
+{
+    return sizeof(double);
+}
+
+/// Writes the header and then the data to the file. Returns true if everything has been written.
+bool write(QIODevice &file, const Header &header, const void *data, qint64 size)
+{
+    return file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == static_cast<qint64>(sizeof(Header))
+        && file.write(static_cast<const char*>(data), size) == size;
+}
+
+/// Writes the header and the values to the file, quantizing them if needed. Returns true if everything has been written.
+bool write(QIODevice &file, Header &header, const float *values, qint64 numberOfVoxels, int numberOfComponents)
+{
+    QVector<quint16> quantizedValues(numberOfVoxels * numberOfComponents);
+    quantize(values, numberOfVoxels, numberOfComponents, header, quantizedValues.data());
+
+    return write(file, header, quantizedValues.constData(), quantizedValues.size() * sizeof(quint16));
+}
+
+bool write(QIODevice &file, Header &header, const double *values, qint64 numberOfVoxels, int numberOfComponents)
+{
+    return write(file, header, values, numberOfVoxels * numberOfComponents * sizeof(double));
+}
+
+/// Reads into values the stored data
+void decode(const uchar *data, qint64 numberOfVoxels, int numberOfComponents, const Header &header, float *values)
+{
+    dequantize(reinterpret_cast<const quint16*>(data), numberOfVoxels, numberOfComponents, header, values);
+}
+
+void decode(const uchar *data, qint64 numberOfVoxels, int numberOfComponents, const Header &header, double *values)
+{
+    Q_UNUSED(header);
+    memcpy(values, data, numberOfVoxels * numberOfComponents * sizeof(double));
+}
+
+/// Rewrites the magic number of the given file to update its modification time, which tells the eviction how recently the volume was used
+void touch(const QString &fileName)
+{
+    QFile file(fileName);
+    if (file.open(QIODevice::ReadWrite))
+    {
+        file.write(reinterpret_cast<const char*>(&Magic), sizeof(Magic));
+    }
+}
+
+/// Returns the files of all the volumes in the given directory, the least recently used first
+QFileInfoList getVolumeFiles(const QString &path)
+{
+    QFileInfoList files;
+    QDirIterator iterator(path, QStringList("*" + FileSuffix), QDir::Files, QDirIterator::Subdirectories);
+    while (iterator.hasNext())
+    {
+        iterator.next();
+        files.append(iterator.fileInfo());
+    }
+
+    std::sort(files.begin(), files.end(), [](const QFileInfo &file1, const QFileInfo &file2)
+    {
+        return file1.lastModified() < file2.lastModified();
+    });
+
+    return files;
+}
+
+}
+
+DerivedVolumeCache::DerivedVolumeCache()
+{
+    Settings settings;
+    m_path = settings.getValue(InputOutputSettings::DerivedVolumeCachePath).toString();
+    m_maximumSize = settings.getValue(InputOutputSettings::MaximumMegaBytesForDerivedVolumeCache).toLongLong() * 1024 * 1024;
+}
+
+DerivedVolumeCache::DerivedVolumeCache(const QString &path, qint64 maximumSize)
+ : m_path(path), m_maximumSize(maximumSize)
+{
+}
+
+QString DerivedVolumeCache::computeKey(const QByteArray &parameters)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(parameters, QCryptographicHash::Sha1).toHex());
+}
+
+QString DerivedVolumeCache::getPath() const
+{
+    return m_path;
+}
+
+qint64 DerivedVolumeCache::getMaximumSize() const
+{
+    return m_maximumSize;
+}
+
+bool DerivedVolumeCache::contains(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key) const
+{
+    if (studyInstanceUID.isEmpty() || seriesInstanceUID.isEmpty() || key.isEmpty())
+    {
+        return false;
+    }
+
+    return QFileInfo(getFilePath(studyInstanceUID, seriesInstanceUID, key)).exists();
+}
+
+bool DerivedVolumeCache::store(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, const float *values,
+                               qint64 numberOfVoxels, int numberOfComponents)
+{
+    return storeValues(studyInstanceUID, seriesInstanceUID, key, values, numberOfVoxels, numberOfComponents);
+}
+
+bool DerivedVolumeCache::store(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, const double *values,
+                               qint64 numberOfVoxels, int numberOfComponents)
+{
+    return storeValues(studyInstanceUID, seriesInstanceUID, key, values, numberOfVoxels, numberOfComponents);
+}
+
+bool DerivedVolumeCache::load(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, float *values, qint64 numberOfVoxels,
+                              int numberOfComponents)
+{
+    return loadValues(studyInstanceUID, seriesInstanceUID, key, values, numberOfVoxels, numberOfComponents);
+}
+
+bool DerivedVolumeCache::load(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, double *values, qint64 numberOfVoxels,
+                              int numberOfComponents)
+{
+    return loadValues(studyInstanceUID, seriesInstanceUID, key, values, numberOfVoxels, numberOfComponents);
+}
+
+void DerivedVolumeCache::removeStudy(const QString &studyInstanceUID)
+{
+    if (studyInstanceUID.isEmpty())
+    {
+        return;
+    }
+
+    QString studyPath = QDir(m_path).filePath(studyInstanceUID);
+    if (QDir(studyPath).exists())
+    {
+        DirectoryUtilities().deleteDirectory(studyPath, true);
+    }
+}
+
+void DerivedVolumeCache::removeSeries(const QString &studyInstanceUID, const QString &seriesInstanceUID)
+{
+    if (studyInstanceUID.isEmpty() || seriesInstanceUID.isEmpty())
+    {
+        return;
+    }
+
+    QString seriesPath = getSeriesPath(studyInstanceUID, seriesInstanceUID);
+    if (QDir(seriesPath).exists())
+    {
+        DirectoryUtilities().deleteDirectory(seriesPath, true);
+        QDir(m_path).rmdir(studyInstanceUID);
+    }
+}
+
+qint64 DerivedVolumeCache::getSize() const
+{
+    qint64 size = 0;
+    foreach (const QFileInfo &file, getVolumeFiles(m_path))
+    {
+        size += file.size();
+    }
+
+    return size;
+}
+
+qint64 DerivedVolumeCache::getStudySize(const QString &studyInstanceUID) const
+{
+    if (studyInstanceUID.isEmpty())
+    {
+        return 0;
+    }
+
+    qint64 size = 0;
+    foreach (const QFileInfo &file, getVolumeFiles(QDir(m_path).filePath(studyInstanceUID)))
+    {
+        size += file.size();
+    }
+
+    return size;
+}
+
+void DerivedVolumeCache::trim()
+{
+    trim(m_maximumSize);
+}
+
+void DerivedVolumeCache::trim(qint64 maximumSize)
+{
+    QFileInfoList files = getVolumeFiles(m_path);
+    qint64 size = 0;
+    foreach (const QFileInfo &file, files)
+    {
+        size += file.size();
+    }
+
+    QDir cacheDirectory(m_path);
+    int numberOfDeletedVolumes = 0;
+
+    for (int i = 0; i < files.size() && size > maximumSize; i++)
+    {
+        if (QFile::remove(files.at(i).absoluteFilePath()))
+        {
+            size -= files.at(i).size();
+            numberOfDeletedVolumes++;
+            // Removes the series and study directories if they have become empty
+            cacheDirectory.rmpath(cacheDirectory.relativeFilePath(files.at(i).absolutePath()));
+        }
+        else
+        {
+            WARN_LOG("Can't delete derived volume " + files.at(i).absoluteFilePath());
+        }
+    }
+
+    if (numberOfDeletedVolumes > 0)
+    {
+        INFO_LOG(QString("Deleted %1 derived volumes to keep the cache under %2 MiB").arg(numberOfDeletedVolumes).arg(maximumSize / (1024 * 1024)));
+    }
+}
+
+QString DerivedVolumeCache::getSeriesPath(const QString &studyInstanceUID, const QString &seriesInstanceUID) const
+{
+    return QDir(m_path).filePath(studyInstanceUID + "/" + seriesInstanceUID);
+}
+
+QString DerivedVolumeCache::getFilePath(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key) const
+{
+    return getSeriesPath(studyInstanceUID, seriesInstanceUID) + "/" + key + FileSuffix;
+}
+
+template <class T>
+bool DerivedVolumeCache::storeValues(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, const T *values,
+                                     qint64 numberOfVoxels, int numberOfComponents)
+{
+    if (studyInstanceUID.isEmpty() || seriesInstanceUID.isEmpty() || key.isEmpty() || !values || numberOfVoxels <= 0 || numberOfComponents < 1
+        || numberOfComponents > MaximumNumberOfComponents)
+    {
+        return false;
+    }
+
+    if (!QDir().mkpath(getSeriesPath(studyInstanceUID, seriesInstanceUID)))
+    {
+        ERROR_LOG("Can't create the derived volume directory " + getSeriesPath(studyInstanceUID, seriesInstanceUID));
+        return false;
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    header.magic = Magic;
+    header.version = Version;
+    header.numberOfVoxels = numberOfVoxels;
+    header.numberOfComponents = numberOfComponents;
+    header.valueSize = getStoredValueSize(values);
+
+    QString fileName = getFilePath(studyInstanceUID, seriesInstanceUID, key);
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        ERROR_LOG("Can't write derived volume " + fileName);
+        return false;
+    }
+
+    if (!write(file, header, values, numberOfVoxels, numberOfComponents) || !file.commit())
+    {
+        ERROR_LOG("Can't write derived volume " + fileName);
+        return false;
+    }
+
+    trim();
+
+    return true;
+}
+
+template <class T>
+bool DerivedVolumeCache::loadValues(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, T *values, qint64 numberOfVoxels,
+                                    int numberOfComponents)
+{
+    if (!contains(studyInstanceUID, seriesInstanceUID, key) || !values)
+    {
+        return false;
+    }
+
+    QString fileName = getFilePath(studyInstanceUID, seriesInstanceUID, key);
+    QFile file(fileName);
+    qint64 expectedSize = sizeof(Header) + numberOfVoxels * numberOfComponents * getStoredValueSize(values);
+
+    if (!file.open(QIODevice::ReadOnly) || file.size() != expectedSize)
+    {
+        WARN_LOG("Derived volume " + fileName + " can't be read or doesn't have the expected size");
+        return false;
+    }
+
+    uchar *data = file.map(0, expectedSize);
+    if (!data)
+    {
+        ERROR_LOG("Can't map derived volume " + fileName);
+        return false;
+    }
+
+    const Header *header = reinterpret_cast<const Header*>(data);
+    bool valid = header->magic == Magic && header->version == Version && header->numberOfVoxels == numberOfVoxels
+              && header->numberOfComponents == numberOfComponents && header->valueSize == getStoredValueSize(values);
+
+    if (valid)
+    {
+        decode(data + sizeof(Header), numberOfVoxels, numberOfComponents, *header, values);
+    }
+    else
+    {
+        WARN_LOG("Derived volume " + fileName + " has an invalid header");
+    }
+
+    file.unmap(data);
+    file.close();
+
+    if (valid)
+    {
+        touch(fileName);
+    }
+
+    return valid;
+}
+
+} // End namespace udg
@@ -0,0 +1,103 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+
+#ifndef UDGDERIVEDVOLUMECACHE_H
+#define UDGDERIVEDVOLUMECACHE_H
+
+#include <QString>
+
+class QByteArray;
+
+namespace udg {
+
+/**
+    Disk cache of volumes derived from a series, such as obscurances or voxel saliencies, that are expensive to compute and can be reused between sessions.
+
+    Each volume is identified by the study and series it comes from and by a key that hashes everything else it depends on (transfer function, parameters...),
+    and it is stored in its own file in <path>/<studyInstanceUID>/<seriesInstanceUID>/<key>.vol. Float values are quantized to 16 bits with a linear
+    mapping per component, while double values, which are only computed when the precision matters, are stored as they are. The file is a fixed header
+    followed by the raw values, so that loading it is a matter of mapping it in memory and scaling the values back.
+
+    The size of the cache is bounded: when a new volume makes it exceed the maximum size, the least recently used volumes are deleted. The volumes of a study
+    or a series are also deleted when the study or series is deleted from the local database.
+  */
+class DerivedVolumeCache {
+public:
+    /// Maximum number of interleaved components of a volume
+    static const int MaximumNumberOfComponents = 4;
+
+    /// Creates a cache with the path and maximum size given in settings
+    DerivedVolumeCache();
+    /// Creates a cache in the given path with the given maximum size in bytes
+    DerivedVolumeCache(const QString &path, qint64 maximumSize);
+
+    /// Returns a key that identifies a volume derived with the given serialized parameters
+    static QString computeKey(const QByteArray &parameters);
+
+    /// Returns the path and the maximum size in bytes of the cache
+    QString getPath() const;
+    qint64 getMaximumSize() const;
+
+    /// Returns true if there is a volume with the given key for the given series
+    bool contains(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key) const;
+
+    /// Saves the given values, with numberOfComponents interleaved components for each of the numberOfVoxels voxels, with the given key for the given
+    /// series. Floats are quantized and doubles are saved without loss. Returns true if the volume has been saved.
+    bool store(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, const float *values, qint64 numberOfVoxels,
+               int numberOfComponents = 1);
+    bool store(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, const double *values, qint64 numberOfVoxels,
+               int numberOfComponents = 1);
+
+    /// Loads into values the volume with the given key for the given series, which must have numberOfVoxels voxels with numberOfComponents components
+    /// and must have been saved with the same value type. Returns true if the volume has been found and loaded.
+    bool load(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, float *values, qint64 numberOfVoxels,
+              int numberOfComponents = 1);
+    bool load(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, double *values, qint64 numberOfVoxels,
+              int numberOfComponents = 1);
+
+    /// Deletes all the volumes of the given study or series
+    void removeStudy(const QString &studyInstanceUID);
+    void removeSeries(const QString &studyInstanceUID, const QString &seriesInstanceUID);
+
+    /// Returns the total size in bytes of the volumes in the cache
+    qint64 getSize() const;
+    /// Returns the size in bytes of the volumes of the given study
+    qint64 getStudySize(const QString &studyInstanceUID) const;
+
+    /// Deletes the least recently used volumes until the size of the cache is not greater than the maximum size
+    void trim();
+    /// Deletes the least recently used volumes until the size of the cache is not greater than the given size
+    void trim(qint64 maximumSize);
+
+private:
+    /// Returns the directory of the volumes of the given series and the file of the volume with the given key
+    QString getSeriesPath(const QString &studyInstanceUID, const QString &seriesInstanceUID) const;
+    QString getFilePath(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key) const;
+
+    template <class T>
+    bool storeValues(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, const T *values, qint64 numberOfVoxels,
+                     int numberOfComponents);
+    template <class T>
+    bool loadValues(const QString &studyInstanceUID, const QString &seriesInstanceUID, const QString &key, T *values, qint64 numberOfVoxels,
+                    int numberOfComponents);
+
+private:
+    QString m_path;
+    qint64 m_maximumSize;
+};
+
+} // End namespace udg
+
+#endif
@@ -99,7 +99,8 @@ HEADERS += databaseconnection.h \
     usermessage.h \
     portinusebyanotherapplication.h \
     localdatabasevoilutdal.h \
-    localdatabaseencapsulateddocumentdal.h
+    localdatabaseencapsulateddocumentdal.h \
+    derivedvolumecache.h
 SOURCES += databaseconnection.cpp \
     pacsdevicemanager.cpp \
     pacsconnection.cpp \
@@ -175,7 +176,8 @@ SOURCES += databaseconnection.cpp \
     usermessage.cpp \
     portinusebyanotherapplication.cpp \
     localdatabasevoilutdal.cpp \
-    localdatabaseencapsulateddocumentdal.cpp
+    localdatabaseencapsulateddocumentdal.cpp \
+    derivedvolumecache.cpp
 win32 {
     HEADERS += windowsportinusebyanotherapplication.h
     SOURCES += windowsportinusebyanotherapplication.cpp
@@ -35,6 +35,8 @@ const QString InputOutputSettings::DeleteLeastRecentlyUsedStudiesNoFreeSpaceCrit
 const QString InputOutputSettings::MinimumDaysUnusedToDeleteStudy(CacheBase + "MaximumDaysNotViewedStudy");
 const QString InputOutputSettings::MinimumFreeGigaBytesForCache(CacheBase + "minimumSpaceRequiredToRetrieveInGbytes");
 const QString InputOutputSettings::MinimumGigaBytesToFreeIfCacheIsFull(CacheBase + "GbytesOfOldStudiesToDeleteIfNotEnoughSapaceAvailable");
+const QString InputOutputSettings::DerivedVolumeCachePath(CacheBase + "derivedVolumePath");
+const QString InputOutputSettings::MaximumMegaBytesForDerivedVolumeCache(CacheBase + "maximumDerivedVolumeCacheSizeInMbytes");
 
 const QString InputOutputSettings::RetrievingStudy("/PACS/RetrievingStudy");
 
@@ -116,6 +118,8 @@ void InputOutputSettings::init()
     settingsRegistry->addSetting(MinimumDaysUnusedToDeleteStudy, 7);
     settingsRegistry->addSetting(MinimumFreeGigaBytesForCache, 5);
     settingsRegistry->addSetting(MinimumGigaBytesToFreeIfCacheIsFull, 2);
+    settingsRegistry->addSetting(DerivedVolumeCachePath, UserDataRootPath + "pacs/derived/", Settings::Parseable);
+    settingsRegistry->addSetting(MaximumMegaBytesForDerivedVolumeCache, 2048);
 
     settingsRegistry->addSetting(ListenToRISRequests, true);
     settingsRegistry->addSetting(RISRequestsPort, 11110);
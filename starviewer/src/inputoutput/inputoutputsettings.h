@@ -37,6 +37,9 @@ public:
     static const QString MinimumGigaBytesToFreeIfCacheIsFull;
     static const QString MinimumFreeGigaBytesForCache;
     static const QString MinimumDaysUnusedToDeleteStudy;
+    /// Directori i mida màxima (en MB) de la cache de volums derivats (obscurances, saliencies...)
+    static const QString DerivedVolumeCachePath;
+    static const QString MaximumMegaBytesForDerivedVolumeCache;
     /// Controlar quin estudi està baixant-se
     static const QString RetrievingStudy;
 
@@ -15,6 +15,7 @@
 #include "localdatabasemanager.h"
 
 #include "databaseconnection.h"
+#include "derivedvolumecache.h"
 #include "dicommask.h"
 #include "directoryutilities.h"
 #include "harddiskinformation.h"
@@ -843,6 +844,17 @@ bool LocalDatabaseManager::thereIsAvailableSpaceOnHardDisk()
     INFO_LOG(QString("Not enough free space in disk to download studies. Free space: %1 MiB. Required: %2 MiB.").arg(freeSpaceInHardDisk)
                                                                                                                 .arg(minimumSpaceRequired));
 
+    // Derived volumes can be computed again, so they are deleted before any study
+    quint64 additionalMegabytesToErase = settings.getValue(InputOutputSettings::MinimumGigaBytesToFreeIfCacheIsFull).toULongLong() * 1024;
+    quint64 megabytesToFreeUp = minimumSpaceRequired - freeSpaceInHardDisk + additionalMegabytesToErase;
+    megabytesToFreeUp -= qMin(megabytesToFreeUp, freeUpSpaceDeletingDerivedVolumes(megabytesToFreeUp));
+
+    freeSpaceInHardDisk = hardDiskInformation.getNumberOfFreeMBytes(getCachePath());
+    if (freeSpaceInHardDisk >= minimumSpaceRequired)
+    {
+        return true;
+    }
+
     // Check if we should try to free up space. If not, return false
     if (!settings.getValue(InputOutputSettings::DeleteLeastRecentlyUsedStudiesNoFreeSpaceCriteria).toBool())
     {
@@ -853,8 +865,6 @@ bool LocalDatabaseManager::thereIsAvailableSpaceOnHardDisk()
 
     // Delete studies until we have the needed space (minimumSpaceRequired - freeSpaceInHardDisk)
     // plus a constant quantity to ensure that we don't have to free up space too often
-    quint64 additionalMegabytesToErase = settings.getValue(InputOutputSettings::MinimumGigaBytesToFreeIfCacheIsFull).toULongLong() * 1024;
-    quint64 megabytesToFreeUp = minimumSpaceRequired - freeSpaceInHardDisk + additionalMegabytesToErase;
     freeUpSpaceDeletingStudies(megabytesToFreeUp);
 
     if (getLastError() != Ok)
@@ -976,13 +986,16 @@ void LocalDatabaseManager::freeUpSpaceDeletingStudies(quint64 megabytesToFreeUp)
         return;
     }
 
+    DerivedVolumeCache derivedVolumeCache;
     quint64 megabytesErased = 0;
 
     while (!studyList.isEmpty() && megabytesErased < megabytesToFreeUp)
     {
         Study *study = studyList.takeFirst();
         emit studyWillBeDeleted(study->getInstanceUID());
-        megabytesErased += HardDiskInformation::getDirectorySizeInBytes(getCachePath() + study->getInstanceUID()) / 1024 / 1024;
+        // The derived volumes of the study are deleted with it
+        megabytesErased += (HardDiskInformation::getDirectorySizeInBytes(getCachePath() + study->getInstanceUID())
+                            + derivedVolumeCache.getStudySize(study->getInstanceUID())) / 1024 / 1024;
         deleteStudy(study->getInstanceUID());
         delete study;
 
@@ -999,6 +1012,22 @@ void LocalDatabaseManager::freeUpSpaceDeletingStudies(quint64 megabytesToFreeUp)
     }
 }
 
+quint64 LocalDatabaseManager::freeUpSpaceDeletingDerivedVolumes(quint64 megabytesToFreeUp)
+{
+    DerivedVolumeCache derivedVolumeCache;
+    qint64 size = derivedVolumeCache.getSize();
+    qint64 bytesToFreeUp = qMin(static_cast<qint64>(megabytesToFreeUp * 1024 * 1024), size);
+
+    if (bytesToFreeUp <= 0)
+    {
+        return 0;
+    }
+
+    derivedVolumeCache.trim(size - bytesToFreeUp);
+
+    return (size - derivedVolumeCache.getSize()) / 1024 / 1024;
+}
+
 QList<Study*> LocalDatabaseManager::getAllStudiesOrderedByLastAccessDate()
 {
     DatabaseConnection databaseConnection;
@@ -1010,6 +1039,8 @@ QList<Study*> LocalDatabaseManager::getAllStudiesOrderedByLastAccessDate()
 
 void LocalDatabaseManager::deleteStudyFromHardDisk(const QString &studyInstanceUID)
 {
+    DerivedVolumeCache().removeStudy(studyInstanceUID);
+
     if (DirectoryUtilities().deleteDirectory(getStudyPath(studyInstanceUID), true))
     {
         m_lastError = Ok;
@@ -1022,6 +1053,8 @@ void LocalDatabaseManager::deleteStudyFromHardDisk(const QString &studyInstanceU
 
 void LocalDatabaseManager::deleteSeriesFromHardDisk(const QString &studyInstanceUID, const QString &seriesInstanceUID)
 {
+    DerivedVolumeCache().removeSeries(studyInstanceUID, seriesInstanceUID);
+
     if (DirectoryUtilities().deleteDirectory(getStudyPath(studyInstanceUID) + QDir::separator() + seriesInstanceUID, true))
     {
         m_lastError = Ok;
@@ -124,13 +124,16 @@ signals:
 private:
     /// Deletes old studies until the given number of megabytes have been deleted.
     void freeUpSpaceDeletingStudies(quint64 megbytesToFreeUp);
+    /// Deletes the least recently used derived volumes until the given number of megabytes have been deleted or there are none left. Returns the
+    /// number of megabytes deleted.
+    quint64 freeUpSpaceDeletingDerivedVolumes(quint64 megabytesToFreeUp);
 
     /// Returns all the studies sorted by last access date.
     QList<Study*> getAllStudiesOrderedByLastAccessDate();
 
-    /// Deletes the study with the given UID from the disk.
+    /// Deletes the study with the given UID from the disk, together with its derived volumes.
     void deleteStudyFromHardDisk(const QString &studyInstanceUID);
-    /// Deletes the series with the given UID from the study with the given UID from the disk.
+    /// Deletes the series with the given UID from the study with the given UID from the disk, together with its derived volumes.
     void deleteSeriesFromHardDisk(const QString &studyInstanceUID, const QString &seriesInstanceUID);
 
     /// Sets the last error according to the given SQL error.
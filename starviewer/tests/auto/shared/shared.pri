@@ -24,6 +24,7 @@ SOURCES += $$PWD/pacsdevicetesthelper.cpp \
            $$PWD/testingsettings.cpp \
            $$PWD/testingmammographyimagehelper.cpp \
            $$PWD/testingdecaycorrectionfactorformulacalculator.cpp \
+           $$PWD/testingrenderingprofiler.cpp \
            $$PWD/databasetesthelper.cpp
            
 HEADERS += $$PWD/autotest.h \
@@ -52,4 +53,6 @@ HEADERS += $$PWD/autotest.h \
            $$PWD/testingsettings.h \
            $$PWD/testingmammographyimagehelper.h \
            $$PWD/testingdecaycorrectionfactorformulacalculator.h \
+           $$PWD/testingrenderingprofiler.h \
+           $$PWD/testingroitool.h \
            $$PWD/databasetesthelper.h
@@ -0,0 +1,11 @@
+#include "testingrenderingprofiler.h"
+
+TestingRenderingProfiler::TestingRenderingProfiler(vtkRenderWindow *renderWindow, vtkRenderer *renderer)
+ : RenderingProfiler(renderWindow, renderer), m_currentTime(0)
+{
+}
+
+qint64 TestingRenderingProfiler::getCurrentTime() const
+{
+    return m_currentTime;
+}
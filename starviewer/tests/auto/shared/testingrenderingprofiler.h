@@ -0,0 +1,20 @@
+#ifndef TESTINGRENDERINGPROFILER_H
+#define TESTINGRENDERINGPROFILER_H
+
+#include "renderingprofiler.h"
+
+using namespace udg;
+
+class TestingRenderingProfiler : public RenderingProfiler {
+public:
+    /// Current time in nanoseconds
+    qint64 m_currentTime;
+
+public:
+    TestingRenderingProfiler(vtkRenderWindow *renderWindow, vtkRenderer *renderer);
+
+protected:
+    qint64 getCurrentTime() const;
+};
+
+#endif // TESTINGRENDERINGPROFILER_H
@@ -0,0 +1,14 @@
+#ifndef TESTINGROITOOL_H
+#define TESTINGROITOOL_H
+
+#include "roitool.h"
+
+using namespace udg;
+
+/// Gives access to the rasterization of ROITool, which doesn't need a viewer
+class TestingROITool : public ROITool {
+public:
+    using ROITool::computeVoxelValues;
+};
+
+#endif // TESTINGROITOOL_H
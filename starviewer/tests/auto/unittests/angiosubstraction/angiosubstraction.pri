@@ -0,0 +1 @@
+SOURCES += $$PWD/test_angioframeregistration.cpp
@@ -0,0 +1,174 @@
+#include "autotest.h"
+#include "angioframeregistration.h"
+
+#include "volume.h"
+
+#include <QScopedPointer>
+#include <QSignalSpy>
+
+#include <cmath>
+
+using namespace udg;
+
+class test_AngioFrameRegistration : public QObject {
+Q_OBJECT
+
+private slots:
+    void start_ShouldFindTheTranslationOfEachFrame();
+
+    void start_ShouldTakeTheRegisteredFramesFromTheCache();
+
+    void start_Benchmark();
+
+private:
+    /// Returns a volume of numberOfFrames frames of size x size pixels with a pattern of blobs, where each frame is the first one moved by
+    /// getShift(frame)
+    static Volume* createRun(int size, int numberOfFrames);
+
+    /// Returns the shift of the pattern in the given frame, in pixels
+    static QPointF getShift(int frame);
+
+    /// Registers the frames to the first one and waits until the registration finishes
+    static bool registerRun(AngioFrameRegistration &registration, int numberOfFrames);
+};
+
+namespace {
+
+/// Maximum time to wait for a registration, in milliseconds
+const int Timeout = 300000;
+
+}
+
+void test_AngioFrameRegistration::start_ShouldFindTheTranslationOfEachFrame()
+{
+    const int numberOfFrames = 6;
+    QScopedPointer<Volume> volume(createRun(128, numberOfFrames));
+
+    AngioFrameRegistration registration;
+    registration.setInput(volume.data());
+    QVERIFY(registerRun(registration, numberOfFrames));
+
+    for (int frame = 0; frame < numberOfFrames; frame++)
+    {
+        QPointF translation;
+        QVERIFY(registration.getTranslation(0, frame, translation));
+
+        QPointF error = translation - getShift(frame);
+        QVERIFY2(std::abs(error.x()) < 0.5 && std::abs(error.y()) < 0.5,
+                 qPrintable(QString("frame %1: translation (%2, %3), expected (%4, %5)").arg(frame).arg(translation.x()).arg(translation.y())
+                            .arg(getShift(frame).x()).arg(getShift(frame).y())));
+    }
+}
+
+void test_AngioFrameRegistration::start_ShouldTakeTheRegisteredFramesFromTheCache()
+{
+    const int numberOfFrames = 3;
+    QScopedPointer<Volume> volume(createRun(64, numberOfFrames));
+
+    AngioFrameRegistration registration;
+    registration.setInput(volume.data());
+    QVERIFY(registerRun(registration, numberOfFrames));
+
+    // The second run doesn't have any frame left to register
+    QSignalSpy progressSpy(&registration, SIGNAL(progress(int, int)));
+    QVERIFY(registerRun(registration, numberOfFrames));
+    foreach (const QList<QVariant> &arguments, progressSpy)
+    {
+        QCOMPARE(arguments.at(1).toInt(), 0);
+    }
+
+    QPointF translation;
+    QVERIFY(registration.getTranslation(0, numberOfFrames - 1, translation));
+
+    // A new input discards the cache
+    registration.setInput(volume.data());
+    QVERIFY(!registration.getTranslation(0, numberOfFrames - 1, translation));
+}
+
+void test_AngioFrameRegistration::start_Benchmark()
+{
+    // A whole run of 100 frames of 512x512 pixels
+    const int numberOfFrames = 100;
+    QScopedPointer<Volume> volume(createRun(512, numberOfFrames));
+    AngioFrameRegistration registration;
+
+    QBENCHMARK
+    {
+        // Setting the input discards the translations of the previous iteration
+        registration.setInput(volume.data());
+        QVERIFY(registerRun(registration, numberOfFrames));
+    }
+}
+
+Volume* test_AngioFrameRegistration::createRun(int size, int numberOfFrames)
+{
+    Volume::ItkImageType::SizeType imageSize;
+    imageSize[0] = size;
+    imageSize[1] = size;
+    imageSize[2] = numberOfFrames;
+    Volume::ItkImageType::IndexType start;
+    start.Fill(0);
+
+    Volume::ItkImageType::Pointer image = Volume::ItkImageType::New();
+    image->SetRegions(Volume::ItkImageType::RegionType(start, imageSize));
+    image->Allocate();
+
+    // Blobs spread over the central part of the frame, which is the one used to register
+    const int numberOfBlobs = 12;
+    double blobX[numberOfBlobs], blobY[numberOfBlobs], blobRadius[numberOfBlobs];
+    for (int i = 0; i < numberOfBlobs; i++)
+    {
+        blobX[i] = size * (0.3 + 0.4 * ((i * 7) % numberOfBlobs) / numberOfBlobs);
+        blobY[i] = size * (0.3 + 0.4 * ((i * 5) % numberOfBlobs) / numberOfBlobs);
+        blobRadius[i] = size * (0.02 + 0.01 * (i % 3));
+    }
+
+    Volume::ItkPixelType *pixels = image->GetBufferPointer();
+    for (int frame = 0; frame < numberOfFrames; frame++)
+    {
+        QPointF shift = getShift(frame);
+
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                double value = 100.0;
+                for (int i = 0; i < numberOfBlobs; i++)
+                {
+                    double dx = x - shift.x() - blobX[i];
+                    double dy = y - shift.y() - blobY[i];
+                    value += 800.0 * std::exp(-(dx * dx + dy * dy) / (2.0 * blobRadius[i] * blobRadius[i]));
+                }
+                *pixels++ = static_cast<Volume::ItkPixelType>(value);
+            }
+        }
+    }
+
+    Volume *volume = new Volume();
+    volume->setData(image);
+
+    return volume;
+}
+
+QPointF test_AngioFrameRegistration::getShift(int frame)
+{
+    return QPointF(frame % 5 - 2, (frame * 3) % 7 - 3) * (frame > 0 ? 1.0 : 0.0);
+}
+
+bool test_AngioFrameRegistration::registerRun(AngioFrameRegistration &registration, int numberOfFrames)
+{
+    QVector<int> frames;
+    for (int frame = 0; frame < numberOfFrames; frame++)
+    {
+        frames << frame;
+    }
+
+    QSignalSpy finishedSpy(&registration, SIGNAL(finished()));
+    registration.start(0, frames);
+
+    return finishedSpy.count() > 0 || finishedSpy.wait(Timeout);
+}
+
+DECLARE_TEST(test_AngioFrameRegistration)
+
+#include "test_angioframeregistration.moc"
@@ -89,7 +89,23 @@ SOURCES += $$PWD/test_image.cpp \
            $$PWD/test_externalapplication.cpp \
            $$PWD/test_sliceorientedvolumepixeldata.cpp \
            $$PWD/test_applicationversionchecker.cpp \
-           $$PWD/test_systemrequirementstest.cpp
+           $$PWD/test_systemrequirementstest.cpp \
+           $$PWD/test_curvedplanarreformation.cpp \
+           $$PWD/test_isosurfaceextractor.cpp \
+           $$PWD/test_voistatisticscalculator.cpp \
+           $$PWD/test_regiongrowing.cpp \
+           $$PWD/test_timeactivitycurvecalculator.cpp \
+           $$PWD/test_drawerspatialindex.cpp \
+           $$PWD/test_drawerlinebatcher.cpp \
+           $$PWD/test_sliceindex.cpp \
+           $$PWD/test_standardizeduptakevaluefactorcache.cpp \
+           $$PWD/test_volumepixeldatastatistics.cpp \
+           $$PWD/test_segmentationprimitives.cpp \
+           $$PWD/test_maskstatistics.cpp \
+           $$PWD/test_gradientvolume.cpp \
+           $$PWD/test_renderingprofiler.cpp \
+           $$PWD/test_roitool.cpp \
+           $$PWD/test_contourrasterizer.cpp
 
 win32 {
     SOURCES += $$PWD/test_windowsfirewallaccess.cpp \
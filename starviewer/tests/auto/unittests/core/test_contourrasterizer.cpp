@@ -0,0 +1,115 @@
+#include "autotest.h"
+#include "contourrasterizer.h"
+
+using namespace udg;
+
+class test_ContourRasterizer : public QObject {
+Q_OBJECT
+
+private slots:
+    void getSpans_ShouldReturnNoSpansForLessThanThreePoints();
+
+    void getSpans_ShouldIncludeVoxelsWithCenterInsideContour();
+
+    void getSpans_ShouldIncludeLowerVertexAndExcludeUpperVertex();
+
+    void getSpans_ShouldReturnSeveralSpansInRowsOfConcaveContour();
+
+    void getSpans_ShouldUseOriginAndSpacingAndClampToExtent();
+
+private:
+    /// Returns the spans of the contour in a plane of 10x10 voxels with origin 0 and unit spacing
+    static QVector<ContourRasterizer::Span> getUnitSpans(const QVector<QPointF> &contour);
+
+    /// Returns a span with the given row and columns
+    static ContourRasterizer::Span createSpan(int row, int firstColumn, int lastColumn);
+};
+
+void test_ContourRasterizer::getSpans_ShouldReturnNoSpansForLessThanThreePoints()
+{
+    QVector<QPointF> contour;
+    contour << QPointF(1.0, 1.0) << QPointF(5.0, 5.0);
+
+    QVERIFY(getUnitSpans(contour).isEmpty());
+}
+
+void test_ContourRasterizer::getSpans_ShouldIncludeVoxelsWithCenterInsideContour()
+{
+    QVector<QPointF> contour;
+    contour << QPointF(1.5, 1.5) << QPointF(4.5, 1.5) << QPointF(4.5, 4.5) << QPointF(1.5, 4.5);
+
+    QVector<ContourRasterizer::Span> expectedSpans;
+    expectedSpans << createSpan(2, 2, 4) << createSpan(3, 2, 4) << createSpan(4, 2, 4);
+
+    QCOMPARE(getUnitSpans(contour), expectedSpans);
+}
+
+void test_ContourRasterizer::getSpans_ShouldIncludeLowerVertexAndExcludeUpperVertex()
+{
+    // Diamond with its vertices on voxel centers: the one of row 1 is included, the one of row 7 is not, and the side ones are crossed once
+    QVector<QPointF> contour;
+    contour << QPointF(5.0, 1.0) << QPointF(8.0, 4.0) << QPointF(5.0, 7.0) << QPointF(2.0, 4.0);
+
+    QVector<ContourRasterizer::Span> expectedSpans;
+    expectedSpans << createSpan(1, 5, 5) << createSpan(2, 4, 6) << createSpan(3, 3, 7) << createSpan(4, 2, 8) << createSpan(5, 3, 7)
+                  << createSpan(6, 4, 6);
+
+    QCOMPARE(getUnitSpans(contour), expectedSpans);
+}
+
+void test_ContourRasterizer::getSpans_ShouldReturnSeveralSpansInRowsOfConcaveContour()
+{
+    // U shape open towards the top rows
+    QVector<QPointF> contour;
+    contour << QPointF(0.5, 0.5) << QPointF(7.5, 0.5) << QPointF(7.5, 7.5) << QPointF(5.5, 7.5) << QPointF(5.5, 3.5) << QPointF(2.5, 3.5)
+            << QPointF(2.5, 7.5) << QPointF(0.5, 7.5);
+
+    QVector<ContourRasterizer::Span> expectedSpans;
+    for (int row = 1; row <= 3; row++)
+    {
+        expectedSpans << createSpan(row, 1, 7);
+    }
+    for (int row = 4; row <= 7; row++)
+    {
+        expectedSpans << createSpan(row, 1, 2) << createSpan(row, 6, 7);
+    }
+
+    QCOMPARE(getUnitSpans(contour), expectedSpans);
+}
+
+void test_ContourRasterizer::getSpans_ShouldUseOriginAndSpacingAndClampToExtent()
+{
+    double origin[2] = { 10.0, 20.0 };
+    double spacing[2] = { 2.0, 0.5 };
+    int extent[4] = { 0, 4, 0, 9 };
+    // Columns from -0.5 to 10 and rows from 0.4 to 2.2
+    QVector<QPointF> contour;
+    contour << QPointF(9.0, 20.2) << QPointF(30.0, 20.2) << QPointF(30.0, 21.1) << QPointF(9.0, 21.1);
+
+    QVector<ContourRasterizer::Span> expectedSpans;
+    expectedSpans << createSpan(1, 0, 4) << createSpan(2, 0, 4);
+
+    QCOMPARE(ContourRasterizer::getSpans(contour, origin, spacing, extent), expectedSpans);
+}
+
+QVector<ContourRasterizer::Span> test_ContourRasterizer::getUnitSpans(const QVector<QPointF> &contour)
+{
+    double origin[2] = { 0.0, 0.0 };
+    double spacing[2] = { 1.0, 1.0 };
+    int extent[4] = { 0, 9, 0, 9 };
+
+    return ContourRasterizer::getSpans(contour, origin, spacing, extent);
+}
+
+ContourRasterizer::Span test_ContourRasterizer::createSpan(int row, int firstColumn, int lastColumn)
+{
+    ContourRasterizer::Span span;
+    span.row = row;
+    span.firstColumn = firstColumn;
+    span.lastColumn = lastColumn;
+    return span;
+}
+
+DECLARE_TEST(test_ContourRasterizer)
+
+#include "test_contourrasterizer.moc"
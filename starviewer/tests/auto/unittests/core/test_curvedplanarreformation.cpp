@@ -0,0 +1,186 @@
+#include "autotest.h"
+#include "curvedplanarreformation.h"
+
+#include "fuzzycomparetesthelper.h"
+
+#include <vtkImageData.h>
+
+using namespace udg;
+using namespace testing;
+
+typedef QList<Vector3> Vector3List;
+
+Q_DECLARE_METATYPE(Vector3List)
+Q_DECLARE_METATYPE(CurvedPlanarReformation::ReformationType)
+
+class test_CurvedPlanarReformation : public QObject {
+Q_OBJECT
+
+private slots:
+    void getPathLength_ShouldReturnExpectedValue_data();
+    void getPathLength_ShouldReturnExpectedValue();
+
+    void computeReformation_ShouldReturnExpectedRows_data();
+    void computeReformation_ShouldReturnExpectedRows();
+
+    void computeReformation_ShouldReturnNullWithDegeneratedPath_data();
+    void computeReformation_ShouldReturnNullWithDegeneratedPath();
+
+    void computeCrossSection_ShouldReturnExpectedValues();
+
+private:
+    /// Returns an 11x11x11 image with unit spacing where the value of each voxel is its x index
+    static vtkSmartPointer<vtkImageData> createXRampImage();
+};
+
+void test_CurvedPlanarReformation::getPathLength_ShouldReturnExpectedValue_data()
+{
+    QTest::addColumn<Vector3List>("path");
+    QTest::addColumn<double>("expectedLength");
+
+    QTest::newRow("empty path") << Vector3List() << 0.0;
+    QTest::newRow("single point") << (Vector3List() << Vector3(1.0, 2.0, 3.0)) << 0.0;
+    QTest::newRow("single segment") << (Vector3List() << Vector3(0.0, 0.0, 0.0) << Vector3(3.0, 4.0, 0.0)) << 5.0;
+    QTest::newRow("duplicated points") << (Vector3List() << Vector3(0.0, 0.0, 0.0) << Vector3(0.0, 0.0, 0.0) << Vector3(0.0, 0.0, 2.0)) << 2.0;
+    QTest::newRow("several segments") << (Vector3List() << Vector3(0.0, 0.0, 0.0) << Vector3(1.0, 0.0, 0.0) << Vector3(1.0, 2.0, 0.0)
+                                                        << Vector3(1.0, 2.0, -3.0)) << 6.0;
+}
+
+void test_CurvedPlanarReformation::getPathLength_ShouldReturnExpectedValue()
+{
+    QFETCH(Vector3List, path);
+    QFETCH(double, expectedLength);
+
+    CurvedPlanarReformation reformation;
+    reformation.setPath(path);
+
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(reformation.getPathLength(), expectedLength));
+}
+
+void test_CurvedPlanarReformation::computeReformation_ShouldReturnExpectedRows_data()
+{
+    QTest::addColumn<CurvedPlanarReformation::ReformationType>("type");
+    QTest::addColumn<Vector3List>("path");
+    QTest::addColumn<int>("expectedRows");
+
+    Vector3List straightPath;
+    straightPath << Vector3(5.0, 0.0, 5.0) << Vector3(5.0, 10.0, 5.0);
+    Vector3List bentPath;
+    bentPath << Vector3(5.0, 0.0, 2.0) << Vector3(5.0, 5.0, 2.0) << Vector3(5.0, 5.0, 8.0);
+
+    QTest::newRow("straightened, straight path") << CurvedPlanarReformation::Straightened << straightPath << 11;
+    QTest::newRow("stretched, straight path") << CurvedPlanarReformation::Stretched << straightPath << 11;
+    QTest::newRow("straightened, bent path") << CurvedPlanarReformation::Straightened << bentPath << 12;
+    QTest::newRow("stretched, bent path") << CurvedPlanarReformation::Stretched << bentPath << 12;
+}
+
+void test_CurvedPlanarReformation::computeReformation_ShouldReturnExpectedRows()
+{
+    QFETCH(CurvedPlanarReformation::ReformationType, type);
+    QFETCH(Vector3List, path);
+    QFETCH(int, expectedRows);
+
+    vtkSmartPointer<vtkImageData> image = createXRampImage();
+    CurvedPlanarReformation reformation;
+    reformation.setInput(image);
+    reformation.setPath(path);
+    reformation.setVectorOfInterest(Vector3(1.0, 0.0, 0.0));
+    reformation.setWidth(4.0);
+
+    vtkSmartPointer<vtkImageData> output = reformation.computeReformation(type);
+
+    QVERIFY(output);
+    int dimensions[3];
+    output->GetDimensions(dimensions);
+    QCOMPARE(dimensions[0], 5);
+    QCOMPARE(dimensions[1], expectedRows);
+
+    // The path lies on x = 5 and rows are sampled along x, so every row should contain the ramp centered at 5
+    for (int row = 0; row < dimensions[1]; row++)
+    {
+        for (int column = 0; column < dimensions[0]; column++)
+        {
+            double value = output->GetScalarComponentAsDouble(column, row, 0, 0);
+            QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(value, 3.0 + column, 0.0001));
+        }
+    }
+}
+
+void test_CurvedPlanarReformation::computeReformation_ShouldReturnNullWithDegeneratedPath_data()
+{
+    QTest::addColumn<CurvedPlanarReformation::ReformationType>("type");
+    QTest::addColumn<Vector3List>("path");
+
+    QTest::newRow("straightened, single point") << CurvedPlanarReformation::Straightened << (Vector3List() << Vector3(5.0, 5.0, 5.0));
+    QTest::newRow("stretched, single point") << CurvedPlanarReformation::Stretched << (Vector3List() << Vector3(5.0, 5.0, 5.0));
+    QTest::newRow("stretched, path parallel to vector of interest") << CurvedPlanarReformation::Stretched
+                                                                    << (Vector3List() << Vector3(0.0, 5.0, 5.0) << Vector3(10.0, 5.0, 5.0));
+}
+
+void test_CurvedPlanarReformation::computeReformation_ShouldReturnNullWithDegeneratedPath()
+{
+    QFETCH(CurvedPlanarReformation::ReformationType, type);
+    QFETCH(Vector3List, path);
+
+    vtkSmartPointer<vtkImageData> image = createXRampImage();
+    CurvedPlanarReformation reformation;
+    reformation.setInput(image);
+    reformation.setPath(path);
+    reformation.setVectorOfInterest(Vector3(1.0, 0.0, 0.0));
+
+    QVERIFY(!reformation.computeReformation(type));
+}
+
+void test_CurvedPlanarReformation::computeCrossSection_ShouldReturnExpectedValues()
+{
+    vtkSmartPointer<vtkImageData> image = createXRampImage();
+    CurvedPlanarReformation reformation;
+    reformation.setInput(image);
+    reformation.setPath(Vector3List() << Vector3(5.0, 0.0, 5.0) << Vector3(5.0, 10.0, 5.0));
+    reformation.setVectorOfInterest(Vector3(1.0, 0.0, 0.0));
+    reformation.setWidth(4.0);
+
+    vtkSmartPointer<vtkImageData> output = reformation.computeCrossSection(5.0);
+
+    QVERIFY(output);
+    int dimensions[3];
+    output->GetDimensions(dimensions);
+    QCOMPARE(dimensions[0], 5);
+    QCOMPARE(dimensions[1], 5);
+
+    for (int row = 0; row < dimensions[1]; row++)
+    {
+        for (int column = 0; column < dimensions[0]; column++)
+        {
+            double value = output->GetScalarComponentAsDouble(column, row, 0, 0);
+            QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(value, 3.0 + column, 0.0001));
+        }
+    }
+}
+
+vtkSmartPointer<vtkImageData> test_CurvedPlanarReformation::createXRampImage()
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, 10, 0, 10, 0, 10);
+    image->SetSpacing(1.0, 1.0, 1.0);
+    image->SetOrigin(0.0, 0.0, 0.0);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    short *pointer = static_cast<short*>(image->GetScalarPointer());
+    for (int z = 0; z <= 10; z++)
+    {
+        for (int y = 0; y <= 10; y++)
+        {
+            for (int x = 0; x <= 10; x++)
+            {
+                *pointer++ = x;
+            }
+        }
+    }
+
+    return image;
+}
+
+DECLARE_TEST(test_CurvedPlanarReformation)
+
+#include "test_curvedplanarreformation.moc"
@@ -0,0 +1,281 @@
+#include "autotest.h"
+#include "drawerlinebatcher.h"
+
+#include "drawerline.h"
+#include "drawerpolyline.h"
+
+#include <vtkActor2D.h>
+#include <vtkCommand.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataMapper2D.h>
+#include <vtkPropAssembly.h>
+#include <vtkPropCollection.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+
+class test_DrawerLineBatcher : public QObject {
+Q_OBJECT
+
+private slots:
+    void canBatch_ShouldAcceptOnlyLinesAndPolylinesInWorldCoordinates();
+
+    void add_ShouldShareBatchBetweenPrimitivesWithTheSameStyle();
+
+    void add_ShouldCreateABatchForEachStyle();
+
+    void update_ShouldMovePrimitiveToTheBatchOfItsNewStyle();
+
+    void update_ShouldTakeHiddenPrimitivesOutOfTheirBatch();
+
+    void remove_ShouldDeleteEmptyBatches();
+
+    void remove_ShouldCompactTheBatchOnceBeforeRendering();
+
+    void destructor_ShouldRemovePrimitiveFromBatcher();
+
+private:
+    /// Returns a line from (x, 0, 0) to (x + 1, 0, 0)
+    static DrawerLine* createLine(double x);
+
+    /// Returns a polyline with the given number of points at height y
+    static DrawerPolyline* createPolyline(int numberOfPoints, double y);
+
+    /// Returns the number of props of the renderer
+    static int getNumberOfProps(vtkRenderer *renderer);
+
+    /// Returns the polydata of the first batch of the renderer
+    static vtkPolyData* getFirstBatchPolyData(vtkRenderer *renderer);
+};
+
+void test_DrawerLineBatcher::canBatch_ShouldAcceptOnlyLinesAndPolylinesInWorldCoordinates()
+{
+    DrawerLine line;
+    DrawerPolyline polyline;
+    DrawerLine displayLine;
+    displayLine.setCoordinateSystem(DrawerPrimitive::DisplayCoordinateSystem);
+
+    QVERIFY(DrawerLineBatcher::canBatch(&line));
+    QVERIFY(DrawerLineBatcher::canBatch(&polyline));
+    QVERIFY(!DrawerLineBatcher::canBatch(&displayLine));
+}
+
+void test_DrawerLineBatcher::add_ShouldShareBatchBetweenPrimitivesWithTheSameStyle()
+{
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    DrawerLineBatcher batcher(renderer);
+
+    QList<DrawerLine*> lines;
+    for (int i = 0; i < 100; i++)
+    {
+        DrawerLine *line = createLine(i);
+        lines << line;
+        batcher.add(line);
+    }
+
+    DrawerPolyline *polyline = new DrawerPolyline();
+    double point[3] = { 0.0, 0.0, 0.0 };
+    polyline->addPoint(point);
+    point[1] = 1.0;
+    polyline->addPoint(point);
+    point[0] = 1.0;
+    polyline->addPoint(point);
+    batcher.add(polyline);
+
+    QCOMPARE(batcher.getNumberOfBatches(), 1);
+    QCOMPARE(getNumberOfProps(renderer), 1);
+    QVERIFY(batcher.contains(lines.first()));
+    QCOMPARE(lines.first()->getLineBatcher(), &batcher);
+
+    delete polyline;
+    qDeleteAll(lines);
+
+    QCOMPARE(batcher.getNumberOfBatches(), 0);
+    QCOMPARE(getNumberOfProps(renderer), 0);
+}
+
+void test_DrawerLineBatcher::add_ShouldCreateABatchForEachStyle()
+{
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    DrawerLineBatcher batcher(renderer);
+
+    DrawerLine *line = createLine(0.0);
+    DrawerLine *redLine = createLine(1.0);
+    redLine->setColor(Qt::red);
+    DrawerLine *wideLine = createLine(2.0);
+    wideLine->setLineWidth(5.0);
+    batcher.add(line);
+    batcher.add(redLine);
+    batcher.add(wideLine);
+
+    QCOMPARE(batcher.getNumberOfBatches(), 3);
+    QCOMPARE(getNumberOfProps(renderer), 3);
+
+    delete line;
+    delete redLine;
+    delete wideLine;
+}
+
+void test_DrawerLineBatcher::update_ShouldMovePrimitiveToTheBatchOfItsNewStyle()
+{
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    DrawerLineBatcher batcher(renderer);
+
+    DrawerLine *line = createLine(0.0);
+    DrawerLine *otherLine = createLine(1.0);
+    batcher.add(line);
+    batcher.add(otherLine);
+
+    otherLine->setColor(Qt::red);
+    otherLine->update();
+
+    QCOMPARE(batcher.getNumberOfBatches(), 2);
+    QVERIFY(!otherLine->isModified());
+
+    line->setColor(Qt::red);
+    line->update();
+
+    QCOMPARE(batcher.getNumberOfBatches(), 1);
+
+    delete line;
+    delete otherLine;
+}
+
+void test_DrawerLineBatcher::update_ShouldTakeHiddenPrimitivesOutOfTheirBatch()
+{
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    DrawerLineBatcher batcher(renderer);
+
+    DrawerLine *line = createLine(0.0);
+    batcher.add(line);
+
+    line->visibilityOff();
+    line->update();
+
+    QCOMPARE(batcher.getNumberOfBatches(), 0);
+    QVERIFY(batcher.contains(line));
+
+    line->visibilityOn();
+    line->update();
+
+    QCOMPARE(batcher.getNumberOfBatches(), 1);
+
+    delete line;
+}
+
+void test_DrawerLineBatcher::remove_ShouldDeleteEmptyBatches()
+{
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    DrawerLineBatcher batcher(renderer);
+
+    DrawerLine *line = createLine(0.0);
+    DrawerLine *otherLine = createLine(1.0);
+    batcher.add(line);
+    batcher.add(otherLine);
+
+    QVERIFY(batcher.remove(line));
+    QVERIFY(!batcher.remove(line));
+    QCOMPARE(line->getLineBatcher(), static_cast<DrawerLineBatcher*>(0));
+    QCOMPARE(batcher.getNumberOfBatches(), 1);
+
+    QVERIFY(batcher.remove(otherLine));
+    QCOMPARE(batcher.getNumberOfBatches(), 0);
+    QCOMPARE(getNumberOfProps(renderer), 0);
+
+    delete line;
+    delete otherLine;
+}
+
+void test_DrawerLineBatcher::remove_ShouldCompactTheBatchOnceBeforeRendering()
+{
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    DrawerLineBatcher batcher(renderer);
+
+    DrawerPolyline *polyline2 = createPolyline(2, 2.0);
+    DrawerPolyline *polyline3 = createPolyline(3, 3.0);
+    DrawerPolyline *polyline4 = createPolyline(4, 4.0);
+    batcher.add(polyline2);
+    batcher.add(polyline3);
+    batcher.add(polyline4);
+
+    vtkPolyData *polyData = getFirstBatchPolyData(renderer);
+    QCOMPARE(polyData->GetNumberOfPoints(), vtkIdType(9));
+
+    // The range of the removed polyline can't be swapped with the last one, so it stays as a hole until the batch is compacted
+    batcher.remove(polyline3);
+    QCOMPARE(polyData->GetNumberOfPoints(), vtkIdType(9));
+
+    batcher.compact();
+    QCOMPARE(polyData->GetNumberOfPoints(), vtkIdType(6));
+    QCOMPARE(polyData->GetNumberOfLines(), vtkIdType(2));
+    QCOMPARE(polyData->GetPoint(2)[1], 4.0);
+
+    // The render compacts the batch
+    batcher.remove(polyline2);
+    renderer->InvokeEvent(vtkCommand::StartEvent);
+    QCOMPARE(polyData->GetNumberOfPoints(), vtkIdType(4));
+    QCOMPARE(polyData->GetNumberOfLines(), vtkIdType(1));
+    QCOMPARE(polyData->GetPoint(0)[1], 4.0);
+
+    // The remaining polyline is still updated in place
+    double point[3] = { 0.0, 5.0, 0.0 };
+    polyline4->setPoint(0, point);
+    polyline4->update();
+    QCOMPARE(polyData->GetPoint(0)[1], 5.0);
+
+    delete polyline2;
+    delete polyline3;
+    delete polyline4;
+}
+
+void test_DrawerLineBatcher::destructor_ShouldRemovePrimitiveFromBatcher()
+{
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    DrawerLine *line = createLine(0.0);
+
+    {
+        DrawerLineBatcher batcher(renderer);
+        batcher.add(line);
+    }
+
+    QCOMPARE(line->getLineBatcher(), static_cast<DrawerLineBatcher*>(0));
+    QCOMPARE(getNumberOfProps(renderer), 0);
+
+    delete line;
+}
+
+DrawerLine* test_DrawerLineBatcher::createLine(double x)
+{
+    DrawerLine *line = new DrawerLine();
+    line->setFirstPoint(x, 0.0, 0.0);
+    line->setSecondPoint(x + 1.0, 0.0, 0.0);
+    return line;
+}
+
+DrawerPolyline* test_DrawerLineBatcher::createPolyline(int numberOfPoints, double y)
+{
+    DrawerPolyline *polyline = new DrawerPolyline();
+    for (int i = 0; i < numberOfPoints; i++)
+    {
+        double point[3] = { static_cast<double>(i), y, 0.0 };
+        polyline->addPoint(point);
+    }
+    return polyline;
+}
+
+int test_DrawerLineBatcher::getNumberOfProps(vtkRenderer *renderer)
+{
+    return renderer->GetViewProps()->GetNumberOfItems();
+}
+
+vtkPolyData* test_DrawerLineBatcher::getFirstBatchPolyData(vtkRenderer *renderer)
+{
+    vtkPropAssembly *propAssembly = vtkPropAssembly::SafeDownCast(renderer->GetViewProps()->GetItemAsObject(0));
+    vtkActor2D *actor = vtkActor2D::SafeDownCast(propAssembly->GetParts()->GetItemAsObject(0));
+    return vtkPolyDataMapper2D::SafeDownCast(actor->GetMapper())->GetInput();
+}
+
+DECLARE_TEST(test_DrawerLineBatcher)
+
+#include "test_drawerlinebatcher.moc"
@@ -0,0 +1,203 @@
+#include "autotest.h"
+#include "drawerspatialindex.h"
+
+#include "drawerline.h"
+#include "mathtools.h"
+
+using namespace udg;
+
+class test_DrawerSpatialIndex : public QObject {
+Q_OBJECT
+
+private slots:
+    void getNearestErasablePrimitive_ShouldReturnNullWhenEmpty();
+
+    void getNearestErasablePrimitive_ShouldReturnSameAsLinearSearch();
+
+    void getNearestErasablePrimitive_ShouldIgnoreNonErasablePrimitives();
+
+    void getNearestErasablePrimitive_ShouldUseAxesOfThePlane();
+
+    void getNearestErasablePrimitive_ShouldSeeChangesAfterInvalidate();
+
+    void getErasablePrimitivesInside_ShouldReturnPrimitivesCompletelyInside();
+
+    void remove_ShouldTakePrimitiveOutOfTheIndex();
+
+private:
+    /// Returns an axial line from (x, y) to (x + length, y)
+    static DrawerLine* createLine(double x, double y, double length);
+};
+
+void test_DrawerSpatialIndex::getNearestErasablePrimitive_ShouldReturnNullWhenEmpty()
+{
+    DrawerSpatialIndex index(OrthogonalPlane::XYPlane);
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double closestPoint[3];
+    double distance;
+
+    QCOMPARE(index.getNearestErasablePrimitive(point, closestPoint, distance), static_cast<DrawerPrimitive*>(0));
+}
+
+void test_DrawerSpatialIndex::getNearestErasablePrimitive_ShouldReturnSameAsLinearSearch()
+{
+    DrawerSpatialIndex index(OrthogonalPlane::XYPlane);
+    QList<DrawerLine*> lines;
+    for (int i = 0; i < 20; i++)
+    {
+        for (int j = 0; j < 20; j++)
+        {
+            DrawerLine *line = createLine(i * 10.0, j * 10.0, 1.0 + (i + j) % 5);
+            lines << line;
+            index.insert(line);
+        }
+    }
+
+    QCOMPARE(index.getNumberOfPrimitives(), 400);
+
+    for (double x = -15.0; x < 215.0; x += 7.3)
+    {
+        for (double y = -15.0; y < 215.0; y += 11.1)
+        {
+            double point[3] = { x, y, 0.0 };
+            double expectedDistance = MathTools::DoubleMaximumValue;
+            double closestPoint[3];
+            foreach (DrawerLine *line, lines)
+            {
+                expectedDistance = qMin(expectedDistance, line->getDistanceToPoint(point, closestPoint));
+            }
+
+            double distance;
+            DrawerPrimitive *nearestPrimitive = index.getNearestErasablePrimitive(point, closestPoint, distance);
+
+            QVERIFY(nearestPrimitive != 0);
+            QCOMPARE(distance, expectedDistance);
+        }
+    }
+
+    qDeleteAll(lines);
+}
+
+void test_DrawerSpatialIndex::getNearestErasablePrimitive_ShouldIgnoreNonErasablePrimitives()
+{
+    DrawerSpatialIndex index(OrthogonalPlane::XYPlane);
+    DrawerLine *nearLine = createLine(0.0, 0.0, 1.0);
+    nearLine->setErasable(false);
+    DrawerLine *farLine = createLine(50.0, 50.0, 1.0);
+    index.insert(nearLine);
+    index.insert(farLine);
+
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double closestPoint[3];
+    double distance;
+
+    QCOMPARE(index.getNearestErasablePrimitive(point, closestPoint, distance), static_cast<DrawerPrimitive*>(farLine));
+
+    delete nearLine;
+    delete farLine;
+}
+
+void test_DrawerSpatialIndex::getNearestErasablePrimitive_ShouldUseAxesOfThePlane()
+{
+    // In the sagittal plane only y and z count, so the line at x = 100 is the nearest one
+    DrawerSpatialIndex index(OrthogonalPlane::YZPlane);
+    DrawerLine *line = new DrawerLine();
+    line->setFirstPoint(100.0, 0.0, 0.0);
+    line->setSecondPoint(100.0, 0.0, 10.0);
+    DrawerLine *otherLine = new DrawerLine();
+    otherLine->setFirstPoint(0.0, 20.0, 0.0);
+    otherLine->setSecondPoint(0.0, 20.0, 10.0);
+    index.insert(line);
+    index.insert(otherLine);
+
+    double point[3] = { 0.0, 1.0, 5.0 };
+    double closestPoint[3];
+    double distance;
+
+    QCOMPARE(index.getNearestErasablePrimitive(point, closestPoint, distance), static_cast<DrawerPrimitive*>(line));
+
+    delete line;
+    delete otherLine;
+}
+
+void test_DrawerSpatialIndex::getNearestErasablePrimitive_ShouldSeeChangesAfterInvalidate()
+{
+    DrawerSpatialIndex index(OrthogonalPlane::XYPlane);
+    DrawerLine *line = createLine(0.0, 0.0, 1.0);
+    DrawerLine *otherLine = createLine(50.0, 50.0, 1.0);
+    index.insert(line);
+    index.insert(otherLine);
+
+    double point[3] = { 100.0, 100.0, 0.0 };
+    double closestPoint[3];
+    double distance;
+
+    QCOMPARE(index.getNearestErasablePrimitive(point, closestPoint, distance), static_cast<DrawerPrimitive*>(otherLine));
+
+    line->setFirstPoint(99.0, 100.0, 0.0);
+    line->setSecondPoint(101.0, 100.0, 0.0);
+    index.invalidate();
+
+    QCOMPARE(index.getNearestErasablePrimitive(point, closestPoint, distance), static_cast<DrawerPrimitive*>(line));
+    QCOMPARE(distance, 0.0);
+
+    delete line;
+    delete otherLine;
+}
+
+void test_DrawerSpatialIndex::getErasablePrimitivesInside_ShouldReturnPrimitivesCompletelyInside()
+{
+    DrawerSpatialIndex index(OrthogonalPlane::XYPlane);
+    QList<DrawerLine*> lines;
+    for (int i = 0; i < 10; i++)
+    {
+        DrawerLine *line = createLine(i * 10.0, 0.0, 5.0);
+        lines << line;
+        index.insert(line);
+    }
+    lines.at(2)->setErasable(false);
+
+    // Contains the lines 1, 2 and 3 and half of the line 4
+    double bounds[6] = { 9.0, 42.0, -1.0, 1.0, -1000.0, 1000.0 };
+    QList<DrawerPrimitive*> primitives = index.getErasablePrimitivesInside(bounds);
+
+    QCOMPARE(primitives.size(), 2);
+    QVERIFY(primitives.contains(lines.at(1)));
+    QVERIFY(primitives.contains(lines.at(3)));
+
+    qDeleteAll(lines);
+}
+
+void test_DrawerSpatialIndex::remove_ShouldTakePrimitiveOutOfTheIndex()
+{
+    DrawerSpatialIndex index(OrthogonalPlane::XYPlane);
+    DrawerLine *line = createLine(0.0, 0.0, 1.0);
+    DrawerLine *otherLine = createLine(50.0, 50.0, 1.0);
+    index.insert(line);
+    index.insert(otherLine);
+
+    QVERIFY(index.remove(line));
+    QVERIFY(!index.remove(line));
+    QCOMPARE(index.getNumberOfPrimitives(), 1);
+
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double closestPoint[3];
+    double distance;
+
+    QCOMPARE(index.getNearestErasablePrimitive(point, closestPoint, distance), static_cast<DrawerPrimitive*>(otherLine));
+
+    delete line;
+    delete otherLine;
+}
+
+DrawerLine* test_DrawerSpatialIndex::createLine(double x, double y, double length)
+{
+    DrawerLine *line = new DrawerLine();
+    line->setFirstPoint(x, y, 0.0);
+    line->setSecondPoint(x + length, y, 0.0);
+    return line;
+}
+
+DECLARE_TEST(test_DrawerSpatialIndex)
+
+#include "test_drawerspatialindex.moc"
@@ -0,0 +1,284 @@
+#include "autotest.h"
+#include "gradientvolume.h"
+
+#include "fuzzycomparetesthelper.h"
+
+#include <vtkFiniteDifferenceGradientEstimator.h>
+#include <vtkImageData.h>
+#include <vtkRecursiveSphereDirectionEncoder.h>
+#include <vtkSmartPointer.h>
+
+#include <cmath>
+
+using namespace udg;
+using namespace testing;
+
+class test_GradientVolume : public QObject {
+Q_OBJECT
+
+private slots:
+    void compute_ShouldBeEmptyWithoutScalars();
+
+    void compute_CentralDifferencesShouldBeExactForLinearRamps_data();
+    void compute_CentralDifferencesShouldBeExactForLinearRamps();
+
+    void compute_LinearRegression4DShouldMatchReference_data();
+    void compute_LinearRegression4DShouldMatchReference();
+
+    void compute_ShouldComputeMagnitudesAndMaximum();
+
+    void encode_ShouldEncodeNormalsAndMagnitudes();
+
+    void getNormal_ShouldMatchTheNormalsOfTheFiniteDifferenceEstimator();
+
+private:
+    /// Returns a 6x5x4 image with spacing (0.5, 1, 2) and value 2x + 3y + z at each voxel
+    static vtkSmartPointer<vtkImageData> createRamp(int scalarType);
+    /// Returns a 7x6x5 image with spacing (1, 0.5, 1.5) and pseudo-random values in [0, 100)
+    static vtkSmartPointer<vtkImageData> createNoise();
+
+    /// Computes the 4D linear regression gradient of the given voxel voxel by voxel, as the old estimator did
+    static Vector3 referenceLinearRegression4D(vtkImageData *image, int x, int y, int z, int radius);
+};
+
+void test_GradientVolume::compute_ShouldBeEmptyWithoutScalars()
+{
+    GradientVolume gradientVolume;
+    QVERIFY(gradientVolume.isEmpty());
+
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    gradientVolume.compute(image);
+    QVERIFY(gradientVolume.isEmpty());
+
+    image->SetExtent(0, 1, 0, 1, 0, 1);
+    image->AllocateScalars(VTK_SHORT, 3);
+    gradientVolume.compute(image);
+    QVERIFY(gradientVolume.isEmpty());
+}
+
+void test_GradientVolume::compute_CentralDifferencesShouldBeExactForLinearRamps_data()
+{
+    QTest::addColumn<int>("scalarType");
+
+    QTest::newRow("unsigned char") << VTK_UNSIGNED_CHAR;
+    QTest::newRow("short") << VTK_SHORT;
+    QTest::newRow("unsigned int") << VTK_UNSIGNED_INT;
+    QTest::newRow("float") << VTK_FLOAT;
+}
+
+void test_GradientVolume::compute_CentralDifferencesShouldBeExactForLinearRamps()
+{
+    QFETCH(int, scalarType);
+
+    vtkSmartPointer<vtkImageData> image = createRamp(scalarType);
+    GradientVolume gradientVolume;
+    gradientVolume.compute(image, GradientVolume::CentralDifferences);
+
+    int dimensions[3];
+    gradientVolume.getDimensions(dimensions);
+    QCOMPARE(dimensions[0], 6);
+    QCOMPARE(dimensions[1], 5);
+    QCOMPARE(dimensions[2], 4);
+    QCOMPARE(gradientVolume.getNumberOfVoxels(), 120);
+
+    // Borders included, since one-sided differences are also exact for a ramp
+    for (int i = 0; i < gradientVolume.getNumberOfVoxels(); i++)
+    {
+        Vector3 gradient = gradientVolume.getGradient(i);
+        QString message = QString("voxel %1: %2").arg(i).arg(gradient.toString());
+        QVERIFY2(FuzzyCompareTestHelper::fuzzyCompare(gradient, Vector3(4.0, 3.0, 0.5), 0.0001), qPrintable(message));
+    }
+}
+
+void test_GradientVolume::compute_LinearRegression4DShouldMatchReference_data()
+{
+    QTest::addColumn<int>("radius");
+
+    QTest::newRow("radius 1") << 1;
+    QTest::newRow("radius 2") << 2;
+}
+
+void test_GradientVolume::compute_LinearRegression4DShouldMatchReference()
+{
+    QFETCH(int, radius);
+
+    vtkSmartPointer<vtkImageData> image = createNoise();
+    GradientVolume gradientVolume;
+    gradientVolume.compute(image, GradientVolume::LinearRegression4D, radius);
+
+    QCOMPARE(gradientVolume.getNumberOfVoxels(), 210);
+
+    for (int z = 0, i = 0; z < 5; z++)
+    {
+        for (int y = 0; y < 6; y++)
+        {
+            for (int x = 0; x < 7; x++, i++)
+            {
+                Vector3 expected = referenceLinearRegression4D(image, x, y, z, radius);
+                Vector3 gradient = gradientVolume.getGradient(i);
+                QString message = QString("voxel (%1, %2, %3): %4 != %5").arg(x).arg(y).arg(z).arg(gradient.toString()).arg(expected.toString());
+                QVERIFY2(FuzzyCompareTestHelper::fuzzyCompare(gradient, expected, 0.01), qPrintable(message));
+            }
+        }
+    }
+}
+
+void test_GradientVolume::compute_ShouldComputeMagnitudesAndMaximum()
+{
+    vtkSmartPointer<vtkImageData> image = createNoise();
+    GradientVolume gradientVolume;
+    gradientVolume.compute(image, GradientVolume::CentralDifferences);
+
+    double maximum = 0.0;
+    for (int i = 0; i < gradientVolume.getNumberOfVoxels(); i++)
+    {
+        double expected = gradientVolume.getGradient(i).length();
+        QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(gradientVolume.getMagnitude(i), expected, 0.001));
+        maximum = qMax(maximum, expected);
+    }
+
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(gradientVolume.getMaximumMagnitude(), maximum, 0.001));
+}
+
+void test_GradientVolume::encode_ShouldEncodeNormalsAndMagnitudes()
+{
+    const float gradientX[] = { 3.0f, 0.0f, 0.1f, -200.0f };
+    const float gradientY[] = { 0.0f, -4.0f, 0.0f, 0.0f };
+    const float gradientZ[] = { 4.0f, 0.0f, 0.0f, 0.0f };
+    unsigned short encodedNormals[4];
+    unsigned char gradientMagnitudes[4];
+
+    vtkSmartPointer<vtkRecursiveSphereDirectionEncoder> directionEncoder = vtkSmartPointer<vtkRecursiveSphereDirectionEncoder>::New();
+    GradientVolume::encode(gradientX, gradientY, gradientZ, 4, directionEncoder, 0.5f, encodedNormals, 2.0f, 1.0f, gradientMagnitudes);
+
+    float normal0[3] = { 0.6f, 0.0f, 0.8f };
+    float normal1[3] = { 0.0f, -1.0f, 0.0f };
+    float zeroNormal[3] = { 0.0f, 0.0f, 0.0f };
+    float normal3[3] = { -1.0f, 0.0f, 0.0f };
+    QCOMPARE(encodedNormals[0], static_cast<unsigned short>(directionEncoder->GetEncodedDirection(normal0)));
+    QCOMPARE(encodedNormals[1], static_cast<unsigned short>(directionEncoder->GetEncodedDirection(normal1)));
+    QCOMPARE(encodedNormals[2], static_cast<unsigned short>(directionEncoder->GetEncodedDirection(zeroNormal)));
+    QCOMPARE(encodedNormals[3], static_cast<unsigned short>(directionEncoder->GetEncodedDirection(normal3)));
+
+    QCOMPARE(gradientMagnitudes[0], static_cast<unsigned char>(12));
+    QCOMPARE(gradientMagnitudes[1], static_cast<unsigned char>(10));
+    QCOMPARE(gradientMagnitudes[2], static_cast<unsigned char>(2));
+    QCOMPARE(gradientMagnitudes[3], static_cast<unsigned char>(255));
+}
+
+void test_GradientVolume::getNormal_ShouldMatchTheNormalsOfTheFiniteDifferenceEstimator()
+{
+    vtkSmartPointer<vtkImageData> image = createNoise();
+    GradientVolume gradientVolume;
+    gradientVolume.compute(image, GradientVolume::CentralDifferences);
+
+    vtkSmartPointer<vtkFiniteDifferenceGradientEstimator> gradientEstimator = vtkSmartPointer<vtkFiniteDifferenceGradientEstimator>::New();
+    gradientEstimator->SetInputData(image);
+    unsigned short *encodedNormals = gradientEstimator->GetEncodedNormals();
+    vtkDirectionEncoder *directionEncoder = gradientEstimator->GetDirectionEncoder();
+
+    // The estimator pads the borders with zeros, so only the inner voxels are compared, and its normals are quantized
+    for (int z = 1; z < 4; z++)
+    {
+        for (int y = 1; y < 5; y++)
+        {
+            for (int x = 1; x < 6; x++)
+            {
+                int offset = x + 7 * (y + 6 * z);
+                Vector3 normal = gradientVolume.getNormal(offset);
+
+                if (gradientVolume.getMagnitude(offset) == 0.0f)
+                {
+                    QCOMPARE(normal.length(), 0.0);
+                    continue;
+                }
+
+                float *decodedNormal = directionEncoder->GetDecodedGradient(encodedNormals[offset]);
+                Vector3 expectedNormal(decodedNormal[0], decodedNormal[1], decodedNormal[2]);
+                QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(normal.length(), 1.0, 0.0001));
+                QVERIFY2(normal * expectedNormal > 0.99, qPrintable(QString("voxel %1: normal %2, expected %3").arg(offset).arg(normal.toString())
+                                                                     .arg(expectedNormal.toString())));
+            }
+        }
+    }
+}
+
+vtkSmartPointer<vtkImageData> test_GradientVolume::createRamp(int scalarType)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, 5, 0, 4, 0, 3);
+    image->SetSpacing(0.5, 1.0, 2.0);
+    image->AllocateScalars(scalarType, 1);
+
+    for (int z = 0; z < 4; z++)
+    {
+        for (int y = 0; y < 5; y++)
+        {
+            for (int x = 0; x < 6; x++)
+            {
+                image->SetScalarComponentFromDouble(x, y, z, 0, 2 * x + 3 * y + z);
+            }
+        }
+    }
+
+    return image;
+}
+
+vtkSmartPointer<vtkImageData> test_GradientVolume::createNoise()
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, 6, 0, 5, 0, 4);
+    image->SetSpacing(1.0, 0.5, 1.5);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    // Simple linear congruential generator, so that the values are the same on every run
+    unsigned int seed = 12345;
+    for (int z = 0; z < 5; z++)
+    {
+        for (int y = 0; y < 6; y++)
+        {
+            for (int x = 0; x < 7; x++)
+            {
+                seed = seed * 1103515245 + 12345;
+                image->SetScalarComponentFromDouble(x, y, z, 0, (seed >> 16) % 100);
+            }
+        }
+    }
+
+    return image;
+}
+
+Vector3 test_GradientVolume::referenceLinearRegression4D(vtkImageData *image, int x, int y, int z, int radius)
+{
+    int dimensions[3];
+    image->GetDimensions(dimensions);
+    double *spacing = image->GetSpacing();
+
+    double a = 0.0, b = 0.0, c = 0.0;
+    for (int ix = -radius; ix <= radius; ix++)
+    {
+        for (int iy = -radius; iy <= radius; iy++)
+        {
+            for (int iz = -radius; iz <= radius; iz++)
+            {
+                if ((ix == 0 && iy == 0 && iz == 0) || x + ix < 0 || x + ix >= dimensions[0] || y + iy < 0 || y + iy >= dimensions[1] || z + iz < 0 ||
+                    z + iz >= dimensions[2])
+                {
+                    continue;
+                }
+
+                double weight = 1.0 / std::sqrt(static_cast<double>(ix * ix + iy * iy + iz * iz));
+                double value = image->GetScalarComponentAsDouble(x + ix, y + iy, z + iz, 0) * weight;
+                a += value * ix;
+                b += value * iy;
+                c += value * iz;
+            }
+        }
+    }
+
+    return Vector3(a / (2.0 * spacing[0]), b / (2.0 * spacing[1]), c / (2.0 * spacing[2]));
+}
+
+DECLARE_TEST(test_GradientVolume)
+
+#include "test_gradientvolume.moc"
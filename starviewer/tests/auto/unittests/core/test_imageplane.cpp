@@ -25,6 +25,9 @@ private slots:
     void getIntersections_ComputesCorrectIntersections_data();
     void getIntersections_ComputesCorrectIntersections();
 
+    void getIntersections_WithCorners_ComputesTheSameIntersectionsAsWithCornersLocation_data();
+    void getIntersections_WithCorners_ComputesTheSameIntersectionsAsWithCornersLocation();
+
     void getDistanceToPoint_ReturnsExpectedValue_data();
     void getDistanceToPoint_ReturnsExpectedValue();
 
@@ -258,6 +261,27 @@ void test_ImagePlane::getIntersections_ComputesCorrectIntersections()
     QCOMPARE(intersection2, expectedIntersection2);
 }
 
+void test_ImagePlane::getIntersections_WithCorners_ComputesTheSameIntersectionsAsWithCornersLocation_data()
+{
+    getIntersections_ComputesCorrectIntersections_data();
+}
+
+void test_ImagePlane::getIntersections_WithCorners_ComputesTheSameIntersectionsAsWithCornersLocation()
+{
+    QFETCH(ImagePlane, imagePlane1);
+    QFETCH(ImagePlane, imagePlane2);
+    QFETCH(ImagePlane::CornersLocation, cornersLocation);
+    QFETCH(bool, expectedReturnValue);
+    QFETCH(Vector3, expectedIntersection1);
+    QFETCH(Vector3, expectedIntersection2);
+
+    Vector3 intersection1, intersection2;
+
+    QCOMPARE(ImagePlane::getIntersections(imagePlane1.getCorners(cornersLocation), &imagePlane2, intersection1, intersection2), expectedReturnValue);
+    QCOMPARE(intersection1, expectedIntersection1);
+    QCOMPARE(intersection2, expectedIntersection2);
+}
+
 void test_ImagePlane::getDistanceToPoint_ReturnsExpectedValue_data()
 {
     QTest::addColumn<Vector3>("point");
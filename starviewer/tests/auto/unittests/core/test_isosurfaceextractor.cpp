@@ -0,0 +1,131 @@
+#include "autotest.h"
+#include "isosurfaceextractor.h"
+
+#include <vtkImageData.h>
+#include <vtkImageMarchingCubes.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+
+#include <cmath>
+
+using namespace udg;
+
+class test_IsosurfaceExtractor : public QObject {
+Q_OBJECT
+
+private slots:
+    void getIsosurface_ShouldReturnNullWithoutInput();
+
+    void getIsosurface_ShouldReturnSameTrianglesAsMarchingCubes_data();
+    void getIsosurface_ShouldReturnSameTrianglesAsMarchingCubes();
+
+    void getIsosurface_ShouldReturnCachedIsosurface();
+
+    void getNumberOfActiveBlocks_ShouldReturnExpectedValue_data();
+    void getNumberOfActiveBlocks_ShouldReturnExpectedValue();
+
+private:
+    /// Returns a 50x50x50 image with unit spacing where the value of each voxel is its distance to the voxel (10, 10, 10) rounded down
+    static vtkSmartPointer<vtkImageData> createDistanceImage();
+};
+
+void test_IsosurfaceExtractor::getIsosurface_ShouldReturnNullWithoutInput()
+{
+    IsosurfaceExtractor extractor;
+
+    QVERIFY(!extractor.getIsosurface(5.0));
+}
+
+void test_IsosurfaceExtractor::getIsosurface_ShouldReturnSameTrianglesAsMarchingCubes_data()
+{
+    QTest::addColumn<double>("isoValue");
+
+    QTest::newRow("inside first block") << 5.5;
+    QTest::newRow("across blocks") << 25.5;
+    QTest::newRow("outside range") << 100.0;
+}
+
+void test_IsosurfaceExtractor::getIsosurface_ShouldReturnSameTrianglesAsMarchingCubes()
+{
+    QFETCH(double, isoValue);
+
+    vtkSmartPointer<vtkImageData> image = createDistanceImage();
+    vtkNew<vtkImageMarchingCubes> marchingCubes;
+    marchingCubes->SetInputData(image);
+    marchingCubes->SetValue(0, isoValue);
+    marchingCubes->Update();
+
+    IsosurfaceExtractor extractor;
+    extractor.setInput(image);
+    vtkPolyData *isosurface = extractor.getIsosurface(isoValue);
+
+    QVERIFY(isosurface);
+    QCOMPARE(isosurface->GetNumberOfPolys(), marchingCubes->GetOutput()->GetNumberOfPolys());
+    QVERIFY(isosurface->GetPointData()->GetNormals());
+    QCOMPARE(isosurface->GetPointData()->GetNormals()->GetNumberOfTuples(), isosurface->GetNumberOfPoints());
+}
+
+void test_IsosurfaceExtractor::getIsosurface_ShouldReturnCachedIsosurface()
+{
+    vtkSmartPointer<vtkImageData> image = createDistanceImage();
+    IsosurfaceExtractor extractor;
+    extractor.setInput(image);
+
+    vtkPolyData *isosurface = extractor.getIsosurface(10.5);
+    extractor.getIsosurface(20.5);
+
+    QCOMPARE(extractor.getIsosurface(10.5), isosurface);
+}
+
+void test_IsosurfaceExtractor::getNumberOfActiveBlocks_ShouldReturnExpectedValue_data()
+{
+    QTest::addColumn<double>("isoValue");
+    QTest::addColumn<int>("expectedNumberOfActiveBlocks");
+
+    // With blocks of 32 cells the image has 2x2x2 blocks. The first one contains the center of the distances and has a maximum of 38.
+    // The others have a minimum of 22 if they are next to it in one dimension, 31 if they are in two dimensions and 38 otherwise.
+    QTest::newRow("below range") << -1.0 << 0;
+    QTest::newRow("inside first block") << 5.5 << 1;
+    QTest::newRow("across blocks") << 25.5 << 4;
+    QTest::newRow("in all blocks but the farthest one") << 35.5 << 7;
+    QTest::newRow("above range") << 100.0 << 0;
+}
+
+void test_IsosurfaceExtractor::getNumberOfActiveBlocks_ShouldReturnExpectedValue()
+{
+    QFETCH(double, isoValue);
+    QFETCH(int, expectedNumberOfActiveBlocks);
+
+    IsosurfaceExtractor extractor;
+    extractor.setInput(createDistanceImage());
+
+    QCOMPARE(extractor.getNumberOfActiveBlocks(isoValue), expectedNumberOfActiveBlocks);
+}
+
+vtkSmartPointer<vtkImageData> test_IsosurfaceExtractor::createDistanceImage()
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, 49, 0, 49, 0, 49);
+    image->SetSpacing(1.0, 1.0, 1.0);
+    image->SetOrigin(0.0, 0.0, 0.0);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    short *pointer = static_cast<short*>(image->GetScalarPointer());
+    for (int z = 0; z < 50; z++)
+    {
+        for (int y = 0; y < 50; y++)
+        {
+            for (int x = 0; x < 50; x++)
+            {
+                *pointer++ = static_cast<short>(std::sqrt((x - 10.0) * (x - 10.0) + (y - 10.0) * (y - 10.0) + (z - 10.0) * (z - 10.0)));
+            }
+        }
+    }
+
+    return image;
+}
+
+DECLARE_TEST(test_IsosurfaceExtractor)
+
+#include "test_isosurfaceextractor.moc"
@@ -0,0 +1,275 @@
+#include "autotest.h"
+#include "maskstatistics.h"
+
+#include <QSignalSpy>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+
+class test_MaskStatistics : public QObject {
+Q_OBJECT
+
+private slots:
+    void countVoxelsInRange_ShouldReturnMinusOneWithoutHistogram();
+
+    void countVoxelsInRange_ShouldReturnExactCountsForIntegers_data();
+    void countVoxelsInRange_ShouldReturnExactCountsForIntegers();
+
+    void countVoxelsInRange_ShouldCountRealValues();
+
+    void requestThresholdVolume_ShouldBeAnsweredWhenTheHistogramIsReady();
+
+    void setMask_ShouldCountTheInsideVoxels();
+
+    void updateMask_ShouldOnlyRecountTheGivenSlices();
+
+    void updateMask_ShouldCountTheSlicesAsTheyWereWhenCalled();
+
+    void setThresholdMask_ShouldTakeTheCountFromTheHistogram();
+
+    void updateMask_ShouldRecountEditedSlicesOfAThresholdMask();
+
+private:
+    /// Returns a 4x4x3 image with spacing (0.5, 0.5, 2) where each slice z has the values 100 * z + i for i in [0, 16)
+    static vtkSmartPointer<vtkImageData> createImage(int scalarType);
+
+    /// Returns a mask of the given image with the value 255 for the voxels in [lower, upper] and 0 for the rest
+    static vtkSmartPointer<vtkImageData> createThresholdMask(vtkImageData *image, double lower, double upper);
+
+    /// Computes the histogram of the given image and waits until it's ready
+    static void computeHistogram(MaskStatistics &statistics, vtkImageData *image);
+};
+
+void test_MaskStatistics::countVoxelsInRange_ShouldReturnMinusOneWithoutHistogram()
+{
+    MaskStatistics statistics;
+
+    QVERIFY(!statistics.isHistogramReady());
+    QCOMPARE(statistics.countVoxelsInRange(0.0, 100.0), qint64(-1));
+}
+
+void test_MaskStatistics::countVoxelsInRange_ShouldReturnExactCountsForIntegers_data()
+{
+    QTest::addColumn<double>("lower");
+    QTest::addColumn<double>("upper");
+    QTest::addColumn<qint64>("expectedCount");
+
+    QTest::newRow("whole range") << 0.0 << 215.0 << qint64(48);
+    QTest::newRow("wider than the range") << -1000.0 << 1000.0 << qint64(48);
+    QTest::newRow("single value") << 107.0 << 107.0 << qint64(1);
+    QTest::newRow("one slice") << 100.0 << 115.0 << qint64(16);
+    QTest::newRow("between slices") << 16.0 << 99.0 << qint64(0);
+    QTest::newRow("real bounds") << 4.5 << 100.5 << qint64(12);
+    QTest::newRow("empty range") << 10.0 << 5.0 << qint64(0);
+    QTest::newRow("below the range") << -10.0 << -1.0 << qint64(0);
+    QTest::newRow("above the range") << 216.0 << 300.0 << qint64(0);
+}
+
+void test_MaskStatistics::countVoxelsInRange_ShouldReturnExactCountsForIntegers()
+{
+    QFETCH(double, lower);
+    QFETCH(double, upper);
+    QFETCH(qint64, expectedCount);
+
+    vtkSmartPointer<vtkImageData> image = createImage(VTK_SHORT);
+    MaskStatistics statistics;
+    computeHistogram(statistics, image);
+
+    QCOMPARE(statistics.countVoxelsInRange(lower, upper), expectedCount);
+}
+
+void test_MaskStatistics::countVoxelsInRange_ShouldCountRealValues()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(VTK_FLOAT);
+    MaskStatistics statistics;
+    computeHistogram(statistics, image);
+
+    QCOMPARE(statistics.countVoxelsInRange(0.0, 215.0), qint64(48));
+    QCOMPARE(statistics.countVoxelsInRange(0.0, 107.5), qint64(24));
+    QCOMPARE(statistics.countVoxelsInRange(199.5, 215.0), qint64(16));
+}
+
+void test_MaskStatistics::requestThresholdVolume_ShouldBeAnsweredWhenTheHistogramIsReady()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(VTK_SHORT);
+    MaskStatistics statistics;
+    QSignalSpy spy(&statistics, SIGNAL(thresholdVolumeComputed(double, double, qint64, double)));
+
+    statistics.setVolume(image);
+    statistics.requestThresholdVolume(0.0, 10.0);
+    statistics.requestThresholdVolume(100.0, 115.0);
+
+    if (spy.isEmpty())
+    {
+        QVERIFY(spy.wait());
+    }
+    QCOMPARE(spy.count(), 1);
+
+    QList<QVariant> arguments = spy.takeFirst();
+    QCOMPARE(arguments.at(0).toDouble(), 100.0);
+    QCOMPARE(arguments.at(1).toDouble(), 115.0);
+    QCOMPARE(arguments.at(2).value<qint64>(), qint64(16));
+    QCOMPARE(arguments.at(3).toDouble(), 8.0);
+
+    // Once the histogram is ready requests are answered at once
+    statistics.requestThresholdVolume(0.0, 215.0);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(2).value<qint64>(), qint64(48));
+}
+
+void test_MaskStatistics::setMask_ShouldCountTheInsideVoxels()
+{
+    vtkSmartPointer<vtkImageData> mask = createImage(VTK_SHORT);
+    MaskStatistics statistics;
+    QSignalSpy spy(&statistics, SIGNAL(maskVolumeComputed(qint64, double)));
+
+    statistics.setMask(mask, 107.0);
+    QVERIFY(!statistics.isMaskUpToDate());
+    QVERIFY(spy.wait());
+
+    QVERIFY(statistics.isMaskUpToDate());
+    QCOMPARE(spy.first().at(0).value<qint64>(), qint64(1));
+    QCOMPARE(statistics.getMaskVoxels(), qint64(1));
+    QCOMPARE(statistics.getMaskVolume(), 0.5);
+}
+
+void test_MaskStatistics::updateMask_ShouldOnlyRecountTheGivenSlices()
+{
+    vtkSmartPointer<vtkImageData> mask = createImage(VTK_SHORT);
+    MaskStatistics statistics;
+    QSignalSpy spy(&statistics, SIGNAL(maskVolumeComputed(qint64, double)));
+
+    statistics.setMask(mask, 107.0);
+    QVERIFY(spy.wait());
+
+    short *scalars = static_cast<short*>(mask->GetScalarPointer());
+    // Two voxels of slice 1 and one of slice 0 are set to the inside value, but only slice 1 is updated
+    scalars[16] = 107;
+    scalars[17] = 107;
+    scalars[0] = 107;
+
+    statistics.updateMask(1, 1);
+    QVERIFY(spy.wait());
+    QCOMPARE(statistics.getMaskVoxels(), qint64(3));
+
+    statistics.updateMask();
+    QVERIFY(spy.wait());
+    QCOMPARE(statistics.getMaskVoxels(), qint64(4));
+    QCOMPARE(spy.count(), 3);
+}
+
+void test_MaskStatistics::updateMask_ShouldCountTheSlicesAsTheyWereWhenCalled()
+{
+    vtkSmartPointer<vtkImageData> mask = createImage(VTK_SHORT);
+    MaskStatistics statistics;
+    QSignalSpy spy(&statistics, SIGNAL(maskVolumeComputed(qint64, double)));
+
+    statistics.setMask(mask, 107.0);
+    QVERIFY(spy.wait());
+
+    short *scalars = static_cast<short*>(mask->GetScalarPointer());
+    scalars[16] = 107;
+    statistics.updateMask(1, 1);
+    // Modified after the count has started without updating it
+    scalars[17] = 107;
+
+    QVERIFY(spy.wait());
+    QCOMPARE(statistics.getMaskVoxels(), qint64(2));
+}
+
+void test_MaskStatistics::setThresholdMask_ShouldTakeTheCountFromTheHistogram()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(VTK_SHORT);
+    vtkSmartPointer<vtkImageData> mask = createThresholdMask(image, 104.0, 211.0);
+    MaskStatistics statistics;
+    computeHistogram(statistics, image);
+    QSignalSpy spy(&statistics, SIGNAL(maskVolumeComputed(qint64, double)));
+
+    statistics.setThresholdMask(mask, 255.0, 104.0, 211.0);
+
+    // The count is answered at once without counting the mask
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(statistics.isMaskUpToDate());
+    QCOMPARE(spy.first().at(0).value<qint64>(), qint64(24));
+    QCOMPARE(statistics.getMaskVoxels(), qint64(24));
+    QCOMPARE(statistics.getMaskVolume(), 12.0);
+}
+
+void test_MaskStatistics::updateMask_ShouldRecountEditedSlicesOfAThresholdMask()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(VTK_SHORT);
+    vtkSmartPointer<vtkImageData> mask = createThresholdMask(image, 104.0, 211.0);
+    MaskStatistics statistics;
+    computeHistogram(statistics, image);
+    QSignalSpy spy(&statistics, SIGNAL(maskVolumeComputed(qint64, double)));
+
+    statistics.setThresholdMask(mask, 255.0, 104.0, 211.0);
+
+    short *scalars = static_cast<short*>(mask->GetScalarPointer());
+    // Slice 1 loses two voxels and slice 0, which had none, gains one
+    scalars[20] = 0;
+    scalars[21] = 0;
+    scalars[0] = 255;
+
+    statistics.updateMask(0, 1);
+    QVERIFY(spy.wait());
+    QCOMPARE(statistics.getMaskVoxels(), qint64(23));
+
+    // Recounting slices already counted doesn't change the result
+    statistics.updateMask();
+    QVERIFY(spy.wait());
+    QCOMPARE(statistics.getMaskVoxels(), qint64(23));
+}
+
+vtkSmartPointer<vtkImageData> test_MaskStatistics::createImage(int scalarType)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, 3, 0, 3, 0, 2);
+    image->SetSpacing(0.5, 0.5, 2.0);
+    image->AllocateScalars(scalarType, 1);
+
+    for (int z = 0; z < 3; z++)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            image->SetScalarComponentFromDouble(i % 4, i / 4, z, 0, 100 * z + i);
+        }
+    }
+
+    return image;
+}
+
+vtkSmartPointer<vtkImageData> test_MaskStatistics::createThresholdMask(vtkImageData *image, double lower, double upper)
+{
+    vtkSmartPointer<vtkImageData> mask = vtkSmartPointer<vtkImageData>::New();
+    mask->CopyStructure(image);
+    mask->AllocateScalars(VTK_SHORT, 1);
+
+    short *maskScalars = static_cast<short*>(mask->GetScalarPointer());
+    for (vtkIdType i = 0; i < image->GetNumberOfPoints(); i++)
+    {
+        double value = image->GetPointData()->GetScalars()->GetComponent(i, 0);
+        maskScalars[i] = value >= lower && value <= upper ? 255 : 0;
+    }
+
+    return mask;
+}
+
+void test_MaskStatistics::computeHistogram(MaskStatistics &statistics, vtkImageData *image)
+{
+    QSignalSpy spy(&statistics, SIGNAL(thresholdVolumeComputed(double, double, qint64, double)));
+    statistics.setVolume(image);
+    statistics.requestThresholdVolume(0.0, 0.0);
+    if (spy.isEmpty())
+    {
+        QVERIFY(spy.wait());
+    }
+}
+
+DECLARE_TEST(test_MaskStatistics)
+
+#include "test_maskstatistics.moc"
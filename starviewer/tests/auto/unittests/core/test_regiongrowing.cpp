@@ -0,0 +1,250 @@
+#include "autotest.h"
+#include "regiongrowing.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+
+class test_RegionGrowing : public QObject {
+Q_OBJECT
+
+private slots:
+    void grow_ShouldReturnEmptyRegionIfSeedIsOutOfRange();
+
+    void grow_ShouldReturnConnectedVoxelsInRange();
+
+    void grow_ShouldBeConfinedToRegionExtent();
+
+    void grow_ShouldGrowIn3DWithWholeExtent();
+
+    void grow_ShouldReturnSameRegionIncrementallyAndFromScratch();
+
+    void grow_ShouldShrinkWhenRangeNarrows();
+
+    void grow_ShouldReturnRegionBoundsWhenResumedFromRejectedSeed();
+
+    void getMaskImage_ShouldReturnExpectedMask();
+
+    void grow_Benchmark_data();
+    void grow_Benchmark();
+
+private:
+    /// Returns an image of size x size voxels with value 0 except in a square ring of value 100 with a gap of value 50 in its top side.
+    /// The ring is the square between size / 4 and 3 * size / 4 minus the square between 3 * size / 8 and 5 * size / 8, and the gap is
+    /// size / 8 voxels wide. Each slice has its index added to the values.
+    static vtkSmartPointer<vtkImageData> createImage(int size, int numberOfSlices = 1);
+};
+
+void test_RegionGrowing::grow_ShouldReturnEmptyRegionIfSeedIsOutOfRange()
+{
+    RegionGrowing regionGrowing;
+    regionGrowing.setInput(createImage(16));
+    int seed[3] = { 0, 0, 0 };
+    regionGrowing.setSeed(seed);
+
+    QCOMPARE(regionGrowing.grow(10.0, 20.0), 0);
+    QVERIFY(!regionGrowing.isInRegion(0, 0, 0));
+}
+
+void test_RegionGrowing::grow_ShouldReturnConnectedVoxelsInRange()
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, 4, 0, 2, 0, 0);
+    image->AllocateScalars(VTK_SHORT, 1);
+    // Rows from y = 0 to y = 2
+    short values[15] = { 1, 1, 1, 0, 1,
+                         0, 1, 0, 0, 1,
+                         1, 1, 0, 1, 1 };
+    std::copy(values, values + 15, static_cast<short*>(image->GetScalarPointer()));
+
+    RegionGrowing regionGrowing;
+    regionGrowing.setInput(image);
+    int seed[3] = { 0, 0, 0 };
+    regionGrowing.setSeed(seed);
+
+    QCOMPARE(regionGrowing.grow(1.0, 1.0), 6);
+    QVERIFY(regionGrowing.isInRegion(2, 0, 0));
+    QVERIFY(regionGrowing.isInRegion(0, 2, 0));
+    QVERIFY(!regionGrowing.isInRegion(4, 0, 0));
+    QVERIFY(!regionGrowing.isInRegion(0, 1, 0));
+
+    int bounds[6];
+    regionGrowing.getRegionBounds(bounds);
+    QCOMPARE(bounds[0], 0);
+    QCOMPARE(bounds[1], 2);
+    QCOMPARE(bounds[2], 0);
+    QCOMPARE(bounds[3], 2);
+}
+
+void test_RegionGrowing::grow_ShouldBeConfinedToRegionExtent()
+{
+    RegionGrowing regionGrowing;
+    regionGrowing.setInput(createImage(16, 4));
+    int extent[6] = { 1, 14, 1, 14, 2, 2 };
+    regionGrowing.setRegionExtent(extent);
+    int seed[3] = { 1, 1, 2 };
+    regionGrowing.setSeed(seed);
+
+    // The outer background of the slice without the border of 1 voxel
+    QCOMPARE(regionGrowing.grow(0.0, 10.0), 14 * 14 - 8 * 8);
+    QVERIFY(!regionGrowing.isInRegion(0, 0, 2));
+    QVERIFY(!regionGrowing.isInRegion(1, 1, 1));
+}
+
+void test_RegionGrowing::grow_ShouldGrowIn3DWithWholeExtent()
+{
+    RegionGrowing regionGrowing;
+    regionGrowing.setInput(createImage(16, 4));
+    int seed[3] = { 0, 0, 0 };
+    regionGrowing.setSeed(seed);
+
+    QCOMPARE(regionGrowing.grow(0.0, 10.0), 4 * (16 * 16 - 8 * 8));
+    QVERIFY(regionGrowing.isInRegion(15, 15, 3));
+
+    vtkSmartPointer<vtkImageData> mask = regionGrowing.getMaskImage();
+    int *dimensions = mask->GetDimensions();
+    QCOMPARE(dimensions[2], 4);
+}
+
+void test_RegionGrowing::grow_ShouldReturnSameRegionIncrementallyAndFromScratch()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(32);
+    int seed[3] = { 9, 9, 0 };
+
+    RegionGrowing incrementalRegionGrowing;
+    incrementalRegionGrowing.setInput(image);
+    incrementalRegionGrowing.setSeed(seed);
+
+    QCOMPARE(incrementalRegionGrowing.grow(90.0, 110.0), 16 * 16 - 8 * 8 - 4 * 4);
+    // The gap is added
+    incrementalRegionGrowing.grow(40.0, 110.0);
+    // The background is added
+    incrementalRegionGrowing.grow(-10.0, 110.0);
+
+    RegionGrowing regionGrowing;
+    regionGrowing.setInput(image);
+    regionGrowing.setSeed(seed);
+
+    QCOMPARE(incrementalRegionGrowing.getNumberOfVoxels(), regionGrowing.grow(-10.0, 110.0));
+    QCOMPARE(incrementalRegionGrowing.getNumberOfVoxels(), 32 * 32);
+}
+
+void test_RegionGrowing::grow_ShouldShrinkWhenRangeNarrows()
+{
+    RegionGrowing regionGrowing;
+    regionGrowing.setInput(createImage(32));
+    int seed[3] = { 9, 9, 0 };
+    regionGrowing.setSeed(seed);
+
+    QCOMPARE(regionGrowing.grow(-10.0, 110.0), 32 * 32);
+    QCOMPARE(regionGrowing.grow(90.0, 110.0), 16 * 16 - 8 * 8 - 4 * 4);
+    QVERIFY(!regionGrowing.isInRegion(0, 0, 0));
+}
+
+void test_RegionGrowing::grow_ShouldReturnRegionBoundsWhenResumedFromRejectedSeed()
+{
+    RegionGrowing regionGrowing;
+    regionGrowing.setInput(createImage(16));
+    int seed[3] = { 4, 4, 0 };
+    regionGrowing.setSeed(seed);
+
+    QCOMPARE(regionGrowing.grow(-10.0, 110.0), 16 * 16);
+    // Starts again from scratch and rejects the seed
+    QCOMPARE(regionGrowing.grow(10.0, 20.0), 0);
+    // Resumes from the rejected seed
+    QCOMPARE(regionGrowing.grow(10.0, 110.0), 8 * 8 - 4 * 4);
+
+    int bounds[6];
+    regionGrowing.getRegionBounds(bounds);
+    QCOMPARE(bounds[0], 4);
+    QCOMPARE(bounds[1], 11);
+    QCOMPARE(bounds[2], 4);
+    QCOMPARE(bounds[3], 11);
+    QCOMPARE(bounds[4], 0);
+    QCOMPARE(bounds[5], 0);
+}
+
+void test_RegionGrowing::getMaskImage_ShouldReturnExpectedMask()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(16);
+    image->SetSpacing(0.5, 2.0, 1.0);
+
+    RegionGrowing regionGrowing;
+    regionGrowing.setInput(image);
+    int extent[6] = { 2, 13, 2, 13, 0, 0 };
+    regionGrowing.setRegionExtent(extent);
+    int seed[3] = { 7, 4, 0 };
+    regionGrowing.setSeed(seed);
+    QCOMPARE(regionGrowing.grow(50.0, 50.0), 4);
+
+    vtkSmartPointer<vtkImageData> mask = regionGrowing.getMaskImage();
+
+    QCOMPARE(mask->GetSpacing()[1], 2.0);
+    QCOMPARE(mask->GetExtent()[0], 2);
+    QCOMPARE(mask->GetExtent()[1], 13);
+    QCOMPARE(*static_cast<unsigned char*>(mask->GetScalarPointer(8, 5, 0)), static_cast<unsigned char>(1));
+    QCOMPARE(*static_cast<unsigned char*>(mask->GetScalarPointer(2, 2, 0)), static_cast<unsigned char>(0));
+}
+
+void test_RegionGrowing::grow_Benchmark_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("512x512") << 512;
+    QTest::newRow("2048x2048") << 2048;
+}
+
+void test_RegionGrowing::grow_Benchmark()
+{
+    QFETCH(int, size);
+
+    vtkSmartPointer<vtkImageData> image = createImage(size);
+    int seed[3] = { 0, 0, 0 };
+
+    QBENCHMARK
+    {
+        RegionGrowing regionGrowing;
+        regionGrowing.setInput(image);
+        regionGrowing.setSeed(seed);
+        regionGrowing.grow(0.0, 10.0);
+        regionGrowing.grow(0.0, 60.0);
+        regionGrowing.grow(0.0, 110.0);
+    }
+}
+
+vtkSmartPointer<vtkImageData> test_RegionGrowing::createImage(int size, int numberOfSlices)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, size - 1, 0, size - 1, 0, numberOfSlices - 1);
+    image->SetSpacing(1.0, 1.0, 1.0);
+    image->SetOrigin(0.0, 0.0, 0.0);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    int ringMinimum = size / 4, ringMaximum = 3 * size / 4;
+    int innerMinimum = 3 * size / 8, innerMaximum = 5 * size / 8;
+    int gapMinimum = size / 2 - size / 16, gapMaximum = size / 2 + size / 16;
+    short *pointer = static_cast<short*>(image->GetScalarPointer());
+    for (int z = 0; z < numberOfSlices; z++)
+    {
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                short value = 0;
+                if (x >= ringMinimum && x < ringMaximum && y >= ringMinimum && y < ringMaximum
+                    && !(x >= innerMinimum && x < innerMaximum && y >= innerMinimum && y < innerMaximum))
+                {
+                    value = (x >= gapMinimum && x < gapMaximum && y < innerMinimum) ? 50 : 100;
+                }
+                *pointer++ = static_cast<short>(value + z);
+            }
+        }
+    }
+
+    return image;
+}
+
+DECLARE_TEST(test_RegionGrowing)
+
+#include "test_regiongrowing.moc"
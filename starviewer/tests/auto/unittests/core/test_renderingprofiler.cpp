@@ -0,0 +1,252 @@
+#include "autotest.h"
+#include "renderingprofiler.h"
+
+#include "fuzzycomparetesthelper.h"
+#include "testingrenderingprofiler.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <vtkCommand.h>
+#include <vtkObject.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+using namespace testing;
+
+class test_RenderingProfiler : public QObject {
+Q_OBJECT
+
+private slots:
+    void getStatistics_ShouldComputeStatisticsOfTheRecordedFrames();
+
+    void getStatistics_ShouldOnlyUseTheLastFramesWhenTheHistoryIsFull();
+
+    void getHistogram_ShouldCountFramesInPowerOfTwoBins();
+
+    void getHistogram_ShouldForgetOverwrittenFrames();
+
+    void endFrame_ShouldDeriveStagesFromTheEnclosingOnes();
+
+    void setEnabled_ShouldNotRecordFramesWhileDisabled();
+
+    void saveCsv_ShouldWriteTheFramesFromOldestToNewest();
+
+private:
+    /// Simulates the rendering of a frame that takes the given time in milliseconds
+    static void renderFrame(TestingRenderingProfiler &profiler, vtkRenderWindow *renderWindow, double milliseconds);
+
+    /// Advances the clock of the profiler the given time in milliseconds
+    static void advance(TestingRenderingProfiler &profiler, double milliseconds);
+};
+
+void test_RenderingProfiler::getStatistics_ShouldComputeStatisticsOfTheRecordedFrames()
+{
+    vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    TestingRenderingProfiler profiler(renderWindow, renderer);
+    profiler.setEnabled(true);
+
+    // Frames of 1 to 10 ms in an order that isn't sorted
+    foreach (double time, QList<double>() << 4.0 << 9.0 << 1.0 << 7.0 << 2.0 << 10.0 << 5.0 << 3.0 << 8.0 << 6.0)
+    {
+        renderFrame(profiler, renderWindow, time);
+    }
+
+    RenderingProfiler::StageStatistics statistics = profiler.getStatistics(RenderingProfiler::Frame);
+
+    QCOMPARE(profiler.getNumberOfFrames(), 10);
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(statistics.last, 6.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(statistics.mean, 5.5));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(statistics.minimum, 1.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(statistics.maximum, 10.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(statistics.median, 6.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(statistics.percentile95, 10.0));
+}
+
+void test_RenderingProfiler::getStatistics_ShouldOnlyUseTheLastFramesWhenTheHistoryIsFull()
+{
+    vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    TestingRenderingProfiler profiler(renderWindow, renderer);
+    profiler.setEnabled(true);
+
+    // Frame i takes i ms, so after the wrap around only frames 11 to FrameHistorySize + 10 are kept
+    for (int i = 1; i <= RenderingProfiler::FrameHistorySize + 10; i++)
+    {
+        renderFrame(profiler, renderWindow, i);
+    }
+
+    RenderingProfiler::StageStatistics statistics = profiler.getStatistics(RenderingProfiler::Frame);
+
+    QCOMPARE(profiler.getNumberOfFrames(), RenderingProfiler::FrameHistorySize);
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(statistics.last, RenderingProfiler::FrameHistorySize + 10.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(statistics.minimum, 11.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(statistics.maximum, RenderingProfiler::FrameHistorySize + 10.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(statistics.mean, (11.0 + RenderingProfiler::FrameHistorySize + 10.0) / 2.0));
+}
+
+void test_RenderingProfiler::getHistogram_ShouldCountFramesInPowerOfTwoBins()
+{
+    vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    TestingRenderingProfiler profiler(renderWindow, renderer);
+    profiler.setEnabled(true);
+
+    foreach (double time, QList<double>() << 0.0 << 0.5 << 1.0 << 1.5 << 2.0 << 3.9 << 4.0 << 255.0 << 256.0 << 10000.0)
+    {
+        renderFrame(profiler, renderWindow, time);
+    }
+
+    QVector<int> expectedHistogram(RenderingProfiler::NumberOfHistogramBins, 0);
+    // [0, 1)
+    expectedHistogram[0] = 2;
+    // [1, 2)
+    expectedHistogram[1] = 2;
+    // [2, 4)
+    expectedHistogram[2] = 2;
+    // [4, 8)
+    expectedHistogram[3] = 1;
+    // [128, 256)
+    expectedHistogram[8] = 1;
+    // [256, infinity)
+    expectedHistogram[RenderingProfiler::NumberOfHistogramBins - 1] = 2;
+
+    QCOMPARE(profiler.getHistogram(RenderingProfiler::Frame), expectedHistogram);
+}
+
+void test_RenderingProfiler::getHistogram_ShouldForgetOverwrittenFrames()
+{
+    vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    TestingRenderingProfiler profiler(renderWindow, renderer);
+    profiler.setEnabled(true);
+
+    // The first 5 frames are overwritten by the last ones
+    for (int i = 0; i < 5; i++)
+    {
+        renderFrame(profiler, renderWindow, 100.0);
+    }
+    for (int i = 0; i < RenderingProfiler::FrameHistorySize; i++)
+    {
+        renderFrame(profiler, renderWindow, 0.5);
+    }
+
+    QVector<int> expectedHistogram(RenderingProfiler::NumberOfHistogramBins, 0);
+    expectedHistogram[0] = RenderingProfiler::FrameHistorySize;
+
+    QCOMPARE(profiler.getHistogram(RenderingProfiler::Frame), expectedHistogram);
+}
+
+void test_RenderingProfiler::endFrame_ShouldDeriveStagesFromTheEnclosingOnes()
+{
+    vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    vtkSmartPointer<vtkObject> mapper = vtkSmartPointer<vtkObject>::New();
+    vtkSmartPointer<vtkObject> reslice = vtkSmartPointer<vtkObject>::New();
+    TestingRenderingProfiler profiler(renderWindow, renderer);
+    profiler.addStageObject(RenderingProfiler::ImageMapper, mapper);
+    profiler.addStageObject(RenderingProfiler::Reslice, reslice);
+    profiler.setEnabled(true);
+
+    // Frame of 10 ms with 8 ms in the renderer, 6 of them in the mapper, which spends 2 of them reslicing
+    renderWindow->InvokeEvent(vtkCommand::StartEvent);
+    advance(profiler, 1.0);
+    renderer->InvokeEvent(vtkCommand::StartEvent);
+    advance(profiler, 1.0);
+    mapper->InvokeEvent(vtkCommand::StartEvent);
+    advance(profiler, 1.0);
+    reslice->InvokeEvent(vtkCommand::StartEvent);
+    advance(profiler, 2.0);
+    reslice->InvokeEvent(vtkCommand::EndEvent);
+    advance(profiler, 3.0);
+    mapper->InvokeEvent(vtkCommand::EndEvent);
+    advance(profiler, 1.0);
+    renderer->InvokeEvent(vtkCommand::EndEvent);
+    advance(profiler, 1.0);
+    renderWindow->InvokeEvent(vtkCommand::EndEvent);
+
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(profiler.getStatistics(RenderingProfiler::Frame).last, 10.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(profiler.getStatistics(RenderingProfiler::ImageMapper).last, 6.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(profiler.getStatistics(RenderingProfiler::Reslice).last, 2.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(profiler.getStatistics(RenderingProfiler::ImageDrawing).last, 4.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(profiler.getStatistics(RenderingProfiler::DrawerPrimitives).last, 2.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(profiler.getStatistics(RenderingProfiler::OtherRenderersAndSwap).last, 2.0));
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(profiler.getStatistics(RenderingProfiler::WindowLevel).last, 0.0));
+}
+
+void test_RenderingProfiler::setEnabled_ShouldNotRecordFramesWhileDisabled()
+{
+    vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    TestingRenderingProfiler profiler(renderWindow, renderer);
+
+    renderFrame(profiler, renderWindow, 1.0);
+    QCOMPARE(profiler.getNumberOfFrames(), 0);
+
+    profiler.setEnabled(true);
+    renderFrame(profiler, renderWindow, 1.0);
+    profiler.setEnabled(false);
+    renderFrame(profiler, renderWindow, 1.0);
+    QCOMPARE(profiler.getNumberOfFrames(), 1);
+
+    // Enabling it again starts a new recording
+    profiler.setEnabled(true);
+    QCOMPARE(profiler.getNumberOfFrames(), 0);
+}
+
+void test_RenderingProfiler::saveCsv_ShouldWriteTheFramesFromOldestToNewest()
+{
+    vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    TestingRenderingProfiler profiler(renderWindow, renderer);
+    profiler.setEnabled(true);
+
+    // Frame i takes i ms, so after the wrap around the oldest frame kept is frame 2
+    for (int i = 0; i < RenderingProfiler::FrameHistorySize + 2; i++)
+    {
+        renderFrame(profiler, renderWindow, i);
+    }
+
+    QTemporaryDir directory;
+    QString fileName = directory.path() + "/profile.csv";
+    QVERIFY(profiler.saveCsv(fileName));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::ReadOnly | QFile::Text));
+    QStringList lines = QTextStream(&file).readAll().split("\n", QString::SkipEmptyParts);
+
+    QCOMPARE(lines.size(), RenderingProfiler::FrameHistorySize + 1);
+
+    QStringList header = lines.first().split(";");
+    QCOMPARE(header.size(), RenderingProfiler::NumberOfStages + 1);
+    QCOMPARE(header.first(), QString("Frame"));
+    QCOMPARE(header.at(RenderingProfiler::Frame + 1), RenderingProfiler::getStageName(RenderingProfiler::Frame));
+
+    QStringList oldestFrame = lines.at(1).split(";");
+    QCOMPARE(oldestFrame.first(), QString("2"));
+    QCOMPARE(oldestFrame.at(RenderingProfiler::Frame + 1), QString("2.000"));
+
+    QStringList newestFrame = lines.last().split(";");
+    QCOMPARE(newestFrame.first(), QString::number(RenderingProfiler::FrameHistorySize + 1));
+    QCOMPARE(newestFrame.at(RenderingProfiler::Frame + 1), QString("%1.000").arg(RenderingProfiler::FrameHistorySize + 1));
+}
+
+void test_RenderingProfiler::renderFrame(TestingRenderingProfiler &profiler, vtkRenderWindow *renderWindow, double milliseconds)
+{
+    renderWindow->InvokeEvent(vtkCommand::StartEvent);
+    advance(profiler, milliseconds);
+    renderWindow->InvokeEvent(vtkCommand::EndEvent);
+}
+
+void test_RenderingProfiler::advance(TestingRenderingProfiler &profiler, double milliseconds)
+{
+    profiler.m_currentTime += static_cast<qint64>(milliseconds * 1000000.0);
+}
+
+DECLARE_TEST(test_RenderingProfiler)
+
+#include "test_renderingprofiler.moc"
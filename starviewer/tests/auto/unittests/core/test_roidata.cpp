@@ -27,6 +27,25 @@ private slots:
     void getMaximum_ReturnsExpectedData_data();
     void getMaximum_ReturnsExpectedData();
 
+    void getMinimum_ReturnsExpectedData();
+
+    void getSum_ReturnsExpectedData();
+
+    void getStandardDeviation_IsAccurateWithLargeOffset();
+
+    void getPercentile_ReturnsExpectedData_data();
+    void getPercentile_ReturnsExpectedData();
+
+    void getPercentile_ReturnsZeroWhenNotEnabled();
+
+    void getStatistics_ReturnZeroWithoutVoxels();
+
+    void getHistogram_ReturnsExpectedData();
+
+    void getHistogram_ReturnsEmptyHistogramWhenBinsAreNotSet();
+
+    void add_ShouldMergeHistogramsWithTheSameBins();
+
 private:
     ROIData generateROIData();
 };
@@ -120,6 +139,115 @@ void test_ROIData::getMaximum_ReturnsExpectedData()
     QCOMPARE(roiData.getMaximum(), expectedMaximum);
 }
 
+void test_ROIData::getMinimum_ReturnsExpectedData()
+{
+    QCOMPARE(generateROIData().getMinimum(), 1.0);
+}
+
+void test_ROIData::getSum_ReturnsExpectedData()
+{
+    QCOMPARE(generateROIData().getSum(), 55.0);
+}
+
+void test_ROIData::getStandardDeviation_IsAccurateWithLargeOffset()
+{
+    ROIData roiData;
+    for (int i = 1; i <= 10; ++i)
+    {
+        roiData.addValue(1.0e9 + i);
+    }
+
+    QCOMPARE(roiData.getNumberOfVoxels(), 10);
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(roiData.getStandardDeviation(), 2.872, 1.0e-3));
+}
+
+void test_ROIData::getPercentile_ReturnsExpectedData_data()
+{
+    QTest::addColumn<double>("percentile");
+    QTest::addColumn<double>("expectedValue");
+
+    QTest::newRow("minimum") << 0.0 << 1.0;
+    QTest::newRow("median") << 50.0 << 5.5;
+    QTest::newRow("95th") << 95.0 << 9.55;
+    QTest::newRow("maximum") << 100.0 << 10.0;
+}
+
+void test_ROIData::getPercentile_ReturnsExpectedData()
+{
+    QFETCH(double, percentile);
+    QFETCH(double, expectedValue);
+
+    ROIData roiData;
+    roiData.setPercentilesEnabled(true);
+    // Add values in reverse order to check that they are sorted
+    for (int i = 10; i > 0; --i)
+    {
+        roiData.addValue(i);
+    }
+
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(roiData.getPercentile(percentile), expectedValue, 1.0e-9));
+}
+
+void test_ROIData::getPercentile_ReturnsZeroWhenNotEnabled()
+{
+    QCOMPARE(generateROIData().getPercentile(50.0), 0.0);
+}
+
+void test_ROIData::getStatistics_ReturnZeroWithoutVoxels()
+{
+    ROIData roiData;
+    roiData.setPercentilesEnabled(true);
+    roiData.addVoxel(Voxel());
+
+    QCOMPARE(roiData.getNumberOfVoxels(), 0);
+    QCOMPARE(roiData.getMean(), 0.0);
+    QCOMPARE(roiData.getStandardDeviation(), 0.0);
+    QCOMPARE(roiData.getMaximum(), 0.0);
+    QCOMPARE(roiData.getMinimum(), 0.0);
+    QCOMPARE(roiData.getSum(), 0.0);
+    QCOMPARE(roiData.getPercentile(50.0), 0.0);
+}
+
+void test_ROIData::getHistogram_ReturnsExpectedData()
+{
+    ROIData roiData;
+    roiData.setHistogramBins(4, 0.0, 8.0);
+
+    // The values out of the range are counted in the first and last bins
+    foreach (double value, QList<double>() << -5.0 << 0.0 << 1.9 << 2.0 << 3.5 << 5.0 << 7.9 << 8.0 << 1.0e12)
+    {
+        roiData.addValue(value);
+    }
+
+    QCOMPARE(roiData.getHistogram(), QVector<int>() << 3 << 2 << 1 << 3);
+
+    // Clearing keeps the bins
+    roiData.clear();
+    QCOMPARE(roiData.getHistogram(), QVector<int>(4, 0));
+}
+
+void test_ROIData::getHistogram_ReturnsEmptyHistogramWhenBinsAreNotSet()
+{
+    QVERIFY(generateROIData().getHistogram().isEmpty());
+}
+
+void test_ROIData::add_ShouldMergeHistogramsWithTheSameBins()
+{
+    ROIData roiData;
+    roiData.setHistogramBins(2, 0.0, 10.0);
+    roiData.addValue(1.0);
+
+    ROIData otherROIData;
+    otherROIData.setHistogramBins(2, 0.0, 10.0);
+    otherROIData.addValue(2.0);
+    otherROIData.addValue(7.0);
+
+    roiData.add(otherROIData);
+
+    QCOMPARE(roiData.getHistogram(), QVector<int>() << 2 << 1);
+    QCOMPARE(roiData.getNumberOfVoxels(), 3);
+}
+
 ROIData test_ROIData::generateROIData()
 {
     ROIData roiData;
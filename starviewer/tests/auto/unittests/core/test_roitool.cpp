@@ -0,0 +1,153 @@
+#include "autotest.h"
+#include "roitool.h"
+
+#include "orthogonalplane.h"
+#include "roidata.h"
+#include "testingroitool.h"
+
+#include <QPointF>
+
+#include <vtkImageData.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+
+class test_ROITool : public QObject {
+Q_OBJECT
+
+private slots:
+    void computeVoxelValues_ShouldAccumulateTheVoxelsInsideAConvexPolygon();
+
+    void computeVoxelValues_ShouldAccumulateEverySpanOfAConcavePolygon();
+
+    void computeVoxelValues_ShouldUseTheSliceOrientedAxes();
+
+    void computeVoxelValues_ShouldIgnoreVoxelsOutOfTheImage();
+
+private:
+    /// Returns an image with the given extent and spacing 1 where each voxel (i, j, k) has the value 100 * i + 10 * j + k
+    static vtkSmartPointer<vtkImageData> createImage(int xSize, int ySize, int zSize);
+
+    /// Returns the points of the polygon with the given vertices in the slice oriented axes of the given plane and the given slice coordinate
+    static vtkSmartPointer<vtkPoints> createPolygon(const QList<QPointF> &vertices, double sliceCoordinate, const OrthogonalPlane &plane);
+
+    /// Rasterizes the polygon with the given vertices over the given image and returns its statistics
+    static ROIData rasterize(const QList<QPointF> &vertices, double sliceCoordinate, const OrthogonalPlane &plane, vtkImageData *image);
+};
+
+void test_ROITool::computeVoxelValues_ShouldAccumulateTheVoxelsInsideAConvexPolygon()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(10, 10, 1);
+    QList<QPointF> square = QList<QPointF>() << QPointF(1.2, 1.2) << QPointF(4.7, 1.2) << QPointF(4.7, 4.7) << QPointF(1.2, 4.7);
+
+    ROIData roiData = rasterize(square, 0.0, OrthogonalPlane(OrthogonalPlane::XYPlane), image);
+
+    // Columns 2 to 4 of rows 2 to 4, whose centers are inside the square
+    QCOMPARE(roiData.getNumberOfVoxels(), 9);
+    QCOMPARE(roiData.getSum(), 2970.0);
+    QCOMPARE(roiData.getMinimum(), 220.0);
+    QCOMPARE(roiData.getMaximum(), 440.0);
+}
+
+void test_ROITool::computeVoxelValues_ShouldAccumulateEverySpanOfAConcavePolygon()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(10, 10, 1);
+    // U shape open at the top
+    QList<QPointF> polygon = QList<QPointF>() << QPointF(0.2, 0.2) << QPointF(4.7, 0.2) << QPointF(4.7, 3.7) << QPointF(3.2, 3.7)
+                                              << QPointF(3.2, 1.7) << QPointF(1.7, 1.7) << QPointF(1.7, 3.7) << QPointF(0.2, 3.7);
+
+    ROIData roiData = rasterize(polygon, 0.0, OrthogonalPlane(OrthogonalPlane::XYPlane), image);
+
+    // Columns 1 to 4 of row 1 and columns 1 and 4 of rows 2 and 3
+    QCOMPARE(roiData.getNumberOfVoxels(), 8);
+    QCOMPARE(roiData.getSum(), 2140.0);
+    QCOMPARE(roiData.getMinimum(), 110.0);
+    QCOMPARE(roiData.getMaximum(), 430.0);
+}
+
+void test_ROITool::computeVoxelValues_ShouldUseTheSliceOrientedAxes()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(5, 5, 5);
+    QList<QPointF> square = QList<QPointF>() << QPointF(1.2, 0.2) << QPointF(3.7, 0.2) << QPointF(3.7, 2.7) << QPointF(1.2, 2.7);
+
+    // Sagittal square at x = 2, with y in [1.2, 3.7] and z in [0.2, 2.7]
+    ROIData roiData = rasterize(square, 2.0, OrthogonalPlane(OrthogonalPlane::YZPlane), image);
+
+    // y from 2 to 3 and z from 1 to 2
+    QCOMPARE(roiData.getNumberOfVoxels(), 4);
+    QCOMPARE(roiData.getSum(), 906.0);
+    QCOMPARE(roiData.getMinimum(), 221.0);
+    QCOMPARE(roiData.getMaximum(), 232.0);
+}
+
+void test_ROITool::computeVoxelValues_ShouldIgnoreVoxelsOutOfTheImage()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(5, 5, 1);
+    OrthogonalPlane plane(OrthogonalPlane::XYPlane);
+
+    QList<QPointF> outside = QList<QPointF>() << QPointF(20.2, 1.2) << QPointF(23.7, 1.2) << QPointF(23.7, 3.7) << QPointF(20.2, 3.7);
+    QCOMPARE(rasterize(outside, 0.0, plane, image).getNumberOfVoxels(), 0);
+
+    // Only column 4 of rows 2 and 3 is inside the image
+    QList<QPointF> partiallyOutside = QList<QPointF>() << QPointF(3.2, 1.2) << QPointF(8.7, 1.2) << QPointF(8.7, 3.7) << QPointF(3.2, 3.7);
+    QCOMPARE(rasterize(partiallyOutside, 0.0, plane, image).getNumberOfVoxels(), 2);
+
+    // Out of the slices of the image
+    QList<QPointF> square = QList<QPointF>() << QPointF(1.2, 1.2) << QPointF(3.7, 1.2) << QPointF(3.7, 3.7) << QPointF(1.2, 3.7);
+    QCOMPARE(rasterize(square, 3.0, plane, image).getNumberOfVoxels(), 0);
+}
+
+vtkSmartPointer<vtkImageData> test_ROITool::createImage(int xSize, int ySize, int zSize)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, xSize - 1, 0, ySize - 1, 0, zSize - 1);
+    image->SetOrigin(0.0, 0.0, 0.0);
+    image->SetSpacing(1.0, 1.0, 1.0);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    for (int k = 0; k < zSize; k++)
+    {
+        for (int j = 0; j < ySize; j++)
+        {
+            for (int i = 0; i < xSize; i++)
+            {
+                image->SetScalarComponentFromDouble(i, j, k, 0, 100 * i + 10 * j + k);
+            }
+        }
+    }
+
+    return image;
+}
+
+vtkSmartPointer<vtkPoints> test_ROITool::createPolygon(const QList<QPointF> &vertices, double sliceCoordinate, const OrthogonalPlane &plane)
+{
+    int xIndex, yIndex, zIndex;
+    plane.getXYZIndexes(xIndex, yIndex, zIndex);
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    foreach (const QPointF &vertex, vertices)
+    {
+        double point[3];
+        point[xIndex] = vertex.x();
+        point[yIndex] = vertex.y();
+        point[zIndex] = sliceCoordinate;
+        points->InsertNextPoint(point);
+    }
+
+    return points;
+}
+
+ROIData test_ROITool::rasterize(const QList<QPointF> &vertices, double sliceCoordinate, const OrthogonalPlane &plane, vtkImageData *image)
+{
+    int xIndex, yIndex, zIndex;
+    plane.getXYZIndexes(xIndex, yIndex, zIndex);
+
+    vtkSmartPointer<vtkPoints> points = createPolygon(vertices, sliceCoordinate, plane);
+
+    return TestingROITool::computeVoxelValues(points, image, xIndex, yIndex, zIndex);
+}
+
+DECLARE_TEST(test_ROITool)
+
+#include "test_roitool.moc"
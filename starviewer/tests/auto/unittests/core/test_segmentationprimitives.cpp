@@ -0,0 +1,343 @@
+#include "autotest.h"
+#include "segmentationprimitives.h"
+
+#include <cmath>
+
+using namespace udg;
+
+class test_SegmentationPrimitives : public QObject {
+Q_OBJECT
+
+private slots:
+    void floodFill_ShouldReturnZeroIfSeedIsOutOfRange();
+
+    void floodFill_ShouldFill6ConnectedVoxelsInRange();
+
+    void floodFill_ShouldBeConfinedToExtent();
+
+    void floodFill_ShouldFillInPlace();
+
+    void floodFill_ShouldFillRegionsDeeperThanTheCallStack();
+
+    void labelConnectedComponents_ShouldMatchBruteForceLabelling();
+
+    void erode_ShouldMatchBruteForceErosion();
+
+    void dilate_ShouldMatchBruteForceDilation();
+
+    void count_ShouldReturnNumberOfVoxelsWithValue();
+
+    void floodFill_Benchmark_data();
+    void floodFill_Benchmark();
+
+    void labelConnectedComponents_Benchmark_data();
+    void labelConnectedComponents_Benchmark();
+
+    void dilate_Benchmark_data();
+    void dilate_Benchmark();
+
+private:
+    /// Returns an image with the given dimensions with random values 0 and 1, with the given percentage of ones
+    static QVector<short> createRandomImage(const int dimensions[3], int percentageOfOnes);
+
+    /// Returns true if there is a voxel of the image with the given value in the ball with the given radius centered at (x, y, z)
+    static bool isInBall(const QVector<short> &image, const int dimensions[3], int x, int y, int z, const int radius[3], short value);
+};
+
+void test_SegmentationPrimitives::floodFill_ShouldReturnZeroIfSeedIsOutOfRange()
+{
+    int dimensions[3] = { 4, 4, 1 };
+    QVector<short> image(16, 0);
+    QVector<unsigned char> mask(16, 0);
+    int seed[3] = { 1, 1, 0 };
+
+    QCOMPARE(SegmentationPrimitives::floodFill(image.constData(), mask.data(), dimensions, seed, 10.0, 20.0, static_cast<unsigned char>(1)),
+             qint64(0));
+    QCOMPARE(mask.count(1), 0);
+
+    int outsideSeed[3] = { 4, 0, 0 };
+    QCOMPARE(SegmentationPrimitives::floodFill(image.constData(), mask.data(), dimensions, outsideSeed, -1.0, 1.0, static_cast<unsigned char>(1)),
+             qint64(0));
+}
+
+void test_SegmentationPrimitives::floodFill_ShouldFill6ConnectedVoxelsInRange()
+{
+    int dimensions[3] = { 3, 3, 2 };
+    // Slices from z = 0 to z = 1, rows from y = 0 to y = 2
+    short values[18] = { 1, 1, 0,
+                         0, 1, 0,
+                         1, 0, 1,
+
+                         0, 0, 0,
+                         0, 1, 1,
+                         1, 0, 1 };
+    QVector<short> image(18);
+    std::copy(values, values + 18, image.begin());
+    QVector<unsigned char> mask(18, 0);
+    int seed[3] = { 0, 0, 0 };
+
+    QCOMPARE(SegmentationPrimitives::floodFill(image.constData(), mask.data(), dimensions, seed, 1.0, 1.0, static_cast<unsigned char>(2)),
+             qint64(7));
+    // The voxels at x = 0, y = 2 are only connected between them
+    unsigned char expected[18] = { 2, 2, 0,
+                                   0, 2, 0,
+                                   0, 0, 2,
+
+                                   0, 0, 0,
+                                   0, 2, 2,
+                                   0, 0, 2 };
+    for (int i = 0; i < 18; i++)
+    {
+        QCOMPARE(mask.at(i), expected[i]);
+    }
+}
+
+void test_SegmentationPrimitives::floodFill_ShouldBeConfinedToExtent()
+{
+    int dimensions[3] = { 8, 8, 1 };
+    QVector<short> image(64, 1);
+    QVector<unsigned char> mask(64, 0);
+    int extent[6] = { 2, 5, 1, 3, 0, 0 };
+    int seed[3] = { 3, 2, 0 };
+
+    QCOMPARE(SegmentationPrimitives::floodFill(image.constData(), mask.data(), dimensions, extent, seed, 1.0, 1.0, static_cast<unsigned char>(1)),
+             qint64(12));
+    QCOMPARE(mask.at(1 * 8 + 2), static_cast<unsigned char>(1));
+    QCOMPARE(mask.at(3 * 8 + 5), static_cast<unsigned char>(1));
+    QCOMPARE(mask.at(1 * 8 + 1), static_cast<unsigned char>(0));
+    QCOMPARE(mask.at(4 * 8 + 3), static_cast<unsigned char>(0));
+}
+
+void test_SegmentationPrimitives::floodFill_ShouldFillInPlace()
+{
+    int dimensions[3] = { 16, 16, 4 };
+    QVector<short> image = createRandomImage(dimensions, 60);
+    QVector<short> mask(image.size(), 0);
+    image[0] = 1;
+    int seed[3] = { 0, 0, 0 };
+
+    qint64 filled = SegmentationPrimitives::floodFill(image.constData(), mask.data(), dimensions, seed, 1.0, 1.0, static_cast<short>(7));
+    QCOMPARE(SegmentationPrimitives::floodFill(image.constData(), image.data(), dimensions, seed, 1.0, 1.0, static_cast<short>(7)), filled);
+    for (int i = 0; i < image.size(); i++)
+    {
+        QCOMPARE(image.at(i) == 7, mask.at(i) == 7);
+    }
+}
+
+void test_SegmentationPrimitives::floodFill_ShouldFillRegionsDeeperThanTheCallStack()
+{
+    // A one voxel wide serpentine that covers every other row of a 1024x1024 slice, more than half a million voxels long
+    int size = 1024;
+    int dimensions[3] = { size, size, 1 };
+    QVector<short> image(size * size, 0);
+    for (int y = 0; y < size; y += 2)
+    {
+        std::fill(image.begin() + y * size, image.begin() + (y + 1) * size, 1);
+        if (y + 1 < size)
+        {
+            image[(y + 1) * size + ((y / 2) % 2 == 0 ? size - 1 : 0)] = 1;
+        }
+    }
+    QVector<unsigned char> mask(image.size(), 0);
+    int seed[3] = { 0, 0, 0 };
+
+    QCOMPARE(SegmentationPrimitives::floodFill(image.constData(), mask.data(), dimensions, seed, 1.0, 1.0, static_cast<unsigned char>(1)),
+             SegmentationPrimitives::count(image.constData(), image.size(), static_cast<short>(1)));
+}
+
+void test_SegmentationPrimitives::labelConnectedComponents_ShouldMatchBruteForceLabelling()
+{
+    int dimensions[3] = { 23, 17, 9 };
+    QVector<short> image = createRandomImage(dimensions, 55);
+
+    QVector<int> labels;
+    int numberOfComponents = SegmentationPrimitives::labelConnectedComponents(image.constData(), dimensions, static_cast<short>(1), labels);
+
+    // Each component filled from its first voxel in raster order must get the next label
+    QVector<int> expectedLabels(image.size(), 0);
+    int expectedNumberOfComponents = 0;
+    for (int z = 0; z < dimensions[2]; z++)
+    {
+        for (int y = 0; y < dimensions[1]; y++)
+        {
+            for (int x = 0; x < dimensions[0]; x++)
+            {
+                int index = x + dimensions[0] * (y + dimensions[1] * z);
+                if (image.at(index) == 1 && expectedLabels.at(index) == 0)
+                {
+                    int seed[3] = { x, y, z };
+                    expectedNumberOfComponents++;
+                    SegmentationPrimitives::floodFill(image.constData(), expectedLabels.data(), dimensions, seed, 1.0, 1.0, expectedNumberOfComponents);
+                }
+            }
+        }
+    }
+
+    QCOMPARE(numberOfComponents, expectedNumberOfComponents);
+    QCOMPARE(labels, expectedLabels);
+}
+
+void test_SegmentationPrimitives::erode_ShouldMatchBruteForceErosion()
+{
+    int dimensions[3] = { 20, 18, 7 };
+    int radius[3] = { 2, 3, 1 };
+    QVector<short> image = createRandomImage(dimensions, 85);
+    QVector<short> eroded(image.size());
+
+    SegmentationPrimitives::erode(image.constData(), eroded.data(), dimensions, radius, static_cast<short>(1), static_cast<short>(0));
+
+    for (int z = 0; z < dimensions[2]; z++)
+    {
+        for (int y = 0; y < dimensions[1]; y++)
+        {
+            for (int x = 0; x < dimensions[0]; x++)
+            {
+                int index = x + dimensions[0] * (y + dimensions[1] * z);
+                short expected = image.at(index) == 1 && isInBall(image, dimensions, x, y, z, radius, 0) ? 0 : image.at(index);
+                QCOMPARE(eroded.at(index), expected);
+            }
+        }
+    }
+}
+
+void test_SegmentationPrimitives::dilate_ShouldMatchBruteForceDilation()
+{
+    int dimensions[3] = { 20, 18, 7 };
+    int radius[3] = { 3, 2, 1 };
+    QVector<short> image = createRandomImage(dimensions, 3);
+    QVector<short> dilated(image.size());
+
+    SegmentationPrimitives::dilate(image.constData(), dilated.data(), dimensions, radius, static_cast<short>(1));
+
+    for (int z = 0; z < dimensions[2]; z++)
+    {
+        for (int y = 0; y < dimensions[1]; y++)
+        {
+            for (int x = 0; x < dimensions[0]; x++)
+            {
+                int index = x + dimensions[0] * (y + dimensions[1] * z);
+                short expected = isInBall(image, dimensions, x, y, z, radius, 1) ? 1 : image.at(index);
+                QCOMPARE(dilated.at(index), expected);
+            }
+        }
+    }
+}
+
+void test_SegmentationPrimitives::count_ShouldReturnNumberOfVoxelsWithValue()
+{
+    int dimensions[3] = { 10, 10, 10 };
+    QVector<short> image = createRandomImage(dimensions, 40);
+
+    QCOMPARE(SegmentationPrimitives::count(image.constData(), image.size(), static_cast<short>(1)), qint64(image.count(1)));
+    QCOMPARE(SegmentationPrimitives::count(image.constData(), image.size(), static_cast<short>(2)), qint64(0));
+}
+
+void test_SegmentationPrimitives::floodFill_Benchmark_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("256x256x64") << 256;
+    QTest::newRow("512x512x64") << 512;
+}
+
+void test_SegmentationPrimitives::floodFill_Benchmark()
+{
+    QFETCH(int, size);
+
+    int dimensions[3] = { size, size, 64 };
+    QVector<short> image = createRandomImage(dimensions, 70);
+    QVector<unsigned char> mask(image.size());
+    image[0] = 1;
+    int seed[3] = { 0, 0, 0 };
+
+    QBENCHMARK
+    {
+        mask.fill(0);
+        SegmentationPrimitives::floodFill(image.constData(), mask.data(), dimensions, seed, 1.0, 1.0, static_cast<unsigned char>(1));
+    }
+}
+
+void test_SegmentationPrimitives::labelConnectedComponents_Benchmark_data()
+{
+    floodFill_Benchmark_data();
+}
+
+void test_SegmentationPrimitives::labelConnectedComponents_Benchmark()
+{
+    QFETCH(int, size);
+
+    int dimensions[3] = { size, size, 64 };
+    QVector<short> image = createRandomImage(dimensions, 50);
+    QVector<int> labels;
+
+    QBENCHMARK
+    {
+        SegmentationPrimitives::labelConnectedComponents(image.constData(), dimensions, static_cast<short>(1), labels);
+    }
+}
+
+void test_SegmentationPrimitives::dilate_Benchmark_data()
+{
+    floodFill_Benchmark_data();
+}
+
+void test_SegmentationPrimitives::dilate_Benchmark()
+{
+    QFETCH(int, size);
+
+    // The largest structuring element used by the stroke segmentation
+    int dimensions[3] = { size, size, 64 };
+    int radius[3] = { 8, 8, 2 };
+    QVector<short> image = createRandomImage(dimensions, 1);
+    QVector<short> dilated(image.size());
+
+    QBENCHMARK
+    {
+        SegmentationPrimitives::dilate(image.constData(), dilated.data(), dimensions, radius, static_cast<short>(1));
+    }
+}
+
+QVector<short> test_SegmentationPrimitives::createRandomImage(const int dimensions[3], int percentageOfOnes)
+{
+    QVector<short> image(dimensions[0] * dimensions[1] * dimensions[2]);
+    // Fixed seed so that the images are the same in every run
+    qsrand(3);
+    for (int i = 0; i < image.size(); i++)
+    {
+        image[i] = qrand() % 100 < percentageOfOnes ? 1 : 0;
+    }
+
+    return image;
+}
+
+bool test_SegmentationPrimitives::isInBall(const QVector<short> &image, const int dimensions[3], int x, int y, int z, const int radius[3],
+                                           short value)
+{
+    for (int dz = -radius[2]; dz <= radius[2]; dz++)
+    {
+        for (int dy = -radius[1]; dy <= radius[1]; dy++)
+        {
+            for (int dx = -radius[0]; dx <= radius[0]; dx++)
+            {
+                double distance = std::pow(dx / (radius[0] + 0.5), 2) + std::pow(dy / (radius[1] + 0.5), 2) + std::pow(dz / (radius[2] + 0.5), 2);
+                if (distance > 1.0)
+                {
+                    continue;
+                }
+
+                int nx = x + dx, ny = y + dy, nz = z + dz;
+                if (nx >= 0 && nx < dimensions[0] && ny >= 0 && ny < dimensions[1] && nz >= 0 && nz < dimensions[2]
+                    && image.at(nx + dimensions[0] * (ny + dimensions[1] * nz)) == value)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+DECLARE_TEST(test_SegmentationPrimitives)
+
+#include "test_segmentationprimitives.moc"
@@ -0,0 +1,139 @@
+#include "autotest.h"
+#include "sliceindex.h"
+
+#include "imageplane.h"
+
+using namespace udg;
+
+class test_SliceIndex : public QObject {
+Q_OBJECT
+
+private slots:
+    void getNearestSlice_ShouldReturnMinusOneWithoutSlices();
+
+    void getNearestSlice_ShouldFindNearestSliceOfParallelSlices_data();
+    void getNearestSlice_ShouldFindNearestSliceOfParallelSlices();
+
+    void getNearestSlice_ShouldReturnLowestSliceWhenTied();
+
+    void getNearestSlice_ShouldSkipNullPlanes();
+
+    void getNearestSlice_ShouldFindNearestSliceOfTiltedSlices();
+
+private:
+    /// Returns an axial plane at the given z
+    static ImagePlane* createAxialPlane(double z);
+};
+
+void test_SliceIndex::getNearestSlice_ShouldReturnMinusOneWithoutSlices()
+{
+    QList<ImagePlane*> planes;
+    SliceIndex sliceIndex(planes);
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double distance;
+
+    QCOMPARE(sliceIndex.getNumberOfSlices(), 0);
+    QCOMPARE(sliceIndex.getNearestSlice(point, distance), -1);
+}
+
+void test_SliceIndex::getNearestSlice_ShouldFindNearestSliceOfParallelSlices_data()
+{
+    QTest::addColumn<double>("z");
+    QTest::addColumn<int>("expectedSlice");
+    QTest::addColumn<double>("expectedDistance");
+
+    // Slices at z = 10, 0, 2.5, 3, 20 (irregular and not sorted)
+    QTest::newRow("below all") << -5.0 << 1 << 5.0;
+    QTest::newRow("on a slice") << 3.0 << 3 << 0.0;
+    QTest::newRow("between slices") << 2.6 << 2 << 0.1;
+    QTest::newRow("nearer to the next one") << 7.0 << 0 << 3.0;
+    QTest::newRow("above all") << 100.0 << 4 << 80.0;
+}
+
+void test_SliceIndex::getNearestSlice_ShouldFindNearestSliceOfParallelSlices()
+{
+    QFETCH(double, z);
+    QFETCH(int, expectedSlice);
+    QFETCH(double, expectedDistance);
+
+    QList<ImagePlane*> planes;
+    planes << createAxialPlane(10.0) << createAxialPlane(0.0) << createAxialPlane(2.5) << createAxialPlane(3.0) << createAxialPlane(20.0);
+    SliceIndex sliceIndex(planes);
+    qDeleteAll(planes);
+
+    double point[3] = { 50.0, -30.0, z };
+    double distance;
+
+    QVERIFY(sliceIndex.areSlicesParallel());
+    QCOMPARE(sliceIndex.getNearestSlice(point, distance), expectedSlice);
+    QVERIFY(qAbs(distance - expectedDistance) < 1e-9);
+}
+
+void test_SliceIndex::getNearestSlice_ShouldReturnLowestSliceWhenTied()
+{
+    QList<ImagePlane*> planes;
+    planes << createAxialPlane(4.0) << createAxialPlane(2.0) << createAxialPlane(0.0) << createAxialPlane(2.0);
+    SliceIndex sliceIndex(planes);
+    qDeleteAll(planes);
+
+    double point[3] = { 0.0, 0.0, 3.0 };
+    double distance;
+
+    QCOMPARE(sliceIndex.getNearestSlice(point, distance), 0);
+
+    point[2] = 2.0;
+
+    QCOMPARE(sliceIndex.getNearestSlice(point, distance), 1);
+}
+
+void test_SliceIndex::getNearestSlice_ShouldSkipNullPlanes()
+{
+    QList<ImagePlane*> planes;
+    planes << 0 << createAxialPlane(5.0) << 0;
+    SliceIndex sliceIndex(planes);
+    qDeleteAll(planes);
+
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double distance;
+
+    QCOMPARE(sliceIndex.getNumberOfSlices(), 1);
+    QCOMPARE(sliceIndex.getNearestSlice(point, distance), 1);
+    QCOMPARE(distance, 5.0);
+}
+
+void test_SliceIndex::getNearestSlice_ShouldFindNearestSliceOfTiltedSlices()
+{
+    // Two axial slices and a slice tilted 45 degrees around the x axis through the origin
+    QList<ImagePlane*> planes;
+    planes << createAxialPlane(-10.0) << createAxialPlane(10.0);
+    ImagePlane *tiltedPlane = new ImagePlane();
+    tiltedPlane->setOrigin(0.0, 0.0, 0.0);
+    tiltedPlane->setImageOrientation(ImageOrientation(QVector3D(1.0, 0.0, 0.0), QVector3D(0.0, 1.0, 1.0).normalized()));
+    planes << tiltedPlane;
+    SliceIndex sliceIndex(planes);
+    qDeleteAll(planes);
+
+    double point[3] = { 0.0, 1.0, 1.0 };
+    double distance;
+
+    QVERIFY(!sliceIndex.areSlicesParallel());
+    QCOMPARE(sliceIndex.getNearestSlice(point, distance), 2);
+    QVERIFY(qAbs(distance) < 1e-9);
+
+    point[2] = -9.0;
+    point[1] = 9.0;
+
+    QCOMPARE(sliceIndex.getNearestSlice(point, distance), 0);
+}
+
+ImagePlane* test_SliceIndex::createAxialPlane(double z)
+{
+    ImagePlane *plane = new ImagePlane();
+    plane->setOrigin(0.0, 0.0, z);
+    plane->setImageOrientation(ImageOrientation(QVector3D(1.0, 0.0, 0.0), QVector3D(0.0, 1.0, 0.0)));
+    return plane;
+}
+
+DECLARE_TEST(test_SliceIndex)
+
+#include "test_sliceindex.moc"
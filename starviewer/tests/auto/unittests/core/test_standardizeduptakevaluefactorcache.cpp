@@ -0,0 +1,45 @@
+#include "autotest.h"
+#include "standardizeduptakevaluefactorcache.h"
+
+#include "volume.h"
+
+using namespace udg;
+
+class test_StandardizedUptakeValueFactorCache : public QObject {
+Q_OBJECT
+
+private slots:
+    void getFactor_ShouldReturnZeroWithoutImage();
+
+    void setFormula_ShouldUpdateTheFormulaLabelAndUnits();
+};
+
+void test_StandardizedUptakeValueFactorCache::getFactor_ShouldReturnZeroWithoutImage()
+{
+    Volume volume;
+    StandardizedUptakeValueFactorCache suvFactorCache(&volume);
+
+    QCOMPARE(suvFactorCache.getFactor(0), 0.0);
+    QCOMPARE(suvFactorCache.getFactor(0, 0), 0.0);
+    QVERIFY(!suvFactorCache.canCompute(0));
+}
+
+void test_StandardizedUptakeValueFactorCache::setFormula_ShouldUpdateTheFormulaLabelAndUnits()
+{
+    Volume volume;
+    StandardizedUptakeValueFactorCache suvFactorCache(&volume);
+    StandardUptakeValueMeasureHandler suvHandler;
+
+    suvFactorCache.setFormula(StandardUptakeValueMeasureHandler::LeanBodyMass);
+    QCOMPARE(suvFactorCache.getFormula(), StandardUptakeValueMeasureHandler::LeanBodyMass);
+    QCOMPARE(suvFactorCache.getFormulaLabel(), suvHandler.getFormulaLabel(StandardUptakeValueMeasureHandler::LeanBodyMass));
+    QCOMPARE(suvFactorCache.getFormulaUnits(), suvHandler.getFormulaUnits(StandardUptakeValueMeasureHandler::LeanBodyMass));
+
+    suvFactorCache.setFormula(StandardUptakeValueMeasureHandler::BodySurfaceArea);
+    QCOMPARE(suvFactorCache.getFormulaLabel(), suvHandler.getFormulaLabel(StandardUptakeValueMeasureHandler::BodySurfaceArea));
+    QCOMPARE(suvFactorCache.getFormulaUnits(), suvHandler.getFormulaUnits(StandardUptakeValueMeasureHandler::BodySurfaceArea));
+}
+
+DECLARE_TEST(test_StandardizedUptakeValueFactorCache)
+
+#include "test_standardizeduptakevaluefactorcache.moc"
@@ -0,0 +1,239 @@
+#include "autotest.h"
+#include "timeactivitycurvecalculator.h"
+
+#include <QTemporaryDir>
+
+#include <cmath>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+
+class test_TimeActivityCurveCalculator : public QObject {
+Q_OBJECT
+
+private slots:
+    void getCurves_ShouldReturnEmptyCurvesWithoutContour();
+
+    void getCurves_ShouldMeasureEachPhaseInAxialContour();
+
+    void getCurves_ShouldMeasureEachPhaseInSagittalContour();
+
+    void getCurves_ShouldMeasureTemporalImage();
+
+    void getCurves_ShouldUpdateWhenContourChanges();
+
+    void getCurves_ShouldReturnTheSameCurvesWhenContourIsEditedInTheSameSlice();
+
+    void saveCsv_ShouldWriteARowForEachPhase();
+
+private:
+    /// Returns an image of 10x10 voxels, 4 slices and 3 phases interleaved along z with unit spacing where the value of each voxel is
+    /// its x index plus 10 times its phase plus 100 times its slice
+    static vtkSmartPointer<vtkImageData> createImage();
+
+    /// Returns a square contour with the given corners
+    static QVector<QPointF> createSquare(double minimum, double maximum);
+};
+
+void test_TimeActivityCurveCalculator::getCurves_ShouldReturnEmptyCurvesWithoutContour()
+{
+    TimeActivityCurveCalculator calculator;
+    calculator.setInput(createImage(), 3);
+
+    const TimeActivityCurveCalculator::Curves &curves = calculator.getCurves();
+
+    QCOMPARE(curves.numberOfVoxels, 0);
+    QCOMPARE(curves.mean.size(), 3);
+    QCOMPARE(curves.mean.at(0), 0.0);
+}
+
+void test_TimeActivityCurveCalculator::getCurves_ShouldMeasureEachPhaseInAxialContour()
+{
+    TimeActivityCurveCalculator calculator;
+    calculator.setInput(createImage(), 3);
+    // Contains columns and rows 2, 3 and 4
+    calculator.setContour(createSquare(1.5, 4.5), OrthogonalPlane::XYPlane, 2);
+
+    const TimeActivityCurveCalculator::Curves &curves = calculator.getCurves();
+
+    QCOMPARE(calculator.getNumberOfPhases(), 3);
+    QCOMPARE(curves.numberOfVoxels, 9);
+    for (int phase = 0; phase < 3; phase++)
+    {
+        QCOMPARE(curves.mean.at(phase), 203.0 + 10.0 * phase);
+        QCOMPARE(curves.minimum.at(phase), 202.0 + 10.0 * phase);
+        QCOMPARE(curves.maximum.at(phase), 204.0 + 10.0 * phase);
+        QVERIFY(qAbs(curves.standardDeviation.at(phase) - std::sqrt(2.0 / 3.0)) < 1e-9);
+    }
+}
+
+void test_TimeActivityCurveCalculator::getCurves_ShouldMeasureEachPhaseInSagittalContour()
+{
+    TimeActivityCurveCalculator calculator;
+    calculator.setInput(createImage(), 3);
+    // The contour is in y and z coordinates and contains rows and slices 1 and 2 of column 5
+    calculator.setContour(createSquare(0.5, 2.5), OrthogonalPlane::YZPlane, 5);
+
+    const TimeActivityCurveCalculator::Curves &curves = calculator.getCurves();
+
+    QCOMPARE(curves.numberOfVoxels, 4);
+    for (int phase = 0; phase < 3; phase++)
+    {
+        QCOMPARE(curves.mean.at(phase), 155.0 + 10.0 * phase);
+        QCOMPARE(curves.minimum.at(phase), 105.0 + 10.0 * phase);
+        QCOMPARE(curves.maximum.at(phase), 205.0 + 10.0 * phase);
+    }
+}
+
+void test_TimeActivityCurveCalculator::getCurves_ShouldMeasureTemporalImage()
+{
+    // 5 phases of 4x4x2 voxels where the value of each voxel is its x index plus 1000 times its phase
+    TimeActivityCurveCalculator::TemporalImageType::Pointer image = TimeActivityCurveCalculator::TemporalImageType::New();
+    TimeActivityCurveCalculator::TemporalImageType::IndexType start;
+    start.Fill(0);
+    TimeActivityCurveCalculator::TemporalImageType::SizeType size;
+    size[0] = 5;
+    size[1] = 4;
+    size[2] = 4;
+    size[3] = 2;
+    TimeActivityCurveCalculator::TemporalImageType::RegionType region;
+    region.SetIndex(start);
+    region.SetSize(size);
+    image->SetRegions(region);
+    image->Allocate();
+
+    double *pointer = image->GetBufferPointer();
+    for (int z = 0; z < 2; z++)
+    {
+        for (int y = 0; y < 4; y++)
+        {
+            for (int x = 0; x < 4; x++)
+            {
+                for (int phase = 0; phase < 5; phase++)
+                {
+                    *pointer++ = 1000.0 * phase + x;
+                }
+            }
+        }
+    }
+
+    double origin[3] = { 10.0, 0.0, 0.0 };
+    double spacing[3] = { 2.0, 1.0, 1.0 };
+
+    TimeActivityCurveCalculator calculator;
+    calculator.setTemporalImage(image, origin, spacing);
+    // Contains columns 1 to 3 of row 1
+    QVector<QPointF> contour;
+    contour << QPointF(11.5, 0.5) << QPointF(16.5, 0.5) << QPointF(16.5, 1.5) << QPointF(11.5, 1.5);
+    calculator.setContour(contour, OrthogonalPlane::XYPlane, 1);
+
+    const TimeActivityCurveCalculator::Curves &curves = calculator.getCurves();
+
+    QCOMPARE(calculator.getNumberOfPhases(), 5);
+    QCOMPARE(curves.numberOfVoxels, 3);
+    for (int phase = 0; phase < 5; phase++)
+    {
+        QCOMPARE(curves.mean.at(phase), 1000.0 * phase + 2.0);
+    }
+}
+
+void test_TimeActivityCurveCalculator::getCurves_ShouldUpdateWhenContourChanges()
+{
+    TimeActivityCurveCalculator calculator;
+    calculator.setInput(createImage(), 3);
+    calculator.setContour(createSquare(1.5, 4.5), OrthogonalPlane::XYPlane, 2);
+
+    QCOMPARE(calculator.getCurves().numberOfVoxels, 9);
+
+    // Contains columns and rows from 2 to 7
+    calculator.setContour(createSquare(1.5, 7.5), OrthogonalPlane::XYPlane, 0);
+
+    const TimeActivityCurveCalculator::Curves &curves = calculator.getCurves();
+    QCOMPARE(curves.numberOfVoxels, 36);
+    QCOMPARE(curves.maximum.at(1), 17.0);
+}
+
+void test_TimeActivityCurveCalculator::getCurves_ShouldReturnTheSameCurvesWhenContourIsEditedInTheSameSlice()
+{
+    // As while the ROI is drawn, the contour gets a new vertex that moves and changes the spans of some rows
+    QVector<QPointF> square = createSquare(1.5, 4.5);
+    QVector<QPointF> editedContour = square;
+    editedContour.insert(2, QPointF(7.5, 3.2));
+
+    TimeActivityCurveCalculator calculator;
+    calculator.setInput(createImage(), 3);
+    calculator.setContour(square, OrthogonalPlane::XYPlane, 2);
+    calculator.getCurves();
+    calculator.setContour(editedContour, OrthogonalPlane::XYPlane, 2);
+    const TimeActivityCurveCalculator::Curves &curves = calculator.getCurves();
+
+    TimeActivityCurveCalculator expectedCalculator;
+    expectedCalculator.setInput(createImage(), 3);
+    expectedCalculator.setContour(editedContour, OrthogonalPlane::XYPlane, 2);
+    const TimeActivityCurveCalculator::Curves &expectedCurves = expectedCalculator.getCurves();
+
+    QVERIFY(curves.numberOfVoxels > 9);
+    QCOMPARE(curves.numberOfVoxels, expectedCurves.numberOfVoxels);
+    QCOMPARE(curves.mean, expectedCurves.mean);
+    QCOMPARE(curves.minimum, expectedCurves.minimum);
+    QCOMPARE(curves.maximum, expectedCurves.maximum);
+    QCOMPARE(curves.standardDeviation, expectedCurves.standardDeviation);
+}
+
+void test_TimeActivityCurveCalculator::saveCsv_ShouldWriteARowForEachPhase()
+{
+    TimeActivityCurveCalculator calculator;
+    calculator.setInput(createImage(), 3);
+    calculator.setContour(createSquare(1.5, 4.5), OrthogonalPlane::XYPlane, 2);
+
+    QTemporaryDir directory;
+    QString fileName = directory.path() + "/curves.csv";
+
+    QVERIFY(TimeActivityCurveCalculator::saveCsv(calculator.getCurves(), fileName));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::ReadOnly | QFile::Text));
+    QStringList lines = QString(file.readAll()).split("\n", QString::SkipEmptyParts);
+
+    QCOMPARE(lines.size(), 4);
+    QCOMPARE(lines.at(2).split(";").at(1), QString("213"));
+}
+
+vtkSmartPointer<vtkImageData> test_TimeActivityCurveCalculator::createImage()
+{
+    const int NumberOfSlices = 4;
+    const int NumberOfPhases = 3;
+
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, 9, 0, 9, 0, NumberOfSlices * NumberOfPhases - 1);
+    image->SetSpacing(1.0, 1.0, 1.0);
+    image->SetOrigin(0.0, 0.0, 0.0);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    short *pointer = static_cast<short*>(image->GetScalarPointer());
+    for (int z = 0; z < NumberOfSlices * NumberOfPhases; z++)
+    {
+        for (int y = 0; y < 10; y++)
+        {
+            for (int x = 0; x < 10; x++)
+            {
+                *pointer++ = static_cast<short>(100 * (z / NumberOfPhases) + 10 * (z % NumberOfPhases) + x);
+            }
+        }
+    }
+
+    return image;
+}
+
+QVector<QPointF> test_TimeActivityCurveCalculator::createSquare(double minimum, double maximum)
+{
+    QVector<QPointF> square;
+    square << QPointF(minimum, minimum) << QPointF(maximum, minimum) << QPointF(maximum, maximum) << QPointF(minimum, maximum);
+    return square;
+}
+
+DECLARE_TEST(test_TimeActivityCurveCalculator)
+
+#include "test_timeactivitycurvecalculator.moc"
@@ -0,0 +1,206 @@
+#include "autotest.h"
+#include "voistatisticscalculator.h"
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+
+class test_VOIStatisticsCalculator : public QObject {
+Q_OBJECT
+
+private slots:
+    void getStatistics_ShouldReturnEmptyStatisticsWithoutVOI();
+
+    void getStatistics_ShouldMeasureVoxelsInsideContour();
+
+    void getStatistics_ShouldMeasureVoxelsInsideSphere();
+
+    void getStatistics_ShouldUpdateEditedContours();
+
+    void getStatistics_ShouldMeasureEachPhase();
+
+    void getStatistics_ShouldReturnExpectedMetabolicVolume_data();
+    void getStatistics_ShouldReturnExpectedMetabolicVolume();
+
+    void getStatistics_ShouldReturnExpectedPeak();
+
+private:
+    /// Returns an image of 20x20 voxels and the given number of slices with unit spacing where the value of each voxel is its x index
+    /// plus 100 times its phase
+    static vtkSmartPointer<vtkImageData> createImage(int numberOfSlices, int numberOfPhases = 1);
+
+    /// Returns a square contour with the given corners
+    static QVector<QPointF> createSquare(double minimum, double maximum);
+};
+
+void test_VOIStatisticsCalculator::getStatistics_ShouldReturnEmptyStatisticsWithoutVOI()
+{
+    VOIStatisticsCalculator calculator;
+    calculator.setInput(createImage(4));
+
+    VOIStatisticsCalculator::Statistics statistics = calculator.getStatistics();
+
+    QCOMPARE(statistics.data.getNumberOfVoxels(), 0);
+    QCOMPARE(statistics.metabolicVolume, 0.0);
+}
+
+void test_VOIStatisticsCalculator::getStatistics_ShouldMeasureVoxelsInsideContour()
+{
+    VOIStatisticsCalculator calculator;
+    calculator.setInput(createImage(4));
+    // Contains columns and rows 2, 3 and 4
+    calculator.setContour(2, createSquare(1.5, 4.5));
+
+    VOIStatisticsCalculator::Statistics statistics = calculator.getStatistics();
+
+    QCOMPARE(statistics.data.getNumberOfVoxels(), 9);
+    QCOMPARE(statistics.data.getSum(), 27.0);
+    QCOMPARE(statistics.data.getMean(), 3.0);
+    QCOMPARE(statistics.data.getMaximum(), 4.0);
+    QCOMPARE(statistics.maximumIndex[0], 4);
+    QCOMPARE(statistics.maximumIndex[1], 2);
+    QCOMPARE(statistics.maximumIndex[2], 2);
+    QVERIFY(!statistics.hasStandardizedUptakeValues);
+}
+
+void test_VOIStatisticsCalculator::getStatistics_ShouldMeasureVoxelsInsideSphere()
+{
+    VOIStatisticsCalculator calculator;
+    calculator.setInput(createImage(4));
+    double center[3] = { 5.0, 5.0, 2.0 };
+    // Contains the center and its 6 neighbours
+    calculator.setSphere(center, 1.0);
+
+    VOIStatisticsCalculator::Statistics statistics = calculator.getStatistics();
+
+    QCOMPARE(statistics.data.getNumberOfVoxels(), 7);
+    QCOMPARE(statistics.data.getSum(), 35.0);
+    QCOMPARE(statistics.data.getMaximum(), 6.0);
+    QCOMPARE(statistics.data.getMinimum(), 4.0);
+}
+
+void test_VOIStatisticsCalculator::getStatistics_ShouldUpdateEditedContours()
+{
+    VOIStatisticsCalculator calculator;
+    calculator.setInput(createImage(4));
+    calculator.setContour(1, createSquare(1.5, 4.5));
+    calculator.setContour(2, createSquare(1.5, 4.5));
+
+    QCOMPARE(calculator.getStatistics().data.getNumberOfVoxels(), 18);
+
+    // Contains columns and rows from 2 to 7
+    calculator.setContour(2, createSquare(1.5, 7.5));
+
+    VOIStatisticsCalculator::Statistics statistics = calculator.getStatistics();
+    QCOMPARE(statistics.data.getNumberOfVoxels(), 45);
+    QCOMPARE(statistics.data.getMaximum(), 7.0);
+
+    calculator.removeContour(2);
+
+    QCOMPARE(calculator.getStatistics().data.getNumberOfVoxels(), 9);
+}
+
+void test_VOIStatisticsCalculator::getStatistics_ShouldMeasureEachPhase()
+{
+    VOIStatisticsCalculator calculator;
+    calculator.setInput(createImage(4, 3), 3);
+    calculator.setContour(1, createSquare(1.5, 4.5));
+
+    QCOMPARE(calculator.getNumberOfSlicesPerPhase(), 4);
+
+    QVector<VOIStatisticsCalculator::Statistics> statistics = calculator.getStatisticsOfAllPhases();
+
+    QCOMPARE(statistics.size(), 3);
+    for (int phase = 0; phase < 3; phase++)
+    {
+        QCOMPARE(statistics[phase].data.getNumberOfVoxels(), 9);
+        QCOMPARE(statistics[phase].data.getMaximum(), 100.0 * phase + 4.0);
+        QCOMPARE(statistics[phase].maximumIndex[2], 1 * 3 + phase);
+    }
+}
+
+void test_VOIStatisticsCalculator::getStatistics_ShouldReturnExpectedMetabolicVolume_data()
+{
+    QTest::addColumn<int>("thresholdType");
+    QTest::addColumn<double>("threshold");
+    QTest::addColumn<double>("expectedMetabolicVolume");
+
+    // Spacing is 2 mm in x and 1 mm in y and z and the values inside the contour are 2, 3 and 4, 3 voxels each
+    QTest::newRow("default") << -1 << 0.0 << 18.0;
+    QTest::newRow("fraction of maximum") << static_cast<int>(VOIStatisticsCalculator::FractionOfMaximumThreshold) << 0.75 << 12.0;
+    QTest::newRow("absolute") << static_cast<int>(VOIStatisticsCalculator::AbsoluteThreshold) << 3.5 << 6.0;
+    QTest::newRow("above maximum") << static_cast<int>(VOIStatisticsCalculator::AbsoluteThreshold) << 10.0 << 0.0;
+}
+
+void test_VOIStatisticsCalculator::getStatistics_ShouldReturnExpectedMetabolicVolume()
+{
+    QFETCH(int, thresholdType);
+    QFETCH(double, threshold);
+    QFETCH(double, expectedMetabolicVolume);
+
+    vtkSmartPointer<vtkImageData> image = createImage(4);
+    image->SetSpacing(2.0, 1.0, 1.0);
+
+    VOIStatisticsCalculator calculator;
+    calculator.setInput(image);
+    // Contains columns 2 to 4 and rows 2 to 4
+    QVector<QPointF> contour;
+    contour << QPointF(3.5, 1.5) << QPointF(8.5, 1.5) << QPointF(8.5, 4.5) << QPointF(3.5, 4.5);
+    calculator.setContour(2, contour);
+    if (thresholdType >= 0)
+    {
+        calculator.setMetabolicVolumeThreshold(static_cast<VOIStatisticsCalculator::MetabolicVolumeThresholdType>(thresholdType), threshold);
+    }
+
+    QCOMPARE(calculator.getStatistics().metabolicVolume, expectedMetabolicVolume);
+}
+
+void test_VOIStatisticsCalculator::getStatistics_ShouldReturnExpectedPeak()
+{
+    VOIStatisticsCalculator calculator;
+    calculator.setInput(createImage(20));
+    // Contains columns and rows from 6 to 10
+    calculator.setContour(10, createSquare(5.5, 10.5));
+
+    VOIStatisticsCalculator::Statistics statistics = calculator.getStatistics();
+
+    // The peak sphere is centered at (10, 6, 10), it's inside the image and its voxels have symmetric x values around 10
+    QCOMPARE(statistics.maximumIndex[0], 10);
+    QCOMPARE(statistics.maximumIndex[1], 6);
+    QCOMPARE(statistics.peak, 10.0);
+}
+
+vtkSmartPointer<vtkImageData> test_VOIStatisticsCalculator::createImage(int numberOfSlices, int numberOfPhases)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, 19, 0, 19, 0, numberOfSlices * numberOfPhases - 1);
+    image->SetSpacing(1.0, 1.0, 1.0);
+    image->SetOrigin(0.0, 0.0, 0.0);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    short *pointer = static_cast<short*>(image->GetScalarPointer());
+    for (int z = 0; z < numberOfSlices * numberOfPhases; z++)
+    {
+        for (int y = 0; y < 20; y++)
+        {
+            for (int x = 0; x < 20; x++)
+            {
+                *pointer++ = static_cast<short>(100 * (z % numberOfPhases) + x);
+            }
+        }
+    }
+
+    return image;
+}
+
+QVector<QPointF> test_VOIStatisticsCalculator::createSquare(double minimum, double maximum)
+{
+    QVector<QPointF> square;
+    square << QPointF(minimum, minimum) << QPointF(maximum, minimum) << QPointF(maximum, maximum) << QPointF(minimum, maximum);
+    return square;
+}
+
+DECLARE_TEST(test_VOIStatisticsCalculator)
+
+#include "test_voistatisticscalculator.moc"
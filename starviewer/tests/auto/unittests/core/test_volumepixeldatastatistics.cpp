@@ -0,0 +1,184 @@
+#include "autotest.h"
+#include "volumepixeldatastatistics.h"
+
+#include "volumepixeldata.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+
+class test_VolumePixelDataStatistics : public QObject {
+Q_OBJECT
+
+private slots:
+    void compute_ShouldBeEmptyWithoutImageData();
+
+    void compute_ShouldComputeVolumeAndSliceRanges();
+
+    void compute_ShouldGiveABinToEachIntegerValueWhenTheyFit();
+
+    void compute_ShouldSpreadValuesInTheBinsWhenTheyDontFit();
+
+    void getPercentile_ShouldReturnExactValuesForIntegers_data();
+    void getPercentile_ShouldReturnExactValuesForIntegers();
+
+    void getSlicePercentile_ShouldOnlyUseTheValuesOfTheSlice();
+
+    void getStatistics_ShouldReturnNullWhenPixelDataChanges();
+
+private:
+    /// Returns a 4x4x3 short image where each slice z has the values 100 * z + i for i in [0, 16)
+    static vtkSmartPointer<vtkImageData> createImage();
+};
+
+void test_VolumePixelDataStatistics::compute_ShouldBeEmptyWithoutImageData()
+{
+    VolumePixelDataStatistics statistics;
+    statistics.compute(0);
+
+    QVERIFY(statistics.isEmpty());
+    QCOMPARE(statistics.getNumberOfSlices(), 0);
+    QVERIFY(!statistics.isUpToDate(0));
+}
+
+void test_VolumePixelDataStatistics::compute_ShouldComputeVolumeAndSliceRanges()
+{
+    vtkSmartPointer<vtkImageData> image = createImage();
+    VolumePixelDataStatistics statistics;
+    statistics.compute(image);
+
+    QVERIFY(!statistics.isEmpty());
+    QVERIFY(statistics.isUpToDate(image));
+    QCOMPARE(statistics.getNumberOfSlices(), 3);
+
+    double range[2];
+    statistics.getRange(range);
+    QCOMPARE(range[0], 0.0);
+    QCOMPARE(range[1], 215.0);
+
+    for (int z = 0; z < 3; z++)
+    {
+        statistics.getSliceRange(z, range);
+        QCOMPARE(range[0], 100.0 * z);
+        QCOMPARE(range[1], 100.0 * z + 15.0);
+    }
+}
+
+void test_VolumePixelDataStatistics::compute_ShouldGiveABinToEachIntegerValueWhenTheyFit()
+{
+    vtkSmartPointer<vtkImageData> image = createImage();
+    VolumePixelDataStatistics statistics;
+    statistics.compute(image, 1000);
+
+    QCOMPARE(statistics.getNumberOfBins(), 216);
+    QCOMPARE(statistics.getBinWidth(), 1.0);
+    QCOMPARE(statistics.getBinMinimum(0), 0.0);
+    QCOMPARE(statistics.getHistogram().at(0), qint64(1));
+    QCOMPARE(statistics.getHistogram().at(16), qint64(0));
+    QCOMPARE(statistics.getHistogram().at(215), qint64(1));
+    QCOMPARE(statistics.getSliceHistogram(1).at(100), qint64(1));
+    QCOMPARE(statistics.getSliceHistogram(1).at(0), qint64(0));
+}
+
+void test_VolumePixelDataStatistics::compute_ShouldSpreadValuesInTheBinsWhenTheyDontFit()
+{
+    vtkSmartPointer<vtkImageData> image = createImage();
+    VolumePixelDataStatistics statistics;
+    statistics.compute(image, 4);
+
+    QCOMPARE(statistics.getNumberOfBins(), 4);
+    QCOMPARE(statistics.getBinWidth(), 215.0 / 4);
+
+    // Slice 0 falls in the first bin, slice 1 is split between the second and the third ones at 107.5 and slice 2 falls in the last one
+    QCOMPARE(statistics.getHistogram(), QVector<qint64>() << 16 << 8 << 8 << 16);
+
+    qint64 total = 0;
+    for (int z = 0; z < 3; z++)
+    {
+        foreach (qint64 count, statistics.getSliceHistogram(z))
+        {
+            total += count;
+        }
+    }
+    QCOMPARE(total, qint64(48));
+}
+
+void test_VolumePixelDataStatistics::getPercentile_ShouldReturnExactValuesForIntegers_data()
+{
+    QTest::addColumn<double>("percentage");
+    QTest::addColumn<double>("expectedValue");
+
+    QTest::newRow("0%") << 0.0 << 0.0;
+    QTest::newRow("25%") << 25.0 << 11.0;
+    QTest::newRow("50%") << 50.0 << 107.0;
+    QTest::newRow("100%") << 100.0 << 215.0;
+    QTest::newRow("over 100%") << 150.0 << 215.0;
+}
+
+void test_VolumePixelDataStatistics::getPercentile_ShouldReturnExactValuesForIntegers()
+{
+    QFETCH(double, percentage);
+    QFETCH(double, expectedValue);
+
+    vtkSmartPointer<vtkImageData> image = createImage();
+    VolumePixelDataStatistics statistics;
+    statistics.compute(image, 1000);
+
+    QCOMPARE(statistics.getPercentile(percentage), expectedValue);
+}
+
+void test_VolumePixelDataStatistics::getSlicePercentile_ShouldOnlyUseTheValuesOfTheSlice()
+{
+    vtkSmartPointer<vtkImageData> image = createImage();
+    VolumePixelDataStatistics statistics;
+    statistics.compute(image, 1000);
+
+    QCOMPARE(statistics.getSlicePercentile(2, 0.0), 200.0);
+    QCOMPARE(statistics.getSlicePercentile(2, 50.0), 207.0);
+    QCOMPARE(statistics.getSlicePercentile(2, 100.0), 215.0);
+}
+
+void test_VolumePixelDataStatistics::getStatistics_ShouldReturnNullWhenPixelDataChanges()
+{
+    VolumePixelData pixelData;
+    pixelData.setData(createImage());
+
+    QVERIFY(!pixelData.getStatistics());
+
+    pixelData.computeStatistics();
+    QVERIFY(pixelData.getStatistics());
+
+    pixelData.getVtkData()->GetPointData()->GetScalars()->Modified();
+    QVERIFY(!pixelData.getStatistics());
+
+    pixelData.computeStatistics();
+    QVERIFY(pixelData.getStatistics());
+
+    pixelData.setData(createImage());
+    QVERIFY(!pixelData.getStatistics());
+}
+
+vtkSmartPointer<vtkImageData> test_VolumePixelDataStatistics::createImage()
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, 3, 0, 3, 0, 2);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    short *scalars = static_cast<short*>(image->GetScalarPointer());
+    for (int z = 0; z < 3; z++)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            scalars[z * 16 + i] = 100 * z + i;
+        }
+    }
+
+    return image;
+}
+
+DECLARE_TEST(test_VolumePixelDataStatistics)
+
+#include "test_volumepixeldatastatistics.moc"
@@ -0,0 +1,4 @@
+SOURCES += $$PWD/test_experimental3dvolume.cpp \
+           $$PWD/test_obscurancemainthread.cpp \
+           $$PWD/test_viewpointvisibilityraycaster.cpp \
+           $$PWD/test_voxelprobabilitiesinviewstore.cpp
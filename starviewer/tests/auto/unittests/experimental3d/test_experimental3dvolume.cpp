@@ -0,0 +1,131 @@
+#include "autotest.h"
+#include "experimental3dvolume.h"
+
+#include "transferfunction.h"
+
+#include <QScopedPointer>
+
+#include <vtkCamera.h>
+#include <vtkImageData.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+
+class test_Experimental3DVolume : public QObject {
+Q_OBJECT
+
+private slots:
+    void render_Benchmark_data();
+    void render_Benchmark();
+
+private:
+    /// Returns a cubic volume of the given size with a sphere of value 1000 on a background of value 0
+    static Experimental3DVolume* createVolume(int size);
+};
+
+namespace {
+
+/// Shading options of the rendering
+enum Shading { Contour, CoolWarm };
+
+}
+
+Q_DECLARE_METATYPE(Shading)
+Q_DECLARE_METATYPE(Experimental3DVolume::GradientEstimator)
+
+void test_Experimental3DVolume::render_Benchmark_data()
+{
+    QTest::addColumn<Shading>("shading");
+    QTest::addColumn<Experimental3DVolume::GradientEstimator>("gradientEstimator");
+
+    QTest::newRow("contour, finite difference") << Contour << Experimental3DVolume::FiniteDifference;
+    QTest::newRow("contour, 4D linear regression") << Contour << Experimental3DVolume::FourDLInearRegression1;
+    QTest::newRow("cool-warm, finite difference") << CoolWarm << Experimental3DVolume::FiniteDifference;
+}
+
+void test_Experimental3DVolume::render_Benchmark()
+{
+    QFETCH(Shading, shading);
+    QFETCH(Experimental3DVolume::GradientEstimator, gradientEstimator);
+
+    QScopedPointer<Experimental3DVolume> volume(createVolume(128));
+
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
+    renderWindow->SetOffScreenRendering(1);
+    renderWindow->SetSize(512, 512);
+    renderWindow->AddRenderer(renderer);
+
+    if (!renderWindow->SupportsOpenGL())
+    {
+        QSKIP("OpenGL isn't available to render the volume");
+    }
+
+    TransferFunction transferFunction;
+    transferFunction.set(0.0, Qt::black, 0.0);
+    transferFunction.set(999.0, Qt::black, 0.0);
+    transferFunction.set(1000.0, QColor(255, 128, 0), 0.5);
+
+    volume->setGradientEstimator(gradientEstimator);
+    volume->setTransferFunction(transferFunction);
+    volume->resetShadingOptions();
+    volume->addAmbientLighting();
+    switch (shading)
+    {
+        case Contour:
+            volume->addContour(0.3);
+            break;
+        case CoolWarm:
+            volume->addCoolWarm(0.4f, 0.4f, 0.2f, 0.6f);
+            break;
+    }
+    volume->forceCpuShaderRendering();
+    renderer->AddViewProp(volume->getVolume());
+
+    vtkCamera *camera = renderer->GetActiveCamera();
+    camera->SetPosition(200.0, 150.0, 100.0);
+    camera->SetFocalPoint(0.0, 0.0, 0.0);
+    camera->SetViewUp(0.0, 0.0, 1.0);
+    renderer->ResetCameraClippingRange();
+
+    // The first rendering sets up the mapper and the VTK gradient estimator, so it is left out
+    renderWindow->Render();
+
+    QBENCHMARK
+    {
+        renderer->GetActiveCamera()->Azimuth(10.0);
+        renderWindow->Render();
+    }
+}
+
+Experimental3DVolume* test_Experimental3DVolume::createVolume(int size)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, size - 1, 0, size - 1, 0, size - 1);
+    image->SetSpacing(1.0, 1.0, 1.0);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    short *data = static_cast<short*>(image->GetScalarPointer());
+    double center = (size - 1) / 2.0;
+    double radius = size / 3.0;
+
+    for (int k = 0; k < size; k++)
+    {
+        for (int j = 0; j < size; j++)
+        {
+            for (int i = 0; i < size; i++)
+            {
+                double x = i - center, y = j - center, z = k - center;
+                *data++ = x * x + y * y + z * z <= radius * radius ? 1000 : 0;
+            }
+        }
+    }
+
+    return new Experimental3DVolume(image);
+}
+
+DECLARE_TEST(test_Experimental3DVolume)
+
+#include "test_experimental3dvolume.moc"
@@ -0,0 +1,148 @@
+#include "autotest.h"
+#include "obscurancemainthread.h"
+
+#include "experimental3dvolume.h"
+#include "fuzzycomparetesthelper.h"
+#include "obscurance.h"
+#include "transferfunction.h"
+
+#include <QScopedPointer>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+using namespace testing;
+
+class test_ObscuranceMainThread : public QObject {
+Q_OBJECT
+
+private slots:
+    void run_ShouldNotDependOnTheNumberOfThreads_data();
+    void run_ShouldNotDependOnTheNumberOfThreads();
+
+    void run_Benchmark_data();
+    void run_Benchmark();
+
+private:
+    /// Returns a volume of the given size ready to compute obscurances, with a sphere of value 1000 on a background of value 0
+    static Experimental3DVolume* createVolume(int size);
+
+    /// Computes the obscurances of the volume with the given number of threads and returns them
+    static Obscurance* computeObscurance(Experimental3DVolume *volume, ObscuranceMainThread::Variant variant, int numberOfThreads);
+};
+
+Q_DECLARE_METATYPE(ObscuranceMainThread::Variant)
+
+void test_ObscuranceMainThread::run_ShouldNotDependOnTheNumberOfThreads_data()
+{
+    QTest::addColumn<ObscuranceMainThread::Variant>("variant");
+    QTest::addColumn<int>("numberOfThreads");
+
+    QTest::newRow("density, 2 threads") << ObscuranceMainThread::Density << 2;
+    QTest::newRow("density, 7 threads") << ObscuranceMainThread::Density << 7;
+    QTest::newRow("opacity, 4 threads") << ObscuranceMainThread::Opacity << 4;
+    QTest::newRow("color bleeding, 4 threads") << ObscuranceMainThread::OpacityColorBleeding << 4;
+}
+
+void test_ObscuranceMainThread::run_ShouldNotDependOnTheNumberOfThreads()
+{
+    QFETCH(ObscuranceMainThread::Variant, variant);
+    QFETCH(int, numberOfThreads);
+
+    QScopedPointer<Experimental3DVolume> volume(createVolume(24));
+    QScopedPointer<Obscurance> expectedObscurance(computeObscurance(volume.data(), variant, 1));
+    QScopedPointer<Obscurance> obscurance(computeObscurance(volume.data(), variant, numberOfThreads));
+
+    QVERIFY(expectedObscurance);
+    QVERIFY(obscurance);
+    QCOMPARE(obscurance->size(), expectedObscurance->size());
+
+    // Only the order of the sums changes
+    for (unsigned int i = 0; i < obscurance->size(); i++)
+    {
+        QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(obscurance->obscurance(i), expectedObscurance->obscurance(i), 1e-9));
+
+        if (obscurance->hasColor())
+        {
+            QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(obscurance->colorBleeding(i).x, expectedObscurance->colorBleeding(i).x, 1e-9));
+            QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(obscurance->colorBleeding(i).y, expectedObscurance->colorBleeding(i).y, 1e-9));
+            QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(obscurance->colorBleeding(i).z, expectedObscurance->colorBleeding(i).z, 1e-9));
+        }
+    }
+}
+
+void test_ObscuranceMainThread::run_Benchmark_data()
+{
+    QTest::addColumn<int>("numberOfThreads");
+
+    // Scaling with the number of threads
+    for (int numberOfThreads = 1; numberOfThreads < QThread::idealThreadCount(); numberOfThreads *= 2)
+    {
+        QTest::newRow(qPrintable(QString("%1 threads").arg(numberOfThreads))) << numberOfThreads;
+    }
+    QTest::newRow(qPrintable(QString("%1 threads").arg(QThread::idealThreadCount()))) << QThread::idealThreadCount();
+}
+
+void test_ObscuranceMainThread::run_Benchmark()
+{
+    QFETCH(int, numberOfThreads);
+
+    QScopedPointer<Experimental3DVolume> volume(createVolume(96));
+
+    QBENCHMARK
+    {
+        delete computeObscurance(volume.data(), ObscuranceMainThread::Opacity, numberOfThreads);
+    }
+}
+
+Experimental3DVolume* test_ObscuranceMainThread::createVolume(int size)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, size - 1, 0, size - 1, 0, size - 1);
+    image->SetSpacing(1.0, 1.0, 1.0);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    short *data = static_cast<short*>(image->GetScalarPointer());
+    double center = (size - 1) / 2.0;
+    double radius = size / 3.0;
+
+    for (int k = 0; k < size; k++)
+    {
+        for (int j = 0; j < size; j++)
+        {
+            for (int i = 0; i < size; i++)
+            {
+                double x = i - center, y = j - center, z = k - center;
+                *data++ = x * x + y * y + z * z <= radius * radius ? 1000 : 0;
+            }
+        }
+    }
+
+    Experimental3DVolume *volume = new Experimental3DVolume(image);
+    // Obscurances are computed with the gradient estimator of the CPU ray cast mapper
+    volume->setGradientEstimator(Experimental3DVolume::FiniteDifference);
+    volume->forceCpuRendering();
+
+    return volume;
+}
+
+Obscurance* test_ObscuranceMainThread::computeObscurance(Experimental3DVolume *volume, ObscuranceMainThread::Variant variant, int numberOfThreads)
+{
+    TransferFunction transferFunction;
+    transferFunction.set(0.0, Qt::black, 0.0);
+    transferFunction.set(1000.0, QColor(255, 128, 0), 1.0);
+
+    ObscuranceMainThread thread(-20, 8.0, ObscuranceMainThread::ExponentialNorm, variant);
+    thread.setVolume(volume->getVolume());
+    thread.setTransferFunction(transferFunction);
+    thread.setNumberOfThreads(numberOfThreads);
+    thread.start();
+    thread.wait();
+
+    return thread.getObscurance();
+}
+
+DECLARE_TEST(test_ObscuranceMainThread)
+
+#include "test_obscurancemainthread.moc"
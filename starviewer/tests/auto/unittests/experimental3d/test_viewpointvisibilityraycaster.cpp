@@ -0,0 +1,232 @@
+#include "autotest.h"
+#include "viewpointvisibilityraycaster.h"
+
+#include "experimental3dvolume.h"
+#include "fuzzycomparetesthelper.h"
+#include "transferfunction.h"
+#include "viewpointgenerator.h"
+
+#include <QScopedPointer>
+
+#include <cmath>
+
+#include <vtkCamera.h>
+#include <vtkImageData.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+using namespace testing;
+
+class test_ViewpointVisibilityRayCaster : public QObject {
+Q_OBJECT
+
+private slots:
+    void rayCast_ShouldReturnNormalizedProbabilities();
+
+    void rayCast_ShouldCastEachViewpointAsOnItsOwn();
+
+    void rayCast_ShouldSeeTheSameRegionAsTheViewerRendering_data();
+    void rayCast_ShouldSeeTheSameRegionAsTheViewerRendering();
+
+private:
+    /// Returns a cubic volume of the given size with a sphere of value 1000 on a background of value 0
+    static Experimental3DVolume* createVolume(int size);
+
+    /// Returns a transfer function where the sphere has the given opacity and the background is transparent
+    static TransferFunction createTransferFunction(double opacity);
+
+    /// Returns p(Z|v) computed as before the ray caster existed: rendering the volume with the VMI voxel shader on a render window
+    static QVector<float> renderVoxelProbabilities(Experimental3DVolume *volume, const TransferFunction &transferFunction, const Vector3 &viewpoint,
+                                                   int imageSize);
+
+    /// Returns the mean position of the voxels weighted by the given probabilities, with the volume centered at the origin
+    static Vector3 getCentroid(const QVector<float> &voxelProbabilities, const int dimensions[3]);
+};
+
+Q_DECLARE_METATYPE(Vector3)
+
+namespace {
+
+const int VolumeSize = 24;
+const double ViewpointDistance = 60.0;
+const int ImageSize = 128;
+
+}
+
+void test_ViewpointVisibilityRayCaster::rayCast_ShouldReturnNormalizedProbabilities()
+{
+    QScopedPointer<Experimental3DVolume> volume(createVolume(VolumeSize));
+    ViewpointVisibilityRayCaster rayCaster(volume->getImage(), createTransferFunction(1.0));
+    rayCaster.setImageSize(ImageSize);
+
+    ViewpointVisibilityRayCaster::View view = rayCaster.rayCast(Vector3(0.0, 0.0, ViewpointDistance));
+
+    QVERIFY(view.viewedVolume > 0.0f);
+    QCOMPARE(view.voxelProbabilities.size(), VolumeSize * VolumeSize * VolumeSize);
+
+    double sum = 0.0;
+    foreach (float probability, view.voxelProbabilities)
+    {
+        QVERIFY(probability >= 0.0f);
+        sum += probability;
+    }
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(sum, 1.0, 1e-4));
+}
+
+void test_ViewpointVisibilityRayCaster::rayCast_ShouldCastEachViewpointAsOnItsOwn()
+{
+    QScopedPointer<Experimental3DVolume> volume(createVolume(VolumeSize));
+    ViewpointVisibilityRayCaster rayCaster(volume->getImage(), createTransferFunction(0.1));
+    rayCaster.setImageSize(ImageSize);
+
+    ViewpointGenerator viewpointGenerator;
+    viewpointGenerator.setToUniform6(ViewpointDistance);
+    QVector<Vector3> viewpoints = viewpointGenerator.viewpoints();
+
+    QVector<ViewpointVisibilityRayCaster::View> views = rayCaster.rayCast(viewpoints);
+
+    QCOMPARE(views.size(), viewpoints.size());
+    for (int i = 0; i < viewpoints.size(); i++)
+    {
+        ViewpointVisibilityRayCaster::View view = rayCaster.rayCast(viewpoints.at(i));
+        QCOMPARE(views.at(i).viewedVolume, view.viewedVolume);
+        QCOMPARE(views.at(i).voxelProbabilities, view.voxelProbabilities);
+    }
+}
+
+void test_ViewpointVisibilityRayCaster::rayCast_ShouldSeeTheSameRegionAsTheViewerRendering_data()
+{
+    QTest::addColumn<double>("opacity");
+    QTest::addColumn<Vector3>("viewpoint");
+
+    QTest::newRow("opaque, from x") << 1.0 << Vector3(ViewpointDistance, 0.0, 0.0);
+    QTest::newRow("opaque, from -z") << 1.0 << Vector3(0.0, 0.0, -ViewpointDistance);
+    QTest::newRow("opaque, from a diagonal") << 1.0 << Vector3(1.0, 1.0, 1.0) * (ViewpointDistance / std::sqrt(3.0));
+    QTest::newRow("translucent, from y") << 0.1 << Vector3(0.0, ViewpointDistance, 0.0);
+}
+
+void test_ViewpointVisibilityRayCaster::rayCast_ShouldSeeTheSameRegionAsTheViewerRendering()
+{
+    QFETCH(double, opacity);
+    QFETCH(Vector3, viewpoint);
+
+    QScopedPointer<Experimental3DVolume> volume(createVolume(VolumeSize));
+    TransferFunction transferFunction = createTransferFunction(opacity);
+    int dimensions[3];
+    volume->getImage()->GetDimensions(dimensions);
+
+    QVector<float> expectedProbabilities = renderVoxelProbabilities(volume.data(), transferFunction, viewpoint, ImageSize);
+    if (expectedProbabilities.isEmpty())
+    {
+        QSKIP("OpenGL isn't available to render the volume");
+    }
+
+    ViewpointVisibilityRayCaster rayCaster(volume->getImage(), transferFunction);
+    rayCaster.setImageSize(ImageSize);
+    QVector<float> probabilities = rayCaster.rayCast(viewpoint).voxelProbabilities;
+
+    // The sampling and the field of view aren't the same as in the rendering, so the probabilities aren't either, but the seen region must be
+    Vector3 expectedCentroid = getCentroid(expectedProbabilities, dimensions);
+    Vector3 centroid = getCentroid(probabilities, dimensions);
+    QVERIFY2((centroid - expectedCentroid).length() < 1.5,
+             qPrintable(QString("centroid: %1, expected: %2").arg(centroid.toString()).arg(expectedCentroid.toString())));
+
+    // The visible voxels face the viewpoint
+    QVERIFY(Vector3::dot(centroid, viewpoint) > 0.0);
+}
+
+Experimental3DVolume* test_ViewpointVisibilityRayCaster::createVolume(int size)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, size - 1, 0, size - 1, 0, size - 1);
+    image->SetSpacing(1.0, 1.0, 1.0);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    short *data = static_cast<short*>(image->GetScalarPointer());
+    double center = (size - 1) / 2.0;
+    double radius = size / 3.0;
+
+    for (int k = 0; k < size; k++)
+    {
+        for (int j = 0; j < size; j++)
+        {
+            for (int i = 0; i < size; i++)
+            {
+                double x = i - center, y = j - center, z = k - center;
+                *data++ = x * x + y * y + z * z <= radius * radius ? 1000 : 0;
+            }
+        }
+    }
+
+    return new Experimental3DVolume(image);
+}
+
+TransferFunction test_ViewpointVisibilityRayCaster::createTransferFunction(double opacity)
+{
+    TransferFunction transferFunction;
+    transferFunction.set(0.0, Qt::white, 0.0);
+    transferFunction.set(999.0, Qt::white, 0.0);
+    transferFunction.set(1000.0, Qt::white, opacity);
+
+    return transferFunction;
+}
+
+QVector<float> test_ViewpointVisibilityRayCaster::renderVoxelProbabilities(Experimental3DVolume *volume, const TransferFunction &transferFunction,
+                                                                          const Vector3 &viewpoint, int imageSize)
+{
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
+    renderWindow->SetOffScreenRendering(1);
+    renderWindow->SetSize(imageSize, imageSize);
+    renderWindow->AddRenderer(renderer);
+
+    if (!renderWindow->SupportsOpenGL())
+    {
+        return QVector<float>();
+    }
+
+    volume->setTransferFunction(transferFunction);
+    volume->startVmiMode();
+    renderer->AddViewProp(volume->getVolume());
+
+    // Same camera as QExperimental3DViewer::setCamera()
+    Vector3 up = ViewpointGenerator::up(viewpoint);
+    vtkCamera *camera = renderer->GetActiveCamera();
+    camera->SetPosition(viewpoint.x, viewpoint.y, viewpoint.z);
+    camera->SetFocalPoint(0.0, 0.0, 0.0);
+    camera->SetViewUp(up.x, up.y, up.z);
+    renderer->ResetCameraClippingRange();
+
+    volume->startVmiSecondPass();
+    renderWindow->Render();
+
+    return volume->finishVmiSecondPass();
+}
+
+Vector3 test_ViewpointVisibilityRayCaster::getCentroid(const QVector<float> &voxelProbabilities, const int dimensions[3])
+{
+    Vector3 centroid;
+    double sum = 0.0;
+    int i = 0;
+
+    for (int z = 0; z < dimensions[2]; z++)
+    {
+        for (int y = 0; y < dimensions[1]; y++)
+        {
+            for (int x = 0; x < dimensions[0]; x++, i++)
+            {
+                Vector3 position(x - (dimensions[0] - 1) / 2.0, y - (dimensions[1] - 1) / 2.0, z - (dimensions[2] - 1) / 2.0);
+                centroid += voxelProbabilities.at(i) * position;
+                sum += voxelProbabilities.at(i);
+            }
+        }
+    }
+
+    return sum > 0.0 ? centroid / sum : centroid;
+}
+
+DECLARE_TEST(test_ViewpointVisibilityRayCaster)
+
+#include "test_viewpointvisibilityraycaster.moc"
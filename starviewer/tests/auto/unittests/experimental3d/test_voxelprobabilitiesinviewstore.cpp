@@ -0,0 +1,145 @@
+#include "autotest.h"
+#include "voxelprobabilitiesinviewstore.h"
+
+#include <QVector>
+
+using namespace udg;
+
+class test_VoxelProbabilitiesInViewStore : public QObject {
+Q_OBJECT
+
+private slots:
+    void get_ShouldReturnZerosForViewsNotStored();
+
+    void get_ShouldReturnTheStoredProbabilities_data();
+    void get_ShouldReturnTheStoredProbabilities();
+
+    void set_ShouldWriteTheViewsThatDontFitInTheMemoryBudgetToTheFile();
+
+    void set_ShouldReplaceTheStoredProbabilities();
+
+    void set_ShouldReuseTheFileSpaceOfReplacedViews();
+
+private:
+    /// Returns probabilities for the given number of voxels where only one of every step voxels isn't zero
+    static QVector<float> createProbabilities(int numberOfVoxels, int step);
+};
+
+Q_DECLARE_METATYPE(QVector<float>)
+
+void test_VoxelProbabilitiesInViewStore::get_ShouldReturnZerosForViewsNotStored()
+{
+    VoxelProbabilitiesInViewStore store(4, 100);
+
+    QVERIFY(store.set(1, createProbabilities(100, 1)));
+
+    QCOMPARE(store.get(0), QVector<float>(100, 0.0f));
+    QCOMPARE(store.get(3), QVector<float>(100, 0.0f));
+}
+
+void test_VoxelProbabilitiesInViewStore::get_ShouldReturnTheStoredProbabilities_data()
+{
+    QTest::addColumn<QVector<float> >("probabilities");
+    QTest::addColumn<qint64>("memoryBudget");
+    QTest::addColumn<int>("expectedNumberOfSparseViews");
+
+    QTest::newRow("sparse in memory") << createProbabilities(1000, 10) << VoxelProbabilitiesInViewStore::DefaultMemoryBudget << 1;
+    QTest::newRow("dense in memory") << createProbabilities(1000, 1) << VoxelProbabilitiesInViewStore::DefaultMemoryBudget << 0;
+    QTest::newRow("all zeros in memory") << QVector<float>(1000, 0.0f) << VoxelProbabilitiesInViewStore::DefaultMemoryBudget << 1;
+    QTest::newRow("sparse in file") << createProbabilities(1000, 10) << qint64(0) << 1;
+    QTest::newRow("dense in file") << createProbabilities(1000, 1) << qint64(0) << 0;
+    QTest::newRow("all zeros without memory budget") << QVector<float>(1000, 0.0f) << qint64(0) << 1;
+}
+
+void test_VoxelProbabilitiesInViewStore::get_ShouldReturnTheStoredProbabilities()
+{
+    QFETCH(QVector<float>, probabilities);
+    QFETCH(qint64, memoryBudget);
+    QFETCH(int, expectedNumberOfSparseViews);
+
+    VoxelProbabilitiesInViewStore store(2, probabilities.size(), memoryBudget);
+
+    QVERIFY(store.set(0, probabilities));
+
+    // The encoding is lossless
+    QCOMPARE(store.get(0), probabilities);
+    QCOMPARE(store.getNumberOfSparseViews(), expectedNumberOfSparseViews);
+}
+
+void test_VoxelProbabilitiesInViewStore::set_ShouldWriteTheViewsThatDontFitInTheMemoryBudgetToTheFile()
+{
+    QVector<QVector<float> > probabilities;
+    probabilities << createProbabilities(1000, 1) << createProbabilities(1000, 2) << createProbabilities(1000, 3);
+
+    // Room for two dense views
+    VoxelProbabilitiesInViewStore store(probabilities.size(), 1000, 2 * 1000 * sizeof(float));
+
+    for (int i = 0; i < probabilities.size(); i++)
+    {
+        QVERIFY(store.set(i, probabilities.at(i)));
+    }
+
+    QVERIFY(store.getMemoryUsage() <= 2 * 1000 * sizeof(float));
+    QVERIFY(store.getFileUsage() > 0);
+
+    for (int i = 0; i < probabilities.size(); i++)
+    {
+        QCOMPARE(store.get(i), probabilities.at(i));
+    }
+}
+
+void test_VoxelProbabilitiesInViewStore::set_ShouldReplaceTheStoredProbabilities()
+{
+    VoxelProbabilitiesInViewStore store(1, 1000);
+    QVector<float> probabilities = createProbabilities(1000, 10);
+
+    QVERIFY(store.set(0, createProbabilities(1000, 1)));
+    QVERIFY(store.set(0, probabilities));
+
+    QCOMPARE(store.get(0), probabilities);
+    QCOMPARE(store.getNumberOfSparseViews(), 1);
+}
+
+void test_VoxelProbabilitiesInViewStore::set_ShouldReuseTheFileSpaceOfReplacedViews()
+{
+    QVector<float> dense = createProbabilities(1000, 1);
+    QVector<float> sparse = createProbabilities(1000, 10);
+
+    // Without memory budget every view goes to the file
+    VoxelProbabilitiesInViewStore store(2, 1000, 0);
+
+    QVERIFY(store.set(0, dense));
+    QVERIFY(store.set(1, dense));
+    qint64 fileSize = store.getFileSize();
+    QCOMPARE(fileSize, qint64(2 * 1000 * sizeof(float)));
+
+    for (int i = 0; i < 10; i++)
+    {
+        QVERIFY(store.set(0, sparse));
+        QVERIFY(store.set(0, dense));
+        QVERIFY(store.set(1, i % 2 == 0 ? sparse : dense));
+    }
+
+    QCOMPARE(store.getFileSize(), fileSize);
+    QCOMPARE(store.getFileUsage(), fileSize);
+    QCOMPARE(store.get(0), dense);
+    QCOMPARE(store.get(1), dense);
+}
+
+QVector<float> test_VoxelProbabilitiesInViewStore::createProbabilities(int numberOfVoxels, int step)
+{
+    QVector<float> probabilities(numberOfVoxels, 0.0f);
+    int numberOfValues = (numberOfVoxels + step - 1) / step;
+
+    for (int i = 0; i < numberOfVoxels; i += step)
+    {
+        // Different values, so that a wrong order would be detected
+        probabilities[i] = (i + 1.0f) / (numberOfValues * numberOfVoxels);
+    }
+
+    return probabilities;
+}
+
+DECLARE_TEST(test_VoxelProbabilitiesInViewStore)
+
+#include "test_voxelprobabilitiesinviewstore.moc"
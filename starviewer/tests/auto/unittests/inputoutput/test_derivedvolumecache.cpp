@@ -0,0 +1,241 @@
+#include "autotest.h"
+#include "derivedvolumecache.h"
+
+#include "fuzzycomparetesthelper.h"
+
+#include <QTemporaryDir>
+#include <QVector>
+
+using namespace udg;
+using namespace testing;
+
+class test_DerivedVolumeCache : public QObject {
+Q_OBJECT
+
+private slots:
+    void computeKey_ShouldDependOnlyOnParameters();
+
+    void load_ShouldReturnStoredValuesWithinQuantizationError_data();
+    void load_ShouldReturnStoredValuesWithinQuantizationError();
+
+    void load_ShouldReturnDoubleValuesWithoutLoss();
+
+    void load_ShouldFailIfVolumeIsMissingOrHasOtherSize();
+
+    void store_ShouldFailWithoutSeries();
+
+    void store_ShouldDeleteVolumesToStayUnderMaximumSize();
+
+    void trim_ShouldDeleteVolumesToStayUnderTheGivenSize();
+
+    void getStudySize_ShouldCountOnlyVolumesOfThatStudy();
+
+    void removeSeries_ShouldDeleteOnlyVolumesOfThatSeries();
+    void removeStudy_ShouldDeleteAllVolumesOfThatStudy();
+
+private:
+    static QVector<float> createValues(int numberOfValues, float minimum, float maximum);
+};
+
+Q_DECLARE_METATYPE(QVector<float>)
+
+void test_DerivedVolumeCache::computeKey_ShouldDependOnlyOnParameters()
+{
+    QString key = DerivedVolumeCache::computeKey("obscurance 1 2 3");
+
+    QCOMPARE(DerivedVolumeCache::computeKey("obscurance 1 2 3"), key);
+    QVERIFY(DerivedVolumeCache::computeKey("obscurance 1 2 4") != key);
+    QVERIFY(!key.isEmpty());
+}
+
+void test_DerivedVolumeCache::load_ShouldReturnStoredValuesWithinQuantizationError_data()
+{
+    QTest::addColumn<QVector<float> >("values");
+    QTest::addColumn<int>("numberOfComponents");
+
+    QTest::newRow("one component in [0, 1]") << createValues(1000, 0.0f, 1.0f) << 1;
+    QTest::newRow("one component in [-50, 200]") << createValues(1000, -50.0f, 200.0f) << 1;
+    QTest::newRow("three components") << createValues(3000, 0.0f, 3.0f) << 3;
+    QTest::newRow("constant") << QVector<float>(100, 0.25f) << 1;
+}
+
+void test_DerivedVolumeCache::load_ShouldReturnStoredValuesWithinQuantizationError()
+{
+    QFETCH(QVector<float>, values);
+    QFETCH(int, numberOfComponents);
+
+    QTemporaryDir directory;
+    DerivedVolumeCache cache(directory.path(), 1024 * 1024);
+    int numberOfVoxels = values.size() / numberOfComponents;
+
+    QVERIFY(cache.store("1.2.3", "1.2.3.4", "key", values.constData(), numberOfVoxels, numberOfComponents));
+    QVERIFY(cache.contains("1.2.3", "1.2.3.4", "key"));
+
+    QVector<float> loadedValues(values.size());
+    QVERIFY(cache.load("1.2.3", "1.2.3.4", "key", loadedValues.data(), numberOfVoxels, numberOfComponents));
+
+    for (int i = 0; i < values.size(); i++)
+    {
+        QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(loadedValues.at(i), values.at(i), 0.003));
+    }
+}
+
+void test_DerivedVolumeCache::load_ShouldReturnDoubleValuesWithoutLoss()
+{
+    // Differences far below the resolution of 16 bits
+    QVector<double> values(500);
+    for (int i = 0; i < values.size(); i++)
+    {
+        values[i] = i / 499.0 + i * 1e-12;
+    }
+
+    QTemporaryDir directory;
+    DerivedVolumeCache cache(directory.path(), 1024 * 1024);
+
+    QVERIFY(cache.store("1.2.3", "1.2.3.4", "key", values.constData(), values.size()));
+
+    QVector<double> loadedValues(values.size());
+    QVERIFY(cache.load("1.2.3", "1.2.3.4", "key", loadedValues.data(), values.size()));
+    QCOMPARE(loadedValues, values);
+
+    // A volume of doubles can't be loaded as floats
+    QVector<float> loadedFloatValues(values.size());
+    QVERIFY(!cache.load("1.2.3", "1.2.3.4", "key", loadedFloatValues.data(), values.size()));
+}
+
+void test_DerivedVolumeCache::load_ShouldFailIfVolumeIsMissingOrHasOtherSize()
+{
+    QVector<float> values = createValues(100, 0.0f, 1.0f);
+
+    QTemporaryDir directory;
+    DerivedVolumeCache cache(directory.path(), 1024 * 1024);
+    QVERIFY(cache.store("1.2.3", "1.2.3.4", "key", values.constData(), values.size()));
+
+    QVector<float> loadedValues(200);
+    QVERIFY(!cache.load("1.2.3", "1.2.3.4", "otherKey", loadedValues.data(), 100));
+    QVERIFY(!cache.load("1.2.3", "1.2.3.5", "key", loadedValues.data(), 100));
+    QVERIFY(!cache.load("1.2.3", "1.2.3.4", "key", loadedValues.data(), 200));
+    QVERIFY(!cache.load("1.2.3", "1.2.3.4", "key", loadedValues.data(), 50, 2));
+}
+
+void test_DerivedVolumeCache::store_ShouldFailWithoutSeries()
+{
+    QVector<float> values = createValues(100, 0.0f, 1.0f);
+
+    QTemporaryDir directory;
+    DerivedVolumeCache cache(directory.path(), 1024 * 1024);
+
+    QVERIFY(!cache.store("1.2.3", "", "key", values.constData(), values.size()));
+    QVERIFY(!cache.store("", "1.2.3.4", "key", values.constData(), values.size()));
+    QCOMPARE(cache.getSize(), qint64(0));
+}
+
+void test_DerivedVolumeCache::store_ShouldDeleteVolumesToStayUnderMaximumSize()
+{
+    QVector<float> values = createValues(1000, 0.0f, 1.0f);
+
+    QTemporaryDir directory;
+    DerivedVolumeCache unboundedCache(directory.path(), 1024 * 1024);
+    QVERIFY(unboundedCache.store("1.2.3", "1.2.3.4", "key1", values.constData(), values.size()));
+    qint64 volumeSize = unboundedCache.getSize();
+
+    DerivedVolumeCache cache(directory.path(), 2 * volumeSize);
+    QVERIFY(cache.store("1.2.3", "1.2.3.4", "key2", values.constData(), values.size()));
+    QVERIFY(cache.store("1.2.3", "1.2.3.4", "key3", values.constData(), values.size()));
+
+    QCOMPARE(cache.getSize(), 2 * volumeSize);
+    int numberOfCachedVolumes = 0;
+    foreach (const QString &key, QStringList() << "key1" << "key2" << "key3")
+    {
+        if (cache.contains("1.2.3", "1.2.3.4", key))
+        {
+            numberOfCachedVolumes++;
+        }
+    }
+    QCOMPARE(numberOfCachedVolumes, 2);
+}
+
+void test_DerivedVolumeCache::trim_ShouldDeleteVolumesToStayUnderTheGivenSize()
+{
+    QVector<float> values = createValues(1000, 0.0f, 1.0f);
+
+    QTemporaryDir directory;
+    DerivedVolumeCache cache(directory.path(), 1024 * 1024);
+    foreach (const QString &key, QStringList() << "key1" << "key2" << "key3")
+    {
+        QVERIFY(cache.store("1.2.3", "1.2.3.4", key, values.constData(), values.size()));
+    }
+    qint64 volumeSize = cache.getSize() / 3;
+
+    cache.trim(volumeSize);
+
+    QCOMPARE(cache.getSize(), volumeSize);
+
+    cache.trim(0);
+
+    QCOMPARE(cache.getSize(), qint64(0));
+}
+
+void test_DerivedVolumeCache::getStudySize_ShouldCountOnlyVolumesOfThatStudy()
+{
+    QVector<float> values = createValues(1000, 0.0f, 1.0f);
+
+    QTemporaryDir directory;
+    DerivedVolumeCache cache(directory.path(), 1024 * 1024);
+    QVERIFY(cache.store("1.2.3", "1.2.3.4", "key1", values.constData(), values.size()));
+    qint64 volumeSize = cache.getSize();
+    QVERIFY(cache.store("1.2.3", "1.2.3.5", "key2", values.constData(), values.size()));
+    QVERIFY(cache.store("1.2.4", "1.2.4.1", "key3", values.constData(), values.size()));
+
+    QCOMPARE(cache.getStudySize("1.2.3"), 2 * volumeSize);
+    QCOMPARE(cache.getStudySize("1.2.4"), volumeSize);
+    QCOMPARE(cache.getStudySize("1.2.5"), qint64(0));
+}
+
+void test_DerivedVolumeCache::removeSeries_ShouldDeleteOnlyVolumesOfThatSeries()
+{
+    QVector<float> values = createValues(100, 0.0f, 1.0f);
+
+    QTemporaryDir directory;
+    DerivedVolumeCache cache(directory.path(), 1024 * 1024);
+    QVERIFY(cache.store("1.2.3", "1.2.3.4", "key", values.constData(), values.size()));
+    QVERIFY(cache.store("1.2.3", "1.2.3.5", "key", values.constData(), values.size()));
+
+    cache.removeSeries("1.2.3", "1.2.3.4");
+
+    QVERIFY(!cache.contains("1.2.3", "1.2.3.4", "key"));
+    QVERIFY(cache.contains("1.2.3", "1.2.3.5", "key"));
+}
+
+void test_DerivedVolumeCache::removeStudy_ShouldDeleteAllVolumesOfThatStudy()
+{
+    QVector<float> values = createValues(100, 0.0f, 1.0f);
+
+    QTemporaryDir directory;
+    DerivedVolumeCache cache(directory.path(), 1024 * 1024);
+    QVERIFY(cache.store("1.2.3", "1.2.3.4", "key", values.constData(), values.size()));
+    QVERIFY(cache.store("1.2.3", "1.2.3.5", "key", values.constData(), values.size()));
+    QVERIFY(cache.store("1.2.6", "1.2.6.7", "key", values.constData(), values.size()));
+
+    cache.removeStudy("1.2.3");
+
+    QVERIFY(!cache.contains("1.2.3", "1.2.3.4", "key"));
+    QVERIFY(!cache.contains("1.2.3", "1.2.3.5", "key"));
+    QVERIFY(cache.contains("1.2.6", "1.2.6.7", "key"));
+}
+
+QVector<float> test_DerivedVolumeCache::createValues(int numberOfValues, float minimum, float maximum)
+{
+    QVector<float> values(numberOfValues);
+    for (int i = 0; i < numberOfValues; i++)
+    {
+        // Not monotonic, so that the quantization doesn't depend on the order of the values
+        values[i] = minimum + (maximum - minimum) * ((i * 37) % numberOfValues) / (numberOfValues - 1);
+    }
+
+    return values;
+}
+
+DECLARE_TEST(test_DerivedVolumeCache)
+
+#include "test_derivedvolumecache.moc"
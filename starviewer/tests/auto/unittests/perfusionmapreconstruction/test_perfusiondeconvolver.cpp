@@ -0,0 +1,257 @@
+#include "autotest.h"
+#include "perfusiondeconvolver.h"
+
+#include "fuzzycomparetesthelper.h"
+
+#include <QVector>
+
+#include <cmath>
+
+#include <itkImage.h>
+#include <itkImageRegionIterator.h>
+#include <itkVnlForwardFFTImageFilter.h>
+#include <itkVnlInverseFFTImageFilter.h>
+
+using namespace udg;
+using namespace testing;
+
+class test_PerfusionDeconvolver : public QObject {
+Q_OBJECT
+
+private slots:
+    void deconvolve_ShouldMatchThePreviousItkDeconvolution_data();
+    void deconvolve_ShouldMatchThePreviousItkDeconvolution();
+
+    void deconvolve_ShouldInvertTheCircularConvolution_data();
+    void deconvolve_ShouldInvertTheCircularConvolution();
+
+    void computeMaximumResidue_ShouldReturnTheMaximumOfTheResidueFunction();
+
+private:
+    /// Returns a gamma variate bolus with the given number of samples
+    static QVector<double> createArterialInputFunction(int numberOfSamples);
+
+    /// Returns an exponential residue function with the given number of samples and mean transit time
+    static QVector<double> createResidueFunction(int numberOfSamples, double meanTransitTime);
+
+    /// Returns the circular convolution of a and b, which must have the same size
+    static QVector<double> convolve(const QVector<double> &a, const QVector<double> &b);
+
+    /// Deconvolves the tissue curve as PerfusionMapCalculatorMainThread did before PerfusionDeconvolver: with ITK forward and inverse FFT filters
+    /// for each curve and the regularized filter computed for each frequency
+    static QVector<double> deconvolveWithItk(const QVector<double> &aif, const QVector<double> &tissue, double regularizationFactor,
+                                             double regularizationExponent, const QVector<double> &omega);
+};
+
+void test_PerfusionDeconvolver::deconvolve_ShouldMatchThePreviousItkDeconvolution_data()
+{
+    QTest::addColumn<int>("numberOfSamples");
+    QTest::addColumn<double>("regularizationFactor");
+    QTest::addColumn<double>("regularizationExponent");
+
+    QTest::newRow("40 samples without regularization") << 40 << 0.0 << 1.0;
+    QTest::newRow("40 samples, exponent 1") << 40 << 0.5 << 1.0;
+    QTest::newRow("60 samples, exponent 2") << 60 << 0.1 << 2.0;
+    QTest::newRow("64 samples, exponent 1") << 64 << 2.0 << 1.0;
+    QTest::newRow("45 samples, exponent 1") << 45 << 0.5 << 1.0;
+}
+
+void test_PerfusionDeconvolver::deconvolve_ShouldMatchThePreviousItkDeconvolution()
+{
+    QFETCH(int, numberOfSamples);
+    QFETCH(double, regularizationFactor);
+    QFETCH(double, regularizationExponent);
+
+    QVector<double> aif = createArterialInputFunction(numberOfSamples);
+    PerfusionDeconvolver deconvolver;
+    deconvolver.setArterialInputFunction(aif, regularizationFactor, regularizationExponent);
+    PerfusionDeconvolver::Workspace workspace(deconvolver);
+
+    // Several curves at once, to check that each one uses its own samples
+    const int numberOfCurves = 3;
+    QVector<double> tissueCurves;
+    for (int i = 0; i < numberOfCurves; i++)
+    {
+        tissueCurves << convolve(aif, createResidueFunction(numberOfSamples, 2.0 + 3.0 * i));
+    }
+
+    QVector<double> residueFunctions(tissueCurves.size());
+    deconvolver.deconvolve(tissueCurves.constData(), numberOfCurves, residueFunctions.data(), workspace);
+
+    for (int i = 0; i < numberOfCurves; i++)
+    {
+        QVector<double> expectedResidueFunction = deconvolveWithItk(aif, tissueCurves.mid(i * numberOfSamples, numberOfSamples), regularizationFactor,
+                                                                    regularizationExponent, deconvolver.getOmega());
+        QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(residueFunctions.mid(i * numberOfSamples, numberOfSamples), expectedResidueFunction, 1e-9));
+    }
+}
+
+void test_PerfusionDeconvolver::deconvolve_ShouldInvertTheCircularConvolution_data()
+{
+    QTest::addColumn<int>("numberOfSamples");
+
+    QTest::newRow("FFT") << 30;
+    // 7 and 11 aren't supported by the FFT, so the direct DFT is used
+    QTest::newRow("DFT") << 77;
+}
+
+void test_PerfusionDeconvolver::deconvolve_ShouldInvertTheCircularConvolution()
+{
+    QFETCH(int, numberOfSamples);
+
+    QVector<double> aif = createArterialInputFunction(numberOfSamples);
+    QVector<double> residueFunction = createResidueFunction(numberOfSamples, 4.0);
+    QVector<double> tissue = convolve(aif, residueFunction);
+
+    PerfusionDeconvolver deconvolver;
+    deconvolver.setArterialInputFunction(aif, 0.0, 1.0);
+    PerfusionDeconvolver::Workspace workspace(deconvolver);
+
+    QVector<double> result(numberOfSamples);
+    deconvolver.deconvolve(tissue.constData(), 1, result.data(), workspace);
+
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(result, residueFunction, 1e-6));
+}
+
+void test_PerfusionDeconvolver::computeMaximumResidue_ShouldReturnTheMaximumOfTheResidueFunction()
+{
+    const int numberOfSamples = 40;
+    QVector<double> aif = createArterialInputFunction(numberOfSamples);
+    QVector<double> tissue = convolve(aif, createResidueFunction(numberOfSamples, 5.0));
+
+    PerfusionDeconvolver deconvolver;
+    deconvolver.setArterialInputFunction(aif, 0.5, 1.0);
+    PerfusionDeconvolver::Workspace workspace(deconvolver);
+
+    QVector<double> residueFunction = deconvolveWithItk(aif, tissue, 0.5, 1.0, deconvolver.getOmega());
+    double expectedMaximum = residueFunction.first();
+    foreach (double value, residueFunction)
+    {
+        expectedMaximum = qMax(expectedMaximum, value);
+    }
+
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(deconvolver.computeMaximumResidue(tissue.constData(), workspace), expectedMaximum, 1e-9));
+}
+
+QVector<double> test_PerfusionDeconvolver::createArterialInputFunction(int numberOfSamples)
+{
+    QVector<double> aif(numberOfSamples, 0.0);
+    const double arrivalTime = 3.0, alpha = 3.0, beta = 1.5;
+
+    for (int i = 0; i < numberOfSamples; i++)
+    {
+        double t = i - arrivalTime;
+        if (t > 0.0)
+        {
+            aif[i] = 10.0 * std::pow(t, alpha) * std::exp(-t / beta);
+        }
+    }
+
+    return aif;
+}
+
+QVector<double> test_PerfusionDeconvolver::createResidueFunction(int numberOfSamples, double meanTransitTime)
+{
+    QVector<double> residueFunction(numberOfSamples);
+    for (int i = 0; i < numberOfSamples; i++)
+    {
+        residueFunction[i] = 0.05 * std::exp(-i / meanTransitTime);
+    }
+
+    return residueFunction;
+}
+
+QVector<double> test_PerfusionDeconvolver::convolve(const QVector<double> &a, const QVector<double> &b)
+{
+    int size = a.size();
+    QVector<double> result(size, 0.0);
+
+    for (int i = 0; i < size; i++)
+    {
+        for (int j = 0; j < size; j++)
+        {
+            result[i] += a.at(j) * b.at((i - j + size) % size);
+        }
+    }
+
+    return result;
+}
+
+QVector<double> test_PerfusionDeconvolver::deconvolveWithItk(const QVector<double> &aif, const QVector<double> &tissue, double regularizationFactor,
+                                                             double regularizationExponent, const QVector<double> &omega)
+{
+    typedef itk::Image<double, 1> ImageType;
+    typedef itk::VnlForwardFFTImageFilter<ImageType> ForwardFFTFilterType;
+    typedef ForwardFFTFilterType::OutputImageType ComplexImageType;
+    typedef itk::VnlInverseFFTImageFilter<ComplexImageType> InverseFFTFilterType;
+
+    int numberOfSamples = aif.size();
+    ImageType::RegionType region;
+    ImageType::IndexType start;
+    start[0] = 0;
+    ImageType::SizeType size;
+    size[0] = numberOfSamples;
+    region.SetSize(size);
+    region.SetIndex(start);
+
+    ImageType::Pointer aifImage = ImageType::New();
+    aifImage->SetRegions(region);
+    aifImage->Allocate();
+    ImageType::Pointer tissueImage = ImageType::New();
+    tissueImage->SetRegions(region);
+    tissueImage->Allocate();
+    for (int i = 0; i < numberOfSamples; i++)
+    {
+        ImageType::IndexType index;
+        index[0] = i;
+        aifImage->SetPixel(index, aif.at(i));
+        tissueImage->SetPixel(index, tissue.at(i));
+    }
+
+    ForwardFFTFilterType::Pointer aifFilter = ForwardFFTFilterType::New();
+    aifFilter->SetInput(aifImage);
+    aifFilter->Update();
+    ForwardFFTFilterType::Pointer tissueFilter = ForwardFFTFilterType::New();
+    tissueFilter->SetInput(tissueImage);
+    tissueFilter->Update();
+
+    ComplexImageType::Pointer residueTransform = ComplexImageType::New();
+    residueTransform->SetRegions(region);
+    residueTransform->Allocate();
+
+    itk::ImageRegionIterator<ComplexImageType> aifIterator(aifFilter->GetOutput(), region);
+    itk::ImageRegionIterator<ComplexImageType> tissueIterator(tissueFilter->GetOutput(), region);
+    itk::ImageRegionIterator<ComplexImageType> residueIterator(residueTransform, region);
+    for (int i = 0; i < numberOfSamples; i++, ++aifIterator, ++tissueIterator, ++residueIterator)
+    {
+        std::complex<double> a = aifIterator.Get();
+        std::complex<double> t = tissueIterator.Get();
+
+        if (regularizationFactor > 1e-6 || std::abs(a.real()) + std::abs(a.imag()) > 1e-6)
+        {
+            double regularization = regularizationFactor * std::pow(-1.0, regularizationExponent) * std::pow(omega.at(i), 2.0 * regularizationExponent);
+            residueIterator.Set(t * (std::conj(a) / (a * std::conj(a) + regularization)));
+        }
+        else
+        {
+            residueIterator.Set(std::complex<double>(0.0, 0.0));
+        }
+    }
+
+    InverseFFTFilterType::Pointer inverseFilter = InverseFFTFilterType::New();
+    inverseFilter->SetInput(residueTransform);
+    inverseFilter->Update();
+
+    QVector<double> residueFunction(numberOfSamples);
+    itk::ImageRegionIterator<ImageType> resultIterator(inverseFilter->GetOutput(), region);
+    for (int i = 0; i < numberOfSamples; i++, ++resultIterator)
+    {
+        residueFunction[i] = resultIterator.Get();
+    }
+
+    return residueFunction;
+}
+
+DECLARE_TEST(test_PerfusionDeconvolver)
+
+#include "test_perfusiondeconvolver.moc"
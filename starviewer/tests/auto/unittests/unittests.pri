@@ -4,3 +4,14 @@ include(inputoutput/inputoutput.pri)
 include(interface/interface.pri)
 include(q2dviewer/q2dviewer.pri)
 include(q3dviewer/q3dviewer.pri)
+
+# Playground extensions are excluded from official releases
+!official_release:!lite_version {
+    include(angiosubstraction/angiosubstraction.pri)
+    include(experimental3d/experimental3d.pri)
+
+    # This extension isn't linked on Mac, see extensions.pri
+    !macx {
+        include(perfusionmapreconstruction/perfusionmapreconstruction.pri)
+    }
+}